@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <cmath>
+
+#include "bench_utils.h"
+
+#include "media/audio_track_read_buffer.h"
+#include "remote_audio_track_interop.h"
+#include "toggle_audio_mixer.h"
+
+#include "pc/audiotrack.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+/// Create 10 ms of a 16-bit sine wave at the given rate.
+std::vector<int16_t> CreateSineFrame(int sample_rate, int num_channels) {
+  const int num_frames = sample_rate / 100;
+  std::vector<int16_t> samples((size_t)num_frames * num_channels);
+  for (int i = 0; i < num_frames; ++i) {
+    const int16_t value =
+        (int16_t)(8000.0 * std::sin(2.0 * 3.14159265 * 440.0 * i /
+                                    sample_rate));
+    std::fill_n(samples.begin() + (size_t)i * num_channels, num_channels,
+                value);
+  }
+  return samples;
+}
+
+/// Measure one 10 ms tick of a read buffer: the WebRTC audio thread delivering
+/// a frame with |OnData()|, and the application reading 10 ms of float samples
+/// with |Read()|, resampled and remixed as needed. Once the format is stable,
+/// neither side may allocate, so any allocation fails the benchmark.
+void BM_AudioTrackReadBuffer_Tick(benchmark::State& state) {
+  const int in_rate = (int)state.range(0);
+  const int in_channels = (int)state.range(1);
+  const int out_rate = (int)state.range(2);
+  const int out_channels = (int)state.range(3);
+  const auto quality = (mrsAudioResamplingQuality)state.range(4);
+
+  // The buffer only registers itself as a sink of the track, which has no
+  // source, so nothing else feeds it.
+  rtc::scoped_refptr<webrtc::AudioTrack> track =
+      webrtc::AudioTrack::Create("bench", nullptr);
+  AudioTrackReadBuffer buffer(track, nullptr, 500, quality);
+  const std::vector<int16_t> in_frame = CreateSineFrame(in_rate, in_channels);
+  const int out_samples = out_rate / 100 * out_channels;
+  std::vector<float> out_frame((size_t)out_samples);
+  const AudioTrackReadBuffer::OutputFormat format{
+      mrsAudioTrackReadBufferSampleType::kFloat32, /* interleaved = */ true};
+
+  auto tick = [&]() {
+    buffer.OnData(in_frame.data(), 16, in_rate, (size_t)in_channels,
+                  (size_t)(in_rate / 100));
+    int num_samples_read = 0;
+    bool has_overrun = false;
+    buffer.Read(out_rate, out_channels,
+                mrsAudioTrackReadBufferPadBehavior::kPadWithZero, format,
+                out_frame.data(), out_samples, &num_samples_read,
+                &has_overrun);
+    benchmark::DoNotOptimize(out_frame.data());
+  };
+
+  // Warm up the resampler for the output format outside of the measurement
+  tick();
+  BenchUtils::AllocationScope allocations;
+  BenchUtils::TickTimer timer;
+  for (auto _ : state) {
+    timer.Begin();
+    tick();
+    timer.End();
+  }
+  const uint64_t allocation_count = allocations.Count();
+  BenchUtils::SetTickCounters(state, allocation_count, timer);
+  if (allocation_count != 0) {
+    state.SkipWithError("Frames allocated once the format was stable.");
+  }
+}
+
+void ReadBufferFormats(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"in_rate", "in_ch", "out_rate", "out_ch", "quality"});
+  for (auto quality : {mrsAudioResamplingQuality::kHigh,
+                       mrsAudioResamplingQuality::kFast}) {
+    for (int in_rate : {16000, 44100, 48000}) {
+      for (int in_channels : {1, 2}) {
+        for (int out_channels : {1, 2}) {
+          bench->Args(
+              {in_rate, in_channels, 48000, out_channels, (int)quality});
+        }
+      }
+    }
+  }
+  // Passthrough only applies to tracks at the rate read
+  for (int in_channels : {1, 2}) {
+    for (int out_channels : {1, 2}) {
+      bench->Args({48000, in_channels, 48000, out_channels,
+                   (int)mrsAudioResamplingQuality::kPassthrough});
+    }
+  }
+}
+
+/// Audio source producing the same 10 ms of audio on each mix.
+class BenchAudioSource : public webrtc::AudioMixer::Source {
+ public:
+  explicit BenchAudioSource(int ssrc)
+      : ssrc_(ssrc), samples_(CreateSineFrame(48000, 1)) {}
+
+  AudioFrameInfo GetAudioFrameWithInfo(
+      int sample_rate_hz,
+      webrtc::AudioFrame* audio_frame) override {
+    // The mixer requests the preferred rate, so no resampling happens here
+    RTC_DCHECK_EQ(sample_rate_hz, 48000);
+    audio_frame->UpdateFrame(timestamp_, samples_.data(), samples_.size(),
+                             sample_rate_hz, webrtc::AudioFrame::kNormalSpeech,
+                             webrtc::AudioFrame::kVadActive, 1);
+    timestamp_ += (uint32_t)samples_.size();
+    return AudioFrameInfo::kNormal;
+  }
+  int Ssrc() const override { return ssrc_; }
+  int PreferredSampleRate() const override { return 48000; }
+
+ private:
+  const int ssrc_;
+  const std::vector<int16_t> samples_;
+  uint32_t timestamp_ = 0;
+};
+
+/// Measure one 10 ms stereo mix of the audio device, with a given number of
+/// sources, a given percentage of which are output to the device while the
+/// others are redirected to their consumers.
+void BM_ToggleAudioMixer_Mix(benchmark::State& state) {
+  const int source_count = (int)state.range(0);
+  const int output_percent = (int)state.range(1);
+  const int output_count = source_count * output_percent / 100;
+
+  rtc::scoped_refptr<ToggleAudioMixer> mixer =
+      new rtc::RefCountedObject<ToggleAudioMixer>();
+  std::vector<std::unique_ptr<BenchAudioSource>> sources;
+  for (int i = 0; i < source_count; ++i) {
+    sources.push_back(std::make_unique<BenchAudioSource>(i + 1));
+    mixer->AddSource(sources.back().get());
+    mixer->OutputSource(i + 1, i < output_count);
+  }
+  webrtc::AudioFrame frame;
+
+  // Warm up the pump frames of the redirected sources
+  mixer->Mix(2, &frame);
+  BenchUtils::AllocationScope allocations;
+  BenchUtils::TickTimer timer;
+  for (auto _ : state) {
+    timer.Begin();
+    mixer->Mix(2, &frame);
+    timer.End();
+    benchmark::DoNotOptimize(frame.data());
+  }
+  BenchUtils::SetTickCounters(state, allocations.Count(), timer);
+
+  for (auto&& source : sources) {
+    mixer->RemoveSource(source.get());
+  }
+}
+
+void MixerSourceCounts(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"sources", "output_pct"});
+  for (int source_count : {1, 4, 16, 64}) {
+    for (int output_percent : {0, 50, 100}) {
+      bench->Args({source_count, output_percent});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_AudioTrackReadBuffer_Tick)->Apply(ReadBufferFormats);
+BENCHMARK(BM_ToggleAudioMixer_Mix)->Apply(MixerSourceCounts);
@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "benchmark/benchmark.h"
+
+#include "interop/global_factory.h"
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  // Terminate the WebRTC threads started by the benchmarks before static
+  // deinitializing.
+  Microsoft::MixedReality::WebRTC::GlobalFactory::ForceShutdown();
+  return 0;
+}
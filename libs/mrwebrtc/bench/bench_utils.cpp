@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "bench_utils.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocation_count{0};
+
+}  // namespace
+
+// Replace the global allocation functions to count allocations. The array and
+// nothrow variants forward to these by default.
+void* operator new(size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+namespace BenchUtils {
+
+uint64_t GetAllocationCount() noexcept {
+  return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void VideoResolutions(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"width", "height"});
+  bench->Args({640, 360});
+  bench->Args({1280, 720});
+  bench->Args({1920, 1080});
+  bench->Args({3840, 2160});
+}
+
+void SetFrameCounters(benchmark::State& state,
+                      size_t bytes_per_frame,
+                      uint64_t allocation_count) {
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * (int64_t)bytes_per_frame);
+  state.counters["bytes/frame"] = (double)bytes_per_frame;
+  state.counters["allocs/frame"] = benchmark::Counter(
+      (double)allocation_count, benchmark::Counter::kAvgIterations);
+}
+
+void SetTickCounters(benchmark::State& state,
+                     uint64_t allocation_count,
+                     const TickTimer& timer) {
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs/tick"] = benchmark::Counter(
+      (double)allocation_count, benchmark::Counter::kAvgIterations);
+  state.counters["max_us/tick"] = timer.MaxMicroseconds();
+}
+
+}  // namespace BenchUtils
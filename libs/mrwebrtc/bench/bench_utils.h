@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+namespace BenchUtils {
+
+/// Get the number of heap allocations made through the global |operator new|
+/// since the process started. Memory allocated with |malloc()|, like the pixel
+/// data of |webrtc::I420Buffer| through |webrtc::AlignedMalloc()|, is not
+/// counted; only the objects owning it are.
+uint64_t GetAllocationCount() noexcept;
+
+/// Count the allocations made between construction and |Count()|.
+class AllocationScope {
+ public:
+  AllocationScope() noexcept : start_(GetAllocationCount()) {}
+  uint64_t Count() const noexcept { return GetAllocationCount() - start_; }
+
+ private:
+  const uint64_t start_;
+};
+
+/// Track the worst-case duration of the ticks of a benchmark, each tick
+/// enclosed in a |Begin()| and |End()| pair.
+class TickTimer {
+ public:
+  void Begin() noexcept { begin_ = std::chrono::steady_clock::now(); }
+  void End() noexcept {
+    max_duration_ =
+        std::max(max_duration_, std::chrono::steady_clock::now() - begin_);
+  }
+
+  /// Worst-case duration of a tick, in microseconds.
+  double MaxMicroseconds() const noexcept {
+    return std::chrono::duration<double, std::micro>(max_duration_).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point begin_;
+  std::chrono::steady_clock::duration max_duration_{0};
+};
+
+/// Register the video resolutions from 360p to 4K as the (width, height)
+/// arguments of a benchmark.
+void VideoResolutions(benchmark::internal::Benchmark* bench);
+
+/// Report the per-frame counters of a video benchmark run, where each
+/// iteration processed one frame of |bytes_per_frame| bytes and the whole run
+/// made |allocation_count| allocations.
+void SetFrameCounters(benchmark::State& state,
+                      size_t bytes_per_frame,
+                      uint64_t allocation_count);
+
+/// Report the per-tick counters of an audio benchmark run, where each
+/// iteration processed one 10 ms tick and the whole run made
+/// |allocation_count| allocations.
+void SetTickCounters(benchmark::State& state,
+                     uint64_t allocation_count,
+                     const TickTimer& timer);
+
+}  // namespace BenchUtils
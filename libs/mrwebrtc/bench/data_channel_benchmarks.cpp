@@ -0,0 +1,294 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <vector>
+
+#include "bench_utils.h"
+
+#include "data_channel_interop.h"
+
+// Reuse the local loopback signaling of the tests, which reports any failure
+// through the Google Test assertions.
+#define GTEST_LANG_CXX11 1
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+#include "../test/peer_connection_test_helpers.h"
+
+namespace {
+
+/// Number of messages sent per iteration, either one at a time or as a single
+/// batch with |mrsDataChannelSendMessages()|.
+constexpr int kMessagesPerIteration = 16;
+
+/// Maximum number of latency samples recorded per run. The storage is
+/// allocated upfront to keep allocations out of the receive path.
+constexpr size_t kMaxLatencySamples = 1 << 20;
+
+/// Time without any message received after which the messages not received
+/// yet are considered lost.
+constexpr auto kDrainTimeout = 2s;
+
+int64_t NowMicroseconds() noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// Negotiated data channel between the two peers of a locally connected pair,
+/// with the first peer sending and the second one receiving. Each message
+/// starts with its send time, from which the receiver computes its one-way
+/// latency; both peers share the same clock.
+class LoopbackChannel {
+ public:
+  LoopbackChannel(const LocalPeerPairRaii& pair, bool ordered, bool reliable) {
+    mrsDataChannelConfig config{};
+    config.id = 42;
+    config.label = "bench";
+    config.flags = ordered ? mrsDataChannelConfigFlags::kOrdered
+                           : mrsDataChannelConfigFlags::kNone;
+    if (reliable) {
+      config.flags = config.flags | mrsDataChannelConfigFlags::kReliable;
+    } else {
+      config.max_retransmits = 0;
+    }
+    if ((mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &sender_) !=
+         Result::kSuccess) ||
+        (mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &receiver_) !=
+         Result::kSuccess)) {
+      return;
+    }
+    latencies_us_.reserve(kMaxLatencySamples);
+
+    mrsDataChannelCallbacks sender_callbacks{};
+    sender_callbacks.buffering_callback = &StaticBufferingCallback;
+    sender_callbacks.buffering_user_data = this;
+    sender_callbacks.state_callback = &StaticStateCallback;
+    sender_callbacks.state_user_data = &sender_open_;
+    mrsDataChannelRegisterCallbacks(sender_, &sender_callbacks);
+
+    mrsDataChannelCallbacks receiver_callbacks{};
+    receiver_callbacks.message_callback = &StaticMessageCallback;
+    receiver_callbacks.message_user_data = this;
+    receiver_callbacks.state_callback = &StaticStateCallback;
+    receiver_callbacks.state_user_data = &receiver_open_;
+    mrsDataChannelRegisterCallbacks(receiver_, &receiver_callbacks);
+  }
+
+  ~LoopbackChannel() {
+    const mrsDataChannelCallbacks no_callbacks{};
+    if (sender_) {
+      mrsDataChannelRegisterCallbacks(sender_, &no_callbacks);
+    }
+    if (receiver_) {
+      mrsDataChannelRegisterCallbacks(receiver_, &no_callbacks);
+    }
+  }
+
+  /// Wait for the channel to open on both peers, once they are connected.
+  bool WaitOpen() {
+    return (sender_ && receiver_ && sender_open_.WaitFor(30s) &&
+            receiver_open_.WaitFor(30s));
+  }
+
+  /// Send |count| messages of the given size, each stamped with the current
+  /// time, waiting for the transport to drain when its buffer is full.
+  bool Send(std::vector<uint8_t>& payload, int count, bool batched) {
+    mrsDataChannelMessage messages[kMessagesPerIteration];
+    int next = 0;
+    while (next < count) {
+      // Messages rejected were not sent, so get a new send time on retry.
+      const int64_t now_us = NowMicroseconds();
+      std::memcpy(payload.data(), &now_us, sizeof(now_us));
+      int num_sent = 0;
+      if (batched) {
+        const int batch_size = count - next;
+        std::fill_n(messages, batch_size,
+                    mrsDataChannelMessage{payload.data(), payload.size()});
+        if (mrsDataChannelSendMessages(sender_, messages, batch_size, nullptr,
+                                       &num_sent) != Result::kSuccess) {
+          return false;
+        }
+      } else {
+        while ((next + num_sent < count) &&
+               (mrsDataChannelSendMessage(sender_, payload.data(),
+                                          payload.size()) ==
+                Result::kSuccess)) {
+          ++num_sent;
+        }
+      }
+      next += num_sent;
+      sent_bytes_ += num_sent * payload.size();
+      if (next < count) {
+        // A send was rejected because the buffer of the transport is full.
+        if (!WaitWritable()) {
+          return false;
+        }
+      }
+    }
+    sent_count_ += count;
+    return true;
+  }
+
+  /// Wait for all messages sent to be received, or until none is received for
+  /// |kDrainTimeout| on an unreliable channel.
+  void Drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t last_count = received_count_;
+    while (received_count_ < sent_count_) {
+      if (cv_.wait_for(lock, kDrainTimeout) == std::cv_status::timeout) {
+        if (received_count_ == last_count) {
+          break;
+        }
+        last_count = received_count_;
+      }
+    }
+  }
+
+  void ReportCounters(benchmark::State& state, int64_t start_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (received_count_ == 0) {
+      state.SkipWithError("No message received");
+      return;
+    }
+    const double elapsed_s =
+        std::max<int64_t>(last_received_us_ - start_us, 1) * 1e-6;
+    state.counters["MB/s"] = received_bytes_ / elapsed_s / (1024.0 * 1024.0);
+    state.counters["loss_pct"] =
+        100.0 * (sent_count_ - received_count_) / sent_count_;
+    if (!latencies_us_.empty()) {
+      auto percentile = [this](double p) {
+        auto it = latencies_us_.begin() +
+                  (ptrdiff_t)(p * (latencies_us_.size() - 1));
+        std::nth_element(latencies_us_.begin(), it, latencies_us_.end());
+        return (double)*it;
+      };
+      state.counters["p50_us"] = percentile(0.50);
+      state.counters["p90_us"] = percentile(0.90);
+      state.counters["p99_us"] = percentile(0.99);
+      state.counters["max_us"] = percentile(1.0);
+    }
+  }
+
+  uint64_t sent_count() const noexcept { return sent_count_; }
+  uint64_t sent_bytes() const noexcept { return sent_bytes_; }
+
+ private:
+  mrsDataChannelHandle sender_{};
+  mrsDataChannelHandle receiver_{};
+  Event sender_open_;
+  Event receiver_open_;
+
+  // Sender state, only accessed by the benchmark thread.
+  uint64_t sent_count_ = 0;
+  uint64_t sent_bytes_ = 0;
+
+  // Buffering state of the sender, and receiver state. Latency samples past
+  // |kMaxLatencySamples| are not recorded.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint64_t buffered_bytes_ = 0;
+  uint64_t buffer_limit_ = 0;
+  uint64_t received_count_ = 0;
+  uint64_t received_bytes_ = 0;
+  int64_t last_received_us_ = 0;
+  std::vector<int64_t> latencies_us_;
+
+  /// Wait for the buffer of the transport to drain to half its capacity.
+  bool WaitWritable() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, 10s, [this]() {
+      return (buffered_bytes_ <= buffer_limit_ / 2);
+    });
+  }
+
+  static void MRS_CALL StaticMessageCallback(void* user_data,
+                                             const void* data,
+                                             const uint64_t size) noexcept {
+    const int64_t now_us = NowMicroseconds();
+    auto self = static_cast<LoopbackChannel*>(user_data);
+    int64_t sent_us;
+    std::memcpy(&sent_us, data, sizeof(sent_us));
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    ++self->received_count_;
+    self->received_bytes_ += size;
+    self->last_received_us_ = now_us;
+    if (self->latencies_us_.size() < kMaxLatencySamples) {
+      self->latencies_us_.push_back(now_us - sent_us);
+    }
+    self->cv_.notify_all();
+  }
+
+  static void MRS_CALL StaticBufferingCallback(void* user_data,
+                                               const uint64_t /*previous*/,
+                                               const uint64_t current,
+                                               const uint64_t limit) noexcept {
+    auto self = static_cast<LoopbackChannel*>(user_data);
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    self->buffered_bytes_ = current;
+    self->buffer_limit_ = limit;
+    self->cv_.notify_all();
+  }
+
+  static void MRS_CALL StaticStateCallback(void* user_data,
+                                           mrsDataChannelState state,
+                                           int32_t /*id*/) noexcept {
+    if (state == mrsDataChannelState::kOpen) {
+      static_cast<Event*>(user_data)->Set();
+    }
+  }
+};
+
+/// Measure the sustained throughput and one-way latency of a data channel
+/// between two peers connected in the same process, sending messages as fast
+/// as the transport accepts them. The latency is therefore measured under
+/// load, and includes the time spent in the buffer of the transport.
+void BM_DataChannel_Loopback(benchmark::State& state) {
+  const size_t message_size = (size_t)state.range(0);
+  const bool ordered = (state.range(1) != 0);
+  const bool reliable = (state.range(2) != 0);
+  const bool batched = (state.range(3) != 0);
+
+  LocalPeerPairRaii pair;
+  LoopbackChannel channel(pair, ordered, reliable);
+  pair.ConnectAndWait();
+  if (!channel.WaitOpen()) {
+    state.SkipWithError("Failed to open the data channel");
+    return;
+  }
+
+  std::vector<uint8_t> payload(message_size, 0x5A);
+  const int64_t start_us = NowMicroseconds();
+  for (auto _ : state) {
+    if (!channel.Send(payload, kMessagesPerIteration, batched)) {
+      state.SkipWithError("Failed to send a message");
+      break;
+    }
+  }
+  channel.Drain();
+  state.SetItemsProcessed(channel.sent_count());
+  state.SetBytesProcessed(channel.sent_bytes());
+  channel.ReportCounters(state, start_us);
+}
+
+void DataChannelModes(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"size", "ordered", "reliable", "batched"});
+  for (int64_t size : {16, 256, 4 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024}) {
+    for (int ordered : {1, 0}) {
+      for (int reliable : {1, 0}) {
+        for (int batched : {0, 1}) {
+          bench->Args({size, ordered, reliable, batched});
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_DataChannel_Loopback)->Apply(DataChannelModes)->UseRealTime();
@@ -0,0 +1,300 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "bench_utils.h"
+
+#include "interop/global_factory.h"
+#include "media/external_video_track_source.h"
+#include "video_frame_observer.h"
+
+#include "rtc_base/event.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+/// Video frame observer exposing |OnFrame()| to feed it frames directly.
+class BenchVideoFrameObserver : public VideoFrameObserver {
+ public:
+  using VideoFrameObserver::OnFrame;
+};
+
+/// Frame sink counting the frames dispatched by a video track source, standing
+/// in for the video tracks so that the source does not drop its frames.
+class CountingVideoSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  void OnFrame(const webrtc::VideoFrame& frame) override {
+    benchmark::DoNotOptimize(frame.video_frame_buffer().get());
+    ++frame_count_;
+  }
+  uint64_t frame_count_ = 0;
+};
+
+/// Size of an I420 frame with tightly packed planes, in bytes.
+constexpr size_t I420FrameSize(int width, int height) {
+  return (static_cast<size_t>(height) * width) +
+         (static_cast<size_t>((height + 1) / 2) * ((width + 1) / 2) * 2);
+}
+
+void MRS_CALL OnI420AFrame(void* user_data, const I420AVideoFrame& frame) {
+  benchmark::DoNotOptimize(frame.ydata_);
+  ++*static_cast<uint64_t*>(user_data);
+}
+
+void MRS_CALL OnArgb32Frame(void* user_data, const Argb32VideoFrame& frame) {
+  benchmark::DoNotOptimize(frame.argb32_data_);
+  ++*static_cast<uint64_t*>(user_data);
+}
+
+/// Create an I420 buffer filled with a gray gradient.
+rtc::scoped_refptr<webrtc::I420Buffer> CreateI420Buffer(int width,
+                                                        int height) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    memset(buffer->MutableDataY() + y * buffer->StrideY(), y & 0xFF, width);
+  }
+  const int chroma_height = buffer->ChromaHeight();
+  memset(buffer->MutableDataU(), 0x80, buffer->StrideU() * chroma_height);
+  memset(buffer->MutableDataV(), 0x80, buffer->StrideV() * chroma_height);
+  return buffer;
+}
+
+/// Create an ARGB32 buffer filled with an opaque gray gradient.
+rtc::scoped_refptr<ArgbBuffer> CreateArgbBuffer(int width, int height) {
+  rtc::scoped_refptr<ArgbBuffer> buffer = ArgbBuffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    uint32_t* const row =
+        reinterpret_cast<uint32_t*>(buffer->Data() + y * buffer->Stride());
+    std::fill_n(row, width, 0xFF000000u | ((y & 0xFF) * 0x010101u));
+  }
+  return buffer;
+}
+
+webrtc::VideoFrame MakeFrame(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer) {
+  return webrtc::VideoFrame::Builder()
+      .set_video_frame_buffer(std::move(buffer))
+      .set_timestamp_us(rtc::TimeMicros())
+      .build();
+}
+
+/// Measure the delivery of one frame to a frame observer with a single frame
+/// callback, including any conversion of the frame to the callback format.
+template <typename FrameCallback>
+void RunOnFrame(benchmark::State& state,
+                const webrtc::VideoFrame& frame,
+                FrameCallback callback,
+                size_t bytes_per_frame) {
+  uint64_t delivered_count = 0;
+  callback.user_data_ = &delivered_count;
+  BenchVideoFrameObserver observer;
+  observer.SetCallback(callback);
+  // Warm up the scratch buffers outside of the measurement
+  observer.OnFrame(frame);
+  BenchUtils::AllocationScope allocations;
+  for (auto _ : state) {
+    observer.OnFrame(frame);
+  }
+  BenchUtils::SetFrameCounters(state, bytes_per_frame, allocations.Count());
+  if (delivered_count != state.iterations() + 1) {
+    state.SkipWithError("Frames were not all delivered.");
+  }
+}
+
+void BM_VideoFrameObserver_OnFrame_I420ToI420A(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  const webrtc::VideoFrame frame = MakeFrame(CreateI420Buffer(width, height));
+  RunOnFrame(state, frame, I420AFrameReadyCallback{&OnI420AFrame, nullptr},
+             I420FrameSize(width, height));
+}
+
+void BM_VideoFrameObserver_OnFrame_I420ToArgb32(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  const webrtc::VideoFrame frame = MakeFrame(CreateI420Buffer(width, height));
+  RunOnFrame(state, frame, Argb32FrameReadyCallback{&OnArgb32Frame, nullptr},
+             Argb32FrameSize(width, height));
+}
+
+void BM_VideoFrameObserver_OnFrame_I420AToArgb32(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      CreateI420Buffer(width, height);
+  std::vector<uint8_t> alpha((size_t)width * height, 0xFF);
+  const webrtc::VideoFrame frame = MakeFrame(webrtc::WrapI420ABuffer(
+      width, height, i420->DataY(), i420->StrideY(), i420->DataU(),
+      i420->StrideU(), i420->DataV(), i420->StrideV(), alpha.data(), width,
+      rtc::Callback0<void>([i420]() {})));
+  RunOnFrame(state, frame, Argb32FrameReadyCallback{&OnArgb32Frame, nullptr},
+             Argb32FrameSize(width, height));
+}
+
+void BM_VideoFrameObserver_OnFrame_NativeToI420A(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  const webrtc::VideoFrame frame = MakeFrame(CreateArgbBuffer(width, height));
+  RunOnFrame(state, frame, I420AFrameReadyCallback{&OnI420AFrame, nullptr},
+             I420FrameSize(width, height));
+}
+
+void BM_ArgbBuffer_ToI420(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  rtc::scoped_refptr<ArgbBuffer> buffer = CreateArgbBuffer(width, height);
+  BenchUtils::AllocationScope allocations;
+  for (auto _ : state) {
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420 = buffer->ToI420();
+    benchmark::DoNotOptimize(i420.get());
+  }
+  BenchUtils::SetFrameCounters(state, Argb32FrameSize(width, height),
+                               allocations.Count());
+}
+
+/// Push-mode source with a sink attached, so that pushed frames are filled and
+/// dispatched instead of dropped.
+class PushSourceFixture {
+ public:
+  PushSourceFixture() {
+    source_ = detail::ExternalVideoTrackSourceCreateForPush(
+        GlobalFactory::InstancePtr());
+    source_->FinishCreation();
+    source_->impl()->AddOrUpdateSink(&sink_, rtc::VideoSinkWants{});
+  }
+  ~PushSourceFixture() {
+    source_->impl()->RemoveSink(&sink_);
+    source_->Shutdown();
+  }
+  RefPtr<ExternalVideoTrackSource> source_;
+  CountingVideoSink sink_;
+};
+
+/// Measure the copy of an I420A frame into a pooled buffer and its dispatch.
+/// Push-mode sources fill their buffers like the I420A request adapter does.
+void BM_ExternalVideoTrackSource_FillBuffer_I420A(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      CreateI420Buffer(width, height);
+  I420AVideoFrame frame_view{};
+  frame_view.width_ = width;
+  frame_view.height_ = height;
+  frame_view.ydata_ = i420->DataY();
+  frame_view.udata_ = i420->DataU();
+  frame_view.vdata_ = i420->DataV();
+  frame_view.ystride_ = i420->StrideY();
+  frame_view.ustride_ = i420->StrideU();
+  frame_view.vstride_ = i420->StrideV();
+  PushSourceFixture fixture;
+  fixture.source_->PushFrame(frame_view, 0);
+  BenchUtils::AllocationScope allocations;
+  for (auto _ : state) {
+    fixture.source_->PushFrame(frame_view, 0);
+  }
+  BenchUtils::SetFrameCounters(
+      state, I420FrameSize(width, height),
+      allocations.Count());
+}
+
+/// Measure the conversion of an ARGB32 frame into a pooled I420 buffer and its
+/// dispatch. Push-mode sources fill their buffers like the ARGB32 request
+/// adapter does.
+void BM_ExternalVideoTrackSource_FillBuffer_Argb32(benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  rtc::scoped_refptr<ArgbBuffer> argb = CreateArgbBuffer(width, height);
+  Argb32VideoFrame frame_view{};
+  frame_view.width_ = width;
+  frame_view.height_ = height;
+  frame_view.argb32_data_ = argb->Data();
+  frame_view.stride_ = argb->Stride();
+  PushSourceFixture fixture;
+  fixture.source_->PushFrame(frame_view, 0);
+  BenchUtils::AllocationScope allocations;
+  for (auto _ : state) {
+    fixture.source_->PushFrame(frame_view, 0);
+  }
+  BenchUtils::SetFrameCounters(state, Argb32FrameSize(width, height),
+                               allocations.Count());
+}
+
+/// External ARGB32 source completing each frame request synchronously with the
+/// same frame.
+class BenchArgb32VideoSource : public Argb32ExternalVideoSource {
+ public:
+  Result FrameRequested(Argb32VideoFrameRequest& frame_request) override {
+    const Result result = frame_request.CompleteRequest(frame_view_);
+    completed_.Set();
+    return result;
+  }
+  Argb32VideoFrame frame_view_{};
+  rtc::Event completed_{/* manual_reset = */ false,
+                        /* initially_signaled = */ false};
+};
+
+/// Measure a whole on-demand frame request: signaling the capture thread,
+/// requesting the frame from the external source, and completing the request
+/// with a frame converted and dispatched to the sink.
+void BM_ExternalVideoTrackSource_CompleteRequest_Argb32(
+    benchmark::State& state) {
+  const int width = (int)state.range(0);
+  const int height = (int)state.range(1);
+  rtc::scoped_refptr<ArgbBuffer> argb = CreateArgbBuffer(width, height);
+  RefPtr<BenchArgb32VideoSource> video_source = new BenchArgb32VideoSource();
+  video_source->frame_view_.width_ = width;
+  video_source->frame_view_.height_ = height;
+  video_source->frame_view_.argb32_data_ = argb->Data();
+  video_source->frame_view_.stride_ = argb->Stride();
+
+  // Track sources need to be created from the worker thread
+  RefPtr<GlobalFactory> global_factory = GlobalFactory::InstancePtr();
+  rtc::Thread* const worker_thread = global_factory->GetWorkerThread();
+  RefPtr<ExternalVideoTrackSource> source =
+      worker_thread->Invoke<RefPtr<ExternalVideoTrackSource>>(
+          RTC_FROM_HERE,
+          rtc::Bind(&ExternalVideoTrackSource::createFromArgb32,
+                    std::move(global_factory), video_source));
+  mrsExternalVideoTrackSourceSettings settings{};
+  settings.scheduling = mrsExternalVideoFrameScheduling::kOnDemand;
+  source->Configure(settings);
+  CountingVideoSink sink;
+  source->impl()->AddOrUpdateSink(&sink, rtc::VideoSinkWants{});
+  source->FinishCreation();
+
+  BenchUtils::AllocationScope allocations;
+  for (auto _ : state) {
+    source->NotifyFrameAvailable();
+    video_source->completed_.Wait(rtc::Event::kForever);
+  }
+  BenchUtils::SetFrameCounters(state, Argb32FrameSize(width, height),
+                               allocations.Count());
+
+  source->impl()->RemoveSink(&sink);
+  source->Shutdown();
+  if (sink.frame_count_ != state.iterations()) {
+    state.SkipWithError("Frames were not all dispatched.");
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_VideoFrameObserver_OnFrame_I420ToI420A)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_VideoFrameObserver_OnFrame_I420ToArgb32)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_VideoFrameObserver_OnFrame_I420AToArgb32)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_VideoFrameObserver_OnFrame_NativeToI420A)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_ArgbBuffer_ToI420)->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_ExternalVideoTrackSource_FillBuffer_I420A)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_ExternalVideoTrackSource_FillBuffer_Argb32)
+    ->Apply(BenchUtils::VideoResolutions);
+BENCHMARK(BM_ExternalVideoTrackSource_CompleteRequest_Argb32)
+    ->Apply(BenchUtils::VideoResolutions)
+    ->UseRealTime();
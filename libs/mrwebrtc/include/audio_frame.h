@@ -29,6 +29,11 @@ struct AudioFrame {
   /// Number of consecutive samples. The frame duration is given by the ratio
   /// |sample_count_| / |sampling_rate_hz_|.
   std::uint32_t sample_count_;
+
+  /// Time at which the first sample of the frame was received, in
+  /// microseconds, in the local monotonic clock. When frames are aggregated,
+  /// this is the reception time of the first aggregated frame.
+  std::int64_t timestamp_us_;
 };
 
 }  // namespace WebRTC
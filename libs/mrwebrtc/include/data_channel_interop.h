@@ -42,9 +42,11 @@ using mrsDataChannelMessageCallback = void(
 
 /// Callback invoked when a data channel internal buffering changes.
 /// The |previous| and |current| values are the old and new sizes in bytes of
-/// the buffering buffer. The |limit| is the capacity of the buffer. Note that
-/// when the buffer is full, any attempt to send data will result is an abrupt
-/// closing of the data channel. So monitoring the buffering state is critical.
+/// the buffering buffer. The |limit| is the capacity of the buffer, as set with
+/// |mrsDataChannelSetLimits|, past which messages are rejected. Note that
+/// when the transport buffer is full, any attempt to send data will result is
+/// an abrupt closing of the data channel. So monitoring the buffering state is
+/// critical.
 using mrsDataChannelBufferingCallback =
     void(MRS_CALL*)(void* user_data,
                     const uint64_t previous,
@@ -90,4 +92,355 @@ mrsDataChannelSendMessage(mrsDataChannelHandle data_channel_handle,
                           const void* data,
                           uint64_t size) noexcept;
 
+/// Message of a batch sent with |mrsDataChannelSendMessages|.
+struct mrsDataChannelMessage {
+  /// Content of the message.
+  const void* data{nullptr};
+
+  /// Byte length of the message.
+  uint64_t size{0};
+};
+
+/// Send through the given data channel a batch of |count| messages. This is
+/// equivalent to calling |mrsDataChannelSendMessage| for each message in
+/// order, but checks the buffering limit and dispatches to the WebRTC
+/// signaling thread only once, which is much cheaper for many small messages.
+///
+/// Each message is accepted or rejected individually. If not NULL,
+/// |accepted_out| is an array of |count| elements which receives for each
+/// message whether it was accepted. |num_accepted_out| receives the number of
+/// accepted messages. Rejected messages are not sent, but later ones may be,
+/// so a reliable ordered channel should stop at the first rejection.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSendMessages(mrsDataChannelHandle data_channel_handle,
+                           const mrsDataChannelMessage* messages,
+                           int32_t count,
+                           mrsBool* accepted_out,
+                           int32_t* num_accepted_out) noexcept;
+
+/// Configuration of the send queue of a data channel.
+struct mrsDataChannelSendQueueConfig {
+  /// Maximum number of bytes pending, queued or buffered by the transport,
+  /// past which |mrsDataChannelQueueMessage| rejects messages. This cannot
+  /// exceed the buffering capacity of the data channel, see
+  /// |mrsDataChannelLimits|.
+  uint64_t high_watermark{4 * 1024 * 1024};
+
+  /// Number of bytes pending below which the writable callback fires, after
+  /// a message was rejected.
+  uint64_t low_watermark{1024 * 1024};
+};
+
+/// Enable the send queue of a data channel with the given configuration, or
+/// disable it if |config| is NULL, discarding any message still queued.
+///
+/// The send queue holds messages natively, and hands them over to the
+/// transport as it sends data, so that the application can keep the channel
+/// busy without monitoring the buffering events. Messages are queued with
+/// |mrsDataChannelQueueMessage| until the high watermark is reached. Once a
+/// message is rejected, the writable callback fires a single time when the
+/// pending bytes fall below the low watermark.
+MRS_API mrsResult MRS_CALL mrsDataChannelSetSendQueue(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelSendQueueConfig* config) noexcept;
+
+/// Callback fired when the send queue of a data channel accepts messages again
+/// after rejecting one.
+using mrsDataChannelWritableCallback = void(MRS_CALL*)(void* user_data);
+
+/// Register a callback fired when the send queue of a data channel accepts
+/// messages again. The callback is invoked on the WebRTC signaling thread.
+MRS_API void MRS_CALL mrsDataChannelRegisterWritableCallback(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelWritableCallback callback,
+    void* user_data) noexcept;
+
+/// Queue a message for sending through the send queue of a data channel. The
+/// message content is copied, and sent as soon as the transport can buffer
+/// it, in order with the other queued messages. Messages queued before the
+/// channel is open are sent once it opens.
+///
+/// This returns |kDataChannelSendQueueFull| if the high watermark is reached,
+/// in which case the writable callback fires when the message can be queued
+/// again, or |kInvalidOperation| if the send queue is disabled.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelQueueMessage(mrsDataChannelHandle data_channel_handle,
+                           const void* data,
+                           uint64_t size) noexcept;
+
+/// Behavior of the receive ring of a data channel when a message does not fit.
+enum class mrsDataChannelReceiveOverflowPolicy : int32_t {
+  /// Drop the message received, keeping the messages not pulled yet.
+  kDropNewest = 0,
+
+  /// Drop the oldest messages not pulled yet until the message received fits.
+  kDropOldest = 1,
+};
+
+/// Configuration of the receive ring of a data channel.
+struct mrsDataChannelReceiveRingConfig {
+  /// Total size of the messages the ring can hold, in bytes. Messages larger
+  /// than this are always dropped.
+  uint64_t capacity_bytes{1024 * 1024};
+
+  /// Maximum number of messages the ring can hold.
+  int32_t max_messages{1024};
+
+  /// Behavior when a message does not fit.
+  mrsDataChannelReceiveOverflowPolicy overflow_policy{
+      mrsDataChannelReceiveOverflowPolicy::kDropNewest};
+};
+
+/// Enable the receive ring of a data channel with the given configuration, or
+/// disable it if |config| is NULL, discarding any message not pulled yet.
+///
+/// While enabled, received messages are not delivered to the message callback,
+/// but copied into a ring preallocated natively, from which the application
+/// pulls them with |mrsDataChannelTryReceiveMessage| or
+/// |mrsDataChannelReceiveMessages| on any thread, at its own pace. This avoids
+/// a callback per message, and lets the application process messages in
+/// batches, for example once per frame. The data available callback fires when
+/// the ring stops being empty.
+MRS_API mrsResult MRS_CALL mrsDataChannelSetReceiveRing(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelReceiveRingConfig* config) noexcept;
+
+/// Callback fired when the receive ring of a data channel stops being empty.
+using mrsDataChannelDataAvailableCallback = void(MRS_CALL*)(void* user_data);
+
+/// Register a callback fired when the receive ring of a data channel receives
+/// a message while empty. It does not fire again until the ring has been
+/// emptied, so the application must pull messages until none is left. The
+/// callback is invoked on the WebRTC signaling thread, and can pull messages.
+MRS_API void MRS_CALL mrsDataChannelRegisterDataAvailableCallback(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelDataAvailableCallback callback,
+    void* user_data) noexcept;
+
+/// Pull the oldest message of the receive ring of a data channel into
+/// |buffer|, of |capacity| bytes. |received_out| receives whether a message
+/// was pulled, and |size_out| its size. If the ring is empty, this succeeds
+/// without pulling any message.
+///
+/// This returns |kBufferTooSmall| if the message is larger than |capacity|,
+/// in which case the message is left in the ring and |size_out| receives its
+/// size, or |kInvalidOperation| if the receive ring is disabled.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelTryReceiveMessage(mrsDataChannelHandle data_channel_handle,
+                                void* buffer,
+                                uint64_t capacity,
+                                uint64_t* size_out,
+                                mrsBool* received_out) noexcept;
+
+/// Pull in order up to |max_messages| messages of the receive ring of a data
+/// channel, copying them one after the other into |buffer|, of |capacity|
+/// bytes, and stopping at the first message which does not fit.
+/// |messages_out| receives the location of each message pulled in |buffer|,
+/// and |count_out| their number.
+///
+/// This returns |kBufferTooSmall| if the oldest message is larger than
+/// |capacity|, or |kInvalidOperation| if the receive ring is disabled.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelReceiveMessages(mrsDataChannelHandle data_channel_handle,
+                              void* buffer,
+                              uint64_t capacity,
+                              mrsDataChannelMessage* messages_out,
+                              int32_t max_messages,
+                              int32_t* count_out) noexcept;
+
+/// Get the number of messages the receive ring of a data channel dropped on
+/// overflow since it was enabled.
+MRS_API mrsResult MRS_CALL mrsDataChannelGetReceiveDroppedCount(
+    mrsDataChannelHandle data_channel_handle,
+    uint64_t* count_out) noexcept;
+
+/// Open a stream for transferring |total_size| bytes through a data channel,
+/// larger than a message can be. |stream_id_out| receives the identifier of
+/// the stream, to write its content with |mrsDataChannelWriteStream|.
+///
+/// The content is fragmented into messages queued through the send queue of
+/// the data channel, which must be enabled with |mrsDataChannelSetSendQueue|,
+/// so the memory used by the transfer is bounded by the high watermark. The
+/// data channel must be ordered and reliable, and the remote data channel must
+/// have a stream receiver set with |mrsDataChannelSetStreamReceiver|.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelOpenStream(mrsDataChannelHandle data_channel_handle,
+                         uint64_t total_size,
+                         uint32_t* stream_id_out) noexcept;
+
+/// Write the next |size| bytes of a stream, as many as the send queue of the
+/// data channel accepts. |written_out| receives the number of bytes written,
+/// which can be less than |size| when the send queue is full, in which case
+/// the writable callback fires when the rest can be written. The stream
+/// completes once its total size is written.
+///
+/// A stream must only be written by one thread at a time. This returns
+/// |kNotFound| if the stream is not open, or |kInvalidParameter| if writing
+/// past the total size of the stream.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelWriteStream(mrsDataChannelHandle data_channel_handle,
+                          uint32_t stream_id,
+                          const void* data,
+                          uint64_t size,
+                          uint64_t* written_out) noexcept;
+
+/// Abort a stream before its total size is written. The remote stream
+/// receiver completes the stream with |kDataChannelStreamAborted|.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelAbortStream(mrsDataChannelHandle data_channel_handle,
+                          uint32_t stream_id) noexcept;
+
+/// Callback fired when a remote stream opens, returning the destination its
+/// content is reassembled into, of at least |total_size| bytes, or NULL to
+/// reject the stream. The destination can be any memory, like a view of a
+/// memory-mapped file, and must remain valid until the stream completes.
+using mrsDataChannelStreamOpenedCallback =
+    void*(MRS_CALL*)(void* user_data, uint32_t stream_id, uint64_t total_size);
+
+/// Callback fired after each fragment of a remote stream is received.
+using mrsDataChannelStreamProgressCallback =
+    void(MRS_CALL*)(void* user_data,
+                    uint32_t stream_id,
+                    uint64_t received_size,
+                    uint64_t total_size);
+
+/// Callback fired when a remote stream is fully received, with |kSuccess|, or
+/// aborted by the sender or by the data channel closing, with
+/// |kDataChannelStreamAborted|.
+using mrsDataChannelStreamCompletedCallback =
+    void(MRS_CALL*)(void* user_data, uint32_t stream_id, mrsResult result);
+
+/// Callbacks of the stream receiver of a data channel.
+struct mrsDataChannelStreamReceiverCallbacks {
+  mrsDataChannelStreamOpenedCallback opened_callback{};
+  void* opened_user_data{};
+  mrsDataChannelStreamProgressCallback progress_callback{};
+  void* progress_user_data{};
+  mrsDataChannelStreamCompletedCallback completed_callback{};
+  void* completed_user_data{};
+};
+
+/// Set the stream receiver of a data channel, or clear it if |callbacks| is
+/// NULL, aborting the streams being received.
+///
+/// While set, all the messages received are handled as stream fragments,
+/// and reassembled natively in place into the destination returned by the
+/// opened callback, without delivering them to the message callback. Use a
+/// data channel dedicated to streams. The callbacks are invoked on the WebRTC
+/// signaling thread.
+MRS_API mrsResult MRS_CALL mrsDataChannelSetStreamReceiver(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelStreamReceiverCallbacks* callbacks) noexcept;
+
+/// Set the size in bytes from which the messages sent through a data channel
+/// created with |mrsDataChannelConfigFlags::kCompressed| are compressed.
+/// Smaller messages, and ones which do not compress, are sent raw, with a
+/// single byte of overhead. The default threshold is 128 bytes.
+MRS_API mrsResult MRS_CALL mrsDataChannelSetCompressionThreshold(
+    mrsDataChannelHandle data_channel_handle,
+    uint64_t threshold) noexcept;
+
+/// Limits of the messages sent through a data channel.
+struct mrsDataChannelLimits {
+  /// Capacity in bytes of the send buffer of the transport, past which
+  /// messages are rejected. This bounds the memory a peer which stops reading
+  /// can hold, per data channel. This cannot exceed the 16 MB past which the
+  /// transport closes the data channel.
+  uint64_t max_buffering_size{16 * 1024 * 1024};
+
+  /// Maximum size in bytes of a message sent, before compression. Larger
+  /// messages are rejected. This cannot exceed |max_buffering_size|, and
+  /// streams are fragmented into messages of at most this size, so it must
+  /// exceed the 24-byte header of stream messages to write streams.
+  uint64_t max_message_size{16 * 1024 * 1024};
+};
+
+/// Set the limits of the messages sent through a data channel. Messages
+/// already buffered are not affected. Lowering the buffering capacity below
+/// the high watermark of the send queue also lowers the amount the queue
+/// hands over to the transport.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSetLimits(mrsDataChannelHandle data_channel_handle,
+                        const mrsDataChannelLimits* limits) noexcept;
+
+MRS_API mrsResult MRS_CALL
+mrsDataChannelGetLimits(mrsDataChannelHandle data_channel_handle,
+                        mrsDataChannelLimits* limits_out) noexcept;
+
+/// Set the limits of the data channels created from now on by a peer
+/// connection, either added locally or by the remote peer. Existing data
+/// channels are not affected.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionSetDataChannelLimits(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelLimits* limits) noexcept;
+
+/// Traffic counters of a data channel, kept natively as it sends and receives
+/// messages. Sizes are those of the messages handed to and received from the
+/// transport, after compression.
+struct mrsDataChannelCounters {
+  uint64_t messages_sent{};
+  uint64_t bytes_sent{};
+  uint64_t messages_received{};
+  uint64_t bytes_received{};
+
+  /// Number of messages rejected by the buffering limit of the transport, or
+  /// by a full send queue.
+  uint64_t messages_rejected{};
+
+  /// Number of bytes buffered by the transport, not sent yet, and peak value
+  /// since the channel was created.
+  uint64_t buffered_amount{};
+  uint64_t peak_buffered_amount{};
+
+  /// Estimate of the one-way latency in microseconds, or -1 if unknown. See
+  /// |mrsDataChannelSetLatencyProbeInterval|.
+  int64_t latency_us{-1};
+};
+
+/// Read the traffic counters of a data channel. This is cheap, and does not
+/// dispatch to any thread, so can be polled on many channels, unlike the
+/// statistics report of the peer connection.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelGetCounters(mrsDataChannelHandle data_channel_handle,
+                          mrsDataChannelCounters* counters_out) noexcept;
+
+/// Enable latency probes on a data channel, sent at most every |interval_ms|
+/// milliseconds along with the messages, or disable them with zero.
+///
+/// A probe is a small message timestamped by the sender and echoed back by the
+/// receiver, which gives an estimate of the one-way latency as half the round
+/// trip, including any backlog of messages in front of it. Both peers must
+/// enable probes on the channel, as a peer without them would deliver the
+/// probes of the other one to its message callback.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSetLatencyProbeInterval(mrsDataChannelHandle data_channel_handle,
+                                      int32_t interval_ms) noexcept;
+
+/// Handle to a message buffer allocated by |mrsDataChannelMessageBufferCreate|.
+using mrsDataChannelMessageBufferHandle = void*;
+
+/// Allocate a buffer of |capacity| bytes for building a message in place, and
+/// sending it with |mrsDataChannelSendMessageBuffer| without any copy of its
+/// content. |data_out| receives the address of the buffer content, which
+/// remains valid until the buffer is sent or destroyed.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelMessageBufferCreate(uint64_t capacity,
+                                  mrsDataChannelMessageBufferHandle* buffer_out,
+                                  void** data_out) noexcept;
+
+/// Destroy a message buffer which was not sent.
+MRS_API void MRS_CALL mrsDataChannelMessageBufferDestroy(
+    mrsDataChannelMessageBufferHandle buffer) noexcept;
+
+/// Send through the given data channel the first |size| bytes of a message
+/// buffer allocated with |mrsDataChannelMessageBufferCreate|, without copying
+/// them. This behaves like |mrsDataChannelSendMessage| otherwise.
+///
+/// This takes ownership of the buffer whatever the result, so the buffer and
+/// its content must not be accessed anymore once this is called.
+MRS_API mrsResult MRS_CALL mrsDataChannelSendMessageBuffer(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelMessageBufferHandle buffer,
+    uint64_t size) noexcept;
+
 }  // extern "C"
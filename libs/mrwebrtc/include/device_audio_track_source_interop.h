@@ -12,10 +12,23 @@ extern "C" {
 struct mrsLocalAudioDeviceInitConfig {
   /// Enable auto gain control (AGC).
   mrsOptBool auto_gain_control_{mrsOptBool::kUnset};
+
+  /// Enable acoustic echo cancellation (AEC). This uses the echo cancellation
+  /// built into the platform or the device where available, which usually
+  /// adds less latency, and the WebRTC one otherwise.
+  mrsOptBool echo_cancellation_{mrsOptBool::kUnset};
+
+  /// Enable noise suppression (NS), using the built-in one where available
+  /// like |echo_cancellation_|.
+  mrsOptBool noise_suppression_{mrsOptBool::kUnset};
+
+  /// Enable the high-pass filter removing the low frequency noise.
+  mrsOptBool highpass_filter_{mrsOptBool::kUnset};
 };
 
 /// Create an audio track source by opening a local audio capture device
-/// (microphone).
+/// (microphone). This returns |mrsResult::kInvalidParameter| if an option of
+/// |init_config| is not one of the |mrsOptBool| values.
 MRS_API mrsResult MRS_CALL mrsDeviceAudioTrackSourceCreate(
     const mrsLocalAudioDeviceInitConfig* init_config,
     mrsDeviceAudioTrackSourceHandle* source_handle_out) noexcept;
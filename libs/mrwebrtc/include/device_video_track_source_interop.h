@@ -53,6 +53,14 @@ struct mrsLocalVideoDeviceInitConfig {
   /// When Mixed Reality Capture is enabled, enable or disable the recording
   /// indicator shown on screen.
   mrsBool enable_mrc_recording_indicator = mrsBool::kTrue;
+
+  /// Select the capture format among the ones natively produced by the device
+  /// instead of letting the capturer pick one, matching first the optional
+  /// resolution and framerate above, then preferring the pixel formats
+  /// cheapest to convert for encoding, like NV12 over MJPEG which requires a
+  /// full JPEG decoding of each frame. Without a resolution or framerate, this
+  /// targets the default 640x480 at 30 FPS.
+  mrsBool prefer_native_format = mrsBool::kFalse;
 };
 
 
@@ -64,4 +72,47 @@ MRS_API mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreate(
     const mrsLocalVideoDeviceInitConfig* init_config,
     mrsDeviceVideoTrackSourceHandle* source_handle_out) noexcept;
 
+/// Callback invoked when a creation started with
+/// |mrsDeviceVideoTrackSourceCreateAsync()| completed. On success, the
+/// callee owns a reference to the source, to release with
+/// |mrsRefCountedObjectRemoveRef()|; otherwise |source_handle| is NULL.
+using mrsDeviceVideoTrackSourceCreatedCallback =
+    void(MRS_CALL*)(void* user_data,
+                    mrsResult result,
+                    mrsDeviceVideoTrackSourceHandle source_handle);
+
+/// Start creating a video track source like
+/// |mrsDeviceVideoTrackSourceCreate()|, but open the device on an internal
+/// thread and invoke |callback| on that thread once done. This can be called
+/// from any thread, including the main UI thread on UWP. Devices are opened
+/// one at a time, in the order of the calls. The ID returned in
+/// |operation_id_out| can be passed to
+/// |mrsDeviceVideoTrackSourceCancelCreateAsync()|.
+MRS_API mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreateAsync(
+    const mrsLocalVideoDeviceInitConfig* init_config,
+    mrsDeviceVideoTrackSourceCreatedCallback callback,
+    void* user_data,
+    uint32_t* operation_id_out) noexcept;
+
+/// Cancel a creation started with |mrsDeviceVideoTrackSourceCreateAsync()|.
+/// Its callback is still invoked, with |mrsResult::kCancelled|, and any source
+/// opened in the meantime is released. Return |mrsResult::kNotFound| if the
+/// creation already completed.
+MRS_API mrsResult MRS_CALL
+mrsDeviceVideoTrackSourceCancelCreateAsync(uint32_t operation_id) noexcept;
+
+/// Create a video track source fed by a Java |org.webrtc.VideoCapturer| on
+/// Android, like an |org.webrtc.Camera2Capturer|. On success, this returns in
+/// |j_capturer_observer_out| a JNI global reference to the Java
+/// |org.webrtc.CapturerObserver| to pass to |VideoCapturer.initialize()|,
+/// which the caller must delete with |DeleteGlobalRef()| once the capturer is
+/// disposed. Capturers initialized with an |org.webrtc.SurfaceTextureHelper|
+/// produce texture frames, which are encoded without any copy to CPU memory by
+/// the codecs of |mrsSetAndroidVideoCodecFactories()|. This returns
+/// |mrsResult::kUnsupported| on other platforms.
+MRS_API mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreateFromAndroidCapturer(
+    mrsBool is_screencast,
+    mrsDeviceVideoTrackSourceHandle* source_handle_out,
+    void** j_capturer_observer_out) noexcept;
+
 }  // extern "C"
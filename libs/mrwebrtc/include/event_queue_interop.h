@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+//
+// Event queue API
+//
+// Instead of invoking a callback for each event on the internal WebRTC
+// threads, objects with event polling enabled record their events in a
+// process-wide queue, which the application drains with |mrsPollEvents()|,
+// typically once per frame on its main thread. This avoids a native-to-managed
+// transition for each event.
+//
+
+/// Type of an event recorded in the event queue.
+enum class mrsEventType : int32_t {
+  /// Some events were dropped because the queue was full. |size| is the number
+  /// of events dropped since the previous event of this type.
+  kEventsDropped = 0,
+
+  /// See |mrsPeerConnectionConnectedCallback|.
+  kConnected = 1,
+
+  /// See |mrsPeerConnectionLocalSdpReadytoSendCallback|. |value| is the
+  /// |mrsSdpMessageType| of the message, and |data| is the SDP message.
+  kLocalSdpReadytoSend = 2,
+
+  /// See |mrsPeerConnectionIceCandidateReadytoSendCallback|. |value| is the
+  /// media line index, |data| is the candidate, and |text| is the "mid".
+  kIceCandidateReadytoSend = 3,
+
+  /// See |mrsPeerConnectionIceStateChangedCallback|. |value| is the new
+  /// |mrsIceConnectionState|.
+  kIceStateChanged = 4,
+
+  /// See |mrsPeerConnectionIceGatheringStateChangedCallback|. |value| is the
+  /// new |mrsIceGatheringState|.
+  kIceGatheringStateChanged = 5,
+
+  /// See |mrsPeerConnectionRenegotiationNeededCallback|.
+  kRenegotiationNeeded = 6,
+
+  /// A data channel was added. |object| is the data channel, |value| its ID,
+  /// and |text| its label. Event polling is enabled on the data channel.
+  kDataChannelAdded = 7,
+
+  /// A data channel was removed. |object| is the data channel, which is
+  /// destroyed.
+  kDataChannelRemoved = 8,
+
+  /// A message was received on a data channel. |source| is the data channel,
+  /// and |data| the message.
+  kDataChannelMessage = 9,
+
+  /// The state of a data channel changed. |source| is the data channel,
+  /// |value| its new |mrsDataChannelState|, and |size| its ID.
+  kDataChannelStateChanged = 10,
+};
+
+/// Event recorded in the event queue. Handles may refer to objects destroyed
+/// since the event was recorded; applications keep track of the objects
+/// removed, which is also reported in the queue, before using them.
+struct mrsEvent {
+  mrsEventType type{mrsEventType::kEventsDropped};
+
+  /// Integer argument of the event, depending on its type.
+  int32_t value{0};
+
+  /// Object which raised the event, either a peer connection or a data
+  /// channel.
+  void* source{nullptr};
+
+  /// User data of |source| when the event was recorded, as set with
+  /// |mrsObjectSetUserData()| or |mrsDataChannelSetUserData()|.
+  void* user_data{nullptr};
+
+  /// Other object the event is about, if any.
+  void* object{nullptr};
+
+  /// Payload of the event, if any, valid until the next call to
+  /// |mrsPollEvents()|. Strings are null-terminated; their size excludes the
+  /// null terminator.
+  const void* data{nullptr};
+  uint64_t size{0};
+
+  /// Secondary null-terminated string of the event, if any, valid until the
+  /// next call to |mrsPollEvents()|.
+  const char* text{nullptr};
+};
+
+/// Move up to |max_count| of the oldest recorded events to |events|, in the
+/// order they were recorded, and return in |count_out| the number of events
+/// moved. This must not be called concurrently from several threads, and
+/// invalidates the payloads of the events returned by the previous call.
+///
+/// The queue holds up to 4096 events. Once full, new events are dropped until
+/// the queue is drained, and a |mrsEventType::kEventsDropped| event is
+/// returned before the next events.
+MRS_API mrsResult MRS_CALL mrsPollEvents(mrsEvent* events,
+                                         uint32_t max_count,
+                                         uint32_t* count_out) noexcept;
+
+/// Enable or disable the recording of the events of a peer connection in the
+/// event queue. This replaces the callbacks registered for the signaling and
+/// data channel events listed in |mrsEventType|, and unregisters them when
+/// disabled.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionSetEventPolling(mrsPeerConnectionHandle peer_handle,
+                                 mrsBool enabled) noexcept;
+
+/// Enable or disable the recording of the events of a data channel in the
+/// event queue. This replaces the callbacks registered with
+/// |mrsDataChannelRegisterCallbacks()|, and unregisters them when disabled.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSetEventPolling(mrsDataChannelHandle data_channel_handle,
+                              mrsBool enabled) noexcept;
+
+}  // extern "C"
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Sample type of the audio pushed to an external audio track source.
+enum class mrsExternalAudioSampleType : int32_t {
+  /// 32-bit floating-point samples in the [-1:1] range.
+  kFloat32 = 0,
+
+  /// Signed 16-bit integer samples.
+  kInt16 = 1,
+};
+
+/// Settings of an external audio track source.
+struct mrsExternalAudioTrackSourceSettings {
+  /// Sampling rate of the pushed audio, in Hertz. This must be a multiple of
+  /// 100 Hz, so that the audio splits into 10 ms frames, between 8 kHz and
+  /// 192 kHz. The audio is resampled once, by the encoder.
+  uint32_t sampling_rate_hz{48000};
+
+  /// Number of interleaved channels of the pushed audio, 1 or 2.
+  uint32_t channel_count{1};
+
+  /// Type of the pushed samples.
+  mrsExternalAudioSampleType sample_type{mrsExternalAudioSampleType::kInt16};
+
+  /// Capacity of the buffer holding the pushed audio until it is consumed, in
+  /// milliseconds, between 10 and 1000 ms.
+  uint32_t buffer_ms{200};
+};
+
+/// Create an audio track source external to the implementation, sending the
+/// audio pushed by the application with
+/// |mrsExternalAudioTrackSourcePushAudio()| instead of the audio of a capture
+/// device. The source consumes 10 ms of pushed audio every 10 ms, padding
+/// with silence if not enough audio was pushed.
+///
+/// Note that the audio device module still sends the audio recorded by the
+/// capture device, if any, to all the audio tracks. To only send external
+/// audio, select |mrsAudioDeviceLayer::kDummy| with
+/// |mrsSetAudioDeviceModuleConfig()|.
+///
+/// This returns a handle to a newly allocated object, which must be released
+/// once not used anymore with |mrsRefCountedObjectRemoveRef()|.
+MRS_API mrsResult MRS_CALL mrsExternalAudioTrackSourceCreate(
+    const mrsExternalAudioTrackSourceSettings* settings,
+    mrsExternalAudioTrackSourceHandle* source_handle_out) noexcept;
+
+/// Push |frame_count| frames of interleaved audio, in the format of the
+/// settings of the source. This copies as many frames as fit in the buffer of
+/// the source, and returns their number in |frames_pushed_out|. This never
+/// blocks, but must not be called concurrently for the same source.
+MRS_API mrsResult MRS_CALL
+mrsExternalAudioTrackSourcePushAudio(mrsExternalAudioTrackSourceHandle handle,
+                                     const void* data,
+                                     uint32_t frame_count,
+                                     uint32_t* frames_pushed_out) noexcept;
+
+}  // extern "C"
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Callback invoked when the encoders sending the frames of an external
+/// encoded video track source need a key frame.
+using mrsKeyFrameRequestedCallback = void(MRS_CALL*)(void* user_data);
+
+/// Callback invoked when the target bitrate of an encoder sending the frames
+/// of an external encoded video track source changed.
+using mrsTargetBitrateChangedCallback = void(MRS_CALL*)(void* user_data,
+                                                        uint32_t bitrate_bps,
+                                                        uint32_t framerate);
+
+/// Create a video track source fed by the application with already-encoded
+/// H.264 or VP8 frames, for example produced by a hardware encoder. Local video
+/// tracks created from this source send the frames as is, without decoding nor
+/// re-encoding them, on transceivers which negotiated the same codec. The
+/// frame callbacks of the source receive black frames, as the frames are never
+/// decoded. This returns a handle to a newly allocated object, which must be
+/// released once not used anymore with |mrsRefCountedObjectRemoveRef()|. This
+/// is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsExternalEncodedVideoTrackSourceCreate(
+    mrsExternalEncodedVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Register a callback invoked when a key frame is needed, for example when a
+/// new remote peer starts receiving the frames, or after packet loss. The
+/// application must then submit a key frame as soon as possible; until then,
+/// the delta frames submitted are dropped by the tracks needing a key frame.
+MRS_API void MRS_CALL
+mrsExternalEncodedVideoTrackSourceRegisterKeyFrameCallback(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    mrsKeyFrameRequestedCallback callback,
+    void* user_data) noexcept;
+
+/// Register a callback invoked when the target bitrate of an encoder sending
+/// the frames changed, and when a track starts sending them. The application
+/// should adapt the bitrate of its encoder accordingly. When several tracks
+/// send the frames, each of them reports its own target.
+MRS_API void MRS_CALL
+mrsExternalEncodedVideoTrackSourceRegisterBitrateCallback(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    mrsTargetBitrateChangedCallback callback,
+    void* user_data) noexcept;
+
+/// Submit an encoded frame to the source. The frame is copied and delivered to
+/// the video tracks on the caller's thread before this returns. The codec name
+/// is either "H264", for complete access units in Annex B format, or "VP8".
+/// Key frames must carry their resolution, which delta frames may omit. The
+/// RTP and NTP timestamps of the frame are ignored; the timestamp is in
+/// milliseconds, or zero to use the current time.
+MRS_API mrsResult MRS_CALL mrsExternalEncodedVideoTrackSourcePushFrame(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    const mrsEncodedVideoFrame* frame,
+    int64_t timestamp_ms) noexcept;
+
+}  // extern "C"
@@ -7,6 +7,49 @@
 
 extern "C" {
 
+/// Scheduling of the frame requests of an external video track source.
+enum class mrsExternalVideoFrameScheduling : int32_t {
+  /// Request frames periodically at the target framerate of the source.
+  kPeriodic = 0,
+
+  /// Only request a frame when the application signals that one is available
+  /// with |mrsExternalVideoTrackSourceNotifyFrameAvailable()|.
+  kOnDemand = 1,
+};
+
+/// Settings of an external video track source.
+struct mrsExternalVideoTrackSourceSettings {
+  /// Target framerate of the periodic frame requests, in frames per second.
+  /// This is ignored for on-demand scheduling.
+  float framerate{30.0f};
+
+  /// Scheduling of the frame requests.
+  mrsExternalVideoFrameScheduling scheduling{
+      mrsExternalVideoFrameScheduling::kPeriodic};
+
+  /// Issue the frame requests from a thread dedicated to this source, instead
+  /// of the thread shared by all external video track sources. This avoids
+  /// delays caused by other sources with slow frame callbacks, at the cost of
+  /// one more thread.
+  bool dedicated_thread{false};
+};
+
+/// Resolution and framerate currently wanted by the consumers of the frames
+/// of an external video track source, like an encoder adapting to the available
+/// CPU or bandwidth. Frames exceeding those limits are downscaled or dropped by
+/// the source, so producing them directly within the limits saves that work.
+struct mrsExternalVideoSinkWants {
+  /// Maximum number of pixels per frame, or zero if unconstrained.
+  uint32_t max_pixel_count{0};
+
+  /// Number of pixels per frame the consumers would prefer, if any, or zero if
+  /// there is no preference.
+  uint32_t target_pixel_count{0};
+
+  /// Maximum framerate, in frames per second, or zero if unconstrained.
+  float max_framerate{0.0f};
+};
+
 /// Create a custom video track source external to the implementation. This
 /// allows feeding into WebRTC frames from any source, including generated or
 /// synthetic frames, for example for testing. The frame is provided from a
@@ -29,6 +72,91 @@ MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromArgb32Callback(
     void* user_data,
     mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
 
+/// Create a custom video track source external to the implementation, in push
+/// mode. Instead of answering frame requests, the application submits frames
+/// on its own schedule with |mrsExternalVideoTrackSourcePushI420AFrame()| or
+/// |mrsExternalVideoTrackSourcePushArgb32Frame()|. This returns a handle to a
+/// newly allocated object, which must be released once not used anymore with
+/// |mrsRefCountedObjectRemoveRef()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateForPush(
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Content generated by a synthetic video track source, from the cheapest to
+/// encode to the most expensive.
+enum class mrsSyntheticVideoComplexity : int32_t {
+  /// Still test pattern, generated once.
+  kStatic = 0,
+
+  /// Scrolling gradient with slowly cycling colors.
+  kModerateMotion = 1,
+
+  /// Random noise, different in each frame, which defeats prediction and
+  /// produces the largest encoded frames.
+  kNoise = 2,
+};
+
+/// Configuration of a synthetic video track source.
+struct mrsSyntheticVideoSourceConfig {
+  /// Resolution of the generated frames, in pixels, up to 8192x8192.
+  uint32_t width{640};
+  uint32_t height{480};
+
+  /// Content of the generated frames.
+  mrsSyntheticVideoComplexity complexity{
+      mrsSyntheticVideoComplexity::kModerateMotion};
+};
+
+/// Create an external video track source generating test patterns natively,
+/// without any callback into the application, for example to load test the
+/// library with many video sources. The frames are generated into pooled
+/// buffers when requested, following the same scheduling as other external
+/// video track sources, which is set with
+/// |mrsExternalVideoTrackSourceConfigure()|. This returns a handle to a newly
+/// allocated object, which must be released once not used anymore with
+/// |mrsRefCountedObjectRemoveRef()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateSynthetic(
+    const mrsSyntheticVideoSourceConfig* config,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Configure the frame requests of an external video track source. This can
+/// only be called before |mrsExternalVideoTrackSourceFinishCreation()|. By
+/// default, frames are requested periodically at 30 frames per second.
+///
+/// Whatever the scheduling, no frame is requested, and pushed frames are
+/// discarded, while no consumer uses the frames of the source; that is, while
+/// all its local video tracks are disabled or not sent to any remote peer and
+/// have no frame callback, and the source itself has no frame callback. The
+/// first frame once a consumer uses the frames again is encoded as a key
+/// frame.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceConfigure(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    const mrsExternalVideoTrackSourceSettings* settings) noexcept;
+
+/// Set the hint about the content of the frames of an external video track
+/// source, and whether the encoders should denoise them, for example to encode
+/// screen content with sharp text at a lower framerate. This can be called
+/// before |mrsExternalVideoTrackSourceFinishCreation()| and at any time after.
+/// A change applies to the video senders configured after it, for example when
+/// a track using the source is added to a transceiver. To change the encoding
+/// of a track already sent, use |mrsLocalVideoTrackSetContentHint()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceSetContentHint(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsVideoContentHint content_hint,
+    mrsOptBool denoising) noexcept;
+
+/// Signal an external video track source configured for on-demand scheduling
+/// that a new frame is available, to make it request that frame as soon as
+/// possible.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceNotifyFrameAvailable(
+    mrsExternalVideoTrackSourceHandle source_handle) noexcept;
+
+/// Get the resolution and framerate currently wanted by the consumers of the
+/// frames of an external video track source. This is typically called from
+/// the frame request callback, to produce frames within those limits.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceGetSinkWants(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsExternalVideoSinkWants* wants_out) noexcept;
+
 /// Callback from the wrapper layer indicating that the wrapper has finished
 /// creation, and it is safe to start sending frame requests to it. This needs
 /// to be called after |mrsExternalVideoTrackSourceCreateFromI420ACallback()| or
@@ -44,6 +172,28 @@ MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
     int64_t timestamp_ms,
     const mrsI420AVideoFrame* frame_view) noexcept;
 
+/// Callback invoked when the implementation releases the last reference to a
+/// video frame provided without copy, after which the application can reuse or
+/// free the frame memory.
+using mrsExternalVideoFrameReleaseCallback = void(MRS_CALL*)(void* user_data);
+
+/// Complete a video frame request with a provided I420A video frame, without
+/// copying the frame. Unlike the copying variant, this also preserves the alpha
+/// plane of the frame, if any, unless it is fully opaque, in which case the
+/// frame is sent without alpha to save the encoding of the alpha plane and its
+/// bandwidth. The memory of all planes must remain valid and unmodified until
+/// |release_callback| is invoked, which can happen on any thread, possibly
+/// before this function returns. If this function returns an error, the frame
+/// is not referenced and the callback is never invoked.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopy(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept;
+
 /// Complete a video frame request with a provided ARGB32 video frame.
 MRS_API mrsResult MRS_CALL
 mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
@@ -52,6 +202,454 @@ mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
     int64_t timestamp_ms,
     const mrsArgb32VideoFrame* frame_view) noexcept;
 
+/// Callback converting a native video frame into I420 into the given
+/// destination planes, which have the size of the native frame.
+using mrsNativeVideoFrameToI420Callback =
+    mrsResult(MRS_CALL*)(void* user_data,
+                         void* native_handle,
+                         uint8_t* ydata,
+                         int32_t ystride,
+                         uint8_t* udata,
+                         int32_t ustride,
+                         uint8_t* vdata,
+                         int32_t vstride);
+
+/// Video frame stored in a platform-specific native object, like a D3D11
+/// shared texture, which hardware encoders can consume without copy.
+struct mrsNativeVideoFrame {
+  /// Width of the video frame, in pixels.
+  uint32_t width{0};
+
+  /// Height of the video frame, in pixels.
+  uint32_t height{0};
+
+  /// Opaque handle to the native object holding the frame. This is passed
+  /// as is to the callbacks below, and to hardware encoders supporting it.
+  void* native_handle{nullptr};
+
+  /// Callback invoked at most once if the frame needs to be read in I420
+  /// format, for example by a software encoder or by a frame callback.
+  mrsNativeVideoFrameToI420Callback to_i420_callback{nullptr};
+
+  /// Callback invoked once the implementation released the last reference to
+  /// the frame, after which the native object can be reused or destroyed.
+  mrsExternalVideoFrameReleaseCallback release_callback{nullptr};
+
+  /// User data passed to the callbacks.
+  void* user_data{nullptr};
+};
+
+/// Complete a video frame request with a provided NV12 video frame. The frame
+/// is converted to I420 and the input memory is not referenced afterward.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNv12FrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNv12VideoFrame* frame_view) noexcept;
+
+/// Complete a video frame request with a native video frame. The frame is not
+/// read or converted until needed; its native handle must stay valid until
+/// its release callback is invoked. If this function returns an error, the
+/// frame is not referenced and neither callback is ever invoked.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNativeFrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNativeVideoFrame* frame) noexcept;
+
+/// Submit an I420A video frame to a source created with
+/// |mrsExternalVideoTrackSourceCreateForPush()|. The frame is copied and
+/// delivered to the video tracks on the caller's thread before this returns.
+/// The timestamp is in milliseconds, or zero to use the current time.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushI420AFrame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept;
+
+/// Submit an ARGB32 video frame to a source created with
+/// |mrsExternalVideoTrackSourceCreateForPush()|. The frame is converted and
+/// delivered to the video tracks on the caller's thread before this returns.
+/// The timestamp is in milliseconds, or zero to use the current time.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushArgb32Frame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept;
+
+/// Submit an NV12 video frame to a source created with
+/// |mrsExternalVideoTrackSourceCreateForPush()|. The frame is converted and
+/// delivered to the video tracks on the caller's thread before this returns.
+/// The timestamp is in milliseconds, or zero to use the current time.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNv12Frame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept;
+
+/// Submit a native video frame to a source created with
+/// |mrsExternalVideoTrackSourceCreateForPush()|. The frame is delivered to the
+/// video tracks on the caller's thread before this returns, and its native
+/// handle must stay valid until its release callback is invoked. The timestamp
+/// is in milliseconds, or zero to use the current time.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNativeFrame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    int64_t timestamp_ms) noexcept;
+
+/// Magic number at the start of a shared memory frame ring, "MRSF".
+constexpr uint32_t kMrsSharedFrameRingMagic = 0x4653524D;
+
+/// Version of the layout of a shared memory frame ring described below.
+constexpr uint32_t kMrsSharedFrameRingVersion = 1;
+
+/// State of a slot of a shared memory frame ring. Each transition is an atomic
+/// 32-bit compare-and-swap on |mrsSharedFrameSlotHeader::state|.
+enum class mrsSharedFrameSlotState : uint32_t {
+  /// The slot is owned by the producer, which can write the next frame to it
+  /// after switching it to |kWriting|.
+  kFree = 0,
+
+  /// The producer is writing a frame to the slot.
+  kWriting = 1,
+
+  /// The slot holds a complete frame, which the producer makes visible by
+  /// switching the slot to this state, then signaling the doorbell event.
+  kReady = 2,
+
+  /// The frame is read by the consumer, which switches the slot back to
+  /// |kFree| once the last reference to the frame is released, typically after
+  /// it is encoded.
+  kReading = 3,
+};
+
+/// Header at the start of a shared memory frame ring, at offset zero of the
+/// file mapping. The |slot_count| slots of |slot_size| bytes each follow it,
+/// the first one at offset |header_size|.
+struct mrsSharedFrameRingHeader {
+  /// Must be |kMrsSharedFrameRingMagic|.
+  uint32_t magic;
+
+  /// Must be |kMrsSharedFrameRingVersion|.
+  uint32_t version;
+
+  /// Size of this header, in bytes, including any padding before the first
+  /// slot.
+  uint32_t header_size;
+
+  /// Number of slots in the ring.
+  uint32_t slot_count;
+
+  /// Size of each slot, in bytes, including its |mrsSharedFrameSlotHeader|.
+  uint32_t slot_size;
+};
+
+/// Header at the start of each slot of a shared memory frame ring, describing
+/// the I420 frame stored in the slot. Offsets are relative to the start of the
+/// slot, and the planes must lie within the slot.
+struct mrsSharedFrameSlotHeader {
+  /// Current |mrsSharedFrameSlotState| of the slot.
+  volatile uint32_t state;
+
+  /// Width of the frame, in pixels.
+  uint32_t width;
+
+  /// Height of the frame, in pixels.
+  uint32_t height;
+
+  /// Offsets of the Y, U and V planes, in bytes.
+  uint32_t yoffset;
+  uint32_t uoffset;
+  uint32_t voffset;
+
+  /// Row strides of the Y, U and V planes, in bytes.
+  int32_t ystride;
+  int32_t ustride;
+  int32_t vstride;
+
+  /// Reserved, must be zero.
+  uint32_t reserved;
+
+  /// Capture timestamp, in milliseconds, or zero to use the time the frame is
+  /// read.
+  int64_t timestamp_ms;
+
+  /// Sequence number of the frame, incremented by the producer for each frame.
+  /// When several slots are ready, the frame with the highest sequence number
+  /// is delivered and the older ones are dropped.
+  uint64_t sequence;
+};
+
+/// Create an external video track source reading I420 frames written by
+/// another process to a shared memory frame ring, without copying them. The
+/// producer creates the ring as the named file mapping |mapping_name|, laid
+/// out as described by |mrsSharedFrameRingHeader|, and the auto-reset named
+/// event |doorbell_event_name| it signals each time a slot becomes ready. The
+/// frames are read on a thread owned by the source, and delivered to the video
+/// tracks by wrapping the slot memory directly; each slot is handed back to
+/// the producer once the last reference to its frame is released, typically
+/// after it is encoded, so the ring needs enough slots for the frames in
+/// flight. Frames ready before |mrsExternalVideoTrackSourceFinishCreation()|
+/// is called are dropped.
+///
+/// This is only supported on Windows desktop, and returns |kUnsupported| on
+/// other platforms. This returns |kNotFound| if the mapping or the event do not
+/// exist, and |kInvalidParameter| if the ring header is not valid.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromSharedMemory(
+    const char* mapping_name,
+    const char* doorbell_event_name,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Statistics of the pool of frame buffers of an external video track source.
+struct mrsExternalVideoBufferPoolStats {
+  /// Number of frames copied or converted into a buffer reused from the pool.
+  uint64_t hit_count{0};
+
+  /// Number of frames which required allocating a new buffer, either because
+  /// all pooled buffers were in use, or because the frame resolution changed.
+  uint64_t miss_count{0};
+};
+
+/// Get the statistics of the pool of frame buffers used by an external video
+/// track source to copy or convert the frames provided by the application.
+/// Frames completed without copy are not counted.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceGetBufferPoolStats(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsExternalVideoBufferPoolStats* stats_out) noexcept;
+
+/// Enable or disable stamping a machine-readable latency marker into the
+/// pixels of each frame produced by an external video track source, with a
+/// frame number and the capture time in the UTC clock of the sender. The
+/// receiver decodes the markers to measure the end-to-end latency of the
+/// frames, see |mrsRemoteVideoTrackSetLatencyMarkerDecoding()|. The marker
+/// overwrites the top-left corner of the frames, over a quarter of their
+/// width, so this is meant for test and diagnostic sessions only. Frames less
+/// than 128 pixels wide are not stamped.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceSetLatencyMarkers(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsBool enabled) noexcept;
+
+/// Synchronize the clock of the capture times passed to the functions
+/// completing or pushing frames with a capture time, like
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|,
+/// with the clock of the frame timestamps, given the current time of that clock
+/// in microseconds, for example from the performance counter of the system.
+/// Call this before passing capture times, and periodically if the clocks
+/// drift apart. Until then, capture times are in the clock of the frame
+/// timestamps.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceSyncCaptureClock(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    int64_t app_time_us) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteI420AFrameRequest()| passing
+/// the capture time of the frame, in microseconds of the clock synchronized
+/// with |mrsExternalVideoTrackSourceSyncCaptureClock()|. Without a capture
+/// time, frames are stamped with the time of their request, or the timestamp
+/// passed to push them, at millisecond resolution. The capture time becomes
+/// the timestamp of the frame, which the encoder paces the frames with and
+/// which the receiver synchronizes the audio and video with, so it should be
+/// the time the content of the frame was captured or rendered, before any
+/// readback. Capture times later than the current time are clamped to it, and
+/// timestamps are kept increasing from frame to frame. A capture time earlier
+/// than the origin of the clock of the frame timestamps returns
+/// |mrsResult::kInvalidParameter|, without completing the request.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsI420AVideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopy()|
+/// passing the capture time of the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopyWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteArgb32FrameRequest()|
+/// passing the capture time of the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsArgb32VideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteNv12FrameRequest()| passing
+/// the capture time of the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNv12FrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsNv12VideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteNativeFrameRequest()|
+/// passing the capture time of the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNativeFrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsNativeVideoFrame* frame) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushI420AFrame()| passing the
+/// capture time of the frame instead of its timestamp. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourcePushI420AFrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    int64_t capture_time_us) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushArgb32Frame()| passing the
+/// capture time of the frame instead of its timestamp. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    int64_t capture_time_us) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushNv12Frame()| passing the capture
+/// time of the frame instead of its timestamp. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourcePushNv12FrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    int64_t capture_time_us) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushNativeFrame()| passing the
+/// capture time of the frame instead of its timestamp. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourcePushNativeFrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    int64_t capture_time_us) noexcept;
+
+/// Information passed along with a frame completed or pushed on an external
+/// video track source, with the variants of the functions completing requests
+/// and pushing frames taking it, like
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo()|.
+struct mrsExternalVideoFrameInfo {
+  /// Capture time of the frame, in microseconds of the clock synchronized
+  /// with |mrsExternalVideoTrackSourceSyncCaptureClock()|, if
+  /// |has_capture_time| is set. See
+  /// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+  int64_t capture_time_us{0};
+
+  /// Use |capture_time_us| as the capture time of the frame. Otherwise the
+  /// frame is stamped with the time of its request, or the current time when
+  /// pushed.
+  mrsBool has_capture_time{mrsBool::kFalse};
+
+  /// Application metadata, like the pose the frame was rendered for, or NULL
+  /// if none. The metadata is copied, and delivered along with the frame in
+  /// the |metadata_| field of the frames passed to the frame callbacks of the
+  /// local and remote video tracks, so that both arrive together. The
+  /// metadata is sent as a trailer of the encoded frame, which the remote peer
+  /// must remove before decoding, so the remote peer must also use this
+  /// library. Remote frames only carry their metadata on Windows Desktop. The
+  /// metadata is dropped along with the frame if the frame is dropped.
+  const void* metadata{nullptr};
+
+  /// Size of |metadata|, in bytes, limited to 1024 bytes.
+  uint32_t metadata_size{0};
+};
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteI420AFrameRequest()| passing
+/// information along with the frame. If |info| is invalid, this returns
+/// |mrsResult::kInvalidParameter| without completing the request.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsI420AVideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopy()|
+/// passing information along with the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopyWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteArgb32FrameRequest()|
+/// passing information along with the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsArgb32VideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteNv12FrameRequest()| passing
+/// information along with the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNv12FrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsNv12VideoFrame* frame_view) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourceCompleteNativeFrameRequest()|
+/// passing information along with the frame. See
+/// |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo()|.
+MRS_API mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNativeFrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsNativeVideoFrame* frame) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushI420AFrame()| passing
+/// information along with the frame. A frame pushed while no sink consumes the
+/// frames of the source is dropped along with its metadata.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushI420AFrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushArgb32Frame()| passing
+/// information along with the frame. See
+/// |mrsExternalVideoTrackSourcePushI420AFrameWithInfo()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushArgb32FrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushNv12Frame()| passing information
+/// along with the frame. See
+/// |mrsExternalVideoTrackSourcePushI420AFrameWithInfo()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNv12FrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept;
+
+/// Variant of |mrsExternalVideoTrackSourcePushNativeFrame()| passing
+/// information along with the frame. See
+/// |mrsExternalVideoTrackSourcePushI420AFrameWithInfo()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNativeFrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    const mrsExternalVideoFrameInfo* info) noexcept;
+
 /// Irreversibly stop the video source frame production and shutdown the video
 /// source.
 MRS_API void MRS_CALL mrsExternalVideoTrackSourceShutdown(
@@ -24,6 +24,75 @@ enum class mrsOptBool : int8_t { kTrue = -1, kFalse = 0, kUnset = 0b01010101 };
 /// Report live objects to debug output, and return the number of live objects.
 MRS_API uint32_t MRS_CALL mrsReportLiveObjects() noexcept;
 
+/// Number of live objects of a given type.
+struct mrsLiveObjectCount {
+  /// Number of objects currently alive.
+  uint32_t current;
+
+  /// Maximum number of objects simultaneously alive since the last call to
+  /// |mrsResetMemoryReportPeaks()|, or since the library was loaded.
+  uint32_t peak;
+};
+
+/// Amount of native memory held in a given category.
+struct mrsMemoryUsage {
+  /// Number of bytes currently held.
+  uint64_t current_bytes;
+
+  /// Maximum number of bytes simultaneously held since the last call to
+  /// |mrsResetMemoryReportPeaks()|, or since the library was loaded.
+  uint64_t peak_bytes;
+};
+
+/// Report of the live objects and of the native memory held by the library,
+/// to track down leaks and size budgets on memory-constrained devices. The
+/// memory usage only covers the long-lived buffers allocated by the library
+/// itself, and not the memory allocated by the WebRTC implementation.
+struct mrsMemoryReport {
+  /// Live objects of each type.
+  mrsLiveObjectCount peer_connections;
+  mrsLiveObjectCount local_audio_tracks;
+  mrsLiveObjectCount local_video_tracks;
+  mrsLiveObjectCount remote_audio_tracks;
+  mrsLiveObjectCount remote_video_tracks;
+  mrsLiveObjectCount data_channels;
+  mrsLiveObjectCount audio_transceivers;
+  mrsLiveObjectCount video_transceivers;
+  mrsLiveObjectCount device_audio_track_sources;
+  mrsLiveObjectCount device_video_track_sources;
+  mrsLiveObjectCount external_video_track_sources;
+  mrsLiveObjectCount relay_video_track_sources;
+  mrsLiveObjectCount external_encoded_video_track_sources;
+  mrsLiveObjectCount external_audio_track_sources;
+
+  /// Video frames queued for the application and not yet dequeued.
+  mrsMemoryUsage frame_buffers;
+
+  /// Scratch buffers for converting and scaling video frames delivered to the
+  /// frame callbacks, including the pooled ARGB32 buffers.
+  mrsMemoryUsage scratch_buffers;
+
+  /// Buffers of the remote audio samples read by the application.
+  mrsMemoryUsage audio_read_buffers;
+
+  /// Messages queued for sending or receiving on data channels.
+  mrsMemoryUsage data_channel_queues;
+
+  /// Video frame buffers pooled by video track sources for reuse.
+  mrsMemoryUsage buffer_pools;
+};
+
+/// Get a report of the live objects and of the native memory held by the
+/// library. Unlike |mrsReportLiveObjects()| this does not enumerate objects,
+/// so is cheap enough to poll periodically. This does not initialize the
+/// library.
+MRS_API mrsResult MRS_CALL
+mrsGetMemoryReport(mrsMemoryReport* report) noexcept;
+
+/// Reset the peaks of the memory report to the current values, to measure the
+/// peaks of a given phase of the application.
+MRS_API void MRS_CALL mrsResetMemoryReportPeaks() noexcept;
+
 /// Global MixedReality-WebRTC library shutdown options.
 enum class mrsShutdownOptions : uint32_t {
   kNone = 0,
@@ -60,6 +129,223 @@ mrsSetShutdownOptions(mrsShutdownOptions options) noexcept;
 /// loss of data is acceptable.
 MRS_API void MRS_CALL mrsForceShutdown() noexcept;
 
+/// Callback creating a video encoder factory when the library initializes. This
+/// returns a pointer to a new |webrtc::VideoEncoderFactory| object created with
+/// |new|, whose ownership is transferred to the library, or NULL to only use
+/// the built-in encoders. This allows plugging for example hardware encoders
+/// from a native plugin built against the same WebRTC headers.
+using mrsVideoEncoderFactoryCreateCallback = void*(MRS_CALL*)(void* user_data);
+
+/// Callback creating a video decoder factory when the library initializes. This
+/// returns a pointer to a new |webrtc::VideoDecoderFactory| object created with
+/// |new|, whose ownership is transferred to the library, or NULL to only use
+/// the built-in decoders.
+using mrsVideoDecoderFactoryCreateCallback = void*(MRS_CALL*)(void* user_data);
+
+/// Set the callbacks creating custom video encoder and decoder factories each
+/// time the library initializes, or NULL to only use the built-in codecs. The
+/// codecs of the custom factories are preferred, with the built-in software
+/// codecs used for the other formats, and as a fallback when a custom codec
+/// fails. This must be called while the library is not initialized, that is
+/// before any object is created or after all are destroyed, and otherwise
+/// returns |mrsResult::kInvalidOperation|. This is not supported on UWP, where
+/// the platform factory provides its own hardware codecs.
+MRS_API mrsResult MRS_CALL mrsSetVideoCodecFactories(
+    mrsVideoEncoderFactoryCreateCallback encoder_factory_callback,
+    mrsVideoDecoderFactoryCreateCallback decoder_factory_callback,
+    void* user_data) noexcept;
+
+/// Use Java video codec factories on Android, typically an
+/// |org.webrtc.DefaultVideoEncoderFactory| and an
+/// |org.webrtc.DefaultVideoDecoderFactory| created with a shared EGL context,
+/// passed as JNI object references, or NULL for the built-in codecs only. With
+/// an EGL context, hardware encoders consume texture frames from
+/// |mrsDeviceVideoTrackSourceCreateFromAndroidCapturer()| through their input
+/// surface, and hardware decoders output frames as textures, which
+/// |mrsVideoFrameBufferGetAndroidTexture()| exposes. This replaces any
+/// factories set with |mrsSetVideoCodecFactories()|, and has the same
+/// restrictions. This returns |mrsResult::kUnsupported| on other platforms.
+MRS_API mrsResult MRS_CALL
+mrsSetAndroidVideoCodecFactories(void* j_encoder_factory,
+                                 void* j_decoder_factory) noexcept;
+
+/// Scheduling priority of a WebRTC thread.
+enum class mrsThreadPriority : int32_t {
+  /// Keep the priority the thread was created with.
+  kDefault = 0,
+  kLow = 1,
+  kNormal = 2,
+  kHigh = 3,
+  kHighest = 4,
+};
+
+/// Scheduling options of a WebRTC thread.
+struct mrsThreadOptions {
+  /// Priority of the thread. On Android, raising the priority above normal
+  /// may fail without the necessary permissions, in which case the thread
+  /// keeps its default priority.
+  mrsThreadPriority priority{mrsThreadPriority::kDefault};
+
+  /// Mask of the logical processors the thread may run on, where bit N stands
+  /// for processor N, or zero to let the thread run on any processor.
+  uint64_t affinity_mask{0};
+};
+
+/// Configuration of a group of WebRTC threads. Each group has its own network,
+/// worker, and signaling threads, which serve the peer connections assigned to
+/// the group with |mrsPeerConnectionConfiguration::thread_group|, so that the
+/// processing of many connections is spread across several threads.
+struct mrsThreadGroupConfig {
+  /// Options of the thread sending and receiving the network packets.
+  mrsThreadOptions network_thread;
+
+  /// Options of the thread processing the media packets.
+  mrsThreadOptions worker_thread;
+
+  /// Options of the thread invoking the peer connection callbacks.
+  mrsThreadOptions signaling_thread;
+};
+
+/// Set the configuration of the groups of WebRTC threads created each time the
+/// library initializes, or pass NULL and zero to use a single group of threads
+/// with the default options. Local tracks and their sources are created by the
+/// first group, and can be added to the peer connections of any group. This
+/// must be called while the library is not initialized, that is before any
+/// object is created or after all are destroyed, and otherwise returns
+/// |mrsResult::kInvalidOperation|. This is not supported on UWP, where the
+/// platform factory creates its own threads.
+MRS_API mrsResult MRS_CALL
+mrsSetThreadGroups(const mrsThreadGroupConfig* groups, uint32_t count) noexcept;
+
+/// Platform audio API used by the audio device module to capture and render
+/// audio. Layers not available on the current platform fail to initialize.
+enum class mrsAudioDeviceLayer : int32_t {
+  /// Default API of the platform, WASAPI in shared mode on Windows.
+  kPlatformDefault = 0,
+
+  /// Windows Core Audio (WASAPI) with the legacy implementation.
+  kWindowsCoreAudio = 1,
+
+  /// Windows Core Audio (WASAPI) with the newer, lower latency implementation.
+  kWindowsCoreAudio2 = 2,
+
+  /// Android Java capture and rendering.
+  kAndroidJava = 3,
+
+  /// Android OpenSL ES capture and rendering.
+  kAndroidOpenSLES = 4,
+
+  /// Android Java capture, and OpenSL ES low latency rendering.
+  kAndroidJavaInputAndOpenSLESOutput = 5,
+
+  /// Android AAudio capture and rendering, on Android 8.1 and later.
+  kAndroidAAudio = 6,
+
+  /// Android Java capture, and AAudio low latency rendering.
+  kAndroidJavaInputAndAAudioOutput = 7,
+
+  /// No audio device; capture produces no audio, and rendering discards it.
+  kDummy = 8,
+};
+
+/// Configuration of the audio device module created when the library
+/// initializes.
+struct mrsAudioDeviceModuleConfig {
+  mrsAudioDeviceLayer audio_layer{mrsAudioDeviceLayer::kPlatformDefault};
+};
+
+/// Set the configuration of the audio device module created when the library
+/// initializes. This must be called while the library is not initialized, and
+/// otherwise returns |mrsResult::kInvalidOperation|. This is not supported on
+/// UWP, where the platform factory creates its own audio device module.
+///
+/// The platform echo cancellation, noise suppression and gain control, where
+/// available, are used instead of the WebRTC ones when enabled on the audio
+/// sources, see |mrsLocalAudioDeviceInitConfig|.
+MRS_API mrsResult MRS_CALL mrsSetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig* config) noexcept;
+
+/// Type of the key of the DTLS certificates.
+enum class mrsCertificateKeyType : int32_t {
+  /// ECDSA key on the NIST P-256 curve, the default of WebRTC, much faster to
+  /// generate than RSA.
+  kEcdsa = 0,
+
+  /// RSA 1024-bit key, for compatibility with older remote peers.
+  kRsa = 1,
+};
+
+/// Configuration of the pool of DTLS certificates of the library.
+struct mrsCertificatePoolConfig {
+  /// Number of certificates generated ahead of time on a background thread,
+  /// up to 64, or zero to let each peer connection generate its own.
+  uint32_t pool_size{0};
+
+  /// Type of the key of the certificates generated by the pool.
+  mrsCertificateKeyType key_type{mrsCertificateKeyType::kEcdsa};
+};
+
+/// Set the configuration of the pool of DTLS certificates created when the
+/// library initializes. Each peer connection created takes a certificate from
+/// the pool instead of generating one, which shortens the creation of
+/// connections, especially with RSA keys or when many connections are created
+/// at once, and the pool generates a replacement in the background. If the
+/// pool is empty, the connection generates its own certificate as usual. See
+/// also |mrsPeerConnectionConfiguration::certificate_identity| to reuse
+/// certificates. This must be called while the library is not initialized,
+/// and otherwise returns |mrsResult::kInvalidOperation|.
+MRS_API mrsResult MRS_CALL
+mrsSetCertificatePoolConfig(const mrsCertificatePoolConfig* config) noexcept;
+
+/// Threading of the video decoders created when the library initializes.
+/// WebRTC lets each software decoder use as many threads as there are
+/// processors, which oversubscribes the processors when receiving many
+/// streams. Only decoders able to decode a frame on several threads use more
+/// than one, like the built-in VP9 decoder; the built-in VP8 and H.264
+/// decoders always decode on the decoding thread of their stream. See also
+/// |mrsRemoteVideoTrackSetLowPriorityDecoding()|.
+struct mrsVideoDecoderThreadingConfig {
+  /// Maximum number of threads of the decoder of a single stream, up to 64, or
+  /// zero for as many as there are processors.
+  uint32_t max_threads_per_decoder{0};
+
+  /// Maximum number of threads of the decoders of all streams together, or
+  /// zero for no limit. Decoders created once the budget is exhausted use a
+  /// single thread each.
+  uint32_t thread_budget{0};
+};
+
+/// Set the threading of the video decoders created when the library
+/// initializes. This must be called while the library is not initialized, and
+/// otherwise returns |mrsResult::kInvalidOperation|. This is not supported on
+/// UWP, where the platform factory creates its own decoders.
+MRS_API mrsResult MRS_CALL mrsSetVideoDecoderThreadingConfig(
+    const mrsVideoDecoderThreadingConfig* config) noexcept;
+
+/// Set the scalability mode of all the VP9 encoders, named "L<S>T<T>" after
+/// the number of spatial and temporal layers, from "L1T1" to "L3T3", or NULL
+/// for the default "L1T1". This version of WebRTC configures the layers of
+/// all VP9 encoders of the process at once, through the "WebRTC-SupportVP9SVC"
+/// field trial, which is appended to the field trials of the application when
+/// the library initializes. This must be called while the library is not
+/// initialized, and otherwise returns |mrsResult::kInvalidOperation|. See also
+/// |mrsRtpEncodingParameters::scalability_mode|.
+MRS_API mrsResult MRS_CALL mrsSetVp9ScalabilityMode(const char* mode) noexcept;
+
+/// Callback fired once the initialization of the library started with
+/// |mrsLibraryInitializeAsync()| completed, with its result.
+using mrsLibraryInitializedCallback = void(MRS_CALL*)(void* user_data,
+                                                      mrsResult result);
+
+/// Start initializing the library on a background thread, instead of when the
+/// first object is created, and invoke |callback| on that thread once done.
+/// Objects created in the meantime wait for the initialization to complete.
+/// The library then stays initialized until the first object is created and
+/// all objects are destroyed again. This must not be called from the callback.
+MRS_API mrsResult MRS_CALL
+mrsLibraryInitializeAsync(mrsLibraryInitializedCallback callback,
+                          void* user_data) noexcept;
+
 /// Opaque enumerator type.
 struct mrsEnumerator;
 
@@ -119,9 +405,26 @@ using mrsExternalVideoTrackSourceHandle = mrsVideoTrackSourceHandle;
 /// Opaque handle to a native DeviceVideoTrackSource interop object.
 using mrsDeviceVideoTrackSourceHandle = mrsVideoTrackSourceHandle;
 
+/// Opaque handle to a native RelayVideoTrackSource interop object.
+using mrsRelayVideoTrackSourceHandle = mrsVideoTrackSourceHandle;
+
+/// Opaque handle to a native ExternalEncodedVideoTrackSource interop object.
+using mrsExternalEncodedVideoTrackSourceHandle = mrsVideoTrackSourceHandle;
+
+/// Opaque handle to a native VideoFrameQueue object. This is not an object
+/// handle; see |mrsVideoFrameQueueCreate()|.
+using mrsVideoFrameQueueHandle = void*;
+
+/// Opaque handle to a native VideoTextureUploader object. This is not an
+/// object handle; see |mrsVideoTextureUploaderCreate()|.
+using mrsVideoTextureUploaderHandle = void*;
+
 /// Opaque handle to a native DeviceAudioTrackSource interop object.
 using mrsDeviceAudioTrackSourceHandle = mrsAudioTrackSourceHandle;
 
+/// Opaque handle to a native ExternalAudioTrackSource interop object.
+using mrsExternalAudioTrackSourceHandle = mrsAudioTrackSourceHandle;
+
 //
 // Video capture enumeration
 //
@@ -139,6 +442,9 @@ using mrsVideoCaptureDeviceEnumCompletedCallback =
 /// For each device found, invoke the mandatory |callback|.
 /// At the end of the enumeration, invoke the optional |completedCallback| if it
 /// was provided (non-null).
+/// The devices are cached until the operating system reports a device added or
+/// removed, see |mrsSetVideoCaptureDevicesChangedCallback()|. Once cached, the
+/// callbacks are invoked synchronously before this function returns.
 /// On UWP this must *not* be called from the main UI thread, otherwise a
 /// |mrsResult::kWrongThread| error might be returned.
 MRS_API mrsResult MRS_CALL mrsEnumVideoCaptureDevicesAsync(
@@ -162,6 +468,8 @@ using mrsVideoCaptureFormatEnumCompletedCallback =
 /// For each device found, invoke the mandatory |callback|.
 /// At the end of the enumeration, invoke the optional |completedCallback| if it
 /// was provided (non-null).
+/// The formats are cached like the devices, see
+/// |mrsEnumVideoCaptureDevicesAsync()|.
 /// On UWP this must *not* be called from the main UI thread, otherwise a
 /// |mrsResult::kWrongThread| error might be returned.
 MRS_API mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
@@ -171,6 +479,18 @@ MRS_API mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
     mrsVideoCaptureFormatEnumCompletedCallback completedCallback,
     void* completedCallbackUserData) noexcept;
 
+/// Callback invoked when a video capture device was added or removed.
+using mrsVideoCaptureDevicesChangedCallback = void(MRS_CALL*)(void* user_data);
+
+/// Set the callback invoked when the operating system reports a video capture
+/// device added or removed, which also drops the cached devices and formats.
+/// The callback is invoked on a background thread of the operating system.
+/// Pass a NULL |callback| to unregister it. Device changes are not reported on
+/// platforms other than Windows and UWP, where nothing is cached either.
+MRS_API void MRS_CALL mrsSetVideoCaptureDevicesChangedCallback(
+    mrsVideoCaptureDevicesChangedCallback callback,
+    void* user_data) noexcept;
+
 //
 // Peer connection
 //
@@ -303,6 +623,11 @@ enum class mrsDataChannelConfigFlags : uint32_t {
   kNone = 0,
   kOrdered = 0x1,
   kReliable = 0x2,
+  /// Compress messages above a size threshold, see
+  /// |mrsDataChannelSetCompressionThreshold|. For in-band channels this is
+  /// negotiated with the remote peer through the channel protocol; for
+  /// out-of-band negotiated channels, both peers must set it.
+  kCompressed = 0x4,
 };
 
 inline mrsDataChannelConfigFlags operator|(
@@ -313,7 +638,7 @@ inline mrsDataChannelConfigFlags operator|(
 
 inline uint32_t operator&(mrsDataChannelConfigFlags a,
                           mrsDataChannelConfigFlags b) noexcept {
-  return ((uint32_t)a | (uint32_t)b);
+  return ((uint32_t)a & (uint32_t)b);
 }
 
 struct mrsDataChannelAddedInfo {
@@ -321,6 +646,11 @@ struct mrsDataChannelAddedInfo {
   int id{0};
   mrsDataChannelConfigFlags flags{};
   const char* label{nullptr};
+
+  /// Partial reliability of the channel, as set in |mrsDataChannelConfig|, or
+  /// -1 if not set.
+  int32_t max_retransmits{-1};
+  int32_t max_packet_lifetime_ms{-1};
 };
 
 /// Callback invoked when a data channel is added to the peer connection. This
@@ -357,6 +687,91 @@ using mrsArgb32VideoFrame = Microsoft::MixedReality::WebRTC::Argb32VideoFrame;
 using mrsArgb32VideoFrameCallback =
     void(MRS_CALL*)(void* user_data, const mrsArgb32VideoFrame& frame);
 
+using mrsNv12VideoFrame = Microsoft::MixedReality::WebRTC::Nv12VideoFrame;
+
+/// Callback invoked when a local or remote (depending on use) video frame is
+/// available to be consumed by the caller, usually for display.
+/// The video frame is encoded in NV12 biplanar format, which is the native
+/// input format of most GPU video pipelines.
+using mrsNv12VideoFrameCallback =
+    void(MRS_CALL*)(void* user_data, const mrsNv12VideoFrame& frame);
+
+using mrsVideoFrameDeliveryOptions =
+    Microsoft::MixedReality::WebRTC::VideoFrameDeliveryOptions;
+
+using mrsVideoFrameBufferType =
+    Microsoft::MixedReality::WebRTC::VideoFrameBufferType;
+
+using mrsVideoFrameLease = Microsoft::MixedReality::WebRTC::VideoFrameLease;
+
+/// Handle to a video frame buffer leased through a |mrsVideoFrameLease|.
+using mrsVideoFrameBufferHandle = void*;
+
+/// Callback invoked when a local or remote (depending on use) video frame is
+/// available to be consumed by the caller, usually for display.
+/// The video frame is delivered as a lease over the original frame buffer,
+/// without any copy or color conversion. The callee receives a reference to
+/// the buffer, and must release it with |mrsVideoFrameBufferRemoveRef()| once
+/// done with it, possibly after the callback returned.
+using mrsVideoFrameLeaseCallback =
+    void(MRS_CALL*)(void* user_data, const mrsVideoFrameLease& lease);
+
+/// Callback invoked when a local or remote (depending on use) video frame is
+/// available to be consumed by the caller, usually for display.
+/// The video frame is encoded in ARGB 32-bit per pixel, and stored in a buffer
+/// from a fixed-size pool. The callee can check out that buffer by calling
+/// |mrsVideoFrameBufferAddRef()| on |buffer_handle| to keep the frame data
+/// alive once the callback returned, and must return it to the pool with
+/// |mrsVideoFrameBufferRemoveRef()| once done. This avoids copying the frame
+/// before the callback returns.
+using mrsArgb32VideoFrameLeaseCallback =
+    void(MRS_CALL*)(void* user_data,
+                    const mrsArgb32VideoFrame& frame,
+                    mrsVideoFrameBufferHandle buffer_handle);
+
+/// Add a reference to a leased video frame buffer. This allows sharing a lease
+/// between several consumers, each releasing its own reference.
+MRS_API void MRS_CALL
+mrsVideoFrameBufferAddRef(mrsVideoFrameBufferHandle handle) noexcept;
+
+/// Remove a reference from a leased video frame buffer. Once the last reference
+/// is removed, the buffer can be recycled or destroyed, and the plane pointers
+/// of the lease become invalid.
+MRS_API void MRS_CALL
+mrsVideoFrameBufferRemoveRef(mrsVideoFrameBufferHandle handle) noexcept;
+
+/// OpenGL ES texture holding a video frame on Android.
+struct mrsAndroidTextureFrame {
+  /// Name of the texture.
+  uint32_t texture_id;
+
+  /// Texture target to bind the texture to, either GL_TEXTURE_EXTERNAL_OES
+  /// for frames of a SurfaceTexture, or GL_TEXTURE_2D.
+  uint32_t gl_target;
+
+  /// Width of the video frame, in pixels.
+  uint32_t width;
+
+  /// Height of the video frame, in pixels.
+  uint32_t height;
+
+  /// Column-major 4x4 matrix transforming the texture coordinates of the
+  /// frame, in the [0:1] range, into the coordinates to sample the texture
+  /// with, which accounts for the cropping and flipping of the frame.
+  float transform_matrix[16];
+};
+
+/// Get the OpenGL ES texture of a leased |mrsVideoFrameBufferType::kNative|
+/// frame buffer on Android, produced by a hardware decoder or a capturer with
+/// an EGL context. The texture can only be sampled from an EGL context sharing
+/// objects with the context of the Java codec factories, and its content is
+/// only valid while the lease holds a reference to the buffer. This returns
+/// |mrsResult::kUnsupported| for buffers not holding a texture, and on other
+/// platforms.
+MRS_API mrsResult MRS_CALL mrsVideoFrameBufferGetAndroidTexture(
+    mrsVideoFrameBufferHandle handle,
+    mrsAndroidTextureFrame* texture_out) noexcept;
+
 using mrsAudioFrame = Microsoft::MixedReality::WebRTC::AudioFrame;
 
 /// Callback invoked when a local or remote (depending on use) audio frame is
@@ -364,6 +779,27 @@ using mrsAudioFrame = Microsoft::MixedReality::WebRTC::AudioFrame;
 using mrsAudioFrameCallback = void(MRS_CALL*)(void* user_data,
                                               const mrsAudioFrame& frame);
 
+/// Audio level of a local or remote audio track, measured natively over the
+/// last audio frame received, that is usually the last 10 ms of audio.
+struct mrsAudioLevel {
+  /// Root mean square of the samples of all channels, in the [0:1] range where
+  /// 1 is a full-scale signal.
+  float rms{0.0f};
+
+  /// Peak absolute value of the samples of all channels, in the [0:1] range.
+  float peak{0.0f};
+
+  /// Whether the track likely carries voice. This is a lightweight energy
+  /// detector comparing the level to an estimate of the noise floor, which
+  /// holds for 200 ms after the level drops, to bridge pauses between words.
+  mrsBool voice_active{mrsBool::kFalse};
+};
+
+/// Callback invoked when the audio level of a local or remote audio track
+/// changes significantly.
+using mrsAudioLevelCallback = void(MRS_CALL*)(void* user_data,
+                                              const mrsAudioLevel& level);
+
 /// ICE transport type. See webrtc::PeerConnectionInterface::IceTransportsType.
 /// Currently values are aligned, but kept as a separate structure to allow
 /// backward compatilibity in case of changes in WebRTC.
@@ -383,6 +819,19 @@ enum class mrsBundlePolicy : int32_t {
   kMaxCompat = 2
 };
 
+/// Continual gathering policy. See
+/// webrtc::PeerConnectionInterface::ContinualGatheringPolicy.
+/// Currently values are aligned, but kept as a separate structure to allow
+/// backward compatilibity in case of changes in WebRTC.
+enum class mrsContinualGatheringPolicy : int32_t {
+  /// Gather candidates once, until gathering completes.
+  kGatherOnce = 0,
+  /// Keep gathering candidates as network interfaces change, for example to
+  /// recover a connection when a device switches networks. Gathering never
+  /// completes with this policy.
+  kGatherContinually = 1
+};
+
 /// SDP semantic (protocol dialect) for (re)negotiating a peer connection.
 /// This cannot be changed after the connection is established.
 enum class mrsSdpSemantic : int32_t {
@@ -393,6 +842,8 @@ enum class mrsSdpSemantic : int32_t {
   kPlanB = 1
 };
 
+struct mrsDataChannelConfig;
+
 /// Configuration to intialize a peer connection object.
 struct mrsPeerConnectionConfiguration {
   /// ICE servers, encoded as a single string buffer.
@@ -425,6 +876,107 @@ struct mrsPeerConnectionConfiguration {
   /// SDP semantic for connection negotiation.
   /// Do not use Plan B unless there is a problem with Unified Plan.
   mrsSdpSemantic sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+
+  /// Number of ICE candidates gathered ahead of time, as soon as the peer
+  /// connection is created, instead of after the first offer or answer is
+  /// created. This shortens the connection setup, especially with TURN
+  /// servers, at the expense of allocating ports and contacting ICE servers
+  /// even if no connection is established. Zero disables pre-gathering. See
+  /// also |mrsPeerConnectionPrewarmIce()|.
+  int ice_candidate_pool_size = 0;
+
+  /// Continual gathering policy for the connection.
+  mrsContinualGatheringPolicy continual_gathering_policy =
+      mrsContinualGatheringPolicy::kGatherOnce;
+
+  /// Index of the group of WebRTC threads serving the connection, as
+  /// configured with |mrsSetThreadGroups()|. The first group is used by
+  /// default.
+  uint32_t thread_group = 0;
+
+  /// Out-of-band negotiated data channels created with the connection, before
+  /// |mrsPeerConnectionCreate()| returns. Each configuration must have a fixed
+  /// ID, and the remote peer must create the same channels. These channels
+  /// open as soon as the SCTP association is established, without the DCEP
+  /// handshake of in-band channels. Use |mrsPeerConnectionGetDataChannelById()|
+  /// to get their handles. The configurations are not used after the call.
+  const mrsDataChannelConfig* data_channels = nullptr;
+  uint32_t data_channel_count = 0;
+
+  /// Maximum number of packets held by the jitter buffer of each audio
+  /// receiver of the connection, or zero for the default of 50 packets. A lower
+  /// value bounds the audio latency under network jitter, at the expense of
+  /// more audio concealment. The video latency is controlled by the sender, see
+  /// |mrsLocalVideoTrackSetPlayoutDelay()|.
+  int audio_jitter_buffer_max_packets = 0;
+
+  /// Range of the local UDP and TCP ports of the ICE candidates, inclusive, or
+  /// zero for any port. Restricting the ports eases firewall configuration on
+  /// servers. This is not supported on UWP.
+  int min_port = 0;
+  int max_port = 0;
+
+  /// Do not gather TCP candidates, which are rarely used when UDP is not
+  /// blocked, and each cost a listening socket.
+  mrsBool disable_tcp_candidates = mrsBool::kFalse;
+
+  /// Do not gather candidates on IPv6 interfaces.
+  mrsBool disable_ipv6 = mrsBool::kFalse;
+
+  /// Do not gather candidates on link-local IPv4 and IPv6 addresses, which are
+  /// only reachable on the same network segment.
+  mrsBool disable_link_local_networks = mrsBool::kFalse;
+
+  /// Semicolon-separated lists of network interfaces to gather candidates on,
+  /// and to ignore, or NULL. Interfaces match if any item is part of their
+  /// name or description, compared case-insensitively. On Windows, the name is
+  /// the GUID of the adapter, and the description its friendly name, for
+  /// example "vEthernet (Default Switch)" for a Hyper-V virtual switch. An
+  /// empty allowlist allows all interfaces, and the denylist applies after the
+  /// allowlist. This is not supported on UWP.
+  ///
+  /// Note that the UDP candidates of an interface always share a single
+  /// socket, as if |PORTALLOCATOR_ENABLE_SHARED_SOCKET| was set.
+  const char* network_interface_allowlist = nullptr;
+  const char* network_interface_denylist = nullptr;
+
+  /// Identity of the remote peer, or NULL. Connections with the same identity
+  /// use the same DTLS certificate, so that the remote peer sees the same
+  /// fingerprint each time it reconnects, for example to pin it. The
+  /// certificate is kept until the library shuts down or the certificate
+  /// expires. It comes from the pool of |mrsSetCertificatePoolConfig()| if not
+  /// empty, or is otherwise generated while creating the first connection.
+  const char* certificate_identity = nullptr;
+
+  /// Play the content of the audio jitter buffers faster than real time when
+  /// they hold more than their target delay, to recover faster from a burst of
+  /// network jitter. Together with a low |audio_jitter_buffer_max_packets|,
+  /// this is a low-latency profile for interactive applications.
+  mrsBool audio_jitter_buffer_fast_accelerate = mrsBool::kFalse;
+
+  /// Mark the media packets with a DiffServ code point (DSCP), for networks
+  /// with quality of service to prioritize them: audio packets are marked as
+  /// expedited forwarding (EF), and video packets as assured forwarding AF41.
+  /// In this version of WebRTC the marking is per media kind, not per sender,
+  /// and data channels are not marked. On Windows, sockets can only be marked
+  /// as allowed by the QoS policies of the system, so the packets may be sent
+  /// unmarked.
+  mrsBool enable_dscp = mrsBool::kFalse;
+
+  /// Offer the AES-GCM SRTP crypto suites, preferred over the default
+  /// AES-CM with HMAC-SHA1 suites when the remote peer supports them. AES-GCM
+  /// both encrypts and authenticates the packets in a single pass, which is
+  /// much cheaper with the AES instructions of recent CPUs, see
+  /// |mrsPeerConnectionGetTransportCryptoStats()| for the suite negotiated.
+  mrsBool enable_gcm_crypto_suites = mrsBool::kFalse;
+
+  /// Offer the AES-CM with HMAC-SHA1 suite with a 32-bit authentication tag,
+  /// shorter than the default 80-bit one.
+  mrsBool enable_aes128_sha1_32_crypto_cipher = mrsBool::kFalse;
+
+  /// Encrypt the RTP header extensions (RFC 6904) negotiated with a remote
+  /// peer supporting it, instead of sending them in clear text.
+  mrsBool enable_encrypted_rtp_header_extensions = mrsBool::kFalse;
 };
 
 /// Create a peer connection and return a handle to it.
@@ -441,6 +993,12 @@ mrsPeerConnectionCreate(const mrsPeerConnectionConfiguration* config,
 /// Register a callback invoked once connected to a remote peer. To unregister,
 /// simply pass nullptr as the callback pointer. Only one callback can be
 /// registered at a time.
+///
+/// As with all the |mrsPeerConnectionRegisterXxxCallback()| functions, once
+/// this returns the previous callback is never invoked again, unless this is
+/// called from within a callback of the same peer connection. A callback
+/// cannot wait for itself, so the event being dispatched may then still invoke
+/// the previous callback.
 MRS_API void MRS_CALL mrsPeerConnectionRegisterConnectedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionConnectedCallback callback,
@@ -545,6 +1103,46 @@ enum class mrsVideoProfileKind : int32_t {
   kVideoHdr8,
 };
 
+/// Hint about the content of the frames of a video track or video track source,
+/// to tune the encoding for it. See webrtc::VideoTrackInterface::ContentHint.
+enum class mrsVideoContentHint : int32_t {
+  /// No hint; the content is encoded like camera content.
+  kNone = 0,
+  /// Content with motion, like camera video or games. Under constraints, the
+  /// encoder keeps the framerate and reduces the resolution.
+  kMotion = 1,
+  /// Content with fine details, like screen sharing. Under constraints, the
+  /// encoder keeps the resolution and reduces the framerate.
+  kDetail = 2,
+  /// Content with text, like documents. This is encoded like |kDetail|.
+  kText = 3
+};
+
+/// Trade-off between the speed of a video encoder and the quality it achieves
+/// at a given bitrate. See webrtc::VideoCodecComplexity.
+enum class mrsVideoEncoderPreset : int32_t {
+  /// Keep the speed chosen by WebRTC, which is |kRealtimeFast| on desktop.
+  kDefault = 0,
+  /// Fastest encoding suited to real-time, for the devices where encoding
+  /// uses most of the processor time.
+  kRealtimeFast = 1,
+  /// Slower encoding with a better quality.
+  kBalanced = 2,
+  /// Slowest encoding with the best quality, for the devices with processor
+  /// time to spare.
+  kQuality = 3
+};
+
+/// Options of the encoder of a local video track.
+struct mrsVideoEncoderOptions {
+  /// Trade-off between the encoding speed and quality.
+  mrsVideoEncoderPreset preset{mrsVideoEncoderPreset::kDefault};
+
+  /// Maximum number of threads the encoder may use, or zero for as many as
+  /// WebRTC allows for the resolution and the processor count.
+  uint32_t max_threads{0};
+};
+
 enum class mrsTransceiverStateUpdatedReason : int32_t {
   kLocalDesc,
   kRemoteDesc,
@@ -574,6 +1172,46 @@ enum class mrsTransceiverOptDirection : int32_t {
 /// Media kind for tracks and transceivers.
 enum class mrsMediaKind : uint32_t { kAudio = 0, kVideo = 1 };
 
+/// Parameters of an encoding of the media sent by a transceiver. A video sender
+/// with several encodings sends the same source as several simulcast layers,
+/// for example at different resolutions. See webrtc::RtpEncodingParameters.
+struct mrsRtpEncodingParameters {
+  /// Optional RTP stream identifier of the encoding, which tells simulcast
+  /// layers apart. This must be a valid SDP token; see |mrsSdpIsValidToken()|.
+  const char* rid{nullptr};
+
+  /// Factor by which the resolution of the video source is scaled down for
+  /// this encoding, which must be greater than or equal to 1.
+  double scale_resolution_down_by{1.0};
+
+  /// Maximum bitrate of the encoding, in bits per second, or zero for no limit.
+  int max_bitrate_bps{0};
+
+  /// Maximum framerate of the encoding, in frames per second, or zero for no
+  /// limit.
+  int max_framerate{0};
+
+  /// Whether the encoding is sent. Inactive encodings are not encoded.
+  mrsBool active{mrsBool::kTrue};
+
+  /// Priority of the encoding relative to the other encodings of the peer
+  /// connection when sharing the available bandwidth, which must be greater
+  /// than zero. An encoding with twice the priority of another gets twice its
+  /// share of the bandwidth.
+  double bitrate_priority{1.0};
+
+  /// Optional scalability mode of a video encoding, or NULL for the default of
+  /// the codec. The mode is named "L<S>T<T>" after the number of spatial and
+  /// temporal layers of a single SVC encoding, from "L1T1" to "L3T3", which a
+  /// relay can forward a subset of to each viewer, for much less encoding
+  /// work than simulcast. This requires a single encoding, and currently only
+  /// applies to VP9: other codecs send a single layer. In this version of
+  /// WebRTC, VP9 layers are configured for the whole process with
+  /// |mrsSetVp9ScalabilityMode()|, so an encoding with a different mode is
+  /// rejected with |mrsResult::kInvalidParameter|.
+  const char* scalability_mode{nullptr};
+};
+
 /// Configuration for creating a new transceiver.
 struct mrsTransceiverInitConfig {
   /// Optional name of the transceiver. This must be a valid SDP token; see
@@ -593,6 +1231,15 @@ struct mrsTransceiverInitConfig {
 
   /// Optional user data.
   void* user_data{nullptr};
+
+  /// Optional array of |send_encodings_count| encodings of the media sent, or
+  /// null for a single encoding with default parameters. Several encodings
+  /// enable simulcast, encoding a single video source once per layer instead
+  /// of once per peer connection. This requires Unified Plan.
+  const mrsRtpEncodingParameters* send_encodings{nullptr};
+
+  /// Number of elements of |send_encodings|.
+  int send_encodings_count{0};
 };
 
 using mrsRequestExternalI420AVideoFrameCallback =
@@ -643,10 +1290,45 @@ struct mrsRemoteVideoTrackConfig {
   const char* track_name{};
 };
 
+/// Priority of a data channel over the other channels of its connection, as
+/// in the WebRTC priority types.
+enum class mrsDataChannelPriority : int32_t {
+  kVeryLow = 0,
+  kLow = 1,
+  kMedium = 2,
+  kHigh = 3,
+};
+
 struct mrsDataChannelConfig {
   int32_t id = -1;  // -1 for auto; >=0 for negotiated
   mrsDataChannelConfigFlags flags{};
   const char* label{};  // optional; can be null or empty string
+
+  /// Partially reliable channels stop retransmitting a message after this
+  /// many retransmissions, or -1 for no limit.
+  int32_t max_retransmits{-1};
+
+  /// Partially reliable channels stop retransmitting a message after this
+  /// many milliseconds since it was first sent, or -1 for no limit. For
+  /// example, updates of a head pose would rather be dropped than delivered
+  /// late and delay the more recent ones.
+  ///
+  /// At most one of |max_retransmits| and |max_packet_lifetime_ms| can be set,
+  /// and only if |flags| does not include |kReliable|. Both are limited to
+  /// 65534.
+  int32_t max_packet_lifetime_ms{-1};
+
+  /// Priority of the messages of the channel sent from its send queue, see
+  /// |mrsDataChannelSetSendQueue()|. All channels of a connection share a
+  /// single SCTP association, whose send buffer is a single queue for all of
+  /// them. A channel holds the messages of its send queue back while a channel
+  /// of a higher priority has data queued or buffered by the transport, so
+  /// that a bulk transfer does not delay the urgent messages sent on another
+  /// channel by more than the data it already handed to the transport, which
+  /// a low high watermark bounds. Messages sent without the send queue are
+  /// handed to the transport immediately whatever the priority. The priority
+  /// is local to this peer, and is not negotiated.
+  mrsDataChannelPriority priority{mrsDataChannelPriority::kLow};
 };
 
 /// Add a new data channel to a peer connection.
@@ -669,6 +1351,51 @@ MRS_API mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
     const mrsDataChannelConfig* config,
     mrsDataChannelHandle* data_channel_handle_out) noexcept;
 
+/// Add |count| new data channels to a peer connection at once, as if by
+/// calling |mrsPeerConnectionAddDataChannel()| for each element of |configs|,
+/// but in a single dispatch to the signaling thread. All configurations are
+/// validated before any channel is created. The function returns the handles
+/// of the channels in |data_channel_handles_out|, which must have room for
+/// |count| handles. On error all handles are null, but the channels created
+/// before the error are kept and reported by the DataChannelAdded callback.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddDataChannels(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelConfig* configs,
+    uint32_t count,
+    mrsDataChannelHandle* data_channel_handles_out) noexcept;
+
+/// Callback fired once a batch of data channels added with
+/// |mrsPeerConnectionAddDataChannelsAsync()| is created, with the handles of
+/// the channels created, in the order of their configurations.
+using mrsPeerConnectionDataChannelsAddedCallback =
+    void(MRS_CALL*)(void* user_data,
+                    mrsResult result,
+                    const mrsDataChannelHandle* data_channel_handles,
+                    uint32_t count);
+
+/// Same as |mrsPeerConnectionAddDataChannels()|, but without waiting for the
+/// signaling thread. The configurations are validated and copied before the
+/// function returns, and the channels are created later on the signaling
+/// thread, after which |callback| is invoked on that thread. Each channel
+/// fires the DataChannelAdded callback before |callback| is invoked.
+///
+/// If the peer connection is closed before the channels are created, the
+/// callback is invoked with |mrsResult::kPeerConnectionClosed| and no handle.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddDataChannelsAsync(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelConfig* configs,
+    uint32_t count,
+    mrsPeerConnectionDataChannelsAddedCallback callback,
+    void* user_data) noexcept;
+
+/// Get the data channel of a peer connection with the given ID, for example
+/// one created with |mrsPeerConnectionConfiguration::data_channels|. Data
+/// channels opened locally without a pre-negotiated ID are not found.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionGetDataChannelById(
+    mrsPeerConnectionHandle peer_handle,
+    int32_t id,
+    mrsDataChannelHandle* data_channel_handle_out) noexcept;
+
 /// Remove an existing data channel from a peer connection and destroy it. If
 /// the channel was an in-band data channel, then the change triggers a
 /// renegotiation needed event.
@@ -683,6 +1410,17 @@ MRS_API mrsResult MRS_CALL
 mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
                                  const mrsIceCandidate* candidate) noexcept;
 
+/// Add several ICE candidates received from a signaling service at once, for
+/// example a batch delivered to the batch callback of the remote peer. This is
+/// equivalent to calling |mrsPeerConnectionAddIceCandidate| for each candidate
+/// in order, but dispatches to the WebRTC signaling thread only once. This
+/// stops at the first candidate which cannot be added and returns its error;
+/// the candidates before it remain added.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionAddIceCandidates(mrsPeerConnectionHandle peer_handle,
+                                  const mrsIceCandidate* candidates,
+                                  int count) noexcept;
+
 /// Create a new JSEP offer to try to establish a connection with a remote peer.
 /// This will generate a local offer message, then invoke the
 /// |LocalSdpReadytoSendCallback| callback, which should send to the remote peer
@@ -755,6 +1493,18 @@ MRS_API mrsResult MRS_CALL mrsPeerConnectionSetRemoteDescriptionAsync(
 MRS_API mrsResult MRS_CALL
 mrsPeerConnectionClose(mrsPeerConnectionHandle peer_handle) noexcept;
 
+/// Close several peer connections at once, like |mrsPeerConnectionClose()|.
+/// The connections of different thread groups, as configured with
+/// |mrsSetThreadGroups()|, are closed concurrently. This waits at most
+/// |timeout_ms| milliseconds for all connections to close, or indefinitely if
+/// negative. If some connections are still closing by then, this returns
+/// |mrsResult::kTimeout| and reports the live objects to the log, and those
+/// connections finish closing in the background.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionCloseMany(const mrsPeerConnectionHandle* peer_handles,
+                           uint32_t count,
+                           int timeout_ms) noexcept;
+
 //
 // SDP utilities
 //
@@ -816,6 +1566,43 @@ MRS_API mrsResult MRS_CALL mrsSdpForceCodecs(const char* message,
                                              char* buffer,
                                              uint64_t* buffer_size) noexcept;
 
+/// Encode an SDP message into a compact form to send to the remote peer through
+/// the signaling service, to be decoded with |mrsSdpDecodeCompact()|. Runs of
+/// codec and header extension attributes repeated across media sections are
+/// only sent once. If |base| is not NULL nor empty, the compact form only holds
+/// the differences with that message, which the remote peer must pass to
+/// decode it. This is typically the previous message exchanged, as the
+/// messages of a renegotiation only differ from it by a few lines.
+///
+/// |message| SDP message to encode.
+/// |base| Optional SDP message to encode the differences with, or NULL.
+/// |buffer| Output buffer of capacity *|buffer_size|.
+/// |buffer_size| Pointer to the buffer capacity on input, modified on output
+/// with the size of the null-terminated compact form, including the null
+/// terminator. Returns |mrsResult::kBufferTooSmall| if the buffer is not large
+/// enough, in which case the call can be retried with that size.
+MRS_API mrsResult MRS_CALL mrsSdpEncodeCompact(const char* message,
+                                               const char* base,
+                                               char* buffer,
+                                               uint64_t* buffer_size) noexcept;
+
+/// Decode the compact form of an SDP message produced by
+/// |mrsSdpEncodeCompact()|, into the SDP message to pass to
+/// |mrsPeerConnectionSetRemoteDescriptionAsync()|.
+///
+/// |compact| Compact form to decode.
+/// |base| The message the compact form was encoded against, or NULL if none.
+/// |buffer| Output buffer of capacity *|buffer_size|.
+/// |buffer_size| Pointer to the buffer capacity on input, modified on output
+/// with the size of the null-terminated SDP message, including the null
+/// terminator. Returns |mrsResult::kBufferTooSmall| if the buffer is not large
+/// enough, and |mrsResult::kInvalidParameter| if the compact form is invalid or
+/// was encoded against another base message.
+MRS_API mrsResult MRS_CALL mrsSdpDecodeCompact(const char* compact,
+                                               const char* base,
+                                               char* buffer,
+                                               uint64_t* buffer_size) noexcept;
+
 /// Must be the same as PeerConnection::FrameHeightRoundMode.
 enum class FrameHeightRoundMode : int32_t { kNone = 0, kCrop = 1, kPad = 2 };
 
@@ -823,9 +1610,27 @@ enum class FrameHeightRoundMode : int32_t { kNone = 0, kCrop = 1, kPad = 2 };
 /// See https://tools.ietf.org/html/rfc4566#page-43 for details.
 MRS_API mrsBool MRS_CALL mrsSdpIsValidToken(const char* token) noexcept;
 
-/// See PeerConnection::SetFrameHeightRoundMode.
+/// See PeerConnection::SetFrameHeightRoundMode. This only affects the H.264
+/// encoder of HoloLens 1; prefer the frame height round mode of the local video
+/// tracks, which works with any encoder. See
+/// |mrsLocalVideoTrackInitSettings::frame_height_round_mode|.
 MRS_API void MRS_CALL mrsSetFrameHeightRoundMode(FrameHeightRoundMode value);
 
+/// Set the minimum number of pixels of a video frame above which color
+/// conversions between I420 and ARGB32 are split into bands of rows converted
+/// in parallel on a small shared worker pool. A value of zero disables parallel
+/// conversion. The default corresponds to a 1440p frame (2560 x 1440 pixels).
+MRS_API void MRS_CALL
+mrsSetParallelConversionThreshold(uint64_t pixel_count) noexcept;
+
+/// Set the minimum number of remote audio tracks not output to the audio
+/// device, but read through callbacks or buffers, above which the audio mixer
+/// pumps those tracks in parallel on the same worker pool, instead of one
+/// after the other on the audio device thread. A value of zero, the default,
+/// disables parallel pumping.
+MRS_API void MRS_CALL
+mrsSetParallelAudioPumpThreshold(int32_t source_count) noexcept;
+
 //
 // Generic utilities
 //
@@ -845,6 +1650,64 @@ MRS_API void MRS_CALL mrsMemCpyStride(void* dst,
                                       int32_t elem_size,
                                       int32_t elem_count) noexcept;
 
+/// Flags for |mrsCopyI420AFrame()| and |mrsCopyArgb32Frame()|.
+enum class mrsFrameCopyFlags : uint32_t {
+  kNone = 0,
+
+  /// Write the rows of the frame bottom-up, for textures whose origin is the
+  /// bottom-left corner.
+  kFlipVertically = 0x1,
+
+  /// Write the destination with non-temporal stores, bypassing the CPU cache.
+  /// This is much faster when the destination is write-combined memory, like a
+  /// mapped GPU upload heap, and for large frames not read back by the CPU.
+  /// This has no effect on CPUs without non-temporal stores.
+  kStreamingStores = 0x2,
+};
+
+inline mrsFrameCopyFlags operator|(mrsFrameCopyFlags a,
+                                   mrsFrameCopyFlags b) noexcept {
+  return (mrsFrameCopyFlags)((uint32_t)a | (uint32_t)b);
+}
+
+inline uint32_t operator&(mrsFrameCopyFlags a, mrsFrameCopyFlags b) noexcept {
+  return ((uint32_t)a & (uint32_t)b);
+}
+
+/// Destination planes of |mrsCopyI420AFrame()|, with the same layout as the
+/// planes of |mrsI420AVideoFrame|.
+struct mrsI420AFrameLayout {
+  void* ydata{nullptr};
+  void* udata{nullptr};
+  void* vdata{nullptr};
+
+  /// Alpha plane, or NULL to skip it. If the source frame has no alpha plane,
+  /// this plane is filled with opaque values.
+  void* adata{nullptr};
+
+  int32_t ystride{0};
+  int32_t ustride{0};
+  int32_t vstride{0};
+  int32_t astride{0};
+};
+
+/// Copy all the planes of an I420A frame, for example as received by a frame
+/// callback, to the destination planes |dst| in a single call. Frames larger
+/// than the parallel conversion threshold, see
+/// |mrsSetParallelConversionThreshold()|, are copied in row bands on several
+/// threads. This returns |mrsResult::kInvalidParameter| if a plane is missing,
+/// or a destination stride is smaller than the row size of its plane.
+MRS_API mrsResult MRS_CALL mrsCopyI420AFrame(const mrsI420AVideoFrame* frame,
+                                             const mrsI420AFrameLayout* dst,
+                                             mrsFrameCopyFlags flags) noexcept;
+
+/// Copy an ARGB32 frame to |dst|, whose rows are |dst_stride| bytes apart,
+/// like |mrsCopyI420AFrame()|.
+MRS_API mrsResult MRS_CALL mrsCopyArgb32Frame(const mrsArgb32VideoFrame* frame,
+                                              void* dst,
+                                              int32_t dst_stride,
+                                              mrsFrameCopyFlags flags) noexcept;
+
 //
 // Stats extraction.
 //
@@ -873,6 +1736,9 @@ struct mrsAudioSenderStats {
   int64_t rtp_stats_timestamp_us;
   uint32_t packets_sent;
   uint64_t bytes_sent;
+
+  /// Number of NACK messages received from the remote peer.
+  uint32_t nack_count;
 };
 
 /// Subset of RTCMediaStreamTrack (audio receiver) and RTCInboundRTPStreamStats.
@@ -889,6 +1755,15 @@ struct mrsAudioReceiverStats {
   int64_t rtp_stats_timestamp_us;
   uint32_t packets_received;
   uint64_t bytes_received;
+
+  /// Number of packets lost, which is negative if duplicates were received.
+  int32_t packets_lost;
+  /// Packet jitter, in seconds.
+  double jitter;
+  /// Number of NACK messages sent to the remote peer.
+  uint32_t nack_count;
+  /// Sum of the time the samples spent in the jitter buffer, in seconds.
+  double jitter_buffer_delay;
 };
 
 /// Subset of RTCMediaStreamTrack (video sender) and RTCOutboundRTPStreamStats.
@@ -904,6 +1779,13 @@ struct mrsVideoSenderStats {
   uint32_t packets_sent;
   uint64_t bytes_sent;
   uint32_t frames_encoded;
+
+  /// Number of NACK, PLI and FIR messages received from the remote peer.
+  uint32_t nack_count;
+  uint32_t pli_count;
+  uint32_t fir_count;
+  /// Sum of the quantization parameters of the frames encoded.
+  uint64_t qp_sum;
 };
 
 /// Subset of RTCMediaStreamTrack (video receiver) + RTCInboundRTPStreamStats.
@@ -919,14 +1801,148 @@ struct mrsVideoReceiverStats {
   uint32_t packets_received;
   uint64_t bytes_received;
   uint32_t frames_decoded;
+
+  /// Number of packets lost, which is negative if duplicates were received.
+  int32_t packets_lost;
+  /// Packet jitter, in seconds.
+  double jitter;
+  /// Number of NACK, PLI and FIR messages sent to the remote peer.
+  uint32_t nack_count;
+  uint32_t pli_count;
+  uint32_t fir_count;
+  /// Sum of the quantization parameters of the frames decoded.
+  uint64_t qp_sum;
+  /// Sum of the time the frames spent in the jitter buffer, in seconds.
+  double jitter_buffer_delay;
 };
 
-/// Subset of RTCTransportStats. See
-/// https://www.w3.org/TR/webrtc-stats/#transportstats-dict*
+/// Subset of RTCTransportStats and of the RTCIceCandidatePairStats of its
+/// selected candidate pair. See
+/// https://www.w3.org/TR/webrtc-stats/#transportstats-dict* and
+/// https://www.w3.org/TR/webrtc-stats/#candidatepair-dict*
 struct mrsTransportStats {
   int64_t timestamp_us;
   uint64_t bytes_sent;
   uint64_t bytes_received;
+
+  /// Latest round trip time measured with STUN requests, in seconds, or zero
+  /// if there is no selected candidate pair yet.
+  double current_round_trip_time;
+  /// Bandwidth estimate of the sending side, in bits per second, or zero if
+  /// not known.
+  double available_outgoing_bitrate;
+};
+
+/// Percentiles of the latency between the capture of the frames of a video
+/// track and their delivery to the frame callbacks, in milliseconds, with a
+/// 1 millisecond resolution.
+struct mrsVideoFrameLatencyStats {
+  uint64_t sample_count;
+  double p50_ms;
+  double p95_ms;
+  double p99_ms;
+  double max_ms;
+};
+
+/// Frames of a video track dropped by the frame delivery before reaching the
+/// frame callbacks, not counting the frames skipped by the framerate limit of
+/// the delivery options.
+struct mrsVideoFrameDeliveryStats {
+  /// Number of frames replaced by a newer frame before the delivery thread
+  /// picked them up, when asynchronous delivery is enabled.
+  uint64_t async_replaced_count;
+
+  /// Number of frames dropped because they arrived while another frame was
+  /// being delivered, either while switching between synchronous and
+  /// asynchronous delivery, or when the source produces frames from several
+  /// threads at once.
+  uint64_t overlap_dropped_count;
+};
+
+/// Statistics of the latency markers decoded from the frames of a remote video
+/// track, stamped by the sender with
+/// |mrsExternalVideoTrackSourceSetLatencyMarkers()|.
+struct mrsVideoLatencyMarkerStats {
+  /// Number of frames with a valid latency marker.
+  uint64_t decoded_count;
+
+  /// Number of frames missing from the sequence of frame numbers of the
+  /// markers, dropped anywhere between the sender and the receiver.
+  uint64_t missing_count;
+
+  /// End-to-end latency of the frames with a valid marker, from their capture
+  /// on the sender to their delivery to the frame callbacks of the receiver.
+  mrsVideoFrameLatencyStats latency;
+};
+
+/// Layers of the video received on a remote video track, over the last few
+/// dozen frames. Those are the layers of a scalable encoding forwarded to this
+/// receiver, see |mrsRtpEncodingParameters::scalability_mode|.
+struct mrsVideoLayerStats {
+  /// Number of spatial layers received, or 1 if the stream is not spatially
+  /// scalable.
+  uint32_t spatial_layer_count;
+
+  /// Number of temporal layers received, or 1 if the stream is not temporally
+  /// scalable.
+  uint32_t temporal_layer_count;
+};
+
+/// Timing of the arrival of the frames of a remote video track, to tell
+/// stalls of the received stream from delays of the application. A gap
+/// between two frames longer than both 3 times the average gap and the average
+/// gap plus 150 ms is a freeze, and a gap longer than 5 seconds is a pause, as
+/// in the standard statistics of the receive streams.
+struct mrsVideoFrameTimingStats {
+  /// Number of frames received.
+  uint64_t frame_count;
+
+  /// Frames received during the last complete second, and average per second
+  /// over the last 10 complete seconds.
+  double framerate_1s;
+  double framerate_10s;
+
+  /// Percentiles of the time between two consecutive frames.
+  mrsVideoFrameLatencyStats inter_arrival;
+
+  /// Number of freezes, and their total duration in milliseconds.
+  uint64_t freeze_count;
+  double total_freeze_duration_ms;
+
+  /// Number of pauses, and their total duration in milliseconds.
+  uint64_t pause_count;
+  double total_pause_duration_ms;
+
+  /// Time since the last frame was received, in milliseconds, or a negative
+  /// value if no frame was received.
+  double ms_since_last_frame;
+};
+
+/// Encoded video frame received on a remote video track before decoding, or
+/// submitted to an external encoded video track source. Submitted frames
+/// ignore the RTP and NTP timestamps.
+struct mrsEncodedVideoFrame {
+  /// SDP name of the codec of the frame, e.g. "VP8" or "H264".
+  const char* codec_name;
+
+  /// RTP timestamp of the frame, in 90 kHz units.
+  uint32_t rtp_timestamp;
+
+  /// Capture time of the frame on the remote peer, in milliseconds since the
+  /// NTP epoch, or a negative value if not known yet.
+  int64_t ntp_time_ms;
+
+  /// Frame resolution in pixels. This is only known for key frames, and is
+  /// zero otherwise.
+  uint32_t width;
+  uint32_t height;
+
+  /// Key frames can be decoded without any previous frame.
+  mrsBool is_keyframe;
+
+  /// Encoded payload, valid only during the call it is passed to.
+  const void* data;
+  uint32_t size;
 };
 
 /// Handle to a WebRTC stats report.
@@ -963,4 +1979,215 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
 MRS_API mrsResult MRS_CALL
 mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report);
 
+/// Kind of object described by a |mrsStatsEntry|.
+enum class mrsStatsEntryKind : int32_t {
+  kDataChannel = 0,
+  kAudioSender = 1,
+  kAudioReceiver = 2,
+  kVideoSender = 3,
+  kVideoReceiver = 4,
+  kTransport = 5,
+};
+
+/// Stats of a single object of a peer connection, with the stats of its RTP
+/// stream and of its track already joined for senders and receivers.
+struct mrsStatsEntry {
+  mrsStatsEntryKind kind;
+  union {
+    mrsDataChannelStats data_channel;
+    mrsAudioSenderStats audio_sender;
+    mrsAudioReceiverStats audio_receiver;
+    mrsVideoSenderStats video_sender;
+    mrsVideoReceiverStats video_receiver;
+    mrsTransportStats transport;
+  };
+};
+
+/// Flags of a stats subscription.
+enum class mrsStatsSubscriptionFlags : uint32_t {
+  kNone = 0,
+
+  /// Only deliver the entries whose values changed since the previous
+  /// snapshot, ignoring timestamps. Snapshots where nothing changed are not
+  /// delivered at all.
+  kChangedOnly = 0x1,
+};
+
+/// Configuration of a stats subscription.
+struct mrsStatsSubscriptionConfig {
+  /// Interval between two snapshots, in milliseconds.
+  int interval_ms{1000};
+
+  mrsStatsSubscriptionFlags flags{mrsStatsSubscriptionFlags::kNone};
+};
+
+/// Callback delivering a stats snapshot of a peer connection. The entries and
+/// the strings they point to are only valid during the callback.
+using mrsStatsSnapshotCallback = void(MRS_CALL*)(void* user_data,
+                                                 const mrsStatsEntry* entries,
+                                                 uint32_t entry_count);
+
+/// Subscribe to periodic stats snapshots of a peer connection, collected on the
+/// signaling thread at the configured interval and delivered as a flat array
+/// of entries, one per data channel, RTP stream with its track, and transport.
+/// This is cheaper than walking a report with |mrsStatsReportGetObjects()|,
+/// and reuses the same entry array for all snapshots. Each peer connection has
+/// at most one subscription, which this replaces. Pass a NULL callback to
+/// unsubscribe; once this returns, the previous callback is not invoked
+/// anymore.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionSubscribeStats(mrsPeerConnectionHandle peer_handle,
+                                const mrsStatsSubscriptionConfig* config,
+                                mrsStatsSnapshotCallback callback,
+                                void* user_data) noexcept;
+
+/// Estimate of the bandwidth available to send to the remote peer, and of the
+/// congestion of the connection.
+struct mrsBandwidthEstimate {
+  int64_t timestamp_us;
+
+  /// Target bitrate of the send-side congestion controller, shared by all the
+  /// media streams sent, in bits per second. This is the available outgoing
+  /// bitrate of the selected candidate pair.
+  double target_bitrate;
+
+  /// Bitrate actually sent on the transports since the previous estimate,
+  /// including data channels, in bits per second.
+  double send_bitrate;
+
+  /// Latest round trip time of the selected candidate pair, in seconds.
+  double round_trip_time;
+
+  /// Fraction of the RTP packets lost since the previous estimate, in the
+  /// [0:1] range. This is measured on the streams received from the remote
+  /// peer, as the loss of the streams sent is not reported locally.
+  double loss_fraction;
+};
+
+/// Configuration of a bandwidth estimate subscription.
+struct mrsBandwidthEstimateConfig {
+  /// Interval between two checks of the estimate, in milliseconds.
+  int interval_ms{500};
+
+  /// Minimum change since the last estimate delivered for a new one to be
+  /// delivered, in percent of the bitrates and round trip time, and in
+  /// percentage points of the loss fraction. Zero delivers all estimates.
+  double change_threshold_percent{10.0};
+};
+
+/// Callback delivering a bandwidth estimate of a peer connection.
+using mrsBandwidthEstimateCallback =
+    void(MRS_CALL*)(void* user_data, const mrsBandwidthEstimate* estimate);
+
+/// Subscribe to the bandwidth estimates of a peer connection, checked on the
+/// signaling thread at the configured interval and delivered when they
+/// changed by more than the configured threshold, to let the application
+/// adapt the data it sends before the media streams suffer from congestion.
+/// The first estimate is delivered once connected. Each peer connection has at
+/// most one bandwidth estimate subscription, which this replaces. Pass a NULL
+/// callback to unsubscribe; once this returns, the previous callback is not
+/// invoked anymore.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionSubscribeBandwidthEstimate(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsBandwidthEstimateConfig* config,
+    mrsBandwidthEstimateCallback callback,
+    void* user_data) noexcept;
+
+/// Configuration of a network probe.
+struct mrsNetworkProbeConfig {
+  /// Duration of the probe, in milliseconds.
+  int duration_ms{2000};
+
+  /// Open data channel of the peer connection to send padding on during the
+  /// probe, or NULL to only measure the traffic already flowing. The remote
+  /// data channel drops the padding, which is not counted in its counters.
+  mrsDataChannelHandle data_channel{nullptr};
+
+  /// Maximum bitrate of the padding, in bits per second.
+  int max_padding_bitrate_bps{10000000};
+};
+
+/// Conditions of the network measured by a probe.
+struct mrsNetworkProbeResult {
+  /// |mrsResult::kSuccess| once the probe completed, or the error which
+  /// stopped it, like |mrsResult::kPeerConnectionClosed|.
+  mrsResult result;
+
+  /// Highest target bitrate of the send-side congestion controller during the
+  /// probe, in bits per second. See |mrsBandwidthEstimate::target_bitrate|.
+  double estimated_bitrate;
+
+  /// Bitrate sent on the transports during the probe, including the padding,
+  /// in bits per second.
+  double measured_bitrate;
+
+  /// Lowest and average round trip times of the selected candidate pair during
+  /// the probe, in seconds.
+  double min_round_trip_time;
+  double round_trip_time;
+
+  /// Fraction of the RTP packets received from the remote peer which were lost
+  /// during the probe, or if none was received, fraction of the ICE
+  /// connectivity checks not answered, in the [0:1] range.
+  double loss_fraction;
+
+  /// Start bitrate suggested for |mrsPeerConnectionSetBitrate()|, in bits per
+  /// second, with some headroom below the measured bitrate if padding was
+  /// sent, or else below the estimated bitrate.
+  int suggested_start_bitrate_bps;
+};
+
+/// Callback delivering the result of a network probe.
+using mrsNetworkProbeCallback =
+    void(MRS_CALL*)(void* user_data, const mrsNetworkProbeResult* result);
+
+/// Probe the network conditions of a connected peer connection, typically
+/// before the media starts, to pick the start bitrate and resolution from
+/// measured conditions rather than let the congestion controller ramp up from
+/// a guess. During the configured duration, the probe samples the stats of the
+/// connection on the signaling thread, and sends padding on the data channel
+/// of the configuration if any, then delivers its result to the callback.
+///
+/// This version of WebRTC only sends RTP padding along with a video stream, so
+/// without one the bandwidth is measured with the data channel padding, which
+/// the SCTP congestion control paces, and the estimate of the congestion
+/// controller remains at its start value. Each peer connection runs at most
+/// one probe at a time. Return |mrsResult::kInvalidOperation| if not connected
+/// or if a probe is already running, and |mrsResult::kNotFound| if the data
+/// channel does not belong to the peer connection.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionProbeNetwork(mrsPeerConnectionHandle peer_handle,
+                              const mrsNetworkProbeConfig* config,
+                              mrsNetworkProbeCallback callback,
+                              void* user_data) noexcept;
+
+/// Crypto suites negotiated on the transport of a peer connection. The names
+/// are the IANA names of the suites, or empty if not negotiated yet, for
+/// example "AEAD_AES_128_GCM" or "AES_CM_128_HMAC_SHA1_80" for SRTP, and
+/// "TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256" for DTLS. The strings are only
+/// valid during the call to the callback.
+struct mrsTransportCryptoStats {
+  /// Crypto suite protecting the RTP and RTCP packets. This is empty for a
+  /// connection with only data channels, which do not use SRTP.
+  const char* srtp_cipher;
+
+  /// Cipher suite of the DTLS connection, which protects the data channels
+  /// and negotiates the SRTP keys.
+  const char* dtls_cipher;
+};
+
+/// Callback delivering the crypto suites of the transport of a connection.
+using mrsTransportCryptoStatsCallback =
+    void(MRS_CALL*)(void* user_data, const mrsTransportCryptoStats* stats);
+
+/// Get the crypto suites negotiated on the transport of the RTP streams of the
+/// connection, or of its data channels if there is no RTP transport. The
+/// standard transport stats of this version of WebRTC do not report them, so
+/// they are collected from the legacy stats, asynchronously on the signaling
+/// thread.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionGetTransportCryptoStats(
+    mrsPeerConnectionHandle peer_handle,
+    mrsTransportCryptoStatsCallback callback,
+    void* user_data) noexcept;
+
 }  // extern "C"
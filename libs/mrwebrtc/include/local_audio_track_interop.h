@@ -24,12 +24,41 @@ MRS_API mrsResult MRS_CALL mrsLocalAudioTrackCreateFromSource(
     mrsLocalAudioTrackHandle* track_handle_out) noexcept;
 
 /// Register a custom callback to be called when the local audio track captured
-/// a frame.
+/// a frame. Once this returns, the previous callback is never invoked again,
+/// unless this is called from within that callback, which cannot wait for
+/// itself.
 MRS_API void MRS_CALL
 mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
                                         mrsAudioFrameCallback callback,
                                         void* user_data) noexcept;
 
+/// Deliver the frames of the local audio track to the frame callback in
+/// batches of |period_ms| milliseconds, instead of one callback every 10 ms.
+/// Each batch is a single frame of the aggregated samples, with the timestamp
+/// of the first one. Zero, the default, disables aggregation. The period
+/// should be a multiple of 10 ms, and cannot exceed 1000 ms.
+MRS_API mrsResult MRS_CALL mrsLocalAudioTrackSetFrameAggregationPeriod(
+    mrsLocalAudioTrackHandle track_handle,
+    int32_t period_ms) noexcept;
+
+/// Get the audio level of the local audio track, measured natively over the
+/// last frame received. This is cheap enough to be polled every frame, and
+/// avoids registering a frame callback only to meter the audio.
+MRS_API mrsResult MRS_CALL
+mrsLocalAudioTrackGetAudioLevel(mrsLocalAudioTrackHandle track_handle,
+                                mrsAudioLevel* level_out) noexcept;
+
+/// Register a callback invoked when the audio level of the local audio track
+/// changes, that is when its RMS level moved by at least |threshold| since the
+/// last invocation, or when its voice activity changes. A zero threshold
+/// invokes the callback on each frame. The callback is invoked once with the
+/// next frame after registering it. Pass a NULL callback to unregister.
+MRS_API mrsResult MRS_CALL mrsLocalAudioTrackRegisterAudioLevelCallback(
+    mrsLocalAudioTrackHandle track_handle,
+    float threshold,
+    mrsAudioLevelCallback callback,
+    void* user_data) noexcept;
+
 /// Enable or disable a local audio track. Enabled tracks output their media
 /// content as usual. Disabled track output some void media content (silent
 /// audio frames). Enabling/disabling a track is a lightweight concept similar
@@ -12,6 +12,15 @@ struct mrsLocalVideoTrackInitSettings {
   /// Track name. This must be a valid SDP token (see |mrsSdpTokenIsValid()|),
   /// or |nullptr| to let the implementation generate a valid unique track name.
   const char* track_name{};
+
+  /// Rounding of the height of the frames sent to a multiple of 16 pixels, for
+  /// the hardware encoders which corrupt or copy frames of other heights. This
+  /// works with any encoder factory. Cropping only offsets the planes of the
+  /// frames, without copying them, while padding copies them into pooled
+  /// buffers, replicating their edge rows, and drops their alpha plane. Frames
+  /// in native buffers are sent unchanged. The frame callbacks of the track
+  /// receive the rounded frames.
+  FrameHeightRoundMode frame_height_round_mode{FrameHeightRoundMode::kNone};
 };
 
 /// Create a new local video track from a video track source.
@@ -23,6 +32,13 @@ MRS_API mrsResult MRS_CALL mrsLocalVideoTrackCreateFromSource(
 /// Register a custom callback to be called when the local video track captured
 /// a frame. The captured frames is passed to the registered callback in I420
 /// encoding.
+///
+/// Registering another callback, or nullptr to unregister, waits for the frame
+/// delivery in progress, so that once this returns the previous callback is
+/// never invoked again. The exception is a call from within a frame callback
+/// of the same track, which cannot wait for itself; the frame being
+/// delivered may then still invoke the previous callback. This applies to all
+/// the frame callback registration functions below.
 MRS_API void MRS_CALL mrsLocalVideoTrackRegisterI420AFrameCallback(
     mrsLocalVideoTrackHandle trackHandle,
     mrsI420AVideoFrameCallback callback,
@@ -36,6 +52,149 @@ MRS_API void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameCallback(
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept;
 
+/// Register a custom callback to be called when the local video track captured
+/// a frame. The captured frame is passed to the registered callback in NV12
+/// encoding.
+MRS_API void MRS_CALL mrsLocalVideoTrackRegisterNv12FrameCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the local video track captured
+/// a frame. The captured frame is passed to the registered callback as a lease
+/// over the original frame buffer, without any copy or conversion. The callee
+/// must release the lease with |mrsVideoFrameBufferRemoveRef()|.
+MRS_API void MRS_CALL mrsLocalVideoTrackRegisterFrameLeaseCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the local video track captured
+/// a frame. The captured frame is passed to the registered callback in ARGB32
+/// encoding, inside a pooled buffer the callee can check out. See
+/// |mrsArgb32VideoFrameLeaseCallback| for details.
+MRS_API void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameLeaseCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Set the number of pooled ARGB32 buffers used to deliver frames to the ARGB32
+/// callbacks, which is the maximum number of frames checked out at once. The
+/// default is a single buffer.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetArgb32BufferPoolSize(mrsLocalVideoTrackHandle trackHandle,
+                                          int pool_size) noexcept;
+
+/// Set the options for the delivery of frames to the I420A, ARGB32 and NV12
+/// callbacks, to downscale frames to a maximum size and skip frames above a
+/// maximum framerate. Frame lease callbacks are not affected.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackSetFrameDeliveryOptions(
+    mrsLocalVideoTrackHandle trackHandle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept;
+
+/// Add a subscriber receiving video frames as I420A-encoded, ARGB32-encoded or
+/// NV12-encoded buffers, in addition to any registered frame callback. Each
+/// frame is converted at most once per format, and all subscribers of a format
+/// share the same read-only frame data. On success, the new subscriber
+/// identifier is returned in |subscriber_id_out|, to later remove the
+/// subscriber with |mrsLocalVideoTrackRemoveFrameSubscriber()|.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackAddI420AFrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackAddArgb32FrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackAddNv12FrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+
+/// Remove a frame subscriber previously added. Once this returns, the
+/// subscriber is never invoked again.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackRemoveFrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    uint64_t subscriber_id) noexcept;
+
+/// Get the percentiles of the latency between the capture of the frames of the
+/// track and their delivery to the frame callbacks. This only accounts for
+/// frames delivered to at least one callback. For a remote track, the capture
+/// time of the frames is only known once the remote peer sent an RTCP sender
+/// report, and requires both peers to have synchronized NTP clocks.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackGetLatencyStats(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameLatencyStats* stats_out) noexcept;
+
+/// Discard the latency samples recorded so far for the track.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackResetLatencyStats(
+    mrsLocalVideoTrackHandle trackHandle) noexcept;
+
+/// Force the encoder of a local video track to produce a key frame for the next
+/// frame of the track, instead of waiting for the next periodic one, for
+/// example when a new viewer joins mid-stream. Other local tracks sharing the
+/// same video track source may produce a key frame too. This is not supported
+/// on UWP.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackRequestKeyFrame(
+    mrsLocalVideoTrackHandle trackHandle) noexcept;
+
+/// Set the hint about the content of a local video track, which overrides the
+/// hint of its source, if any. This applies immediately to the encoder of the
+/// track, if sent. For a track attached to a transceiver, this also sets the
+/// degradation preference of the sender to keep the framerate for motion, and
+/// the resolution for details and text, unless the application set it with
+/// |mrsTransceiverSetDegradationPreference()|.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetContentHint(mrsLocalVideoTrackHandle trackHandle,
+                                 mrsVideoContentHint content_hint) noexcept;
+
+/// Request the receivers of a local video track to play its frames out with a
+/// delay between |min_delay_ms| and |max_delay_ms| milliseconds after capture,
+/// through the playout delay RTP header extension. The video jitter buffer of
+/// the receivers does not delay frames less than the minimum, even when the
+/// network allows it, and does not delay them more than the maximum, at the
+/// expense of more frames rendered late or dropped. A range of 0 to 0 renders
+/// frames as soon as they are decoded, for the lowest latency, for example for
+/// remote rendering and cloud gaming. Values have a 10 ms granularity, up
+/// to 40950 ms. Set both values to -1 to stop stamping the frames; receivers keep
+/// the last range they received, which defaults to 0 to 10000 ms. The remote
+/// peer must negotiate the extension, which this library does by default.
+/// This is not supported on UWP.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetPlayoutDelay(mrsLocalVideoTrackHandle trackHandle,
+                                  int32_t min_delay_ms,
+                                  int32_t max_delay_ms) noexcept;
+
+/// Set the options of the encoder of a local video track. The encoder is
+/// reinitialized with the options on the next frame of the track, which makes
+/// it produce a key frame. Only the built-in VP8 encoder honors the preset in
+/// this version of WebRTC, and only on desktop, where the mobile builds choose
+/// the speed from the resolution. The built-in VP8, VP9 and H.264 encoders all
+/// honor the maximum number of threads. Other local tracks sharing the same
+/// video track source may use the options too. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackSetEncoderOptions(
+    mrsLocalVideoTrackHandle trackHandle,
+    const mrsVideoEncoderOptions* options) noexcept;
+
+/// Enable or disable asynchronous frame delivery. When enabled, color
+/// conversion and frame callbacks run on a dedicated delivery thread instead of
+/// the thread producing the frames, and only the latest frame is kept when the
+/// callbacks cannot keep up. The frames dropped are counted in the stats
+/// returned by |mrsLocalVideoTrackGetFrameDeliveryStats()|. Once unregistering
+/// a frame callback returns, the callback is not invoked again, even by the
+/// delivery thread.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetAsyncFrameDelivery(mrsLocalVideoTrackHandle trackHandle,
+                                        mrsBool enabled) noexcept;
+
+/// Get the number of frames dropped by the frame delivery of the track.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackGetFrameDeliveryStats(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameDeliveryStats* stats_out) noexcept;
+
 /// Enable or disable a local video track. Enabled tracks output their media
 /// content as usual. Disabled track output some void media content (black video
 /// frames, silent audio frames). Enabling/disabling a track is a lightweight
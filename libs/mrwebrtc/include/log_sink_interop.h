@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+//
+// Log sink API
+//
+// The log sink receives the native logs of the library and of the WebRTC
+// implementation. Logging threads, like the media threads, only copy each
+// message into an in-memory ring, and a background thread writes the messages
+// to a file or to a callback. The ring never blocks the logging threads: when
+// it is full, messages are dropped and counted. This keeps verbose logging
+// cheap enough to leave enabled in production.
+//
+// Levels are set per module, where a module is the name of the source file
+// which logs, without extension, like "peer_connection". Messages below the
+// lowest level of all modules are not even formatted.
+//
+
+/// Severity of a log message.
+enum class mrsLogLevel : int32_t {
+  kVerbose = 0,
+  kInfo = 1,
+  kWarning = 2,
+  kError = 3,
+  /// Level of modules which log nothing.
+  kNone = 4,
+};
+
+/// Callback receiving the messages of the log sink, on its background thread.
+/// |module| is the module which logged the message, or an empty string if
+/// unknown, and |message| is the text of the message, as UTF-8.
+using mrsLogCallback = void(MRS_CALL*)(void* user_data,
+                                       mrsLogLevel level,
+                                       const char* module,
+                                       const char* message);
+
+/// Configuration of the log sink.
+struct mrsLogSinkConfig {
+  /// Level of the modules with no level of their own.
+  mrsLogLevel level{mrsLogLevel::kInfo};
+
+  /// Number of messages the ring holds. Messages longer than 512 bytes are
+  /// truncated.
+  uint32_t capacity{1024};
+
+  /// Interval between two writes of the background thread, in milliseconds.
+  /// The thread also wakes up early when the ring is half full.
+  int32_t flush_interval_ms{100};
+
+  /// UTF-8 path of a file to write the messages to, truncated when the sink
+  /// is installed, or NULL.
+  const char* file_path{nullptr};
+
+  /// Callback receiving the messages, or NULL.
+  mrsLogCallback callback{nullptr};
+  void* user_data{nullptr};
+
+  /// Keep writing the messages to the debug output too. That output is
+  /// written synchronously by the logging threads, and is disabled by default
+  /// while the sink is installed.
+  mrsBool keep_debug_output{mrsBool::kFalse};
+};
+
+/// Statistics of the log sink.
+struct mrsLogSinkStats {
+  /// Number of messages written to the file or the callback.
+  uint64_t written_count;
+
+  /// Number of messages dropped because the ring was full.
+  uint64_t dropped_count;
+};
+
+/// Install the log sink. At least one of the file path and the callback must
+/// be set. Return |mrsResult::kInvalidOperation| if the sink is already
+/// installed, and |mrsResult::kNotFound| if the file cannot be created.
+MRS_API mrsResult MRS_CALL
+mrsLogSinkInstall(const mrsLogSinkConfig* config) noexcept;
+
+/// Uninstall the log sink, after writing the messages still in the ring. This
+/// is a no-op if the sink is not installed.
+MRS_API void MRS_CALL mrsLogSinkUninstall() noexcept;
+
+/// Set the level of a module, or the level of the modules with no level of
+/// their own if |module| is NULL. The module names are matched by prefix, the
+/// longest matching name taking precedence, so that "video_capture" also sets
+/// the level of "video_capture_factory". This can be called from any thread,
+/// and takes effect immediately.
+MRS_API mrsResult MRS_CALL mrsLogSinkSetLevel(const char* module,
+                                              mrsLogLevel level) noexcept;
+
+/// Write all the messages logged so far, and wait for them to be written.
+MRS_API mrsResult MRS_CALL mrsLogSinkFlush() noexcept;
+
+MRS_API mrsResult MRS_CALL
+mrsLogSinkGetStats(mrsLogSinkStats* stats_out) noexcept;
+
+}  // extern "C"
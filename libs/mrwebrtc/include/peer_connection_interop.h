@@ -53,6 +53,195 @@ MRS_API void MRS_CALL mrsPeerConnectionRegisterIceGatheringStateChangedCallback(
     mrsPeerConnectionIceGatheringStateChangedCallback callback,
     void* user_data) noexcept;
 
+/// Callback invoked when a batch of local ICE candidates is ready to be sent
+/// to the remote peer. The |candidates| array of |count| elements is only
+/// valid during the call.
+using mrsPeerConnectionIceCandidatesReadytoSendCallback =
+    void(MRS_CALL*)(void* user_data,
+                    const mrsIceCandidate* candidates,
+                    int count);
+
+/// Register a callback invoked when a batch of local ICE candidates is ready
+/// to be sent, as configured with
+/// |mrsPeerConnectionSetIceCandidateBatchWindow()|. This is invoked in
+/// addition to the callback registered with
+/// |mrsPeerConnectionRegisterIceCandidateReadytoSendCallback()|, which still
+/// receives each candidate individually as soon as it is gathered.
+MRS_API void MRS_CALL mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data) noexcept;
+
+/// Set the time in milliseconds local ICE candidates are held before being
+/// delivered together to the batch callback, counted from the first candidate
+/// of each batch. Sending a single signaling message per batch instead of one
+/// per candidate reduces the signaling overhead of trickle ICE. Zero, the
+/// default, delivers each candidate on its own as soon as it is gathered, and
+/// a negative value holds all candidates until gathering completes. Any
+/// pending batch is always delivered when gathering completes, before the ICE
+/// gathering state change is notified.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionSetIceCandidateBatchWindow(mrsPeerConnectionHandle peer_handle,
+                                            int window_ms) noexcept;
+
+/// Set whether the transceivers created by applying a remote description are
+/// subscribed to the media they receive. When false, new remote transceivers
+/// are unsubscribed as with |mrsTransceiverSetSubscribed()| before the answer
+/// is created, so that the remote peer does not send any media until the
+/// application subscribes. The default is true.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionSetAutoSubscribe(mrsPeerConnectionHandle peer_handle,
+                                  mrsBool auto_subscribe) noexcept;
+
+/// Add a listener of a peer connection event, invoked in addition to the
+/// callback registered with the corresponding
+/// |mrsPeerConnectionRegisterXxxCallback()| function, and to any other
+/// listener. This allows several independent components to observe the same
+/// event. On success, the new listener identifier is returned in
+/// |listener_id_out|, to later remove the listener with
+/// |mrsPeerConnectionRemoveListener()|. Adding a listener never waits for the
+/// callbacks in progress, so it may be called from any thread while another
+/// callback of the same peer connection is running.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddConnectedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionConnectedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddLocalSdpReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionLocalSdpReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddIceCandidateReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidateReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddIceCandidatesReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddIceStateChangedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceStateChangedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddIceGatheringStateChangedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceGatheringStateChangedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddRenegotiationNeededListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionRenegotiationNeededCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddTransceiverAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionTransceiverAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddAudioTrackAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionAudioTrackAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddAudioTrackRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionAudioTrackRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddVideoTrackAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionVideoTrackAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddVideoTrackRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionVideoTrackRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddDataChannelAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionDataChannelAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsPeerConnectionAddDataChannelRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionDataChannelRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept;
+
+/// Remove a listener previously added with any of the
+/// |mrsPeerConnectionAddXxxListener()| functions. Once this returns, the
+/// listener is never invoked again, unless this is called from within a
+/// callback of the same peer connection, in which case the event being
+/// dispatched may still invoke it.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionRemoveListener(mrsPeerConnectionHandle peer_handle,
+                                uint64_t listener_id) noexcept;
+
+/// Create a new JSEP offer restarting ICE, to re-establish the transport of an
+/// existing session, for example after the ICE connection failed following a
+/// network change. All transceivers, data channels, and the DTLS session are
+/// kept, and only the ICE credentials and candidates are renegotiated. This
+/// otherwise behaves like |mrsPeerConnectionCreateOffer()|.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionRestartIce(mrsPeerConnectionHandle peer_handle) noexcept;
+
+/// Policy to automatically restart ICE when the connection is lost.
+struct mrsIceRestartPolicy {
+  /// Restart ICE automatically when the ICE connection fails. Only one of the
+  /// two peers should enable this, to avoid both peers creating an offer at
+  /// the same time.
+  mrsBool enabled{mrsBool::kFalse};
+
+  /// Delay in milliseconds after the ICE connection becomes disconnected
+  /// before restarting ICE if the connection did not recover on its own, or a
+  /// negative value to only restart once the connection failed. A disconnect
+  /// is detected within a few seconds, whereas the connection only fails after
+  /// about 15 seconds.
+  int disconnected_delay_ms{-1};
+
+  /// Maximum number of consecutive restarts until the connection is
+  /// re-established, or zero for no limit.
+  int max_attempts{3};
+};
+
+/// Set the policy to automatically restart ICE when the connection is lost.
+/// Restarts are initiated as if by |mrsPeerConnectionRestartIce()|, and are
+/// postponed while an SDP exchange is in progress.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionSetIceRestartPolicy(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsIceRestartPolicy* policy) noexcept;
+
+/// Start gathering ICE candidates before the negotiation, by growing the pool
+/// of candidates gathered ahead of time to at least |pool_size|. The first
+/// offer or answer then uses the pooled candidates, which shortens the time to
+/// establish the connection. This must be called before the first offer or
+/// answer is created; see also
+/// |mrsPeerConnectionConfiguration::ice_candidate_pool_size| to pre-gather on
+/// creation.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionPrewarmIce(mrsPeerConnectionHandle peer_handle,
+                            int pool_size) noexcept;
+
+/// Start a batch of changes, for example adding several transceivers, during
+/// which the renegotiation needed event is not raised. If the event was raised
+/// during the batch, it is raised once by |mrsPeerConnectionEndBatchUpdate()|,
+/// so that all changes are negotiated with a single offer. Batches can be
+/// nested, in which case only the outermost one raises the event.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionBeginBatchUpdate(mrsPeerConnectionHandle peer_handle) noexcept;
+
+/// End a batch of changes started with |mrsPeerConnectionBeginBatchUpdate()|,
+/// and raise the renegotiation needed event if it was raised during the
+/// outermost batch. This fails with |mrsResult::kInvalidOperation| if no batch
+/// was started.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionEndBatchUpdate(mrsPeerConnectionHandle peer_handle) noexcept;
+
 /// Create a new transceiver attached to the given peer connection.
 MRS_API mrsResult MRS_CALL
 mrsPeerConnectionAddTransceiver(mrsPeerConnectionHandle peer_handle,
@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Create a video track source relaying the encoded frames of a remote video
+/// track, to send them to other peer connections without decoding nor
+/// re-encoding them. Local video tracks created from this source forward the
+/// frames as is, on their own RTP stream, and forward the key frame requests
+/// of their remote peer to the remote peer sending the relayed track. The
+/// frames can only be relayed on transceivers which negotiated the same codec
+/// as the relayed track; only VP8 and H.264 are supported.
+///
+/// The source receives frames as long as the remote track exists, and remains
+/// valid afterward. Its frame callbacks receive black frames, as the relayed
+/// frames are never decoded. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsRelayVideoTrackSourceCreate(
+    mrsRemoteVideoTrackHandle remote_track_handle,
+    mrsRelayVideoTrackSourceHandle* source_handle_out) noexcept;
+
+}  // extern "C"
@@ -10,7 +10,9 @@
 extern "C" {
 
 /// Register a custom callback to be called when the local audio track received
-/// a frame.
+/// a frame. Once this returns, the previous callback is never invoked again,
+/// unless this is called from within that callback, which cannot wait for
+/// itself.
 ///
 /// WebRTC audio tracks produce an audio frame every 10 ms.
 /// If you want the audio frames to be buffered (and optionally resampled)
@@ -23,6 +25,37 @@ mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
                                          mrsAudioFrameCallback callback,
                                          void* user_data) noexcept;
 
+/// Deliver the frames of the remote audio track to the frame callback in
+/// batches of |period_ms| milliseconds, instead of one callback every 10 ms.
+/// Each batch is a single frame of the aggregated samples, with the timestamp
+/// of the first one. Zero, the default, disables aggregation. The period
+/// should be a multiple of 10 ms, and cannot exceed 1000 ms.
+MRS_API mrsResult MRS_CALL mrsRemoteAudioTrackSetFrameAggregationPeriod(
+    mrsRemoteAudioTrackHandle track_handle,
+    int32_t period_ms) noexcept;
+
+/// Get the audio level of the remote audio track, measured natively over the
+/// last frame received. This is cheap enough to be polled every frame, and
+/// avoids registering a frame callback only to meter the audio. The level is
+/// only updated while the track is decoded, that is while it is output to the
+/// audio device or has any consumer.
+MRS_API mrsResult MRS_CALL
+mrsRemoteAudioTrackGetAudioLevel(mrsRemoteAudioTrackHandle track_handle,
+                                 mrsAudioLevel* level_out) noexcept;
+
+/// Register a callback invoked when the audio level of the remote audio track
+/// changes, that is when its RMS level moved by at least |threshold| since the
+/// last invocation, or when its voice activity changes. A zero threshold
+/// invokes the callback on each frame. The callback is invoked once with the
+/// next frame after registering it. Pass a NULL callback to unregister.
+/// Registering a callback decodes the track even when it is not output to the
+/// audio device, like a frame callback.
+MRS_API mrsResult MRS_CALL mrsRemoteAudioTrackRegisterAudioLevelCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    float threshold,
+    mrsAudioLevelCallback callback,
+    void* user_data) noexcept;
+
 /// Enable or disable a remote audio track. Enabled tracks output their media
 /// content as usual. Disabled tracks output some void media content (silent
 /// audio frames). Enabling/disabling a track is a lightweight concept similar
@@ -52,6 +85,27 @@ mrsRemoteAudioTrackOutputToDevice(mrsRemoteAudioTrackHandle track_handle,
 MRS_API mrsBool MRS_CALL mrsRemoteAudioTrackIsOutputToDevice(
     mrsRemoteAudioTrackHandle track_handle) noexcept;
 
+/// Set the linear gain and the stereo pan of a remote audio track. They are
+/// applied natively to the audio device output and to the read buffers of the
+/// track, ramping from the previous values over a few milliseconds to avoid
+/// clicks. Frame callbacks still receive the audio unchanged.
+///
+/// |gain| must be non-negative, and values above 1 amplify the audio,
+/// saturating the loudest samples. |pan| ranges from -1 (left only) to 1
+/// (right only), attenuating the opposite channel, and has no effect on mono
+/// output. The default is a gain of 1 with a centered pan.
+MRS_API mrsResult MRS_CALL
+mrsRemoteAudioTrackSetGain(mrsRemoteAudioTrackHandle track_handle,
+                           float gain,
+                           float pan) noexcept;
+
+/// Mute or unmute a remote audio track, ramping its gain down to zero or back
+/// up to the gain set with |mrsRemoteAudioTrackSetGain|. Unlike not outputting
+/// the track to the audio device, this also silences its read buffers.
+MRS_API mrsResult MRS_CALL
+mrsRemoteAudioTrackSetMuted(mrsRemoteAudioTrackHandle track_handle,
+                            mrsBool muted) noexcept;
+
 /// High level interface for consuming WebRTC audio tracks.
 ///
 /// Enqueues audio frames for a remote audio track in an internal buffer as they
@@ -89,6 +143,62 @@ MRS_API mrsResult MRS_CALL
 mrsRemoteAudioTrackCreateReadBuffer(mrsRemoteAudioTrackHandle track_handle,
                                     mrsAudioTrackReadBufferHandle* bufferOut);
 
+/// Quality of the sample rate conversion of an AudioTrackReadBuffer, when the
+/// rate read differs from the rate of the track.
+enum class mrsAudioResamplingQuality : int32_t {
+  /// Filtered resampling of WebRTC, which best preserves the audio at a higher
+  /// CPU cost. This is the default.
+  kHigh = 0,
+
+  /// Linear interpolation, several times cheaper but which lets some high
+  /// frequencies alias. This is usually enough for voice, for example on
+  /// mobile devices.
+  kFast = 1,
+
+  /// No rate conversion, for applications reading at the rate of the track,
+  /// usually 48 kHz. Frames of any other rate play at the wrong pitch and
+  /// speed, and the clock drift is not corrected in adaptive mode.
+  kPassthrough = 2,
+};
+
+/// Options of an AudioTrackReadBuffer.
+struct mrsAudioTrackReadBufferOptions {
+  /// Capacity of the buffer, in milliseconds. WebRTC delivers audio in 10ms
+  /// frames, so this should be a multiple of 10.
+  int32_t buffer_ms{500};
+
+  /// Quality of the sample rate conversion.
+  mrsAudioResamplingQuality resampling_quality{
+      mrsAudioResamplingQuality::kHigh};
+};
+
+/// Variant of |mrsRemoteAudioTrackCreateReadBuffer| with the given options.
+/// Pass a null |options| for the default ones.
+MRS_API mrsResult MRS_CALL mrsRemoteAudioTrackCreateReadBufferWithOptions(
+    mrsRemoteAudioTrackHandle track_handle,
+    const mrsAudioTrackReadBufferOptions* options,
+    mrsAudioTrackReadBufferHandle* buffer_out) noexcept;
+
+/// Create an AudioTrackReadBuffer attached to no track, which buffers the
+/// frames pushed by the application with |mrsAudioTrackReadBufferPushFrame|
+/// instead. This lets audio from any origin go through the same buffering,
+/// resampling and drift correction as a remote audio track. Pass a null
+/// |options| for the default ones.
+MRS_API mrsResult MRS_CALL mrsAudioTrackReadBufferCreateForPush(
+    const mrsAudioTrackReadBufferOptions* options,
+    mrsAudioTrackReadBufferHandle* buffer_out) noexcept;
+
+/// Push a frame into a buffer created with
+/// |mrsAudioTrackReadBufferCreateForPush|, as a remote audio track delivers
+/// its frames. The frame holds 8-bit or 16-bit samples of 1 or 2 channels,
+/// usually 10 ms of audio. The frame is dropped, and counted as an overrun,
+/// if the buffer is full or if the frame is larger than 10 ms of 16-bit
+/// stereo audio at 96 kHz. Only one thread at a time may push frames, and
+/// this never blocks the thread reading the buffer.
+MRS_API mrsResult MRS_CALL
+mrsAudioTrackReadBufferPushFrame(mrsAudioTrackReadBufferHandle buffer,
+                                 const mrsAudioFrame* frame) noexcept;
+
 
 /// Fill |data| with samples from the internal buffer.
 ///
@@ -132,8 +242,153 @@ mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
                             int* num_samples_read_out,
                             mrsBool* has_overrun_out);
 
+/// Sample type of the output of |mrsAudioTrackReadBufferReadWithFormat|.
+enum class mrsAudioTrackReadBufferSampleType : int32_t {
+  /// 32-bit floating-point samples in the [-1:1] range.
+  kFloat32 = 0,
+
+  /// Signed 16-bit integer samples.
+  kInt16 = 1,
+};
+
+/// Layout of the output of |mrsAudioTrackReadBufferReadWithFormat|.
+struct mrsAudioTrackReadBufferOutputFormat {
+  /// Type of each sample.
+  mrsAudioTrackReadBufferSampleType sample_type{
+      mrsAudioTrackReadBufferSampleType::kFloat32};
+
+  /// If true, the samples of all channels are interleaved, like for
+  /// |mrsAudioTrackReadBufferRead|. Otherwise the output is planar: it is
+  /// split into one contiguous plane per channel, each of
+  /// |num_samples_max / num_channels| samples.
+  mrsBool interleaved{mrsBool::kTrue};
+};
+
+/// Variant of |mrsAudioTrackReadBufferRead| writing samples in the given
+/// format, converted from the internal buffer in a single pass.
+///
+/// |samples_out| must point to an array of at least |num_samples_max|
+/// elements of the sample type of |format|. For planar output,
+/// |num_samples_max| must be a multiple of |num_channels|. In case of
+/// underrun, each plane holds |*num_samples_read_out / num_channels| samples
+/// read, followed by the padding.
+MRS_API mrsResult MRS_CALL mrsAudioTrackReadBufferReadWithFormat(
+    mrsAudioTrackReadBufferHandle buffer,
+    int sample_rate,
+    int num_channels,
+    mrsAudioTrackReadBufferPadBehavior pad_behavior,
+    const mrsAudioTrackReadBufferOutputFormat* format,
+    void* samples_out,
+    int num_samples_max,
+    int* num_samples_read_out,
+    mrsBool* has_overrun_out) noexcept;
+
+/// Latency window targeted by an AudioTrackReadBuffer in adaptive mode.
+struct mrsAudioTrackReadBufferLatencyWindow {
+  /// Minimum buffered duration, in milliseconds. Below this, playback is
+  /// slowed down slightly, and after an underrun reading resumes only once
+  /// this much audio is buffered again.
+  int32_t min_latency_ms{40};
+
+  /// Maximum buffered duration, in milliseconds. Above this, playback is sped
+  /// up slightly. Must be greater than |min_latency_ms|, and not exceed the
+  /// buffer capacity.
+  int32_t max_latency_ms{120};
+};
+
+/// Enable or disable the adaptive latency mode of an AudioTrackReadBuffer.
+///
+/// By default the buffer plays audio as soon as it is available, and drops
+/// new frames when it is full. In adaptive mode it keeps the buffered duration
+/// within the given window instead, compensating for the clock drift between
+/// the sender and the local audio engine by resampling the output by a small
+/// fraction of a percent, rather than by dropping or padding frames.
+///
+/// Pass a null |window| to disable the adaptive mode.
+MRS_API mrsResult MRS_CALL mrsAudioTrackReadBufferSetLatencyWindow(
+    mrsAudioTrackReadBufferHandle buffer,
+    const mrsAudioTrackReadBufferLatencyWindow* window) noexcept;
+
+/// Statistics about the fill level of an AudioTrackReadBuffer.
+struct mrsAudioTrackReadBufferStats {
+  /// Buffered duration, in milliseconds, at the last read.
+  int32_t latency_ms;
+
+  /// Minimum and maximum buffered duration, in milliseconds, observed by the
+  /// reads since the previous call to |mrsAudioTrackReadBufferGetStats|.
+  int32_t min_fill_ms;
+  int32_t max_fill_ms;
+
+  /// Number of times the buffer ran empty while reading.
+  uint64_t underrun_count;
+
+  /// Number of incoming frames dropped because the buffer was full.
+  uint64_t overrun_count;
+};
+
+/// Get the fill level statistics of an AudioTrackReadBuffer. This can be
+/// called from any thread.
+MRS_API mrsResult MRS_CALL
+mrsAudioTrackReadBufferGetStats(mrsAudioTrackReadBufferHandle buffer,
+                                mrsAudioTrackReadBufferStats* stats) noexcept;
+
 /// Release the buffer.
 MRS_API void MRS_CALL
 mrsAudioTrackReadBufferDestroy(mrsAudioTrackReadBufferHandle buffer);
 
+/// High level interface for consuming the mix of several remote audio tracks.
+///
+/// Buffers the audio of each track like an AudioTrackReadBuffer, and mixes the
+/// tracks natively with a per-track gain, so that a single call to
+/// |mrsMixedAudioReadBufferRead| reads the mix of all tracks. This is cheaper
+/// than reading one AudioTrackReadBuffer per track and mixing them in the
+/// application.
+using mrsMixedAudioReadBufferHandle = void*;
+
+/// Create a mixed audio read buffer, initially mixing no track.
+MRS_API mrsResult MRS_CALL mrsMixedAudioReadBufferCreate(
+    mrsMixedAudioReadBufferHandle* buffer_out) noexcept;
+
+/// Add a remote audio track to the mix, with the given linear |gain|. The
+/// track is decoded for as long as it is part of the mix, even if not output
+/// to the audio device, and is kept alive until removed or until the buffer
+/// is destroyed. Adding a track already part of the mix fails with
+/// |kInvalidOperation|.
+MRS_API mrsResult MRS_CALL
+mrsMixedAudioReadBufferAddTrack(mrsMixedAudioReadBufferHandle buffer,
+                                mrsRemoteAudioTrackHandle track_handle,
+                                float gain) noexcept;
+
+/// Remove a remote audio track from the mix.
+MRS_API mrsResult MRS_CALL mrsMixedAudioReadBufferRemoveTrack(
+    mrsMixedAudioReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle) noexcept;
+
+/// Change the linear gain of a remote audio track already part of the mix.
+/// This takes effect from the next read.
+MRS_API mrsResult MRS_CALL
+mrsMixedAudioReadBufferSetTrackGain(mrsMixedAudioReadBufferHandle buffer,
+                                    mrsRemoteAudioTrackHandle track_handle,
+                                    float gain) noexcept;
+
+/// Fill |samples_out| with |num_samples| interleaved floating-point samples of
+/// the mix of all tracks, resampled to |sample_rate| with |num_channels|
+/// channels. Tracks which run out of data contribute silence, so the output is
+/// always filled entirely. The mix is not clipped, so samples can extend past
+/// the [-1:1] range when several tracks are loud at once.
+///
+/// |has_overrun_out| is set to |mrsBool::kTrue| if any track dropped frames
+/// since the previous read.
+MRS_API mrsResult MRS_CALL
+mrsMixedAudioReadBufferRead(mrsMixedAudioReadBufferHandle buffer,
+                            int sample_rate,
+                            int num_channels,
+                            float* samples_out,
+                            int num_samples,
+                            mrsBool* has_overrun_out) noexcept;
+
+/// Release the buffer, and all the tracks of the mix.
+MRS_API void MRS_CALL
+mrsMixedAudioReadBufferDestroy(mrsMixedAudioReadBufferHandle buffer) noexcept;
+
 }  // extern "C"
@@ -11,6 +11,13 @@ extern "C" {
 /// Register a custom callback to be called when the remote video track received
 /// a frame. The received frames is passed to the registered callback in I420
 /// encoding.
+///
+/// Registering another callback, or nullptr to unregister, waits for the frame
+/// delivery in progress, so that once this returns the previous callback is
+/// never invoked again. The exception is a call from within a frame callback
+/// of the same track, which cannot wait for itself; the frame being
+/// delivered may then still invoke the previous callback. This applies to all
+/// the frame callback registration functions below.
 MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterI420AFrameCallback(
     mrsRemoteVideoTrackHandle trackHandle,
     mrsI420AVideoFrameCallback callback,
@@ -24,6 +31,252 @@ MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameCallback(
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept;
 
+/// Register a custom callback to be called when the remote video track received
+/// a frame. The received frame is passed to the registered callback in NV12
+/// encoding.
+MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterNv12FrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the remote video track received
+/// a frame. The received frame is passed to the registered callback as a lease
+/// over the decoded frame buffer, without any copy or conversion. The callee
+/// must release the lease with |mrsVideoFrameBufferRemoveRef()|.
+MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterFrameLeaseCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the remote video track received
+/// a frame. The received frame is passed to the registered callback in ARGB32
+/// encoding, inside a pooled buffer the callee can check out. See
+/// |mrsArgb32VideoFrameLeaseCallback| for details.
+MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameLeaseCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Set the number of pooled ARGB32 buffers used to deliver frames to the ARGB32
+/// callbacks, which is the maximum number of frames checked out at once. The
+/// default is a single buffer.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackSetArgb32BufferPoolSize(
+    mrsRemoteVideoTrackHandle trackHandle,
+    int pool_size) noexcept;
+
+/// Set the options for the delivery of frames to the I420A, ARGB32 and NV12
+/// callbacks, to downscale frames to a maximum size and skip frames above a
+/// maximum framerate. Frame lease callbacks are not affected.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackSetFrameDeliveryOptions(
+    mrsRemoteVideoTrackHandle trackHandle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept;
+
+/// Add a subscriber receiving video frames as I420A-encoded, ARGB32-encoded or
+/// NV12-encoded buffers, in addition to any registered frame callback. Each
+/// frame is converted at most once per format, and all subscribers of a format
+/// share the same read-only frame data. On success, the new subscriber
+/// identifier is returned in |subscriber_id_out|, to later remove the
+/// subscriber with |mrsRemoteVideoTrackRemoveFrameSubscriber()|.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackAddI420AFrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackAddArgb32FrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackAddNv12FrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+
+/// Add a subscriber enqueuing the video frames into a video frame queue
+/// created with |mrsVideoFrameQueueCreate()|, without copying them. The
+/// subscriber must be removed before the queue is destroyed.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackAddFrameQueueSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameQueueHandle queue_handle,
+    uint64_t* subscriber_id_out) noexcept;
+
+/// Remove a frame subscriber previously added. Once this returns, the
+/// subscriber is never invoked again.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackRemoveFrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    uint64_t subscriber_id) noexcept;
+
+/// Get the percentiles of the latency between the capture of the frames of the
+/// track and their delivery to the frame callbacks. This only accounts for
+/// frames delivered to at least one callback. For a remote track, the capture
+/// time of the frames is only known once the remote peer sent an RTCP sender
+/// report, and requires both peers to have synchronized NTP clocks.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackGetLatencyStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameLatencyStats* stats_out) noexcept;
+
+/// Discard the latency samples recorded so far for the track.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackResetLatencyStats(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept;
+
+/// Enable or disable decoding the latency markers stamped into the pixels of
+/// the frames by the sender, see
+/// |mrsExternalVideoTrackSourceSetLatencyMarkers()|, to measure the end-to-end
+/// latency of the frames. This relies on the UTC
+/// clocks of both peers, which must be synchronized (e.g. with NTP) when the
+/// peers run on different machines. The statistics are reset with
+/// |mrsRemoteVideoTrackResetLatencyStats()|.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackSetLatencyMarkerDecoding(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsBool enabled) noexcept;
+
+/// Get the statistics of the latency markers decoded from the frames of the
+/// track.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackGetLatencyMarkerStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoLatencyMarkerStats* stats_out) noexcept;
+
+/// Get the layers of the scalable video encoding received on the track, from
+/// the RTP payload descriptors of the frames. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackGetLayerStats(mrsRemoteVideoTrackHandle trackHandle,
+                                 mrsVideoLayerStats* stats_out) noexcept;
+
+/// Get the timing of the arrival of the frames of the track since the last
+/// reset, including the freezes and pauses of the received stream. Frames are
+/// timed as they arrive from the decoder, whether or not they are delivered to
+/// a frame callback.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackGetFrameTimingStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameTimingStats* stats_out) noexcept;
+
+/// Discard the frame timing statistics recorded so far for the track.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackResetFrameTimingStats(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept;
+
+/// Enable or disable asynchronous frame delivery. When enabled, color
+/// conversion and frame callbacks run on a dedicated delivery thread instead of
+/// the thread producing the frames, and only the latest frame is kept when the
+/// callbacks cannot keep up. The frames dropped are counted in the stats
+/// returned by |mrsRemoteVideoTrackGetFrameDeliveryStats()|. Once unregistering
+/// a frame callback returns, the callback is not invoked again, even by the
+/// delivery thread.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackSetAsyncFrameDelivery(mrsRemoteVideoTrackHandle trackHandle,
+                                         mrsBool enabled) noexcept;
+
+/// Get the number of frames dropped by the frame delivery of the track.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackGetFrameDeliveryStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameDeliveryStats* stats_out) noexcept;
+
+/// Ask the remote peer to send a key frame on a remote video track, instead of
+/// waiting for the next periodic one, for example when starting to record the
+/// encoded frames of the track mid-stream. The request is sent as an RTCP PLI
+/// message with the next frame received. The delta frames received until the
+/// key frame are not decoded. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackRequestKeyFrame(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept;
+
+/// Callback fired for each encoded frame received on a remote video track.
+using mrsEncodedVideoFrameCallback =
+    void(MRS_CALL*)(void* user_data, const mrsEncodedVideoFrame* frame);
+
+/// Register a callback invoked with each encoded frame received on the track,
+/// before it is decoded, for example to record the stream without re-encoding
+/// it. The callback is invoked on the decoding thread. Pass a NULL callback to
+/// unregister it. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsEncodedVideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Enable or disable decoding the frames of the track. When disabled, the
+/// track does not deliver any decoded frame, but still invokes the encoded
+/// frame callback, which saves the decoding cost on receive-only tracks
+/// recorded as is. Decoding resumes on the next key frame once enabled again.
+/// This is not supported on UWP.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackSetDecodingEnabled(mrsRemoteVideoTrackHandle trackHandle,
+                                      mrsBool enabled) noexcept;
+
+/// Decode the frames of the track on a single thread, or on as many threads as
+/// allowed by |mrsVideoDecoderThreadingConfig| if |low_priority| is false, the
+/// default. Low priority decoding suits the tracks shown in the background,
+/// leaving the processors to the decoders of the other tracks. The change
+/// takes effect on the next key frame, which is requested from the remote
+/// peer. This is not supported on UWP.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackSetLowPriorityDecoding(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsBool low_priority) noexcept;
+
+/// Start recording the encoded frames received on the track to the file at
+/// |path|, overwriting any existing file, for example to replay them later
+/// with |mrsReplayEncodedVideo()|. The recording holds the frames as received,
+/// with their RTP timestamp and the time they reached the decoder, and starts
+/// at the next key frame, which is requested from the remote peer. This
+/// replaces any recording in progress, and is not supported on UWP.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackStartRecording(mrsRemoteVideoTrackHandle trackHandle,
+                                  const char* path) noexcept;
+
+/// Stop recording the encoded frames of the track, if recording, and close the
+/// recording file. The number of frames recorded is returned in
+/// |frame_count_out|, which can be NULL.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackStopRecording(mrsRemoteVideoTrackHandle trackHandle,
+                                 uint32_t* frame_count_out) noexcept;
+
+/// Configuration of the replay of a recording of encoded video frames.
+struct mrsEncodedVideoReplayConfig {
+  /// Path of a recording created with |mrsRemoteVideoTrackStartRecording()|.
+  const char* path{nullptr};
+
+  /// Deliver the frames at the pacing of their recorded arrival times, to
+  /// reproduce the conditions of the recording. Otherwise the frames are
+  /// decoded and delivered as fast as possible, to benchmark that path.
+  mrsBool recorded_pacing{mrsBool::kFalse};
+
+  /// Optional callbacks invoked with each decoded frame, as for a remote
+  /// video track.
+  mrsI420AVideoFrameCallback i420a_callback{nullptr};
+  void* i420a_user_data{nullptr};
+  mrsArgb32VideoFrameCallback argb32_callback{nullptr};
+  void* argb32_user_data{nullptr};
+};
+
+/// Statistics of the replay of a recording of encoded video frames.
+struct mrsEncodedVideoReplayStats {
+  /// Number of encoded frames read from the recording.
+  uint32_t frames_read{0};
+
+  /// Number of frames decoded and delivered to the callbacks.
+  uint32_t frames_decoded{0};
+
+  /// Number of frames the decoder failed to decode.
+  uint32_t decode_errors{0};
+
+  /// Total time spent decoding and delivering the frames, in microseconds,
+  /// excluding the waits of the recorded pacing.
+  int64_t decode_time_us{0};
+
+  /// Total duration of the replay, in microseconds.
+  int64_t duration_us{0};
+};
+
+/// Replay a recording of encoded video frames through a software decoder and
+/// the same frame delivery path as a remote video track, for example to
+/// benchmark decoding and delivery on frames captured from a real stream. The
+/// recording is replayed on the caller's thread, where the frame callbacks are
+/// invoked, and this returns once the whole recording is replayed. This
+/// returns |kNotFound| if the file cannot be opened, |kInvalidParameter| if it
+/// is not a valid recording, and |kUnsupported| if no decoder supports its
+/// codec.
+MRS_API mrsResult MRS_CALL
+mrsReplayEncodedVideo(const mrsEncodedVideoReplayConfig* config,
+                      mrsEncodedVideoReplayStats* stats_out) noexcept;
+
 /// Enable or disable a remote video track. Enabled tracks output their media
 /// content as usual. Disabled tracks output some void media content (black
 /// video frames, silent audio frames). Enabling/disabling a track is a
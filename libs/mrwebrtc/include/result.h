@@ -59,6 +59,12 @@ enum class Result : std::uint32_t {
   /// complete successfully.
   kBufferTooSmall = 0x80000009,
 
+  /// The operation did not complete before its deadline.
+  kTimeout = 0x8000000A,
+
+  /// The operation was cancelled by the caller before it completed.
+  kCancelled = 0x8000000B,
+
   //
   // Peer connection (0x1xx)
   //
@@ -82,6 +88,14 @@ enum class Result : std::uint32_t {
   /// The specified data channel ID is invalid.
   kInvalidDataChannelId = 0x80000302,
 
+  /// The send queue of the data channel is full, and cannot accept any more
+  /// message until it drains below its low watermark.
+  kDataChannelSendQueueFull = 0x80000303,
+
+  /// A data channel stream was aborted before it was fully transferred,
+  /// either by the sender or because the data channel closed.
+  kDataChannelStreamAborted = 0x80000304,
+
   //
   // Media (0x4xx)
   //
@@ -32,6 +32,197 @@ MRS_API mrsResult MRS_CALL
 mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
                            mrsTransceiverDirection new_direction) noexcept;
 
+/// Subscribe to or unsubscribe from the media received by the transceiver, for
+/// example to only receive the remote videos currently displayed in a large
+/// session. While unsubscribed, the next SDP offers and answers do not receive
+/// on the media line, so that the remote peer stops sending, the remote track
+/// is not decoded nor played, and a remote track added is only announced by
+/// the track added callbacks once the transceiver is subscribed again. The
+/// desired direction is left unchanged, and applies again once subscribed.
+/// Changing the subscription of a transceiver which receives triggers a
+/// renegotiation.
+MRS_API mrsResult MRS_CALL
+mrsTransceiverSetSubscribed(mrsTransceiverHandle transceiver_handle,
+                            mrsBool subscribed) noexcept;
+
+/// Set the parameters of the encodings of the media sent by the transceiver,
+/// for example to lower the bitrate or framerate of a single sender. This
+/// applies immediately, without any SDP renegotiation. The |encodings| array
+/// must have one element per encoding of the transceiver, as configured when
+/// it was created, in the same order; that is one element unless simulcast was
+/// enabled. The RID of each encoding cannot be changed, and can be left null.
+/// In Plan B this fails until the sender is created by the first offer or
+/// answer sending media.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetEncodingParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsRtpEncodingParameters* encodings,
+    int count) noexcept;
+
+/// Strategy to reduce the quality of the video sent when the encoder cannot
+/// keep up, or the bandwidth is limited. See webrtc::DegradationPreference.
+enum class mrsDegradationPreference : int32_t {
+  /// Never adapt the video quality.
+  kDisabled = 0,
+  /// Keep the framerate, reducing the resolution, for example for motion.
+  kMaintainFramerate = 1,
+  /// Keep the resolution, reducing the framerate, for example for text.
+  kMaintainResolution = 2,
+  /// Reduce both resolution and framerate. This is the default.
+  kBalanced = 3
+};
+
+/// Set the degradation preference of the video sent by the transceiver. This
+/// applies immediately, without any SDP renegotiation. This fails if the
+/// transceiver is an audio transceiver.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetDegradationPreference(
+    mrsTransceiverHandle transceiver_handle,
+    mrsDegradationPreference preference) noexcept;
+
+/// Codec preferred for the media line of a transceiver.
+struct mrsCodecPreference {
+  /// SDP name of the codec, for example "H264" or "opus", compared
+  /// case-insensitively.
+  const char* name{nullptr};
+
+  /// Optional semicolon-separated list of "key=value" format parameters the
+  /// codec must have, to select among the variants of a codec, for example
+  /// "packetization-mode=1" for H.264, or NULL to allow all variants.
+  const char* params{nullptr};
+};
+
+/// Set the codecs preferred for the media line of the transceiver, in order of
+/// preference. The next SDP offers and answers only advertise the supported
+/// codecs matching these preferences, in that order, along with their
+/// retransmission codecs. This applies to the offer or answer as it is
+/// created, without modifying its SDP message afterward like
+/// |mrsSdpForceCodecs()|, and does not require a renegotiation by itself. If
+/// none of the preferred codecs is supported, the media line is unchanged.
+/// Pass a zero |count| to remove all preferences. This fails with
+/// |mrsResult::kUnsupported| in Plan B, where transceivers do not have their
+/// own media line.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetCodecPreferences(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsCodecPreference* codecs,
+    uint32_t count) noexcept;
+
+/// Options of the Opus encoder of an audio transceiver. Unset options keep the
+/// value negotiated with the remote peer.
+struct mrsAudioCodecOptions {
+  /// Discontinuous transmission, which sends almost no packets during silence.
+  /// This saves most of the bandwidth of participants not talking.
+  mrsOptBool dtx{mrsOptBool::kUnset};
+
+  /// In-band forward error correction, which carries a low-bitrate copy of
+  /// each packet in the next one to conceal single packet losses.
+  mrsOptBool fec{mrsOptBool::kUnset};
+
+  /// Duration of audio in each packet, in milliseconds, from 10 to 120, or
+  /// zero to keep the default of 20 ms. Longer packets save the overhead of
+  /// the packet headers, at the expense of latency.
+  int32_t ptime_ms{0};
+
+  /// Send stereo audio if true, or mono audio if false.
+  mrsOptBool stereo{mrsOptBool::kUnset};
+
+  /// Maximum bitrate of the encoder, in bits per second, or zero for no limit
+  /// beyond the bandwidth estimate. Unlike the other options, this applies
+  /// immediately without renegotiation, and can be changed at any time.
+  int32_t max_bitrate_bps{0};
+};
+
+/// Set the options of the Opus encoder of an audio transceiver. The maximum
+/// bitrate applies immediately if the transceiver is already negotiated, or
+/// once it is. The other options apply to the next SDP offers and answers:
+/// they override the format parameters of Opus in the remote descriptions as
+/// they are applied, which configure the encoder, and they are advertised in
+/// the local descriptions as they are created, for the remote peer to send
+/// audio the same way. This does not require modifying the SDP messages like
+/// |mrsSdpForceCodecs()|. This fails with |mrsResult::kInvalidMediaKind| for a
+/// video transceiver, and with |mrsResult::kUnsupported| in Plan B, where
+/// transceivers do not have their own media line.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetAudioCodecOptions(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsAudioCodecOptions* options) noexcept;
+
+/// Reason why the encoder of a video transceiver sends a lower resolution
+/// than the resolution of its input frames.
+enum class mrsQualityLimitationReason : int32_t {
+  /// The resolution is not limited.
+  kNone = 0,
+
+  /// The resolution is limited because encoding overuses the CPU.
+  kCpu = 1,
+
+  /// The resolution is limited by the bitrate available to the encoder, or by
+  /// the encoded quality at that bitrate.
+  kBandwidth = 2,
+
+  /// The resolution is lower than the input resolution for another reason,
+  /// for example because of the scaling of the encoding parameters.
+  kOther = 3,
+};
+
+/// Change of the quality limitation of a video transceiver.
+struct mrsQualityLimitationEvent {
+  /// Time of the check which detected the change, in milliseconds.
+  int64_t timestamp_ms;
+
+  /// Current limitation reason.
+  mrsQualityLimitationReason reason;
+
+  /// Limitation reason before this change, which lasted
+  /// |previous_duration_ms|. If only the resolution changed, this is |reason|
+  /// and the time spent in it so far. For the first event of a subscription,
+  /// this is |mrsQualityLimitationReason::kNone| with a zero duration.
+  mrsQualityLimitationReason previous_reason;
+  int64_t previous_duration_ms;
+
+  /// Total time spent in each limitation reason since the subscription,
+  /// indexed by |mrsQualityLimitationReason|, in milliseconds.
+  int64_t total_durations_ms[4];
+
+  /// Resolution of the encoded frames, in pixels.
+  uint32_t frame_width;
+  uint32_t frame_height;
+
+  /// Framerate of the encoded frames, in frames per second.
+  int32_t framerate;
+
+  /// Resolution of the input frames of the encoder, in pixels.
+  uint32_t input_width;
+  uint32_t input_height;
+
+  /// Number of resolution changes made by the encoder to adapt to CPU and
+  /// bandwidth limits.
+  int32_t adaptation_changes;
+};
+
+/// Configuration of a quality limitation subscription.
+struct mrsQualityLimitationConfig {
+  /// Interval between two checks of the send stream stats, in milliseconds.
+  int interval_ms{500};
+};
+
+/// Callback delivering a quality limitation change of a video transceiver.
+using mrsQualityLimitationCallback =
+    void(MRS_CALL*)(void* user_data, const mrsQualityLimitationEvent* event);
+
+/// Subscribe to the quality limitation changes of a video transceiver. The
+/// stats of the send stream are checked on the signaling thread at the
+/// configured interval, and an event is delivered when the limitation reason
+/// or the encoded resolution changes, for example to lower the rendering
+/// resolution of the application when the encoder is limited by the CPU. The
+/// first event is delivered once the stream is sent. Each transceiver has at
+/// most one subscription, which this replaces. Pass a NULL callback to
+/// unsubscribe; once this returns, the previous callback is not invoked
+/// anymore. This fails with |mrsResult::kInvalidMediaKind| for an audio
+/// transceiver.
+MRS_API mrsResult MRS_CALL mrsTransceiverSubscribeQualityLimitation(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsQualityLimitationConfig* config,
+    mrsQualityLimitationCallback callback,
+    void* user_data) noexcept;
+
 /// Set the local audio track associated with this transceiver. This new track
 /// replaces the existing one, if any. This doesn't require any SDP
 /// renegotiation. This fails if the transceiver is a video transceiver.
@@ -9,6 +9,15 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+/// Clockwise rotation of a video frame, in degrees. This mirrors the values of
+/// |webrtc::VideoRotation|.
+enum class VideoRotation : std::int32_t {
+  k0 = 0,
+  k90 = 90,
+  k180 = 180,
+  k270 = 270,
+};
+
 /// View over an existing buffer representing a video frame encoded in I420
 /// format with an extra Alpha plane for opacity.
 struct I420AVideoFrame {
@@ -54,6 +63,49 @@ struct I420AVideoFrame {
   /// This is ignored if there is no A plane (|adata_| is NULL).
   /// Otherwise, this is always greater than or equal to |width_|.
   std::int32_t astride_;
+
+  /// Capture timestamp of the frame, in microseconds, in the local monotonic
+  /// clock of |rtc::TimeMicros()|. For remote frames, this is the estimated
+  /// render time of the frame instead. This is ignored on input frames.
+  std::int64_t timestamp_us_;
+
+  /// Capture time of the frame, in milliseconds since the NTP epoch, in the
+  /// clock of the local peer, or zero if unknown. For remote frames, this is
+  /// the capture time on the remote peer, translated into the local clock once
+  /// an RTCP sender report was received. This is ignored on input frames.
+  std::int64_t ntp_time_ms_;
+
+  /// RTP timestamp of the frame, in 90 kHz units, or zero if the frame was not
+  /// sent or received over RTP. This is ignored on input frames.
+  std::uint32_t rtp_timestamp_;
+
+  /// Application metadata passed along with the frame by its sender in
+  /// |mrsExternalVideoFrameInfo|, or NULL if none. The data is only valid
+  /// during the callback delivering the frame. This is ignored on input
+  /// frames.
+  const void* metadata_;
+
+  /// Size of |metadata_|, in bytes, or zero if the frame has no metadata.
+  std::uint32_t metadata_size_;
+
+  /// Clockwise rotation to apply to the frame to display it upright, which
+  /// renderers can apply for free when sampling the frame. This is
+  /// |VideoRotation::k0| if the delivery options applied the rotation to the
+  /// pixels already. This is ignored on input frames.
+  VideoRotation rotation_;
+
+  /// Single buffer holding all the planes of the frame if the delivery options
+  /// requested packed planes, or NULL otherwise. The buffer is aligned to 64
+  /// bytes, and holds the Y, U, V, and A planes in that order, each one
+  /// immediately following the previous one, with |ydata_| at its start. The
+  /// offsets of the planes are those of their pointers within the buffer, so
+  /// the whole frame can be copied at once into a single staging resource. The
+  /// buffer is only valid during the callback delivering the frame. This is
+  /// ignored on input frames.
+  const void* packed_data_;
+
+  /// Size of |packed_data_|, in bytes, or zero if the planes are not packed.
+  std::uint32_t packed_size_;
 };
 
 /// View over an existing buffer representing a video frame encoded in ARGB
@@ -72,6 +124,198 @@ struct Argb32VideoFrame {
   /// Stride in bytes between two consecutive rows in the ARGB buffer.
   /// This is always greater than or equal to |width_|.
   std::int32_t stride_;
+
+  /// Capture timestamp of the frame, in microseconds, in the local monotonic
+  /// clock of |rtc::TimeMicros()|. For remote frames, this is the estimated
+  /// render time of the frame instead. This is ignored on input frames.
+  std::int64_t timestamp_us_;
+
+  /// Capture time of the frame, in milliseconds since the NTP epoch, in the
+  /// clock of the local peer, or zero if unknown. For remote frames, this is
+  /// the capture time on the remote peer, translated into the local clock once
+  /// an RTCP sender report was received. This is ignored on input frames.
+  std::int64_t ntp_time_ms_;
+
+  /// RTP timestamp of the frame, in 90 kHz units, or zero if the frame was not
+  /// sent or received over RTP. This is ignored on input frames.
+  std::uint32_t rtp_timestamp_;
+
+  /// Application metadata passed along with the frame by its sender in
+  /// |mrsExternalVideoFrameInfo|, or NULL if none. The data is only valid
+  /// during the callback delivering the frame. This is ignored on input
+  /// frames.
+  const void* metadata_;
+
+  /// Size of |metadata_|, in bytes, or zero if the frame has no metadata.
+  std::uint32_t metadata_size_;
+
+  /// Clockwise rotation to apply to the frame to display it upright, which
+  /// renderers can apply for free when sampling the frame. This is
+  /// |VideoRotation::k0| if the delivery options applied the rotation to the
+  /// pixels already. This is ignored on input frames.
+  VideoRotation rotation_;
+};
+
+/// View over an existing buffer representing a video frame encoded in NV12
+/// format, with a full-resolution Y plane followed by an interleaved UV plane
+/// with 2x2 chroma downsampling.
+struct Nv12VideoFrame {
+  /// Width of the video frame, in pixels.
+  std::uint32_t width_;
+
+  /// Height of the video frame, in pixels.
+  std::uint32_t height_;
+
+  /// Pointer to the raw contiguous memory block holding the Y plane data.
+  /// The size of the buffer is at least (|ystride_| * |height_|) bytes.
+  const void* ydata_;
+
+  /// Pointer to the raw contiguous memory block holding the interleaved UV
+  /// plane data. The size of the buffer is at least
+  /// (|uvstride_| * (|height_| + 1) / 2) bytes.
+  const void* uvdata_;
+
+  /// Stride in bytes between two consecutive rows in the Y plane buffer.
+  /// This is always greater than or equal to |width_|.
+  std::int32_t ystride_;
+
+  /// Stride in bytes between two consecutive rows in the UV plane buffer.
+  /// This is always greater than or equal to (2 * ((|width_| + 1) / 2)).
+  std::int32_t uvstride_;
+
+  /// Capture timestamp of the frame, in microseconds, in the local monotonic
+  /// clock of |rtc::TimeMicros()|. For remote frames, this is the estimated
+  /// render time of the frame instead. This is ignored on input frames.
+  std::int64_t timestamp_us_;
+
+  /// Capture time of the frame, in milliseconds since the NTP epoch, in the
+  /// clock of the local peer, or zero if unknown. For remote frames, this is
+  /// the capture time on the remote peer, translated into the local clock once
+  /// an RTCP sender report was received. This is ignored on input frames.
+  std::int64_t ntp_time_ms_;
+
+  /// RTP timestamp of the frame, in 90 kHz units, or zero if the frame was not
+  /// sent or received over RTP. This is ignored on input frames.
+  std::uint32_t rtp_timestamp_;
+
+  /// Application metadata passed along with the frame by its sender in
+  /// |mrsExternalVideoFrameInfo|, or NULL if none. The data is only valid
+  /// during the callback delivering the frame. This is ignored on input
+  /// frames.
+  const void* metadata_;
+
+  /// Size of |metadata_|, in bytes, or zero if the frame has no metadata.
+  std::uint32_t metadata_size_;
+
+  /// Clockwise rotation to apply to the frame to display it upright, which
+  /// renderers can apply for free when sampling the frame. This is
+  /// |VideoRotation::k0| if the delivery options applied the rotation to the
+  /// pixels already. This is ignored on input frames.
+  VideoRotation rotation_;
+};
+
+/// Options controlling the delivery of video frames to the frame callbacks
+/// producing a converted copy of the frame (I420A, ARGB32, NV12). Frame leases
+/// always deliver the original frame buffer, and ignore those options.
+struct VideoFrameDeliveryOptions {
+  /// Maximum width of the delivered frames, in pixels, or zero for no limit.
+  /// Larger frames are downscaled to fit, preserving their aspect ratio.
+  std::uint32_t max_width_;
+
+  /// Maximum height of the delivered frames, in pixels, or zero for no limit.
+  /// Larger frames are downscaled to fit, preserving their aspect ratio.
+  std::uint32_t max_height_;
+
+  /// Maximum delivery framerate, in frames per second, or zero for no limit.
+  /// Frames arriving faster are skipped before any conversion or scaling.
+  float max_framerate_;
+
+  /// Rotate the pixels of the delivered frames upright, after downscaling,
+  /// for consumers which cannot rotate the frames themselves. Otherwise the
+  /// frames are delivered as produced, with their rotation in |rotation_|.
+  bool apply_rotation_;
+
+  /// Deliver the I420A frames with their planes packed into a single buffer,
+  /// see |I420AVideoFrame::packed_data_|, for consumers uploading them with
+  /// a single copy. Packing copies the frame once, after any downscaling and
+  /// rotation. The ARGB32 and NV12 frames are not affected.
+  bool pack_planes_;
+
+  /// Alignment of the row strides of the packed planes, in bytes, for example
+  /// the row pitch alignment required by the staging resource. This must be
+  /// zero or a power of two no greater than 256. Zero packs the rows tightly,
+  /// with the strides equal to the width of the planes.
+  std::uint32_t packed_stride_alignment_;
+};
+
+/// Type of the buffer holding the data of a video frame. This mirrors the
+/// values of |webrtc::VideoFrameBuffer::Type|.
+enum class VideoFrameBufferType : std::int32_t {
+  /// Opaque buffer type specific to the platform or the source producing the
+  /// frame, typically a GPU texture or some other hardware surface. Its data
+  /// cannot be accessed directly through plane pointers.
+  kNative = 0,
+
+  /// 8-bit I420 triplanar YUV format, with 2x2 chroma downsampling.
+  kI420 = 1,
+
+  /// Same as |kI420|, with an extra 8-bit alpha plane of the size of the Y
+  /// plane.
+  kI420A = 2,
+
+  /// 8-bit I444 triplanar YUV format, without chroma downsampling.
+  kI444 = 3,
+
+  /// 10-bit I420 triplanar YUV format, where each sample is stored as a 16-bit
+  /// value.
+  kI010 = 4,
+};
+
+/// Lease over the buffer of a video frame, giving direct access to the buffer
+/// produced by the video source or decoder without any copy or conversion.
+///
+/// The lease holds a reference to the underlying buffer, which keeps the plane
+/// data alive even after the callback delivering the lease returned. The user
+/// must release that reference with |mrsVideoFrameBufferRemoveRef()| once done
+/// with the frame data, otherwise the buffer is leaked.
+struct VideoFrameLease {
+  /// Opaque handle to the leased frame buffer, used to release the lease.
+  void* buffer_handle_;
+
+  /// Type of the leased buffer, which determines which planes are available.
+  VideoFrameBufferType type_;
+
+  /// Width of the video frame, in pixels.
+  std::uint32_t width_;
+
+  /// Height of the video frame, in pixels.
+  std::uint32_t height_;
+
+  /// Pointer to the Y plane data, or NULL for |kNative| and |kI010| buffers.
+  const void* ydata_;
+
+  /// Pointer to the U plane data, or NULL for |kNative| and |kI010| buffers.
+  const void* udata_;
+
+  /// Pointer to the V plane data, or NULL for |kNative| and |kI010| buffers.
+  const void* vdata_;
+
+  /// Pointer to the alpha plane data, which is only available for |kI420A|
+  /// buffers. This is NULL for all other buffer types.
+  const void* adata_;
+
+  /// Stride in bytes between two consecutive rows in the Y plane buffer.
+  std::int32_t ystride_;
+
+  /// Stride in bytes between two consecutive rows in the U plane buffer.
+  std::int32_t ustride_;
+
+  /// Stride in bytes between two consecutive rows in the V plane buffer.
+  std::int32_t vstride_;
+
+  /// Stride in bytes between two consecutive rows in the A plane buffer, or
+  /// zero if there is no alpha plane.
+  std::int32_t astride_;
 };
 
 }  // namespace WebRTC
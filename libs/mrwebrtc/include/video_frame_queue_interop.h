@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+//
+// Video frame queue API
+//
+// A video frame queue collects the frames of a video track source or of a
+// remote video track without copying them, for the application to dequeue
+// them at its own pace, typically once per rendered frame, and upload their
+// planes directly to the GPU. See
+// |mrsVideoTrackSourceAddFrameQueueSubscriber()| and
+// |mrsRemoteVideoTrackAddFrameQueueSubscriber()|.
+//
+
+/// Statistics of a video frame queue.
+struct mrsVideoFrameQueueStats {
+  /// Number of frames enqueued since the queue was created.
+  uint64_t enqueued_count;
+
+  /// Number of frames dequeued since the queue was created.
+  uint64_t dequeued_count;
+
+  /// Number of frames dropped because the queue was full when a newer frame
+  /// arrived.
+  uint64_t dropped_count;
+
+  /// Number of frames currently in the queue.
+  uint32_t queued_count;
+
+  /// Percentiles of the time spent by the dequeued frames in the queue.
+  mrsVideoFrameLatencyStats queue_latency;
+};
+
+/// Create a video frame queue holding up to |depth| frames, between 1 and 16.
+/// Once full, a new frame replaces the oldest one. Use a depth of 1 to only
+/// ever get the latest frame. The queue must be destroyed with
+/// |mrsVideoFrameQueueDestroy()|.
+MRS_API mrsResult MRS_CALL
+mrsVideoFrameQueueCreate(uint32_t depth,
+                         mrsVideoFrameQueueHandle* queue_handle_out) noexcept;
+
+/// Destroy a video frame queue, releasing the frames not dequeued. The queue
+/// must first be removed from the frame subscribers it was added to.
+MRS_API void MRS_CALL
+mrsVideoFrameQueueDestroy(mrsVideoFrameQueueHandle queue_handle) noexcept;
+
+/// Dequeue the oldest frame of the queue. On success, |lease_out| holds a
+/// lease over the frame buffer, which exposes its planes; frames of native
+/// buffers are converted to I420 when enqueued. The caller must release the
+/// lease with |mrsVideoFrameBufferRemoveRef()|. If the queue is empty, this
+/// returns |mrsResult::kNotFound|.
+MRS_API mrsResult MRS_CALL
+mrsVideoFrameQueueTryDequeue(mrsVideoFrameQueueHandle queue_handle,
+                             mrsVideoFrameLease* lease_out) noexcept;
+
+/// Get the statistics of a video frame queue.
+MRS_API mrsResult MRS_CALL
+mrsVideoFrameQueueGetStats(mrsVideoFrameQueueHandle queue_handle,
+                           mrsVideoFrameQueueStats* stats_out) noexcept;
+
+}  // extern "C"
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+//
+// Video texture uploader API
+//
+// A video texture uploader writes the latest frame of a video frame queue
+// into GPU textures on the render thread of the application, without copying
+// the frame into managed memory first. In Unity, the render event of the
+// uploader is issued with |GL.IssuePluginEvent()| once per rendered frame, and
+// the textures are the native pointers of the Y, U, and V textures returned
+// by |Texture.GetNativeTexturePtr()|.
+//
+// With Direct3D 11, the uploader can instead convert the frames to RGBA into
+// a single texture, with a compute shader on the GPU of the texture. This
+// avoids both the conversion on the CPU and the conversion in the material of
+// the application. If the shader cannot run on the device, the frames are
+// converted on the CPU with libyuv and uploaded as RGBA.
+//
+
+/// Graphics API of the textures of a video texture uploader.
+enum class mrsVideoTextureApi : int32_t {
+  /// Direct3D 11, on Windows. The textures are |ID3D11Texture2D| pointers of
+  /// format |DXGI_FORMAT_R8_UNORM|, with a default usage.
+  kD3D11 = 0,
+
+  /// OpenGL ES 3, on Android. The textures are names of |GL_TEXTURE_2D|
+  /// textures of internal format |GL_R8|, cast to pointers.
+  kOpenGLES3 = 1,
+};
+
+/// Textures receiving the uploaded frames, either one texture per plane of the
+/// I420 frames, or a single RGBA texture. The alpha plane of I420A frames is
+/// not uploaded.
+struct mrsVideoTextures {
+  /// Texture receiving the Y plane, of size |width| x |height|.
+  void* y_texture;
+
+  /// Texture receiving the U plane, of size ((|width| + 1) / 2) x
+  /// ((|height| + 1) / 2).
+  void* u_texture;
+
+  /// Texture receiving the V plane, of the same size as |u_texture|.
+  void* v_texture;
+
+  /// Width of the frames uploaded, in pixels.
+  uint32_t width;
+
+  /// Height of the frames uploaded, in pixels.
+  uint32_t height;
+
+  /// Texture receiving the frames converted to RGBA, of size |width| x
+  /// |height|, in place of the plane textures which must then be NULL. Only
+  /// supported with Direct3D 11, for |ID3D11Texture2D| textures of format
+  /// |DXGI_FORMAT_R8G8B8A8_UNORM| or |DXGI_FORMAT_R8G8B8A8_TYPELESS|, with a
+  /// default usage. The colors are converted from BT.601 limited range, and
+  /// the alpha is opaque. The shader writes directly into textures created
+  /// with |D3D11_BIND_UNORDERED_ACCESS|, and into an intermediate texture
+  /// copied into the others. The texture can be created with
+  /// |D3D11_RESOURCE_MISC_SHARED| for another device to open it by handle,
+  /// the conversion being done on the device owning the texture.
+  void* rgba_texture;
+};
+
+/// Statistics of a video texture uploader.
+struct mrsVideoTextureUploaderStats {
+  /// Number of frames uploaded to the textures.
+  uint64_t uploaded_count;
+
+  /// Number of frames dequeued but not uploaded, either because newer frames
+  /// were dequeued by the same render event, or because their size did not
+  /// match the size of the textures.
+  uint64_t skipped_count;
+
+  /// Size of the last frame dequeued, in pixels, or zero if none was. The
+  /// application can compare it to the size of its textures to recreate them
+  /// when the resolution of the video changes.
+  uint32_t frame_width;
+  uint32_t frame_height;
+
+  /// Number of the frames uploaded to an RGBA texture which were converted on
+  /// the CPU, because the conversion shader is not available on the device of
+  /// the texture.
+  uint64_t cpu_converted_count;
+};
+
+/// Render event function of the video texture uploaders, with the signature
+/// of the callbacks of |GL.IssuePluginEvent()| in Unity.
+using mrsVideoTextureRenderEventCallback = void(MRS_CALL*)(int32_t event_id);
+
+/// Create a video texture uploader dequeuing frames from a video frame queue,
+/// which must outlive it, and uploading them to textures of the given graphics
+/// API. This returns |mrsResult::kUnsupported| if the graphics API is not
+/// supported on the current platform. The uploader must be destroyed with
+/// |mrsVideoTextureUploaderDestroy()|.
+MRS_API mrsResult MRS_CALL mrsVideoTextureUploaderCreate(
+    mrsVideoFrameQueueHandle queue_handle,
+    mrsVideoTextureApi api,
+    mrsVideoTextureUploaderHandle* uploader_handle_out) noexcept;
+
+/// Destroy a video texture uploader. Render events issued for the uploader but
+/// not executed yet are ignored. The textures must not be destroyed before
+/// the uploader, unless replaced with |mrsVideoTextureUploaderSetTextures()|.
+MRS_API void MRS_CALL mrsVideoTextureUploaderDestroy(
+    mrsVideoTextureUploaderHandle uploader_handle) noexcept;
+
+/// Set the textures receiving the frames, or NULL to stop uploading. This can
+/// be called from any thread; the textures are used by the next render event.
+/// This returns |mrsResult::kUnsupported| for an RGBA texture if the graphics
+/// API of the uploader is not Direct3D 11.
+MRS_API mrsResult MRS_CALL mrsVideoTextureUploaderSetTextures(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    const mrsVideoTextures* textures) noexcept;
+
+/// Get the render event function and the event identifier to issue on the
+/// render thread to upload the latest frame of the queue, if any, to the
+/// textures. On each event, the frames in the queue are dequeued, and only the
+/// latest one is uploaded.
+MRS_API mrsResult MRS_CALL mrsVideoTextureUploaderGetRenderEvent(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    mrsVideoTextureRenderEventCallback* callback_out,
+    int32_t* event_id_out) noexcept;
+
+/// Get the statistics of a video texture uploader.
+MRS_API mrsResult MRS_CALL mrsVideoTextureUploaderGetStats(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    mrsVideoTextureUploaderStats* stats_out) noexcept;
+
+}  // extern "C"
@@ -10,6 +10,13 @@ extern "C" {
 /// Register a custom callback to be called when the video track source produced
 /// a frame. The produced frame is passed to the registered callback in I420
 /// encoding.
+///
+/// Registering another callback, or nullptr to unregister, waits for the frame
+/// delivery in progress, so that once this returns the previous callback is
+/// never invoked again. The exception is a call from within a frame callback
+/// of the same source, which cannot wait for itself; the frame being
+/// delivered may then still invoke the previous callback. This applies to all
+/// the frame callback registration functions below.
 MRS_API void MRS_CALL mrsVideoTrackSourceRegisterFrameCallback(
     mrsVideoTrackSourceHandle source_handle,
     mrsI420AVideoFrameCallback callback,
@@ -23,4 +30,99 @@ MRS_API void MRS_CALL mrsVideoTrackSourceRegisterArgb32FrameCallback(
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept;
 
+/// Register a custom callback to be called when the video track source produced
+/// a frame. The produced frame is passed to the registered callback in NV12
+/// encoding.
+MRS_API void MRS_CALL mrsVideoTrackSourceRegisterNv12FrameCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the video track source produced
+/// a frame. The produced frame is passed to the registered callback as a lease
+/// over the original frame buffer, without any copy or conversion. The callee
+/// must release the lease with |mrsVideoFrameBufferRemoveRef()|.
+MRS_API void MRS_CALL mrsVideoTrackSourceRegisterFrameLeaseCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the video track source produced
+/// a frame. The produced frame is passed to the registered callback in ARGB32
+/// encoding, inside a pooled buffer the callee can check out. See
+/// |mrsArgb32VideoFrameLeaseCallback| for details.
+MRS_API void MRS_CALL mrsVideoTrackSourceRegisterArgb32FrameLeaseCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept;
+
+/// Set the number of pooled ARGB32 buffers used to deliver frames to the ARGB32
+/// callbacks, which is the maximum number of frames checked out at once. The
+/// default is a single buffer.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceSetArgb32BufferPoolSize(
+    mrsVideoTrackSourceHandle source_handle,
+    int pool_size) noexcept;
+
+/// Set the options for the delivery of frames to the I420A, ARGB32 and NV12
+/// callbacks, to downscale frames to a maximum size and skip frames above a
+/// maximum framerate. Frame lease callbacks are not affected.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceSetFrameDeliveryOptions(
+    mrsVideoTrackSourceHandle source_handle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept;
+
+/// Callback fired on the WebRTC worker thread once the frame sink of a video
+/// track source was updated asynchronously.
+using mrsVideoTrackSourceSinkUpdatedCallback = void(MRS_CALL*)(void* user_data);
+
+/// Enable or disable asynchronous sink updates for the video track source. The
+/// source delivers its frames to a sink, which is added to the source when the
+/// first frame callback or subscriber is registered, and removed with the last
+/// one, on the WebRTC worker thread. By default these calls block until the
+/// worker thread applied the change. With asynchronous updates, the change is
+/// posted to the worker thread instead, and the optional |callback| is invoked
+/// once applied. A new callback then receives the frames produced after the
+/// change is applied. An unregistered callback is never invoked again once the
+/// call returns, as with synchronous updates.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceSetAsyncSinkUpdates(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsBool enabled,
+    mrsVideoTrackSourceSinkUpdatedCallback callback,
+    void* user_data) noexcept;
+
+/// Add a subscriber receiving video frames as I420A-encoded, ARGB32-encoded or
+/// NV12-encoded buffers, in addition to any registered frame callback. Each
+/// frame is converted at most once per format, and all subscribers of a format
+/// share the same read-only frame data. On success, the new subscriber
+/// identifier is returned in |subscriber_id_out|, to later remove the
+/// subscriber with |mrsVideoTrackSourceRemoveFrameSubscriber()|.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceAddI420AFrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceAddArgb32FrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceAddNv12FrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept;
+
+/// Add a subscriber enqueuing the video frames into a video frame queue
+/// created with |mrsVideoFrameQueueCreate()|, without copying them. The
+/// subscriber must be removed before the queue is destroyed.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceAddFrameQueueSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsVideoFrameQueueHandle queue_handle,
+    uint64_t* subscriber_id_out) noexcept;
+
+/// Remove a frame subscriber previously added. Once this returns, the
+/// subscriber is never invoked again.
+MRS_API mrsResult MRS_CALL mrsVideoTrackSourceRemoveFrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    uint64_t subscriber_id) noexcept;
+
 }  // extern "C"
@@ -0,0 +1,593 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Scaling soak harness: create a number of locally connected peer connection
+// pairs sending audio, video, and data, hold them for some time, and report
+// the resource usage of the process and the quality of the connections as CSV.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <psapi.h>
+#include <tlhelp32.h>
+
+#include "../include/data_channel_interop.h"
+#include "../include/external_audio_track_source_interop.h"
+#include "../include/external_video_track_source_interop.h"
+#include "../include/local_audio_track_interop.h"
+#include "../include/local_video_track_interop.h"
+#include "../include/remote_video_track_interop.h"
+#include "../include/transceiver_interop.h"
+
+namespace {
+
+struct SoakOptions {
+  /// Number of peer connection pairs.
+  int pairs = 10;
+
+  /// Duration the pairs are held once all connected, in seconds.
+  int duration_s = 60;
+
+  /// Interval between two reports, in seconds.
+  int interval_s = 5;
+
+  /// Resolution of the test pattern sent by each video track.
+  int width = 320;
+  int height = 240;
+
+  bool audio = true;
+  bool video = true;
+  bool data = true;
+
+  /// Path of the CSV report, or empty to write it to the standard output.
+  std::string output;
+};
+
+void PrintUsage() {
+  std::fprintf(
+      stderr,
+      "Usage: mrwebrtc-win32-soak [options]\n"
+      "  --pairs=N        Number of peer connection pairs (default 10)\n"
+      "  --duration=S     Seconds to hold the pairs once connected (60)\n"
+      "  --interval=S     Seconds between two reports (5)\n"
+      "  --width=W        Width of the video test pattern (320)\n"
+      "  --height=H       Height of the video test pattern (240)\n"
+      "  --no-audio       Do not send audio\n"
+      "  --no-video       Do not send video\n"
+      "  --no-data        Do not send data channel messages\n"
+      "  --output=FILE    Write the CSV report to FILE instead of stdout\n");
+}
+
+bool ParseOptions(int argc, char** argv, SoakOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    const std::string name = arg.substr(0, eq);
+    const std::string value =
+        (eq != std::string::npos ? arg.substr(eq + 1) : std::string());
+    if (name == "--pairs") {
+      options.pairs = std::atoi(value.c_str());
+    } else if (name == "--duration") {
+      options.duration_s = std::atoi(value.c_str());
+    } else if (name == "--interval") {
+      options.interval_s = std::atoi(value.c_str());
+    } else if (name == "--width") {
+      options.width = std::atoi(value.c_str());
+    } else if (name == "--height") {
+      options.height = std::atoi(value.c_str());
+    } else if (name == "--no-audio") {
+      options.audio = false;
+    } else if (name == "--no-video") {
+      options.video = false;
+    } else if (name == "--no-data") {
+      options.data = false;
+    } else if (name == "--output") {
+      options.output = value;
+    } else {
+      return false;
+    }
+  }
+  return ((options.pairs > 0) && (options.duration_s >= 0) &&
+          (options.interval_s > 0) && (options.width >= 16) &&
+          (options.height >= 16) && (options.width % 2 == 0) &&
+          (options.height % 2 == 0));
+}
+
+/// Resource usage of the whole process.
+struct ProcessUsage {
+  double working_set_mb = 0.0;
+  double private_mb = 0.0;
+  int thread_count = 0;
+
+  /// CPU time used since the previous sample, in percent of one core.
+  double cpu_core_pct = 0.0;
+};
+
+class ProcessMonitor {
+ public:
+  ProcessMonitor() { Sample(); }
+
+  ProcessUsage Sample() {
+    ProcessUsage usage;
+    PROCESS_MEMORY_COUNTERS_EX memory{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(),
+                             (PROCESS_MEMORY_COUNTERS*)&memory,
+                             sizeof(memory))) {
+      usage.working_set_mb = memory.WorkingSetSize / (1024.0 * 1024.0);
+      usage.private_mb = memory.PrivateUsage / (1024.0 * 1024.0);
+    }
+    usage.thread_count = CountThreads();
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t cpu_time = GetCpuTime100ns();
+    const double wall_s =
+        std::chrono::duration<double>(now - last_sample_time_).count();
+    if (wall_s > 0.0) {
+      usage.cpu_core_pct = (cpu_time - last_cpu_time_) * 1e-7 / wall_s * 100.0;
+    }
+    last_sample_time_ = now;
+    last_cpu_time_ = cpu_time;
+    return usage;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last_sample_time_{};
+  uint64_t last_cpu_time_ = 0;
+
+  static int CountThreads() {
+    const DWORD pid = GetCurrentProcessId();
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+      return 0;
+    }
+    int count = 0;
+    THREADENTRY32 entry{};
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = Thread32First(snapshot, &entry); ok;
+         ok = Thread32Next(snapshot, &entry)) {
+      if (entry.th32OwnerProcessID == pid) {
+        ++count;
+      }
+    }
+    CloseHandle(snapshot);
+    return count;
+  }
+
+  static uint64_t GetCpuTime100ns() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+                         &user)) {
+      return 0;
+    }
+    auto to_u64 = [](const FILETIME& ft) {
+      return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    };
+    return to_u64(kernel) + to_u64(user);
+  }
+};
+
+/// Cumulative quality counters of the receiving peer of a pair, from its
+/// latest stats snapshot.
+struct ReceiveStats {
+  uint64_t video_frames_received = 0;
+  uint64_t video_frames_dropped = 0;
+  int64_t video_packets_lost = 0;
+  int64_t audio_packets_lost = 0;
+  double audio_jitter_s = 0.0;
+  double rtt_s = 0.0;
+  uint64_t data_messages_received = 0;
+
+  /// Latency of the video frames from their capture on the sender to their
+  /// delivery on the receiver, from their latency markers, since the previous
+  /// sample.
+  double video_latency_p50_ms = 0.0;
+  double video_latency_p99_ms = 0.0;
+
+  ReceiveStats& operator+=(const ReceiveStats& other) {
+    video_frames_received += other.video_frames_received;
+    video_frames_dropped += other.video_frames_dropped;
+    video_packets_lost += other.video_packets_lost;
+    audio_packets_lost += other.audio_packets_lost;
+    audio_jitter_s += other.audio_jitter_s;
+    rtt_s += other.rtt_s;
+    data_messages_received += other.data_messages_received;
+    video_latency_p50_ms += other.video_latency_p50_ms;
+    video_latency_p99_ms =
+        std::max(video_latency_p99_ms, other.video_latency_p99_ms);
+    return *this;
+  }
+};
+
+/// Pair of locally connected peers, with the first one sending a test pattern
+/// video track, an audio track, and data channel messages to the second one.
+class SoakPair {
+ public:
+  SoakPair(const SoakOptions& options) : options_(options) {}
+
+  ~SoakPair() {
+    if (pair_) {
+      mrsPeerConnectionSubscribeStats(pair_->pc2(), nullptr, nullptr, nullptr);
+      mrsPeerConnectionRegisterVideoTrackAddedCallback(pair_->pc2(), nullptr,
+                                                       nullptr);
+    }
+    if (video_track_) {
+      mrsRefCountedObjectRemoveRef(video_track_);
+    }
+    if (video_source_) {
+      mrsExternalVideoTrackSourceShutdown(video_source_);
+      mrsRefCountedObjectRemoveRef(video_source_);
+    }
+    if (audio_track_) {
+      mrsRefCountedObjectRemoveRef(audio_track_);
+    }
+    if (audio_source_) {
+      mrsRefCountedObjectRemoveRef(audio_source_);
+    }
+    pair_.reset();
+  }
+
+  /// Create the peers and their tracks, and connect them. Return the time it
+  /// took, in milliseconds, or a negative value on error.
+  double Setup() {
+    const auto start = std::chrono::steady_clock::now();
+    pair_ = std::make_unique<LocalPeerPairRaii>();
+    if (options_.video && !AddVideo()) {
+      return -1.0;
+    }
+    if (options_.audio && !AddAudio()) {
+      return -1.0;
+    }
+    if (options_.data) {
+      // Negotiated channel, which also forces SCTP to be negotiated.
+      mrsDataChannelConfig config{};
+      config.id = 0;
+      config.label = "soak";
+      config.flags = mrsDataChannelConfigFlags::kOrdered |
+                     mrsDataChannelConfigFlags::kReliable;
+      mrsDataChannelHandle receiver;
+      if ((mrsPeerConnectionAddDataChannel(pair_->pc1(), &config,
+                                           &data_channel_) !=
+           Result::kSuccess) ||
+          (mrsPeerConnectionAddDataChannel(pair_->pc2(), &config,
+                                           &receiver) != Result::kSuccess)) {
+        return -1.0;
+      }
+    }
+    pair_->ConnectAndWait();
+    const double setup_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+
+    mrsStatsSubscriptionConfig stats_config{};
+    stats_config.interval_ms = options_.interval_s * 1000;
+    if (mrsPeerConnectionSubscribeStats(pair_->pc2(), &stats_config,
+                                        &StaticStatsCallback,
+                                        this) != Result::kSuccess) {
+      return -1.0;
+    }
+    return setup_ms;
+  }
+
+  /// Push the next samples of the test tone, and send a data channel message.
+  void Tick(const std::vector<int16_t>& tone) {
+    if (audio_source_) {
+      uint32_t frames_pushed = 0;
+      mrsExternalAudioTrackSourcePushAudio(
+          audio_source_, tone.data(), (uint32_t)tone.size(), &frames_pushed);
+    }
+    if (data_channel_) {
+      uint8_t message[64]{};
+      std::memcpy(message, &tick_count_, sizeof(tick_count_));
+      mrsDataChannelSendMessage(data_channel_, message, sizeof(message));
+    }
+    ++tick_count_;
+  }
+
+  /// Get the latest receive stats, and reset the video latency measured.
+  ReceiveStats GetReceiveStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ReceiveStats stats = receive_stats_;
+    mrsVideoLatencyMarkerStats marker_stats{};
+    if (remote_video_track_ &&
+        (mrsRemoteVideoTrackGetLatencyMarkerStats(
+             remote_video_track_, &marker_stats) == Result::kSuccess)) {
+      stats.video_latency_p50_ms = marker_stats.latency.p50_ms;
+      stats.video_latency_p99_ms = marker_stats.latency.p99_ms;
+      mrsRemoteVideoTrackResetLatencyStats(remote_video_track_);
+    }
+    return stats;
+  }
+
+ private:
+  const SoakOptions& options_;
+  std::unique_ptr<LocalPeerPairRaii> pair_;
+  mrsExternalVideoTrackSourceHandle video_source_{};
+  mrsLocalVideoTrackHandle video_track_{};
+  mrsExternalAudioTrackSourceHandle audio_source_{};
+  mrsLocalAudioTrackHandle audio_track_{};
+  mrsDataChannelHandle data_channel_{};
+  uint64_t tick_count_ = 0;
+
+  // Test pattern, with a vertical bar moving by one column per frame so that
+  // the encoder keeps some work to do.
+  std::vector<uint8_t> y_plane_;
+  std::vector<uint8_t> uv_plane_;
+  int frame_count_ = 0;
+
+  std::mutex stats_mutex_;
+  ReceiveStats receive_stats_;
+  mrsRemoteVideoTrackHandle remote_video_track_{};
+
+  bool AddVideo() {
+    y_plane_.resize((size_t)options_.width * options_.height);
+    uv_plane_.assign((size_t)options_.width * options_.height / 4, 0x80);
+    if (mrsExternalVideoTrackSourceCreateFromI420ACallback(
+            &StaticFrameCallback, this, &video_source_) != Result::kSuccess) {
+      return false;
+    }
+    // Stamp latency markers into the frames, for the receiver to measure the
+    // latency of the frames under load.
+    mrsExternalVideoTrackSourceSetLatencyMarkers(video_source_, mrsBool::kTrue);
+    mrsPeerConnectionRegisterVideoTrackAddedCallback(
+        pair_->pc2(), &StaticVideoTrackAddedCallback, this);
+    mrsExternalVideoTrackSourceFinishCreation(video_source_);
+    mrsLocalVideoTrackInitSettings settings{};
+    mrsTransceiverInitConfig config{};
+    config.media_kind = mrsMediaKind::kVideo;
+    mrsTransceiverHandle transceiver;
+    return ((mrsLocalVideoTrackCreateFromSource(&settings, video_source_,
+                                                &video_track_) ==
+             Result::kSuccess) &&
+            (mrsPeerConnectionAddTransceiver(pair_->pc1(), &config,
+                                             &transceiver) ==
+             Result::kSuccess) &&
+            (mrsTransceiverSetLocalVideoTrack(transceiver, video_track_) ==
+             Result::kSuccess));
+  }
+
+  bool AddAudio() {
+    mrsExternalAudioTrackSourceSettings source_settings{};
+    if (mrsExternalAudioTrackSourceCreate(&source_settings, &audio_source_) !=
+        Result::kSuccess) {
+      return false;
+    }
+    mrsLocalAudioTrackInitSettings settings{};
+    mrsTransceiverInitConfig config{};
+    config.media_kind = mrsMediaKind::kAudio;
+    mrsTransceiverHandle transceiver;
+    return ((mrsLocalAudioTrackCreateFromSource(&settings, audio_source_,
+                                                &audio_track_) ==
+             Result::kSuccess) &&
+            (mrsPeerConnectionAddTransceiver(pair_->pc1(), &config,
+                                             &transceiver) ==
+             Result::kSuccess) &&
+            (mrsTransceiverSetLocalAudioTrack(transceiver, audio_track_) ==
+             Result::kSuccess));
+  }
+
+  static mrsResult MRS_CALL
+  StaticFrameCallback(void* user_data,
+                      mrsExternalVideoTrackSourceHandle source_handle,
+                      uint32_t request_id,
+                      int64_t timestamp_ms) {
+    auto self = static_cast<SoakPair*>(user_data);
+    const int width = self->options_.width;
+    const int height = self->options_.height;
+    const int bar = (self->frame_count_++ * 2) % width;
+    for (int j = 0; j < height; ++j) {
+      uint8_t* row = self->y_plane_.data() + (size_t)j * width;
+      std::memset(row, 0x40, width);
+      std::memset(row + bar, 0xC0, std::min(16, width - bar));
+    }
+    mrsI420AVideoFrame frame{};
+    frame.width_ = width;
+    frame.height_ = height;
+    frame.ydata_ = self->y_plane_.data();
+    frame.udata_ = self->uv_plane_.data();
+    frame.vdata_ = self->uv_plane_.data();
+    frame.ystride_ = width;
+    frame.ustride_ = width / 2;
+    frame.vstride_ = width / 2;
+    return mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
+        source_handle, request_id, timestamp_ms, &frame);
+  }
+
+  static void MRS_CALL
+  StaticVideoTrackAddedCallback(void* user_data,
+                                const mrsRemoteVideoTrackAddedInfo* info) {
+    mrsRemoteVideoTrackSetLatencyMarkerDecoding(info->track_handle,
+                                                mrsBool::kTrue);
+    auto self = static_cast<SoakPair*>(user_data);
+    std::lock_guard<std::mutex> lock(self->stats_mutex_);
+    self->remote_video_track_ = info->track_handle;
+  }
+
+  static void MRS_CALL StaticStatsCallback(void* user_data,
+                                           const mrsStatsEntry* entries,
+                                           uint32_t entry_count) {
+    ReceiveStats stats;
+    for (uint32_t i = 0; i < entry_count; ++i) {
+      const mrsStatsEntry& entry = entries[i];
+      switch (entry.kind) {
+        case mrsStatsEntryKind::kVideoReceiver:
+          stats.video_frames_received += entry.video_receiver.frames_received;
+          stats.video_frames_dropped += entry.video_receiver.frames_dropped;
+          stats.video_packets_lost += entry.video_receiver.packets_lost;
+          break;
+        case mrsStatsEntryKind::kAudioReceiver:
+          stats.audio_packets_lost += entry.audio_receiver.packets_lost;
+          stats.audio_jitter_s =
+              std::max(stats.audio_jitter_s, entry.audio_receiver.jitter);
+          break;
+        case mrsStatsEntryKind::kTransport:
+          stats.rtt_s =
+              std::max(stats.rtt_s, entry.transport.current_round_trip_time);
+          break;
+        case mrsStatsEntryKind::kDataChannel:
+          stats.data_messages_received +=
+              entry.data_channel.messages_received;
+          break;
+        default:
+          break;
+      }
+    }
+    auto self = static_cast<SoakPair*>(user_data);
+    std::lock_guard<std::mutex> lock(self->stats_mutex_);
+    self->receive_stats_ = stats;
+  }
+};
+
+/// Writer of the CSV report, one row per sample.
+class SoakReport {
+ public:
+  explicit SoakReport(FILE* file) : file_(file) {
+    std::fprintf(file_,
+                 "phase,elapsed_s,pairs,setup_ms,working_set_mb,private_mb,"
+                 "mb_per_pair,threads,threads_per_pair,cpu_core_pct,"
+                 "cpu_pct_per_pair,video_fps_per_pair,video_frames_dropped,"
+                 "video_packets_lost,audio_packets_lost,audio_jitter_ms,rtt_ms,"
+                 "data_messages_per_s,video_latency_ms,video_latency_p99_ms\n");
+    baseline_ = monitor_.Sample();
+    start_ = std::chrono::steady_clock::now();
+    last_sample_ = start_;
+    WriteRow("baseline", {}, 0.0, {});
+  }
+
+  /// Write a row for the given pairs, with the time it took to set up the
+  /// last one, if any.
+  void Sample(const char* phase,
+              const std::vector<std::unique_ptr<SoakPair>>& pairs,
+              double setup_ms) {
+    ReceiveStats total;
+    for (auto&& pair : pairs) {
+      total += pair->GetReceiveStats();
+    }
+    WriteRow(phase, pairs, setup_ms, total);
+  }
+
+ private:
+  FILE* const file_;
+  ProcessMonitor monitor_;
+  ProcessUsage baseline_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::time_point last_sample_;
+  ReceiveStats last_total_;
+
+  void WriteRow(const char* phase,
+                const std::vector<std::unique_ptr<SoakPair>>& pairs,
+                double setup_ms,
+                const ReceiveStats& total) {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed_s =
+        std::chrono::duration<double>(now - start_).count();
+    const double interval_s =
+        std::max(std::chrono::duration<double>(now - last_sample_).count(),
+                 1e-3);
+    const ProcessUsage usage = monitor_.Sample();
+    const double count = (double)std::max<size_t>(pairs.size(), 1);
+    std::fprintf(
+        file_,
+        "%s,%.1f,%zu,%.1f,%.1f,%.1f,%.2f,%d,%.2f,%.1f,%.2f,%.1f,%llu,%lld,"
+        "%lld,%.2f,%.2f,%.1f,%.1f,%.1f\n",
+        phase, elapsed_s, pairs.size(), setup_ms, usage.working_set_mb,
+        usage.private_mb,
+        (usage.private_mb - baseline_.private_mb) / count,
+        usage.thread_count,
+        (usage.thread_count - baseline_.thread_count) / count,
+        usage.cpu_core_pct, usage.cpu_core_pct / count,
+        (total.video_frames_received - last_total_.video_frames_received) /
+            interval_s / count,
+        (unsigned long long)total.video_frames_dropped,
+        (long long)total.video_packets_lost,
+        (long long)total.audio_packets_lost,
+        total.audio_jitter_s * 1000.0 / count, total.rtt_s * 1000.0 / count,
+        (total.data_messages_received - last_total_.data_messages_received) /
+            interval_s,
+        total.video_latency_p50_ms / count, total.video_latency_p99_ms);
+    std::fflush(file_);
+    last_sample_ = now;
+    last_total_ = total;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  SoakOptions options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+  FILE* file = stdout;
+  if (!options.output.empty()) {
+    file = std::fopen(options.output.c_str(), "w");
+    if (!file) {
+      std::fprintf(stderr, "Cannot open %s\n", options.output.c_str());
+      return 1;
+    }
+  }
+
+  // Only send the external audio, without opening any audio device.
+  mrsAudioDeviceModuleConfig adm_config{};
+  adm_config.audio_layer = mrsAudioDeviceLayer::kDummy;
+  mrsSetAudioDeviceModuleConfig(&adm_config);
+
+  // 100 ms of a 440 Hz tone at the default 48 kHz mono of the audio sources,
+  // pushed on each tick.
+  constexpr auto kTickPeriod = 100ms;
+  std::vector<int16_t> tone(4800);
+  for (size_t i = 0; i < tone.size(); ++i) {
+    tone[i] = (int16_t)(4000.0 * std::sin(2.0 * 3.14159265 * 440.0 * i /
+                                          48000.0));
+  }
+
+  int exit_code = 0;
+  {
+    SoakReport report(file);
+    std::vector<std::unique_ptr<SoakPair>> pairs;
+    pairs.reserve(options.pairs);
+
+    // Set up the pairs one at a time, to measure the setup time of each.
+    for (int i = 0; i < options.pairs; ++i) {
+      pairs.push_back(std::make_unique<SoakPair>(options));
+      const double setup_ms = pairs.back()->Setup();
+      if (setup_ms < 0.0) {
+        std::fprintf(stderr, "Failed to set up pair #%d\n", i);
+        exit_code = 1;
+        break;
+      }
+      report.Sample("setup", pairs, setup_ms);
+    }
+
+    // Hold the pairs, sending audio and data, and reporting periodically.
+    if (exit_code == 0) {
+      const auto start = std::chrono::steady_clock::now();
+      const auto end = start + std::chrono::seconds(options.duration_s);
+      auto next_report = start + std::chrono::seconds(options.interval_s);
+      for (auto tick = start; tick < end; tick += kTickPeriod) {
+        std::this_thread::sleep_until(tick);
+        for (auto&& pair : pairs) {
+          pair->Tick(tone);
+        }
+        if (tick >= next_report) {
+          report.Sample("soak", pairs, 0.0);
+          next_report += std::chrono::seconds(options.interval_s);
+        }
+      }
+    }
+    pairs.clear();
+    report.Sample("teardown", pairs, 0.0);
+  }
+
+  if (file != stdout) {
+    std::fclose(file);
+  }
+  return exit_code;
+}
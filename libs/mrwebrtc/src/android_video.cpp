@@ -0,0 +1,238 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "android_video.h"
+
+#if defined(MR_SHARING_ANDROID)
+
+#include <mutex>
+
+#include "sdk/android/native_api/codecs/wrapper.h"
+#include "sdk/android/native_api/jni/class_loader.h"
+#include "sdk/android/native_api/jni/jvm.h"
+#include "sdk/android/native_api/video/videosource.h"
+#include "sdk/android/native_api/video/wrapper.h"
+
+#include "encoded_frame_relay.h"
+#include "interop/global_factory.h"
+#include "media/native_video_frame_buffer.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// JNI global references to the Java video codec factories, if any.
+std::mutex g_codec_factories_mutex;
+jobject g_j_encoder_factory RTC_GUARDED_BY(g_codec_factories_mutex) = nullptr;
+jobject g_j_decoder_factory RTC_GUARDED_BY(g_codec_factories_mutex) = nullptr;
+
+void* MRS_CALL CreateEncoderFactory(void* /*user_data*/) {
+  std::lock_guard<std::mutex> lock(g_codec_factories_mutex);
+  if (!g_j_encoder_factory) {
+    return nullptr;
+  }
+  return webrtc::JavaToNativeVideoEncoderFactory(
+             webrtc::AttachCurrentThreadIfNeeded(), g_j_encoder_factory)
+      .release();
+}
+
+void* MRS_CALL CreateDecoderFactory(void* /*user_data*/) {
+  std::lock_guard<std::mutex> lock(g_codec_factories_mutex);
+  if (!g_j_decoder_factory) {
+    return nullptr;
+  }
+  return webrtc::JavaToNativeVideoDecoderFactory(
+             webrtc::AttachCurrentThreadIfNeeded(), g_j_decoder_factory)
+      .release();
+}
+
+/// Replace a JNI global reference with a new one to |j_object|, if not NULL.
+void ResetGlobalRef(JNIEnv* env, jobject& ref, void* j_object) {
+  if (ref) {
+    env->DeleteGlobalRef(ref);
+  }
+  ref = (j_object ? env->NewGlobalRef(static_cast<jobject>(j_object))
+                  : nullptr);
+}
+
+/// Clear any pending Java exception, and return whether there was one.
+bool ClearException(JNIEnv* env, const char* method) {
+  if (!env->ExceptionCheck()) {
+    return false;
+  }
+  RTC_LOG(LS_ERROR) << "Java exception calling " << method;
+  env->ExceptionDescribe();
+  env->ExceptionClear();
+  return true;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result SetAndroidVideoCodecFactories(void* j_encoder_factory,
+                                     void* j_decoder_factory) noexcept {
+  const bool has_factories = (j_encoder_factory || j_decoder_factory);
+  const Result result = GlobalFactory::SetVideoCodecFactories(
+      {has_factories ? &CreateEncoderFactory : nullptr, nullptr},
+      {has_factories ? &CreateDecoderFactory : nullptr, nullptr});
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  JNIEnv* const env = webrtc::AttachCurrentThreadIfNeeded();
+  std::lock_guard<std::mutex> lock(g_codec_factories_mutex);
+  ResetGlobalRef(env, g_j_encoder_factory, j_encoder_factory);
+  ResetGlobalRef(env, g_j_decoder_factory, j_decoder_factory);
+  return Result::kSuccess;
+}
+
+ErrorOr<rtc::scoped_refptr<webrtc::VideoTrackSourceInterface>>
+CreateAndroidCapturerSource(bool is_screencast,
+                            void** j_capturer_observer_out) noexcept {
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  if (!global_factory->GetPeerConnectionFactory()) {
+    return Error(Result::kInvalidOperation);
+  }
+  JNIEnv* const env = webrtc::AttachCurrentThreadIfNeeded();
+  rtc::scoped_refptr<webrtc::JavaVideoTrackSourceInterface> source =
+      webrtc::CreateJavaVideoSource(
+          env, global_factory->GetSignalingThread(), is_screencast);
+  if (!source) {
+    return Error(Result::kUnknownError);
+  }
+  webrtc::ScopedJavaLocalRef<jobject> j_observer =
+      source->GetJavaVideoCapturerObserver(env);
+  *j_capturer_observer_out = env->NewGlobalRef(j_observer.obj());
+  return rtc::scoped_refptr<webrtc::VideoTrackSourceInterface>(
+      std::move(source));
+}
+
+Result GetAndroidTexture(webrtc::VideoFrameBuffer* buffer,
+                         mrsAndroidTextureFrame& texture_out) noexcept {
+  // Only the buffers of the Java sources and codecs wrap a Java buffer, and
+  // converting any other |kNative| buffer to Java would crash.
+  const webrtc::VideoFrame frame(buffer, webrtc::kVideoRotation_0, 0);
+  if ((buffer->type() != webrtc::VideoFrameBuffer::Type::kNative) ||
+      NativeVideoFrameBuffer::IsInstance(buffer) ||
+      EncodedVideoFrameBuffer::FromFrame(frame)) {
+    return Result::kUnsupported;
+  }
+  JNIEnv* const env = webrtc::AttachCurrentThreadIfNeeded();
+  webrtc::ScopedJavaLocalRef<jclass> frame_class =
+      webrtc::GetClass(env, "org/webrtc/VideoFrame");
+  webrtc::ScopedJavaLocalRef<jclass> texture_class =
+      webrtc::GetClass(env, "org/webrtc/VideoFrame$TextureBuffer");
+  webrtc::ScopedJavaLocalRef<jclass> type_class =
+      webrtc::GetClass(env, "org/webrtc/VideoFrame$TextureBuffer$Type");
+  webrtc::ScopedJavaLocalRef<jclass> renderer_class =
+      webrtc::GetClass(env, "org/webrtc/RendererCommon");
+
+  // Wrapping the buffer in a Java frame retains the Java buffer, until the
+  // frame is released below.
+  webrtc::ScopedJavaLocalRef<jobject> j_frame =
+      webrtc::NativeToJavaVideoFrame(env, frame);
+  auto query_texture = [&]() {
+    webrtc::ScopedJavaLocalRef<jobject> j_buffer(
+        env, env->CallObjectMethod(
+                 j_frame.obj(),
+                 env->GetMethodID(frame_class.obj(), "getBuffer",
+                                  "()Lorg/webrtc/VideoFrame$Buffer;")));
+    if (ClearException(env, "VideoFrame.getBuffer()")) {
+      return Result::kUnknownError;
+    }
+    if (!env->IsInstanceOf(j_buffer.obj(), texture_class.obj())) {
+      // Java I420 buffer, for example from a software decoder
+      return Result::kUnsupported;
+    }
+    const jint texture_id = env->CallIntMethod(
+        j_buffer.obj(),
+        env->GetMethodID(texture_class.obj(), "getTextureId", "()I"));
+    if (ClearException(env, "TextureBuffer.getTextureId()")) {
+      return Result::kUnknownError;
+    }
+    webrtc::ScopedJavaLocalRef<jobject> j_type(
+        env, env->CallObjectMethod(
+                 j_buffer.obj(),
+                 env->GetMethodID(
+                     texture_class.obj(), "getType",
+                     "()Lorg/webrtc/VideoFrame$TextureBuffer$Type;")));
+    if (ClearException(env, "TextureBuffer.getType()")) {
+      return Result::kUnknownError;
+    }
+    const jint gl_target = env->CallIntMethod(
+        j_type.obj(),
+        env->GetMethodID(type_class.obj(), "getGlTarget", "()I"));
+    if (ClearException(env, "TextureBuffer.Type.getGlTarget()")) {
+      return Result::kUnknownError;
+    }
+    webrtc::ScopedJavaLocalRef<jobject> j_matrix(
+        env, env->CallObjectMethod(
+                 j_buffer.obj(),
+                 env->GetMethodID(texture_class.obj(), "getTransformMatrix",
+                                  "()Landroid/graphics/Matrix;")));
+    if (ClearException(env, "TextureBuffer.getTransformMatrix()")) {
+      return Result::kUnknownError;
+    }
+    webrtc::ScopedJavaLocalRef<jfloatArray> j_values(
+        env, static_cast<jfloatArray>(env->CallStaticObjectMethod(
+                 renderer_class.obj(),
+                 env->GetStaticMethodID(
+                     renderer_class.obj(),
+                     "convertMatrixFromAndroidGraphicsMatrix",
+                     "(Landroid/graphics/Matrix;)[F"),
+                 j_matrix.obj())));
+    if (ClearException(env, "RendererCommon.convertMatrix()")) {
+      return Result::kUnknownError;
+    }
+    env->GetFloatArrayRegion(j_values.obj(), 0, 16,
+                             texture_out.transform_matrix);
+    texture_out.texture_id = (uint32_t)texture_id;
+    texture_out.gl_target = (uint32_t)gl_target;
+    texture_out.width = (uint32_t)buffer->width();
+    texture_out.height = (uint32_t)buffer->height();
+    return Result::kSuccess;
+  };
+  const Result result = query_texture();
+  env->CallVoidMethod(j_frame.obj(),
+                      env->GetMethodID(frame_class.obj(), "release", "()V"));
+  ClearException(env, "VideoFrame.release()");
+  return result;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#else  // defined(MR_SHARING_ANDROID)
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result SetAndroidVideoCodecFactories(void* /*j_encoder_factory*/,
+                                     void* /*j_decoder_factory*/) noexcept {
+  return Result::kUnsupported;
+}
+
+ErrorOr<rtc::scoped_refptr<webrtc::VideoTrackSourceInterface>>
+CreateAndroidCapturerSource(bool /*is_screencast*/,
+                            void** /*j_capturer_observer_out*/) noexcept {
+  return Error(Result::kUnsupported);
+}
+
+Result GetAndroidTexture(webrtc::VideoFrameBuffer* /*buffer*/,
+                         mrsAndroidTextureFrame& /*texture_out*/) noexcept {
+  return Result::kUnsupported;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#endif  // defined(MR_SHARING_ANDROID)
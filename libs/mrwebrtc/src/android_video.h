@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "api/mediastreaminterface.h"
+#include "api/video/video_frame_buffer.h"
+
+#include "interop_api.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Use the Java video codec factories |j_encoder_factory| and
+/// |j_decoder_factory|, typically |org.webrtc.DefaultVideoEncoderFactory| and
+/// |org.webrtc.DefaultVideoDecoderFactory|, or NULL for the built-in codecs
+/// only. The factories are referenced until replaced. This returns
+/// |Result::kUnsupported| on platforms other than Android.
+Result SetAndroidVideoCodecFactories(void* j_encoder_factory,
+                                     void* j_decoder_factory) noexcept;
+
+/// Create a video source fed by a Java |org.webrtc.VideoCapturer|, and return
+/// in |j_capturer_observer_out| a JNI global reference to the Java
+/// |org.webrtc.CapturerObserver| to initialize the capturer with. This returns
+/// |Result::kUnsupported| on platforms other than Android.
+ErrorOr<rtc::scoped_refptr<webrtc::VideoTrackSourceInterface>>
+CreateAndroidCapturerSource(bool is_screencast,
+                            void** j_capturer_observer_out) noexcept;
+
+/// Get the OpenGL ES texture of a frame buffer wrapping a Java
+/// |org.webrtc.VideoFrame.TextureBuffer|. This returns |Result::kUnsupported|
+/// for any other buffer, and on platforms other than Android.
+Result GetAndroidTexture(webrtc::VideoFrameBuffer* buffer,
+                         mrsAndroidTextureFrame& texture_out) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,861 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "audio_conversion.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#define MRS_AUDIO_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function, and selects them at runtime.
+#define MRS_TARGET_AVX2
+#else
+#define MRS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define MRS_AUDIO_NEON 1
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define MRS_AUDIO_NEON_A64 1
+#endif
+#if defined(_MSC_VER) && defined(_M_ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace {
+
+constexpr const float kS16ToF32 = 1.0f / 32768.0f;
+constexpr const float kF32ToS16 = 32768.0f;
+
+using Microsoft::MixedReality::WebRTC::detail::AudioKernelLevel;
+
+#if defined(MRS_AUDIO_X86)
+/// Check whether the CPU and the OS support AVX2. This queries the CPU
+/// directly rather than through libyuv, so that the kernels do not depend on
+/// WebRTC and build into the tests as is.
+bool HasAvx2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 0);
+  if (regs[0] < 7) {
+    return false;
+  }
+  // The OS must save the YMM registers on context switches
+  __cpuid(regs, 1);
+  const bool has_osxsave = ((regs[2] & (1 << 27)) != 0);
+  const bool has_avx = ((regs[2] & (1 << 28)) != 0);
+  if (!has_osxsave || !has_avx || ((_xgetbv(0) & 0x6) != 0x6)) {
+    return false;
+  }
+  __cpuidex(regs, 7, 0);
+  return ((regs[1] & (1 << 5)) != 0);
+#else
+  return (__builtin_cpu_supports("avx2") != 0);
+#endif
+}
+#endif
+
+AudioKernelLevel GetCpuKernelLevel() noexcept {
+#if defined(MRS_AUDIO_X86)
+  // SSE2 is part of the x64 baseline, and required by WebRTC on x86.
+  return (HasAvx2() ? AudioKernelLevel::kAvx2 : AudioKernelLevel::kSimd);
+#elif defined(MRS_AUDIO_NEON)
+  return AudioKernelLevel::kSimd;
+#else
+  return AudioKernelLevel::kScalar;
+#endif
+}
+
+/// Version of the kernels in use, the fastest one by default.
+AudioKernelLevel g_kernel_level = GetCpuKernelLevel();
+
+//
+// Scalar versions, also used for the tail of vectorized loops.
+//
+
+void ConvertU8ToS16Scalar(const uint8_t* src, int16_t* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = (int16_t)(((int)src[i] - 128) * 256);
+  }
+}
+
+void ConvertS16ToF32Scalar(const int16_t* src, float* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = (float)src[i] * kS16ToF32;
+  }
+}
+
+void ConvertF32ToS16Scalar(const float* src, int16_t* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    const float value =
+        std::min(std::max(src[i] * kF32ToS16, -32768.0f), 32767.0f);
+    dst[i] = (int16_t)std::nearbyint(value);
+  }
+}
+
+void DownmixStereoToMonoS16Scalar(const int16_t* src,
+                                  int16_t* dst,
+                                  size_t frame_count) {
+  for (size_t i = 0; i < frame_count; ++i) {
+    dst[i] = (int16_t)(((int)src[2 * i] + (int)src[2 * i + 1]) >> 1);
+  }
+}
+
+void UpmixMonoS16ToStereoF32Scalar(const int16_t* src,
+                                   float* dst,
+                                   size_t frame_count) {
+  for (size_t i = 0; i < frame_count; ++i) {
+    const float value = (float)src[i] * kS16ToF32;
+    dst[2 * i] = value;
+    dst[2 * i + 1] = value;
+  }
+}
+
+void MeasureLevelS16Scalar(const int16_t* src,
+                           size_t count,
+                           uint64_t* sum_of_squares,
+                           int* peak) {
+  uint64_t sum = 0;
+  int max_abs = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const int value = src[i];
+    sum += (uint64_t)(value * value);
+    max_abs = std::max(max_abs, std::abs(value));
+  }
+  *sum_of_squares += sum;
+  *peak = std::max(*peak, max_abs);
+}
+
+void MixAccumulateF32Scalar(const float* src,
+                            float gain,
+                            float* dst,
+                            size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] += src[i] * gain;
+  }
+}
+
+int16_t RoundToS16(float value) {
+  return (int16_t)std::nearbyint(
+      std::min(std::max(value, -32768.0f), 32767.0f));
+}
+
+// The ramps compute the gain of each frame from its index rather than
+// accumulating steps, so that all versions produce identical results.
+
+void ScaleS16RampScalar(const int16_t* src,
+                        int16_t* dst,
+                        size_t begin,
+                        size_t frame_count,
+                        int channels,
+                        const float* gain,
+                        const float* step) {
+  for (size_t i = begin; i < frame_count; ++i) {
+    for (int c = 0; c < channels; ++c) {
+      const float g = gain[c] + step[c] * (float)i;
+      dst[i * channels + c] = RoundToS16((float)src[i * channels + c] * g);
+    }
+  }
+}
+
+void UpmixMonoS16ToStereoS16RampScalar(const int16_t* src,
+                                       int16_t* dst,
+                                       size_t begin,
+                                       size_t frame_count,
+                                       const float* gain,
+                                       const float* step) {
+  for (size_t i = begin; i < frame_count; ++i) {
+    const float value = (float)src[i];
+    dst[2 * i] = RoundToS16(value * (gain[0] + step[0] * (float)i));
+    dst[2 * i + 1] = RoundToS16(value * (gain[1] + step[1] * (float)i));
+  }
+}
+
+#if defined(MRS_AUDIO_X86)
+
+//
+// SSE2 versions
+//
+
+size_t ConvertU8ToS16Sse2(const uint8_t* src, int16_t* dst, size_t count) {
+  const __m128i bias = _mm_set1_epi8((char)0x80);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    // (x - 128) * 256 is (x ^ 0x80) in the high byte of a 16-bit lane
+    const __m128i v = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bias);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_unpacklo_epi8(zero, v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8),
+                     _mm_unpackhi_epi8(zero, v));
+  }
+  return i;
+}
+
+size_t ConvertS16ToF32Sse2(const int16_t* src, float* dst, size_t count) {
+  const __m128 scale = _mm_set1_ps(kS16ToF32);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign-extend to 32 bits by unpacking into the high half, then shifting
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+  return i;
+}
+
+size_t ConvertF32ToS16Sse2(const float* src, int16_t* dst, size_t count) {
+  const __m128 scale = _mm_set1_ps(kF32ToS16);
+  const __m128 min_value = _mm_set1_ps(-32768.0f);
+  const __m128 max_value = _mm_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Clamp before converting, since out-of-range conversions are undefined
+    const __m128 lo = _mm_min_ps(
+        _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), min_value),
+        max_value);
+    const __m128 hi = _mm_min_ps(
+        _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), min_value),
+        max_value);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+  }
+  return i;
+}
+
+size_t DownmixStereoToMonoS16Sse2(const int16_t* src,
+                                  int16_t* dst,
+                                  size_t frame_count) {
+  size_t i = 0;
+  for (; i + 8 <= frame_count; i += 8) {
+    // Both loads happen before the store, and the store never reaches past
+    // the loaded samples, so this is safe in place.
+    const __m128i v0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+    const __m128i v1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8));
+    // Each 32-bit lane holds one L/R pair; sign-extend each half
+    const __m128i left0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+    const __m128i right0 = _mm_srai_epi32(v0, 16);
+    const __m128i left1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+    const __m128i right1 = _mm_srai_epi32(v1, 16);
+    const __m128i mono0 = _mm_srai_epi32(_mm_add_epi32(left0, right0), 1);
+    const __m128i mono1 = _mm_srai_epi32(_mm_add_epi32(left1, right1), 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packs_epi32(mono0, mono1));
+  }
+  return i;
+}
+
+size_t UpmixMonoS16ToStereoF32Sse2(const int16_t* src,
+                                   float* dst,
+                                   size_t frame_count) {
+  const __m128 scale = _mm_set1_ps(kS16ToF32);
+  size_t i = 0;
+  for (; i + 8 <= frame_count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128 lo = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), scale);
+    const __m128 hi = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), scale);
+    _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(lo, lo));
+    _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(lo, lo));
+    _mm_storeu_ps(dst + 2 * i + 8, _mm_unpacklo_ps(hi, hi));
+    _mm_storeu_ps(dst + 2 * i + 12, _mm_unpackhi_ps(hi, hi));
+  }
+  return i;
+}
+
+size_t MeasureLevelS16Sse2(const int16_t* src,
+                           size_t count,
+                           uint64_t* sum_of_squares,
+                           int* peak) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = zero;
+  __m128i max_value = zero;
+  __m128i min_value = zero;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    max_value = _mm_max_epi16(max_value, v);
+    min_value = _mm_min_epi16(min_value, v);
+    // Each pair of squares fits in 32 bits when taken as unsigned, even for
+    // two -32768 samples, so zero-extend to accumulate in 64 bits.
+    const __m128i squares = _mm_madd_epi16(v, v);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(squares, zero));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(squares, zero));
+  }
+  alignas(16) uint64_t sums[2];
+  alignas(16) int16_t maxs[8];
+  alignas(16) int16_t mins[8];
+  _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+  _mm_store_si128(reinterpret_cast<__m128i*>(maxs), max_value);
+  _mm_store_si128(reinterpret_cast<__m128i*>(mins), min_value);
+  *sum_of_squares += sums[0] + sums[1];
+  for (int k = 0; k < 8; ++k) {
+    *peak = std::max(*peak, std::max((int)maxs[k], -(int)mins[k]));
+  }
+  return i;
+}
+
+size_t MixAccumulateF32Sse2(const float* src,
+                            float gain,
+                            float* dst,
+                            size_t count) {
+  const __m128 g = _mm_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128 lo = _mm_mul_ps(_mm_loadu_ps(src + i), g);
+    const __m128 hi = _mm_mul_ps(_mm_loadu_ps(src + i + 4), g);
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), lo));
+    _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), hi));
+  }
+  return i;
+}
+
+size_t ScaleS16RampSse2(const int16_t* src,
+                        int16_t* dst,
+                        size_t frame_count,
+                        int channels,
+                        const float* gain,
+                        const float* step) {
+  // Per-lane channel gains and frame offsets of a block of 8 samples.
+  float lane_gain[8];
+  float lane_step[8];
+  float lane_frame[8];
+  for (int j = 0; j < 8; ++j) {
+    lane_gain[j] = gain[j % channels];
+    lane_step[j] = step[j % channels];
+    lane_frame[j] = (float)(j / channels);
+  }
+  const __m128 gain_lo = _mm_loadu_ps(lane_gain);
+  const __m128 gain_hi = _mm_loadu_ps(lane_gain + 4);
+  const __m128 step_lo = _mm_loadu_ps(lane_step);
+  const __m128 step_hi = _mm_loadu_ps(lane_step + 4);
+  const __m128 frame_lo = _mm_loadu_ps(lane_frame);
+  const __m128 frame_hi = _mm_loadu_ps(lane_frame + 4);
+  const size_t count = frame_count * channels;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128 frame = _mm_set1_ps((float)(i / channels));
+    const __m128 g_lo = _mm_add_ps(
+        gain_lo, _mm_mul_ps(step_lo, _mm_add_ps(frame, frame_lo)));
+    const __m128 g_hi = _mm_add_ps(
+        gain_hi, _mm_mul_ps(step_hi, _mm_add_ps(frame, frame_hi)));
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign-extend to 32 bits by placing each sample in the high half.
+    const __m128 lo = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), g_lo);
+    const __m128 hi = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), g_hi);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+  }
+  return i / channels;
+}
+
+size_t UpmixMonoS16ToStereoS16RampSse2(const int16_t* src,
+                                       int16_t* dst,
+                                       size_t frame_count,
+                                       const float* gain,
+                                       const float* step) {
+  const __m128 gain_left = _mm_set1_ps(gain[0]);
+  const __m128 gain_right = _mm_set1_ps(gain[1]);
+  const __m128 step_left = _mm_set1_ps(step[0]);
+  const __m128 step_right = _mm_set1_ps(step[1]);
+  const __m128 frame_offset = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  size_t i = 0;
+  for (; i + 4 <= frame_count; i += 4) {
+    const __m128 frame = _mm_add_ps(_mm_set1_ps((float)i), frame_offset);
+    const __m128i v =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+    const __m128 value =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    const __m128 left = _mm_mul_ps(
+        value, _mm_add_ps(gain_left, _mm_mul_ps(step_left, frame)));
+    const __m128 right = _mm_mul_ps(
+        value, _mm_add_ps(gain_right, _mm_mul_ps(step_right, frame)));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + 2 * i),
+        _mm_packs_epi32(_mm_cvtps_epi32(_mm_unpacklo_ps(left, right)),
+                        _mm_cvtps_epi32(_mm_unpackhi_ps(left, right))));
+  }
+  return i;
+}
+
+//
+// AVX2 versions, for the conversions to and from floating point which are the
+// most expensive per sample.
+//
+
+MRS_TARGET_AVX2 size_t ConvertS16ToF32Avx2(const int16_t* src,
+                                           float* dst,
+                                           size_t count) {
+  const __m256 scale = _mm256_set1_ps(kS16ToF32);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i v0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i v1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    _mm256_storeu_ps(
+        dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v0)),
+                               scale));
+    _mm256_storeu_ps(
+        dst + i + 8,
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v1)), scale));
+  }
+  return i;
+}
+
+MRS_TARGET_AVX2 size_t ConvertF32ToS16Avx2(const float* src,
+                                           int16_t* dst,
+                                           size_t count) {
+  const __m256 scale = _mm256_set1_ps(kF32ToS16);
+  const __m256 min_value = _mm256_set1_ps(-32768.0f);
+  const __m256 max_value = _mm256_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256 lo = _mm256_min_ps(
+        _mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale),
+                      min_value),
+        max_value);
+    const __m256 hi = _mm256_min_ps(
+        _mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale),
+                      min_value),
+        max_value);
+    // The 256-bit pack works per 128-bit lane, so reorder the 64-bit blocks
+    // afterward to restore the sample order.
+    const __m256i packed =
+        _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  return i;
+}
+
+MRS_TARGET_AVX2 size_t UpmixMonoS16ToStereoF32Avx2(const int16_t* src,
+                                                   float* dst,
+                                                   size_t frame_count) {
+  const __m256 scale = _mm256_set1_ps(kS16ToF32);
+  size_t i = 0;
+  for (; i + 8 <= frame_count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m256 f =
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), scale);
+    // Duplicate within 128-bit lanes, then reorder the lanes
+    const __m256 lo = _mm256_unpacklo_ps(f, f);  // 0 0 1 1 | 4 4 5 5
+    const __m256 hi = _mm256_unpackhi_ps(f, f);  // 2 2 3 3 | 6 6 7 7
+    _mm256_storeu_ps(dst + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(dst + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  return i;
+}
+
+MRS_TARGET_AVX2 size_t MixAccumulateF32Avx2(const float* src,
+                                            float gain,
+                                            float* dst,
+                                            size_t count) {
+  // Multiply and add separately rather than with FMA, to round like the other
+  // versions.
+  const __m256 g = _mm256_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(src + i), g);
+    const __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), g);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), lo));
+    _mm256_storeu_ps(dst + i + 8,
+                     _mm256_add_ps(_mm256_loadu_ps(dst + i + 8), hi));
+  }
+  return i;
+}
+
+#endif  // defined(MRS_AUDIO_X86)
+
+#if defined(MRS_AUDIO_NEON)
+
+//
+// NEON versions
+//
+
+size_t ConvertU8ToS16Neon(const uint8_t* src, int16_t* dst, size_t count) {
+  const uint8x16_t bias = vdupq_n_u8(0x80);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), bias));
+    vst1q_s16(dst + i, vshll_n_s8(vget_low_s8(v), 8));
+    vst1q_s16(dst + i + 8, vshll_n_s8(vget_high_s8(v), 8));
+  }
+  return i;
+}
+
+size_t ConvertS16ToF32Neon(const int16_t* src, float* dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int16x8_t v = vld1q_s16(src + i);
+    vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))),
+                                   kS16ToF32));
+    vst1q_f32(dst + i + 4,
+              vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))),
+                          kS16ToF32));
+  }
+  return i;
+}
+
+#if defined(MRS_AUDIO_NEON_A64)
+size_t ConvertF32ToS16Neon(const float* src, int16_t* dst, size_t count) {
+  const float32x4_t min_value = vdupq_n_f32(-32768.0f);
+  const float32x4_t max_value = vdupq_n_f32(32767.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const float32x4_t lo = vminq_f32(
+        vmaxq_f32(vmulq_n_f32(vld1q_f32(src + i), kF32ToS16), min_value),
+        max_value);
+    const float32x4_t hi = vminq_f32(
+        vmaxq_f32(vmulq_n_f32(vld1q_f32(src + i + 4), kF32ToS16), min_value),
+        max_value);
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)),
+                                    vqmovn_s32(vcvtnq_s32_f32(hi))));
+  }
+  return i;
+}
+#endif  // defined(MRS_AUDIO_NEON_A64)
+
+size_t DownmixStereoToMonoS16Neon(const int16_t* src,
+                                  int16_t* dst,
+                                  size_t frame_count) {
+  size_t i = 0;
+  for (; i + 8 <= frame_count; i += 8) {
+    // Deinterleave L/R, then use the halving add which rounds down like the
+    // scalar version.
+    const int16x8x2_t v = vld2q_s16(src + 2 * i);
+    vst1q_s16(dst + i, vhaddq_s16(v.val[0], v.val[1]));
+  }
+  return i;
+}
+
+size_t UpmixMonoS16ToStereoF32Neon(const int16_t* src,
+                                   float* dst,
+                                   size_t frame_count) {
+  size_t i = 0;
+  for (; i + 8 <= frame_count; i += 8) {
+    const int16x8_t v = vld1q_s16(src + i);
+    const float32x4_t lo =
+        vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), kS16ToF32);
+    const float32x4_t hi =
+        vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), kS16ToF32);
+    vst2q_f32(dst + 2 * i, float32x4x2_t{{lo, lo}});
+    vst2q_f32(dst + 2 * i + 8, float32x4x2_t{{hi, hi}});
+  }
+  return i;
+}
+
+size_t MeasureLevelS16Neon(const int16_t* src,
+                           size_t count,
+                           uint64_t* sum_of_squares,
+                           int* peak) {
+  // Squares are at most 2^30, so pairwise accumulation into 64-bit lanes
+  // never overflows.
+  int64x2_t sum = vdupq_n_s64(0);
+  int16x8_t max_value = vdupq_n_s16(0);
+  int16x8_t min_value = vdupq_n_s16(0);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int16x8_t v = vld1q_s16(src + i);
+    max_value = vmaxq_s16(max_value, v);
+    min_value = vminq_s16(min_value, v);
+    const int16x4_t lo = vget_low_s16(v);
+    const int16x4_t hi = vget_high_s16(v);
+    sum = vpadalq_s32(sum, vmull_s16(lo, lo));
+    sum = vpadalq_s32(sum, vmull_s16(hi, hi));
+  }
+  int16_t maxs[8];
+  int16_t mins[8];
+  vst1q_s16(maxs, max_value);
+  vst1q_s16(mins, min_value);
+  *sum_of_squares +=
+      (uint64_t)(vgetq_lane_s64(sum, 0) + vgetq_lane_s64(sum, 1));
+  for (int k = 0; k < 8; ++k) {
+    *peak = std::max(*peak, std::max((int)maxs[k], -(int)mins[k]));
+  }
+  return i;
+}
+
+size_t MixAccumulateF32Neon(const float* src,
+                            float gain,
+                            float* dst,
+                            size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const float32x4_t lo = vmulq_n_f32(vld1q_f32(src + i), gain);
+    const float32x4_t hi = vmulq_n_f32(vld1q_f32(src + i + 4), gain);
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), lo));
+    vst1q_f32(dst + i + 4, vaddq_f32(vld1q_f32(dst + i + 4), hi));
+  }
+  return i;
+}
+
+#if defined(MRS_AUDIO_NEON_A64)
+size_t ScaleS16RampNeon(const int16_t* src,
+                        int16_t* dst,
+                        size_t frame_count,
+                        int channels,
+                        const float* gain,
+                        const float* step) {
+  // Per-lane channel gains and frame offsets of a block of 8 samples.
+  float lane_gain[8];
+  float lane_step[8];
+  float lane_frame[8];
+  for (int j = 0; j < 8; ++j) {
+    lane_gain[j] = gain[j % channels];
+    lane_step[j] = step[j % channels];
+    lane_frame[j] = (float)(j / channels);
+  }
+  const float32x4_t gain_lo = vld1q_f32(lane_gain);
+  const float32x4_t gain_hi = vld1q_f32(lane_gain + 4);
+  const float32x4_t step_lo = vld1q_f32(lane_step);
+  const float32x4_t step_hi = vld1q_f32(lane_step + 4);
+  const float32x4_t frame_lo = vld1q_f32(lane_frame);
+  const float32x4_t frame_hi = vld1q_f32(lane_frame + 4);
+  const size_t count = frame_count * channels;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Multiply and add separately rather than fused, like the scalar version.
+    const float32x4_t frame = vdupq_n_f32((float)(i / channels));
+    const float32x4_t g_lo =
+        vaddq_f32(gain_lo, vmulq_f32(step_lo, vaddq_f32(frame, frame_lo)));
+    const float32x4_t g_hi =
+        vaddq_f32(gain_hi, vmulq_f32(step_hi, vaddq_f32(frame, frame_hi)));
+    const int16x8_t v = vld1q_s16(src + i);
+    const float32x4_t lo =
+        vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), g_lo);
+    const float32x4_t hi =
+        vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), g_hi);
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)),
+                                    vqmovn_s32(vcvtnq_s32_f32(hi))));
+  }
+  return i / channels;
+}
+
+size_t UpmixMonoS16ToStereoS16RampNeon(const int16_t* src,
+                                       int16_t* dst,
+                                       size_t frame_count,
+                                       const float* gain,
+                                       const float* step) {
+  const float frame_offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  const float32x4_t frame_offset = vld1q_f32(frame_offsets);
+  size_t i = 0;
+  for (; i + 4 <= frame_count; i += 4) {
+    const float32x4_t frame = vaddq_f32(vdupq_n_f32((float)i), frame_offset);
+    const float32x4_t value =
+        vcvtq_f32_s32(vmovl_s16(vld1_s16(src + i)));
+    const float32x4_t left = vmulq_f32(
+        value, vaddq_f32(vdupq_n_f32(gain[0]), vmulq_n_f32(frame, step[0])));
+    const float32x4_t right = vmulq_f32(
+        value, vaddq_f32(vdupq_n_f32(gain[1]), vmulq_n_f32(frame, step[1])));
+    vst2_s16(dst + 2 * i,
+             int16x4x2_t{{vqmovn_s32(vcvtnq_s32_f32(left)),
+                          vqmovn_s32(vcvtnq_s32_f32(right))}});
+  }
+  return i;
+}
+#endif  // defined(MRS_AUDIO_NEON_A64)
+
+#endif  // defined(MRS_AUDIO_NEON)
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void ConvertU8ToS16(const uint8_t* src, int16_t* dst, size_t count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertU8ToS16Sse2(src, dst, count);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertU8ToS16Neon(src, dst, count);
+  }
+#endif
+  ConvertU8ToS16Scalar(src + done, dst + done, count - done);
+}
+
+void ConvertS16ToF32(const int16_t* src, float* dst, size_t count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kAvx2) {
+    done = ConvertS16ToF32Avx2(src, dst, count);
+  } else if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertS16ToF32Sse2(src, dst, count);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertS16ToF32Neon(src, dst, count);
+  }
+#endif
+  ConvertS16ToF32Scalar(src + done, dst + done, count - done);
+}
+
+void ConvertF32ToS16(const float* src, int16_t* dst, size_t count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kAvx2) {
+    done = ConvertF32ToS16Avx2(src, dst, count);
+  } else if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertF32ToS16Sse2(src, dst, count);
+  }
+#elif defined(MRS_AUDIO_NEON_A64)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ConvertF32ToS16Neon(src, dst, count);
+  }
+#endif
+  ConvertF32ToS16Scalar(src + done, dst + done, count - done);
+}
+
+void DownmixStereoToMonoS16(const int16_t* src,
+                            int16_t* dst,
+                            size_t frame_count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = DownmixStereoToMonoS16Sse2(src, dst, frame_count);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = DownmixStereoToMonoS16Neon(src, dst, frame_count);
+  }
+#endif
+  DownmixStereoToMonoS16Scalar(src + 2 * done, dst + done, frame_count - done);
+}
+
+void UpmixMonoS16ToStereoF32(const int16_t* src,
+                             float* dst,
+                             size_t frame_count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kAvx2) {
+    done = UpmixMonoS16ToStereoF32Avx2(src, dst, frame_count);
+  } else if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = UpmixMonoS16ToStereoF32Sse2(src, dst, frame_count);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = UpmixMonoS16ToStereoF32Neon(src, dst, frame_count);
+  }
+#endif
+  UpmixMonoS16ToStereoF32Scalar(src + done, dst + 2 * done, frame_count - done);
+}
+
+void MeasureLevelS16(const int16_t* src,
+                     size_t count,
+                     uint64_t* sum_of_squares,
+                     int* peak) noexcept {
+  *sum_of_squares = 0;
+  *peak = 0;
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = MeasureLevelS16Sse2(src, count, sum_of_squares, peak);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = MeasureLevelS16Neon(src, count, sum_of_squares, peak);
+  }
+#endif
+  MeasureLevelS16Scalar(src + done, count - done, sum_of_squares, peak);
+}
+
+void MixAccumulateF32(const float* src,
+                      float gain,
+                      float* dst,
+                      size_t count) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kAvx2) {
+    done = MixAccumulateF32Avx2(src, gain, dst, count);
+  } else if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = MixAccumulateF32Sse2(src, gain, dst, count);
+  }
+#elif defined(MRS_AUDIO_NEON)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = MixAccumulateF32Neon(src, gain, dst, count);
+  }
+#endif
+  MixAccumulateF32Scalar(src + done, gain, dst + done, count - done);
+}
+
+void ScaleS16Ramp(const int16_t* src,
+                  int16_t* dst,
+                  size_t frame_count,
+                  int channels,
+                  const float gain[2],
+                  const float step[2]) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ScaleS16RampSse2(src, dst, frame_count, channels, gain, step);
+  }
+#elif defined(MRS_AUDIO_NEON_A64)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = ScaleS16RampNeon(src, dst, frame_count, channels, gain, step);
+  }
+#endif
+  ScaleS16RampScalar(src, dst, done, frame_count, channels, gain, step);
+}
+
+void UpmixMonoS16ToStereoS16Ramp(const int16_t* src,
+                                 int16_t* dst,
+                                 size_t frame_count,
+                                 const float gain[2],
+                                 const float step[2]) noexcept {
+  size_t done = 0;
+#if defined(MRS_AUDIO_X86)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = UpmixMonoS16ToStereoS16RampSse2(src, dst, frame_count, gain, step);
+  }
+#elif defined(MRS_AUDIO_NEON_A64)
+  if (g_kernel_level >= AudioKernelLevel::kSimd) {
+    done = UpmixMonoS16ToStereoS16RampNeon(src, dst, frame_count, gain, step);
+  }
+#endif
+  UpmixMonoS16ToStereoS16RampScalar(src, dst, done, frame_count, gain, step);
+}
+
+namespace detail {
+
+AudioKernelLevel GetSupportedAudioKernelLevel() noexcept {
+  return GetCpuKernelLevel();
+}
+
+void SetAudioKernelLevel(AudioKernelLevel level) noexcept {
+  g_kernel_level = std::min(level, GetCpuKernelLevel());
+}
+
+}  // namespace detail
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
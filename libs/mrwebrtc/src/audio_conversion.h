@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Sample conversion and channel remixing kernels for interleaved PCM audio.
+/// Each kernel is vectorized for the instruction sets available at runtime
+/// (SSE2 or AVX2 on x86/x64, NEON on ARM), with a scalar fallback producing
+/// identical results. Unless noted, the source and destination must not
+/// overlap.
+
+/// Convert |count| unsigned 8-bit samples to signed 16-bit samples.
+void ConvertU8ToS16(const uint8_t* src, int16_t* dst, size_t count) noexcept;
+
+/// Convert |count| signed 16-bit samples to floating-point samples in the
+/// [-1:1] range.
+void ConvertS16ToF32(const int16_t* src, float* dst, size_t count) noexcept;
+
+/// Convert |count| floating-point samples in the [-1:1] range to signed 16-bit
+/// samples, rounding to nearest and saturating out-of-range values.
+void ConvertF32ToS16(const float* src, int16_t* dst, size_t count) noexcept;
+
+/// Downmix |frame_count| interleaved stereo 16-bit frames to mono by averaging
+/// the left and right channels, rounding toward negative infinity. This can
+/// operate in place, with |dst| equal to |src|.
+void DownmixStereoToMonoS16(const int16_t* src,
+                            int16_t* dst,
+                            size_t frame_count) noexcept;
+
+/// Convert |frame_count| mono 16-bit frames to interleaved stereo
+/// floating-point frames, duplicating each sample on both channels.
+void UpmixMonoS16ToStereoF32(const int16_t* src,
+                             float* dst,
+                             size_t frame_count) noexcept;
+
+/// Measure the level of |count| signed 16-bit samples, returning the sum of
+/// their squares and their peak absolute value, in the [0:32768] range.
+void MeasureLevelS16(const int16_t* src,
+                     size_t count,
+                     uint64_t* sum_of_squares,
+                     int* peak) noexcept;
+
+/// Add |count| floating-point samples scaled by |gain| to the samples of
+/// |dst|, without clipping the result.
+void MixAccumulateF32(const float* src,
+                      float gain,
+                      float* dst,
+                      size_t count) noexcept;
+
+/// Scale |frame_count| interleaved 16-bit frames of |channels| channels, 1 or
+/// 2, by linear gain ramps, multiplying channel |c| of frame |i| by
+/// |gain[c] + step[c] * i|, rounding to nearest and saturating. This can
+/// operate in place, with |dst| equal to |src|.
+void ScaleS16Ramp(const int16_t* src,
+                  int16_t* dst,
+                  size_t frame_count,
+                  int channels,
+                  const float gain[2],
+                  const float step[2]) noexcept;
+
+/// Convert |frame_count| mono 16-bit frames to interleaved stereo 16-bit
+/// frames, scaling the left and right channels by the gain ramps of
+/// |ScaleS16Ramp()|, to pan a mono signal.
+void UpmixMonoS16ToStereoS16Ramp(const int16_t* src,
+                                 int16_t* dst,
+                                 size_t frame_count,
+                                 const float gain[2],
+                                 const float step[2]) noexcept;
+
+namespace detail {
+
+/// Versions of the kernels, from the most portable to the fastest.
+enum class AudioKernelLevel : int {
+  /// Scalar code only.
+  kScalar = 0,
+  /// SSE2 on x86/x64, or NEON on ARM.
+  kSimd = 1,
+  /// AVX2 on x86/x64, where the CPU supports it.
+  kAvx2 = 2,
+};
+
+/// Get the fastest version of the kernels supported by the CPU, which the
+/// kernels use by default.
+AudioKernelLevel GetSupportedAudioKernelLevel() noexcept;
+
+/// Restrict the kernels to the given version, or to the fastest supported one
+/// if lower, for example to compare each vectorized version with the scalar
+/// one. This is not thread-safe, and is only intended for testing.
+void SetAudioKernelLevel(AudioKernelLevel level) noexcept;
+
+}  // namespace detail
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -4,16 +4,135 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "audio_conversion.h"
 #include "audio_frame_observer.h"
 
+namespace {
+
+//
+// Voice activity detection. The noise floor follows the frame power down
+// immediately, and back up slowly, so that it settles on the quietest frames,
+// between words. Frames well above it are considered voice. The constants
+// assume 10 ms frames, which WebRTC always delivers.
+//
+
+/// Lowest noise floor power, -90 dBFS, so that silence does not make any
+/// faint sound look like voice.
+constexpr const float kMinNoiseFloor = 1e-9f;
+
+/// Noise floor increase for each frame above it, making it rise by 2 dB/s.
+constexpr const float kNoiseFloorRisePerFrame = 1.0046f;
+
+/// Minimum ratio of the frame power to the noise floor for voice, about 9 dB.
+constexpr const float kVoiceToNoiseRatio = 8.0f;
+
+/// Minimum frame power for voice, -50 dBFS, below which nothing is audible.
+constexpr const float kMinVoicePower = 1e-5f;
+
+/// Time voice remains active after the level drops.
+constexpr const int kVoiceHangoverMs = 200;
+
+}  // namespace
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
 void AudioFrameObserver::SetCallback(
     AudioFrameReadyCallback callback) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  callback_ = std::move(callback);
+  callback_.Update([&callback](AudioFrameReadyCallback& current) {
+    current = std::move(callback);
+  });
+}
+
+void AudioFrameObserver::SetAggregationPeriod(int period_ms) noexcept {
+  RTC_DCHECK_GE(period_ms, 0);
+  RTC_DCHECK_LE(period_ms, kMaxAggregationPeriodMs);
+  aggregation_period_ms_.store(period_ms, std::memory_order_relaxed);
+}
+
+void AudioFrameObserver::GetAudioLevel(mrsAudioLevel& level) const noexcept {
+  level.rms = rms_level_.load(std::memory_order_relaxed);
+  level.peak = peak_level_.load(std::memory_order_relaxed);
+  level.voice_active = (voice_active_.load(std::memory_order_relaxed)
+                            ? mrsBool::kTrue
+                            : mrsBool::kFalse);
+}
+
+void AudioFrameObserver::SetAudioLevelCallback(
+    AudioLevelChangedCallback callback,
+    float threshold) noexcept {
+  RTC_DCHECK_GE(threshold, 0.0f);
+  level_callback_.Update([&callback, threshold](LevelCallback& current) {
+    current.callback = std::move(callback);
+    current.threshold = threshold;
+  });
+  level_callback_changed_.store(true, std::memory_order_relaxed);
+}
+
+void AudioFrameObserver::UpdateLevel(const int16_t* samples,
+                                     int sample_rate,
+                                     size_t number_of_channels,
+                                     size_t number_of_frames) noexcept {
+  const size_t count = number_of_channels * number_of_frames;
+  if ((count == 0) || (sample_rate <= 0)) {
+    return;
+  }
+  uint64_t sum_of_squares;
+  int peak;
+  MeasureLevelS16(samples, count, &sum_of_squares, &peak);
+  const float power =
+      (float)((double)sum_of_squares / ((double)count * 32768.0 * 32768.0));
+  mrsAudioLevel level;
+  level.rms = std::sqrt(power);
+  level.peak = (float)peak / 32768.0f;
+
+  if (power < noise_floor_) {
+    noise_floor_ = std::max(power, kMinNoiseFloor);
+  } else {
+    noise_floor_ *= kNoiseFloorRisePerFrame;
+  }
+  if ((power >= kMinVoicePower) &&
+      (power >= noise_floor_ * kVoiceToNoiseRatio)) {
+    voice_hangover_ms_ = kVoiceHangoverMs;
+  } else {
+    const int frame_ms = (int)(number_of_frames * 1000 / sample_rate);
+    voice_hangover_ms_ = std::max(voice_hangover_ms_ - frame_ms, 0);
+  }
+  const bool voice_active = (voice_hangover_ms_ > 0);
+  level.voice_active = (voice_active ? mrsBool::kTrue : mrsBool::kFalse);
+
+  rms_level_.store(level.rms, std::memory_order_relaxed);
+  peak_level_.store(level.peak, std::memory_order_relaxed);
+  voice_active_.store(voice_active, std::memory_order_relaxed);
+
+  RcuSnapshot<LevelCallback>::ReadScope level_callback(level_callback_);
+  if (!level_callback->callback) {
+    return;
+  }
+  const bool force =
+      level_callback_changed_.exchange(false, std::memory_order_relaxed);
+  if (force ||
+      (std::fabs(level.rms - reported_level_.rms) >=
+       level_callback->threshold) ||
+      (level.voice_active != reported_level_.voice_active)) {
+    reported_level_ = level;
+    level_callback->callback(level);
+  }
+}
+
+void AudioFrameObserver::Flush(
+    const AudioFrameReadyCallback& callback) noexcept {
+  if (pending_.sample_count_ == 0) {
+    return;
+  }
+  pending_.data_ = buffer_.data();
+  callback(pending_);
+  pending_.sample_count_ = 0;
+  pending_size_ = 0;
 }
 
 void AudioFrameObserver::OnData(const void* audio_data,
@@ -21,8 +140,16 @@ void AudioFrameObserver::OnData(const void* audio_data,
                                 int sample_rate,
                                 size_t number_of_channels,
                                 size_t number_of_frames) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (!callback_) {
+  if (bits_per_sample == 16) {
+    UpdateLevel(static_cast<const int16_t*>(audio_data), sample_rate,
+                number_of_channels, number_of_frames);
+  }
+
+  RcuSnapshot<AudioFrameReadyCallback>::ReadScope callback(callback_);
+  if (!*callback) {
+    // Drop any aggregated frame, which is now outdated
+    pending_.sample_count_ = 0;
+    pending_size_ = 0;
     return;
   }
   AudioFrame frame;
@@ -31,7 +158,45 @@ void AudioFrameObserver::OnData(const void* audio_data,
   frame.sampling_rate_hz_ = static_cast<uint32_t>(sample_rate);
   frame.channel_count_ = static_cast<uint32_t>(number_of_channels);
   frame.sample_count_ = static_cast<uint32_t>(number_of_frames);
-  callback_(frame);
+  frame.timestamp_us_ = rtc::TimeMicros();
+
+  const int period_ms = aggregation_period_ms_.load(std::memory_order_relaxed);
+  if (period_ms != current_period_ms_) {
+    Flush(*callback);
+    current_period_ms_ = period_ms;
+    // Room for 16-bit stereo at up to 96kHz, so this never reallocates
+    // afterward.
+    constexpr const size_t kMaxBytesPerMs = 96 * 2 * 2;
+    buffer_.resize(period_ms * kMaxBytesPerMs);
+    buffer_.shrink_to_fit();
+  }
+
+  const size_t size = (size_t)(bits_per_sample / 8) * number_of_channels *
+                      number_of_frames;
+  if ((pending_.sample_count_ > 0) &&
+      ((pending_.bits_per_sample_ != frame.bits_per_sample_) ||
+       (pending_.sampling_rate_hz_ != frame.sampling_rate_hz_) ||
+       (pending_.channel_count_ != frame.channel_count_) ||
+       (pending_size_ + size > buffer_.size()))) {
+    // Only frames of the same format can be aggregated
+    Flush(*callback);
+  }
+  if ((period_ms == 0) || (size > buffer_.size())) {
+    (*callback)(frame);
+    return;
+  }
+
+  if (pending_.sample_count_ == 0) {
+    pending_ = frame;
+    pending_.sample_count_ = 0;
+  }
+  memcpy(buffer_.data() + pending_size_, audio_data, size);
+  pending_size_ += size;
+  pending_.sample_count_ += frame.sample_count_;
+  if ((uint64_t)pending_.sample_count_ * 1000 >=
+      (uint64_t)period_ms * pending_.sampling_rate_hz_) {
+    Flush(*callback);
+  }
 }
 
 }  // namespace WebRTC
@@ -3,12 +3,15 @@
 
 #pragma once
 
-#include <mutex>
+#include <atomic>
+#include <vector>
 
 #include "api/mediastreaminterface.h"
 
 #include "audio_frame.h"
 #include "callback.h"
+#include "interop_api.h"
+#include "rcu_snapshot.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -17,11 +20,40 @@ namespace WebRTC {
 /// Callback fired on newly available audio frame.
 using AudioFrameReadyCallback = Callback<const AudioFrame&>;
 
+/// Callback fired when the audio level changes significantly.
+using AudioLevelChangedCallback = Callback<const mrsAudioLevel&>;
+
 /// Audio frame observer to get notified of newly available audio frames.
 class AudioFrameObserver : public webrtc::AudioTrackSinkInterface {
  public:
+  /// Register a callback to get notified on frame available. The callback is
+  /// read on the per-frame path without any lock. Once this returns, the
+  /// previous callback is never invoked again, unless this is called from
+  /// within that callback.
   void SetCallback(AudioFrameReadyCallback callback) noexcept;
 
+  /// Deliver the frames in batches of |period_ms| milliseconds instead of
+  /// individually, to reduce the number of callback invocations. WebRTC
+  /// produces a frame every 10ms, so this should be a multiple of 10. Zero
+  /// delivers each frame as soon as it is received. This can be called from
+  /// any thread, and takes effect from the next frame.
+  void SetAggregationPeriod(int period_ms) noexcept;
+
+  /// Maximum aggregation period, in milliseconds.
+  static constexpr const int kMaxAggregationPeriodMs = 1000;
+
+  /// Get the audio level measured over the last frame received, whether or
+  /// not a frame callback is registered. This is lock-free and can be polled
+  /// from any thread.
+  void GetAudioLevel(mrsAudioLevel& level) const noexcept;
+
+  /// Register a callback invoked when the RMS level moved by at least
+  /// |threshold| since the last invocation, or when the voice activity
+  /// changes. The callback is invoked once with the next frame after being
+  /// registered, then on changes only, from the thread delivering the frames.
+  void SetAudioLevelCallback(AudioLevelChangedCallback callback,
+                             float threshold) noexcept;
+
  protected:
   // AudioTrackSinkInterface interface
   void OnData(const void* audio_data,
@@ -31,8 +63,65 @@ class AudioFrameObserver : public webrtc::AudioTrackSinkInterface {
               size_t number_of_frames) noexcept override;
 
  private:
-  AudioFrameReadyCallback callback_ RTC_GUARDED_BY(mutex_);
-  std::mutex mutex_;
+  /// Deliver the aggregated frames, if any.
+  void Flush(const AudioFrameReadyCallback& callback) noexcept;
+
+  /// Measure the level of a 16-bit frame and notify the level callback.
+  void UpdateLevel(const int16_t* samples,
+                   int sample_rate,
+                   size_t number_of_channels,
+                   size_t number_of_frames) noexcept;
+
+  struct LevelCallback {
+    AudioLevelChangedCallback callback;
+    float threshold{0.0f};
+  };
+
+  RcuSnapshot<AudioFrameReadyCallback> callback_;
+  RcuSnapshot<LevelCallback> level_callback_;
+
+  /// Set when the level callback changes, to invoke the new one immediately.
+  std::atomic<bool> level_callback_changed_{false};
+
+  /// Last audio level measured, read by |GetAudioLevel()|.
+  std::atomic<float> rms_level_{0.0f};
+  std::atomic<float> peak_level_{0.0f};
+  std::atomic<bool> voice_active_{false};
+
+  //
+  // Level metering state, only accessed from |OnData()|.
+  //
+
+  /// Estimated power of the background noise, in the [0:1] range, starting
+  /// from a quiet -60 dBFS.
+  float noise_floor_{1e-6f};
+
+  /// Remaining time voice is reported active for after the level dropped.
+  int voice_hangover_ms_{0};
+
+  /// Level last passed to the level callback.
+  mrsAudioLevel reported_level_{};
+
+  /// Aggregation period requested with |SetAggregationPeriod()|.
+  std::atomic<int> aggregation_period_ms_{0};
+
+  //
+  // Aggregation state, only accessed from |OnData()|.
+  //
+
+  /// Aggregation period |buffer_| is currently allocated for.
+  int current_period_ms_{0};
+
+  /// Buffer the aggregated frames are copied into, allocated once when the
+  /// aggregation period changes.
+  std::vector<uint8_t> buffer_;
+
+  /// Format, timestamp and sample count of the aggregated frames, or a zero
+  /// sample count if none.
+  AudioFrame pending_{};
+
+  /// Number of bytes of |buffer_| used by the aggregated frames.
+  size_t pending_size_{0};
 };
 
 }  // namespace WebRTC
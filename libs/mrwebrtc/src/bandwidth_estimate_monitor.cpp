@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "api/stats/rtcstats_objects.h"
+
+#include "bandwidth_estimate_monitor.h"
+#include "simple_stats.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Check if a value changed by more than |threshold_percent| of its previous
+/// value.
+bool HasChangedRelative(double previous,
+                        double current,
+                        double threshold_percent) {
+  if (previous == 0.0) {
+    return (current != 0.0);
+  }
+  return (std::abs(current - previous) * 100.0 >=
+          std::abs(previous) * threshold_percent);
+}
+
+/// Collector forwarding a report to its monitor, if still alive.
+class MonitorCollector : public webrtc::RTCStatsCollectorCallback {
+ public:
+  explicit MonitorCollector(
+      std::weak_ptr<BandwidthEstimateMonitor> monitor) noexcept
+      : monitor_(std::move(monitor)) {}
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override {
+    if (std::shared_ptr<BandwidthEstimateMonitor> monitor = monitor_.lock()) {
+      monitor->OnReport(*report);
+    }
+  }
+
+ private:
+  std::weak_ptr<BandwidthEstimateMonitor> monitor_;
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void BandwidthEstimateMonitor::Collect(
+    webrtc::PeerConnectionInterface& peer) noexcept {
+  if (collecting_) {
+    return;
+  }
+  collecting_ = true;
+  rtc::scoped_refptr<MonitorCollector> collector =
+      new rtc::RefCountedObject<MonitorCollector>(shared_from_this());
+  peer.GetStats(collector);
+}
+
+void BandwidthEstimateMonitor::OnReport(
+    const webrtc::RTCStatsReport& report) noexcept {
+  collecting_ = false;
+
+  // Sum the counters of all transports and received streams, and take the
+  // estimate of the first selected candidate pair, which carries all streams
+  // when bundling.
+  mrsBandwidthEstimate estimate{};
+  bool connected = false;
+  uint64_t bytes_sent = 0;
+  int64_t packets_received = 0;
+  int64_t packets_lost = 0;
+  for (const webrtc::RTCStats& stats : report) {
+    if (stats.type() == webrtc::RTCTransportStats::kType) {
+      mrsTransportStats transport{};
+      FillTransportStats(transport,
+                         stats.cast_to<webrtc::RTCTransportStats>(), report);
+      bytes_sent += transport.bytes_sent;
+      if (!connected && (transport.available_outgoing_bitrate > 0.0)) {
+        connected = true;
+        estimate.target_bitrate = transport.available_outgoing_bitrate;
+        estimate.round_trip_time = transport.current_round_trip_time;
+      }
+    } else if (stats.type() == webrtc::RTCInboundRTPStreamStats::kType) {
+      const auto& rtp_stats = stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
+      packets_received += GetValueIfDefined(rtp_stats.packets_received);
+      packets_lost += GetValueIfDefined(rtp_stats.packets_lost);
+    }
+  }
+  if (!connected) {
+    has_previous_sample_ = false;
+    return;
+  }
+
+  const int64_t timestamp_us = report.timestamp_us();
+  // Counters restart from zero when the transport is recreated.
+  const bool has_previous_sample =
+      has_previous_sample_ && (bytes_sent >= previous_bytes_sent_);
+  const int64_t elapsed_us = timestamp_us - previous_timestamp_us_;
+  const uint64_t bytes_sent_delta = bytes_sent - previous_bytes_sent_;
+  const int64_t received_delta = packets_received - previous_packets_received_;
+  const int64_t lost_delta = packets_lost - previous_packets_lost_;
+  has_previous_sample_ = true;
+  previous_timestamp_us_ = timestamp_us;
+  previous_bytes_sent_ = bytes_sent;
+  previous_packets_received_ = packets_received;
+  previous_packets_lost_ = packets_lost;
+  if (!has_previous_sample || (elapsed_us <= 0)) {
+    // Rates need two samples of the same connection.
+    return;
+  }
+
+  estimate.timestamp_us = timestamp_us;
+  estimate.send_bitrate = (bytes_sent_delta * 8.0 * 1e6) / elapsed_us;
+  // The loss count decreases when duplicates are received.
+  if ((lost_delta > 0) && (received_delta + lost_delta > 0)) {
+    estimate.loss_fraction = std::min(
+        1.0, (double)lost_delta / (double)(received_delta + lost_delta));
+  }
+
+  if (!has_last_estimate_ || HasChanged(estimate)) {
+    has_last_estimate_ = true;
+    last_estimate_ = estimate;
+    callback_(&estimate);
+  }
+}
+
+bool BandwidthEstimateMonitor::HasChanged(
+    const mrsBandwidthEstimate& estimate) const noexcept {
+  const double threshold = config_.change_threshold_percent;
+  return HasChangedRelative(last_estimate_.target_bitrate,
+                            estimate.target_bitrate, threshold) ||
+         HasChangedRelative(last_estimate_.send_bitrate, estimate.send_bitrate,
+                            threshold) ||
+         HasChangedRelative(last_estimate_.round_trip_time,
+                            estimate.round_trip_time, threshold) ||
+         (std::abs(estimate.loss_fraction - last_estimate_.loss_fraction) *
+              100.0 >=
+          threshold);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
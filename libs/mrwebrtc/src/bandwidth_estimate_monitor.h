@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+
+#include "api/peerconnectioninterface.h"
+#include "api/stats/rtcstatsreport.h"
+
+#include "callback.h"
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Callback delivering a bandwidth estimate.
+using BandwidthEstimateCallback = Callback<const mrsBandwidthEstimate*>;
+
+/// Periodic check of the bandwidth estimate of a peer connection, delivering
+/// the estimates which changed significantly. This is only accessed on the
+/// signaling thread.
+class BandwidthEstimateMonitor
+    : public std::enable_shared_from_this<BandwidthEstimateMonitor> {
+ public:
+  BandwidthEstimateMonitor(const mrsBandwidthEstimateConfig& config,
+                           BandwidthEstimateCallback callback) noexcept
+      : config_(config), callback_(callback) {}
+
+  int interval_ms() const noexcept { return config_.interval_ms; }
+
+  /// Request a new report from the peer connection, and check its estimate
+  /// once ready, unless the monitor is destroyed first. This is a no-op while
+  /// the previous report is being collected.
+  void Collect(webrtc::PeerConnectionInterface& peer) noexcept;
+
+  /// Compute the estimate of a report requested by |Collect()|, and deliver it
+  /// to the callback if it changed enough since the last one delivered.
+  void OnReport(const webrtc::RTCStatsReport& report) noexcept;
+
+ private:
+  /// Check if an estimate changed enough since the last one delivered.
+  bool HasChanged(const mrsBandwidthEstimate& estimate) const noexcept;
+
+  const mrsBandwidthEstimateConfig config_;
+  const BandwidthEstimateCallback callback_;
+
+  /// A report is being collected.
+  bool collecting_{false};
+
+  /// Counters of the previous report, to compute the rates since then.
+  bool has_previous_sample_{false};
+  int64_t previous_timestamp_us_{0};
+  uint64_t previous_bytes_sent_{0};
+  int64_t previous_packets_received_{0};
+  int64_t previous_packets_lost_{0};
+
+  /// Last estimate delivered, if any.
+  bool has_last_estimate_{false};
+  mrsBandwidthEstimate last_estimate_{};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -4,7 +4,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "export.h"
+#include "tracing.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -35,8 +40,10 @@ struct Callback {
   }
 
   /// Invoke the callback with the given arguments |args|.
-  constexpr void operator()(Args... args) const noexcept {
+  void operator()(Args... args) const noexcept {
     if (callback_ != nullptr) {
+      MRS_TRACE_SCOPE2(Interop, "Callback", "function", (intptr_t)callback_,
+                       "user_data", (intptr_t)user_data_);
       (*callback_)(user_data_, std::forward<Args>(args)...);
     }
   }
@@ -64,14 +71,63 @@ struct RetCallback {
   }
 
   /// Invoke the callback with the given arguments |args|.
-  constexpr return_type operator()(Args... args) const noexcept {
+  return_type operator()(Args... args) const noexcept {
     if (callback_ != nullptr) {
+      MRS_TRACE_SCOPE2(Interop, "Callback", "function", (intptr_t)callback_,
+                       "user_data", (intptr_t)user_data_);
       return (*callback_)(user_data_, std::forward<Args>(args)...);
     }
     return return_type{};
   }
 };
 
+/// Identifier of a listener in a |CallbackList|.
+using CallbackListenerId = uint64_t;
+
+/// List of listeners of a given callback type |CallbackT|, all invoked in turn
+/// with the same arguments.
+template <typename CallbackT>
+struct CallbackList {
+  struct Entry {
+    CallbackListenerId id_;
+    CallbackT callback_;
+  };
+
+  /// Listeners, in registration order.
+  std::vector<Entry> entries_;
+
+  /// Check if the list has any listener.
+  explicit operator bool() const noexcept { return !entries_.empty(); }
+
+  /// Invoke all listeners with the given arguments |args|.
+  template <typename... Args>
+  void operator()(Args&&... args) const noexcept {
+    for (auto&& entry : entries_) {
+      entry.callback_(args...);
+    }
+  }
+
+  /// Assign the callback of the listener with the given identifier, adding it
+  /// if not present, or remove that listener if |callback| is empty. Return
+  /// |true| if the list changed.
+  bool Set(CallbackListenerId id, CallbackT callback) {
+    auto it =
+        std::find_if(entries_.begin(), entries_.end(),
+                     [id](const Entry& entry) { return (entry.id_ == id); });
+    if (!callback) {
+      if (it == entries_.end()) {
+        return false;
+      }
+      entries_.erase(it);
+    } else if (it != entries_.end()) {
+      it->callback_ = std::move(callback);
+    } else {
+      entries_.push_back(Entry{id, std::move(callback)});
+    }
+    return true;
+  }
+};
+
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
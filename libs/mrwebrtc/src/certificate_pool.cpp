@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "certificate_pool.h"
+
+#include "rtc_base/rtccertificategenerator.h"
+#include "rtc_base/timeutils.h"
+
+namespace {
+
+enum {
+  /// Generate a certificate to refill the pool.
+  MSG_REFILL
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+CertificatePool::CertificatePool(
+    const mrsCertificatePoolConfig& config) noexcept
+    : config_(config) {
+  if (config_.pool_size == 0) {
+    return;
+  }
+  thread_ = rtc::Thread::Create();
+  thread_->SetName("Certificate generation thread", thread_.get());
+  thread_->Start();
+  std::lock_guard<std::mutex> lock(mutex_);
+  RequestRefillNoLock();
+}
+
+CertificatePool::~CertificatePool() {
+  if (thread_) {
+    thread_->Clear(this);
+    thread_->Stop();
+  }
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> CertificatePool::Take(
+    const std::string& identity) noexcept {
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!identity.empty()) {
+      auto it = identity_certificates_.find(identity);
+      if (it != identity_certificates_.end()) {
+        const uint64_t now_ms =
+            rtc::TimeUTCMicros() / rtc::kNumMicrosecsPerMillisec;
+        if (!it->second->HasExpired(now_ms)) {
+          return it->second;
+        }
+        identity_certificates_.erase(it);
+      }
+    }
+    if (!certificates_.empty()) {
+      certificate = std::move(certificates_.front());
+      certificates_.pop_front();
+      RequestRefillNoLock();
+    }
+  }
+  if (identity.empty()) {
+    return certificate;
+  }
+  if (!certificate) {
+    // The connection would generate its own certificate otherwise, which
+    // cannot be reused.
+    certificate = Generate();
+    if (!certificate) {
+      return nullptr;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another connection to the same identity may have raced this one.
+  auto inserted = identity_certificates_.emplace(identity, certificate);
+  return inserted.first->second;
+}
+
+void CertificatePool::OnMessage(rtc::Message* message) {
+  RTC_DCHECK_EQ(MSG_REFILL, message->message_id);
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate = Generate();
+  std::lock_guard<std::mutex> lock(mutex_);
+  refill_pending_ = false;
+  if (!certificate) {
+    // Let the next |Take()| retry.
+    return;
+  }
+  certificates_.push_back(std::move(certificate));
+  RequestRefillNoLock();
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> CertificatePool::Generate()
+    const noexcept {
+  const rtc::KeyParams key_params =
+      (config_.key_type == mrsCertificateKeyType::kRsa
+           ? rtc::KeyParams::RSA()
+           : rtc::KeyParams::ECDSA(rtc::EC_NIST_P256));
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate =
+      rtc::RTCCertificateGenerator::GenerateCertificate(key_params,
+                                                        absl::nullopt);
+  if (!certificate) {
+    RTC_LOG(LS_ERROR) << "Failed to generate a DTLS certificate.";
+  }
+  return certificate;
+}
+
+void CertificatePool::RequestRefillNoLock() {
+  if (!thread_ || refill_pending_ ||
+      (certificates_.size() >= config_.pool_size)) {
+    return;
+  }
+  refill_pending_ = true;
+  thread_->Post(RTC_FROM_HERE, this, MSG_REFILL);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
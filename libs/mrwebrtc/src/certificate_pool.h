@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/rtccertificate.h"
+#include "rtc_base/thread.h"
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Pool of DTLS certificates generated ahead of time on a background thread,
+/// handed to the peer connections as they are created, so that they do not
+/// generate their own. The pool also keeps the certificate of each remote
+/// identity, to reuse it for all the connections to that identity.
+class CertificatePool : public rtc::MessageHandler {
+ public:
+  /// Create a pool, and start generating its certificates if |config| has a
+  /// non-zero pool size.
+  explicit CertificatePool(const mrsCertificatePoolConfig& config) noexcept;
+  ~CertificatePool() override;
+
+  /// Take a certificate for a new peer connection, and start generating a
+  /// replacement. If |identity| is not empty, return the certificate already
+  /// taken for the same identity, if any and not expired, and otherwise keep
+  /// the one returned for later connections to the same identity. This
+  /// returns NULL if the pool is empty and |identity| is empty, to let the
+  /// connection generate its own certificate without waiting.
+  rtc::scoped_refptr<rtc::RTCCertificate> Take(
+      const std::string& identity) noexcept;
+
+ protected:
+  // MessageHandler interface
+  void OnMessage(rtc::Message* message) override;
+
+ private:
+  /// Generate a new certificate with the key type of the pool, or return NULL
+  /// on failure.
+  rtc::scoped_refptr<rtc::RTCCertificate> Generate() const noexcept;
+
+  /// Post a message to generate a certificate on |thread_|, unless already
+  /// pending or the pool is full.
+  void RequestRefillNoLock() RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const mrsCertificatePoolConfig config_;
+
+  /// Thread generating the certificates, or NULL if the pool size is zero.
+  std::unique_ptr<rtc::Thread> thread_;
+
+  std::mutex mutex_;
+
+  /// Certificates generated and not taken yet.
+  std::deque<rtc::scoped_refptr<rtc::RTCCertificate>> certificates_
+      RTC_GUARDED_BY(mutex_);
+
+  /// Certificates taken for each remote identity.
+  std::unordered_map<std::string, rtc::scoped_refptr<rtc::RTCCertificate>>
+      identity_certificates_ RTC_GUARDED_BY(mutex_);
+
+  /// A message to generate a certificate is posted to |thread_|.
+  bool refill_pending_ RTC_GUARDED_BY(mutex_){false};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
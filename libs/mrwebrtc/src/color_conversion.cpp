@@ -0,0 +1,360 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "color_conversion.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#define MRS_COLOR_X86 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Range of rows [first, second) of a frame.
+using RowBand = std::pair<int, int>;
+
+using RowFunc = std::function<void(int, int)>;
+
+/// Minimum number of rows in a band, to avoid dispatching bands too small to
+/// amortize the synchronization cost.
+constexpr const int kMinRowsPerBand = 64;
+
+/// Maximum number of worker threads in the conversion pool.
+constexpr const unsigned int kMaxWorkerCount = 7;
+
+std::atomic<uint64_t> g_parallel_conversion_threshold{
+    kDefaultParallelConversionThreshold};
+
+/// Small pool of worker threads shared by all parallel color conversions.
+class ConversionPool {
+ public:
+  /// Get the pool instance, creating its worker threads on first use.
+  static ConversionPool& Get() {
+    // Intentionally leaked, to avoid joining threads during static
+    // destruction, which can deadlock when the library is unloaded.
+    static ConversionPool* const pool = new ConversionPool();
+    return *pool;
+  }
+
+  /// Number of worker threads, not counting the calling thread.
+  size_t GetWorkerCount() const noexcept { return workers_.size(); }
+
+  /// Invoke |func| for each band, using the worker threads along the calling
+  /// thread, and return once all bands are processed.
+  void Run(std::vector<RowBand> bands, const RowFunc& func) {
+    auto batch = std::make_shared<Batch>(std::move(bands), func);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batches_.push_back(batch);
+    }
+    work_cv_.notify_all();
+
+    // Participate instead of idling, then wait for the bands claimed by the
+    // worker threads.
+    ProcessBands(*batch);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&batch]() { return (batch->remaining_ == 0); });
+    auto it = std::find(batches_.begin(), batches_.end(), batch);
+    if (it != batches_.end()) {
+      batches_.erase(it);
+    }
+  }
+
+ private:
+  struct Batch {
+    Batch(std::vector<RowBand> bands, const RowFunc& func)
+        : bands_(std::move(bands)), func_(&func), remaining_(bands_.size()) {}
+    const std::vector<RowBand> bands_;
+    /// Only dereferenced for unprocessed bands, while the caller waits.
+    const RowFunc* const func_;
+    std::atomic<size_t> next_{0};
+    size_t remaining_;  // guarded by |mutex_|
+  };
+
+  ConversionPool() {
+    const unsigned int hw_count = std::thread::hardware_concurrency();
+    const unsigned int count =
+        std::min(hw_count > 1 ? hw_count - 1 : 0u, kMaxWorkerCount);
+    workers_.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+      workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+  }
+
+  void ProcessBands(Batch& batch) {
+    size_t index;
+    while ((index = batch.next_.fetch_add(1)) < batch.bands_.size()) {
+      const RowBand& band = batch.bands_[index];
+      (*batch.func_)(band.first, band.second);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--batch.remaining_ == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      work_cv_.wait(lock, [this]() { return !batches_.empty(); });
+      std::shared_ptr<Batch> batch = batches_.front();
+      if (batch->next_.load() >= batch->bands_.size()) {
+        // All bands already claimed; retire the batch from the queue so other
+        // workers do not pick it up again.
+        batches_.pop_front();
+        continue;
+      }
+      lock.unlock();
+      ProcessBands(*batch);
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::shared_ptr<Batch>> batches_;
+  std::vector<std::thread> workers_;
+};
+
+/// Copy a row with non-temporal stores, where available.
+void StreamRow(uint8_t* dst, const uint8_t* src, size_t size) {
+#if defined(MRS_COLOR_X86)
+  // SSE2 is part of the x64 baseline, and required by WebRTC on x86.
+  // Streaming stores need a 16-byte aligned destination.
+  const size_t head = std::min(size, (16 - ((uintptr_t)dst & 15)) & 15);
+  memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  size -= head;
+  for (; size >= 64; size -= 64, dst += 64, src += 64) {
+    const __m128i* const s = reinterpret_cast<const __m128i*>(src);
+    __m128i* const d = reinterpret_cast<__m128i*>(dst);
+    const __m128i v0 = _mm_loadu_si128(s);
+    const __m128i v1 = _mm_loadu_si128(s + 1);
+    const __m128i v2 = _mm_loadu_si128(s + 2);
+    const __m128i v3 = _mm_loadu_si128(s + 3);
+    _mm_stream_si128(d, v0);
+    _mm_stream_si128(d + 1, v1);
+    _mm_stream_si128(d + 2, v2);
+    _mm_stream_si128(d + 3, v3);
+  }
+  for (; size >= 16; size -= 16, dst += 16, src += 16) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+  }
+#endif
+  // NEON has no non-temporal store intrinsic; the cache is used as usual.
+  memcpy(dst, src, size);
+}
+
+/// Check if all bytes of a row are 0xFF.
+bool IsRowOpaque(const uint8_t* row, size_t size) {
+#if defined(MRS_COLOR_X86)
+  if (size >= 64) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(row);
+    __m128i acc = _mm_set1_epi8((char)0xFF);
+    for (; size >= 64; size -= 64, s += 4) {
+      acc = _mm_and_si128(
+          acc, _mm_and_si128(_mm_and_si128(_mm_loadu_si128(s),
+                                           _mm_loadu_si128(s + 1)),
+                             _mm_and_si128(_mm_loadu_si128(s + 2),
+                                           _mm_loadu_si128(s + 3))));
+    }
+    for (; size >= 16; size -= 16, ++s) {
+      acc = _mm_and_si128(acc, _mm_loadu_si128(s));
+    }
+    const __m128i all_set = _mm_cmpeq_epi8(acc, _mm_set1_epi8((char)0xFF));
+    if (_mm_movemask_epi8(all_set) != 0xFFFF) {
+      return false;
+    }
+    row = reinterpret_cast<const uint8_t*>(s);
+  }
+#endif
+  // Compilers vectorize this loop well enough on other architectures.
+  uint64_t acc = ~uint64_t{0};
+  for (; size >= 8; size -= 8, row += 8) {
+    uint64_t word;
+    memcpy(&word, row, 8);
+    acc &= word;
+  }
+  for (; size > 0; --size, ++row) {
+    acc &= (*row | ~uint64_t{0xFF});
+  }
+  return (acc == ~uint64_t{0});
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void SetParallelConversionThreshold(uint64_t pixel_count) noexcept {
+  g_parallel_conversion_threshold.store(pixel_count);
+}
+
+uint64_t GetParallelConversionThreshold() noexcept {
+  return g_parallel_conversion_threshold.load();
+}
+
+void ForEachRowBand(int width,
+                    int height,
+                    const std::function<void(int, int)>& func) noexcept {
+  const uint64_t threshold = g_parallel_conversion_threshold.load();
+  const uint64_t pixel_count = static_cast<uint64_t>(width) * height;
+  if ((threshold == 0) || (pixel_count < threshold) ||
+      (height < 2 * kMinRowsPerBand)) {
+    func(0, height);
+    return;
+  }
+  ConversionPool& pool = ConversionPool::Get();
+  const int max_band_count = static_cast<int>(pool.GetWorkerCount()) + 1;
+  const int band_count =
+      std::min(max_band_count, std::max(1, height / kMinRowsPerBand));
+  if (band_count <= 1) {
+    func(0, height);
+    return;
+  }
+  // Round the band height up to a multiple of 2 for chroma downsampling
+  const int rows_per_band = (((height + band_count - 1) / band_count) + 1) & ~1;
+  std::vector<RowBand> bands;
+  bands.reserve(band_count);
+  for (int row = 0; row < height; row += rows_per_band) {
+    bands.emplace_back(row, std::min(row + rows_per_band, height));
+  }
+  pool.Run(std::move(bands), func);
+}
+
+void ForEachRangeParallel(int count,
+                          const std::function<void(int, int)>& func) noexcept {
+  ConversionPool& pool = ConversionPool::Get();
+  const int max_range_count = static_cast<int>(pool.GetWorkerCount()) + 1;
+  const int range_count = std::min(max_range_count, count);
+  if (range_count <= 1) {
+    func(0, count);
+    return;
+  }
+  const int per_range = (count + range_count - 1) / range_count;
+  std::vector<RowBand> ranges;
+  ranges.reserve(range_count);
+  for (int begin = 0; begin < count; begin += per_range) {
+    ranges.emplace_back(begin, std::min(begin + per_range, count));
+  }
+  pool.Run(std::move(ranges), func);
+}
+
+void CopyPlaneRows(const uint8_t* src,
+                   int src_stride,
+                   uint8_t* dst,
+                   int dst_stride,
+                   int row_size,
+                   int height,
+                   int row_begin,
+                   int row_end,
+                   bool flip,
+                   bool streaming) noexcept {
+  src += (size_t)row_begin * src_stride;
+  if (flip) {
+    dst += (size_t)(height - 1 - row_begin) * dst_stride;
+    dst_stride = -dst_stride;
+  } else {
+    dst += (size_t)row_begin * dst_stride;
+  }
+  const int row_count = row_end - row_begin;
+  if (!streaming) {
+    // libyuv copies tightly packed planes at once, and has its own SIMD rows.
+    libyuv::CopyPlane(src, src_stride, dst, dst_stride, row_size, row_count);
+    return;
+  }
+  for (int i = 0; i < row_count; ++i) {
+    StreamRow(dst, src, (size_t)row_size);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+bool IsPlaneOpaque(const uint8_t* data,
+                   int stride,
+                   int width,
+                   int height) noexcept {
+  for (int i = 0; i < height; ++i) {
+    if (!IsRowOpaque(data + (size_t)i * stride, (size_t)width)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FenceStreamingStores() noexcept {
+#if defined(MRS_COLOR_X86)
+  _mm_sfence();
+#endif
+}
+
+void ConvertI420ToArgb32(const uint8_t* yptr,
+                         int ystride,
+                         const uint8_t* uptr,
+                         int ustride,
+                         const uint8_t* vptr,
+                         int vstride,
+                         const uint8_t* aptr,
+                         int astride,
+                         uint8_t* argb,
+                         int argb_stride,
+                         int width,
+                         int height) noexcept {
+  ForEachRowBand(width, height, [&](int row_begin, int row_end) {
+    const int row_count = row_end - row_begin;
+    const int chroma_row = row_begin / 2;
+    const uint8_t* const y = yptr + (size_t)row_begin * ystride;
+    const uint8_t* const u = uptr + (size_t)chroma_row * ustride;
+    const uint8_t* const v = vptr + (size_t)chroma_row * vstride;
+    uint8_t* const dst = argb + (size_t)row_begin * argb_stride;
+    if (aptr) {
+      const uint8_t* const a = aptr + (size_t)row_begin * astride;
+      libyuv::I420AlphaToARGB(y, ystride, u, ustride, v, vstride, a, astride,
+                              dst, argb_stride, width, row_count, 0);
+    } else {
+      libyuv::I420ToARGB(y, ystride, u, ustride, v, vstride, dst, argb_stride,
+                         width, row_count);
+    }
+  });
+}
+
+void ConvertArgb32ToI420(const uint8_t* argb,
+                         int argb_stride,
+                         uint8_t* yptr,
+                         int ystride,
+                         uint8_t* uptr,
+                         int ustride,
+                         uint8_t* vptr,
+                         int vstride,
+                         int width,
+                         int height) noexcept {
+  ForEachRowBand(width, height, [&](int row_begin, int row_end) {
+    const int chroma_row = row_begin / 2;
+    libyuv::ARGBToI420(argb + (size_t)row_begin * argb_stride, argb_stride,
+                       yptr + (size_t)row_begin * ystride, ystride,
+                       uptr + (size_t)chroma_row * ustride, ustride,
+                       vptr + (size_t)chroma_row * vstride, vstride, width,
+                       row_end - row_begin);
+  });
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Default minimum number of pixels of a frame for the color conversion to be
+/// split into row bands and run in parallel. Below this, the overhead of the
+/// dispatch outweighs the gain, and conversion runs on the calling thread.
+/// The default corresponds to a 1440p frame.
+constexpr const uint64_t kDefaultParallelConversionThreshold = 2560 * 1440;
+
+/// Set the minimum number of pixels of a frame for color conversions to run in
+/// parallel. A value of zero disables parallel conversion.
+void SetParallelConversionThreshold(uint64_t pixel_count) noexcept;
+
+/// Get the minimum number of pixels of a frame for color conversions to run in
+/// parallel, or zero if parallel conversion is disabled.
+uint64_t GetParallelConversionThreshold() noexcept;
+
+/// Invoke |func(row_begin, row_end)| over all rows of a frame of the given
+/// dimensions, split into bands of rows. The start of each band is a multiple
+/// of 2, so that bands map to whole rows of the 2x2 downsampled chroma planes.
+/// If the frame has fewer pixels than the parallel conversion threshold, this
+/// invokes |func(0, height)| once on the calling thread. Otherwise the bands
+/// are dispatched to a small shared worker pool, and the calling thread
+/// participates until all bands are processed. This returns once |func| has
+/// returned for all bands.
+void ForEachRowBand(int width,
+                    int height,
+                    const std::function<void(int, int)>& func) noexcept;
+
+/// Invoke |func(begin, end)| over the range of indices [0, count), split into
+/// one sub-range per thread of the worker pool used by |ForEachRowBand()|, and
+/// return once |func| has returned for all sub-ranges. The calling thread
+/// participates in the work.
+void ForEachRangeParallel(int count,
+                          const std::function<void(int, int)>& func) noexcept;
+
+/// Copy the rows [row_begin, row_end) of a plane of |height| rows and
+/// |row_size| bytes per row, optionally to the mirrored rows of the destination
+/// to flip the plane vertically. With |streaming| the destination is written
+/// with non-temporal stores where available, which bypass the CPU cache; this
+/// is faster for write-combined memory like GPU upload heaps, and for planes
+/// too large to benefit from the cache.
+void CopyPlaneRows(const uint8_t* src,
+                   int src_stride,
+                   uint8_t* dst,
+                   int dst_stride,
+                   int row_size,
+                   int height,
+                   int row_begin,
+                   int row_end,
+                   bool flip,
+                   bool streaming) noexcept;
+
+/// Check if all the bytes of a plane of |width| by |height| bytes are 0xFF,
+/// for example an alpha plane which is fully opaque. This returns as soon as a
+/// row has another value.
+bool IsPlaneOpaque(const uint8_t* data,
+                   int stride,
+                   int width,
+                   int height) noexcept;
+
+/// Order the non-temporal stores of |CopyPlaneRows()| issued by the calling
+/// thread before any later store, so the copy is visible to other threads.
+void FenceStreamingStores() noexcept;
+
+/// Convert an I420 frame to ARGB32, with an optional alpha plane. If |aptr| is
+/// NULL then the output alpha is opaque.
+void ConvertI420ToArgb32(const uint8_t* yptr,
+                         int ystride,
+                         const uint8_t* uptr,
+                         int ustride,
+                         const uint8_t* vptr,
+                         int vstride,
+                         const uint8_t* aptr,
+                         int astride,
+                         uint8_t* argb,
+                         int argb_stride,
+                         int width,
+                         int height) noexcept;
+
+/// Convert an ARGB32 frame to I420, discarding the alpha channel.
+void ConvertArgb32ToI420(const uint8_t* argb,
+                         int argb_stride,
+                         uint8_t* yptr,
+                         int ystride,
+                         uint8_t* uptr,
+                         int ustride,
+                         uint8_t* vptr,
+                         int vstride,
+                         int width,
+                         int height) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
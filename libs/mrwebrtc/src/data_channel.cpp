@@ -5,7 +5,9 @@
 #include "pch.h"
 
 #include "data_channel.h"
+#include "lz4_block.h"
 #include "peer_connection.h"
+#include "tracing.h"
 
 namespace {
 
@@ -22,6 +24,34 @@ inline ApiDataState apiStateFromRtcState(RtcDataState rtcState) {
   return (ApiDataState)rtcState;
 }
 
+/// Encoding of the messages of compressed data channels, in their first byte.
+/// Compressed messages are followed by their decompressed size, as a 32-bit
+/// little-endian integer, then by an LZ4 block.
+enum class MessageEncoding : uint8_t {
+  kRaw = 0,
+  kLz4 = 1,
+};
+
+/// Prefixes of the latency probes, sent as text messages, while application
+/// messages are always binary. A ping carries the time it was sent, which
+/// the pong echoes back.
+constexpr const char kPingPrefix[] = "mrs-ping:";
+constexpr const char kPongPrefix[] = "mrs-pong:";
+constexpr const size_t kProbePrefixSize = sizeof(kPingPrefix) - 1;
+
+/// Prefix of the padding of the network probes, sent as text messages and
+/// dropped on receipt.
+constexpr const char kPaddingPrefix[] = "mrs-fill:";
+constexpr const size_t kPaddingPrefixSize = sizeof(kPaddingPrefix) - 1;
+
+bool IsPadding(const rtc::CopyOnWriteBuffer& message) noexcept {
+  return (message.size() >= kPaddingPrefixSize) &&
+         (memcmp(message.cdata(), kPaddingPrefix, kPaddingPrefixSize) == 0);
+}
+
+constexpr const size_t kRawHeaderSize = 1;
+constexpr const size_t kLz4HeaderSize = 5;
+
 }  // namespace
 
 namespace Microsoft {
@@ -30,9 +60,14 @@ namespace WebRTC {
 
 DataChannel::DataChannel(
     PeerConnection* owner,
+    rtc::Thread* signaling_thread,
     rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) noexcept
-    : owner_(owner), data_channel_(std::move(data_channel)) {
+    : owner_(owner),
+      signaling_thread_(signaling_thread),
+      data_channel_(std::move(data_channel)),
+      compressed_(data_channel_->protocol() == kCompressedProtocol) {
   RTC_CHECK(owner_);
+  RTC_CHECK(signaling_thread_);
   data_channel_->RegisterObserver(this);
 }
 
@@ -63,21 +98,468 @@ void DataChannel::SetStateCallback(StateCallback callback) noexcept {
   state_callback_ = callback;
 }
 
-size_t DataChannel::GetMaxBufferingSize() const noexcept {
-  // See BufferingCallback; current WebRTC implementation has a limit of 16MB
-  // for the internal data track buffer capacity.
-  static constexpr size_t kMaxBufferingSize = 0x1000000uLL;  // 16 MB
-  return kMaxBufferingSize;
+void DataChannel::SetWritableCallback(WritableCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  writable_callback_ = callback;
+}
+
+void DataChannel::SetDataAvailableCallback(
+    DataAvailableCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_available_callback_ = callback;
+}
+
+bool DataChannel::AreLimitsValid(const mrsDataChannelLimits& limits) noexcept {
+  return (limits.max_message_size > 0) &&
+         (limits.max_message_size <= limits.max_buffering_size) &&
+         (limits.max_buffering_size <= kMaxTransportBufferingSize);
+}
+
+Result DataChannel::SetLimits(const mrsDataChannelLimits& limits) noexcept {
+  if (!AreLimitsValid(limits)) {
+    RTC_LOG(LS_ERROR) << "Invalid data channel limits of "
+                      << limits.max_buffering_size << " buffered bytes and "
+                      << limits.max_message_size << " bytes per message.";
+    return Result::kInvalidParameter;
+  }
+  max_buffering_size_.store((size_t)limits.max_buffering_size,
+                            std::memory_order_relaxed);
+  max_message_size_.store((size_t)limits.max_message_size,
+                          std::memory_order_relaxed);
+  return Result::kSuccess;
 }
 
 bool DataChannel::Send(const void* data, size_t size) noexcept {
-  if (data_channel_->buffered_amount() + size > GetMaxBufferingSize()) {
+  MRS_TRACE_SCOPE2(DataChannel, "DataChannel::Send", "channel", (intptr_t)this,
+                   "size", size);
+  if (!CanSend(size)) {
+    return false;
+  }
+  return SendEncoded(EncodeMessage(data, size));
+}
+
+bool DataChannel::Send(rtc::CopyOnWriteBuffer buffer) noexcept {
+  MRS_TRACE_SCOPE2(DataChannel, "DataChannel::Send", "channel", (intptr_t)this,
+                   "size", buffer.size());
+  if (buffer.size() > GetMaxMessageSize()) {
+    messages_rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (!compressed_) {
+    return SendEncoded(buffer);
+  }
+  return SendEncoded(EncodeMessage(buffer.cdata(), buffer.size()));
+}
+
+bool DataChannel::SendEncoded(const rtc::CopyOnWriteBuffer& message) noexcept {
+  if (!CanBuffer(message.size()) || !SendToTransport(message)) {
+    messages_rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool DataChannel::SendToTransport(
+    const rtc::CopyOnWriteBuffer& message) noexcept {
+  // DataBuffer and the transport only add references to the buffer storage.
+  webrtc::DataBuffer data_buffer(message, /* binary = */ true);
+  if (!data_channel_->Send(data_buffer)) {
+    return false;
+  }
+  messages_sent_.fetch_add(1, std::memory_order_relaxed);
+  bytes_sent_.fetch_add(message.size(), std::memory_order_relaxed);
+  MaybeSendLatencyProbe();
+  return true;
+}
+
+void DataChannel::GetCounters(mrsDataChannelCounters& counters) const
+    noexcept {
+  counters.messages_sent = messages_sent_.load(std::memory_order_relaxed);
+  counters.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  counters.messages_received =
+      messages_received_.load(std::memory_order_relaxed);
+  counters.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+  counters.messages_rejected =
+      messages_rejected_.load(std::memory_order_relaxed);
+  counters.buffered_amount = buffered_amount_.load(std::memory_order_relaxed);
+  counters.peak_buffered_amount =
+      peak_buffered_amount_.load(std::memory_order_relaxed);
+  counters.latency_us = latency_us_.load(std::memory_order_relaxed);
+}
+
+void DataChannel::SetLatencyProbeInterval(int interval_ms) noexcept {
+  latency_probe_interval_ms_.store(interval_ms, std::memory_order_relaxed);
+  if (interval_ms <= 0) {
+    latency_us_.store(-1, std::memory_order_relaxed);
+  }
+}
+
+void DataChannel::MaybeSendLatencyProbe() noexcept {
+  const int interval_ms =
+      latency_probe_interval_ms_.load(std::memory_order_relaxed);
+  if (interval_ms <= 0) {
+    return;
+  }
+  // Probes are sent along with messages, timing the delivery of the actual
+  // traffic including any backlog, without needing a timer.
+  const int64_t now_us = rtc::TimeMicros();
+  int64_t last_us = last_probe_time_us_.load(std::memory_order_relaxed);
+  if ((now_us - last_us < interval_ms * (int64_t)1000) ||
+      !last_probe_time_us_.compare_exchange_strong(last_us, now_us)) {
+    // Too early, or another thread is sending a probe.
+    return;
+  }
+  data_channel_->Send(
+      webrtc::DataBuffer(kPingPrefix + std::to_string(now_us)));
+}
+
+bool DataChannel::HandleLatencyProbe(
+    const rtc::CopyOnWriteBuffer& message) noexcept {
+  if (message.size() <= kProbePrefixSize) {
+    return false;
+  }
+  const char* const text = message.cdata<char>();
+  const std::string timestamp(text + kProbePrefixSize,
+                              message.size() - kProbePrefixSize);
+  if (memcmp(text, kPingPrefix, kProbePrefixSize) == 0) {
+    data_channel_->Send(webrtc::DataBuffer(kPongPrefix + timestamp));
+    return true;
+  }
+  if (memcmp(text, kPongPrefix, kProbePrefixSize) == 0) {
+    // Without synchronized clocks, estimate the one-way latency as half the
+    // round trip, smoothed like the TCP round trip time.
+    const int64_t sent_us = strtoll(timestamp.c_str(), nullptr, 10);
+    const int64_t one_way_us = (rtc::TimeMicros() - sent_us) / 2;
+    const int64_t latency_us = latency_us_.load(std::memory_order_relaxed);
+    latency_us_.store(
+        latency_us < 0 ? one_way_us
+                       : latency_us + (one_way_us - latency_us) / 8,
+        std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+bool DataChannel::SendPadding(size_t size, size_t max_buffered) noexcept {
+  size = std::max(size, kPaddingPrefixSize);
+  if ((data_channel_->state() != webrtc::DataChannelInterface::kOpen) ||
+      (data_channel_->buffered_amount() + size > max_buffered) ||
+      !CanBuffer(size)) {
+    return false;
+  }
+  rtc::CopyOnWriteBuffer padding(size);
+  uint8_t* const data = padding.data();
+  memcpy(data, kPaddingPrefix, kPaddingPrefixSize);
+  memset(data + kPaddingPrefixSize, ' ', size - kPaddingPrefixSize);
+  return data_channel_->Send(webrtc::DataBuffer(padding, /* binary = */ false));
+}
+
+rtc::CopyOnWriteBuffer DataChannel::EncodeMessage(const void* data,
+                                                  size_t size) const noexcept {
+  if (!compressed_) {
+    return rtc::CopyOnWriteBuffer((const char*)data, size);
+  }
+  auto src = static_cast<const uint8_t*>(data);
+  if ((size >= compression_threshold_.load(std::memory_order_relaxed)) &&
+      (size > kLz4HeaderSize) && (size <= UINT32_MAX)) {
+    // Compress straight into the message sent, and only keep the result if
+    // smaller than the raw message.
+    const size_t capacity = size - kLz4HeaderSize;
+    rtc::CopyOnWriteBuffer message(kLz4HeaderSize +
+                                   std::min(capacity, Lz4CompressBound(size)));
+    uint8_t* const dst = message.data();
+    const size_t compressed_size =
+        Lz4Compress(src, size, dst + kLz4HeaderSize, capacity);
+    if (compressed_size > 0) {
+      dst[0] = (uint8_t)MessageEncoding::kLz4;
+      for (int i = 0; i < 4; ++i) {
+        dst[1 + i] = (uint8_t)(size >> (8 * i));
+      }
+      message.SetSize(kLz4HeaderSize + compressed_size);
+      return message;
+    }
+  }
+  rtc::CopyOnWriteBuffer message(kRawHeaderSize + size);
+  uint8_t* const dst = message.data();
+  dst[0] = (uint8_t)MessageEncoding::kRaw;
+  if (size > 0) {
+    memcpy(dst + kRawHeaderSize, src, size);
+  }
+  return message;
+}
+
+bool DataChannel::DecodeMessage(const rtc::CopyOnWriteBuffer& message,
+                                const uint8_t** data,
+                                size_t* size) noexcept {
+  const uint8_t* const src = message.cdata();
+  const size_t src_size = message.size();
+  if (src_size < kRawHeaderSize) {
     return false;
   }
+  switch ((MessageEncoding)src[0]) {
+    case MessageEncoding::kRaw:
+      *data = src + kRawHeaderSize;
+      *size = src_size - kRawHeaderSize;
+      return true;
+    case MessageEncoding::kLz4: {
+      if (src_size < kLz4HeaderSize) {
+        return false;
+      }
+      size_t decompressed_size = 0;
+      for (int i = 0; i < 4; ++i) {
+        decompressed_size |= ((size_t)src[1 + i] << (8 * i));
+      }
+      // Bound the allocation, as no message can legitimately be larger.
+      if (decompressed_size > kMaxTransportBufferingSize) {
+        return false;
+      }
+      decompress_buffer_.resize(decompressed_size);
+      if (!Lz4Decompress(src + kLz4HeaderSize, src_size - kLz4HeaderSize,
+                         decompress_buffer_.data(), decompressed_size)) {
+        return false;
+      }
+      *data = decompress_buffer_.data();
+      *size = decompressed_size;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+int DataChannel::SendBatch(const mrsDataChannelMessage* messages,
+                           int count,
+                           mrsBool* accepted) noexcept {
+  // The proxy runs its methods inline when already on the signaling thread,
+  // so this dispatches a single time for the whole batch.
+  return signaling_thread_->Invoke<int>(RTC_FROM_HERE, [&]() {
+    int num_accepted = 0;
+    const size_t buffered = (size_t)data_channel_->buffered_amount();
+    const size_t max_buffering_size = GetMaxBufferingSize();
+    const size_t max_message_size = GetMaxMessageSize();
+    size_t budget =
+        (buffered < max_buffering_size ? max_buffering_size - buffered : 0);
+    for (int i = 0; i < count; ++i) {
+      const mrsDataChannelMessage& message = messages[i];
+      bool sent = false;
+      if ((message.size <= budget) && (message.size <= max_message_size)) {
+        rtc::CopyOnWriteBuffer storage =
+            EncodeMessage(message.data, (size_t)message.size);
+        sent = (storage.size() <= budget) && SendToTransport(storage);
+        if (sent) {
+          budget -= storage.size();
+          ++num_accepted;
+        }
+      }
+      if (!sent) {
+        messages_rejected_.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (accepted) {
+        accepted[i] = (sent ? mrsBool::kTrue : mrsBool::kFalse);
+      }
+    }
+    return num_accepted;
+  });
+}
+
+void DataChannel::EnableSendQueue(size_t high_watermark,
+                                  size_t low_watermark) noexcept {
+  RTC_DCHECK_LT(low_watermark, high_watermark);
+  RTC_DCHECK_LE(high_watermark, GetMaxBufferingSize());
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&]() {
+    send_queue_enabled_ = true;
+    high_watermark_ = high_watermark;
+    low_watermark_ = low_watermark;
+    DrainSendQueue();
+  });
+}
+
+void DataChannel::DisableSendQueue() noexcept {
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&]() {
+    send_queue_enabled_ = false;
+    send_queue_.clear();
+    send_queue_bytes_ = 0;
+    send_queue_memory_charge_.Set(send_queue_bytes_);
+    writable_pending_ = false;
+    UpdateSendPending();
+  });
+}
+
+Result DataChannel::QueueSend(const void* data, size_t size) noexcept {
+  if (size > GetMaxMessageSize()) {
+    return Result::kInvalidParameter;
+  }
+  // Copy outside of the signaling thread, which is shared by all channels.
+  return QueueEncoded(EncodeMessage(data, size));
+}
+
+Result DataChannel::QueueSend(rtc::CopyOnWriteBuffer message) noexcept {
+  if (message.size() > GetMaxMessageSize()) {
+    return Result::kInvalidParameter;
+  }
+  if (!compressed_) {
+    return QueueEncoded(std::move(message));
+  }
+  return QueueEncoded(EncodeMessage(message.cdata(), message.size()));
+}
+
+Result DataChannel::QueueEncoded(rtc::CopyOnWriteBuffer message) noexcept {
+  const size_t size = message.size();
+  if (size > GetMaxBufferingSize()) {
+    return Result::kInvalidParameter;
+  }
+  return signaling_thread_->Invoke<Result>(RTC_FROM_HERE, [&]() {
+    if (!send_queue_enabled_) {
+      return Result::kInvalidOperation;
+    }
+    // Always accept a message when nothing is pending, even if larger than
+    // the high watermark, so that it can eventually be sent.
+    const size_t pending =
+        send_queue_bytes_ + (size_t)data_channel_->buffered_amount();
+    if ((pending > 0) && (pending + size > high_watermark_)) {
+      writable_pending_ = true;
+      messages_rejected_.fetch_add(1, std::memory_order_relaxed);
+      return Result::kDataChannelSendQueueFull;
+    }
+    send_queue_.push_back(std::move(message));
+    send_queue_bytes_ += size;
+    send_queue_memory_charge_.Set(send_queue_bytes_);
+    DrainSendQueue();
+    return Result::kSuccess;
+  });
+}
+
+void DataChannel::EnableReceiveRing(
+    size_t capacity,
+    size_t max_messages,
+    MessageRing::OverflowPolicy policy) noexcept {
+  // Allocate outside of the lock, which the signaling thread takes for each
+  // message received.
+  auto ring = std::make_unique<MessageRing>(capacity, max_messages, policy);
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  receive_ring_ = std::move(ring);
+}
 
-  rtc::CopyOnWriteBuffer bufferStorage((const char*)data, size);
-  webrtc::DataBuffer buffer(bufferStorage, /* binary = */ true);
-  return data_channel_->Send(buffer);
+void DataChannel::DisableReceiveRing() noexcept {
+  // Free the ring after releasing the lock, which is destroyed first.
+  std::unique_ptr<MessageRing> ring;
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  ring = std::move(receive_ring_);
+}
+
+Result DataChannel::TryReceive(void* buffer,
+                               size_t capacity,
+                               size_t* size_out,
+                               bool* received) noexcept {
+  *size_out = 0;
+  *received = false;
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  if (!receive_ring_) {
+    return Result::kInvalidOperation;
+  }
+  if (receive_ring_->empty()) {
+    return Result::kSuccess;
+  }
+  const size_t size = receive_ring_->FrontSize();
+  *size_out = size;
+  if (size > capacity) {
+    // Leave the message in the ring, for the caller to retry with a buffer
+    // large enough.
+    return Result::kBufferTooSmall;
+  }
+  receive_ring_->PopFront(buffer);
+  *received = true;
+  return Result::kSuccess;
+}
+
+Result DataChannel::ReceiveMany(void* buffer,
+                                size_t capacity,
+                                mrsDataChannelMessage* messages,
+                                int max_messages,
+                                int* count) noexcept {
+  *count = 0;
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  if (!receive_ring_) {
+    return Result::kInvalidOperation;
+  }
+  uint8_t* dst = static_cast<uint8_t*>(buffer);
+  size_t offset = 0;
+  int num_received = 0;
+  while ((num_received < max_messages) && !receive_ring_->empty()) {
+    const size_t size = receive_ring_->FrontSize();
+    if (size > capacity - offset) {
+      break;
+    }
+    receive_ring_->PopFront(dst + offset);
+    messages[num_received].data = dst + offset;
+    messages[num_received].size = size;
+    offset += size;
+    ++num_received;
+  }
+  *count = num_received;
+  if ((num_received == 0) && !receive_ring_->empty()) {
+    // Not even the oldest message fits.
+    return Result::kBufferTooSmall;
+  }
+  return Result::kSuccess;
+}
+
+uint64_t DataChannel::GetReceiveDroppedCount() const noexcept {
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  return (receive_ring_ ? receive_ring_->dropped_count() : 0);
+}
+
+void DataChannel::SetStreamReceiver(
+    std::unique_ptr<DataChannelStreamReceiver> receiver) noexcept {
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&]() {
+    if (stream_receiver_) {
+      stream_receiver_->AbortAll();
+    }
+    stream_receiver_ = std::move(receiver);
+  });
+}
+
+void DataChannel::DrainSendQueue() noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (!send_queue_enabled_ || draining_) {
+    return;
+  }
+  draining_ = true;
+  while (!send_queue_.empty()) {
+    // Channels of a higher priority resume this one once they drained.
+    if (owner_ && owner_->HasDataChannelSendPendingAbove(send_priority_)) {
+      break;
+    }
+    const rtc::CopyOnWriteBuffer& message = send_queue_.front();
+    // Keep the transport buffering below the high watermark and the buffering
+    // capacity, which also keeps it below the limit past which it closes the
+    // channel.
+    const size_t buffered = (size_t)data_channel_->buffered_amount();
+    const size_t limit = std::min(high_watermark_, GetMaxBufferingSize());
+    if ((buffered > 0) && (buffered + message.size() > limit)) {
+      break;
+    }
+    // This fails until the channel is open, in which case the messages are
+    // kept until it is.
+    if (!SendToTransport(message)) {
+      break;
+    }
+    send_queue_bytes_ -= message.size();
+    send_queue_memory_charge_.Set(send_queue_bytes_);
+    send_queue_.pop_front();
+  }
+  draining_ = false;
+  UpdateSendPending();
+
+  if (writable_pending_ &&
+      (send_queue_bytes_ + (size_t)data_channel_->buffered_amount() <
+       low_watermark_)) {
+    writable_pending_ = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (writable_callback_) {
+      writable_callback_();
+    }
+  }
 }
 
 void DataChannel::InvokeOnStateChange() const noexcept {
@@ -92,23 +574,110 @@ void DataChannel::InvokeOnStateChange() const noexcept {
 
 void DataChannel::OnStateChange() noexcept {
   InvokeOnStateChange();
+  switch (data_channel_->state()) {
+    case webrtc::DataChannelInterface::kOpen:
+      // Send the messages queued while connecting.
+      DrainSendQueue();
+      break;
+    case webrtc::DataChannelInterface::kClosing:
+    case webrtc::DataChannelInterface::kClosed:
+      send_queue_.clear();
+      send_queue_bytes_ = 0;
+      send_queue_memory_charge_.Set(send_queue_bytes_);
+      UpdateSendPending();
+      if (stream_receiver_) {
+        stream_receiver_->AbortAll();
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 void DataChannel::OnMessage(const webrtc::DataBuffer& buffer) noexcept {
+  MRS_TRACE_SCOPE2(DataChannel, "DataChannel::OnMessage", "channel",
+                   (intptr_t)this, "size", buffer.data.size());
+  if (!buffer.binary && IsPadding(buffer.data)) {
+    return;
+  }
+  if (!buffer.binary &&
+      (latency_probe_interval_ms_.load(std::memory_order_relaxed) > 0) &&
+      HandleLatencyProbe(buffer.data)) {
+    return;
+  }
+  messages_received_.fetch_add(1, std::memory_order_relaxed);
+  bytes_received_.fetch_add(buffer.data.size(), std::memory_order_relaxed);
+  const uint8_t* data = buffer.data.cdata();
+  size_t size = buffer.data.size();
+  if (compressed_ && !DecodeMessage(buffer.data, &data, &size)) {
+    RTC_LOG(LS_ERROR) << "Dropping malformed message of " << buffer.data.size()
+                      << " bytes received on compressed data channel "
+                      << label() << ".";
+    return;
+  }
+  if (stream_receiver_) {
+    stream_receiver_->OnMessage(data, size);
+    return;
+  }
+  bool became_available = false;
+  {
+    std::lock_guard<std::mutex> lock(receive_mutex_);
+    if (receive_ring_) {
+      const bool was_empty = receive_ring_->empty();
+      became_available = receive_ring_->Push(data, size) && was_empty;
+      if (!became_available) {
+        return;
+      }
+    }
+  }
   std::lock_guard<std::mutex> lock(mutex_);
-  if (message_callback_) {
-    message_callback_(buffer.data.data(), buffer.data.size());
+  if (became_available) {
+    // Notify only when the ring stops being empty, instead of for each
+    // message, so the consumer is expected to drain it. This is fired outside
+    // of the ring lock, so the callback can pull messages right away.
+    if (data_available_callback_) {
+      data_available_callback_();
+    }
+  } else if (message_callback_) {
+    message_callback_(data, size);
   }
 }
 
 void DataChannel::OnBufferedAmountChange(uint64_t previous_amount) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (buffering_callback_) {
-    uint64_t current_amount = data_channel_->buffered_amount();
-    constexpr uint64_t max_capacity =
-        0x1000000;  // 16MB, see DataChannelInterface
-    buffering_callback_(previous_amount, current_amount, max_capacity);
+  const uint64_t current_amount = data_channel_->buffered_amount();
+  buffered_amount_.store(current_amount, std::memory_order_relaxed);
+  if (current_amount > peak_buffered_amount_.load(std::memory_order_relaxed)) {
+    peak_buffered_amount_.store(current_amount, std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffering_callback_) {
+      buffering_callback_(previous_amount, current_amount,
+                          GetMaxBufferingSize());
+    }
+  }
+  // The transport sent some data, refill it from the send queue.
+  DrainSendQueue();
+  UpdateSendPending();
+}
+
+void DataChannel::UpdateSendPending() noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  // Channels still connecting keep their messages queued without holding the
+  // other channels back.
+  const bool pending =
+      (data_channel_->state() == webrtc::DataChannelInterface::kOpen) &&
+      ((send_queue_bytes_ > 0) || (data_channel_->buffered_amount() > 0));
+  if ((send_pending_.exchange(pending) != pending) && owner_) {
+    owner_->OnDataChannelSendPending(send_priority_, pending);
+  }
+}
+
+void DataChannel::OnRemovedFromPeerConnection() noexcept {
+  if (send_pending_.exchange(false) && owner_) {
+    owner_->OnDataChannelSendPending(send_priority_, false);
   }
+  owner_ = nullptr;
 }
 
 }  // namespace WebRTC
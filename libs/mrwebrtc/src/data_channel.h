@@ -4,14 +4,20 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <mutex>
+#include <vector>
 
 #include "api/datachannelinterface.h"
 
 #include "callback.h"
 #include "data_channel.h"
 #include "data_channel_interop.h"
+#include "data_channel_stream.h"
 #include "interop_api.h"
+#include "memory_accounting.h"
+#include "message_ring.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -38,18 +44,38 @@ class DataChannel : public webrtc::DataChannelObserver {
   /// Callback fired when data buffering changed.
   /// The first parameter indicates the old buffering amount in bytes, the
   /// second one the new value, and the last one indicates the limit in bytes
-  /// (buffer capacity). This is important because if the send buffer is full
-  /// then any attempt to send data will abruptly close the data channel. See
-  /// comment in webrtc::DataChannelInterface::Send() for details. Current
-  /// WebRTC implementation has a limit of 16MB for the buffer capacity.
+  /// (buffer capacity), as set with |SetLimits()|. This is important because
+  /// if the transport send buffer is full then any attempt to send data will
+  /// abruptly close the data channel. See comment in
+  /// webrtc::DataChannelInterface::Send() for details. Current WebRTC
+  /// implementation has a limit of 16MB for the buffer capacity.
   using BufferingCallback =
       Callback<const uint64_t, const uint64_t, const uint64_t>;
 
   /// Callback fired when the data channel state changed.
   using StateCallback = Callback<mrsDataChannelState, int>;
 
+  /// Callback fired when the send queue accepts messages again after having
+  /// rejected one.
+  using WritableCallback = Callback<>;
+
+  /// Callback fired when the receive ring holds messages again after having
+  /// been emptied.
+  using DataAvailableCallback = Callback<>;
+
+  /// Protocol of the data channels compressing their messages.
+  static constexpr const char* kCompressedProtocol = "mrs-lz4";
+
+  /// Default size in bytes from which messages are compressed.
+  static constexpr const size_t kDefaultCompressionThreshold = 128;
+
+  /// Buffering size in bytes past which the WebRTC transport closes the data
+  /// channel, which is also the default buffering capacity.
+  static constexpr const size_t kMaxTransportBufferingSize = 0x1000000;  // 16MB
+
   DataChannel(
       PeerConnection* owner,
+      rtc::Thread* signaling_thread,
       rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) noexcept;
 
   /// Remove the data channel from its parent PeerConnection and close it.
@@ -74,23 +100,143 @@ class DataChannel : public webrtc::DataChannelObserver {
     if (data_channel_->reliable()) {
       flags = flags | mrsDataChannelConfigFlags::kReliable;
     }
+    if (compressed_) {
+      flags = flags | mrsDataChannelConfigFlags::kCompressed;
+    }
     return flags;
   }
 
+  /// Get the maximum number of retransmissions of a message of a partially
+  /// reliable channel, or -1 if not limited.
+  MRS_NODISCARD int max_retransmits() const {
+    return FromReliabilityLimit(data_channel_->maxRetransmits());
+  }
+
+  /// Get the maximum lifetime in milliseconds of a message of a partially
+  /// reliable channel, or -1 if not limited.
+  MRS_NODISCARD int max_packet_lifetime_ms() const {
+    return FromReliabilityLimit(data_channel_->maxRetransmitTime());
+  }
+
   /// Get the friendly channel name.
   MRS_NODISCARD std::string label() const;
 
   void SetMessageCallback(MessageCallback callback) noexcept;
   void SetBufferingCallback(BufferingCallback callback) noexcept;
   void SetStateCallback(StateCallback callback) noexcept;
+  void SetWritableCallback(WritableCallback callback) noexcept;
+  void SetDataAvailableCallback(DataAvailableCallback callback) noexcept;
 
   /// Get the maximum buffering size, in bytes, before |Send()| stops accepting
   /// data.
-  MRS_NODISCARD size_t GetMaxBufferingSize() const noexcept;
+  MRS_NODISCARD size_t GetMaxBufferingSize() const noexcept {
+    return max_buffering_size_.load(std::memory_order_relaxed);
+  }
+
+  /// Get the maximum size in bytes of a message sent, before compression.
+  MRS_NODISCARD size_t GetMaxMessageSize() const noexcept {
+    return max_message_size_.load(std::memory_order_relaxed);
+  }
+
+  /// Check that |limits| are within the transport limits and consistent.
+  MRS_NODISCARD static bool AreLimitsValid(
+      const mrsDataChannelLimits& limits) noexcept;
+
+  /// Set the buffering capacity and maximum message size. See
+  /// |mrsDataChannelSetLimits|.
+  Result SetLimits(const mrsDataChannelLimits& limits) noexcept;
 
   /// Send a blob of data through the data channel.
   bool Send(const void* data, size_t size) noexcept;
 
+  /// Send a buffer through the data channel without copying its content. The
+  /// buffer is shared with the transport, which releases it once sent.
+  bool Send(rtc::CopyOnWriteBuffer buffer) noexcept;
+
+  /// Send a batch of |count| messages through the data channel, checking the
+  /// buffering limit once and dispatching once to the signaling thread for
+  /// the whole batch, instead of once per message. Each message is accepted
+  /// or rejected individually, in order; |accepted|, if not null, receives
+  /// whether each was accepted. Returns the number of messages accepted.
+  int SendBatch(const mrsDataChannelMessage* messages,
+                int count,
+                mrsBool* accepted) noexcept;
+
+  /// Enable the send queue, which buffers messages natively and drains them
+  /// into the transport as it sends data, keeping the bytes pending in both
+  /// below |high_watermark|. See |mrsDataChannelSetSendQueue|.
+  void EnableSendQueue(size_t high_watermark, size_t low_watermark) noexcept;
+
+  /// Disable the send queue, discarding the messages it still holds.
+  void DisableSendQueue() noexcept;
+
+  /// Queue a message for sending. See |mrsDataChannelQueueMessage|.
+  Result QueueSend(const void* data, size_t size) noexcept;
+
+  /// Queue a message for sending, without copying it again.
+  Result QueueSend(rtc::CopyOnWriteBuffer message) noexcept;
+
+  /// Get the sending side of the streams of this data channel.
+  MRS_NODISCARD DataChannelStreamSender& stream_sender() noexcept {
+    return stream_sender_;
+  }
+
+  /// Set the receiving side of the streams of this data channel, which then
+  /// handles all the messages received, or clear it to resume delivering
+  /// messages normally. Streams still being received are aborted.
+  void SetStreamReceiver(
+      std::unique_ptr<DataChannelStreamReceiver> receiver) noexcept;
+
+  /// Enable the receive ring, which stores received messages natively until
+  /// pulled with |TryReceive()| or |ReceiveMany()|, instead of delivering them
+  /// to the message callback. See |mrsDataChannelSetReceiveRing|.
+  void EnableReceiveRing(size_t capacity,
+                         size_t max_messages,
+                         MessageRing::OverflowPolicy policy) noexcept;
+
+  /// Disable the receive ring, discarding the messages it still holds, and
+  /// resume delivering messages to the message callback.
+  void DisableReceiveRing() noexcept;
+
+  /// Pull the oldest message of the receive ring into |buffer|. See
+  /// |mrsDataChannelTryReceiveMessage|.
+  Result TryReceive(void* buffer,
+                    size_t capacity,
+                    size_t* size_out,
+                    bool* received) noexcept;
+
+  /// Pull as many whole messages of the receive ring as fit in |buffer|, up
+  /// to |max_messages|. See |mrsDataChannelReceiveMessages|.
+  Result ReceiveMany(void* buffer,
+                     size_t capacity,
+                     mrsDataChannelMessage* messages,
+                     int max_messages,
+                     int* count) noexcept;
+
+  /// Get the number of messages the receive ring dropped on overflow.
+  MRS_NODISCARD uint64_t GetReceiveDroppedCount() const noexcept;
+
+  /// Set the size in bytes from which messages are compressed, if the data
+  /// channel compresses its messages. See
+  /// |mrsDataChannelSetCompressionThreshold|.
+  void SetCompressionThreshold(size_t threshold) noexcept {
+    compression_threshold_.store(threshold, std::memory_order_relaxed);
+  }
+
+  /// Read the traffic counters of the data channel, without dispatching to
+  /// the signaling thread. See |mrsDataChannelGetCounters|.
+  void GetCounters(mrsDataChannelCounters& counters) const noexcept;
+
+  /// Set the interval between latency probes, or disable them with zero.
+  /// See |mrsDataChannelSetLatencyProbeInterval|.
+  void SetLatencyProbeInterval(int interval_ms) noexcept;
+
+  /// Send a padding message of |size| bytes, which the remote data channel
+  /// drops, unless the channel is not open or this would buffer more than
+  /// |max_buffered| bytes. Padding is not counted in the counters. Return
+  /// |false| if the padding was not sent.
+  bool SendPadding(size_t size, size_t max_buffered) noexcept;
+
   //
   // Advanced use
   //
@@ -101,7 +247,25 @@ class DataChannel : public webrtc::DataChannelObserver {
 
   /// This is invoked automatically by PeerConnection::RemoveDataChannel().
   /// Do not call it manually.
-  void OnRemovedFromPeerConnection() noexcept { owner_ = nullptr; }
+  void OnRemovedFromPeerConnection() noexcept;
+
+  /// Set the priority of the send queue of this channel over the other
+  /// channels of its connection. This is set by the peer connection when it
+  /// creates the channel, before handing it out.
+  void SetSendPriority(mrsDataChannelPriority priority) noexcept {
+    send_priority_ = priority;
+  }
+
+  /// Get the priority of the send queue of this channel.
+  MRS_NODISCARD mrsDataChannelPriority send_priority() const noexcept {
+    return send_priority_;
+  }
+
+  /// Hand over the queued messages to the transport, up to the high watermark,
+  /// unless a channel of a higher priority has data pending, and fire the
+  /// writable callback if the queue drained enough. Only called on the
+  /// signaling thread.
+  void DrainSendQueue() noexcept;
 
   /// Fire the event now.
   void InvokeOnStateChange() const noexcept;
@@ -117,20 +281,146 @@ class DataChannel : public webrtc::DataChannelObserver {
   void OnBufferedAmountChange(uint64_t previous_amount) noexcept override;
 
  private:
+  /// Report to the owner whether this channel has data pending to send, if
+  /// that changed. Only called on the signaling thread.
+  void UpdateSendPending() noexcept;
+
+  /// Encode a message for sending, compressing it on a compressed channel if
+  /// large enough and if it compresses.
+  rtc::CopyOnWriteBuffer EncodeMessage(const void* data,
+                                       size_t size) const noexcept;
+
+  /// Decode a message received on a compressed channel, returning its
+  /// content in |data| and |size|, or |false| if it is malformed. Only called
+  /// on the signaling thread.
+  bool DecodeMessage(const rtc::CopyOnWriteBuffer& message,
+                     const uint8_t** data,
+                     size_t* size) noexcept;
+
+  bool SendEncoded(const rtc::CopyOnWriteBuffer& message) noexcept;
+
+  /// Hand over a message to the transport, and count it if accepted.
+  bool SendToTransport(const rtc::CopyOnWriteBuffer& message) noexcept;
+
+  /// Send a latency probe if the probe interval elapsed since the last one.
+  void MaybeSendLatencyProbe() noexcept;
+
+  /// Handle a text message received, which carries latency probes. Return
+  /// |false| if the message is not a probe. Only called on the signaling
+  /// thread.
+  bool HandleLatencyProbe(const rtc::CopyOnWriteBuffer& message) noexcept;
+  Result QueueEncoded(rtc::CopyOnWriteBuffer message) noexcept;
+
+  /// Convert a limit reported by WebRTC, which truncates the unset value -1 to
+  /// 16 bits.
+  static constexpr int FromReliabilityLimit(uint16_t limit) noexcept {
+    return (limit == 0xFFFF ? -1 : (int)limit);
+  }
+
+  /// Check if |size| more bytes can be buffered without closing the channel.
+  MRS_NODISCARD bool CanBuffer(size_t size) const noexcept {
+    return (data_channel_->buffered_amount() + size <= GetMaxBufferingSize());
+  }
+
+  /// Check if a message of |size| bytes, before compression, can be sent.
+  MRS_NODISCARD bool CanSend(size_t size) const noexcept {
+    return (size <= GetMaxMessageSize()) && CanBuffer(size);
+  }
+
   /// PeerConnection object owning this data channel. This is only valid from
   /// creation until the data channel is removed from the peer connection with
   /// RemoveDataChannel(), at which point the data channel is removed from its
   /// parent's collection and |owner_| is set to nullptr.
   PeerConnection* owner_{};
 
+  /// Thread the data channel proxy dispatches its calls to.
+  rtc::Thread* const signaling_thread_;
+
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel_;
 
+  /// Are messages compressed, as negotiated through the channel protocol?
+  const bool compressed_;
+
+  std::atomic<size_t> compression_threshold_{kDefaultCompressionThreshold};
+
+  /// Limits of the messages sent. See |SetLimits()|.
+  std::atomic<size_t> max_buffering_size_{kMaxTransportBufferingSize};
+  std::atomic<size_t> max_message_size_{kMaxTransportBufferingSize};
+
+  /// Buffer messages are decompressed into, reused across messages to avoid
+  /// allocations. Only accessed on the signaling thread.
+  std::vector<uint8_t> decompress_buffer_;
+
   MessageCallback message_callback_ RTC_GUARDED_BY(mutex_);
   BufferingCallback buffering_callback_ RTC_GUARDED_BY(mutex_);
   StateCallback state_callback_ RTC_GUARDED_BY(mutex_);
+  WritableCallback writable_callback_ RTC_GUARDED_BY(mutex_);
+  DataAvailableCallback data_available_callback_ RTC_GUARDED_BY(mutex_);
   mutable std::mutex mutex_;
 
+  /// Receive ring, pulled from any thread while messages are pushed on the
+  /// signaling thread. This has its own lock, distinct from the one held
+  /// while firing callbacks, so that the data available callback can pull
+  /// messages.
+  std::unique_ptr<MessageRing> receive_ring_ RTC_GUARDED_BY(receive_mutex_);
+  mutable std::mutex receive_mutex_;
+
+  //
+  // Send queue state, only accessed on the signaling thread.
+  //
+
+  bool send_queue_enabled_{false};
+  size_t high_watermark_{0};
+  size_t low_watermark_{0};
+  std::deque<rtc::CopyOnWriteBuffer> send_queue_;
+
+  /// Total size of the messages in |send_queue_|, in bytes.
+  size_t send_queue_bytes_{0};
+
+  /// Accounting of |send_queue_bytes_| as data channel queue memory.
+  MemoryCharge send_queue_memory_charge_{MemoryCategory::kDataChannelQueues};
+
+  /// Was a message rejected since the writable callback last fired?
+  bool writable_pending_{false};
+
+  /// Priority of the send queue over the other channels of the connection.
+  mrsDataChannelPriority send_priority_{mrsDataChannelPriority::kLow};
+
+  /// Has this channel data queued or buffered by the transport, as last
+  /// reported to its owner? This is cleared from any thread when the channel
+  /// is removed from its owner.
+  std::atomic_bool send_pending_{false};
+
+  /// Is |DrainSendQueue()| running? The transport can notify a change of its
+  /// buffered amount while sending, which must not drain recursively.
+  bool draining_{false};
+
+  /// Receiving side of the streams, only accessed on the signaling thread.
+  std::unique_ptr<DataChannelStreamReceiver> stream_receiver_;
+
+  DataChannelStreamSender stream_sender_{*this};
+
+  //
+  // Traffic counters, updated without locking. The buffered amount and its
+  // peak, and the latency estimate, are only written on the signaling thread.
+  //
+
+  std::atomic<uint64_t> messages_sent_{0};
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> messages_received_{0};
+  std::atomic<uint64_t> bytes_received_{0};
+  std::atomic<uint64_t> messages_rejected_{0};
+  std::atomic<uint64_t> buffered_amount_{0};
+  std::atomic<uint64_t> peak_buffered_amount_{0};
+  std::atomic<int64_t> latency_us_{-1};
+
+  /// Interval between latency probes, or zero if disabled.
+  std::atomic<int> latency_probe_interval_ms_{0};
+
+  /// Time the last latency probe was sent, in microseconds.
+  std::atomic<int64_t> last_probe_time_us_{0};
+
   /// Opaque user data.
   void* user_data_{nullptr};
 };
@@ -0,0 +1,237 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "data_channel.h"
+#include "data_channel_stream.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+constexpr const size_t kMaxFragmentSize =
+    kMaxStreamFrameSize - sizeof(StreamFrameHeader);
+
+/// Allocate a frame with room for |payload_size| bytes after its header, and
+/// write the header.
+rtc::CopyOnWriteBuffer MakeFrame(StreamFrameHeader::Type type,
+                                 uint32_t stream_id,
+                                 uint64_t value,
+                                 size_t payload_size) {
+  StreamFrameHeader header{};
+  header.magic = StreamFrameHeader::kMagic;
+  header.type = type;
+  header.stream_id = stream_id;
+  header.value = value;
+  rtc::CopyOnWriteBuffer frame(sizeof(header) + payload_size);
+  memcpy(frame.data(), &header, sizeof(header));
+  return frame;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result DataChannelStreamSender::Open(uint64_t total_size,
+                                     uint32_t* stream_id) noexcept {
+  // Fragments are reassembled by offset, without any sequence number, so
+  // they must arrive in order and without loss.
+  const uint32_t required_flags =
+      (uint32_t)mrsDataChannelConfigFlags::kOrdered |
+      (uint32_t)mrsDataChannelConfigFlags::kReliable;
+  if (((uint32_t)data_channel_.flags() & required_flags) != required_flags) {
+    RTC_LOG(LS_ERROR) << "Cannot open a stream on data channel "
+                      << data_channel_.label()
+                      << " which is not ordered and reliable.";
+    return Result::kInvalidOperation;
+  }
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = next_stream_id_++;
+  }
+  const Result result = data_channel_.QueueSend(
+      MakeFrame(StreamFrameHeader::Type::kOpen, id, total_size, 0));
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (total_size > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.emplace(id, OutgoingStream{total_size, 0});
+  }
+  *stream_id = id;
+  return Result::kSuccess;
+}
+
+Result DataChannelStreamSender::Write(uint32_t stream_id,
+                                      const void* data,
+                                      uint64_t size,
+                                      uint64_t* written) noexcept {
+  *written = 0;
+  uint64_t offset;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+      return Result::kNotFound;
+    }
+    if (size > it->second.total_size - it->second.offset) {
+      return Result::kInvalidParameter;
+    }
+    offset = it->second.offset;
+  }
+
+  // Queue fragments until the send queue is full. Each fragment is copied
+  // straight into the frame handed over to the transport, and the frames stay
+  // within the maximum message size of the data channel.
+  const size_t max_message_size = data_channel_.GetMaxMessageSize();
+  if (max_message_size <= sizeof(StreamFrameHeader)) {
+    return Result::kInvalidOperation;
+  }
+  const size_t max_fragment_size = std::min(
+      kMaxFragmentSize, max_message_size - sizeof(StreamFrameHeader));
+  auto src = static_cast<const uint8_t*>(data);
+  uint64_t remaining = size;
+  Result result = Result::kSuccess;
+  while (remaining > 0) {
+    const size_t fragment_size =
+        (size_t)std::min<uint64_t>(remaining, max_fragment_size);
+    rtc::CopyOnWriteBuffer frame = MakeFrame(
+        StreamFrameHeader::Type::kData, stream_id, offset, fragment_size);
+    memcpy(frame.data() + sizeof(StreamFrameHeader), src, fragment_size);
+    result = data_channel_.QueueSend(std::move(frame));
+    if (result != Result::kSuccess) {
+      break;
+    }
+    src += fragment_size;
+    offset += fragment_size;
+    remaining -= fragment_size;
+    *written += fragment_size;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end()) {
+      it->second.offset = offset;
+      if (offset == it->second.total_size) {
+        // The receiver completes the stream on its last fragment.
+        streams_.erase(it);
+      }
+    }
+  }
+
+  // A full queue is not an error; the writable callback signals when to
+  // write the rest.
+  if (result == Result::kDataChannelSendQueueFull) {
+    return Result::kSuccess;
+  }
+  return result;
+}
+
+Result DataChannelStreamSender::Abort(uint32_t stream_id) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (streams_.erase(stream_id) == 0) {
+      return Result::kNotFound;
+    }
+  }
+  return data_channel_.QueueSend(
+      MakeFrame(StreamFrameHeader::Type::kAbort, stream_id, 0, 0));
+}
+
+void DataChannelStreamReceiver::OnMessage(const uint8_t* data,
+                                          size_t size) noexcept {
+  StreamFrameHeader header;
+  if (size < sizeof(header)) {
+    RTC_LOG(LS_WARNING) << "Ignoring data channel message of " << size
+                        << " bytes, too small for a stream frame.";
+    return;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != StreamFrameHeader::kMagic) {
+    RTC_LOG(LS_WARNING) << "Ignoring data channel message which is not a "
+                           "stream frame.";
+    return;
+  }
+  const uint32_t stream_id = header.stream_id;
+  switch (header.type) {
+    case StreamFrameHeader::Type::kOpen: {
+      if (streams_.find(stream_id) != streams_.end()) {
+        RTC_LOG(LS_WARNING) << "Data channel stream " << stream_id
+                            << " opened twice.";
+        Complete(stream_id, Result::kDataChannelStreamAborted);
+      }
+      const uint64_t total_size = header.value;
+      void* const destination = opened_callback_(stream_id, total_size);
+      if (!destination && (total_size > 0)) {
+        // Rejected; the fragments of the stream are ignored.
+        return;
+      }
+      if (total_size == 0) {
+        completed_callback_(stream_id, Result::kSuccess);
+        return;
+      }
+      streams_.emplace(stream_id,
+                       IncomingStream{static_cast<uint8_t*>(destination),
+                                      total_size, 0});
+      break;
+    }
+    case StreamFrameHeader::Type::kData: {
+      auto it = streams_.find(stream_id);
+      if (it == streams_.end()) {
+        // Rejected or aborted stream.
+        return;
+      }
+      IncomingStream& stream = it->second;
+      const size_t fragment_size = size - sizeof(header);
+      if ((header.value != stream.received) ||
+          (fragment_size > stream.total_size - stream.received)) {
+        RTC_LOG(LS_ERROR) << "Invalid fragment of " << fragment_size
+                          << " bytes at offset " << header.value
+                          << " for data channel stream " << stream_id << ".";
+        Complete(stream_id, Result::kDataChannelStreamAborted);
+        return;
+      }
+      memcpy(stream.destination + stream.received, data + sizeof(header),
+             fragment_size);
+      stream.received += fragment_size;
+      progress_callback_(stream_id, stream.received, stream.total_size);
+      if (stream.received == stream.total_size) {
+        Complete(stream_id, Result::kSuccess);
+      }
+      break;
+    }
+    case StreamFrameHeader::Type::kAbort:
+      if (streams_.find(stream_id) != streams_.end()) {
+        Complete(stream_id, Result::kDataChannelStreamAborted);
+      }
+      break;
+    default:
+      RTC_LOG(LS_WARNING) << "Ignoring data channel stream frame of unknown "
+                          << "type " << (int)header.type << ".";
+      break;
+  }
+}
+
+void DataChannelStreamReceiver::AbortAll() noexcept {
+  while (!streams_.empty()) {
+    Complete(streams_.begin()->first, Result::kDataChannelStreamAborted);
+  }
+}
+
+void DataChannelStreamReceiver::Complete(uint32_t stream_id,
+                                         Result result) noexcept {
+  // Forget the stream before the callback, which may release its destination.
+  streams_.erase(stream_id);
+  completed_callback_(stream_id, result);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "callback.h"
+#include "result.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class DataChannel;
+
+/// Streams are large payloads transferred through a data channel as a
+/// sequence of messages, each carrying a fixed-size frame header followed by
+/// a fragment of the payload. A stream starts with an open frame announcing
+/// its total size, followed by data frames in offset order, and ends once all
+/// its bytes are transferred, or with an abort frame. This relies on the data
+/// channel being ordered and reliable.
+struct StreamFrameHeader {
+  enum class Type : uint8_t {
+    kOpen = 1,
+    kData = 2,
+    kAbort = 3,
+  };
+
+  /// Magic number identifying stream frames, "MRST" in memory order.
+  static constexpr uint32_t kMagic = 0x5453524Du;
+
+  uint32_t magic;
+  Type type;
+  uint8_t reserved[3];
+  uint32_t stream_id;
+  uint32_t reserved2;
+
+  /// Total size of the stream for an open frame, or offset of the fragment
+  /// for a data frame.
+  uint64_t value;
+};
+static_assert(sizeof(StreamFrameHeader) == 24, "");
+
+/// Maximum size of a stream frame, header included. This stays within the
+/// message size all SCTP implementations accept.
+constexpr const size_t kMaxStreamFrameSize = 64 * 1024;
+
+/// Sending side of the streams of a data channel. Each stream is fragmented
+/// into frames queued with |DataChannel::QueueSend()|, so the send queue of
+/// the channel paces the transfer and bounds the memory it uses.
+class DataChannelStreamSender {
+ public:
+  explicit DataChannelStreamSender(DataChannel& data_channel) noexcept
+      : data_channel_(data_channel) {}
+
+  /// Open a stream of |total_size| bytes. See |mrsDataChannelOpenStream|.
+  Result Open(uint64_t total_size, uint32_t* stream_id) noexcept;
+
+  /// Write the next bytes of a stream, as many as the send queue accepts.
+  /// See |mrsDataChannelWriteStream|.
+  Result Write(uint32_t stream_id,
+               const void* data,
+               uint64_t size,
+               uint64_t* written) noexcept;
+
+  /// Abort a stream before all its bytes were written.
+  Result Abort(uint32_t stream_id) noexcept;
+
+ private:
+  struct OutgoingStream {
+    uint64_t total_size;
+    uint64_t offset;
+  };
+
+  DataChannel& data_channel_;
+
+  /// Streams open and not fully written yet. The lock is never held while
+  /// queuing frames, which dispatches to the signaling thread.
+  std::unordered_map<uint32_t, OutgoingStream> streams_ RTC_GUARDED_BY(mutex_);
+  uint32_t next_stream_id_ RTC_GUARDED_BY(mutex_) = 1;
+  std::mutex mutex_;
+};
+
+/// Receiving side of the streams of a data channel, which reassembles each
+/// stream in place into a destination supplied by the application. This only
+/// holds the state of the streams, and is only accessed on the signaling
+/// thread.
+class DataChannelStreamReceiver {
+ public:
+  /// Callback fired when a stream opens, returning the destination of the
+  /// stream content, or NULL to reject the stream.
+  using OpenedCallback = RetCallback<void*, uint32_t, uint64_t>;
+
+  /// Callback fired after each fragment of a stream is received.
+  using ProgressCallback = Callback<uint32_t, uint64_t, uint64_t>;
+
+  /// Callback fired when a stream is fully received, or aborted.
+  using CompletedCallback = Callback<uint32_t, Result>;
+
+  DataChannelStreamReceiver(OpenedCallback opened_callback,
+                            ProgressCallback progress_callback,
+                            CompletedCallback completed_callback) noexcept
+      : opened_callback_(opened_callback),
+        progress_callback_(progress_callback),
+        completed_callback_(completed_callback) {}
+
+  /// Handle a message received by the data channel.
+  void OnMessage(const uint8_t* data, size_t size) noexcept;
+
+  /// Abort all the streams being received, for example when the channel
+  /// closes.
+  void AbortAll() noexcept;
+
+ private:
+  struct IncomingStream {
+    uint8_t* destination;
+    uint64_t total_size;
+    uint64_t received;
+  };
+
+  void Complete(uint32_t stream_id, Result result) noexcept;
+
+  OpenedCallback opened_callback_;
+  ProgressCallback progress_callback_;
+  CompletedCallback completed_callback_;
+  std::unordered_map<uint32_t, IncomingStream> streams_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "decoder_thread_budget.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+int DecoderThreadBudget::Acquire(int number_of_cores,
+                                 bool low_priority) noexcept {
+  uint32_t threads = (uint32_t)std::max(number_of_cores, 1);
+  if (low_priority) {
+    threads = 1;
+  } else if (max_threads_per_decoder_ > 0) {
+    threads = std::min(threads, max_threads_per_decoder_);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (thread_budget_ > 0) {
+    // Each decoder needs at least one thread, even past the budget.
+    const uint32_t available =
+        (threads_in_use_ < thread_budget_ ? thread_budget_ - threads_in_use_
+                                          : 0u);
+    threads = std::max(std::min(threads, available), 1u);
+  }
+  threads_in_use_ += threads;
+  return (int)threads;
+}
+
+void DecoderThreadBudget::Release(int threads) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RTC_DCHECK_GE(threads_in_use_, (uint32_t)threads);
+  threads_in_use_ -= (uint32_t)threads;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Allocation of the decoding threads among the video decoders of all the
+/// receive streams, shared by all thread groups. WebRTC lets each decoder use
+/// as many threads as there are processors, so with many streams the decoders
+/// oversubscribe the processors and compete with each other. This is
+/// multithread-safe.
+class DecoderThreadBudget {
+ public:
+  explicit DecoderThreadBudget(
+      const mrsVideoDecoderThreadingConfig& config) noexcept
+      : max_threads_per_decoder_(config.max_threads_per_decoder),
+        thread_budget_(config.thread_budget) {}
+
+  /// Reserve the threads of a decoder which WebRTC initializes with
+  /// |number_of_cores|, and return the number of threads it may use, at least
+  /// one. Low priority decoders use a single thread, leaving the rest of the
+  /// budget to the other decoders. The threads are returned to the budget with
+  /// |Release()|.
+  int Acquire(int number_of_cores, bool low_priority) noexcept;
+
+  /// Return to the budget the threads reserved with |Acquire()|.
+  void Release(int threads) noexcept;
+
+ private:
+  const uint32_t max_threads_per_decoder_;
+  const uint32_t thread_budget_;
+  std::mutex mutex_;
+  uint32_t threads_in_use_ RTC_GUARDED_BY(mutex_){0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "encoded_frame_recording.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/stringutils.h"
+#include "system_wrappers/include/cpu_info.h"
+
+#include "utils.h"
+#include "video_frame_observer.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Upper bound on the size of a recorded frame, to reject corrupted files
+/// before allocating a buffer for the frame.
+constexpr uint32_t kMaxRecordedFrameSize = 64 * 1024 * 1024;
+
+/// Decode callback delivering the replayed frames to a frame observer.
+class ReplayDecodedCallback : public webrtc::DecodedImageCallback {
+ public:
+  explicit ReplayDecodedCallback(VideoFrameObserver& observer) noexcept
+      : observer_(observer) {}
+
+  int32_t Decoded(webrtc::VideoFrame& frame) override {
+    ++decoded_count_;
+    observer_.OnFrame(frame);
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  uint32_t decoded_count() const noexcept { return decoded_count_; }
+
+ private:
+  VideoFrameObserver& observer_;
+  uint32_t decoded_count_{0};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ErrorOr<std::unique_ptr<EncodedFrameRecorder>> EncodedFrameRecorder::Create(
+    const char* path) noexcept {
+  if (IsStringNullOrEmpty(path)) {
+    return Error(Result::kInvalidParameter);
+  }
+  std::unique_ptr<webrtc::FileWrapper> file(webrtc::FileWrapper::Create());
+  if (!file->OpenFile(path, /* read_only = */ false)) {
+    RTC_LOG(LS_ERROR) << "Failed to create recording file " << path;
+    return Error(Result::kNotFound);
+  }
+  return std::unique_ptr<EncodedFrameRecorder>(
+      new EncodedFrameRecorder(std::move(file)));
+}
+
+uint32_t EncodedFrameRecorder::frame_count() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return frame_count_;
+}
+
+void EncodedFrameRecorder::OnEncodedFrame(
+    const webrtc::EncodedImage& image,
+    webrtc::VideoCodecType codec_type) noexcept {
+  const int64_t now_us = rtc::TimeMicros();
+  const bool is_keyframe = (image._frameType == webrtc::kVideoFrameKey);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (failed_) {
+    return;
+  }
+  if (!started_) {
+    // The frames before the first key frame cannot be decoded on replay.
+    if (!is_keyframe) {
+      return;
+    }
+    RecordingFileHeader header{};
+    memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.header_size = sizeof(RecordingFileHeader);
+    rtc::strcpyn(header.codec_name, sizeof(header.codec_name),
+                 webrtc::CodecTypeToPayloadString(codec_type));
+    if (!file_->Write(&header, sizeof(header))) {
+      RTC_LOG(LS_ERROR) << "Failed to write the header of a recording.";
+      failed_ = true;
+      return;
+    }
+    codec_type_ = codec_type;
+    start_time_us_ = now_us;
+    started_ = true;
+  } else if (codec_type != codec_type_) {
+    return;
+  }
+  RecordedFrameHeader frame{};
+  frame.size = (uint32_t)image._length;
+  frame.rtp_timestamp = image._timeStamp;
+  frame.arrival_time_us = now_us - start_time_us_;
+  frame.width = (uint16_t)image._encodedWidth;
+  frame.height = (uint16_t)image._encodedHeight;
+  frame.is_keyframe = (is_keyframe ? 1 : 0);
+  if (!file_->Write(&frame, sizeof(frame)) ||
+      !file_->Write(image._buffer, image._length)) {
+    RTC_LOG(LS_ERROR) << "Failed to write frame #" << frame_count_
+                      << " of a recording.";
+    failed_ = true;
+    return;
+  }
+  ++frame_count_;
+}
+
+Result ReplayEncodedFrames(const char* path,
+                           bool recorded_pacing,
+                           VideoFrameObserver& observer,
+                           mrsEncodedVideoReplayStats& stats) noexcept {
+  stats = {};
+  std::unique_ptr<webrtc::FileWrapper> file(webrtc::FileWrapper::Create());
+  if (!file->OpenFile(path, /* read_only = */ true)) {
+    return Result::kNotFound;
+  }
+  RecordingFileHeader header{};
+  if ((file->Read(&header, sizeof(header)) != sizeof(header)) ||
+      (memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0) ||
+      (header.version != kRecordingVersion) ||
+      (header.header_size != sizeof(RecordingFileHeader))) {
+    RTC_LOG(LS_ERROR) << "Invalid recording file " << path;
+    return Result::kInvalidParameter;
+  }
+  header.codec_name[sizeof(header.codec_name) - 1] = '\0';
+  const webrtc::VideoCodecType codec_type =
+      webrtc::PayloadStringToCodecType(header.codec_name);
+
+  // Decode with the built-in software decoders, which are available on all
+  // platforms, unlike the custom decoders of the peer connection factory.
+  webrtc::InternalDecoderFactory decoder_factory;
+  std::unique_ptr<webrtc::VideoDecoder> decoder =
+      decoder_factory.CreateVideoDecoder(
+          webrtc::SdpVideoFormat(header.codec_name));
+  if (!decoder) {
+    RTC_LOG(LS_ERROR) << "No decoder to replay " << header.codec_name
+                      << " recording " << path;
+    return Result::kUnsupported;
+  }
+  ReplayDecodedCallback callback(observer);
+  decoder->RegisterDecodeCompleteCallback(&callback);
+  webrtc::VideoCodec settings{};
+  settings.codecType = codec_type;
+  if (decoder->InitDecode(&settings, webrtc::CpuInfo::DetectNumberOfCores()) !=
+      WEBRTC_VIDEO_CODEC_OK) {
+    return Result::kUnsupported;
+  }
+
+  const size_t padding =
+      webrtc::EncodedImage::GetBufferPaddingBytes(codec_type);
+  std::vector<uint8_t> buffer;
+  Result result = Result::kSuccess;
+  const int64_t start_time_us = rtc::TimeMicros();
+  RecordedFrameHeader frame{};
+  while (file->Read(&frame, sizeof(frame)) == sizeof(frame)) {
+    if (frame.size > kMaxRecordedFrameSize) {
+      RTC_LOG(LS_ERROR) << "Invalid frame #" << stats.frames_read
+                        << " in recording " << path;
+      result = Result::kInvalidParameter;
+      break;
+    }
+    // Some decoders read past the end of the frame, so pad it with zeros.
+    buffer.assign(frame.size + padding, 0);
+    if (file->Read(buffer.data(), frame.size) != (int)frame.size) {
+      break;
+    }
+    ++stats.frames_read;
+    if (recorded_pacing) {
+      const int64_t wait_us =
+          start_time_us + frame.arrival_time_us - rtc::TimeMicros();
+      if (wait_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+      }
+    }
+    webrtc::EncodedImage image(buffer.data(), frame.size, buffer.size());
+    image._timeStamp = frame.rtp_timestamp;
+    image._encodedWidth = frame.width;
+    image._encodedHeight = frame.height;
+    image._frameType = (frame.is_keyframe ? webrtc::kVideoFrameKey
+                                          : webrtc::kVideoFrameDelta);
+    image._completeFrame = true;
+    const int64_t decode_start_us = rtc::TimeMicros();
+    if (decoder->Decode(image, /* missing_frames = */ false, nullptr,
+                        rtc::TimeMillis()) < WEBRTC_VIDEO_CODEC_OK) {
+      ++stats.decode_errors;
+    }
+    stats.decode_time_us += rtc::TimeMicros() - decode_start_us;
+  }
+  decoder->Release();
+  stats.frames_decoded = callback.decoded_count();
+  stats.duration_us = rtc::TimeMicros() - start_time_us;
+  return result;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
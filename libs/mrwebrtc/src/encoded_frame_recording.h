@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rtc_base/system/file_wrapper.h"
+
+#include "encoded_frame_tap.h"
+#include "mrs_errors.h"
+#include "remote_video_track_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class VideoFrameObserver;
+
+/// Header at the start of a recording of encoded video frames. A recording is
+/// a raw container holding the frames of a single codec, each preceded by a
+/// |RecordedFrameHeader|. All fields are little-endian.
+struct RecordingFileHeader {
+  /// Must be |kRecordingMagic|.
+  char magic[4];
+
+  /// Must be |kRecordingVersion|.
+  uint16_t version;
+
+  /// Size of this header, in bytes.
+  uint16_t header_size;
+
+  /// SDP name of the codec of the frames, like "VP8", zero-terminated.
+  char codec_name[16];
+
+  uint32_t reserved[2];
+};
+static_assert(sizeof(RecordingFileHeader) == 32, "Unexpected header size.");
+
+/// Header preceding each frame of a recording, followed by |size| bytes of
+/// encoded data.
+struct RecordedFrameHeader {
+  /// Size of the encoded frame, in bytes.
+  uint32_t size;
+
+  /// RTP timestamp of the frame, in the 90 kHz clock of the sender.
+  uint32_t rtp_timestamp;
+
+  /// Time the frame reached the decoder, in microseconds, relative to the
+  /// first frame of the recording.
+  int64_t arrival_time_us;
+
+  /// Encoded resolution, if known, or zero.
+  uint16_t width;
+  uint16_t height;
+
+  /// Non-zero for key frames.
+  uint8_t is_keyframe;
+
+  uint8_t reserved[3];
+};
+static_assert(sizeof(RecordedFrameHeader) == 24, "Unexpected header size.");
+
+constexpr char kRecordingMagic[4] = {'M', 'R', 'E', 'V'};
+constexpr uint16_t kRecordingVersion = 1;
+
+/// Sink of the encoded frames of a receive stream writing them to a recording
+/// file, starting from the first key frame so that the recording can be
+/// decoded from its start. Frames of another codec than the first one, after
+/// a renegotiation, are skipped.
+class EncodedFrameRecorder : public EncodedFrameSink {
+ public:
+  /// Create the recording file at |path|, overwriting any existing file.
+  static ErrorOr<std::unique_ptr<EncodedFrameRecorder>> Create(
+      const char* path) noexcept;
+
+  /// Number of frames written so far.
+  uint32_t frame_count() const noexcept;
+
+  // EncodedFrameSink
+  void OnEncodedFrame(const webrtc::EncodedImage& image,
+                      webrtc::VideoCodecType codec_type) noexcept override;
+
+ private:
+  explicit EncodedFrameRecorder(std::unique_ptr<webrtc::FileWrapper> file)
+      : file_(std::move(file)) {}
+
+  mutable std::mutex mutex_;
+  std::unique_ptr<webrtc::FileWrapper> file_ RTC_GUARDED_BY(mutex_);
+
+  /// Codec of the recorded frames, set with the first key frame.
+  webrtc::VideoCodecType codec_type_ RTC_GUARDED_BY(mutex_) =
+      webrtc::kVideoCodecGeneric;
+  bool started_ RTC_GUARDED_BY(mutex_) = false;
+
+  /// Arrival time of the first frame, in the clock of |rtc::TimeMicros()|.
+  int64_t start_time_us_ RTC_GUARDED_BY(mutex_) = 0;
+
+  uint32_t frame_count_ RTC_GUARDED_BY(mutex_) = 0;
+
+  /// A write failed, and no frame is written anymore.
+  bool failed_ RTC_GUARDED_BY(mutex_) = false;
+};
+
+/// Decode the frames of a recording created by |EncodedFrameRecorder| on the
+/// caller's thread, and deliver the decoded frames to |observer|, either at
+/// the pacing of their recorded arrival times or as fast as possible. This
+/// returns |kNotFound| if the file cannot be opened, |kInvalidParameter| if it
+/// is not a valid recording, and |kUnsupported| if no decoder supports the
+/// codec of the recording. A truncated last frame is ignored.
+Result ReplayEncodedFrames(const char* path,
+                           bool recorded_pacing,
+                           VideoFrameObserver& observer,
+                           mrsEncodedVideoReplayStats& stats) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
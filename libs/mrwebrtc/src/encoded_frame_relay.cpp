@@ -0,0 +1,376 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "encoded_frame_relay.h"
+
+#include "api/video/i420_buffer.h"
+#include "common_video/h264/h264_common.h"
+#include "media/base/mediaconstants.h"
+#include "modules/include/module_common_types.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/timeutils.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Buffers alive, to recognize them among the other |kNative| buffers without
+/// relying on RTTI, which WebRTC is built without.
+std::mutex g_live_buffers_mutex;
+std::unordered_set<const webrtc::VideoFrameBuffer*> g_live_buffers
+    RTC_GUARDED_BY(g_live_buffers_mutex);
+
+/// Time after which a key frame request not matched by any frame expires.
+constexpr int64_t kKeyFrameRequestTimeoutMs = 1000;
+
+/// Pending key frame requests. The count allows encoders to skip the lock in
+/// the common case without any request.
+std::mutex g_keyframe_requests_mutex;
+std::vector<std::shared_ptr<KeyFrameRequest>> g_keyframe_requests
+    RTC_GUARDED_BY(g_keyframe_requests_mutex);
+std::atomic<size_t> g_keyframe_request_count{0};
+
+/// Remove the expired key frame requests.
+void PurgeKeyFrameRequests(int64_t now_ms)
+    RTC_EXCLUSIVE_LOCKS_REQUIRED(g_keyframe_requests_mutex) {
+  auto end = std::remove_if(
+      g_keyframe_requests.begin(), g_keyframe_requests.end(),
+      [now_ms](const std::shared_ptr<KeyFrameRequest>& request) {
+        return (request->expiry_ms() <= now_ms);
+      });
+  g_keyframe_requests.erase(end, g_keyframe_requests.end());
+  g_keyframe_request_count.store(g_keyframe_requests.size(),
+                                 std::memory_order_relaxed);
+}
+
+/// Check if a key frame was requested for the given frame, and mark the
+/// matching requests as fulfilled.
+bool TakeKeyFrameRequests(const webrtc::VideoFrame& frame) {
+  if (g_keyframe_request_count.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(g_keyframe_requests_mutex);
+  PurgeKeyFrameRequests(rtc::TimeMillis());
+  bool requested = false;
+  for (const std::shared_ptr<KeyFrameRequest>& request : g_keyframe_requests) {
+    if (request->Matches(frame)) {
+      request->MarkFulfilled();
+      requested = true;
+    }
+  }
+  return requested;
+}
+
+/// Encoder sending the relayed encoded frames as is, and encoding all other
+/// frames with the wrapped encoder.
+class RelayVideoEncoder : public webrtc::VideoEncoder {
+ public:
+  RelayVideoEncoder(std::unique_ptr<webrtc::VideoEncoder> encoder,
+                    const webrtc::SdpVideoFormat& format) noexcept
+      : encoder_(std::move(encoder)),
+        codec_type_(webrtc::PayloadStringToCodecType(format.name)) {
+    auto it = format.parameters.find(cricket::kH264FmtpPacketizationMode);
+    if ((it != format.parameters.end()) && (it->second == "1")) {
+      packetization_mode_ = webrtc::H264PacketizationMode::NonInterleaved;
+    }
+  }
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    return encoder_->InitEncode(codec_settings, number_of_cores,
+                                max_payload_size);
+  }
+
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    callback_ = callback;
+    return encoder_->RegisterEncodeCompleteCallback(callback);
+  }
+
+  int32_t Release() override { return encoder_->Release(); }
+
+  int32_t Encode(const webrtc::VideoFrame& frame,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override {
+    if (EncodedVideoFrameBuffer* buffer =
+            EncodedVideoFrameBuffer::FromFrame(frame)) {
+      return Relay(frame, *buffer, frame_types);
+    }
+    std::vector<webrtc::FrameType> keyframe_types;
+    if (TakeKeyFrameRequests(frame)) {
+      keyframe_types.assign(frame_types ? frame_types->size() : 1,
+                            webrtc::kVideoFrameKey);
+      frame_types = &keyframe_types;
+    }
+    if (frame.video_frame_buffer()->type() ==
+        webrtc::VideoFrameBuffer::Type::kNative) {
+      // This encoder claims to support native buffers for the relayed frames,
+      // so converts the other ones itself.
+      webrtc::VideoFrame i420_frame{
+          webrtc::VideoFrame::Builder()
+              .set_video_frame_buffer(frame.video_frame_buffer()->ToI420())
+              .set_timestamp_rtp(frame.timestamp())
+              .set_timestamp_ms(frame.render_time_ms())
+              .set_rotation(frame.rotation())
+              .build()};
+      i420_frame.set_ntp_time_ms(frame.ntp_time_ms());
+      return encoder_->Encode(i420_frame, codec_specific_info, frame_types);
+    }
+    return encoder_->Encode(frame, codec_specific_info, frame_types);
+  }
+
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override {
+    return encoder_->SetChannelParameters(packet_loss, rtt);
+  }
+
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    bitrate_bps_ = allocation.get_sum_bps();
+    framerate_ = framerate;
+    if (std::shared_ptr<EncodedFrameProducer> producer = producer_.lock()) {
+      producer->OnTargetBitrateChanged(bitrate_bps_, framerate_);
+    }
+    return encoder_->SetRateAllocation(allocation, framerate);
+  }
+
+  ScalingSettings GetScalingSettings() const override {
+    return encoder_->GetScalingSettings();
+  }
+
+  bool SupportsNativeHandle() const override { return true; }
+
+  const char* ImplementationName() const override {
+    return encoder_->ImplementationName();
+  }
+
+ private:
+  int32_t Relay(const webrtc::VideoFrame& frame,
+                const EncodedVideoFrameBuffer& buffer,
+                const std::vector<webrtc::FrameType>* frame_types) {
+    if (!callback_) {
+      return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+    }
+    if (buffer.codec_type() != codec_type_) {
+      if (!codec_mismatch_logged_) {
+        RTC_LOG(LS_ERROR) << "Cannot relay frames of codec "
+                          << webrtc::CodecTypeToPayloadString(
+                                 buffer.codec_type())
+                          << " on a stream negotiated with codec "
+                          << webrtc::CodecTypeToPayloadString(codec_type_)
+                          << ". Dropping them.";
+        codec_mismatch_logged_ = true;
+      }
+      return WEBRTC_VIDEO_CODEC_OK;
+    }
+
+    // Report the current target bitrate to a new producer, which is only
+    // notified of the later changes otherwise.
+    std::shared_ptr<EncodedFrameProducer> producer = buffer.producer();
+    if (producer && (producer != producer_.lock())) {
+      producer_ = producer;
+      if (bitrate_bps_ > 0) {
+        producer->OnTargetBitrateChanged(bitrate_bps_, framerate_);
+      }
+    }
+
+    // Delta frames reference the previous frame, so cannot be sent after a
+    // frame was dropped before reaching the encoder, or before the first key
+    // frame.
+    const bool contiguous = (buffer.index() == last_index_ + 1);
+    last_index_ = buffer.index();
+    // A relayed key frame fulfills local key frame requests too.
+    const bool keyframe_requested = TakeKeyFrameRequests(frame);
+    if (buffer.is_keyframe()) {
+      needs_keyframe_ = false;
+    } else {
+      needs_keyframe_ |= !contiguous;
+      bool keyframe_wanted = (needs_keyframe_ || keyframe_requested);
+      if (frame_types) {
+        for (webrtc::FrameType type : *frame_types) {
+          keyframe_wanted |= (type == webrtc::kVideoFrameKey);
+        }
+      }
+      if (keyframe_wanted) {
+        buffer.RequestKeyFrame();
+      }
+      if (needs_keyframe_) {
+        return WEBRTC_VIDEO_CODEC_OK;
+      }
+    }
+
+    webrtc::EncodedImage image(const_cast<uint8_t*>(buffer.data()),
+                               buffer.size(), buffer.size());
+    image._encodedWidth = frame.width();
+    image._encodedHeight = frame.height();
+    image._timeStamp = frame.timestamp();
+    image.ntp_time_ms_ = frame.ntp_time_ms();
+    image.capture_time_ms_ = frame.render_time_ms();
+    image.rotation_ = frame.rotation();
+    image._frameType = (buffer.is_keyframe() ? webrtc::kVideoFrameKey
+                                             : webrtc::kVideoFrameDelta);
+    image._completeFrame = true;
+
+    webrtc::CodecSpecificInfo info;
+    info.codecType = codec_type_;
+    webrtc::RTPFragmentationHeader fragmentation;
+    const webrtc::RTPFragmentationHeader* fragmentation_ptr = nullptr;
+    if (codec_type_ == webrtc::kVideoCodecVP8) {
+      info.codecSpecific.VP8.nonReference = false;
+      info.codecSpecific.VP8.temporalIdx = webrtc::kNoTemporalIdx;
+      info.codecSpecific.VP8.layerSync = false;
+      info.codecSpecific.VP8.keyIdx = webrtc::kNoKeyIdx;
+    } else if (codec_type_ == webrtc::kVideoCodecH264) {
+      // The packetizer needs the NAL units of the access unit.
+      info.codecSpecific.H264.packetization_mode = packetization_mode_;
+      const std::vector<webrtc::H264::NaluIndex> nalus =
+          webrtc::H264::FindNaluIndices(buffer.data(), buffer.size());
+      fragmentation.VerifyAndAllocateFragmentationHeader(nalus.size());
+      for (size_t i = 0; i < nalus.size(); ++i) {
+        fragmentation.fragmentationOffset[i] = nalus[i].payload_start_offset;
+        fragmentation.fragmentationLength[i] = nalus[i].payload_size;
+      }
+      fragmentation_ptr = &fragmentation;
+    }
+    const webrtc::EncodedImageCallback::Result result =
+        callback_->OnEncodedImage(image, &info, fragmentation_ptr);
+    return (result.error == webrtc::EncodedImageCallback::Result::OK
+                ? WEBRTC_VIDEO_CODEC_OK
+                : WEBRTC_VIDEO_CODEC_ERROR);
+  }
+
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+  const webrtc::VideoCodecType codec_type_;
+  webrtc::H264PacketizationMode packetization_mode_{
+      webrtc::H264PacketizationMode::SingleNalUnit};
+  webrtc::EncodedImageCallback* callback_{nullptr};
+
+  /// Index of the last relayed frame received. Frame indices start at 1, so
+  /// the first frame is always contiguous.
+  uint64_t last_index_{0};
+
+  /// A delta frame was dropped since the last key frame.
+  bool needs_keyframe_{true};
+
+  bool codec_mismatch_logged_{false};
+
+  /// Producer of the last relayed frame, and the last target bitrate and
+  /// framerate set by the video engine.
+  std::weak_ptr<EncodedFrameProducer> producer_;
+  uint32_t bitrate_bps_{0};
+  uint32_t framerate_{0};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<EncodedVideoFrameBuffer> EncodedVideoFrameBuffer::Create(
+    const uint8_t* data,
+    size_t size,
+    webrtc::VideoCodecType codec_type,
+    bool is_keyframe,
+    int width,
+    int height,
+    uint64_t index,
+    std::weak_ptr<EncodedFrameProducer> producer) {
+  return new rtc::RefCountedObject<EncodedVideoFrameBuffer>(
+      data, size, codec_type, is_keyframe, width, height, index,
+      std::move(producer));
+}
+
+EncodedVideoFrameBuffer* EncodedVideoFrameBuffer::FromFrame(
+    const webrtc::VideoFrame& frame) {
+  webrtc::VideoFrameBuffer* const buffer = frame.video_frame_buffer().get();
+  if (buffer->type() != Type::kNative) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+  if (g_live_buffers.find(buffer) == g_live_buffers.end()) {
+    return nullptr;
+  }
+  return static_cast<EncodedVideoFrameBuffer*>(buffer);
+}
+
+EncodedVideoFrameBuffer::EncodedVideoFrameBuffer(
+    const uint8_t* data,
+    size_t size,
+    webrtc::VideoCodecType codec_type,
+    bool is_keyframe,
+    int width,
+    int height,
+    uint64_t index,
+    std::weak_ptr<EncodedFrameProducer> producer)
+    : data_(data, size),
+      codec_type_(codec_type),
+      is_keyframe_(is_keyframe),
+      width_(width),
+      height_(height),
+      index_(index),
+      producer_(std::move(producer)) {
+  std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+  g_live_buffers.insert(this);
+}
+
+EncodedVideoFrameBuffer::~EncodedVideoFrameBuffer() {
+  std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+  g_live_buffers.erase(this);
+}
+
+void EncodedVideoFrameBuffer::RequestKeyFrame() const noexcept {
+  if (std::shared_ptr<EncodedFrameProducer> producer = producer_.lock()) {
+    producer->RequestKeyFrame();
+  }
+}
+
+std::shared_ptr<KeyFrameRequest> RequestKeyFrameForFrame(
+    const webrtc::VideoFrame& frame) noexcept {
+  const int64_t now_ms = rtc::TimeMillis();
+  auto request = std::make_shared<KeyFrameRequest>(
+      frame, now_ms + kKeyFrameRequestTimeoutMs);
+  std::lock_guard<std::mutex> lock(g_keyframe_requests_mutex);
+  g_keyframe_requests.push_back(request);
+  PurgeKeyFrameRequests(now_ms);
+  return request;
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface>
+EncodedVideoFrameBuffer::ToI420() {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width_, height_);
+  webrtc::I420Buffer::SetBlack(buffer);
+  return buffer;
+}
+
+std::vector<webrtc::SdpVideoFormat>
+RelayVideoEncoderFactory::GetSupportedFormats() const {
+  return encoder_factory_->GetSupportedFormats();
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+RelayVideoEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  return encoder_factory_->QueryVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+RelayVideoEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      encoder_factory_->CreateVideoEncoder(format);
+  if (!encoder) {
+    return nullptr;
+  }
+  return absl::make_unique<RelayVideoEncoder>(std::move(encoder), format);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
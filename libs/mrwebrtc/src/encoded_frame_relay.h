@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_buffer.h"
+#include "api/video_codecs/video_encoder_factory.h"
+#include "common_types.h"
+#include "rtc_base/buffer.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Producer of the encoded frames carried by |EncodedVideoFrameBuffer|,
+/// notified by the encoders sending them.
+class EncodedFrameProducer {
+ public:
+  virtual ~EncodedFrameProducer() = default;
+
+  /// Produce a key frame as soon as possible.
+  virtual void RequestKeyFrame() noexcept = 0;
+
+  /// Called when the target bitrate of an encoder sending the frames changed.
+  virtual void OnTargetBitrateChanged(uint32_t /*bitrate_bps*/,
+                                      uint32_t /*framerate*/) noexcept {}
+};
+
+/// Frame buffer of type |kNative| carrying an already-encoded frame, either
+/// relayed from a remote video track or provided by the application. Encoders
+/// created by |RelayVideoEncoderFactory| send the frame as is instead of
+/// encoding it, while any other consumer calling |ToI420()| gets a black
+/// frame, as the frame is never decoded.
+class EncodedVideoFrameBuffer : public webrtc::VideoFrameBuffer {
+ public:
+  /// Create a new buffer holding a copy of an encoded frame. |index| orders
+  /// the frames relayed from the same stream, to detect the ones dropped
+  /// before reaching the encoder. Key frame requests and bitrate changes are
+  /// forwarded to |producer|.
+  static rtc::scoped_refptr<EncodedVideoFrameBuffer> Create(
+      const uint8_t* data,
+      size_t size,
+      webrtc::VideoCodecType codec_type,
+      bool is_keyframe,
+      int width,
+      int height,
+      uint64_t index,
+      std::weak_ptr<EncodedFrameProducer> producer);
+
+  /// Get the encoded frame buffer of a video frame, or NULL if the frame does
+  /// not carry an encoded frame.
+  static EncodedVideoFrameBuffer* FromFrame(const webrtc::VideoFrame& frame);
+
+  const uint8_t* data() const noexcept { return data_.data(); }
+  size_t size() const noexcept { return data_.size(); }
+  webrtc::VideoCodecType codec_type() const noexcept { return codec_type_; }
+  bool is_keyframe() const noexcept { return is_keyframe_; }
+  uint64_t index() const noexcept { return index_; }
+
+  /// Ask the producer of the frames for a key frame.
+  void RequestKeyFrame() const noexcept;
+
+  /// Get the producer of the frames, or NULL if it was destroyed.
+  std::shared_ptr<EncodedFrameProducer> producer() const noexcept {
+    return producer_.lock();
+  }
+
+  // webrtc::VideoFrameBuffer
+  Type type() const override { return Type::kNative; }
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+  rtc::scoped_refptr<webrtc::I420BufferInterface> ToI420() override;
+
+ protected:
+  EncodedVideoFrameBuffer(const uint8_t* data,
+                          size_t size,
+                          webrtc::VideoCodecType codec_type,
+                          bool is_keyframe,
+                          int width,
+                          int height,
+                          uint64_t index,
+                          std::weak_ptr<EncodedFrameProducer> producer);
+  ~EncodedVideoFrameBuffer() override;
+
+ private:
+  const rtc::Buffer data_;
+  const webrtc::VideoCodecType codec_type_;
+  const bool is_keyframe_;
+  const int width_;
+  const int height_;
+  const uint64_t index_;
+  const std::weak_ptr<EncodedFrameProducer> producer_;
+};
+
+/// Request for the encoders of a given frame to encode it as a key frame.
+class KeyFrameRequest {
+ public:
+  KeyFrameRequest(const webrtc::VideoFrame& frame, int64_t expiry_ms) noexcept
+      : buffer_(frame.video_frame_buffer().get()),
+        timestamp_us_(frame.timestamp_us()),
+        expiry_ms_(expiry_ms) {}
+
+  /// Check if the request targets the given frame. Frames are identified by
+  /// their buffer and capture time, as pooled buffers are reused.
+  bool Matches(const webrtc::VideoFrame& frame) const noexcept {
+    return (frame.video_frame_buffer().get() == buffer_) &&
+           (frame.timestamp_us() == timestamp_us_);
+  }
+
+  int64_t expiry_ms() const noexcept { return expiry_ms_; }
+
+  /// Check if at least one encoder produced a key frame for the request.
+  bool IsFulfilled() const noexcept {
+    return fulfilled_.load(std::memory_order_relaxed);
+  }
+
+  void MarkFulfilled() noexcept {
+    fulfilled_.store(true, std::memory_order_relaxed);
+  }
+
+ private:
+  /// Never dereferenced, only compared.
+  const webrtc::VideoFrameBuffer* const buffer_;
+  const int64_t timestamp_us_;
+  const int64_t expiry_ms_;
+  std::atomic_bool fulfilled_{false};
+};
+
+/// Ask the encoders created by |RelayVideoEncoderFactory| to encode the given
+/// frame as a key frame. As the frames of a source are shared by all the
+/// tracks using it, this affects the encoders of all those tracks which
+/// encode the frame. Requests expire after a short time, in case the frame is
+/// dropped before reaching any encoder.
+std::shared_ptr<KeyFrameRequest> RequestKeyFrameForFrame(
+    const webrtc::VideoFrame& frame) noexcept;
+
+/// Video encoder factory wrapping the encoders of another factory to send the
+/// frames carrying an |EncodedVideoFrameBuffer| without encoding them, and
+/// encode all other frames as usual. The encoders also honor the key frame
+/// requests of |RequestKeyFrameForFrame()|.
+class RelayVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  explicit RelayVideoEncoderFactory(
+      std::unique_ptr<webrtc::VideoEncoderFactory> encoder_factory) noexcept
+      : encoder_factory_(std::move(encoder_factory)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoEncoderFactory> encoder_factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,339 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "encoded_frame_tap.h"
+
+#include "api/video_codecs/video_decoder.h"
+#include "modules/video_coding/include/video_error_codes.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Maximum number of frames whose metadata is kept until they are delivered,
+/// to cover the frames queued between the decoder and the remote track.
+constexpr size_t kMaxFrameMetadataCount = 32;
+
+/// Decoder delivering the encoded frames of a receive stream to its tap, then
+/// decoding them with the wrapped decoder unless decoding is disabled.
+class EncodedFrameTapDecoder : public webrtc::VideoDecoder {
+ public:
+  EncodedFrameTapDecoder(
+      std::unique_ptr<webrtc::VideoDecoder> decoder,
+      std::string codec_name,
+      std::shared_ptr<EncodedFrameTap> tap,
+      std::shared_ptr<DecoderThreadBudget> thread_budget) noexcept
+      : decoder_(std::move(decoder)),
+        codec_name_(std::move(codec_name)),
+        codec_type_(webrtc::PayloadStringToCodecType(codec_name_)),
+        tap_(std::move(tap)),
+        thread_budget_(std::move(thread_budget)) {}
+
+  ~EncodedFrameTapDecoder() override { ReleaseThreads(); }
+
+  int32_t InitDecode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    // Keep the settings to reinitialize the decoder when its priority changes.
+    has_codec_settings_ = (codec_settings != nullptr);
+    if (codec_settings) {
+      codec_settings_ = *codec_settings;
+    }
+    number_of_cores_ = number_of_cores;
+    return InitDecodeWithBudget(codec_settings);
+  }
+
+  int32_t Decode(const webrtc::EncodedImage& input_image,
+                 bool missing_frames,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    // Remove the metadata trailer, if any, before anything reads the frame.
+    webrtc::EncodedImage image(input_image);
+    if (FrameMetadata metadata =
+            StripFrameMetadata(image._buffer, image._length)) {
+      tap_->AddFrameMetadata(image._timeStamp, std::move(metadata));
+    }
+    const bool is_keyframe = (image._frameType == webrtc::kVideoFrameKey);
+    tap_->RecordLayers(codec_specific_info);
+    tap_->OnEncodedFrame(image, codec_type_, codec_name_.c_str());
+
+    if (tap_->TakeKeyFrameRequest() && !is_keyframe) {
+      // Failing to decode makes the receiver request a key frame. The next
+      // delta frames reference this one, so cannot be decoded either.
+      needs_keyframe_ = true;
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    if (!tap_->IsDecodingEnabled()) {
+      needs_keyframe_ = true;
+      return WEBRTC_VIDEO_CODEC_OK;
+    }
+    if (needs_keyframe_) {
+      // The frames skipped while decoding was disabled are referenced by the
+      // next delta frames. Reporting an error makes the receiver request a key
+      // frame to resume decoding.
+      if (!is_keyframe) {
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      }
+      needs_keyframe_ = false;
+    }
+    if (is_keyframe && (tap_->IsLowPriorityDecoding() != low_priority_)) {
+      // Reinitializing the decoder drops its reference frames, which the next
+      // delta frames do not need after a key frame.
+      decoder_->Release();
+      const int32_t result = InitDecodeWithBudget(
+          has_codec_settings_ ? &codec_settings_ : nullptr);
+      if (result != WEBRTC_VIDEO_CODEC_OK) {
+        return result;
+      }
+      if (decode_complete_callback_) {
+        decoder_->RegisterDecodeCompleteCallback(decode_complete_callback_);
+      }
+    }
+    return decoder_->Decode(image, missing_frames, codec_specific_info,
+                            render_time_ms);
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      webrtc::DecodedImageCallback* callback) override {
+    decode_complete_callback_ = callback;
+    return decoder_->RegisterDecodeCompleteCallback(callback);
+  }
+
+  int32_t Release() override {
+    ReleaseThreads();
+    return decoder_->Release();
+  }
+
+  bool PrefersLateDecoding() const override {
+    return decoder_->PrefersLateDecoding();
+  }
+
+  const char* ImplementationName() const override {
+    return decoder_->ImplementationName();
+  }
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoder> decoder_;
+  const std::string codec_name_;
+  const webrtc::VideoCodecType codec_type_;
+  std::shared_ptr<EncodedFrameTap> tap_;
+  std::shared_ptr<DecoderThreadBudget> thread_budget_;
+
+  /// Initialize the wrapped decoder with the threads allocated by the budget
+  /// for the current priority of the stream.
+  int32_t InitDecodeWithBudget(
+      const webrtc::VideoCodec* codec_settings) noexcept {
+    ReleaseThreads();
+    low_priority_ = tap_->IsLowPriorityDecoding();
+    threads_ = thread_budget_->Acquire(number_of_cores_, low_priority_);
+    return decoder_->InitDecode(codec_settings, threads_);
+  }
+
+  void ReleaseThreads() noexcept {
+    if (threads_ > 0) {
+      thread_budget_->Release(threads_);
+      threads_ = 0;
+    }
+  }
+
+  //
+  // The members below are only accessed by the thread decoding the stream, or
+  // while the stream is not decoding.
+  //
+
+  /// Decoding was skipped since the last key frame.
+  bool needs_keyframe_{false};
+
+  /// Settings and processor count the decoder was initialized with by WebRTC.
+  webrtc::VideoCodec codec_settings_;
+  bool has_codec_settings_{false};
+  int32_t number_of_cores_{1};
+
+  /// Threads allocated to the decoder, or zero if not initialized, and the
+  /// priority they were allocated for.
+  int threads_{0};
+  bool low_priority_{false};
+
+  webrtc::DecodedImageCallback* decode_complete_callback_{nullptr};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void EncodedFrameTap::SetCallback(EncodedVideoFrameCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+void EncodedFrameTap::AddSink(EncodedFrameSink* sink) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sinks_.push_back(sink);
+}
+
+void EncodedFrameTap::RemoveSink(EncodedFrameSink* sink) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find(sinks_.begin(), sinks_.end(), sink);
+  if (it != sinks_.end()) {
+    sinks_.erase(it);
+  }
+}
+
+void EncodedFrameTap::RecordLayers(
+    const webrtc::CodecSpecificInfo* codec_specific_info) noexcept {
+  int spatial_index = 0;
+  int temporal_index = 0;
+  if (codec_specific_info) {
+    switch (codec_specific_info->codecType) {
+      case webrtc::kVideoCodecVP8:
+        temporal_index = codec_specific_info->codecSpecific.VP8.temporalIdx;
+        break;
+      case webrtc::kVideoCodecVP9:
+        spatial_index = codec_specific_info->codecSpecific.VP9.spatial_idx;
+        temporal_index = codec_specific_info->codecSpecific.VP9.temporal_idx;
+        break;
+      default:
+        break;
+    }
+  }
+  // The indices are |kNoSpatialIdx| or |kNoTemporalIdx| without layers.
+  if ((spatial_index < 0) || (spatial_index >= kMaxLayers)) {
+    spatial_index = 0;
+  }
+  if ((temporal_index < 0) || (temporal_index >= kMaxLayers)) {
+    temporal_index = 0;
+  }
+  const uint64_t frame_count =
+      layer_frame_count_.load(std::memory_order_relaxed) + 1;
+  last_spatial_frames_[spatial_index].store(frame_count,
+                                            std::memory_order_relaxed);
+  last_temporal_frames_[temporal_index].store(frame_count,
+                                              std::memory_order_relaxed);
+  layer_frame_count_.store(frame_count, std::memory_order_relaxed);
+}
+
+mrsVideoLayerStats EncodedFrameTap::GetLayerStats() const noexcept {
+  const uint64_t frame_count =
+      layer_frame_count_.load(std::memory_order_relaxed);
+  auto count_layers = [frame_count](const std::atomic<uint64_t>* last_frames) {
+    uint32_t count = 1;
+    for (int i = 1; i < kMaxLayers; ++i) {
+      const uint64_t last_frame =
+          last_frames[i].load(std::memory_order_relaxed);
+      if ((last_frame > 0) && (frame_count - last_frame < kLayerWindowFrames)) {
+        count = (uint32_t)i + 1;
+      }
+    }
+    return count;
+  };
+  mrsVideoLayerStats stats{};
+  stats.spatial_layer_count = count_layers(last_spatial_frames_);
+  stats.temporal_layer_count = count_layers(last_temporal_frames_);
+  return stats;
+}
+
+void EncodedFrameTap::OnEncodedFrame(const webrtc::EncodedImage& image,
+                                     webrtc::VideoCodecType codec_type,
+                                     const char* codec_name) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (callback_) {
+    mrsEncodedVideoFrame frame{};
+    frame.codec_name = codec_name;
+    frame.rtp_timestamp = image._timeStamp;
+    frame.ntp_time_ms = image.ntp_time_ms_;
+    frame.width = image._encodedWidth;
+    frame.height = image._encodedHeight;
+    frame.is_keyframe = (image._frameType == webrtc::kVideoFrameKey)
+                            ? mrsBool::kTrue
+                            : mrsBool::kFalse;
+    frame.data = image._buffer;
+    frame.size = (uint32_t)image._length;
+    callback_(&frame);
+  }
+  for (EncodedFrameSink* sink : sinks_) {
+    sink->OnEncodedFrame(image, codec_type);
+  }
+}
+
+void EncodedFrameTap::AddFrameMetadata(uint32_t rtp_timestamp,
+                                       FrameMetadata metadata) noexcept {
+  std::lock_guard<std::mutex> lock(metadata_mutex_);
+  if (metadata_.size() >= kMaxFrameMetadataCount) {
+    metadata_.pop_front();
+  }
+  metadata_.emplace_back(rtp_timestamp, std::move(metadata));
+  has_metadata_.store(true, std::memory_order_relaxed);
+}
+
+FrameMetadata EncodedFrameTap::FindFrameMetadata(uint32_t rtp_timestamp) const
+    noexcept {
+  if (!has_metadata_.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(metadata_mutex_);
+  for (auto it = metadata_.rbegin(); it != metadata_.rend(); ++it) {
+    if (it->first == rtp_timestamp) {
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<EncodedFrameTap> EncodedFrameTapRegistry::GetOrCreate(
+    const std::string& stream_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shared_ptr<EncodedFrameTap> tap;
+  for (auto it = taps_.begin(); it != taps_.end();) {
+    if (it->second.expired()) {
+      it = taps_.erase(it);
+    } else {
+      if (it->first == stream_id) {
+        tap = it->second.lock();
+      }
+      ++it;
+    }
+  }
+  if (!tap) {
+    tap = std::make_shared<EncodedFrameTap>();
+    taps_[stream_id] = tap;
+  }
+  return tap;
+}
+
+std::vector<webrtc::SdpVideoFormat>
+EncodedFrameTapDecoderFactory::GetSupportedFormats() const {
+  return decoder_factory_->GetSupportedFormats();
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+EncodedFrameTapDecoderFactory::CreateVideoDecoder(
+    const webrtc::SdpVideoFormat& format) {
+  return decoder_factory_->CreateVideoDecoder(format);
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+EncodedFrameTapDecoderFactory::LegacyCreateVideoDecoder(
+    const webrtc::SdpVideoFormat& format,
+    const std::string& receive_stream_id) {
+  std::unique_ptr<webrtc::VideoDecoder> decoder =
+      decoder_factory_->LegacyCreateVideoDecoder(format, receive_stream_id);
+  if (!decoder) {
+    return nullptr;
+  }
+  // Unsignaled streams are not associated with any remote track, but still
+  // need a tap of their own to remove the metadata trailer of their frames.
+  std::shared_ptr<EncodedFrameTap> tap =
+      (receive_stream_id.empty() ? std::make_shared<EncodedFrameTap>()
+                                 : registry_->GetOrCreate(receive_stream_id));
+  return absl::make_unique<EncodedFrameTapDecoder>(
+      std::move(decoder), format.name, std::move(tap), thread_budget_);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
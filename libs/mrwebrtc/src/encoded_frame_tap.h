@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "api/video/encoded_image.h"
+#include "api/video_codecs/video_decoder_factory.h"
+#include "common_types.h"
+
+#include "callback.h"
+#include "decoder_thread_budget.h"
+#include "encoded_frame_relay.h"
+#include "frame_metadata.h"
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Callback fired for each encoded frame received on a remote video track.
+using EncodedVideoFrameCallback = Callback<const mrsEncodedVideoFrame*>;
+
+/// Internal consumer of the encoded frames of a receive stream.
+class EncodedFrameSink {
+ public:
+  virtual ~EncodedFrameSink() = default;
+
+  /// Called on the decoding thread with each encoded frame of the stream.
+  virtual void OnEncodedFrame(const webrtc::EncodedImage& image,
+                              webrtc::VideoCodecType codec_type) noexcept = 0;
+};
+
+/// Access point to the encoded frames of a single receive stream, shared by
+/// the decoder of the stream and the remote video track it feeds.
+class EncodedFrameTap : public EncodedFrameProducer {
+ public:
+  /// Register the callback invoked with each encoded frame before it is
+  /// decoded. Once this returns, the previous callback is not invoked anymore.
+  void SetCallback(EncodedVideoFrameCallback callback) noexcept;
+
+  /// Enable or disable decoding the frames of the stream. Disabled streams do
+  /// not produce any decoded frame, but still invoke the encoded frame
+  /// callback.
+  void SetDecodingEnabled(bool enabled) noexcept {
+    decoding_enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool IsDecodingEnabled() const noexcept {
+    return decoding_enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Decode the frames of the stream on a single thread, leaving the other
+  /// decoding threads to the other streams. This takes effect on the next key
+  /// frame, which reinitializes the decoder of the stream.
+  void SetLowPriorityDecoding(bool low_priority) noexcept {
+    low_priority_decoding_.store(low_priority, std::memory_order_relaxed);
+  }
+
+  bool IsLowPriorityDecoding() const noexcept {
+    return low_priority_decoding_.load(std::memory_order_relaxed);
+  }
+
+  /// Add a sink receiving the encoded frames in addition to the callback.
+  /// Once |RemoveSink()| returns, the sink is not invoked anymore.
+  void AddSink(EncodedFrameSink* sink) noexcept;
+  void RemoveSink(EncodedFrameSink* sink) noexcept;
+
+  /// Ask the remote peer for a key frame. Requests are coalesced until the
+  /// decoder of the stream processes the next frame.
+  void RequestKeyFrame() noexcept override {
+    keyframe_requested_.store(true, std::memory_order_relaxed);
+  }
+
+  /// Take the pending key frame request, if any.
+  bool TakeKeyFrameRequest() noexcept {
+    return keyframe_requested_.exchange(false, std::memory_order_relaxed);
+  }
+
+  /// Record the layers of an encoded frame of the stream, from its RTP payload
+  /// descriptor. Only called on the decoding thread.
+  void RecordLayers(
+      const webrtc::CodecSpecificInfo* codec_specific_info) noexcept;
+
+  /// Get the layers received over the last |kLayerWindowFrames| frames.
+  mrsVideoLayerStats GetLayerStats() const noexcept;
+
+  /// Deliver an encoded frame to the callback and the sinks.
+  void OnEncodedFrame(const webrtc::EncodedImage& image,
+                      webrtc::VideoCodecType codec_type,
+                      const char* codec_name) noexcept;
+
+  /// Record the metadata sent along with an encoded frame, for the remote
+  /// video track to deliver it with the decoded frame. Only the metadata of
+  /// the last few frames is kept.
+  void AddFrameMetadata(uint32_t rtp_timestamp,
+                        FrameMetadata metadata) noexcept;
+
+  /// Find the metadata of a decoded frame from its RTP timestamp, or NULL if
+  /// the frame has none.
+  FrameMetadata FindFrameMetadata(uint32_t rtp_timestamp) const noexcept;
+
+ private:
+  std::mutex mutex_;
+  EncodedVideoFrameCallback callback_ RTC_GUARDED_BY(mutex_);
+  std::vector<EncodedFrameSink*> sinks_ RTC_GUARDED_BY(mutex_);
+  mutable std::mutex metadata_mutex_;
+  std::deque<std::pair<uint32_t, FrameMetadata>> metadata_
+      RTC_GUARDED_BY(metadata_mutex_);
+  std::atomic_bool has_metadata_{false};
+
+  /// Number of frames the layers are reported over.
+  static constexpr const uint64_t kLayerWindowFrames = 64;
+  static constexpr const int kMaxLayers = 4;
+
+  /// Number of frames recorded, and number of the last frame of each spatial
+  /// and temporal layer plus one, or zero if none.
+  std::atomic<uint64_t> layer_frame_count_{0};
+  std::atomic<uint64_t> last_spatial_frames_[kMaxLayers]{};
+  std::atomic<uint64_t> last_temporal_frames_[kMaxLayers]{};
+
+  std::atomic_bool decoding_enabled_{true};
+  std::atomic_bool low_priority_decoding_{false};
+  std::atomic_bool keyframe_requested_{false};
+};
+
+/// Collection of the encoded frame taps, indexed by receive stream ID, which
+/// is the ID of the remote track fed by the stream. A tap lives as long as
+/// either the decoder or the remote track holds it, so either can be created
+/// first. This is multithread-safe.
+class EncodedFrameTapRegistry {
+ public:
+  /// Get the tap of a receive stream, creating it if needed.
+  std::shared_ptr<EncodedFrameTap> GetOrCreate(const std::string& stream_id);
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<EncodedFrameTap>> taps_
+      RTC_GUARDED_BY(mutex_);
+};
+
+/// Video decoder factory wrapping the decoders of another factory to deliver
+/// the encoded frames of each receive stream to its tap before decoding, and
+/// to limit their threads to those allocated by the thread budget.
+class EncodedFrameTapDecoderFactory : public webrtc::VideoDecoderFactory {
+ public:
+  EncodedFrameTapDecoderFactory(
+      std::unique_ptr<webrtc::VideoDecoderFactory> decoder_factory,
+      std::shared_ptr<EncodedFrameTapRegistry> registry,
+      std::shared_ptr<DecoderThreadBudget> thread_budget) noexcept
+      : decoder_factory_(std::move(decoder_factory)),
+        registry_(std::move(registry)),
+        thread_budget_(std::move(thread_budget)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoDecoder> CreateVideoDecoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+  /// Create a decoder for the given receive stream. This is the only factory
+  /// method receiving the ID of the stream, which the video engine uses when
+  /// configuring receive streams.
+  std::unique_ptr<webrtc::VideoDecoder> LegacyCreateVideoDecoder(
+      const webrtc::SdpVideoFormat& format,
+      const std::string& receive_stream_id) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoderFactory> decoder_factory_;
+  std::shared_ptr<EncodedFrameTapRegistry> registry_;
+  std::shared_ptr<DecoderThreadBudget> thread_budget_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "event_queue.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+constexpr size_t EventQueue::kCapacity;
+
+EventQueue& EventQueue::Instance() noexcept {
+  // Never destroyed, as events may be recorded until the process exits.
+  static EventQueue* const instance = new EventQueue(kCapacity);
+  return *instance;
+}
+
+EventQueue::EventQueue(size_t capacity) noexcept
+    : mask_(capacity - 1), slots_(new Slot[capacity]) {
+  RTC_DCHECK_GT(capacity, 0u);
+  RTC_DCHECK_EQ(capacity & mask_, 0u);
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool EventQueue::Push(const mrsEvent& event) noexcept {
+  // Claim the slot of the next position, unless a writer claimed it first, in
+  // which case retry with the following position.
+  size_t pos = write_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[pos & mask_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (write_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the event of the previous turn.
+      dropped_count_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = write_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Assigning reuses the capacity of the buffers of the slot.
+  slot->event = event;
+  slot->data.assign(static_cast<const char*>(event.data), (size_t)event.size);
+  if (event.text) {
+    slot->text.assign(event.text);
+  }
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t EventQueue::Poll(mrsEvent* events, uint32_t max_count) noexcept {
+  if (data_.size() < max_count) {
+    data_.resize(max_count);
+    text_.resize(max_count);
+  }
+  uint32_t count = 0;
+  if (max_count == 0) {
+    return count;
+  }
+  const uint64_t dropped_count =
+      dropped_count_.exchange(0, std::memory_order_relaxed);
+  if (dropped_count > 0) {
+    events[count] = mrsEvent{};
+    events[count].type = mrsEventType::kEventsDropped;
+    events[count].size = dropped_count;
+    ++count;
+  }
+  for (; count < max_count; ++count, ++read_pos_) {
+    Slot& slot = slots_[read_pos_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != read_pos_ + 1) {
+      break;  // Empty, or the event is still being written
+    }
+    mrsEvent& event = events[count];
+    event = slot.event;
+    slot.data.swap(data_[count]);
+    event.data = (event.size > 0 ? data_[count].data() : nullptr);
+    if (event.text) {
+      slot.text.swap(text_[count]);
+      event.text = text_[count].c_str();
+    }
+    // Release the slot for the next turn of the queue.
+    slot.sequence.store(read_pos_ + mask_ + 1, std::memory_order_release);
+  }
+  return count;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
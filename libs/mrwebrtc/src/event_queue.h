@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event_queue_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Bounded queue of events, recorded by any number of threads and polled by a
+/// single thread. Recording an event never takes a lock. Payloads are copied
+/// into buffers owned by the slots of the queue, which are swapped with the
+/// buffers of the poller instead of being copied again, so once warmed up the
+/// queue does not allocate.
+class EventQueue {
+ public:
+  /// Number of events held by the queue.
+  static constexpr size_t kCapacity = 4096;
+
+  /// Get the process-wide queue polled by |mrsPollEvents()|.
+  static EventQueue& Instance() noexcept;
+
+  /// Create a queue holding up to |capacity| events, which must be a power of
+  /// two.
+  explicit EventQueue(size_t capacity) noexcept;
+
+  /// Record a copy of an event and of its payload. Return |false| if the
+  /// queue is full and the event was dropped.
+  bool Push(const mrsEvent& event) noexcept;
+
+  /// Move up to |max_count| of the oldest events to |events|, and return the
+  /// number of events moved. The payloads of the events are valid until the
+  /// next call. This must not be called concurrently.
+  uint32_t Poll(mrsEvent* events, uint32_t max_count) noexcept;
+
+ private:
+  struct Slot {
+    /// Position of the event in the queue when it can be read, or of the next
+    /// turn of the queue when the slot can be written.
+    std::atomic<size_t> sequence{0};
+    mrsEvent event;
+    std::string data;
+    std::string text;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  /// Position of the next event to write, shared by the writers.
+  std::atomic<size_t> write_pos_{0};
+
+  /// Position of the next event to read, only accessed by the poller.
+  size_t read_pos_{0};
+
+  /// Number of events dropped and not reported yet.
+  std::atomic<uint64_t> dropped_count_{0};
+
+  /// Payloads of the events returned by the last poll.
+  std::vector<std::string> data_;
+  std::vector<std::string> text_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,464 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "frame_metadata.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+#include "modules/include/module_common_types.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/timeutils.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Time after which metadata or a playout delay not found by any encoder
+/// expires.
+constexpr int64_t kFrameMetadataTimeoutMs = 1000;
+
+/// Maximum number of frames with metadata, a playout delay or encoder options
+/// pending, to bound the memory used by sources attaching metadata faster than
+/// it expires.
+constexpr size_t kMaxAttachedFrames = 64;
+
+/// Maximum number of frames with metadata or a playout delay pending encoding
+/// in an encoder.
+constexpr size_t kMaxPendingEncodes = 8;
+
+/// Time after which an encoder whose frames stopped carrying encoder options
+/// reverts to the default options. Options of frames dropped or expired before
+/// reaching the encoder are missed, which must not reinitialize the encoder.
+constexpr int64_t kEncoderOptionsTimeoutMs = 1000;
+
+/// Magic value ending the metadata trailer of an encoded frame. The trailer is
+/// the metadata followed by its size as a little-endian 16-bit value, then by
+/// this value.
+constexpr uint8_t kTrailerMagic[4] = {'M', 'R', 'F', 'M'};
+
+/// Size of the trailer in addition to the metadata itself.
+constexpr size_t kTrailerOverhead = 2 + sizeof(kTrailerMagic);
+
+struct AttachedFrame {
+  /// Never dereferenced, only compared.
+  const webrtc::VideoFrameBuffer* buffer_;
+  int64_t timestamp_us_;
+  int64_t expiry_ms_;
+  /// NULL for frames with only a playout delay.
+  FrameMetadata metadata_;
+  /// {-1, -1} for frames without a playout delay.
+  webrtc::PlayoutDelay playout_delay_;
+  /// Default options for frames without encoder options.
+  mrsVideoEncoderOptions encoder_options_;
+};
+
+/// Frames with metadata, a playout delay or encoder options attached. The
+/// count allows looking up frames without the lock in the common case without
+/// any metadata.
+std::mutex g_attached_frames_mutex;
+std::deque<AttachedFrame> g_attached_frames
+    RTC_GUARDED_BY(g_attached_frames_mutex);
+std::atomic<size_t> g_attached_frame_count{0};
+
+/// Remove the expired metadata. Frames are attached in expiry order.
+void PurgeAttachedFrames(int64_t now_ms)
+    RTC_EXCLUSIVE_LOCKS_REQUIRED(g_attached_frames_mutex) {
+  while (!g_attached_frames.empty() &&
+         ((g_attached_frames.front().expiry_ms_ <= now_ms) ||
+          (g_attached_frames.size() > kMaxAttachedFrames))) {
+    g_attached_frames.pop_front();
+  }
+  g_attached_frame_count.store(g_attached_frames.size(),
+                               std::memory_order_relaxed);
+}
+
+bool HasPlayoutDelay(const webrtc::PlayoutDelay& delay) noexcept {
+  return (delay.min_ms >= 0) || (delay.max_ms >= 0);
+}
+
+bool IsSameOptions(const mrsVideoEncoderOptions& a,
+                   const mrsVideoEncoderOptions& b) noexcept {
+  return (a.preset == b.preset) && (a.max_threads == b.max_threads);
+}
+
+/// Complexity of the VP8 and VP9 encoders for an encoder preset.
+webrtc::VideoCodecComplexity ToComplexity(
+    mrsVideoEncoderPreset preset) noexcept {
+  switch (preset) {
+    default:
+    case mrsVideoEncoderPreset::kRealtimeFast:
+      return webrtc::kComplexityNormal;
+    case mrsVideoEncoderPreset::kBalanced:
+      return webrtc::kComplexityHigh;
+    case mrsVideoEncoderPreset::kQuality:
+      return webrtc::kComplexityMax;
+  }
+}
+
+/// Encoder appending the metadata attached to each frame to its encoded image,
+/// and applying the encoder options requested for the frames.
+class FrameMetadataEncoder : public webrtc::VideoEncoder,
+                             public webrtc::EncodedImageCallback {
+ public:
+  explicit FrameMetadataEncoder(
+      std::unique_ptr<webrtc::VideoEncoder> encoder) noexcept
+      : encoder_(std::move(encoder)) {}
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    // Keep the settings to reinitialize the encoder when its options change.
+    codec_settings_ = *codec_settings;
+    number_of_cores_ = number_of_cores;
+    max_payload_size_ = max_payload_size;
+    has_rate_allocation_ = false;
+    return InitEncodeWithOptions();
+  }
+
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    callback_ = callback;
+    return encoder_->RegisterEncodeCompleteCallback(callback ? this : nullptr);
+  }
+
+  int32_t Release() override { return encoder_->Release(); }
+
+  int32_t Encode(const webrtc::VideoFrame& frame,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override {
+    if (UpdateOptions(FindFrameEncoderOptions(frame))) {
+      // Reinitializing the encoder makes it produce a key frame, which the
+      // receivers need anyway after a change of the encoding parameters.
+      encoder_->Release();
+      const int32_t result = InitEncodeWithOptions();
+      if (result != WEBRTC_VIDEO_CODEC_OK) {
+        return result;
+      }
+      encoder_->RegisterEncodeCompleteCallback(callback_ ? this : nullptr);
+      if (has_rate_allocation_) {
+        encoder_->SetRateAllocation(rate_allocation_, framerate_);
+      }
+    }
+    FrameMetadata metadata = FindFrameMetadata(frame);
+    const webrtc::PlayoutDelay playout_delay = FindFramePlayoutDelay(frame);
+    if (metadata || HasPlayoutDelay(playout_delay)) {
+      // The encoded images only carry the RTP timestamp of their frame.
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_.size() >= kMaxPendingEncodes) {
+        pending_.pop_front();
+      }
+      pending_.push_back(
+          PendingEncode{frame.timestamp(), std::move(metadata), playout_delay});
+    }
+    return encoder_->Encode(frame, codec_specific_info, frame_types);
+  }
+
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override {
+    return encoder_->SetChannelParameters(packet_loss, rtt);
+  }
+
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    rate_allocation_ = allocation;
+    framerate_ = framerate;
+    has_rate_allocation_ = true;
+    return encoder_->SetRateAllocation(allocation, framerate);
+  }
+
+  ScalingSettings GetScalingSettings() const override {
+    return encoder_->GetScalingSettings();
+  }
+
+  bool SupportsNativeHandle() const override {
+    return encoder_->SupportsNativeHandle();
+  }
+
+  const char* ImplementationName() const override {
+    return encoder_->ImplementationName();
+  }
+
+  // EncodedImageCallback interface
+  Result OnEncodedImage(
+      const webrtc::EncodedImage& image,
+      const webrtc::CodecSpecificInfo* codec_specific_info,
+      const webrtc::RTPFragmentationHeader* fragmentation) override {
+    FrameMetadata metadata;
+    webrtc::PlayoutDelay playout_delay{-1, -1};
+    {
+      // Simulcast layers of the same frame share its entry.
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const PendingEncode& pending : pending_) {
+        if (pending.rtp_timestamp_ == image._timeStamp) {
+          metadata = pending.metadata_;
+          playout_delay = pending.playout_delay_;
+        }
+      }
+    }
+    if (!metadata || (image._length == 0)) {
+      if (!HasPlayoutDelay(playout_delay)) {
+        return callback_->OnEncodedImage(image, codec_specific_info,
+                                         fragmentation);
+      }
+      webrtc::EncodedImage delayed_image(image);
+      delayed_image.playout_delay_ = playout_delay;
+      return callback_->OnEncodedImage(delayed_image, codec_specific_info,
+                                       fragmentation);
+    }
+
+    const uint16_t metadata_size = (uint16_t)metadata->size();
+    const uint8_t size_bytes[2] = {(uint8_t)(metadata_size & 0xFF),
+                                   (uint8_t)(metadata_size >> 8)};
+    tagged_buffer_.SetData(image._buffer, image._length);
+    tagged_buffer_.AppendData(metadata->data(), metadata->size());
+    tagged_buffer_.AppendData(size_bytes, sizeof(size_bytes));
+    tagged_buffer_.AppendData(kTrailerMagic, sizeof(kTrailerMagic));
+    webrtc::EncodedImage tagged_image(image);
+    tagged_image._buffer = tagged_buffer_.data();
+    tagged_image._length = tagged_buffer_.size();
+    tagged_image._size = tagged_buffer_.size();
+    if (HasPlayoutDelay(playout_delay)) {
+      tagged_image.playout_delay_ = playout_delay;
+    }
+
+    webrtc::RTPFragmentationHeader tagged_fragmentation;
+    if (fragmentation && (fragmentation->fragmentationVectorSize > 0)) {
+      // Extend the last NAL unit with the trailer, for the packetizer to send
+      // it.
+      tagged_fragmentation.CopyFrom(*fragmentation);
+      tagged_fragmentation
+          .fragmentationLength[fragmentation->fragmentationVectorSize - 1] +=
+          metadata->size() + kTrailerOverhead;
+      fragmentation = &tagged_fragmentation;
+    }
+    return callback_->OnEncodedImage(tagged_image, codec_specific_info,
+                                     fragmentation);
+  }
+
+  void OnDroppedFrame(DropReason reason) override {
+    callback_->OnDroppedFrame(reason);
+  }
+
+ private:
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+  webrtc::EncodedImageCallback* callback_{nullptr};
+
+  struct PendingEncode {
+    uint32_t rtp_timestamp_;
+    FrameMetadata metadata_;
+    webrtc::PlayoutDelay playout_delay_;
+  };
+
+  /// Last frames with metadata or a playout delay passed to the wrapped
+  /// encoder, which may deliver their encoded images on another thread.
+  std::mutex mutex_;
+  std::deque<PendingEncode> pending_ RTC_GUARDED_BY(mutex_);
+
+  /// Encoded image with its metadata trailer, reused for each frame. Only
+  /// accessed by the thread delivering the encoded images.
+  rtc::Buffer tagged_buffer_;
+
+  /// Update the current options from the options of a frame, and return
+  /// |true| if they changed.
+  bool UpdateOptions(const mrsVideoEncoderOptions& options) noexcept {
+    if (IsSameOptions(options, options_)) {
+      options_missing_since_ms_ = -1;
+      return false;
+    }
+    if (!HasEncoderOptions(options)) {
+      const int64_t now_ms = rtc::TimeMillis();
+      if (options_missing_since_ms_ < 0) {
+        options_missing_since_ms_ = now_ms;
+      }
+      if (now_ms - options_missing_since_ms_ < kEncoderOptionsTimeoutMs) {
+        return false;
+      }
+    }
+    options_ = options;
+    options_missing_since_ms_ = -1;
+    return true;
+  }
+
+  /// Initialize the wrapped encoder with the settings of WebRTC adjusted for
+  /// the current options.
+  int32_t InitEncodeWithOptions() noexcept {
+    webrtc::VideoCodec settings = codec_settings_;
+    if (options_.preset != mrsVideoEncoderPreset::kDefault) {
+      if (settings.codecType == webrtc::kVideoCodecVP8) {
+        settings.VP8()->complexity = ToComplexity(options_.preset);
+      } else if (settings.codecType == webrtc::kVideoCodecVP9) {
+        settings.VP9()->complexity = ToComplexity(options_.preset);
+      }
+    }
+    int32_t number_of_cores = number_of_cores_;
+    if (options_.max_threads > 0) {
+      number_of_cores =
+          std::min(number_of_cores, (int32_t)options_.max_threads);
+    }
+    return encoder_->InitEncode(&settings, number_of_cores,
+                                max_payload_size_);
+  }
+
+  //
+  // The members below are only accessed on the encoding thread.
+  //
+
+  /// Settings the encoder was initialized with by WebRTC, and the options
+  /// applied over them.
+  webrtc::VideoCodec codec_settings_;
+  int32_t number_of_cores_{1};
+  size_t max_payload_size_{0};
+  mrsVideoEncoderOptions options_;
+
+  /// Time since which the frames carry no encoder options while some are
+  /// applied, or -1 if they do.
+  int64_t options_missing_since_ms_{-1};
+
+  /// Last rates set by WebRTC, restored after reinitializing the encoder.
+  webrtc::VideoBitrateAllocation rate_allocation_;
+  uint32_t framerate_{0};
+  bool has_rate_allocation_{false};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void AttachFrameMetadata(const webrtc::VideoFrame& frame,
+                         FrameMetadata metadata) noexcept {
+  const int64_t now_ms = rtc::TimeMillis();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  g_attached_frames.push_back(AttachedFrame{
+      frame.video_frame_buffer().get(), frame.timestamp_us(),
+      now_ms + kFrameMetadataTimeoutMs, std::move(metadata),
+      webrtc::PlayoutDelay{-1, -1}, mrsVideoEncoderOptions{}});
+  PurgeAttachedFrames(now_ms);
+}
+
+FrameMetadata FindFrameMetadata(const webrtc::VideoFrame& frame) noexcept {
+  if (g_attached_frame_count.load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+  const webrtc::VideoFrameBuffer* const buffer =
+      frame.video_frame_buffer().get();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  PurgeAttachedFrames(rtc::TimeMillis());
+  for (const AttachedFrame& attached : g_attached_frames) {
+    if ((attached.buffer_ == buffer) &&
+        (attached.timestamp_us_ == frame.timestamp_us()) &&
+        attached.metadata_) {
+      return attached.metadata_;
+    }
+  }
+  return nullptr;
+}
+
+void SetFramePlayoutDelay(const webrtc::VideoFrame& frame,
+                          webrtc::PlayoutDelay delay) noexcept {
+  const int64_t now_ms = rtc::TimeMillis();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  g_attached_frames.push_back(AttachedFrame{
+      frame.video_frame_buffer().get(), frame.timestamp_us(),
+      now_ms + kFrameMetadataTimeoutMs, nullptr, delay,
+      mrsVideoEncoderOptions{}});
+  PurgeAttachedFrames(now_ms);
+}
+
+webrtc::PlayoutDelay FindFramePlayoutDelay(
+    const webrtc::VideoFrame& frame) noexcept {
+  if (g_attached_frame_count.load(std::memory_order_relaxed) == 0) {
+    return webrtc::PlayoutDelay{-1, -1};
+  }
+  const webrtc::VideoFrameBuffer* const buffer =
+      frame.video_frame_buffer().get();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  PurgeAttachedFrames(rtc::TimeMillis());
+  for (const AttachedFrame& attached : g_attached_frames) {
+    if ((attached.buffer_ == buffer) &&
+        (attached.timestamp_us_ == frame.timestamp_us()) &&
+        HasPlayoutDelay(attached.playout_delay_)) {
+      return attached.playout_delay_;
+    }
+  }
+  return webrtc::PlayoutDelay{-1, -1};
+}
+
+void SetFrameEncoderOptions(const webrtc::VideoFrame& frame,
+                            const mrsVideoEncoderOptions& options) noexcept {
+  const int64_t now_ms = rtc::TimeMillis();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  g_attached_frames.push_back(AttachedFrame{
+      frame.video_frame_buffer().get(), frame.timestamp_us(),
+      now_ms + kFrameMetadataTimeoutMs, nullptr, webrtc::PlayoutDelay{-1, -1},
+      options});
+  PurgeAttachedFrames(now_ms);
+}
+
+mrsVideoEncoderOptions FindFrameEncoderOptions(
+    const webrtc::VideoFrame& frame) noexcept {
+  if (g_attached_frame_count.load(std::memory_order_relaxed) == 0) {
+    return mrsVideoEncoderOptions{};
+  }
+  const webrtc::VideoFrameBuffer* const buffer =
+      frame.video_frame_buffer().get();
+  std::lock_guard<std::mutex> lock(g_attached_frames_mutex);
+  PurgeAttachedFrames(rtc::TimeMillis());
+  for (const AttachedFrame& attached : g_attached_frames) {
+    if ((attached.buffer_ == buffer) &&
+        (attached.timestamp_us_ == frame.timestamp_us()) &&
+        HasEncoderOptions(attached.encoder_options_)) {
+      return attached.encoder_options_;
+    }
+  }
+  return mrsVideoEncoderOptions{};
+}
+
+FrameMetadata StripFrameMetadata(const uint8_t* data, size_t& size) noexcept {
+  if (!data || (size < kTrailerOverhead) ||
+      (memcmp(data + size - sizeof(kTrailerMagic), kTrailerMagic,
+              sizeof(kTrailerMagic)) != 0)) {
+    return nullptr;
+  }
+  const uint8_t* const size_bytes = data + size - kTrailerOverhead;
+  const size_t metadata_size = size_bytes[0] | ((size_t)size_bytes[1] << 8);
+  if ((metadata_size > kMaxFrameMetadataSize) ||
+      (metadata_size + kTrailerOverhead > size)) {
+    return nullptr;
+  }
+  size -= metadata_size + kTrailerOverhead;
+  return std::make_shared<const rtc::Buffer>(data + size, metadata_size);
+}
+
+std::vector<webrtc::SdpVideoFormat>
+FrameMetadataEncoderFactory::GetSupportedFormats() const {
+  return encoder_factory_->GetSupportedFormats();
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+FrameMetadataEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  return encoder_factory_->QueryVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+FrameMetadataEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      encoder_factory_->CreateVideoEncoder(format);
+  if (!encoder) {
+    return nullptr;
+  }
+  return absl::make_unique<FrameMetadataEncoder>(std::move(encoder));
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video_codecs/video_encoder_factory.h"
+#include "common_types.h"
+#include "rtc_base/buffer.h"
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Maximum size of the application metadata attached to a video frame, in
+/// bytes.
+constexpr size_t kMaxFrameMetadataSize = 1024;
+
+/// Application metadata attached to a video frame, shared read-only by all the
+/// consumers of the frame.
+using FrameMetadata = std::shared_ptr<const rtc::Buffer>;
+
+/// Attach metadata to a frame dispatched by a local video source, for the
+/// frame observers of the source and its tracks, and for the encoders created
+/// by |FrameMetadataEncoderFactory|, to find it. Frames are identified by their
+/// buffer and capture time, as pooled buffers are reused. The metadata expires
+/// after a short time, in case the frame is dropped before reaching any
+/// encoder.
+void AttachFrameMetadata(const webrtc::VideoFrame& frame,
+                         FrameMetadata metadata) noexcept;
+
+/// Find the metadata attached to a frame with |AttachFrameMetadata()|, or NULL
+/// if the frame has none.
+FrameMetadata FindFrameMetadata(const webrtc::VideoFrame& frame) noexcept;
+
+/// Request the receivers of a frame dispatched by a local video source to play
+/// it out with a delay within |delay|, in milliseconds, through the playout
+/// delay RTP header extension. The encoders created by
+/// |FrameMetadataEncoderFactory| stamp the delay on the encoded frame. Like for
+/// |AttachFrameMetadata()|, the request expires after a short time.
+void SetFramePlayoutDelay(const webrtc::VideoFrame& frame,
+                          webrtc::PlayoutDelay delay) noexcept;
+
+/// Find the playout delay requested for a frame with |SetFramePlayoutDelay()|,
+/// or {-1, -1} if none was requested.
+webrtc::PlayoutDelay FindFramePlayoutDelay(
+    const webrtc::VideoFrame& frame) noexcept;
+
+/// Check if encoder options differ from the default ones.
+inline bool HasEncoderOptions(const mrsVideoEncoderOptions& options) noexcept {
+  return (options.preset != mrsVideoEncoderPreset::kDefault) ||
+         (options.max_threads != 0);
+}
+
+/// Request the encoders created by |FrameMetadataEncoderFactory| encoding a
+/// frame dispatched by a local video source to use |options|. The encoders
+/// reinitialize the wrapped encoder each time the options of their frames
+/// change, including to the default options once frames stopped carrying any
+/// for a second.
+/// Like for |AttachFrameMetadata()|, the request expires after a short time.
+void SetFrameEncoderOptions(const webrtc::VideoFrame& frame,
+                            const mrsVideoEncoderOptions& options) noexcept;
+
+/// Find the encoder options requested for a frame with
+/// |SetFrameEncoderOptions()|, or the default options if none were requested.
+mrsVideoEncoderOptions FindFrameEncoderOptions(
+    const webrtc::VideoFrame& frame) noexcept;
+
+/// Remove the metadata trailer appended to an encoded frame by the encoders of
+/// |FrameMetadataEncoderFactory|, if any, and return the metadata it carried.
+/// On return, |size| is the size of the encoded frame without the trailer.
+FrameMetadata StripFrameMetadata(const uint8_t* data, size_t& size) noexcept;
+
+/// Video encoder factory wrapping the encoders of another factory to send the
+/// metadata attached to each frame along with it, as a trailer appended to the
+/// encoded frame, which |StripFrameMetadata()| removes on the receiver before
+/// decoding. Frames without metadata are sent unchanged, so streams without
+/// any metadata remain decodable by any receiver. The encoders also stamp the
+/// playout delay requested for each frame, if any, and apply the encoder
+/// options requested for it.
+class FrameMetadataEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  explicit FrameMetadataEncoderFactory(
+      std::unique_ptr<webrtc::VideoEncoderFactory> encoder_factory) noexcept
+      : encoder_factory_(std::move(encoder_factory)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoEncoderFactory> encoder_factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "frame_timing_stats.h"
+
+namespace {
+
+/// Minimum gap between two frames for the stream to be considered paused,
+/// in microseconds.
+constexpr const int64_t kPauseThresholdUs = 5000000;
+
+/// Minimum excess of a gap over the average for a freeze, in microseconds.
+constexpr const int64_t kFreezeMarginUs = 150000;
+
+/// Weight of the last gap in the average gap.
+constexpr const int64_t kAverageWeight = 30;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void FrameTimingStats::RecordFrame(int64_t now_us) noexcept {
+  frame_count_.fetch_add(1, std::memory_order_relaxed);
+  int64_t expected = -1;
+  first_frame_us_.compare_exchange_strong(expected, now_us,
+                                          std::memory_order_relaxed);
+
+  // Count the frame in the bucket of its second, recycling the bucket if it
+  // still holds an older second.
+  const int64_t second = now_us / 1000000;
+  SecondBucket& bucket =
+      seconds_[static_cast<size_t>(second % seconds_.size())];
+  int64_t bucket_second = bucket.second.load(std::memory_order_relaxed);
+  if ((bucket_second != second) &&
+      bucket.second.compare_exchange_strong(bucket_second, second,
+                                            std::memory_order_relaxed)) {
+    bucket.count.store(0, std::memory_order_relaxed);
+  }
+  bucket.count.fetch_add(1, std::memory_order_relaxed);
+
+  const int64_t last_us =
+      last_frame_us_.exchange(now_us, std::memory_order_relaxed);
+  if (last_us < 0) {
+    return;
+  }
+  const int64_t interval_us = now_us - last_us;
+  if (interval_us < 0) {
+    return;
+  }
+  inter_arrival_.Record(interval_us);
+
+  const int64_t average_us =
+      average_interval_us_.load(std::memory_order_relaxed);
+  if (interval_us >= kPauseThresholdUs) {
+    pause_count_.fetch_add(1, std::memory_order_relaxed);
+    pause_duration_us_.fetch_add(interval_us, std::memory_order_relaxed);
+  } else if ((average_us > 0) &&
+             (interval_us >= std::max(3 * average_us,
+                                      average_us + kFreezeMarginUs))) {
+    freeze_count_.fetch_add(1, std::memory_order_relaxed);
+    freeze_duration_us_.fetch_add(interval_us, std::memory_order_relaxed);
+  } else {
+    // Freezes and pauses are excluded from the average, otherwise a long
+    // freeze would hide the next ones.
+    average_interval_us_.store(
+        average_us > 0
+            ? average_us + (interval_us - average_us) / kAverageWeight
+            : interval_us,
+        std::memory_order_relaxed);
+  }
+}
+
+FrameTimingSummary FrameTimingStats::GetSummary(int64_t now_us) const
+    noexcept {
+  FrameTimingSummary summary;
+  summary.frame_count_ = frame_count_.load(std::memory_order_relaxed);
+  summary.inter_arrival_ = inter_arrival_.GetSummary();
+  summary.freeze_count_ = freeze_count_.load(std::memory_order_relaxed);
+  summary.total_freeze_duration_ms_ =
+      freeze_duration_us_.load(std::memory_order_relaxed) / 1000.0;
+  summary.pause_count_ = pause_count_.load(std::memory_order_relaxed);
+  summary.total_pause_duration_ms_ =
+      pause_duration_us_.load(std::memory_order_relaxed) / 1000.0;
+  const int64_t last_us = last_frame_us_.load(std::memory_order_relaxed);
+  if (last_us < 0) {
+    return summary;
+  }
+  summary.time_since_last_frame_ms_ =
+      std::max<int64_t>(now_us - last_us, 0) / 1000.0;
+
+  // Only count the complete seconds since the first frame, so that the rate
+  // is not underestimated while the window fills up.
+  const int64_t now_second = now_us / 1000000;
+  const int64_t first_second =
+      first_frame_us_.load(std::memory_order_relaxed) / 1000000;
+  const int64_t window =
+      std::min<int64_t>(now_second - first_second, kWindowSeconds);
+  if (window <= 0) {
+    return summary;
+  }
+  uint64_t window_count = 0;
+  for (int64_t second = now_second - window; second < now_second; ++second) {
+    const SecondBucket& bucket =
+        seconds_[static_cast<size_t>(second % seconds_.size())];
+    if (bucket.second.load(std::memory_order_relaxed) != second) {
+      continue;
+    }
+    const uint32_t count = bucket.count.load(std::memory_order_relaxed);
+    window_count += count;
+    if (second == now_second - 1) {
+      summary.framerate_1s_ = count;
+    }
+  }
+  summary.framerate_window_ = (double)window_count / window;
+  return summary;
+}
+
+void FrameTimingStats::Reset() noexcept {
+  inter_arrival_.Reset();
+  frame_count_.store(0, std::memory_order_relaxed);
+  first_frame_us_.store(-1, std::memory_order_relaxed);
+  last_frame_us_.store(-1, std::memory_order_relaxed);
+  average_interval_us_.store(0, std::memory_order_relaxed);
+  freeze_count_.store(0, std::memory_order_relaxed);
+  freeze_duration_us_.store(0, std::memory_order_relaxed);
+  pause_count_.store(0, std::memory_order_relaxed);
+  pause_duration_us_.store(0, std::memory_order_relaxed);
+  for (auto&& bucket : seconds_) {
+    bucket.second.store(-1, std::memory_order_relaxed);
+    bucket.count.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
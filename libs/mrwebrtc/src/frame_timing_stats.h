@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Summary of the frame arrivals recorded by |FrameTimingStats|.
+struct FrameTimingSummary {
+  /// Number of frames recorded.
+  uint64_t frame_count_ = 0;
+
+  /// Framerate over the last complete second, and over the last complete
+  /// seconds of the window, in frames per second.
+  double framerate_1s_ = 0.0;
+  double framerate_window_ = 0.0;
+
+  /// Percentiles of the time between two consecutive frames.
+  LatencySummary inter_arrival_;
+
+  /// Freezes, and their total duration in milliseconds.
+  uint64_t freeze_count_ = 0;
+  double total_freeze_duration_ms_ = 0.0;
+
+  /// Pauses, and their total duration in milliseconds.
+  uint64_t pause_count_ = 0;
+  double total_pause_duration_ms_ = 0.0;
+
+  /// Time since the last frame, in milliseconds, or -1 if no frame arrived.
+  double time_since_last_frame_ms_ = -1.0;
+};
+
+/// Timing of the arrival of the frames of a video stream, to tell stalls of
+/// the stream from delays of the application consuming its frames. Like the
+/// standard stats of the receive streams, a gap between two frames is a
+/// freeze when longer than both 3 times the average gap and the average gap
+/// plus 150 ms, and a pause when longer than 5 seconds. Recording a frame is
+/// lock-free so that it can be done on the per-frame path, and reading the
+/// summary may run concurrently with recording.
+class FrameTimingStats {
+ public:
+  /// Duration of the window of the framerate, in seconds.
+  static constexpr int kWindowSeconds = 10;
+
+  FrameTimingStats() noexcept { Reset(); }
+
+  /// Record the arrival of a frame at |now_us|, in microseconds of
+  /// |rtc::TimeMicros()|.
+  void RecordFrame(int64_t now_us) noexcept;
+
+  /// Get the statistics of the frames recorded since the last reset.
+  FrameTimingSummary GetSummary(int64_t now_us) const noexcept;
+
+  /// Discard all frames recorded so far.
+  void Reset() noexcept;
+
+ private:
+  /// Number of frames which arrived during one second.
+  struct SecondBucket {
+    std::atomic<int64_t> second;
+    std::atomic<uint32_t> count;
+  };
+
+  LatencyHistogram inter_arrival_;
+  std::atomic<uint64_t> frame_count_;
+  std::atomic<int64_t> first_frame_us_;
+  std::atomic<int64_t> last_frame_us_;
+
+  /// Average gap between two frames, excluding freezes and pauses, or zero
+  /// before the second frame.
+  std::atomic<int64_t> average_interval_us_;
+
+  std::atomic<uint64_t> freeze_count_;
+  std::atomic<int64_t> freeze_duration_us_;
+  std::atomic<uint64_t> pause_count_;
+  std::atomic<int64_t> pause_duration_us_;
+
+  /// Frame counts of the last seconds, indexed by second modulo the bucket
+  /// count. The extra bucket holds the current, incomplete second.
+  std::array<SecondBucket, kWindowSeconds + 1> seconds_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "audio_conversion.h"
+#include "gain_ramp.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void GainRamp::SetTarget(float left, float right, int sample_rate) noexcept {
+  if ((left == target_[0]) && (right == target_[1])) {
+    return;
+  }
+  target_[0] = left;
+  target_[1] = right;
+  remaining_frames_ = std::max<size_t>((size_t)sample_rate * kRampMs / 1000, 1);
+  for (int c = 0; c < 2; ++c) {
+    step_[c] = (target_[c] - current_[c]) / (float)remaining_frames_;
+  }
+}
+
+size_t GainRamp::NextSegment(size_t frame_count,
+                             float gain[2],
+                             float step[2]) noexcept {
+  gain[0] = current_[0];
+  gain[1] = current_[1];
+  if (remaining_frames_ == 0) {
+    step[0] = step[1] = 0.0f;
+    return frame_count;
+  }
+  const size_t count = std::min(frame_count, remaining_frames_);
+  step[0] = step_[0];
+  step[1] = step_[1];
+  remaining_frames_ -= count;
+  if (remaining_frames_ == 0) {
+    // Land exactly on the target, whatever the rounding of the steps.
+    current_[0] = target_[0];
+    current_[1] = target_[1];
+  } else {
+    current_[0] += step_[0] * (float)count;
+    current_[1] += step_[1] * (float)count;
+  }
+  return count;
+}
+
+void GainRamp::Apply(const int16_t* src,
+                     int16_t* dst,
+                     size_t frame_count,
+                     int channels) noexcept {
+  while (frame_count > 0) {
+    float gain[2];
+    float step[2];
+    const size_t count = NextSegment(frame_count, gain, step);
+    ScaleS16Ramp(src, dst, count, channels, gain, step);
+    src += count * channels;
+    dst += count * channels;
+    frame_count -= count;
+  }
+}
+
+void GainRamp::ApplyUpmix(const int16_t* src,
+                          int16_t* dst,
+                          size_t frame_count) noexcept {
+  while (frame_count > 0) {
+    float gain[2];
+    float step[2];
+    const size_t count = NextSegment(frame_count, gain, step);
+    UpmixMonoS16ToStereoS16Ramp(src, dst, count, gain, step);
+    src += count;
+    dst += count * 2;
+    frame_count -= count;
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Gains of the left and right channels of an audio stream, ramping linearly
+/// to new values over |kRampMs| rather than stepping, which would click. Mono
+/// streams use the left gain. This is not thread safe.
+class GainRamp {
+ public:
+  /// Duration of the ramp toward new gains, in milliseconds.
+  static constexpr const int kRampMs = 20;
+
+  /// Check if the gains are exactly one with no ramp in progress, in which
+  /// case the stream can be left untouched.
+  bool IsUnity() const noexcept {
+    return (remaining_frames_ == 0) && (current_[0] == 1.0f) &&
+           (current_[1] == 1.0f);
+  }
+
+  /// Check if both channels have the same gain, now and once the ramp ends,
+  /// in which case a mono stream does not need to be upmixed to be panned.
+  bool IsBalanced() const noexcept {
+    return (current_[0] == current_[1]) && (target_[0] == target_[1]);
+  }
+
+  /// Set the gains to ramp to, starting with the next frames. This is a no-op
+  /// if they are the current target.
+  void SetTarget(float left, float right, int sample_rate) noexcept;
+
+  /// Scale |frame_count| interleaved frames of |channels| channels, 1 or 2,
+  /// from |src| into |dst|, and advance the ramp. This can operate in place.
+  void Apply(const int16_t* src,
+             int16_t* dst,
+             size_t frame_count,
+             int channels) noexcept;
+
+  /// Upmix |frame_count| mono frames from |src| to stereo frames into |dst|,
+  /// scaling each channel by its own gain, and advance the ramp.
+  void ApplyUpmix(const int16_t* src,
+                  int16_t* dst,
+                  size_t frame_count) noexcept;
+
+ private:
+  /// Get the start gains and the per-frame steps of the next frames, and
+  /// advance the ramp past them. Return the number of frames covered, at most
+  /// |frame_count|, which is less if the ramp ends before.
+  size_t NextSegment(size_t frame_count,
+                     float gain[2],
+                     float step[2]) noexcept;
+
+  float current_[2]{1.0f, 1.0f};
+  float target_[2]{1.0f, 1.0f};
+  float step_[2]{0.0f, 0.0f};
+  size_t remaining_frames_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -8,6 +8,7 @@
 #include "callback.h"
 #include "data_channel.h"
 #include "data_channel_interop.h"
+#include "peer_connection.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
@@ -51,3 +52,373 @@ mrsDataChannelSendMessage(mrsDataChannelHandle dataChannelHandle,
   return (data_channel->Send(data, (size_t)size) ? Result::kSuccess
                                                  : Result::kUnknownError);
 }
+
+mrsResult MRS_CALL
+mrsDataChannelSendMessages(mrsDataChannelHandle data_channel_handle,
+                           const mrsDataChannelMessage* messages,
+                           int32_t count,
+                           mrsBool* accepted_out,
+                           int32_t* num_accepted_out) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((count < 0) || ((count > 0) && !messages) || !num_accepted_out) {
+    return Result::kInvalidParameter;
+  }
+  *num_accepted_out = 0;
+  if (count == 0) {
+    return Result::kSuccess;
+  }
+  *num_accepted_out = data_channel->SendBatch(messages, count, accepted_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsDataChannelSetSendQueue(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelSendQueueConfig* config) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!config) {
+    data_channel->DisableSendQueue();
+    return Result::kSuccess;
+  }
+  if ((config->low_watermark >= config->high_watermark) ||
+      (config->high_watermark > data_channel->GetMaxBufferingSize())) {
+    RTC_LOG(LS_ERROR) << "Invalid data channel send queue watermarks "
+                      << config->low_watermark << " and "
+                      << config->high_watermark << " bytes.";
+    return Result::kInvalidParameter;
+  }
+  data_channel->EnableSendQueue((size_t)config->high_watermark,
+                                (size_t)config->low_watermark);
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsDataChannelRegisterWritableCallback(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelWritableCallback callback,
+    void* user_data) noexcept {
+  if (auto data_channel = static_cast<DataChannel*>(data_channel_handle)) {
+    data_channel->SetWritableCallback({callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL
+mrsDataChannelQueueMessage(mrsDataChannelHandle data_channel_handle,
+                           const void* data,
+                           uint64_t size) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((size > 0) && !data) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->QueueSend(data, (size_t)size);
+}
+
+mrsResult MRS_CALL mrsDataChannelSetReceiveRing(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelReceiveRingConfig* config) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!config) {
+    data_channel->DisableReceiveRing();
+    return Result::kSuccess;
+  }
+  if ((config->capacity_bytes == 0) || (config->capacity_bytes > SIZE_MAX) ||
+      (config->max_messages <= 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid data channel receive ring capacity of "
+                      << config->capacity_bytes << " bytes and "
+                      << config->max_messages << " messages.";
+    return Result::kInvalidParameter;
+  }
+  const MessageRing::OverflowPolicy policy =
+      (config->overflow_policy ==
+               mrsDataChannelReceiveOverflowPolicy::kDropOldest
+           ? MessageRing::OverflowPolicy::kDropOldest
+           : MessageRing::OverflowPolicy::kDropNewest);
+  data_channel->EnableReceiveRing((size_t)config->capacity_bytes,
+                                  (size_t)config->max_messages, policy);
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsDataChannelRegisterDataAvailableCallback(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelDataAvailableCallback callback,
+    void* user_data) noexcept {
+  if (auto data_channel = static_cast<DataChannel*>(data_channel_handle)) {
+    data_channel->SetDataAvailableCallback({callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL
+mrsDataChannelTryReceiveMessage(mrsDataChannelHandle data_channel_handle,
+                                void* buffer,
+                                uint64_t capacity,
+                                uint64_t* size_out,
+                                mrsBool* received_out) noexcept {
+  if (!size_out || !received_out) {
+    return Result::kInvalidParameter;
+  }
+  *size_out = 0;
+  *received_out = mrsBool::kFalse;
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((capacity > 0) && !buffer) {
+    return Result::kInvalidParameter;
+  }
+  size_t size = 0;
+  bool received = false;
+  const Result result = data_channel->TryReceive(
+      buffer, (size_t)std::min<uint64_t>(capacity, SIZE_MAX), &size,
+      &received);
+  *size_out = size;
+  *received_out = (received ? mrsBool::kTrue : mrsBool::kFalse);
+  return result;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelReceiveMessages(mrsDataChannelHandle data_channel_handle,
+                              void* buffer,
+                              uint64_t capacity,
+                              mrsDataChannelMessage* messages_out,
+                              int32_t max_messages,
+                              int32_t* count_out) noexcept {
+  if (!count_out) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = 0;
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((max_messages < 0) || ((max_messages > 0) && !messages_out) ||
+      ((capacity > 0) && !buffer)) {
+    return Result::kInvalidParameter;
+  }
+  int count = 0;
+  const Result result = data_channel->ReceiveMany(
+      buffer, (size_t)std::min<uint64_t>(capacity, SIZE_MAX), messages_out,
+      max_messages, &count);
+  *count_out = count;
+  return result;
+}
+
+mrsResult MRS_CALL mrsDataChannelGetReceiveDroppedCount(
+    mrsDataChannelHandle data_channel_handle,
+    uint64_t* count_out) noexcept {
+  if (!count_out) {
+    return Result::kInvalidParameter;
+  }
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  *count_out = data_channel->GetReceiveDroppedCount();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelOpenStream(mrsDataChannelHandle data_channel_handle,
+                         uint64_t total_size,
+                         uint32_t* stream_id_out) noexcept {
+  if (!stream_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *stream_id_out = 0;
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  return data_channel->stream_sender().Open(total_size, stream_id_out);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelWriteStream(mrsDataChannelHandle data_channel_handle,
+                          uint32_t stream_id,
+                          const void* data,
+                          uint64_t size,
+                          uint64_t* written_out) noexcept {
+  if (!written_out) {
+    return Result::kInvalidParameter;
+  }
+  *written_out = 0;
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((size > 0) && !data) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->stream_sender().Write(stream_id, data, size,
+                                             written_out);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelAbortStream(mrsDataChannelHandle data_channel_handle,
+                          uint32_t stream_id) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  return data_channel->stream_sender().Abort(stream_id);
+}
+
+mrsResult MRS_CALL mrsDataChannelSetStreamReceiver(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelStreamReceiverCallbacks* callbacks) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callbacks) {
+    data_channel->SetStreamReceiver(nullptr);
+    return Result::kSuccess;
+  }
+  if (!callbacks->opened_callback) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->SetStreamReceiver(std::make_unique<DataChannelStreamReceiver>(
+      DataChannelStreamReceiver::OpenedCallback{callbacks->opened_callback,
+                                                callbacks->opened_user_data},
+      DataChannelStreamReceiver::ProgressCallback{
+          callbacks->progress_callback, callbacks->progress_user_data},
+      DataChannelStreamReceiver::CompletedCallback{
+          callbacks->completed_callback, callbacks->completed_user_data}));
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsDataChannelSetCompressionThreshold(
+    mrsDataChannelHandle data_channel_handle,
+    uint64_t threshold) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  data_channel->SetCompressionThreshold(
+      (size_t)std::min<uint64_t>(threshold, SIZE_MAX));
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSetLimits(mrsDataChannelHandle data_channel_handle,
+                        const mrsDataChannelLimits* limits) noexcept {
+  if (!limits) {
+    return Result::kInvalidParameter;
+  }
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  return data_channel->SetLimits(*limits);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelGetLimits(mrsDataChannelHandle data_channel_handle,
+                        mrsDataChannelLimits* limits_out) noexcept {
+  if (!limits_out) {
+    return Result::kInvalidParameter;
+  }
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  limits_out->max_buffering_size = data_channel->GetMaxBufferingSize();
+  limits_out->max_message_size = data_channel->GetMaxMessageSize();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionSetDataChannelLimits(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelLimits* limits) noexcept {
+  if (!limits) {
+    return Result::kInvalidParameter;
+  }
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!DataChannel::AreLimitsValid(*limits)) {
+    return Result::kInvalidParameter;
+  }
+  peer->SetDataChannelLimits(*limits);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelGetCounters(mrsDataChannelHandle data_channel_handle,
+                          mrsDataChannelCounters* counters_out) noexcept {
+  if (!counters_out) {
+    return Result::kInvalidParameter;
+  }
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  data_channel->GetCounters(*counters_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSetLatencyProbeInterval(mrsDataChannelHandle data_channel_handle,
+                                      int32_t interval_ms) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (interval_ms < 0) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->SetLatencyProbeInterval(interval_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelMessageBufferCreate(uint64_t capacity,
+                                  mrsDataChannelMessageBufferHandle* buffer_out,
+                                  void** data_out) noexcept {
+  if (!buffer_out || !data_out) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = nullptr;
+  *data_out = nullptr;
+  if (capacity > SIZE_MAX) {
+    return Result::kOutOfRange;
+  }
+  auto buffer = new rtc::CopyOnWriteBuffer((size_t)capacity);
+  *buffer_out = buffer;
+  *data_out = buffer->data();
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsDataChannelMessageBufferDestroy(
+    mrsDataChannelMessageBufferHandle buffer) noexcept {
+  delete static_cast<rtc::CopyOnWriteBuffer*>(buffer);
+}
+
+mrsResult MRS_CALL mrsDataChannelSendMessageBuffer(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelMessageBufferHandle buffer,
+    uint64_t size) noexcept {
+  std::unique_ptr<rtc::CopyOnWriteBuffer> message(
+      static_cast<rtc::CopyOnWriteBuffer*>(buffer));
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel || !message) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (size > message->size()) {
+    return Result::kInvalidParameter;
+  }
+  // Shrinking keeps the storage, so this does not copy either.
+  message->SetSize((size_t)size);
+  return (data_channel->Send(std::move(*message)) ? Result::kSuccess
+                                                  : Result::kUnknownError);
+}
@@ -11,6 +11,15 @@
 
 using namespace Microsoft::MixedReality::WebRTC;
 
+namespace {
+
+bool IsValid(mrsOptBool value) noexcept {
+  return (value == mrsOptBool::kTrue) || (value == mrsOptBool::kFalse) ||
+         (value == mrsOptBool::kUnset);
+}
+
+}  // namespace
+
 mrsResult MRS_CALL mrsDeviceAudioTrackSourceCreate(
     const mrsLocalAudioDeviceInitConfig* init_config,
     mrsDeviceAudioTrackSourceHandle* source_handle_out) noexcept {
@@ -19,6 +28,17 @@ mrsResult MRS_CALL mrsDeviceAudioTrackSourceCreate(
     return Result::kInvalidParameter;
   }
   *source_handle_out = nullptr;
+  if (!init_config) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL init_config.";
+    return Result::kInvalidParameter;
+  }
+  if (!IsValid(init_config->auto_gain_control_) ||
+      !IsValid(init_config->echo_cancellation_) ||
+      !IsValid(init_config->noise_suppression_) ||
+      !IsValid(init_config->highpass_filter_)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio processing option.";
+    return Result::kInvalidParameter;
+  }
 
   ErrorOr<RefPtr<DeviceAudioTrackSource>> result =
       DeviceAudioTrackSource::Create(*init_config);
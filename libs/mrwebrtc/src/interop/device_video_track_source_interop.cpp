@@ -29,3 +29,48 @@ mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreate(
   *source_handle_out = result.value().release();
   return Result::kSuccess;
 }
+
+mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreateFromAndroidCapturer(
+    mrsBool is_screencast,
+    mrsDeviceVideoTrackSourceHandle* source_handle_out,
+    void** j_capturer_observer_out) noexcept {
+  if (!source_handle_out || !j_capturer_observer_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  *j_capturer_observer_out = nullptr;
+
+  ErrorOr<RefPtr<DeviceVideoTrackSource>> result =
+      DeviceVideoTrackSource::CreateFromAndroidCapturer(
+          is_screencast != mrsBool::kFalse, j_capturer_observer_out);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create Android capturer video track "
+                         "source.";
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsDeviceVideoTrackSourceCreateAsync(
+    const mrsLocalVideoDeviceInitConfig* init_config,
+    mrsDeviceVideoTrackSourceCreatedCallback callback,
+    void* user_data,
+    uint32_t* operation_id_out) noexcept {
+  if (!init_config || !callback || !operation_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *operation_id_out = 0;
+  ErrorOr<uint32_t> result = DeviceVideoTrackSource::CreateAsync(
+      *init_config, {callback, user_data});
+  if (!result.ok()) {
+    return result.error().result();
+  }
+  *operation_id_out = result.value();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDeviceVideoTrackSourceCancelCreateAsync(uint32_t operation_id) noexcept {
+  return DeviceVideoTrackSource::CancelCreateAsync(operation_id);
+}
@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "data_channel.h"
+#include "data_channel_interop.h"
+#include "event_queue.h"
+#include "event_queue_interop.h"
+#include "peer_connection.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+// The callbacks below are registered with the object raising the events as
+// user data, and record the events in the queue.
+
+mrsEvent MakeEvent(mrsEventType type, PeerConnection* peer) noexcept {
+  mrsEvent event{};
+  event.type = type;
+  event.source = peer;
+  event.user_data = peer->GetUserData();
+  return event;
+}
+
+mrsEvent MakeEvent(mrsEventType type, DataChannel* data_channel) noexcept {
+  mrsEvent event{};
+  event.type = type;
+  event.source = data_channel;
+  event.user_data = data_channel->GetUserData();
+  return event;
+}
+
+void SetString(mrsEvent& event, const char* str) noexcept {
+  event.data = str;
+  event.size = (str ? strlen(str) : 0);
+}
+
+void MRS_CALL OnConnected(void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  EventQueue::Instance().Push(MakeEvent(mrsEventType::kConnected, peer));
+}
+
+void MRS_CALL OnLocalSdpReadytoSend(void* user_data,
+                                    mrsSdpMessageType type,
+                                    const char* sdp) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kLocalSdpReadytoSend, peer);
+  event.value = (int32_t)type;
+  SetString(event, sdp);
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnIceCandidateReadytoSend(
+    void* user_data,
+    const mrsIceCandidate* candidate) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kIceCandidateReadytoSend, peer);
+  event.value = candidate->sdp_mline_index;
+  SetString(event, candidate->content);
+  event.text = (candidate->sdp_mid ? candidate->sdp_mid : "");
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnIceStateChanged(void* user_data,
+                                mrsIceConnectionState state) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kIceStateChanged, peer);
+  event.value = (int32_t)state;
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnIceGatheringStateChanged(void* user_data,
+                                         mrsIceGatheringState state) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kIceGatheringStateChanged, peer);
+  event.value = (int32_t)state;
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnRenegotiationNeeded(void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  EventQueue::Instance().Push(
+      MakeEvent(mrsEventType::kRenegotiationNeeded, peer));
+}
+
+void MRS_CALL OnDataChannelMessage(void* user_data,
+                                   const void* data,
+                                   const uint64_t size) noexcept {
+  auto data_channel = static_cast<DataChannel*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kDataChannelMessage, data_channel);
+  event.data = data;
+  event.size = size;
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnDataChannelStateChanged(void* user_data,
+                                        mrsDataChannelState state,
+                                        int id) noexcept {
+  auto data_channel = static_cast<DataChannel*>(user_data);
+  mrsEvent event =
+      MakeEvent(mrsEventType::kDataChannelStateChanged, data_channel);
+  event.value = (int32_t)state;
+  event.size = (uint64_t)id;
+  EventQueue::Instance().Push(event);
+}
+
+void SetEventPolling(DataChannel& data_channel, bool enabled) noexcept {
+  void* const user_data = (enabled ? &data_channel : nullptr);
+  data_channel.SetMessageCallback(
+      {enabled ? &OnDataChannelMessage : nullptr, user_data});
+  data_channel.SetBufferingCallback({});
+  data_channel.SetStateCallback(
+      {enabled ? &OnDataChannelStateChanged : nullptr, user_data});
+}
+
+void MRS_CALL OnDataChannelAdded(void* user_data,
+                                 const mrsDataChannelAddedInfo* info) noexcept {
+  // Enable polling before returning, as the channel may receive messages as
+  // soon as this callback returns.
+  auto data_channel = static_cast<DataChannel*>(info->handle);
+  SetEventPolling(*data_channel, true);
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kDataChannelAdded, peer);
+  event.object = data_channel;
+  event.value = info->id;
+  event.text = (info->label ? info->label : "");
+  EventQueue::Instance().Push(event);
+}
+
+void MRS_CALL OnDataChannelRemoved(void* user_data,
+                                   mrsDataChannelHandle handle) noexcept {
+  auto peer = static_cast<PeerConnection*>(user_data);
+  mrsEvent event = MakeEvent(mrsEventType::kDataChannelRemoved, peer);
+  event.object = handle;
+  EventQueue::Instance().Push(event);
+}
+
+}  // namespace
+
+mrsResult MRS_CALL mrsPollEvents(mrsEvent* events,
+                                 uint32_t max_count,
+                                 uint32_t* count_out) noexcept {
+  if (!count_out) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = 0;
+  if (!events && (max_count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = EventQueue::Instance().Poll(events, max_count);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionSetEventPolling(mrsPeerConnectionHandle peer_handle,
+                                 mrsBool enabled) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  const bool enable = (enabled != mrsBool::kFalse);
+  void* const user_data = (enable ? peer : nullptr);
+  peer->RegisterConnectedCallback(
+      {enable ? &OnConnected : nullptr, user_data});
+  peer->RegisterLocalSdpReadytoSendCallback(
+      {enable ? &OnLocalSdpReadytoSend : nullptr, user_data});
+  peer->RegisterIceCandidateReadytoSendCallback(
+      {enable ? &OnIceCandidateReadytoSend : nullptr, user_data});
+  peer->RegisterIceStateChangedCallback(
+      {enable ? &OnIceStateChanged : nullptr, user_data});
+  peer->RegisterIceGatheringStateChangedCallback(
+      {enable ? &OnIceGatheringStateChanged : nullptr, user_data});
+  peer->RegisterRenegotiationNeededCallback(
+      {enable ? &OnRenegotiationNeeded : nullptr, user_data});
+  peer->RegisterDataChannelAddedCallback(
+      {enable ? &OnDataChannelAdded : nullptr, user_data});
+  peer->RegisterDataChannelRemovedCallback(
+      {enable ? &OnDataChannelRemoved : nullptr, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSetEventPolling(mrsDataChannelHandle data_channel_handle,
+                              mrsBool enabled) noexcept {
+  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  SetEventPolling(*data_channel, (enabled != mrsBool::kFalse));
+  return Result::kSuccess;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "external_audio_track_source_interop.h"
+#include "media/external_audio_track_source.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsExternalAudioTrackSourceCreate(
+    const mrsExternalAudioTrackSourceSettings* settings,
+    mrsExternalAudioTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL audio track source handle.";
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  if (!settings) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL external audio track source settings.";
+    return Result::kInvalidParameter;
+  }
+  ErrorOr<RefPtr<ExternalAudioTrackSource>> result =
+      ExternalAudioTrackSource::Create(*settings);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create external audio track source.";
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsExternalAudioTrackSourcePushAudio(mrsExternalAudioTrackSourceHandle handle,
+                                     const void* data,
+                                     uint32_t frame_count,
+                                     uint32_t* frames_pushed_out) noexcept {
+  if (!frames_pushed_out) {
+    return Result::kInvalidParameter;
+  }
+  *frames_pushed_out = 0;
+  if (!data && (frame_count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto source = static_cast<ExternalAudioTrackSource*>(handle)) {
+    *frames_pushed_out = source->PushAudio(data, frame_count);
+    return Result::kSuccess;
+  }
+  return Result::kInvalidNativeHandle;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "external_encoded_video_track_source_interop.h"
+#include "interop/global_factory.h"
+#include "media/external_encoded_video_track_source.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsExternalEncodedVideoTrackSourceCreate(
+    mrsExternalEncodedVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL video track source handle.";
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  ErrorOr<RefPtr<ExternalEncodedVideoTrackSource>> result =
+      ExternalEncodedVideoTrackSource::Create(GlobalFactory::InstancePtr());
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create external encoded video track "
+                         "source.";
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release();
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsExternalEncodedVideoTrackSourceRegisterKeyFrameCallback(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    mrsKeyFrameRequestedCallback callback,
+    void* user_data) noexcept {
+  if (auto source =
+          static_cast<ExternalEncodedVideoTrackSource*>(source_handle)) {
+    source->SetKeyFrameRequestedCallback(
+        KeyFrameRequestedCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsExternalEncodedVideoTrackSourceRegisterBitrateCallback(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    mrsTargetBitrateChangedCallback callback,
+    void* user_data) noexcept {
+  if (auto source =
+          static_cast<ExternalEncodedVideoTrackSource*>(source_handle)) {
+    source->SetTargetBitrateChangedCallback(
+        TargetBitrateChangedCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL mrsExternalEncodedVideoTrackSourcePushFrame(
+    mrsExternalEncodedVideoTrackSourceHandle source_handle,
+    const mrsEncodedVideoFrame* frame,
+    int64_t timestamp_ms) noexcept {
+  if (!frame) {
+    return Result::kInvalidParameter;
+  }
+  if (auto source =
+          static_cast<ExternalEncodedVideoTrackSource*>(source_handle)) {
+    return source->PushFrame(*frame, timestamp_ms);
+  }
+  return Result::kInvalidNativeHandle;
+}
@@ -9,9 +9,28 @@
 #include "external_video_track_source_interop.h"
 #include "interop/global_factory.h"
 #include "media/external_video_track_source.h"
+#include "media/synthetic_frame_generator.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
+namespace {
+
+/// Read the information passed along with a frame by the application.
+Result ReadFrameInfo(const mrsExternalVideoFrameInfo* info,
+                     absl::optional<int64_t>& capture_time_us,
+                     FrameMetadata& metadata) noexcept {
+  if (!info) {
+    return Result::kInvalidParameter;
+  }
+  if (info->has_capture_time != mrsBool::kFalse) {
+    capture_time_us = info->capture_time_us;
+  }
+  return ExternalVideoTrackSource::CopyFrameMetadata(
+      info->metadata, info->metadata_size, metadata);
+}
+
+}  // namespace
+
 mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromI420ACallback(
     mrsRequestExternalI420AVideoFrameCallback callback,
     void* user_data,
@@ -48,6 +67,95 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromArgb32Callback(
   return Result::kSuccess;
 }
 
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateForPush(
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  RefPtr<ExternalVideoTrackSource> track_source =
+      detail::ExternalVideoTrackSourceCreateForPush(
+          GlobalFactory::InstancePtr());
+  if (!track_source) {
+    return Result::kUnknownError;
+  }
+  *source_handle_out = track_source.release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateSynthetic(
+    const mrsSyntheticVideoSourceConfig* config,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!config || !source_handle_out ||
+      !SyntheticFrameGenerator::IsValidConfig(*config)) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  RefPtr<ExternalVideoTrackSource> track_source =
+      detail::ExternalVideoTrackSourceCreateSynthetic(
+          GlobalFactory::InstancePtr(), *config);
+  if (!track_source) {
+    return Result::kUnknownError;
+  }
+  *source_handle_out = track_source.release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromSharedMemory(
+    const char* mapping_name,
+    const char* doorbell_event_name,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (IsStringNullOrEmpty(mapping_name) ||
+      IsStringNullOrEmpty(doorbell_event_name) || !source_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  RefPtr<ExternalVideoTrackSource> track_source =
+      detail::ExternalVideoTrackSourceCreateForPush(
+          GlobalFactory::InstancePtr());
+  if (!track_source) {
+    return Result::kUnknownError;
+  }
+  const Result result =
+      track_source->ReadFromSharedMemory(mapping_name, doorbell_event_name);
+  if (result != Result::kSuccess) {
+    track_source->Shutdown();
+    return result;
+  }
+  *source_handle_out = track_source.release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceConfigure(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    const mrsExternalVideoTrackSourceSettings* settings) noexcept {
+  if (!settings) {
+    return Result::kInvalidParameter;
+  }
+  if (auto source = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    return source->Configure(*settings);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceSetContentHint(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsVideoContentHint content_hint,
+    mrsOptBool denoising) noexcept {
+  if (auto source = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    return source->SetContentHint(content_hint, denoising);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceNotifyFrameAvailable(
+    mrsExternalVideoTrackSourceHandle source_handle) noexcept {
+  if (auto source = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    return source->NotifyFrameAvailable();
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 void MRS_CALL mrsExternalVideoTrackSourceFinishCreation(
     mrsExternalVideoTrackSourceHandle source_handle) noexcept {
   if (auto source = static_cast<ExternalVideoTrackSource*>(source_handle)) {
@@ -55,6 +163,19 @@ void MRS_CALL mrsExternalVideoTrackSourceFinishCreation(
   }
 }
 
+mrsResult MRS_CALL mrsExternalVideoTrackSourceGetSinkWants(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsExternalVideoSinkWants* wants_out) noexcept {
+  if (!wants_out) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    *wants_out = track->GetSinkWants();
+    return Result::kSuccess;
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
     mrsExternalVideoTrackSourceHandle handle,
     uint32_t request_id,
@@ -69,6 +190,23 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
   return mrsResult::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopy(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept {
+  if (!frame_view || !release_callback) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequestNoCopy(request_id, timestamp_ms, *frame_view,
+                                        {release_callback, release_user_data});
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
     mrsExternalVideoTrackSourceHandle handle,
     uint32_t request_id,
@@ -83,6 +221,442 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
   return mrsResult::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNv12FrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNv12VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, timestamp_ms, *frame_view);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNativeFrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNativeVideoFrame* frame) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, timestamp_ms, *frame);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushI420AFrame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, timestamp_ms);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushArgb32Frame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, timestamp_ms);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNv12Frame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    int64_t timestamp_ms) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, timestamp_ms);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNativeFrame(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    int64_t timestamp_ms) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame, timestamp_ms);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceGetBufferPoolStats(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsExternalVideoBufferPoolStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    const FrameBufferPoolStats stats = track->GetBufferPoolStats();
+    stats_out->hit_count = stats.hit_count_;
+    stats_out->miss_count = stats.miss_count_;
+    return Result::kSuccess;
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceSetLatencyMarkers(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    mrsBool enabled) noexcept {
+  if (auto track = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    track->SetLatencyMarkers(enabled != mrsBool::kFalse);
+    return Result::kSuccess;
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceSyncCaptureClock(
+    mrsExternalVideoTrackSourceHandle source_handle,
+    int64_t app_time_us) noexcept {
+  if (auto track = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+    track->SyncCaptureClock(app_time_us);
+    return mrsResult::kSuccess;
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsI420AVideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopyWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept {
+  if (!frame_view || !release_callback) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequestNoCopy(request_id, 0, *frame_view,
+                                        {release_callback, release_user_data},
+                                        capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsArgb32VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNv12FrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsNv12VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNativeFrameRequestWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t capture_time_us,
+    const mrsNativeVideoFrame* frame) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushI420AFrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    int64_t capture_time_us) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    int64_t capture_time_us) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNv12FrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    int64_t capture_time_us) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNativeFrameWithCaptureTime(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    int64_t capture_time_us) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame, 0, capture_time_us);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsI420AVideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us,
+                                  std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopyWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsI420AVideoFrame* frame_view,
+    mrsExternalVideoFrameReleaseCallback release_callback,
+    void* release_user_data) noexcept {
+  if (!frame_view || !release_callback) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequestNoCopy(
+        request_id, 0, *frame_view, {release_callback, release_user_data},
+        capture_time_us, std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsArgb32VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us,
+                                  std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNv12FrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsNv12VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame_view, capture_time_us,
+                                  std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsExternalVideoTrackSourceCompleteNativeFrameRequestWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    const mrsExternalVideoFrameInfo* info,
+    const mrsNativeVideoFrame* frame) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->CompleteRequest(request_id, 0, *frame, capture_time_us,
+                                  std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushI420AFrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsI420AVideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us,
+                            std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushArgb32FrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsArgb32VideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us,
+                            std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNv12FrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNv12VideoFrame* frame_view,
+    const mrsExternalVideoFrameInfo* info) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame_view, 0, capture_time_us,
+                            std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourcePushNativeFrameWithInfo(
+    mrsExternalVideoTrackSourceHandle handle,
+    const mrsNativeVideoFrame* frame,
+    const mrsExternalVideoFrameInfo* info) noexcept {
+  if (!frame || (frame->width == 0) || (frame->height == 0)) {
+    return Result::kInvalidParameter;
+  }
+  absl::optional<int64_t> capture_time_us;
+  FrameMetadata metadata;
+  const Result result = ReadFrameInfo(info, capture_time_us, metadata);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+    return track->PushFrame(*frame, 0, capture_time_us, std::move(metadata));
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
 void MRS_CALL mrsExternalVideoTrackSourceShutdown(
     mrsExternalVideoTrackSourceHandle handle) noexcept {
   if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
@@ -193,6 +767,27 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromArgb32(
   return track_source;
 }
 
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateForPush(
+    RefPtr<GlobalFactory> global_factory) {
+  // Tracks need to be created from the worker thread
+  rtc::Thread* const worker_thread = global_factory->GetWorkerThread();
+  return worker_thread->Invoke<RefPtr<ExternalVideoTrackSource>>(
+      RTC_FROM_HERE, rtc::Bind(&ExternalVideoTrackSource::createForPush,
+                               std::move(global_factory)));
+}
+
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateSynthetic(
+    RefPtr<GlobalFactory> global_factory,
+    const mrsSyntheticVideoSourceConfig& config) {
+  // Tracks need to be created from the worker thread
+  rtc::Thread* const worker_thread = global_factory->GetWorkerThread();
+  return worker_thread->Invoke<RefPtr<ExternalVideoTrackSource>>(
+      RTC_FROM_HERE, [&global_factory, &config]() {
+        return ExternalVideoTrackSource::createSynthetic(
+            std::move(global_factory), config);
+      });
+}
+
 }  // namespace detail
 }  // namespace WebRTC
 }  // namespace MixedReality
@@ -10,9 +10,127 @@
 #include "peer_connection.h"
 #include "rtc_base/refcountedobject.h"
 #include "utils.h"
-
+#include "tracing.h"
+#include "decoder_thread_budget.h"
+#include "encoded_frame_relay.h"
+#include "encoded_frame_tap.h"
+#include "frame_metadata.h"
+#include "video_codec_factory.h"
+
+#include <algorithm>
 #include <exception>
 
+#if defined(MR_SHARING_ANDROID)
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif  // defined(MR_SHARING_ANDROID)
+
+namespace {
+
+#if !defined(WINUWP)
+
+/// Apply the options of a WebRTC thread to the calling thread. Failures are
+/// logged, leaving the thread running with its default options.
+void ApplyThreadOptions(const mrsThreadOptions& options,
+                        const char* thread_name) {
+#if defined(MR_SHARING_WIN)
+  if (options.priority != mrsThreadPriority::kDefault) {
+    static const int kPriorities[] = {
+        THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL,
+        THREAD_PRIORITY_HIGHEST};
+    if (!::SetThreadPriority(::GetCurrentThread(),
+                             kPriorities[(int)options.priority])) {
+      RTC_LOG(LS_WARNING) << "Failed to set the priority of the "
+                          << thread_name << ": error #" << ::GetLastError();
+    }
+  }
+  if (options.affinity_mask != 0) {
+    if (!::SetThreadAffinityMask(::GetCurrentThread(),
+                                 (DWORD_PTR)options.affinity_mask)) {
+      RTC_LOG(LS_WARNING) << "Failed to set the affinity of the "
+                          << thread_name << ": error #" << ::GetLastError();
+    }
+  }
+#elif defined(MR_SHARING_ANDROID)
+  if (options.priority != mrsThreadPriority::kDefault) {
+    // Nice values, similar to the Android thread priorities.
+    static const int kPriorities[] = {0, 10, 0, -4, -8};
+    if (setpriority(PRIO_PROCESS, gettid(),
+                    kPriorities[(int)options.priority]) != 0) {
+      RTC_LOG(LS_WARNING) << "Failed to set the priority of the "
+                          << thread_name << ": error #" << errno;
+    }
+  }
+  if (options.affinity_mask != 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64; ++cpu) {
+      if ((options.affinity_mask & (1ull << cpu)) != 0) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      RTC_LOG(LS_WARNING) << "Failed to set the affinity of the "
+                          << thread_name << ": error #" << errno;
+    }
+  }
+#endif
+}
+
+/// Create and start a WebRTC thread with the given options.
+std::unique_ptr<rtc::Thread> StartThread(std::unique_ptr<rtc::Thread> thread,
+                                         const std::string& name,
+                                         const mrsThreadOptions& options) {
+  RTC_CHECK(thread.get());
+  thread->SetName(name, thread.get());
+  thread->Start();
+  if ((options.priority != mrsThreadPriority::kDefault) ||
+      (options.affinity_mask != 0)) {
+    thread->Invoke<void>(RTC_FROM_HERE, [&options, &name]() {
+      ApplyThreadOptions(options, name.c_str());
+    });
+  }
+  return thread;
+}
+
+/// Check that the options of a WebRTC thread are valid.
+bool IsValid(const mrsThreadOptions& options) {
+  return (options.priority >= mrsThreadPriority::kDefault) &&
+         (options.priority <= mrsThreadPriority::kHighest);
+}
+
+webrtc::AudioDeviceModule::AudioLayer ToAudioLayer(
+    const mrsAudioDeviceModuleConfig& config) {
+  using AudioLayer = webrtc::AudioDeviceModule::AudioLayer;
+  switch (config.audio_layer) {
+    default:
+    case mrsAudioDeviceLayer::kPlatformDefault:
+      return AudioLayer::kPlatformDefaultAudio;
+    case mrsAudioDeviceLayer::kWindowsCoreAudio:
+      return AudioLayer::kWindowsCoreAudio;
+    case mrsAudioDeviceLayer::kWindowsCoreAudio2:
+      return AudioLayer::kWindowsCoreAudio2;
+    case mrsAudioDeviceLayer::kAndroidJava:
+      return AudioLayer::kAndroidJavaAudio;
+    case mrsAudioDeviceLayer::kAndroidOpenSLES:
+      return AudioLayer::kAndroidOpenSLESAudio;
+    case mrsAudioDeviceLayer::kAndroidJavaInputAndOpenSLESOutput:
+      return AudioLayer::kAndroidJavaInputAndOpenSLESOutputAudio;
+    case mrsAudioDeviceLayer::kAndroidAAudio:
+      return AudioLayer::kAndroidAAudioAudio;
+    case mrsAudioDeviceLayer::kAndroidJavaInputAndAAudioOutput:
+      return AudioLayer::kAndroidJavaInputAndAAudioOutputAudio;
+    case mrsAudioDeviceLayer::kDummy:
+      return AudioLayer::kDummyAudio;
+  }
+}
+
+#endif  // !defined(WINUWP)
+
+}  // namespace
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -27,6 +145,27 @@ uint32_t GlobalFactory::StaticReportLiveObjects() noexcept {
   return 0;
 }
 
+void GlobalFactory::GetLiveObjectCounts(
+    LiveObjectCount (&counts)[kObjectTypeCount]) noexcept {
+  // The object collections outlive any initialization, so do not initialize
+  // the library only to read them.
+  GlobalFactory* const factory = GetInstance();
+  for (int i = 0; i < kObjectTypeCount; ++i) {
+    ObjectShard& shard = factory->alive_objects_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    counts[i].current_ = static_cast<uint32_t>(shard.objects.size());
+    counts[i].peak_ = static_cast<uint32_t>(shard.peak_count);
+  }
+}
+
+void GlobalFactory::ResetLiveObjectPeaks() noexcept {
+  GlobalFactory* const factory = GetInstance();
+  for (ObjectShard& shard : factory->alive_objects_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.peak_count = shard.objects.size();
+  }
+}
+
 mrsShutdownOptions GlobalFactory::GetShutdownOptions() noexcept {
   GlobalFactory* const factory = GetInstance();
   std::lock_guard<std::recursive_mutex> lock(factory->mutex_);
@@ -42,6 +181,158 @@ void GlobalFactory::SetShutdownOptions(mrsShutdownOptions options) noexcept {
   factory->shutdown_options_ = options;
 }
 
+Result GlobalFactory::SetVideoCodecFactories(
+    VideoCodecFactoryCallback encoder_factory_callback,
+    VideoCodecFactoryCallback decoder_factory_callback) noexcept {
+#if defined(WINUWP)
+  (void)encoder_factory_callback;
+  (void)decoder_factory_callback;
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the video codec factories while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->video_encoder_factory_callback_ = encoder_factory_callback;
+  factory->video_decoder_factory_callback_ = decoder_factory_callback;
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetThreadGroups(
+    std::vector<mrsThreadGroupConfig> groups) noexcept {
+#if defined(WINUWP)
+  (void)groups;
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  for (const mrsThreadGroupConfig& group : groups) {
+    if (!IsValid(group.network_thread) || !IsValid(group.worker_thread) ||
+        !IsValid(group.signaling_thread)) {
+      return Result::kInvalidParameter;
+    }
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the thread groups while the library "
+                         "is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->thread_group_configs_ = std::move(groups);
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig& config) noexcept {
+#if defined(WINUWP)
+  (void)config;
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  if ((config.audio_layer < mrsAudioDeviceLayer::kPlatformDefault) ||
+      (config.audio_layer > mrsAudioDeviceLayer::kDummy)) {
+    return Result::kInvalidParameter;
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the audio device module configuration "
+                         "while the library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->audio_device_module_config_ = config;
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetVideoDecoderThreadingConfig(
+    const mrsVideoDecoderThreadingConfig& config) noexcept {
+#if defined(WINUWP)
+  (void)config;
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  constexpr uint32_t kMaxThreadsPerDecoder = 64;
+  if (config.max_threads_per_decoder > kMaxThreadsPerDecoder) {
+    return Result::kInvalidParameter;
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the video decoder threading while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->video_decoder_threading_config_ = config;
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetCertificatePoolConfig(
+    const mrsCertificatePoolConfig& config) noexcept {
+  constexpr uint32_t kMaxPoolSize = 64;
+  if ((config.pool_size > kMaxPoolSize) ||
+      ((config.key_type != mrsCertificateKeyType::kEcdsa) &&
+       (config.key_type != mrsCertificateKeyType::kRsa))) {
+    return Result::kInvalidParameter;
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the certificate pool configuration "
+                         "while the library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->certificate_pool_config_ = config;
+  return Result::kSuccess;
+}
+
+Result GlobalFactory::SetVp9Layers(
+    absl::optional<ScalabilityMode> layers) noexcept {
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the VP9 scalability mode while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->vp9_layers_ = layers;
+  return Result::kSuccess;
+}
+
+Result GlobalFactory::InitializeAsync(InitializedCallback callback) noexcept {
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->async_init_mutex_);
+  try {
+    // Wait for any previous initialization, which usually completed already.
+    if (factory->async_init_thread_.joinable()) {
+      factory->async_init_thread_.join();
+    }
+    factory->async_init_thread_ = std::thread([factory, callback]() {
+      mrsResult result;
+      {
+        std::lock_guard<std::mutex> init_lock(factory->init_mutex_);
+        result = factory->InitializeImplNoLock();
+        if ((result == Result::kSuccess) &&
+            !factory->holds_initial_ref_.exchange(true)) {
+          factory->AddRef();
+        }
+      }
+      if (result != Result::kSuccess) {
+        RTC_LOG(LS_ERROR) << "Failed to initialize global MixedReality-WebRTC "
+                             "factory: error code #"
+                          << (int)result;
+      }
+      callback(result);
+    });
+  } catch (...) {
+    return Result::kUnknownError;
+  }
+  return Result::kSuccess;
+}
+
 void GlobalFactory::ForceShutdown() noexcept {
   GlobalFactory* const factory = GetInstance();
   std::lock_guard<std::mutex> lock(factory->init_mutex_);
@@ -107,6 +398,12 @@ RefPtr<GlobalFactory> GlobalFactory::GetInstancePtrImpl(
 }
 
 GlobalFactory::~GlobalFactory() {
+  {
+    std::lock_guard<std::mutex> lock(async_init_mutex_);
+    if (async_init_thread_.joinable()) {
+      async_init_thread_.join();
+    }
+  }
   std::lock_guard<std::mutex> lock(init_mutex_);
   ShutdownImplNoLock(ShutdownAction::kFromObjectDestructor);
 }
@@ -118,51 +415,116 @@ GlobalFactory::GetPeerConnectionFactory() noexcept {
   return peer_factory_;
 }
 
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+GlobalFactory::GetPeerConnectionFactory(uint32_t thread_group) noexcept {
+#if defined(WINUWP)
+  return (thread_group == 0 ? peer_factory_ : nullptr);
+#else   // defined(WINUWP)
+  return (thread_group < thread_groups_.size()
+              ? thread_groups_[thread_group].peer_factory
+              : nullptr);
+#endif  // defined(WINUWP)
+}
+
 rtc::Thread* GlobalFactory::GetWorkerThread() const noexcept {
   // This only requires init_mutex_ read lock, which must be acquired to access
   // the singleton instance.
 #if defined(WINUWP)
   return impl_ ? impl_->workerThread.get() : nullptr;
 #else   // defined(WINUWP)
-  return worker_thread_.get();
+  return thread_groups_.empty() ? nullptr
+                                : thread_groups_[0].worker_thread.get();
 #endif  // defined(WINUWP)
 }
 
+rtc::Thread* GlobalFactory::GetCaptureSchedulerThread() const noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+  return capture_scheduler_thread_.get();
+}
+
+CertificatePool* GlobalFactory::GetCertificatePool() const noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+  return certificate_pool_.get();
+}
+
+ScalabilityMode GlobalFactory::GetVp9Layers() const noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+  return vp9_layers_.value_or(ScalabilityMode{});
+}
+
 rtc::Thread* GlobalFactory::GetSignalingThread() const noexcept {
   // This only requires init_mutex_ read lock, which must be acquired to access
   // the singleton instance.
+  return GetSignalingThread(0);
+}
+
+rtc::Thread* GlobalFactory::GetSignalingThread(
+    uint32_t thread_group) const noexcept {
+#if defined(WINUWP)
+  return (impl_ && (thread_group == 0)) ? impl_->signalingThread.get()
+                                        : nullptr;
+#else   // defined(WINUWP)
+  return (thread_group < thread_groups_.size()
+              ? thread_groups_[thread_group].signaling_thread.get()
+              : nullptr);
+#endif  // defined(WINUWP)
+}
+
+rtc::Thread* GlobalFactory::GetNetworkThread(
+    uint32_t thread_group) const noexcept {
 #if defined(WINUWP)
-  return impl_ ? impl_->signalingThread.get() : nullptr;
+  (void)thread_group;
+  return nullptr;
 #else   // defined(WINUWP)
-  return signaling_thread_.get();
+  return (thread_group < thread_groups_.size()
+              ? thread_groups_[thread_group].network_thread.get()
+              : nullptr);
+#endif  // defined(WINUWP)
+}
+
+rtc::scoped_refptr<ToggleAudioMixer> GlobalFactory::audio_mixer(
+    uint32_t thread_group) const {
+#if defined(WINUWP)
+  return (thread_group == 0 ? custom_audio_mixer_ : nullptr);
+#else   // defined(WINUWP)
+  return (thread_group < thread_groups_.size()
+              ? thread_groups_[thread_group].audio_mixer
+              : nullptr);
 #endif  // defined(WINUWP)
 }
 
 void GlobalFactory::AddObject(TrackedObject* obj) noexcept {
   try {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    RTC_DCHECK(std::find(alive_objects_.begin(), alive_objects_.end(), obj) ==
-               alive_objects_.end());
-    alive_objects_.push_back(obj);
+    ObjectShard& shard = alive_objects_[(int)obj->GetObjectType()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const bool inserted = shard.objects.insert(obj).second;
+    RTC_DCHECK(inserted);
+    (void)inserted;
+    shard.peak_count = std::max(shard.peak_count, shard.objects.size());
   } catch (...) {
   }
+  // Hand over the reference held since |InitializeAsync()| to the object. This
+  // cannot be the last reference, since the object holds its own.
+  if (holds_initial_ref_.load(std::memory_order_relaxed) &&
+      holds_initial_ref_.exchange(false)) {
+    RemoveRef();
+  }
 }
 
 void GlobalFactory::RemoveObject(TrackedObject* obj) noexcept {
   try {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    auto it = std::find(alive_objects_.begin(), alive_objects_.end(), obj);
-    if (it != alive_objects_.end()) {
-      alive_objects_.erase(it);
-    }
+    ObjectShard& shard = alive_objects_[(int)obj->GetObjectType()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.objects.erase(obj);
   } catch (...) {
   }
 }
 
 uint32_t GlobalFactory::ReportLiveObjects() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  ReportLiveObjectsNoLock();
-  return static_cast<uint32_t>(alive_objects_.size());
+  return ReportLiveObjectsNoLock();
 }
 
 #if defined(WINUWP)
@@ -200,6 +562,13 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
     return Result::kSuccess;
   }
 
+  tracing::RegisterProvider();
+
+  // Configure the VP9 encoders before creating any, as the encoder threads
+  // read the field trials without synchronization.
+  const ScalabilityMode vp9_layers = GetVp9Layers();
+  ApplyVp9Layers(vp9_layers.spatial_layers, vp9_layers.temporal_layers);
+
 #if defined(WINUWP)
   RTC_CHECK(!impl_);
   auto mw = winrt::Windows::ApplicationModel::Core::CoreApplication::MainView();
@@ -239,37 +608,121 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
   // Cache the peer connection factory
   peer_factory_ = impl_->peerConnectionFactory();
 #else  // defined(WINUWP)
-  custom_audio_mixer_ = new rtc::RefCountedObject<ToggleAudioMixer>();
-  network_thread_ = rtc::Thread::CreateWithSocketServer();
-  RTC_CHECK(network_thread_.get());
-  network_thread_->SetName("WebRTC network thread", network_thread_.get());
-  network_thread_->Start();
-  worker_thread_ = rtc::Thread::Create();
-  RTC_CHECK(worker_thread_.get());
-  worker_thread_->SetName("WebRTC worker thread", worker_thread_.get());
-  worker_thread_->Start();
-  signaling_thread_ = rtc::Thread::Create();
-  RTC_CHECK(signaling_thread_.get());
-  signaling_thread_->SetName("WebRTC signaling thread",
-                             signaling_thread_.get());
-  signaling_thread_->Start();
-
-  peer_factory_ = webrtc::CreatePeerConnectionFactory(
-      network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
-      nullptr, webrtc::CreateBuiltinAudioEncoderFactory(),
-      webrtc::CreateBuiltinAudioDecoderFactory(),
-      std::unique_ptr<webrtc::VideoEncoderFactory>(
-          new webrtc::MultiplexEncoderFactory(
-              absl::make_unique<webrtc::InternalEncoderFactory>())),
-      std::unique_ptr<webrtc::VideoDecoderFactory>(
-          new webrtc::MultiplexDecoderFactory(
-              absl::make_unique<webrtc::InternalDecoderFactory>())),
-      custom_audio_mixer_, nullptr);
+  // Tap the encoded frames of the receive streams of all thread groups, and
+  // share the decoding threads between them.
+  encoded_frame_taps_ = std::make_shared<EncodedFrameTapRegistry>();
+  decoder_thread_budget_ =
+      std::make_shared<DecoderThreadBudget>(video_decoder_threading_config_);
+  std::vector<mrsThreadGroupConfig> configs = thread_group_configs_;
+  if (configs.empty()) {
+    configs.emplace_back();
+  }
+  thread_groups_.resize(configs.size());
+  for (uint32_t i = 0; i < configs.size(); ++i) {
+    if (!CreateThreadGroupNoLock(configs[i], i, thread_groups_[i])) {
+      thread_groups_.clear();
+      encoded_frame_taps_ = nullptr;
+      decoder_thread_budget_ = nullptr;
+      return Result::kUnknownError;
+    }
+  }
+  custom_audio_mixer_ = thread_groups_[0].audio_mixer;
+  peer_factory_ = thread_groups_[0].peer_factory;
 #endif  // defined(WINUWP)
-  return (peer_factory_.get() != nullptr ? Result::kSuccess
-                                         : Result::kUnknownError);
+  if (!peer_factory_) {
+    return Result::kUnknownError;
+  }
+  capture_scheduler_thread_ = rtc::Thread::Create();
+  RTC_CHECK(capture_scheduler_thread_.get());
+  capture_scheduler_thread_->SetName("External video capture scheduler thread",
+                                     capture_scheduler_thread_.get());
+  capture_scheduler_thread_->Start();
+  certificate_pool_ =
+      absl::make_unique<CertificatePool>(certificate_pool_config_);
+  return Result::kSuccess;
+}
+
+#if !defined(WINUWP)
+
+bool GlobalFactory::CreateThreadGroupNoLock(const mrsThreadGroupConfig& config,
+                                            uint32_t index,
+                                            ThreadGroup& group) {
+  // Keep the original names for the first group.
+  const std::string suffix =
+      (index > 0 ? " #" + std::to_string(index) : std::string());
+  group.audio_mixer = new rtc::RefCountedObject<ToggleAudioMixer>();
+  group.network_thread =
+      StartThread(rtc::Thread::CreateWithSocketServer(),
+                  "WebRTC network thread" + suffix, config.network_thread);
+  group.worker_thread =
+      StartThread(rtc::Thread::Create(), "WebRTC worker thread" + suffix,
+                  config.worker_thread);
+  group.signaling_thread =
+      StartThread(rtc::Thread::Create(), "WebRTC signaling thread" + suffix,
+                  config.signaling_thread);
+
+  // Prefer the codecs of the custom factories if any, falling back to the
+  // built-in software codecs.
+  std::unique_ptr<webrtc::VideoEncoderFactory> encoder_factory;
+  if (auto custom = static_cast<webrtc::VideoEncoderFactory*>(
+          video_encoder_factory_callback_())) {
+    encoder_factory = absl::make_unique<FallbackVideoEncoderFactory>(
+        std::unique_ptr<webrtc::VideoEncoderFactory>(custom));
+  } else {
+    encoder_factory = absl::make_unique<webrtc::InternalEncoderFactory>();
+  }
+  std::unique_ptr<webrtc::VideoDecoderFactory> decoder_factory;
+  if (auto custom = static_cast<webrtc::VideoDecoderFactory*>(
+          video_decoder_factory_callback_())) {
+    decoder_factory = absl::make_unique<FallbackVideoDecoderFactory>(
+        std::unique_ptr<webrtc::VideoDecoderFactory>(custom));
+  } else {
+    decoder_factory = absl::make_unique<webrtc::InternalDecoderFactory>();
+  }
+  // Relay the encoded frames of the relay sources on all send streams, and
+  // tap the encoded frames of all receive streams, which also allocates the
+  // decoding threads of each stream. The tap must wrap the other decoder
+  // factories, which do not forward the receive stream ID. The frame metadata
+  // is appended to the encoded frames by the outermost encoder, and removed by
+  // the tap before decoding.
+  encoder_factory = absl::make_unique<FrameMetadataEncoderFactory>(
+      absl::make_unique<RelayVideoEncoderFactory>(
+          std::unique_ptr<webrtc::VideoEncoderFactory>(
+              new webrtc::MultiplexEncoderFactory(
+                  std::move(encoder_factory)))));
+  decoder_factory = absl::make_unique<EncodedFrameTapDecoderFactory>(
+      std::unique_ptr<webrtc::VideoDecoderFactory>(
+          new webrtc::MultiplexDecoderFactory(std::move(decoder_factory))),
+      encoded_frame_taps_, decoder_thread_budget_);
+  // Let the factory create the default audio device module, unless another
+  // audio layer was selected. The module must be created on the worker thread.
+  rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module;
+  if (audio_device_module_config_.audio_layer !=
+      mrsAudioDeviceLayer::kPlatformDefault) {
+    const auto audio_layer = ToAudioLayer(audio_device_module_config_);
+    audio_device_module = group.worker_thread->Invoke<
+        rtc::scoped_refptr<webrtc::AudioDeviceModule>>(
+        RTC_FROM_HERE, [audio_layer]() {
+          return webrtc::AudioDeviceModule::Create(audio_layer);
+        });
+    if (!audio_device_module) {
+      RTC_LOG(LS_ERROR) << "Failed to create the audio device module for "
+                           "audio layer #"
+                        << (int)audio_device_module_config_.audio_layer;
+      return false;
+    }
+  }
+  group.peer_factory = webrtc::CreatePeerConnectionFactory(
+      group.network_thread.get(), group.worker_thread.get(),
+      group.signaling_thread.get(), std::move(audio_device_module),
+      webrtc::CreateBuiltinAudioEncoderFactory(),
+      webrtc::CreateBuiltinAudioDecoderFactory(), std::move(encoder_factory),
+      std::move(decoder_factory), group.audio_mixer, nullptr);
+  return (group.peer_factory != nullptr);
 }
 
+#endif  // !defined(WINUWP)
+
 bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
   if (!peer_factory_) {
     return true;  // already shut down
@@ -277,6 +730,13 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
 
   custom_audio_mixer_ = nullptr;
 
+  // The reference held since |InitializeAsync()| does not prevent forcing the
+  // shutdown.
+  if ((shutdown_action != ShutdownAction::kTryShutdownIfSafe) &&
+      holds_initial_ref_.exchange(false)) {
+    ref_count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
   // This is read under the init mutex lock so can be relaxed, as it cannot
   // decrease during that time. However we should test the value before it's
   // cleared below, so use acquire semantic.
@@ -305,31 +765,43 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
 
     // Clear debug infos and references. This leaks objects, but at least won't
     // interact with future uses.
-    alive_objects_.clear();
+    for (ObjectShard& shard : alive_objects_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.objects.clear();
+    }
     ref_count_.store(0, std::memory_order_release);  // see "load acquire" above
   }
 
   // Shutdown
+  certificate_pool_.reset();
+  capture_scheduler_thread_.reset();
   peer_factory_ = nullptr;
+  encoded_frame_taps_ = nullptr;
 #if defined(WINUWP)
   impl_ = nullptr;
 #else   // defined(WINUWP)
-  network_thread_.reset();
-  worker_thread_.reset();
-  signaling_thread_.reset();
+  thread_groups_.clear();
+  decoder_thread_budget_ = nullptr;
 #endif  // defined(WINUWP)
   return true;
 }
 
-void GlobalFactory::ReportLiveObjectsNoLock() {
-  RTC_LOG(LS_INFO) << "mr-webrtc alive objects report for "
-                   << alive_objects_.size() << " objects:";
-  int i = 0;
-  for (auto&& obj : alive_objects_) {
-    RTC_LOG(LS_INFO) << "[" << i << "] " << ObjectToString(obj) << " [~"
-                     << obj->GetApproxRefCount() << " ref(s)]";
-    ++i;
+uint32_t GlobalFactory::ReportLiveObjectsNoLock() {
+  // Objects may be added or removed concurrently to the other shards, so the
+  // count is only known once all shards are reported.
+  RTC_LOG(LS_INFO) << "mr-webrtc alive objects report:";
+  uint32_t i = 0;
+  for (ObjectShard& shard : alive_objects_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (TrackedObject* obj : shard.objects) {
+      RTC_LOG(LS_INFO) << "[" << i << "] " << ObjectToString(obj) << " [~"
+                       << obj->GetApproxRefCount() << " ref(s)]";
+      ++i;
+    }
   }
+  RTC_LOG(LS_INFO) << "mr-webrtc alive objects report for " << i
+                   << " objects.";
+  return i;
 }
 
 }  // namespace WebRTC
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <thread>
+
+#include "certificate_pool.h"
 #include "export.h"
 #include "peer_connection.h"
 #include "utils.h"
@@ -11,6 +14,9 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class DecoderThreadBudget;
+class EncodedFrameTapRegistry;
+
 /// The global factory is a helper class used to initialize and shutdown the
 /// internal WebRTC library, which adds extra functionalities over a classical
 /// init/shutdown pair of functions:
@@ -30,6 +36,26 @@ class GlobalFactory {
   /// returns 0. This is multithread-safe.
   static uint32_t StaticReportLiveObjects() noexcept;
 
+  /// Number of tracked objects alive of a given type.
+  struct LiveObjectCount {
+    /// Number of objects currently alive.
+    uint32_t current_ = 0;
+
+    /// Maximum number of objects simultaneously alive since the last call to
+    /// |ResetLiveObjectPeaks()|, or since the process started.
+    uint32_t peak_ = 0;
+  };
+
+  /// Get the number of tracked objects alive for each object type. Unlike
+  /// |StaticReportLiveObjects()| this does not enumerate the objects, and does
+  /// not require the library to be initialized. This is multithread-safe.
+  static void GetLiveObjectCounts(
+      LiveObjectCount (&counts)[kObjectTypeCount]) noexcept;
+
+  /// Reset the peak number of objects alive of each type to its current
+  /// number. This is multithread-safe.
+  static void ResetLiveObjectPeaks() noexcept;
+
   /// Get the library shutdown options. This function does not initialize the
   /// library, but will store the options for a future initializing. Conversely,
   /// if the library is already initialized then the options are set
@@ -42,6 +68,60 @@ class GlobalFactory {
   /// immediately. This is multithread-safe.
   static void SetShutdownOptions(mrsShutdownOptions options) noexcept;
 
+  /// Callback creating a custom video codec factory, returning ownership of a
+  /// new |webrtc::VideoEncoderFactory| or |webrtc::VideoDecoderFactory|.
+  using VideoCodecFactoryCallback = RetCallback<void*>;
+
+  /// Set the callbacks creating the custom video encoder and decoder factories
+  /// when the library initializes. This fails if the library is already
+  /// initialized. This is multithread-safe.
+  static Result SetVideoCodecFactories(
+      VideoCodecFactoryCallback encoder_factory_callback,
+      VideoCodecFactoryCallback decoder_factory_callback) noexcept;
+
+  /// Set the configuration of the groups of WebRTC threads created when the
+  /// library initializes, or an empty collection for a single group with the
+  /// default options. This fails if the library is already initialized. This
+  /// is multithread-safe.
+  static Result SetThreadGroups(
+      std::vector<mrsThreadGroupConfig> groups) noexcept;
+
+  /// Set the configuration of the audio device module created by each thread
+  /// group when the library initializes. This fails if the library is already
+  /// initialized. This is multithread-safe.
+  static Result SetAudioDeviceModuleConfig(
+      const mrsAudioDeviceModuleConfig& config) noexcept;
+
+  /// Set the configuration of the pool of DTLS certificates created when the
+  /// library initializes. This fails if the library is already initialized.
+  /// This is multithread-safe.
+  static Result SetCertificatePoolConfig(
+      const mrsCertificatePoolConfig& config) noexcept;
+
+  /// Set the threading of the video decoders created when the library
+  /// initializes. This fails if the library is already initialized. This is
+  /// multithread-safe.
+  static Result SetVideoDecoderThreadingConfig(
+      const mrsVideoDecoderThreadingConfig& config) noexcept;
+
+  /// Set the layers of all the VP9 encoders of the process, applied when the
+  /// library initializes, or |absl::nullopt| for the default single layer.
+  /// This fails if the library is already initialized. This is
+  /// multithread-safe.
+  static Result SetVp9Layers(absl::optional<ScalabilityMode> layers) noexcept;
+
+  /// Callback fired once the library initialized, with the result of the
+  /// initialization.
+  using InitializedCallback = Callback<mrsResult>;
+
+  /// Start initializing the library on a background thread, and invoke the
+  /// callback on that thread once done. The library holds a reference to
+  /// itself once initialized, which is handed over to the first tracked object
+  /// added, so that it stays initialized until that object and all others are
+  /// destroyed. This is multithread-safe, but must not be called from the
+  /// callback.
+  static Result InitializeAsync(InitializedCallback callback) noexcept;
+
   /// Force-shutdown the library if it is initialized, or does nothing
   /// otherwise. This call will terminate the WebRTC threads, therefore will
   /// prevent any dispatched call to a WebRTC object from completing. However,
@@ -106,6 +186,11 @@ class GlobalFactory {
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
   GetPeerConnectionFactory() noexcept;
 
+  /// Get the peer connection factory of the given thread group, or NULL if the
+  /// library is not initialized or the group does not exist.
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+  GetPeerConnectionFactory(uint32_t thread_group) noexcept;
+
   /// Get the WebRTC background worker thread, or NULL if the library is not
   /// initialized.
   rtc::Thread* GetWorkerThread() const noexcept;
@@ -114,6 +199,27 @@ class GlobalFactory {
   /// initialized.
   rtc::Thread* GetSignalingThread() const noexcept;
 
+  /// Get the WebRTC signaling thread of the given thread group, or NULL if the
+  /// library is not initialized or the group does not exist.
+  rtc::Thread* GetSignalingThread(uint32_t thread_group) const noexcept;
+
+  /// Get the WebRTC network thread of the given thread group, or NULL if the
+  /// library is not initialized, the group does not exist, or the platform
+  /// does not expose its network thread.
+  rtc::Thread* GetNetworkThread(uint32_t thread_group) const noexcept;
+
+  /// Get the thread shared by all external video track sources to schedule
+  /// their frame requests, or NULL if the library is not initialized.
+  rtc::Thread* GetCaptureSchedulerThread() const noexcept;
+
+  /// Get the pool of DTLS certificates handed to the new peer connections, or
+  /// NULL if the library is not initialized.
+  CertificatePool* GetCertificatePool() const noexcept;
+
+  /// Get the layers of all the VP9 encoders, set with |SetVp9Layers()|. The
+  /// scalability mode of an encoding cannot differ from it.
+  ScalabilityMode GetVp9Layers() const noexcept;
+
   /// Add to the global factory collection a tracked object whose lifetime is
   /// monitored (via the library reference count) to know when it is safe to
   /// shutdown the library and terminate the WebRTC threads. This is generally
@@ -142,6 +248,17 @@ class GlobalFactory {
     return custom_audio_mixer_;
   }
 
+  /// Get the audio mixer of the given thread group, or NULL if the group does
+  /// not exist.
+  rtc::scoped_refptr<ToggleAudioMixer> audio_mixer(
+      uint32_t thread_group) const;
+
+  /// Get the taps of the encoded frames of the remote video tracks, or NULL if
+  /// not supported on the current platform.
+  std::shared_ptr<EncodedFrameTapRegistry> encoded_frame_taps() const {
+    return encoded_frame_taps_;
+  }
+
  private:
   friend struct std::default_delete<GlobalFactory>;
 
@@ -160,6 +277,23 @@ class GlobalFactory {
 
   mrsResult InitializeImplNoLock();
 
+#if !defined(WINUWP)
+  /// Set of WebRTC threads with the peer connection factory using them.
+  struct ThreadGroup {
+    std::unique_ptr<rtc::Thread> network_thread;
+    std::unique_ptr<rtc::Thread> worker_thread;
+    std::unique_ptr<rtc::Thread> signaling_thread;
+    rtc::scoped_refptr<ToggleAudioMixer> audio_mixer;
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> peer_factory;
+  };
+
+  /// Start the threads of a new thread group and create its peer connection
+  /// factory, or return |false| if the factory cannot be created.
+  bool CreateThreadGroupNoLock(const mrsThreadGroupConfig& config,
+                               uint32_t index,
+                               ThreadGroup& group);
+#endif  // !defined(WINUWP)
+
   enum class ShutdownAction {
     /// Try to safely shutdown, only if no tracked object is alive.
     kTryShutdownIfSafe,
@@ -176,7 +310,9 @@ class GlobalFactory {
   /// down.
   bool ShutdownImplNoLock(ShutdownAction shutdown_action);
 
-  void ReportLiveObjectsNoLock();
+  /// Report live objects, and return their number. This does not require
+  /// |mutex_|, but locks each object shard in turn.
+  uint32_t ReportLiveObjectsNoLock();
 
  private:
   /// Mutex for multithread-safe factory initializing and shutdown.
@@ -198,22 +334,59 @@ class GlobalFactory {
 
 #else  // defined(WINUWP)
 
-  /// WebRTC networking thread. This is initialized only while the library
-  /// is initialized, and is immutable between init and shutdown, so do not
+  /// WebRTC networking, worker, and signaling threads, grouped with the peer
+  /// connection factory using them. The first group owns |peer_factory_| and
+  /// |custom_audio_mixer_|. This is initialized only while the library is
+  /// initialized, and is immutable between init and shutdown, so do not
   /// require |mutex_| for access, but |init_mutex_| instead.
-  std::unique_ptr<rtc::Thread> network_thread_ RTC_GUARDED_BY(init_mutex_);
+  std::vector<ThreadGroup> thread_groups_ RTC_GUARDED_BY(init_mutex_);
 
-  /// WebRTC background worker thread. This is initialized only while the
-  /// library is initialized, and is immutable between init and shutdown, so do
-  /// not require |mutex_| for access, but |init_mutex_| instead.
-  std::unique_ptr<rtc::Thread> worker_thread_ RTC_GUARDED_BY(init_mutex_);
+  /// Configuration of the thread groups created on initialization, or empty
+  /// for a single group with the default options. This can only change while
+  /// the library is not initialized.
+  std::vector<mrsThreadGroupConfig> thread_group_configs_
+      RTC_GUARDED_BY(init_mutex_);
 
-  /// WebRTC signaling thread. This is initialized only while the library
+  /// Configuration of the audio device modules created on initialization.
+  /// This can only change while the library is not initialized.
+  mrsAudioDeviceModuleConfig audio_device_module_config_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Configuration of the threading of the video decoders created on
+  /// initialization. This can only change while the library is not
+  /// initialized.
+  mrsVideoDecoderThreadingConfig video_decoder_threading_config_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Decoding threads shared by the video decoders of all thread groups. This
+  /// is initialized only while the library is initialized.
+  std::shared_ptr<DecoderThreadBudget> decoder_thread_budget_
+      RTC_GUARDED_BY(init_mutex_);
+
+#endif  // defined(WINUWP)
+
+  /// Thread multiplexing the frame requests of all external video track
+  /// sources not using a dedicated thread, and the audio delivery of all
+  /// external audio track sources. This is initialized only while the library
   /// is initialized, and is immutable between init and shutdown, so do not
   /// require |mutex_| for access, but |init_mutex_| instead.
-  std::unique_ptr<rtc::Thread> signaling_thread_ RTC_GUARDED_BY(init_mutex_);
+  std::unique_ptr<rtc::Thread> capture_scheduler_thread_
+      RTC_GUARDED_BY(init_mutex_);
 
-#endif  // defined(WINUWP)
+  /// Pool of DTLS certificates. This is initialized only while the library is
+  /// initialized, and is immutable between init and shutdown, so do not
+  /// require |mutex_| for access, but |init_mutex_| instead.
+  std::unique_ptr<CertificatePool> certificate_pool_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Configuration of the certificate pool created on initialization. This can
+  /// only change while the library is not initialized.
+  mrsCertificatePoolConfig certificate_pool_config_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Layers of the VP9 encoders, applied on initialization. This can only
+  /// change while the library is not initialized.
+  absl::optional<ScalabilityMode> vp9_layers_ RTC_GUARDED_BY(init_mutex_);
 
   /// Reference count to the library, for automated shutdown.
   mutable std::atomic_uint32_t ref_count_{0};
@@ -227,11 +400,40 @@ class GlobalFactory {
   mrsShutdownOptions shutdown_options_ RTC_GUARDED_BY(mutex_) =
       mrsShutdownOptions::kDefault;
 
-  /// Collection of all tracked objects alive. This is solely used to display a
-  /// debugging report with |ReportLiveObjects()|.
-  std::vector<TrackedObject*> alive_objects_ RTC_GUARDED_BY(mutex_);
+  /// Callbacks creating the custom video codec factories on initialization.
+  /// These can only change while the library is not initialized.
+  VideoCodecFactoryCallback video_encoder_factory_callback_
+      RTC_GUARDED_BY(init_mutex_);
+  VideoCodecFactoryCallback video_decoder_factory_callback_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Collection of the tracked objects alive of a same type, with its own lock
+  /// to avoid contention between objects of different types.
+  struct ObjectShard {
+    std::mutex mutex;
+    std::unordered_set<TrackedObject*> objects RTC_GUARDED_BY(mutex);
+    size_t peak_count RTC_GUARDED_BY(mutex) = 0;
+  };
+
+  /// Collections of all tracked objects alive, indexed by object type. This is
+  /// solely used for debugging reports with |ReportLiveObjects()| and
+  /// |GetLiveObjectCounts()|.
+  ObjectShard alive_objects_[kObjectTypeCount];
 
   rtc::scoped_refptr<ToggleAudioMixer> custom_audio_mixer_;
+
+  /// Mutex for |async_init_thread_|.
+  std::mutex async_init_mutex_;
+
+  /// Thread initializing the library started by |InitializeAsync()|, if any.
+  std::thread async_init_thread_ RTC_GUARDED_BY(async_init_mutex_);
+
+  /// The library holds a reference to itself after |InitializeAsync()|, until
+  /// the first tracked object is added.
+  std::atomic_bool holds_initial_ref_{false};
+
+  /// Taps of the encoded frames, shared with the video decoder factory.
+  std::shared_ptr<EncodedFrameTapRegistry> encoded_frame_taps_;
 };
 
 }  // namespace WebRTC
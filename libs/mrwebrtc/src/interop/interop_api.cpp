@@ -7,7 +7,9 @@
 
 #include "api/stats/rtcstats_objects.h"
 
+#include "android_video.h"
 #include "audio_track_source_interop.h"
+#include "color_conversion.h"
 #include "data_channel.h"
 #include "data_channel_interop.h"
 #include "external_video_track_source_interop.h"
@@ -15,13 +17,17 @@
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "local_video_track_interop.h"
+#include "memory_accounting.h"
 #include "media/audio_track_source.h"
 #include "media/external_video_track_source.h"
 #include "media/local_audio_track.h"
 #include "media/local_video_track.h"
+#include "media/video_capture_device_cache.h"
 #include "peer_connection.h"
 #include "peer_connection_interop.h"
 #include "sdp_utils.h"
+#include "simple_stats.h"
+#include "toggle_audio_mixer.h"
 #include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
@@ -49,51 +55,19 @@ mrsResult RTCToAPIError(const webrtc::RTCError& error) {
   }
 }
 
+/// Check that all fields of an ICE candidate received from the remote peer are
+/// provided.
+bool IsValidIceCandidate(const mrsIceCandidate& candidate) noexcept {
+  return (!IsStringNullOrEmpty(candidate.sdp_mid) &&
+          !IsStringNullOrEmpty(candidate.content) &&
+          (candidate.sdp_mline_index >= 0));
+}
+
 #if defined(WINUWP)
 using WebRtcFactoryPtr =
     std::shared_ptr<wrapper::impl::org::webRtc::WebRtcFactory>;
 #endif  // defined(WINUWP)
 
-/// Convert a WebRTC VideoType format into its FOURCC counterpart.
-uint32_t FourCCFromVideoType(webrtc::VideoType videoType) {
-  switch (videoType) {
-    default:
-    case webrtc::VideoType::kUnknown:
-      return (uint32_t)libyuv::FOURCC_ANY;
-    case webrtc::VideoType::kI420:
-      return (uint32_t)libyuv::FOURCC_I420;
-    case webrtc::VideoType::kIYUV:
-      return (uint32_t)libyuv::FOURCC_IYUV;
-    case webrtc::VideoType::kRGB24:
-      // this seems unintuitive, but is how defined in the core implementation
-      return (uint32_t)libyuv::FOURCC_24BG;
-    case webrtc::VideoType::kABGR:
-      return (uint32_t)libyuv::FOURCC_ABGR;
-    case webrtc::VideoType::kARGB:
-      return (uint32_t)libyuv::FOURCC_ARGB;
-    case webrtc::VideoType::kARGB4444:
-      return (uint32_t)libyuv::FOURCC_R444;
-    case webrtc::VideoType::kRGB565:
-      return (uint32_t)libyuv::FOURCC_RGBP;
-    case webrtc::VideoType::kARGB1555:
-      return (uint32_t)libyuv::FOURCC_RGBO;
-    case webrtc::VideoType::kYUY2:
-      return (uint32_t)libyuv::FOURCC_YUY2;
-    case webrtc::VideoType::kYV12:
-      return (uint32_t)libyuv::FOURCC_YV12;
-    case webrtc::VideoType::kUYVY:
-      return (uint32_t)libyuv::FOURCC_UYVY;
-    case webrtc::VideoType::kMJPEG:
-      return (uint32_t)libyuv::FOURCC_MJPG;
-    case webrtc::VideoType::kNV21:
-      return (uint32_t)libyuv::FOURCC_NV21;
-    case webrtc::VideoType::kNV12:
-      return (uint32_t)libyuv::FOURCC_NV12;
-    case webrtc::VideoType::kBGRA:
-      return (uint32_t)libyuv::FOURCC_BGRA;
-  };
-}
-
 }  // namespace
 
 inline rtc::Thread* GetWorkerThread() {
@@ -104,6 +78,57 @@ uint32_t MRS_CALL mrsReportLiveObjects() noexcept {
   return GlobalFactory::StaticReportLiveObjects();
 }
 
+mrsResult MRS_CALL mrsGetMemoryReport(mrsMemoryReport* report) noexcept {
+  if (!report) {
+    return Result::kInvalidParameter;
+  }
+  GlobalFactory::LiveObjectCount counts[kObjectTypeCount];
+  GlobalFactory::GetLiveObjectCounts(counts);
+  mrsLiveObjectCount* const report_counts[] = {
+      &report->peer_connections,
+      &report->local_audio_tracks,
+      &report->local_video_tracks,
+      &report->remote_audio_tracks,
+      &report->remote_video_tracks,
+      &report->data_channels,
+      &report->audio_transceivers,
+      &report->video_transceivers,
+      &report->device_audio_track_sources,
+      &report->device_video_track_sources,
+      &report->external_video_track_sources,
+      &report->relay_video_track_sources,
+      &report->external_encoded_video_track_sources,
+      &report->external_audio_track_sources,
+  };
+  static_assert(sizeof(report_counts) / sizeof(report_counts[0]) ==
+                    kObjectTypeCount,
+                "Missing object type in mrsMemoryReport");
+  for (int i = 0; i < kObjectTypeCount; ++i) {
+    report_counts[i]->current = counts[i].current_;
+    report_counts[i]->peak = counts[i].peak_;
+  }
+  mrsMemoryUsage* const report_usages[] = {
+      &report->frame_buffers,      &report->scratch_buffers,
+      &report->audio_read_buffers, &report->data_channel_queues,
+      &report->buffer_pools,
+  };
+  static_assert(sizeof(report_usages) / sizeof(report_usages[0]) ==
+                    kMemoryCategoryCount,
+                "Missing memory category in mrsMemoryReport");
+  for (int i = 0; i < kMemoryCategoryCount; ++i) {
+    const MemoryUsage usage =
+        MemoryAccounting::GetUsage(static_cast<MemoryCategory>(i));
+    report_usages[i]->current_bytes = usage.current_bytes_;
+    report_usages[i]->peak_bytes = usage.peak_bytes_;
+  }
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsResetMemoryReportPeaks() noexcept {
+  GlobalFactory::ResetLiveObjectPeaks();
+  MemoryAccounting::ResetPeaks();
+}
+
 mrsShutdownOptions MRS_CALL mrsGetShutdownOptions() noexcept {
   return GlobalFactory::GetShutdownOptions();
 }
@@ -116,6 +141,73 @@ void MRS_CALL mrsForceShutdown() noexcept {
   GlobalFactory::ForceShutdown();
 }
 
+mrsResult MRS_CALL mrsSetVideoCodecFactories(
+    mrsVideoEncoderFactoryCreateCallback encoder_factory_callback,
+    mrsVideoDecoderFactoryCreateCallback decoder_factory_callback,
+    void* user_data) noexcept {
+  return GlobalFactory::SetVideoCodecFactories(
+      {encoder_factory_callback, user_data},
+      {decoder_factory_callback, user_data});
+}
+
+mrsResult MRS_CALL
+mrsSetAndroidVideoCodecFactories(void* j_encoder_factory,
+                                 void* j_decoder_factory) noexcept {
+  return SetAndroidVideoCodecFactories(j_encoder_factory, j_decoder_factory);
+}
+
+mrsResult MRS_CALL mrsSetThreadGroups(const mrsThreadGroupConfig* groups,
+                                     uint32_t count) noexcept {
+  if (!groups && (count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetThreadGroups(
+      std::vector<mrsThreadGroupConfig>(groups, groups + count));
+}
+
+mrsResult MRS_CALL mrsSetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetAudioDeviceModuleConfig(*config);
+}
+
+mrsResult MRS_CALL
+mrsSetCertificatePoolConfig(const mrsCertificatePoolConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetCertificatePoolConfig(*config);
+}
+
+mrsResult MRS_CALL mrsSetVideoDecoderThreadingConfig(
+    const mrsVideoDecoderThreadingConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetVideoDecoderThreadingConfig(*config);
+}
+
+mrsResult MRS_CALL mrsSetVp9ScalabilityMode(const char* mode) noexcept {
+  absl::optional<ScalabilityMode> layers;
+  if (!IsStringNullOrEmpty(mode)) {
+    ErrorOr<ScalabilityMode> parsed = ParseScalabilityMode(mode);
+    if (!parsed.ok()) {
+      RTC_LOG(LS_ERROR) << parsed.error().message();
+      return parsed.error().result();
+    }
+    layers = parsed.MoveValue();
+  }
+  return GlobalFactory::SetVp9Layers(layers);
+}
+
+mrsResult MRS_CALL
+mrsLibraryInitializeAsync(mrsLibraryInitializedCallback callback,
+                          void* user_data) noexcept {
+  return GlobalFactory::InitializeAsync({callback, user_data});
+}
+
 void MRS_CALL mrsCloseEnum(mrsEnumHandle* handleRef) noexcept {
   if (handleRef) {
     if (auto& handle = *handleRef) {
@@ -135,6 +227,20 @@ mrsResult MRS_CALL mrsEnumVideoCaptureDevicesAsync(
     return Result::kInvalidParameter;
   }
 #if defined(WINUWP)
+  // Serve the cached devices synchronously
+  std::vector<VideoCaptureDeviceInfo> devices;
+  uint64_t generation;
+  if (VideoCaptureDeviceCache::Instance().GetDevices(devices, generation)) {
+    for (auto&& device : devices) {
+      (*enumCallback)(device.id.c_str(), device.name.c_str(),
+                      enumCallbackUserData);
+    }
+    if (completedCallback) {
+      (*completedCallback)(completedCallbackUserData);
+    }
+    return Result::kSuccess;
+  }
+
   RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
   // The UWP factory needs to be initialized for getDevices() to work.
   if (!global_factory->GetPeerConnectionFactory()) {
@@ -144,43 +250,38 @@ mrsResult MRS_CALL mrsEnumVideoCaptureDevicesAsync(
 
   auto vci = wrapper::impl::org::webRtc::VideoCapturer::getDevices();
   vci->thenClosure([vci, enumCallback, completedCallback, enumCallbackUserData,
-                    completedCallbackUserData] {
+                    completedCallbackUserData, generation] {
     auto deviceList = vci->value();
+    std::vector<VideoCaptureDeviceInfo> devices;
     for (auto&& vdi : *deviceList) {
       auto devInfo =
           wrapper::impl::org::webRtc::VideoDeviceInfo::toNative_winrt(vdi);
       auto id = winrt::to_string(devInfo.Id());
       auto name = winrt::to_string(devInfo.Name());
       (*enumCallback)(id.c_str(), name.c_str(), enumCallbackUserData);
+      devices.push_back({std::move(id), std::move(name)});
     }
+    VideoCaptureDeviceCache::Instance().SetDevices(std::move(devices),
+                                                   generation);
     if (completedCallback) {
       (*completedCallback)(completedCallbackUserData);
     }
   });
   return Result::kSuccess;
 #else
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
-      webrtc::VideoCaptureFactory::CreateDeviceInfo());
-  if (!info) {
-    RTC_LOG(LS_ERROR) << "Failed to start video capture devices enumeration.";
-    if (completedCallback) {
-      (*completedCallback)(completedCallbackUserData);
-    }
-    return Result::kUnknownError;
-  }
-  int num_devices = info->NumberOfDevices();
-  for (int i = 0; i < num_devices; ++i) {
-    constexpr uint32_t kSize = 256;
-    char name[kSize] = {0};
-    char id[kSize] = {0};
-    if (info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-      (*enumCallback)(id, name, enumCallbackUserData);
+  std::vector<VideoCaptureDeviceInfo> devices;
+  const mrsResult res =
+      VideoCaptureDeviceCache::Instance().GetOrEnumerateDevices(devices);
+  if (res == Result::kSuccess) {
+    for (auto&& device : devices) {
+      (*enumCallback)(device.id.c_str(), device.name.c_str(),
+                      enumCallbackUserData);
     }
   }
   if (completedCallback) {
     (*completedCallback)(completedCallbackUserData);
   }
-  return Result::kSuccess;
+  return res;
 #endif
 }
 
@@ -200,6 +301,21 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
   }
 
 #if defined(WINUWP)
+  // Serve the cached formats synchronously
+  std::vector<VideoCaptureFormatInfo> formats;
+  uint64_t generation;
+  if (VideoCaptureDeviceCache::Instance().GetFormats(device_id_str, formats,
+                                                     generation)) {
+    for (auto&& format : formats) {
+      (*enumCallback)(format.width, format.height, format.framerate,
+                      format.fourcc, enumCallbackUserData);
+    }
+    if (completedCallback) {
+      (*completedCallback)(Result::kSuccess, completedCallbackUserData);
+    }
+    return Result::kSuccess;
+  }
+
   RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
   // The UWP factory needs to be initialized for getDevices() to work.
   WebRtcFactoryPtr uwp_factory;
@@ -233,7 +349,7 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
           winrt::Windows::Devices::Enumeration::DeviceClass::VideoCapture);
   asyncResults.Completed([device_id_str, enumCallback, completedCallback,
                           enumCallbackUserData, completedCallbackUserData,
-                          uwp_factory = std::move(uwp_factory)](
+                          generation, uwp_factory = std::move(uwp_factory)](
                              auto&& asyncResults,
                              winrt::Windows::Foundation::AsyncStatus status) {
     // If the OS enumeration failed, terminate our own enumeration
@@ -280,6 +396,7 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
     }
 
     // Get its supported capture formats
+    std::vector<VideoCaptureFormatInfo> formats;
     auto captureFormatList = vcd->getSupportedFormats();
     for (auto&& captureFormat : *captureFormatList) {
       uint32_t width = captureFormat->get_width();
@@ -292,8 +409,11 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
       // those formats, as we don't know their encoding.
       if (fourcc != libyuv::FOURCC_ANY) {
         (*enumCallback)(width, height, framerate, fourcc, enumCallbackUserData);
+        formats.push_back({width, height, framerate, fourcc});
       }
     }
+    VideoCaptureDeviceCache::Instance().SetFormats(
+        device_id_str, std::move(formats), generation);
 
     // Invoke the completed callback at the end of enumeration
     if (completedCallback) {
@@ -301,41 +421,25 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
     }
   });
 #else   // defined(WINUWP)
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
-      webrtc::VideoCaptureFactory::CreateDeviceInfo());
-  if (!info) {
-    return Result::kUnknownError;
+  // Enum video capture formats, unless the device does not exist
+  VideoCaptureDeviceCache& cache = VideoCaptureDeviceCache::Instance();
+  std::vector<VideoCaptureDeviceInfo> devices;
+  const mrsResult res = cache.GetOrEnumerateDevices(devices);
+  if (res != Result::kSuccess) {
+    return res;
   }
-  int num_devices = info->NumberOfDevices();
-  for (int device_idx = 0; device_idx < num_devices; ++device_idx) {
-    // Filter devices by name
-    constexpr uint32_t kSize = 256;
-    char name[kSize] = {0};
-    char id[kSize] = {0};
-    if (info->GetDeviceName(device_idx, name, kSize, id, kSize) == -1) {
-      continue;
-    }
-    if (id != device_id_str) {
-      continue;
-    }
-
-    // Enum video capture formats
-    int32_t num_capabilities = info->NumberOfCapabilities(id);
-    for (int32_t cap_idx = 0; cap_idx < num_capabilities; ++cap_idx) {
-      webrtc::VideoCaptureCapability capability{};
-      if (info->GetCapability(id, cap_idx, capability) != -1) {
-        uint32_t width = capability.width;
-        uint32_t height = capability.height;
-        double framerate = capability.maxFPS;
-        uint32_t fourcc = FourCCFromVideoType(capability.videoType);
-        if (fourcc != libyuv::FOURCC_ANY) {
-          (*enumCallback)(width, height, framerate, fourcc,
-                          enumCallbackUserData);
-        }
-      }
+  auto it = std::find_if(devices.begin(), devices.end(),
+                         [&device_id_str](const VideoCaptureDeviceInfo& info) {
+                           return (info.id == device_id_str);
+                         });
+  std::vector<VideoCaptureFormatInfo> formats;
+  if ((it != devices.end()) &&
+      (cache.GetOrEnumerateFormats(device_id_str, formats) ==
+       Result::kSuccess)) {
+    for (auto&& format : formats) {
+      (*enumCallback)(format.width, format.height, format.framerate,
+                      format.fourcc, enumCallbackUserData);
     }
-
-    break;
   }
 
   // Invoke the completed callback at the end of enumeration
@@ -348,6 +452,13 @@ mrsResult MRS_CALL mrsEnumVideoCaptureFormatsAsync(
   // Note that the enumeration is asynchronous, so not done yet.
   return Result::kSuccess;
 }
+void MRS_CALL mrsSetVideoCaptureDevicesChangedCallback(
+    mrsVideoCaptureDevicesChangedCallback callback,
+    void* user_data) noexcept {
+  VideoCaptureDeviceCache::Instance().SetDevicesChangedCallback(
+      {callback, user_data});
+}
+
 mrsResult MRS_CALL
 mrsPeerConnectionCreate(const mrsPeerConnectionConfiguration* config,
                         mrsPeerConnectionHandle* peer_handle_out) noexcept {
@@ -491,15 +602,82 @@ mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
   }
   const bool ordered = (config->flags & mrsDataChannelConfigFlags::kOrdered);
   const bool reliable = (config->flags & mrsDataChannelConfigFlags::kReliable);
+  const bool compressed =
+      (config->flags & mrsDataChannelConfigFlags::kCompressed);
   const absl::string_view label = (config->label ? config->label : "");
   ErrorOr<std::shared_ptr<DataChannel>> data_channel =
-      peer->AddDataChannel(config->id, label, ordered, reliable);
+      peer->AddDataChannel(config->id, label, ordered, reliable, compressed,
+                           config->max_retransmits,
+                           config->max_packet_lifetime_ms, config->priority);
   if (data_channel.ok()) {
     *data_channel_handle_out = data_channel.value().operator->();
   }
   return data_channel.error().result();
 }
 
+mrsResult MRS_CALL mrsPeerConnectionAddDataChannels(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelConfig* configs,
+    uint32_t count,
+    mrsDataChannelHandle* data_channel_handles_out) noexcept {
+  if (!configs || !data_channel_handles_out || (count == 0)) {
+    return Result::kInvalidParameter;
+  }
+  std::fill_n(data_channel_handles_out, count, nullptr);
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  ErrorOr<std::vector<std::shared_ptr<DataChannel>>> data_channels =
+      peer->AddDataChannels(DataChannelSettings::FromConfigs(configs, count));
+  if (!data_channels.ok()) {
+    return data_channels.error().result();
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    data_channel_handles_out[i] = data_channels.value()[i].get();
+  }
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddDataChannelsAsync(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsDataChannelConfig* configs,
+    uint32_t count,
+    mrsPeerConnectionDataChannelsAddedCallback callback,
+    void* user_data) noexcept {
+  if (!configs || !callback || (count == 0)) {
+    return Result::kInvalidParameter;
+  }
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  return peer
+      ->AddDataChannelsAsync(DataChannelSettings::FromConfigs(configs, count),
+                             {callback, user_data})
+      .result();
+}
+
+mrsResult MRS_CALL mrsPeerConnectionGetDataChannelById(
+    mrsPeerConnectionHandle peer_handle,
+    int32_t id,
+    mrsDataChannelHandle* data_channel_handle_out) noexcept {
+  if (!data_channel_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *data_channel_handle_out = nullptr;
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  std::shared_ptr<DataChannel> data_channel = peer->GetDataChannelById(id);
+  if (!data_channel) {
+    return Result::kNotFound;
+  }
+  *data_channel_handle_out = data_channel.get();
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL mrsPeerConnectionRemoveDataChannel(
     mrsPeerConnectionHandle peer_handle,
     mrsDataChannelHandle data_channel_handle) noexcept {
@@ -518,9 +696,7 @@ mrsResult MRS_CALL mrsPeerConnectionRemoveDataChannel(
 mrsResult MRS_CALL
 mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
                                  const mrsIceCandidate* candidate) noexcept {
-  if (!candidate || IsStringNullOrEmpty(candidate->sdp_mid) ||
-      IsStringNullOrEmpty(candidate->content) ||
-      (candidate->sdp_mline_index < 0)) {
+  if (!candidate || !IsValidIceCandidate(*candidate)) {
     return mrsResult::kInvalidParameter;
   }
   auto const peer = static_cast<PeerConnection*>(peer_handle);
@@ -534,6 +710,29 @@ mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
   return result.result();
 }
 
+mrsResult MRS_CALL
+mrsPeerConnectionAddIceCandidates(mrsPeerConnectionHandle peer_handle,
+                                  const mrsIceCandidate* candidates,
+                                  int count) noexcept {
+  if ((count < 0) || ((count > 0) && !candidates)) {
+    return mrsResult::kInvalidParameter;
+  }
+  for (int i = 0; i < count; ++i) {
+    if (!IsValidIceCandidate(candidates[i])) {
+      return mrsResult::kInvalidParameter;
+    }
+  }
+  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  Error result = peer->AddIceCandidates(candidates, count);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << result.message();
+  }
+  return result.result();
+}
+
 mrsResult MRS_CALL
 mrsPeerConnectionCreateOffer(mrsPeerConnectionHandle peer_handle) noexcept {
   if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
@@ -602,6 +801,25 @@ mrsPeerConnectionClose(mrsPeerConnectionHandle peer_handle) noexcept {
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL
+mrsPeerConnectionCloseMany(const mrsPeerConnectionHandle* peer_handles,
+                           uint32_t count,
+                           int timeout_ms) noexcept {
+  if (!peer_handles && (count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  std::vector<RefPtr<PeerConnection>> peers;
+  peers.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto peer = static_cast<PeerConnection*>(peer_handles[i]);
+    if (!peer) {
+      return Result::kInvalidNativeHandle;
+    }
+    peers.emplace_back(peer);
+  }
+  return PeerConnection::CloseMany(std::move(peers), timeout_ms);
+}
+
 mrsResult MRS_CALL mrsSdpForceCodecs(const char* message,
                                      SdpFilter audio_filter,
                                      SdpFilter video_filter,
@@ -642,6 +860,53 @@ mrsResult MRS_CALL mrsSdpForceCodecs(const char* message,
   return Result::kSuccess;
 }
 
+namespace {
+
+/// Copy a string into a buffer allocated by the caller, as a null-terminated
+/// string, and return the size needed for it.
+mrsResult CopyToBuffer(const std::string& str,
+                       char* buffer,
+                       uint64_t* buffer_size) noexcept {
+  const size_t capacity = static_cast<size_t>(*buffer_size);
+  const size_t size = str.size();
+  *buffer_size = size + 1;
+  if (capacity < size + 1) {
+    return Result::kBufferTooSmall;
+  }
+  memcpy(buffer, str.c_str(), size);
+  buffer[size] = '\0';
+  return Result::kSuccess;
+}
+
+}  // namespace
+
+mrsResult MRS_CALL mrsSdpEncodeCompact(const char* message,
+                                       const char* base,
+                                       char* buffer,
+                                       uint64_t* buffer_size) noexcept {
+  if (!message || !buffer_size || (!buffer && (*buffer_size > 0))) {
+    return Result::kInvalidParameter;
+  }
+  const std::string compact =
+      SdpEncodeCompact(message, base ? std::string(base) : std::string());
+  return CopyToBuffer(compact, buffer, buffer_size);
+}
+
+mrsResult MRS_CALL mrsSdpDecodeCompact(const char* compact,
+                                       const char* base,
+                                       char* buffer,
+                                       uint64_t* buffer_size) noexcept {
+  if (!compact || !buffer_size || (!buffer && (*buffer_size > 0))) {
+    return Result::kInvalidParameter;
+  }
+  std::string message;
+  if (!SdpDecodeCompact(compact, base ? std::string(base) : std::string(),
+                        message)) {
+    return Result::kInvalidParameter;
+  }
+  return CopyToBuffer(message, buffer, buffer_size);
+}
+
 mrsBool MRS_CALL mrsSdpIsValidToken(const char* token) noexcept {
   return ((token != nullptr) && SdpIsValidToken(token) ? mrsBool::kTrue
                                                        : mrsBool::kFalse);
@@ -652,6 +917,16 @@ void MRS_CALL mrsSetFrameHeightRoundMode(FrameHeightRoundMode value) {
       (PeerConnection::FrameHeightRoundMode)value);
 }
 
+void MRS_CALL
+mrsSetParallelConversionThreshold(uint64_t pixel_count) noexcept {
+  SetParallelConversionThreshold(pixel_count);
+}
+
+void MRS_CALL
+mrsSetParallelAudioPumpThreshold(int32_t source_count) noexcept {
+  ToggleAudioMixer::SetParallelPumpThreshold(std::max(source_count, 0));
+}
+
 void MRS_CALL mrsMemCpy(void* dst, const void* src, uint64_t size) noexcept {
   memcpy(dst, src, static_cast<size_t>(size));
 }
@@ -680,6 +955,145 @@ void MRS_CALL mrsMemCpyStride(void* dst,
   }
 }
 
+namespace {
+
+/// Copy the rows [row_begin, row_end) of a frame plane, which the caller
+/// splits into bands of even rows so that they map to the chroma rows
+/// [row_begin / 2, (row_end + 1) / 2).
+struct PlaneCopy {
+  const uint8_t* src;
+  int src_stride;
+  uint8_t* dst;
+  int dst_stride;
+  int row_size;
+  int height;
+  bool downsampled;
+
+  void CopyBand(int row_begin, int row_end, bool flip, bool streaming) const {
+    if (downsampled) {
+      row_begin /= 2;
+      row_end = (row_end + 1) / 2;
+    }
+    if (src) {
+      CopyPlaneRows(src, src_stride, dst, dst_stride, row_size, height,
+                    row_begin, row_end, flip, streaming);
+      return;
+    }
+    // Fill rows without a source with opaque alpha.
+    for (int row = row_begin; row < row_end; ++row) {
+      const int dst_row = (flip ? height - 1 - row : row);
+      memset(dst + (size_t)dst_row * dst_stride, 0xFF, row_size);
+    }
+  }
+};
+
+void CopyPlanes(const PlaneCopy* planes,
+                size_t count,
+                int width,
+                int height,
+                mrsFrameCopyFlags flags) noexcept {
+  const bool flip = ((flags & mrsFrameCopyFlags::kFlipVertically) != 0);
+  const bool streaming = ((flags & mrsFrameCopyFlags::kStreamingStores) != 0);
+  ForEachRowBand(width, height, [&](int row_begin, int row_end) {
+    for (size_t i = 0; i < count; ++i) {
+      planes[i].CopyBand(row_begin, row_end, flip, streaming);
+    }
+    if (streaming) {
+      // Non-temporal stores are only ordered on the thread which issued them.
+      FenceStreamingStores();
+    }
+  });
+}
+
+}  // namespace
+
+mrsResult MRS_CALL mrsCopyI420AFrame(const mrsI420AVideoFrame* frame,
+                                     const mrsI420AFrameLayout* dst,
+                                     mrsFrameCopyFlags flags) noexcept {
+  if (!frame || !dst || !frame->ydata_ || !frame->udata_ || !frame->vdata_ ||
+      !dst->ydata || !dst->udata || !dst->vdata) {
+    return Result::kInvalidParameter;
+  }
+  const int width = (int)frame->width_;
+  const int height = (int)frame->height_;
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  if ((dst->ystride < width) || (dst->ustride < chroma_width) ||
+      (dst->vstride < chroma_width) ||
+      (dst->adata && (dst->astride < width))) {
+    return Result::kInvalidParameter;
+  }
+  PlaneCopy planes[4] = {
+      {static_cast<const uint8_t*>(frame->ydata_), frame->ystride_,
+       static_cast<uint8_t*>(dst->ydata), dst->ystride, width, height, false},
+      {static_cast<const uint8_t*>(frame->udata_), frame->ustride_,
+       static_cast<uint8_t*>(dst->udata), dst->ustride, chroma_width,
+       chroma_height, true},
+      {static_cast<const uint8_t*>(frame->vdata_), frame->vstride_,
+       static_cast<uint8_t*>(dst->vdata), dst->vstride, chroma_width,
+       chroma_height, true},
+      {static_cast<const uint8_t*>(frame->adata_), frame->astride_,
+       static_cast<uint8_t*>(dst->adata), dst->astride, width, height, false}};
+  CopyPlanes(planes, (dst->adata ? 4 : 3), width, height, flags);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsCopyArgb32Frame(const mrsArgb32VideoFrame* frame,
+                                      void* dst,
+                                      int32_t dst_stride,
+                                      mrsFrameCopyFlags flags) noexcept {
+  if (!frame || !frame->argb32_data_ || !dst) {
+    return Result::kInvalidParameter;
+  }
+  const int width = (int)frame->width_;
+  const int height = (int)frame->height_;
+  if (dst_stride < width * 4) {
+    return Result::kInvalidParameter;
+  }
+  const PlaneCopy plane{static_cast<const uint8_t*>(frame->argb32_data_),
+                        frame->stride_,
+                        static_cast<uint8_t*>(dst),
+                        dst_stride,
+                        width * 4,
+                        height,
+                        false};
+  CopyPlanes(&plane, 1, width, height, flags);
+  return Result::kSuccess;
+}
+
+void MRS_CALL
+mrsVideoFrameBufferAddRef(mrsVideoFrameBufferHandle handle) noexcept {
+  if (auto buffer = static_cast<webrtc::VideoFrameBuffer*>(handle)) {
+    buffer->AddRef();
+  } else {
+    RTC_LOG(LS_WARNING)
+        << "Trying to add reference to NULL video frame buffer.";
+  }
+}
+
+void MRS_CALL
+mrsVideoFrameBufferRemoveRef(mrsVideoFrameBufferHandle handle) noexcept {
+  if (auto buffer = static_cast<webrtc::VideoFrameBuffer*>(handle)) {
+    buffer->Release();
+  } else {
+    RTC_LOG(LS_WARNING)
+        << "Trying to remove reference from NULL video frame buffer.";
+  }
+}
+
+mrsResult MRS_CALL mrsVideoFrameBufferGetAndroidTexture(
+    mrsVideoFrameBufferHandle handle,
+    mrsAndroidTextureFrame* texture_out) noexcept {
+  auto buffer = static_cast<webrtc::VideoFrameBuffer*>(handle);
+  if (!buffer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!texture_out) {
+    return Result::kInvalidParameter;
+  }
+  return GetAndroidTexture(buffer, *texture_out);
+}
+
 namespace {
 template <class T>
 T& FindOrInsert(std::vector<std::pair<std::string, T>>& vec,
@@ -725,27 +1139,6 @@ mrsResult MRS_CALL mrsPeerConnectionGetSimpleStats(
   return Result::kInvalidNativeHandle;
 }
 
-namespace {
-template <class T>
-void GetCommonValues(T& lhs, const webrtc::RTCOutboundRTPStreamStats& rhs) {
-  lhs.rtp_stats_timestamp_us = rhs.timestamp_us();
-  lhs.packets_sent = *rhs.packets_sent;
-  lhs.bytes_sent = *rhs.bytes_sent;
-}
-template <class T>
-void GetCommonValues(T& lhs, const webrtc::RTCInboundRTPStreamStats& rhs) {
-  lhs.rtp_stats_timestamp_us = rhs.timestamp_us();
-  lhs.packets_received = *rhs.packets_received;
-  lhs.bytes_received = *rhs.bytes_received;
-}
-
-template <class T>
-T GetValueIfDefined(const webrtc::RTCStatsMember<T>& member) {
-  return member.is_defined() ? *member : 0;
-}
-
-}  // namespace
-
 mrsResult MRS_CALL
 mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
                          const char* stats_type,
@@ -760,10 +1153,8 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
     for (auto&& stats : *report) {
       if (!strcmp(stats.type(), "data-channel")) {
         const auto& dc_stats = stats.cast_to<webrtc::RTCDataChannelStats>();
-        mrsDataChannelStats simple_stats{
-            dc_stats.timestamp_us(),     *dc_stats.datachannelid,
-            *dc_stats.messages_sent,     *dc_stats.bytes_sent,
-            *dc_stats.messages_received, *dc_stats.bytes_received};
+        mrsDataChannelStats simple_stats{};
+        FillDataChannelStats(simple_stats, dc_stats);
         (*callback)(user_data, &simple_stats);
       }
     }
@@ -779,7 +1170,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
             // Removing a track will leave a "trackless" RTP stream. Ignore it.
             ortp_stats.track_id.is_defined()) {
           auto& dest_stats = FindOrInsert(pending_stats, *ortp_stats.track_id);
-          GetCommonValues(dest_stats, ortp_stats);
+          FillRtpStats(dest_stats, ortp_stats);
         }
       } else if (!strcmp(stats.type(), "track")) {
         const auto& track_stats =
@@ -787,12 +1178,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "audio") {
           if (!(*track_stats.remote_source)) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.audio_level = GetValueIfDefined(track_stats.audio_level);
-            dest_stats.total_audio_energy = *track_stats.total_audio_energy;
-            dest_stats.total_samples_duration =
-                *track_stats.total_samples_duration;
+            FillTrackStats(dest_stats, track_stats);
           }
         }
       }
@@ -810,7 +1196,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
             stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
         if (*irtp_stats.kind == "audio") {
           auto& dest_stats = FindOrInsert(pending_stats, *irtp_stats.track_id);
-          GetCommonValues(dest_stats, irtp_stats);
+          FillRtpStats(dest_stats, irtp_stats);
         }
       } else if (!strcmp(stats.type(), "track")) {
         const auto& track_stats =
@@ -818,15 +1204,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "audio") {
           if (*track_stats.remote_source) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            // This seems to be undefined in some not well specified cases.
-            dest_stats.audio_level = GetValueIfDefined(track_stats.audio_level);
-            dest_stats.total_audio_energy = *track_stats.total_audio_energy;
-            dest_stats.total_samples_received =
-                GetValueIfDefined(track_stats.total_samples_received);
-            dest_stats.total_samples_duration =
-                *track_stats.total_samples_duration;
+            FillTrackStats(dest_stats, track_stats);
           }
         }
       }
@@ -846,8 +1224,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
             // Removing a track will leave a "trackless" RTP stream. Ignore it.
             ortp_stats.track_id.is_defined()) {
           auto& dest_stats = FindOrInsert(pending_stats, *ortp_stats.track_id);
-          GetCommonValues(dest_stats, ortp_stats);
-          dest_stats.frames_encoded = *ortp_stats.frames_encoded;
+          FillRtpStats(dest_stats, ortp_stats);
         }
       } else if (!strcmp(stats.type(), "track")) {
         const auto& track_stats =
@@ -855,11 +1232,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "video") {
           if (!(*track_stats.remote_source)) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.frames_sent = GetValueIfDefined(track_stats.frames_sent);
-            dest_stats.huge_frames_sent =
-                GetValueIfDefined(track_stats.huge_frames_sent);
+            FillTrackStats(dest_stats, track_stats);
           }
         }
       }
@@ -877,8 +1250,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
             stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
         if (*irtp_stats.kind == "video") {
           auto& dest_stats = FindOrInsert(pending_stats, *irtp_stats.track_id);
-          GetCommonValues(dest_stats, irtp_stats);
-          dest_stats.frames_decoded = *irtp_stats.frames_decoded;
+          FillRtpStats(dest_stats, irtp_stats);
         }
       } else if (!strcmp(stats.type(), "track")) {
         const auto& track_stats =
@@ -886,12 +1258,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "video") {
           if (*track_stats.remote_source) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.frames_received =
-                GetValueIfDefined(track_stats.frames_received);
-            dest_stats.frames_dropped =
-                GetValueIfDefined(track_stats.frames_dropped);
+            FillTrackStats(dest_stats, track_stats);
           }
         }
       }
@@ -902,10 +1269,10 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
   } else if (!strcmp(stats_type, "TransportStats")) {
     for (auto&& stats : *report) {
       if (!strcmp(stats.type(), "transport")) {
-        const auto& dc_stats = stats.cast_to<webrtc::RTCTransportStats>();
-        mrsTransportStats simple_stats{dc_stats.timestamp_us(),
-                                       *dc_stats.bytes_sent,
-                                       *dc_stats.bytes_received};
+        const auto& transport_stats =
+            stats.cast_to<webrtc::RTCTransportStats>();
+        mrsTransportStats simple_stats{};
+        FillTransportStats(simple_stats, transport_stats, *report);
         (*callback)(user_data, &simple_stats);
       }
     }
@@ -913,6 +1280,112 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
   return Result::kSuccess;
 }
 
+mrsResult MRS_CALL
+mrsPeerConnectionSubscribeStats(mrsPeerConnectionHandle peer_handle,
+                                const mrsStatsSubscriptionConfig* config,
+                                mrsStatsSnapshotCallback callback,
+                                void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (callback && (!config || (config->interval_ms <= 0))) {
+    return Result::kInvalidParameter;
+  }
+  return peer->SubscribeStats(config ? *config : mrsStatsSubscriptionConfig{},
+                              StatsSnapshotCallback{callback, user_data});
+}
+
+mrsResult MRS_CALL mrsPeerConnectionSubscribeBandwidthEstimate(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsBandwidthEstimateConfig* config,
+    mrsBandwidthEstimateCallback callback,
+    void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (callback && (!config || (config->interval_ms <= 0) ||
+                   (config->change_threshold_percent < 0.0))) {
+    return Result::kInvalidParameter;
+  }
+  return peer->SubscribeBandwidthEstimate(
+      config ? *config : mrsBandwidthEstimateConfig{},
+      BandwidthEstimateCallback{callback, user_data});
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionProbeNetwork(mrsPeerConnectionHandle peer_handle,
+                              const mrsNetworkProbeConfig* config,
+                              mrsNetworkProbeCallback callback,
+                              void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  const mrsNetworkProbeConfig probe_config =
+      config ? *config : mrsNetworkProbeConfig{};
+  if (!callback || (probe_config.duration_ms <= 0) ||
+      (probe_config.max_padding_bitrate_bps < 0)) {
+    return Result::kInvalidParameter;
+  }
+  return peer->ProbeNetwork(probe_config,
+                            NetworkProbeCallback{callback, user_data});
+}
+
+mrsResult MRS_CALL mrsPeerConnectionGetTransportCryptoStats(
+    mrsPeerConnectionHandle peer_handle,
+    mrsTransportCryptoStatsCallback callback,
+    void* user_data) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  struct Observer : webrtc::StatsObserver {
+    Observer(mrsTransportCryptoStatsCallback callback, void* user_data)
+        : callback_(callback), user_data_(user_data) {}
+
+    mrsTransportCryptoStatsCallback callback_;
+    void* user_data_;
+    void OnComplete(const webrtc::StatsReports& reports) override {
+      // Each transport channel has a component report. Prefer one with an
+      // SRTP suite, since the data channels only use DTLS.
+      std::string srtp_cipher;
+      std::string dtls_cipher;
+      for (const webrtc::StatsReport* report : reports) {
+        if (report->type() != webrtc::StatsReport::kStatsReportTypeComponent) {
+          continue;
+        }
+        const webrtc::StatsReport::Value* srtp =
+            report->FindValue(webrtc::StatsReport::kStatsValueNameSrtpCipher);
+        const webrtc::StatsReport::Value* dtls =
+            report->FindValue(webrtc::StatsReport::kStatsValueNameDtlsCipher);
+        if (srtp) {
+          srtp_cipher = srtp->ToString();
+          dtls_cipher = dtls ? dtls->ToString() : std::string();
+          break;
+        }
+        if (dtls && dtls_cipher.empty()) {
+          dtls_cipher = dtls->ToString();
+        }
+      }
+      mrsTransportCryptoStats stats{};
+      stats.srtp_cipher = srtp_cipher.c_str();
+      stats.dtls_cipher = dtls_cipher.c_str();
+      (*callback_)(user_data_, &stats);
+    }
+  };
+  rtc::scoped_refptr<Observer> observer =
+      new rtc::RefCountedObject<Observer>(callback, user_data);
+  if (!peer->GetLegacyStats(observer)) {
+    return Result::kUnknownError;
+  }
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report) {
   if (auto rep = static_cast<const webrtc::RTCStatsReport*>(stats_report)) {
     rep->Release();
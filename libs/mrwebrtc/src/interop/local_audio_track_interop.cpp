@@ -68,6 +68,55 @@ mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
   }
 }
 
+mrsResult MRS_CALL mrsLocalAudioTrackSetFrameAggregationPeriod(
+    mrsLocalAudioTrackHandle track_handle,
+    int32_t period_ms) noexcept {
+  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((period_ms < 0) ||
+      (period_ms > AudioFrameObserver::kMaxAggregationPeriodMs)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio frame aggregation period "
+                      << period_ms << " ms.";
+    return Result::kInvalidParameter;
+  }
+  track->SetAggregationPeriod(period_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsLocalAudioTrackGetAudioLevel(mrsLocalAudioTrackHandle track_handle,
+                                mrsAudioLevel* level_out) noexcept {
+  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!level_out) {
+    return Result::kInvalidParameter;
+  }
+  track->GetAudioLevel(*level_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalAudioTrackRegisterAudioLevelCallback(
+    mrsLocalAudioTrackHandle track_handle,
+    float threshold,
+    mrsAudioLevelCallback callback,
+    void* user_data) noexcept {
+  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!(threshold >= 0.0f)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio level threshold " << threshold;
+    return Result::kInvalidParameter;
+  }
+  track->SetAudioLevelCallback(AudioLevelChangedCallback{callback, user_data},
+                               threshold);
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsLocalAudioTrackSetEnabled(mrsLocalAudioTrackHandle track_handle,
                              mrsBool enabled) noexcept {
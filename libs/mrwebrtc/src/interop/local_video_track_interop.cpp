@@ -31,6 +31,15 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromSource(
     RTC_LOG(LS_ERROR) << "Invalid track source handle.";
     return Result::kInvalidParameter;
   }
+  const FrameHeightRoundMode round_mode =
+      init_settings->frame_height_round_mode;
+  if ((round_mode != FrameHeightRoundMode::kNone) &&
+      (round_mode != FrameHeightRoundMode::kCrop) &&
+      (round_mode != FrameHeightRoundMode::kPad)) {
+    RTC_LOG(LS_ERROR) << "Invalid frame height round mode "
+                      << (int)round_mode << ".";
+    return Result::kInvalidParameter;
+  }
   if (!track_handle_out) {
     RTC_LOG(LS_ERROR) << "Invalid NULL local video track handle reference.";
     return Result::kInvalidParameter;
@@ -45,9 +54,15 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromSource(
 
   // Create the audio track
   auto source = static_cast<VideoTrackSource*>(source_handle);
+  rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> track_source =
+      source->impl();
+  if (round_mode != FrameHeightRoundMode::kNone) {
+    track_source = new rtc::RefCountedObject<FrameHeightRoundingAdapter>(
+        std::move(track_source), round_mode);
+  }
   rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track =
       pc_factory->CreateVideoTrack(init_settings->track_name,
-                                   source->impl().get());
+                                   track_source.get());
   if (!video_track) {
     RTC_LOG(LS_ERROR) << "Failed to create local video track from source.";
     return Result::kUnknownError;
@@ -78,6 +93,235 @@ void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameCallback(
   }
 }
 
+void MRS_CALL mrsLocalVideoTrackRegisterNv12FrameCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<LocalVideoTrack*>(trackHandle)) {
+    track->SetCallback(Nv12FrameReadyCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsLocalVideoTrackRegisterFrameLeaseCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<LocalVideoTrack*>(trackHandle)) {
+    track->SetCallback(VideoFrameLeaseCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameLeaseCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<LocalVideoTrack*>(trackHandle)) {
+    track->SetCallback(Argb32FrameLeaseCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackSetArgb32BufferPoolSize(mrsLocalVideoTrackHandle trackHandle,
+                                          int pool_size) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (pool_size <= 0) {
+    return Result::kInvalidParameter;
+  }
+  track->SetArgbBufferPoolSize(pool_size);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackSetFrameDeliveryOptions(
+    mrsLocalVideoTrackHandle trackHandle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!options || !VideoFrameObserver::IsValidDeliveryOptions(*options)) {
+    return Result::kInvalidParameter;
+  }
+  track->SetDeliveryOptions(*options);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackAddI420AFrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(I420AFrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackAddArgb32FrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(Argb32FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackAddNv12FrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(Nv12FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackRemoveFrameSubscriber(
+    mrsLocalVideoTrackHandle trackHandle,
+    uint64_t subscriber_id) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!track->RemoveSubscriber(subscriber_id)) {
+    return Result::kNotFound;
+  }
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackGetLatencyStats(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameLatencyStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const LatencySummary summary = track->GetLatencySummary();
+  stats_out->sample_count = summary.sample_count_;
+  stats_out->p50_ms = summary.p50_ms_;
+  stats_out->p95_ms = summary.p95_ms_;
+  stats_out->p99_ms = summary.p99_ms_;
+  stats_out->max_ms = summary.max_ms_;
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackResetLatencyStats(
+    mrsLocalVideoTrackHandle trackHandle) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->ResetLatencyStats();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackRequestKeyFrame(
+    mrsLocalVideoTrackHandle trackHandle) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->RequestKeyFrame();
+}
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackSetContentHint(mrsLocalVideoTrackHandle trackHandle,
+                                 mrsVideoContentHint content_hint) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetContentHint(content_hint);
+}
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackSetPlayoutDelay(mrsLocalVideoTrackHandle trackHandle,
+                                  int32_t min_delay_ms,
+                                  int32_t max_delay_ms) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetPlayoutDelay(min_delay_ms, max_delay_ms);
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackSetEncoderOptions(
+    mrsLocalVideoTrackHandle trackHandle,
+    const mrsVideoEncoderOptions* options) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!options) {
+    return Result::kInvalidParameter;
+  }
+  return track->SetEncoderOptions(*options);
+}
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackSetAsyncFrameDelivery(mrsLocalVideoTrackHandle trackHandle,
+                                        mrsBool enabled) noexcept {
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->SetAsyncDelivery(enabled != mrsBool::kFalse);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackGetFrameDeliveryStats(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsVideoFrameDeliveryStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<LocalVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  stats_out->async_replaced_count = track->GetAsyncDroppedFrameCount();
+  stats_out->overlap_dropped_count = track->GetOverlapDroppedFrameCount();
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsLocalVideoTrackSetEnabled(mrsLocalVideoTrackHandle track_handle,
                              mrsBool enabled) noexcept {
@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "log_sink.h"
+#include "log_sink_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+/// Installed sink, if any, and the debug output level to restore when it is
+/// uninstalled.
+std::mutex g_sink_mutex;
+std::unique_ptr<AsyncLogSink> g_sink RTC_GUARDED_BY(g_sink_mutex);
+int g_debug_severity RTC_GUARDED_BY(g_sink_mutex) = rtc::LS_NONE;
+bool g_debug_output_disabled RTC_GUARDED_BY(g_sink_mutex) = false;
+
+}  // namespace
+
+mrsResult MRS_CALL mrsLogSinkInstall(const mrsLogSinkConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(g_sink_mutex);
+  if (g_sink) {
+    return Result::kInvalidOperation;
+  }
+  ErrorOr<std::unique_ptr<AsyncLogSink>> sink = AsyncLogSink::Create(*config);
+  if (!sink.ok()) {
+    return sink.error().result();
+  }
+  g_sink = sink.MoveValue();
+  rtc::LogMessage::AddLogToStream(g_sink.get(), g_sink->min_severity());
+  g_debug_output_disabled = (config->keep_debug_output == mrsBool::kFalse);
+  if (g_debug_output_disabled) {
+    g_debug_severity = rtc::LogMessage::GetLogToDebug();
+    rtc::LogMessage::LogToDebug(rtc::LS_NONE);
+  }
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsLogSinkUninstall() noexcept {
+  std::lock_guard<std::mutex> lock(g_sink_mutex);
+  if (!g_sink) {
+    return;
+  }
+  // This waits for the messages being logged, which then cannot reach the
+  // sink once destroyed.
+  rtc::LogMessage::RemoveLogToStream(g_sink.get());
+  if (g_debug_output_disabled) {
+    rtc::LogMessage::LogToDebug((rtc::LoggingSeverity)g_debug_severity);
+  }
+  g_sink.reset();
+}
+
+mrsResult MRS_CALL mrsLogSinkSetLevel(const char* module,
+                                      mrsLogLevel level) noexcept {
+  if (((int)level < 0) || (level > mrsLogLevel::kNone)) {
+    return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(g_sink_mutex);
+  if (!g_sink) {
+    return Result::kInvalidOperation;
+  }
+  const rtc::LoggingSeverity previous_severity = g_sink->min_severity();
+  g_sink->SetLevel(module, level);
+  const rtc::LoggingSeverity severity = g_sink->min_severity();
+  if (severity != previous_severity) {
+    // Update the level WebRTC formats messages at for the sink.
+    rtc::LogMessage::RemoveLogToStream(g_sink.get());
+    rtc::LogMessage::AddLogToStream(g_sink.get(), severity);
+  }
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLogSinkFlush() noexcept {
+  std::lock_guard<std::mutex> lock(g_sink_mutex);
+  if (!g_sink) {
+    return Result::kInvalidOperation;
+  }
+  g_sink->Flush();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLogSinkGetStats(mrsLogSinkStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(g_sink_mutex);
+  if (!g_sink) {
+    return Result::kInvalidOperation;
+  }
+  *stats_out = g_sink->GetStats();
+  return Result::kSuccess;
+}
@@ -13,6 +13,32 @@
 
 using namespace Microsoft::MixedReality::WebRTC;
 
+namespace {
+
+/// Add a listener to a peer connection with |add(peer)|, after validating the
+/// interop arguments.
+template <typename CallbackT, typename AddFunc>
+mrsResult AddListener(mrsPeerConnectionHandle peer_handle,
+                      CallbackT callback,
+                      uint64_t* listener_id_out,
+                      AddFunc&& add) noexcept {
+  if (!listener_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *listener_id_out = 0;
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *listener_id_out = add(*peer);
+  return Result::kSuccess;
+}
+
+}  // namespace
+
 void MRS_CALL mrsPeerConnectionRegisterTransceiverAddedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionTransceiverAddedCallback callback,
@@ -33,6 +59,275 @@ void MRS_CALL mrsPeerConnectionRegisterIceGatheringStateChangedCallback(
   }
 }
 
+void MRS_CALL mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data) noexcept {
+  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+    peer->RegisterIceCandidatesReadytoSendCallback(
+        Callback<const mrsIceCandidate*, int>{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionRestartIce(mrsPeerConnectionHandle peer_handle) noexcept {
+  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+    return (peer->CreateOffer(/*ice_restart=*/true) ? Result::kSuccess
+                                                    : Result::kUnknownError);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionSetIceRestartPolicy(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsIceRestartPolicy* policy) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!policy || (policy->max_attempts < 0)) {
+    return Result::kInvalidParameter;
+  }
+  peer->SetIceRestartPolicy(*policy);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionPrewarmIce(mrsPeerConnectionHandle peer_handle,
+                            int pool_size) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (pool_size <= 0) {
+    return Result::kInvalidParameter;
+  }
+  Error result = peer->PrewarmIce(pool_size);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << result.message();
+  }
+  return result.result();
+}
+
+mrsResult MRS_CALL mrsPeerConnectionBeginBatchUpdate(
+    mrsPeerConnectionHandle peer_handle) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  peer->BeginBatchUpdate();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionEndBatchUpdate(mrsPeerConnectionHandle peer_handle) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  return peer->EndBatchUpdate();
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionSetIceCandidateBatchWindow(mrsPeerConnectionHandle peer_handle,
+                                            int window_ms) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  peer->SetIceCandidateBatchWindow(window_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionSetAutoSubscribe(mrsPeerConnectionHandle peer_handle,
+                                  mrsBool auto_subscribe) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  peer->SetAutoSubscribe(auto_subscribe != mrsBool::kFalse);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddConnectedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionConnectedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddConnectedListener({callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddLocalSdpReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionLocalSdpReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddLocalSdpReadytoSendListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddIceCandidateReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidateReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddIceCandidateReadytoSendListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddIceCandidatesReadytoSendListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddIceCandidatesReadytoSendListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddIceStateChangedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceStateChangedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddIceStateChangedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddIceGatheringStateChangedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionIceGatheringStateChangedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddIceGatheringStateChangedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddRenegotiationNeededListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionRenegotiationNeededCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddRenegotiationNeededListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddTransceiverAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionTransceiverAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddTransceiverAddedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddAudioTrackAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionAudioTrackAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddAudioTrackAddedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddAudioTrackRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionAudioTrackRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddAudioTrackRemovedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddVideoTrackAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionVideoTrackAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddVideoTrackAddedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddVideoTrackRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionVideoTrackRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddVideoTrackRemovedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddDataChannelAddedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionDataChannelAddedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddDataChannelAddedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL mrsPeerConnectionAddDataChannelRemovedListener(
+    mrsPeerConnectionHandle peer_handle,
+    mrsPeerConnectionDataChannelRemovedCallback callback,
+    void* user_data,
+    uint64_t* listener_id_out) noexcept {
+  return AddListener(peer_handle, callback, listener_id_out,
+                     [&](PeerConnection& peer) {
+                       return peer.AddDataChannelRemovedListener(
+                           {callback, user_data});
+                     });
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionRemoveListener(mrsPeerConnectionHandle peer_handle,
+                                uint64_t listener_id) noexcept {
+  auto peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  return (peer->RemoveListener(listener_id) ? Result::kSuccess
+                                            : Result::kNotFound);
+}
+
 mrsResult MRS_CALL
 mrsPeerConnectionAddTransceiver(mrsPeerConnectionHandle peer_handle,
                                 const mrsTransceiverInitConfig* config,
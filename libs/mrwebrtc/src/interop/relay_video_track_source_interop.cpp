@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/relay_video_track_source.h"
+#include "media/remote_video_track.h"
+#include "relay_video_track_source_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsRelayVideoTrackSourceCreate(
+    mrsRemoteVideoTrackHandle remote_track_handle,
+    mrsRelayVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL video track source handle.";
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  auto track = static_cast<RemoteVideoTrack*>(remote_track_handle);
+  if (!track) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL remote video track handle.";
+    return Result::kInvalidNativeHandle;
+  }
+
+  ErrorOr<RefPtr<RelayVideoTrackSource>> result =
+      RelayVideoTrackSource::Create(*track);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create relay video track source.";
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release();
+  return Result::kSuccess;
+}
@@ -5,9 +5,12 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include <cmath>
+
 #include "media/remote_audio_track.h"
 #include "remote_audio_track_interop.h"
 #include "media/audio_track_read_buffer.h"
+#include "media/mixed_audio_read_buffer.h"
 #include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
@@ -21,6 +24,55 @@ mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
   }
 }
 
+mrsResult MRS_CALL mrsRemoteAudioTrackSetFrameAggregationPeriod(
+    mrsRemoteAudioTrackHandle track_handle,
+    int32_t period_ms) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((period_ms < 0) ||
+      (period_ms > AudioFrameObserver::kMaxAggregationPeriodMs)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio frame aggregation period "
+                      << period_ms << " ms.";
+    return Result::kInvalidParameter;
+  }
+  track->SetAggregationPeriod(period_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsRemoteAudioTrackGetAudioLevel(mrsRemoteAudioTrackHandle track_handle,
+                                 mrsAudioLevel* level_out) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!level_out) {
+    return Result::kInvalidParameter;
+  }
+  track->GetAudioLevel(*level_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteAudioTrackRegisterAudioLevelCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    float threshold,
+    mrsAudioLevelCallback callback,
+    void* user_data) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!(threshold >= 0.0f)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio level threshold " << threshold;
+    return Result::kInvalidParameter;
+  }
+  track->SetAudioLevelCallback(AudioLevelChangedCallback{callback, user_data},
+                               threshold);
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsRemoteAudioTrackSetEnabled(mrsRemoteAudioTrackHandle track_handle,
                               mrsBool enabled) noexcept {
@@ -57,6 +109,34 @@ mrsBool MRS_CALL mrsRemoteAudioTrackIsOutputToDevice(
   return mrsBool::kFalse;
 }
 
+mrsResult MRS_CALL
+mrsRemoteAudioTrackSetGain(mrsRemoteAudioTrackHandle track_handle,
+                           float gain,
+                           float pan) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  // Written to reject NaN values too.
+  if (!(gain >= 0.0f) || !std::isfinite(gain) || !(pan >= -1.0f) ||
+      !(pan <= 1.0f)) {
+    return Result::kInvalidParameter;
+  }
+  track->SetGain(gain, pan);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsRemoteAudioTrackSetMuted(mrsRemoteAudioTrackHandle track_handle,
+                            mrsBool muted) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->SetMuted(muted != mrsBool::kFalse);
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsRemoteAudioTrackCreateReadBuffer(mrsRemoteAudioTrackHandle track_handle,
                               mrsAudioTrackReadBufferHandle* audioBufferOut) {
@@ -66,16 +146,97 @@ mrsRemoteAudioTrackCreateReadBuffer(mrsRemoteAudioTrackHandle track_handle,
 
   *audioBufferOut = nullptr;
   if (auto track = static_cast<RemoteAudioTrack*>(track_handle)) {
-    auto buffer = track->CreateReadBuffer();
+    auto buffer = track->CreateReadBuffer(mrsAudioTrackReadBufferOptions{});
     *audioBufferOut = buffer.release();
     return Result::kSuccess;
   }
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsRemoteAudioTrackCreateReadBufferWithOptions(
+    mrsRemoteAudioTrackHandle track_handle,
+    const mrsAudioTrackReadBufferOptions* options,
+    mrsAudioTrackReadBufferHandle* buffer_out) noexcept {
+  if (!buffer_out) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = nullptr;
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const mrsAudioTrackReadBufferOptions opts =
+      (options ? *options : mrsAudioTrackReadBufferOptions{});
+  if ((opts.buffer_ms < 10) ||
+      ((opts.resampling_quality != mrsAudioResamplingQuality::kHigh) &&
+       (opts.resampling_quality != mrsAudioResamplingQuality::kFast) &&
+       (opts.resampling_quality != mrsAudioResamplingQuality::kPassthrough))) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = track->CreateReadBuffer(opts).release();
+  return Result::kSuccess;
+}
+
 #define LOG_INVALID_ARG_IF(...) \
   (__VA_ARGS__) && ((RTC_LOG_F(LS_ERROR) << "Invalid argument: " #__VA_ARGS__), true)
 
+mrsResult MRS_CALL mrsAudioTrackReadBufferCreateForPush(
+    const mrsAudioTrackReadBufferOptions* options,
+    mrsAudioTrackReadBufferHandle* buffer_out) noexcept {
+  if (LOG_INVALID_ARG_IF(!buffer_out)) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = nullptr;
+  const mrsAudioTrackReadBufferOptions opts =
+      (options ? *options : mrsAudioTrackReadBufferOptions{});
+  if (LOG_INVALID_ARG_IF(opts.buffer_ms < 10)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(
+          (opts.resampling_quality != mrsAudioResamplingQuality::kHigh) &&
+          (opts.resampling_quality != mrsAudioResamplingQuality::kFast) &&
+          (opts.resampling_quality !=
+           mrsAudioResamplingQuality::kPassthrough))) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = new AudioTrackReadBuffer(nullptr, nullptr, opts.buffer_ms,
+                                         opts.resampling_quality);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsAudioTrackReadBufferPushFrame(mrsAudioTrackReadBufferHandle buffer,
+                                 const mrsAudioFrame* frame) noexcept {
+  auto stream = static_cast<AudioTrackReadBuffer*>(buffer);
+  if (!stream) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!stream->IsPushBuffer())) {
+    return Result::kInvalidOperation;
+  }
+  if (LOG_INVALID_ARG_IF(!frame)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF((frame->bits_per_sample_ != 8) &&
+                         (frame->bits_per_sample_ != 16))) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF((frame->channel_count_ != 1) &&
+                         (frame->channel_count_ != 2))) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(frame->sampling_rate_hz_ == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(frame->sample_count_ > 0 && !frame->data_)) {
+    return Result::kInvalidParameter;
+  }
+  stream->OnData(frame->data_, (int)frame->bits_per_sample_,
+                 (int)frame->sampling_rate_hz_, frame->channel_count_,
+                 frame->sample_count_);
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
                             int sample_rate,
@@ -85,6 +246,22 @@ mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
                             int num_samples_max,
                             int* num_samples_read_out,
                             mrsBool* has_overrun_out) {
+  const mrsAudioTrackReadBufferOutputFormat format{};
+  return mrsAudioTrackReadBufferReadWithFormat(
+      buffer, sample_rate, num_channels, pad_behavior, &format, samples_out,
+      num_samples_max, num_samples_read_out, has_overrun_out);
+}
+
+mrsResult MRS_CALL mrsAudioTrackReadBufferReadWithFormat(
+    mrsAudioTrackReadBufferHandle buffer,
+    int sample_rate,
+    int num_channels,
+    mrsAudioTrackReadBufferPadBehavior pad_behavior,
+    const mrsAudioTrackReadBufferOutputFormat* format,
+    void* samples_out,
+    int num_samples_max,
+    int* num_samples_read_out,
+    mrsBool* has_overrun_out) noexcept {
   if (!buffer) {
     return Result::kInvalidNativeHandle;
   }
@@ -100,10 +277,25 @@ mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
     return Result::kInvalidParameter;
   }
 
+  if (LOG_INVALID_ARG_IF(!format)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(
+          format->sample_type != mrsAudioTrackReadBufferSampleType::kFloat32 &&
+          format->sample_type != mrsAudioTrackReadBufferSampleType::kInt16)) {
+    return Result::kInvalidParameter;
+  }
+
   if (LOG_INVALID_ARG_IF(num_samples_max < 0)) {
     return Result::kInvalidParameter;
   }
 
+  if (LOG_INVALID_ARG_IF(format->interleaved == mrsBool::kFalse &&
+                         num_samples_max % num_channels != 0)) {
+    return Result::kInvalidParameter;
+  }
+
   if (LOG_INVALID_ARG_IF(num_samples_max > 0 && !samples_out)) {
     return Result::kInvalidParameter;
   }
@@ -118,15 +310,145 @@ mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
 
   auto stream = static_cast<AudioTrackReadBuffer*>(buffer);
   bool has_overrun;
-  stream->Read(sample_rate, num_channels, pad_behavior, samples_out,
-               num_samples_max, num_samples_read_out, &has_overrun);
+  const AudioTrackReadBuffer::OutputFormat output_format{
+      format->sample_type, format->interleaved != mrsBool::kFalse};
+  stream->Read(sample_rate, num_channels, pad_behavior, output_format,
+               samples_out, num_samples_max, num_samples_read_out,
+               &has_overrun);
   *has_overrun_out = has_overrun ? mrsBool::kTrue : mrsBool::kFalse;
   return Result::kSuccess;
 }
 
+mrsResult MRS_CALL mrsAudioTrackReadBufferSetLatencyWindow(
+    mrsAudioTrackReadBufferHandle buffer,
+    const mrsAudioTrackReadBufferLatencyWindow* window) noexcept {
+  auto stream = static_cast<AudioTrackReadBuffer*>(buffer);
+  if (!stream) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!window) {
+    stream->DisableAdaptiveLatency();
+    return Result::kSuccess;
+  }
+  if (LOG_INVALID_ARG_IF(window->min_latency_ms < 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(window->max_latency_ms <= window->min_latency_ms)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(window->max_latency_ms > stream->GetCapacityMs())) {
+    return Result::kInvalidParameter;
+  }
+  stream->EnableAdaptiveLatency(window->min_latency_ms,
+                                window->max_latency_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsAudioTrackReadBufferGetStats(mrsAudioTrackReadBufferHandle buffer,
+                                mrsAudioTrackReadBufferStats* stats) noexcept {
+  auto stream = static_cast<AudioTrackReadBuffer*>(buffer);
+  if (!stream) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!stats)) {
+    return Result::kInvalidParameter;
+  }
+  stream->GetStats(*stats);
+  return Result::kSuccess;
+}
+
 void MRS_CALL
 mrsAudioTrackReadBufferDestroy(mrsAudioTrackReadBufferHandle buffer) {
   if (auto ars = static_cast<AudioTrackReadBuffer*>(buffer)) {
     delete ars;
   }
 }
+
+mrsResult MRS_CALL mrsMixedAudioReadBufferCreate(
+    mrsMixedAudioReadBufferHandle* buffer_out) noexcept {
+  if (LOG_INVALID_ARG_IF(!buffer_out)) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = new MixedAudioReadBuffer();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsMixedAudioReadBufferAddTrack(mrsMixedAudioReadBufferHandle buffer,
+                                mrsRemoteAudioTrackHandle track_handle,
+                                float gain) noexcept {
+  auto mixer = static_cast<MixedAudioReadBuffer*>(buffer);
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!mixer || !track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!std::isfinite(gain))) {
+    return Result::kInvalidParameter;
+  }
+  return mixer->AddTrack(*track, gain);
+}
+
+mrsResult MRS_CALL mrsMixedAudioReadBufferRemoveTrack(
+    mrsMixedAudioReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle) noexcept {
+  auto mixer = static_cast<MixedAudioReadBuffer*>(buffer);
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!mixer || !track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return mixer->RemoveTrack(*track);
+}
+
+mrsResult MRS_CALL
+mrsMixedAudioReadBufferSetTrackGain(mrsMixedAudioReadBufferHandle buffer,
+                                    mrsRemoteAudioTrackHandle track_handle,
+                                    float gain) noexcept {
+  auto mixer = static_cast<MixedAudioReadBuffer*>(buffer);
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!mixer || !track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!std::isfinite(gain))) {
+    return Result::kInvalidParameter;
+  }
+  return mixer->SetTrackGain(*track, gain);
+}
+
+mrsResult MRS_CALL
+mrsMixedAudioReadBufferRead(mrsMixedAudioReadBufferHandle buffer,
+                            int sample_rate,
+                            int num_channels,
+                            float* samples_out,
+                            int num_samples,
+                            mrsBool* has_overrun_out) noexcept {
+  auto mixer = static_cast<MixedAudioReadBuffer*>(buffer);
+  if (!mixer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(sample_rate <= 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(num_channels <= 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(num_samples < 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(num_samples > 0 && !samples_out)) {
+    return Result::kInvalidParameter;
+  }
+  if (LOG_INVALID_ARG_IF(!has_overrun_out)) {
+    return Result::kInvalidParameter;
+  }
+  bool has_overrun;
+  mixer->Read(sample_rate, num_channels, samples_out, num_samples,
+              &has_overrun);
+  *has_overrun_out = has_overrun ? mrsBool::kTrue : mrsBool::kFalse;
+  return Result::kSuccess;
+}
+
+void MRS_CALL
+mrsMixedAudioReadBufferDestroy(mrsMixedAudioReadBufferHandle buffer) noexcept {
+  delete static_cast<MixedAudioReadBuffer*>(buffer);
+}
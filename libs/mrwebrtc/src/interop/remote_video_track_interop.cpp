@@ -5,8 +5,11 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "encoded_frame_recording.h"
 #include "media/remote_video_track.h"
 #include "remote_video_track_interop.h"
+#include "utils.h"
+#include "video_frame_queue.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
@@ -28,6 +31,386 @@ void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameCallback(
   }
 }
 
+void MRS_CALL mrsRemoteVideoTrackRegisterNv12FrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<RemoteVideoTrack*>(trackHandle)) {
+    track->SetCallback(Nv12FrameReadyCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsRemoteVideoTrackRegisterFrameLeaseCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<RemoteVideoTrack*>(trackHandle)) {
+    track->SetCallback(VideoFrameLeaseCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameLeaseCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto track = static_cast<RemoteVideoTrack*>(trackHandle)) {
+    track->SetCallback(Argb32FrameLeaseCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackSetArgb32BufferPoolSize(
+    mrsRemoteVideoTrackHandle trackHandle,
+    int pool_size) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (pool_size <= 0) {
+    return Result::kInvalidParameter;
+  }
+  track->SetArgbBufferPoolSize(pool_size);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackSetFrameDeliveryOptions(
+    mrsRemoteVideoTrackHandle trackHandle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!options || !VideoFrameObserver::IsValidDeliveryOptions(*options)) {
+    return Result::kInvalidParameter;
+  }
+  track->SetDeliveryOptions(*options);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackAddI420AFrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(I420AFrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackAddArgb32FrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(Argb32FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackAddNv12FrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      track->AddSubscriber(Nv12FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackAddFrameQueueSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameQueueHandle queue_handle,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  auto queue = static_cast<VideoFrameQueue*>(queue_handle);
+  if (!track || !queue) {
+    return Result::kInvalidNativeHandle;
+  }
+  *subscriber_id_out = track->AddSubscriber(queue->GetCallback());
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackRemoveFrameSubscriber(
+    mrsRemoteVideoTrackHandle trackHandle,
+    uint64_t subscriber_id) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!track->RemoveSubscriber(subscriber_id)) {
+    return Result::kNotFound;
+  }
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackGetLatencyStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameLatencyStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const LatencySummary summary = track->GetLatencySummary();
+  stats_out->sample_count = summary.sample_count_;
+  stats_out->p50_ms = summary.p50_ms_;
+  stats_out->p95_ms = summary.p95_ms_;
+  stats_out->p99_ms = summary.p99_ms_;
+  stats_out->max_ms = summary.max_ms_;
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackResetLatencyStats(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->ResetLatencyStats();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackSetLatencyMarkerDecoding(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsBool enabled) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->SetLatencyMarkerDecoding(enabled != mrsBool::kFalse);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackGetLatencyMarkerStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoLatencyMarkerStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const LatencyMarkerStats stats = track->GetLatencyMarkerStats();
+  stats_out->decoded_count = stats.decoded_count_;
+  stats_out->missing_count = stats.missing_count_;
+  stats_out->latency.sample_count = stats.latency_.sample_count_;
+  stats_out->latency.p50_ms = stats.latency_.p50_ms_;
+  stats_out->latency.p95_ms = stats.latency_.p95_ms_;
+  stats_out->latency.p99_ms = stats.latency_.p99_ms_;
+  stats_out->latency.max_ms = stats.latency_.max_ms_;
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackGetLayerStats(mrsRemoteVideoTrackHandle trackHandle,
+                                 mrsVideoLayerStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  std::shared_ptr<EncodedFrameTap> tap = track->GetEncodedFrameTap();
+  if (!tap) {
+    return Result::kUnsupported;
+  }
+  *stats_out = tap->GetLayerStats();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackGetFrameTimingStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameTimingStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const FrameTimingSummary summary = track->GetFrameTimingSummary();
+  stats_out->frame_count = summary.frame_count_;
+  stats_out->framerate_1s = summary.framerate_1s_;
+  stats_out->framerate_10s = summary.framerate_window_;
+  stats_out->inter_arrival.sample_count = summary.inter_arrival_.sample_count_;
+  stats_out->inter_arrival.p50_ms = summary.inter_arrival_.p50_ms_;
+  stats_out->inter_arrival.p95_ms = summary.inter_arrival_.p95_ms_;
+  stats_out->inter_arrival.p99_ms = summary.inter_arrival_.p99_ms_;
+  stats_out->inter_arrival.max_ms = summary.inter_arrival_.max_ms_;
+  stats_out->freeze_count = summary.freeze_count_;
+  stats_out->total_freeze_duration_ms = summary.total_freeze_duration_ms_;
+  stats_out->pause_count = summary.pause_count_;
+  stats_out->total_pause_duration_ms = summary.total_pause_duration_ms_;
+  stats_out->ms_since_last_frame = summary.time_since_last_frame_ms_;
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackResetFrameTimingStats(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->ResetFrameTimingStats();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackSetAsyncFrameDelivery(mrsRemoteVideoTrackHandle trackHandle,
+                                         mrsBool enabled) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  track->SetAsyncDelivery(enabled != mrsBool::kFalse);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackGetFrameDeliveryStats(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsVideoFrameDeliveryStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  stats_out->async_replaced_count = track->GetAsyncDroppedFrameCount();
+  stats_out->overlap_dropped_count = track->GetOverlapDroppedFrameCount();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsEncodedVideoFrameCallback callback,
+    void* user_data) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetEncodedFrameCallback(
+      EncodedVideoFrameCallback{callback, user_data});
+}
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackSetDecodingEnabled(mrsRemoteVideoTrackHandle trackHandle,
+                                      mrsBool enabled) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetDecodingEnabled(enabled != mrsBool::kFalse);
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackSetLowPriorityDecoding(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsBool low_priority) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetLowPriorityDecoding(low_priority != mrsBool::kFalse);
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackRequestKeyFrame(
+    mrsRemoteVideoTrackHandle trackHandle) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->RequestKeyFrame();
+}
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackStartRecording(mrsRemoteVideoTrackHandle trackHandle,
+                                  const char* path) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->StartRecording(path);
+}
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackStopRecording(mrsRemoteVideoTrackHandle trackHandle,
+                                 uint32_t* frame_count_out) noexcept {
+  auto track = static_cast<RemoteVideoTrack*>(trackHandle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  const uint32_t frame_count = track->StopRecording();
+  if (frame_count_out) {
+    *frame_count_out = frame_count;
+  }
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsReplayEncodedVideo(const mrsEncodedVideoReplayConfig* config,
+                      mrsEncodedVideoReplayStats* stats_out) noexcept {
+  if (!config || IsStringNullOrEmpty(config->path)) {
+    return Result::kInvalidParameter;
+  }
+  VideoFrameObserver observer;
+  if (config->i420a_callback) {
+    observer.SetCallback(I420AFrameReadyCallback{config->i420a_callback,
+                                                 config->i420a_user_data});
+  }
+  if (config->argb32_callback) {
+    observer.SetCallback(Argb32FrameReadyCallback{config->argb32_callback,
+                                                  config->argb32_user_data});
+  }
+  mrsEncodedVideoReplayStats stats{};
+  const Result result = ReplayEncodedFrames(
+      config->path, config->recorded_pacing != mrsBool::kFalse, observer,
+      stats);
+  if (stats_out) {
+    *stats_out = stats;
+  }
+  return result;
+}
+
 mrsResult MRS_CALL
 mrsRemoteVideoTrackSetEnabled(mrsRemoteVideoTrackHandle track_handle,
                               mrsBool enabled) noexcept {
@@ -11,6 +11,7 @@
 #include "media/remote_video_track.h"
 #include "media/transceiver.h"
 #include "transceiver_interop.h"
+#include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
@@ -43,6 +44,92 @@ mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL
+mrsTransceiverSetSubscribed(mrsTransceiverHandle transceiver_handle,
+                            mrsBool subscribed) noexcept {
+  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+    return transceiver->SetSubscribed(subscribed != mrsBool::kFalse);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsTransceiverSetEncodingParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsRtpEncodingParameters* encodings,
+    int count) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((count < 0) || ((count > 0) && !encodings)) {
+    return Result::kInvalidParameter;
+  }
+  return transceiver->SetEncodingParameters(encodings, count);
+}
+
+mrsResult MRS_CALL mrsTransceiverSetDegradationPreference(
+    mrsTransceiverHandle transceiver_handle,
+    mrsDegradationPreference preference) noexcept {
+  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+    return transceiver->SetDegradationPreference(preference);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsTransceiverSetCodecPreferences(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsCodecPreference* codecs,
+    uint32_t count) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!codecs && (count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  std::vector<SdpCodecPreference> preferences(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (IsStringNullOrEmpty(codecs[i].name)) {
+      return Result::kInvalidParameter;
+    }
+    preferences[i].name = codecs[i].name;
+    if (!IsStringNullOrEmpty(codecs[i].params)) {
+      SdpParseCodecParameters(codecs[i].params, preferences[i].params);
+    }
+  }
+  return transceiver->SetCodecPreferences(std::move(preferences));
+}
+
+mrsResult MRS_CALL mrsTransceiverSetAudioCodecOptions(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsAudioCodecOptions* options) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!options) {
+    return Result::kInvalidParameter;
+  }
+  return transceiver->SetAudioCodecOptions(*options);
+}
+
+mrsResult MRS_CALL mrsTransceiverSubscribeQualityLimitation(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsQualityLimitationConfig* config,
+    mrsQualityLimitationCallback callback,
+    void* user_data) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (callback && (!config || (config->interval_ms <= 0))) {
+    return Result::kInvalidParameter;
+  }
+  return transceiver->SubscribeQualityLimitation(
+      config ? *config : mrsQualityLimitationConfig{},
+      QualityLimitationCallback{callback, user_data});
+}
+
 mrsResult MRS_CALL mrsTransceiverSetLocalAudioTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalAudioTrackHandle track_handle) noexcept {
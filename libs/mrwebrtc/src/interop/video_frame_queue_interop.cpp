@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "video_frame_queue.h"
+#include "video_frame_queue_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL
+mrsVideoFrameQueueCreate(uint32_t depth,
+                         mrsVideoFrameQueueHandle* queue_handle_out) noexcept {
+  if (!queue_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *queue_handle_out = nullptr;
+  if ((depth < 1) || (depth > VideoFrameQueue::kMaxDepth)) {
+    return Result::kOutOfRange;
+  }
+  *queue_handle_out = new VideoFrameQueue(depth);
+  return Result::kSuccess;
+}
+
+void MRS_CALL
+mrsVideoFrameQueueDestroy(mrsVideoFrameQueueHandle queue_handle) noexcept {
+  delete static_cast<VideoFrameQueue*>(queue_handle);
+}
+
+mrsResult MRS_CALL
+mrsVideoFrameQueueTryDequeue(mrsVideoFrameQueueHandle queue_handle,
+                             mrsVideoFrameLease* lease_out) noexcept {
+  if (!lease_out) {
+    return Result::kInvalidParameter;
+  }
+  *lease_out = mrsVideoFrameLease{};
+  auto queue = static_cast<VideoFrameQueue*>(queue_handle);
+  if (!queue) {
+    return Result::kInvalidNativeHandle;
+  }
+  return (queue->TryDequeue(*lease_out) ? Result::kSuccess
+                                        : Result::kNotFound);
+}
+
+mrsResult MRS_CALL
+mrsVideoFrameQueueGetStats(mrsVideoFrameQueueHandle queue_handle,
+                           mrsVideoFrameQueueStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto queue = static_cast<VideoFrameQueue*>(queue_handle);
+  if (!queue) {
+    return Result::kInvalidNativeHandle;
+  }
+  const VideoFrameQueueStats stats = queue->GetStats();
+  stats_out->enqueued_count = stats.enqueued_count_;
+  stats_out->dequeued_count = stats.dequeued_count_;
+  stats_out->dropped_count = stats.dropped_count_;
+  stats_out->queued_count = stats.queued_count_;
+  mrsVideoFrameLatencyStats& latency = stats_out->queue_latency;
+  latency.sample_count = stats.queue_latency_.sample_count_;
+  latency.p50_ms = stats.queue_latency_.p50_ms_;
+  latency.p95_ms = stats.queue_latency_.p95_ms_;
+  latency.p99_ms = stats.queue_latency_.p99_ms_;
+  latency.max_ms = stats.queue_latency_.max_ms_;
+  return Result::kSuccess;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "video_texture_uploader.h"
+#include "video_texture_uploader_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsVideoTextureUploaderCreate(
+    mrsVideoFrameQueueHandle queue_handle,
+    mrsVideoTextureApi api,
+    mrsVideoTextureUploaderHandle* uploader_handle_out) noexcept {
+  if (!uploader_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *uploader_handle_out = nullptr;
+  auto queue = static_cast<VideoFrameQueue*>(queue_handle);
+  if (!queue) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!VideoTextureUploader::IsApiSupported(api)) {
+    return Result::kUnsupported;
+  }
+  *uploader_handle_out = new VideoTextureUploader(*queue, api);
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsVideoTextureUploaderDestroy(
+    mrsVideoTextureUploaderHandle uploader_handle) noexcept {
+  delete static_cast<VideoTextureUploader*>(uploader_handle);
+}
+
+mrsResult MRS_CALL mrsVideoTextureUploaderSetTextures(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    const mrsVideoTextures* textures) noexcept {
+  auto uploader = static_cast<VideoTextureUploader*>(uploader_handle);
+  if (!uploader) {
+    return Result::kInvalidNativeHandle;
+  }
+  return uploader->SetTextures(textures);
+}
+
+mrsResult MRS_CALL mrsVideoTextureUploaderGetRenderEvent(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    mrsVideoTextureRenderEventCallback* callback_out,
+    int32_t* event_id_out) noexcept {
+  if (!callback_out || !event_id_out) {
+    return Result::kInvalidParameter;
+  }
+  auto uploader = static_cast<VideoTextureUploader*>(uploader_handle);
+  if (!uploader) {
+    return Result::kInvalidNativeHandle;
+  }
+  *callback_out = &VideoTextureUploader::OnRenderEvent;
+  *event_id_out = uploader->event_id();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTextureUploaderGetStats(
+    mrsVideoTextureUploaderHandle uploader_handle,
+    mrsVideoTextureUploaderStats* stats_out) noexcept {
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  auto uploader = static_cast<VideoTextureUploader*>(uploader_handle);
+  if (!uploader) {
+    return Result::kInvalidNativeHandle;
+  }
+  *stats_out = uploader->GetStats();
+  return Result::kSuccess;
+}
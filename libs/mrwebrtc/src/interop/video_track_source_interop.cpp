@@ -6,6 +6,7 @@
 #include "pch.h"
 
 #include "media/video_track_source.h"
+#include "video_frame_queue.h"
 #include "video_track_source_interop.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
@@ -17,7 +18,10 @@ void MRS_CALL mrsVideoTrackSourceRegisterFrameCallback(
   if (auto source = static_cast<VideoTrackSource*>(source_handle)) {
     RTC_DCHECK(
         (source->GetObjectType() == ObjectType::kDeviceVideoTrackSource) ||
-        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource));
+        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kRelayVideoTrackSource) ||
+        (source->GetObjectType() ==
+         ObjectType::kExternalEncodedVideoTrackSource));
     source->SetCallback(I420AFrameReadyCallback{callback, user_data});
   }
 }
@@ -32,7 +36,190 @@ void MRS_CALL mrsVideoTrackSourceRegisterArgb32FrameCallback(
   if (auto source = static_cast<VideoTrackSource*>(source_handle)) {
     RTC_DCHECK(
         (source->GetObjectType() == ObjectType::kDeviceVideoTrackSource) ||
-        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource));
+        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kRelayVideoTrackSource) ||
+        (source->GetObjectType() ==
+         ObjectType::kExternalEncodedVideoTrackSource));
     source->SetCallback(Argb32FrameReadyCallback{callback, user_data});
   }
 }
+
+void MRS_CALL mrsVideoTrackSourceRegisterNv12FrameCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto source = static_cast<VideoTrackSource*>(source_handle)) {
+    RTC_DCHECK(
+        (source->GetObjectType() == ObjectType::kDeviceVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kRelayVideoTrackSource) ||
+        (source->GetObjectType() ==
+         ObjectType::kExternalEncodedVideoTrackSource));
+    source->SetCallback(Nv12FrameReadyCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsVideoTrackSourceRegisterFrameLeaseCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsVideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto source = static_cast<VideoTrackSource*>(source_handle)) {
+    RTC_DCHECK(
+        (source->GetObjectType() == ObjectType::kDeviceVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kRelayVideoTrackSource) ||
+        (source->GetObjectType() ==
+         ObjectType::kExternalEncodedVideoTrackSource));
+    source->SetCallback(VideoFrameLeaseCallback{callback, user_data});
+  }
+}
+
+void MRS_CALL mrsVideoTrackSourceRegisterArgb32FrameLeaseCallback(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsArgb32VideoFrameLeaseCallback callback,
+    void* user_data) noexcept {
+  if (auto source = static_cast<VideoTrackSource*>(source_handle)) {
+    RTC_DCHECK(
+        (source->GetObjectType() == ObjectType::kDeviceVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kExternalVideoTrackSource) ||
+        (source->GetObjectType() == ObjectType::kRelayVideoTrackSource) ||
+        (source->GetObjectType() ==
+         ObjectType::kExternalEncodedVideoTrackSource));
+    source->SetCallback(Argb32FrameLeaseCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceSetArgb32BufferPoolSize(
+    mrsVideoTrackSourceHandle source_handle,
+    int pool_size) noexcept {
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (pool_size <= 0) {
+    return Result::kInvalidParameter;
+  }
+  source->SetArgbBufferPoolSize(pool_size);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceSetFrameDeliveryOptions(
+    mrsVideoTrackSourceHandle source_handle,
+    const mrsVideoFrameDeliveryOptions* options) noexcept {
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!options || !VideoFrameObserver::IsValidDeliveryOptions(*options)) {
+    return Result::kInvalidParameter;
+  }
+  source->SetDeliveryOptions(*options);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceAddI420AFrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsI420AVideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      source->AddSubscriber(I420AFrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceAddArgb32FrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsArgb32VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      source->AddSubscriber(Argb32FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceAddNv12FrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out =
+      source->AddSubscriber(Nv12FrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceAddFrameQueueSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsVideoFrameQueueHandle queue_handle,
+    uint64_t* subscriber_id_out) noexcept {
+  if (!subscriber_id_out) {
+    return Result::kInvalidParameter;
+  }
+  *subscriber_id_out = 0;
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  auto queue = static_cast<VideoFrameQueue*>(queue_handle);
+  if (!source || !queue) {
+    return Result::kInvalidNativeHandle;
+  }
+  *subscriber_id_out = source->AddSubscriber(queue->GetCallback());
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceSetAsyncSinkUpdates(
+    mrsVideoTrackSourceHandle source_handle,
+    mrsBool enabled,
+    mrsVideoTrackSourceSinkUpdatedCallback callback,
+    void* user_data) noexcept {
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  source->SetAsyncSinkUpdates(enabled != mrsBool::kFalse,
+                              SinkUpdatedCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsVideoTrackSourceRemoveFrameSubscriber(
+    mrsVideoTrackSourceHandle source_handle,
+    uint64_t subscriber_id) noexcept {
+  auto source = static_cast<VideoTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!source->RemoveSubscriber(subscriber_id)) {
+    return Result::kNotFound;
+  }
+  return Result::kSuccess;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "latency_histogram.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void LatencyHistogram::Record(int64_t latency_us) noexcept {
+  if (latency_us < 0) {
+    return;
+  }
+  const int64_t index =
+      std::min<int64_t>(latency_us / 1000, kBucketCount - 1);
+  buckets_[static_cast<size_t>(index)].fetch_add(1, std::memory_order_relaxed);
+  int64_t max_us = max_us_.load(std::memory_order_relaxed);
+  while ((latency_us > max_us) &&
+         !max_us_.compare_exchange_weak(max_us, latency_us,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+LatencySummary LatencyHistogram::GetSummary() const noexcept {
+  std::array<uint32_t, kBucketCount> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  LatencySummary summary;
+  summary.sample_count_ = total;
+  if (total == 0) {
+    return summary;
+  }
+  summary.max_ms_ = max_us_.load(std::memory_order_relaxed) / 1000.0;
+
+  // Report the upper bound of the bucket containing each percentile, capped
+  // by the maximum since the last bucket is unbounded.
+  const uint64_t p50_rank = (total * 50 + 99) / 100;
+  const uint64_t p95_rank = (total * 95 + 99) / 100;
+  const uint64_t p99_rank = (total * 99 + 99) / 100;
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    const uint64_t prev = cumulative;
+    cumulative += counts[i];
+    const double upper_ms = std::min<double>(i + 1.0, summary.max_ms_);
+    if ((prev < p50_rank) && (cumulative >= p50_rank)) {
+      summary.p50_ms_ = upper_ms;
+    }
+    if ((prev < p95_rank) && (cumulative >= p95_rank)) {
+      summary.p95_ms_ = upper_ms;
+    }
+    if ((prev < p99_rank) && (cumulative >= p99_rank)) {
+      summary.p99_ms_ = upper_ms;
+      break;
+    }
+  }
+  return summary;
+}
+
+void LatencyHistogram::Reset() noexcept {
+  for (auto&& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  max_us_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Summary of the latency samples recorded by a |LatencyHistogram|.
+struct LatencySummary {
+  /// Number of samples recorded.
+  uint64_t sample_count_ = 0;
+
+  /// Median latency, in milliseconds.
+  double p50_ms_ = 0.0;
+
+  /// 95th percentile latency, in milliseconds.
+  double p95_ms_ = 0.0;
+
+  /// 99th percentile latency, in milliseconds.
+  double p99_ms_ = 0.0;
+
+  /// Maximum latency, in milliseconds.
+  double max_ms_ = 0.0;
+};
+
+/// Fixed-size histogram of latency samples with a 1 millisecond resolution,
+/// for reporting percentiles. Recording a sample is lock-free and wait-free,
+/// so that it can be done on a per-frame path; reading the summary may run
+/// concurrently with recording, and then returns an approximate result.
+class LatencyHistogram {
+ public:
+  /// Number of buckets. The last bucket collects all samples at or above
+  /// (kBucketCount - 1) milliseconds.
+  static constexpr int kBucketCount = 1000;
+
+  LatencyHistogram() noexcept { Reset(); }
+
+  /// Record a latency sample, in microseconds. Negative samples, which can
+  /// result from unsynchronized clocks, are ignored.
+  void Record(int64_t latency_us) noexcept;
+
+  /// Get the percentiles of the samples recorded since the last reset.
+  LatencySummary GetSummary() const noexcept;
+
+  /// Discard all samples recorded so far.
+  void Reset() noexcept;
+
+ private:
+  std::array<std::atomic<uint32_t>, kBucketCount> buckets_;
+  std::atomic<int64_t> max_us_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "latency_marker.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Number of cells per row of the marker grid.
+constexpr int kColumnCount = 16;
+
+/// Number of bytes of a marker: one header byte, the 4-byte frame number, the
+/// 8-byte capture time, and one checksum byte.
+constexpr int kByteCount = 14;
+
+/// Number of rows of the marker grid, with one bit per cell.
+constexpr int kRowCount = (kByteCount * 8 + kColumnCount - 1) / kColumnCount;
+
+/// Fraction of the frame width covered by a cell.
+constexpr double kCellsPerWidth = 4.0 * kColumnCount;
+
+/// Value of the header byte, and initial value of the checksum.
+constexpr uint8_t kHeader = 0xA5;
+
+/// Luma of the cells of 0 and 1 bits, within the video range.
+constexpr uint8_t kBlack = 16;
+constexpr uint8_t kWhite = 235;
+
+/// Luma threshold between a 0 and a 1 bit.
+constexpr int kThreshold = (kBlack + kWhite) / 2;
+
+/// Start offset in pixels of cell |index| with size |cell_size|.
+int CellStart(int index, double cell_size) noexcept {
+  return static_cast<int>(std::lround(index * cell_size));
+}
+
+uint8_t Checksum(const uint8_t* bytes, int count) noexcept {
+  uint8_t checksum = kHeader;
+  for (int i = 0; i < count; ++i) {
+    // Rotate to catch swapped bytes, which a plain XOR would not
+    checksum = static_cast<uint8_t>((checksum << 1) | (checksum >> 7));
+    checksum ^= bytes[i];
+  }
+  return checksum;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+constexpr int LatencyMarkerCodec::kMinWidth;
+
+bool LatencyMarkerCodec::Write(const LatencyMarker& marker,
+                               uint8_t* ydata,
+                               int ystride,
+                               uint8_t* udata,
+                               int ustride,
+                               uint8_t* vdata,
+                               int vstride,
+                               int width,
+                               int height) noexcept {
+  const double cell_size = width / kCellsPerWidth;
+  const int marker_width = CellStart(kColumnCount, cell_size);
+  const int marker_height = CellStart(kRowCount, cell_size);
+  if ((width < kMinWidth) || (height < marker_height)) {
+    return false;
+  }
+
+  uint8_t bytes[kByteCount];
+  bytes[0] = kHeader;
+  for (int i = 0; i < 4; ++i) {
+    bytes[1 + i] = static_cast<uint8_t>(marker.frame_number_ >> (8 * i));
+  }
+  const uint64_t time = static_cast<uint64_t>(marker.capture_time_utc_us_);
+  for (int i = 0; i < 8; ++i) {
+    bytes[5 + i] = static_cast<uint8_t>(time >> (8 * i));
+  }
+  bytes[kByteCount - 1] = Checksum(bytes, kByteCount - 1);
+
+  for (int bit = 0; bit < kRowCount * kColumnCount; ++bit) {
+    const bool set = (bit < kByteCount * 8) &&
+                     ((bytes[bit / 8] >> (7 - bit % 8)) & 0x1);
+    const int row = bit / kColumnCount;
+    const int column = bit % kColumnCount;
+    const int x0 = CellStart(column, cell_size);
+    const int x1 = CellStart(column + 1, cell_size);
+    const int y0 = CellStart(row, cell_size);
+    const int y1 = CellStart(row + 1, cell_size);
+    for (int y = y0; y < y1; ++y) {
+      std::fill(ydata + y * ystride + x0, ydata + y * ystride + x1,
+                set ? kWhite : kBlack);
+    }
+  }
+  const int chroma_width = (marker_width + 1) / 2;
+  for (int y = 0; y < (marker_height + 1) / 2; ++y) {
+    std::fill_n(udata + y * ustride, chroma_width, 128);
+    std::fill_n(vdata + y * vstride, chroma_width, 128);
+  }
+  return true;
+}
+
+bool LatencyMarkerCodec::Read(const uint8_t* ydata,
+                              int ystride,
+                              int width,
+                              int height,
+                              LatencyMarker& marker) noexcept {
+  const double cell_size = width / kCellsPerWidth;
+  if ((width < kMinWidth / 2) ||
+      (height < CellStart(kRowCount, cell_size))) {
+    return false;
+  }
+
+  // Average the center of each cell, away from the edges blurred by scaling
+  // and compression.
+  uint8_t bytes[kByteCount]{};
+  for (int bit = 0; bit < kByteCount * 8; ++bit) {
+    const int row = bit / kColumnCount;
+    const int column = bit % kColumnCount;
+    const int x0 = static_cast<int>((column + 0.25) * cell_size);
+    const int x1 =
+        std::max(x0 + 1, static_cast<int>((column + 0.75) * cell_size));
+    const int y0 = static_cast<int>((row + 0.25) * cell_size);
+    const int y1 =
+        std::max(y0 + 1, static_cast<int>((row + 0.75) * cell_size));
+    int sum = 0;
+    for (int y = y0; y < y1; ++y) {
+      const uint8_t* const line = ydata + y * ystride;
+      for (int x = x0; x < x1; ++x) {
+        sum += line[x];
+      }
+    }
+    if (sum > kThreshold * (x1 - x0) * (y1 - y0)) {
+      bytes[bit / 8] |= static_cast<uint8_t>(0x80 >> (bit % 8));
+    }
+  }
+  if ((bytes[0] != kHeader) ||
+      (bytes[kByteCount - 1] != Checksum(bytes, kByteCount - 1))) {
+    return false;
+  }
+
+  uint32_t frame_number = 0;
+  for (int i = 0; i < 4; ++i) {
+    frame_number |= static_cast<uint32_t>(bytes[1 + i]) << (8 * i);
+  }
+  uint64_t time = 0;
+  for (int i = 0; i < 8; ++i) {
+    time |= static_cast<uint64_t>(bytes[5 + i]) << (8 * i);
+  }
+  marker.frame_number_ = frame_number;
+  marker.capture_time_utc_us_ = static_cast<int64_t>(time);
+  return true;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
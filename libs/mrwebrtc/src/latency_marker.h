@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Machine-readable marker stamped into the pixels of a video frame, to
+/// measure the end-to-end latency of the frame from its capture on the sender
+/// to its delivery on the receiver, including encoding, network, and decoding.
+struct LatencyMarker {
+  /// Sequence number of the frame on the sender, to detect missing frames.
+  uint32_t frame_number_ = 0;
+
+  /// Capture time of the frame, in microseconds in the UTC clock of the
+  /// sender, as returned by |rtc::TimeUTCMicros()|.
+  int64_t capture_time_utc_us_ = 0;
+};
+
+/// Encoding of a |LatencyMarker| into the luma plane of a frame, as a grid of
+/// black and white cells in its top-left corner, with a header and a checksum
+/// to tell a marker from arbitrary content. The cell size is proportional to
+/// the frame width, so that the marker survives downscaling by the encoder as
+/// long as the aspect ratio is preserved, and each cell is large enough to
+/// survive lossy compression. The marker occupies a quarter of the frame width.
+class LatencyMarkerCodec {
+ public:
+  /// Minimum frame width, in pixels, to fit a marker.
+  static constexpr int kMinWidth = 128;
+
+  /// Write a marker into the planes of an I420 frame, overwriting its content.
+  /// The chroma of the marker area is neutralized, so that the marker reads as
+  /// gray levels regardless of the frame content. Return |false| if the frame
+  /// is too small to fit a marker.
+  static bool Write(const LatencyMarker& marker,
+                    uint8_t* ydata,
+                    int ystride,
+                    uint8_t* udata,
+                    int ustride,
+                    uint8_t* vdata,
+                    int vstride,
+                    int width,
+                    int height) noexcept;
+
+  /// Read a marker from the luma plane of a frame. Return |false| if the frame
+  /// contains no valid marker.
+  static bool Read(const uint8_t* ydata,
+                   int ystride,
+                   int width,
+                   int height,
+                   LatencyMarker& marker) noexcept;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,298 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "log_sink.h"
+#include "utils.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Maximum length of a module name. Longer names are truncated.
+constexpr const size_t kMaxModuleLength = 63;
+
+rtc::LoggingSeverity ToSeverity(mrsLogLevel level) noexcept {
+  switch (level) {
+    case mrsLogLevel::kVerbose:
+      return rtc::LS_VERBOSE;
+    case mrsLogLevel::kInfo:
+      return rtc::LS_INFO;
+    case mrsLogLevel::kWarning:
+      return rtc::LS_WARNING;
+    case mrsLogLevel::kError:
+      return rtc::LS_ERROR;
+    default:
+      return rtc::LS_NONE;
+  }
+}
+
+mrsLogLevel ToLogLevel(rtc::LoggingSeverity severity) noexcept {
+  switch (severity) {
+    case rtc::LS_VERBOSE:
+      return mrsLogLevel::kVerbose;
+    case rtc::LS_INFO:
+      return mrsLogLevel::kInfo;
+    case rtc::LS_WARNING:
+      return mrsLogLevel::kWarning;
+    default:
+      return mrsLogLevel::kError;
+  }
+}
+
+char LevelLetter(mrsLogLevel level) noexcept {
+  switch (level) {
+    case mrsLogLevel::kVerbose:
+      return 'V';
+    case mrsLogLevel::kInfo:
+      return 'I';
+    case mrsLogLevel::kWarning:
+      return 'W';
+    default:
+      return 'E';
+  }
+}
+
+/// Find the module of a message, from the "(file.cc:123): " prefix WebRTC
+/// writes before the text of the messages logged with a file name. Return an
+/// empty range if the message has no such prefix.
+void FindModule(const std::string& message,
+                size_t* offset,
+                size_t* length) noexcept {
+  *offset = 0;
+  *length = 0;
+  const size_t open = message.find('(');
+  if (open == std::string::npos) {
+    return;
+  }
+  const size_t close = message.find("): ", open);
+  const size_t colon = message.find(':', open);
+  if ((close == std::string::npos) || (colon >= close)) {
+    return;
+  }
+  const size_t dot = message.find('.', open);
+  const size_t end = std::min(dot, colon);
+  *offset = open + 1;
+  *length = std::min(end - *offset, kMaxModuleLength);
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ErrorOr<std::unique_ptr<AsyncLogSink>> AsyncLogSink::Create(
+    const mrsLogSinkConfig& config) noexcept {
+  if ((config.capacity == 0) || (config.flush_interval_ms <= 0) ||
+      ((int)config.level < 0) || (config.level > mrsLogLevel::kNone) ||
+      (IsStringNullOrEmpty(config.file_path) && !config.callback)) {
+    return Error(Result::kInvalidParameter);
+  }
+  std::unique_ptr<webrtc::FileWrapper> file;
+  if (!IsStringNullOrEmpty(config.file_path)) {
+    file.reset(webrtc::FileWrapper::Create());
+    if (!file->OpenFile(config.file_path, /* read_only = */ false)) {
+      return Error(Result::kNotFound);
+    }
+  }
+  return std::unique_ptr<AsyncLogSink>(
+      new AsyncLogSink(config, std::move(file)));
+}
+
+AsyncLogSink::AsyncLogSink(const mrsLogSinkConfig& config,
+                           std::unique_ptr<webrtc::FileWrapper> file) noexcept
+    : file_(std::move(file)),
+      callback_(config.callback),
+      user_data_(config.user_data),
+      flush_interval_ms_(config.flush_interval_ms),
+      slots_(config.capacity) {
+  const mrsLogLevel level = config.level;
+  levels_.Update([level](Levels& levels) { levels.default_level = level; });
+  thread_ = std::thread([this]() { FlushLoop(); });
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_cv_.notify_one();
+  thread_.join();
+  if (file_) {
+    file_->CloseFile();
+  }
+}
+
+rtc::LoggingSeverity AsyncLogSink::min_severity() const noexcept {
+  RcuSnapshot<Levels>::ReadScope levels(levels_);
+  mrsLogLevel level = levels->default_level;
+  for (const auto& module : levels->modules) {
+    level = std::min(level, module.second);
+  }
+  return ToSeverity(level);
+}
+
+void AsyncLogSink::SetLevel(const char* module, mrsLogLevel level) noexcept {
+  levels_.Update([module, level](Levels& levels) {
+    if (!module) {
+      levels.default_level = level;
+      return;
+    }
+    auto it = std::find_if(
+        levels.modules.begin(), levels.modules.end(),
+        [module](const std::pair<std::string, mrsLogLevel>& entry) {
+          return (entry.first == module);
+        });
+    if (it != levels.modules.end()) {
+      it->second = level;
+      return;
+    }
+    levels.modules.emplace_back(module, level);
+    std::stable_sort(levels.modules.begin(), levels.modules.end(),
+                     [](const std::pair<std::string, mrsLogLevel>& lhs,
+                        const std::pair<std::string, mrsLogLevel>& rhs) {
+                       return (lhs.first.size() > rhs.first.size());
+                     });
+  });
+}
+
+mrsLogLevel AsyncLogSink::GetModuleLevel(const char* module,
+                                         size_t length) const noexcept {
+  RcuSnapshot<Levels>::ReadScope levels(levels_);
+  for (const auto& entry : levels->modules) {
+    if ((entry.first.size() <= length) &&
+        (memcmp(entry.first.data(), module, entry.first.size()) == 0)) {
+      return entry.second;
+    }
+  }
+  return levels->default_level;
+}
+
+void AsyncLogSink::Flush() noexcept {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const uint64_t request = ++flush_requests_;
+  wake_cv_.notify_one();
+  flushed_cv_.wait(lock, [this, request]() {
+    return (flushes_done_ >= request);
+  });
+}
+
+mrsLogSinkStats AsyncLogSink::GetStats() const noexcept {
+  mrsLogSinkStats stats{};
+  stats.written_count = written_count_.load(std::memory_order_relaxed);
+  stats.dropped_count = dropped_count_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void AsyncLogSink::OnLogMessage(const std::string& message) {
+  OnLogMessage(message, rtc::LS_INFO, nullptr);
+}
+
+void AsyncLogSink::OnLogMessage(const std::string& message,
+                                rtc::LoggingSeverity severity,
+                                const char* /*tag*/) {
+  // Sensitive messages may hold secrets, and are never written.
+  if (severity < rtc::LS_VERBOSE) {
+    return;
+  }
+  const mrsLogLevel level = ToLogLevel(severity);
+  size_t module_offset;
+  size_t module_length;
+  FindModule(message, &module_offset, &module_length);
+  if (level < GetModuleLevel(message.data() + module_offset, module_length)) {
+    return;
+  }
+
+  const size_t write_index = write_index_.load(std::memory_order_relaxed);
+  const size_t read_index = read_index_.load(std::memory_order_acquire);
+  const size_t count = write_index - read_index;
+  if (count >= slots_.size()) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Slot& slot = slots_[write_index % slots_.size()];
+  size_t length = message.size();
+  while ((length > 0) && (message[length - 1] == '\n')) {
+    --length;
+  }
+  length = std::min(length, kMaxMessageLength - 1);
+  slot.timestamp_ms = rtc::TimeUTCMicros() / 1000;
+  slot.level = level;
+  slot.module_offset = (uint16_t)std::min(module_offset, length);
+  slot.module_length =
+      (uint16_t)std::min(module_length, length - slot.module_offset);
+  slot.length = (uint16_t)length;
+  memcpy(slot.text, message.data(), length);
+  slot.text[length] = '\0';
+  write_index_.store(write_index + 1, std::memory_order_release);
+
+  // Wake up the background thread early, once, before the ring fills up.
+  if (count + 1 == (slots_.size() + 1) / 2) {
+    wake_cv_.notify_one();
+  }
+}
+
+void AsyncLogSink::FlushLoop() noexcept {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (!stopping_ && (flush_requests_ == flushes_done_)) {
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_));
+    }
+    const uint64_t requests = flush_requests_;
+    const bool stopping = stopping_;
+    lock.unlock();
+    WriteMessages();
+    lock.lock();
+    flushes_done_ = requests;
+    flushed_cv_.notify_all();
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void AsyncLogSink::WriteMessages() noexcept {
+  const size_t write_index = write_index_.load(std::memory_order_acquire);
+  size_t read_index = read_index_.load(std::memory_order_relaxed);
+  if (read_index == write_index) {
+    return;
+  }
+  for (; read_index != write_index; ++read_index) {
+    const Slot& slot = slots_[read_index % slots_.size()];
+    if (file_) {
+      char prefix[32];
+      const int prefix_length =
+          snprintf(prefix, sizeof(prefix), "%" PRId64 " %c ",
+                   slot.timestamp_ms, LevelLetter(slot.level));
+      line_.assign(prefix, (size_t)prefix_length);
+      line_.append(slot.text, slot.length);
+      line_.push_back('\n');
+      file_->Write(line_.data(), line_.size());
+    }
+    if (callback_) {
+      char module[kMaxModuleLength + 1];
+      memcpy(module, slot.text + slot.module_offset, slot.module_length);
+      module[slot.module_length] = '\0';
+      callback_(user_data_, slot.level, module, slot.text);
+    }
+    // Release each slot as soon as it is written, to make room early.
+    read_index_.store(read_index + 1, std::memory_order_release);
+    written_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (file_) {
+    file_->Flush();
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
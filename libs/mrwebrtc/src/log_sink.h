@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtc_base/logging.h"
+#include "system_wrappers/include/file_wrapper.h"
+
+#include "log_sink_interop.h"
+#include "mrs_errors.h"
+#include "rcu_snapshot.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Implementation of the log sink of |mrsLogSinkInstall()|.
+///
+/// WebRTC invokes its sinks with its logging lock held, so messages are pushed
+/// by a single thread at a time into a single-producer single-consumer ring of
+/// fixed-size slots, preallocated so that pushing never locks nor allocates.
+/// A background thread pops them and writes them out. The module levels are
+/// read by the logging threads from a read-copy-update snapshot.
+class AsyncLogSink : public rtc::LogSink {
+ public:
+  /// Maximum length of a message, in bytes. Longer messages are truncated.
+  static constexpr const size_t kMaxMessageLength = 512;
+
+  /// Create a sink for a valid |config|, opening its file if any, and start
+  /// its background thread.
+  static ErrorOr<std::unique_ptr<AsyncLogSink>> Create(
+      const mrsLogSinkConfig& config) noexcept;
+
+  /// Stop the background thread after it writes the messages left. The sink
+  /// must be removed from the WebRTC log streams first.
+  ~AsyncLogSink() override;
+
+  /// Lowest level of all modules, below which WebRTC does not need to format
+  /// messages for this sink.
+  rtc::LoggingSeverity min_severity() const noexcept;
+
+  /// See |mrsLogSinkSetLevel()|.
+  void SetLevel(const char* module, mrsLogLevel level) noexcept;
+
+  /// See |mrsLogSinkFlush()|.
+  void Flush() noexcept;
+
+  mrsLogSinkStats GetStats() const noexcept;
+
+  // rtc::LogSink implementation.
+  void OnLogMessage(const std::string& message) override;
+  void OnLogMessage(const std::string& message,
+                    rtc::LoggingSeverity severity,
+                    const char* tag) override;
+
+ private:
+  /// Levels of the modules, sorted by decreasing name length so that the
+  /// first match is the longest one.
+  struct Levels {
+    mrsLogLevel default_level{mrsLogLevel::kInfo};
+    std::vector<std::pair<std::string, mrsLogLevel>> modules;
+  };
+
+  /// Message stored in a ring slot.
+  struct Slot {
+    int64_t timestamp_ms;
+    mrsLogLevel level;
+    /// Module name, as a range of |text|.
+    uint16_t module_offset;
+    uint16_t module_length;
+    uint16_t length;
+    char text[kMaxMessageLength];
+  };
+
+  AsyncLogSink(const mrsLogSinkConfig& config,
+               std::unique_ptr<webrtc::FileWrapper> file) noexcept;
+
+  /// Get the level of the module named |module|, of |length| characters.
+  mrsLogLevel GetModuleLevel(const char* module, size_t length) const noexcept;
+
+  /// Background thread, writing the messages out on each flush interval,
+  /// flush request, or once the ring is half full.
+  void FlushLoop() noexcept;
+
+  /// Pop all messages of the ring and write them out. Only called by the
+  /// background thread.
+  void WriteMessages() noexcept;
+
+  const std::unique_ptr<webrtc::FileWrapper> file_;
+  const mrsLogCallback callback_;
+  void* const user_data_;
+  const int flush_interval_ms_;
+
+  RcuSnapshot<Levels> levels_;
+
+  /// Ring of messages. Slot |i % slots_.size()| holds message |i|, and each
+  /// index is written by one side only, and read by the other to detect a
+  /// full or empty ring.
+  std::vector<Slot> slots_;
+  std::atomic<size_t> write_index_{0};
+  std::atomic<size_t> read_index_{0};
+
+  std::atomic<uint64_t> written_count_{0};
+  std::atomic<uint64_t> dropped_count_{0};
+
+  /// Wake-up of the background thread, and completion of the flushes.
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable flushed_cv_;
+  bool stopping_ RTC_GUARDED_BY(mutex_){false};
+  uint64_t flush_requests_ RTC_GUARDED_BY(mutex_){0};
+  uint64_t flushes_done_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Buffer the background thread formats lines into.
+  std::string line_;
+
+  std::thread thread_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "lz4_block.h"
+
+namespace {
+
+/// Minimum length of a match.
+constexpr const size_t kMinMatch = 4;
+
+/// The last match must start at least this many bytes before the end of the
+/// block.
+constexpr const size_t kMatchStartLimit = 12;
+
+/// The last bytes of the block are always literals.
+constexpr const size_t kLastLiterals = 5;
+
+/// Matches are encoded with a 16-bit offset.
+constexpr const size_t kMaxOffset = 65535;
+
+constexpr const int kHashLog = 12;
+
+inline uint32_t Read32(const uint8_t* p) noexcept {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t sequence) noexcept {
+  return ((sequence * 2654435761u) >> (32 - kHashLog));
+}
+
+/// Bounded writer of the compressed output, which records any overflow
+/// instead of writing.
+class Writer {
+ public:
+  Writer(uint8_t* dst, size_t capacity) noexcept
+      : ptr_(dst), end_(dst + capacity) {}
+
+  bool ok() const noexcept { return ok_; }
+  uint8_t* ptr() const noexcept { return ptr_; }
+
+  void WriteByte(uint8_t value) noexcept {
+    if (ok_ && (ptr_ < end_)) {
+      *ptr_++ = value;
+    } else {
+      ok_ = false;
+    }
+  }
+
+  void WriteBytes(const uint8_t* src, size_t size) noexcept {
+    if (size == 0) {
+      return;
+    }
+    if (ok_ && (size <= (size_t)(end_ - ptr_))) {
+      memcpy(ptr_, src, size);
+      ptr_ += size;
+    } else {
+      ok_ = false;
+    }
+  }
+
+  /// Write the extension bytes of a length which overflowed its token nibble.
+  void WriteLength(size_t length) noexcept {
+    for (; length >= 255; length -= 255) {
+      WriteByte(255);
+    }
+    WriteByte((uint8_t)length);
+  }
+
+ private:
+  uint8_t* ptr_;
+  uint8_t* const end_;
+  bool ok_{true};
+};
+
+/// Write a sequence of |literal_size| literals, followed by a match of
+/// |match_size| bytes at |offset| bytes back if |match_size| is not zero.
+void WriteSequence(Writer& writer,
+                   const uint8_t* literals,
+                   size_t literal_size,
+                   size_t offset,
+                   size_t match_size) noexcept {
+  const size_t match_code = (match_size > 0 ? match_size - kMinMatch : 0);
+  const uint8_t token =
+      (uint8_t)((std::min<size_t>(literal_size, 15) << 4) |
+                std::min<size_t>(match_code, 15));
+  writer.WriteByte(token);
+  if (literal_size >= 15) {
+    writer.WriteLength(literal_size - 15);
+  }
+  writer.WriteBytes(literals, literal_size);
+  if (match_size > 0) {
+    writer.WriteByte((uint8_t)(offset & 0xFF));
+    writer.WriteByte((uint8_t)(offset >> 8));
+    if (match_code >= 15) {
+      writer.WriteLength(match_code - 15);
+    }
+  }
+}
+
+/// Read the extension bytes of a length, adding them to |length|.
+bool ReadLength(const uint8_t*& ip,
+                const uint8_t* end,
+                size_t& length) noexcept {
+  uint8_t value;
+  do {
+    if (ip >= end) {
+      return false;
+    }
+    value = *ip++;
+    length += value;
+  } while (value == 255);
+  return true;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+size_t Lz4Compress(const uint8_t* src,
+                   size_t size,
+                   uint8_t* dst,
+                   size_t capacity) noexcept {
+  Writer writer(dst, capacity);
+  size_t anchor = 0;
+  if (size > kMatchStartLimit) {
+    // Positions of the last sequences seen, by hash; 16 kB on the stack.
+    uint32_t table[1 << kHashLog]{};
+    const size_t match_start_limit = size - kMatchStartLimit;
+    const size_t match_end_limit = size - kLastLiterals;
+    size_t ip = 1;
+    while (ip < match_start_limit) {
+      const uint32_t sequence = Read32(src + ip);
+      uint32_t& entry = table[Hash(sequence)];
+      const size_t ref = entry;
+      entry = (uint32_t)ip;
+      if ((ip - ref > kMaxOffset) || (Read32(src + ref) != sequence)) {
+        ++ip;
+        continue;
+      }
+      // Extend the match forward, stopping before the last literals.
+      size_t match_size = kMinMatch;
+      while ((ip + match_size < match_end_limit) &&
+             (src[ref + match_size] == src[ip + match_size])) {
+        ++match_size;
+      }
+      WriteSequence(writer, src + anchor, ip - anchor, ip - ref, match_size);
+      if (!writer.ok()) {
+        return 0;
+      }
+      ip += match_size;
+      anchor = ip;
+    }
+  }
+  WriteSequence(writer, src + anchor, size - anchor, 0, 0);
+  return (writer.ok() ? (size_t)(writer.ptr() - dst) : 0);
+}
+
+bool Lz4Decompress(const uint8_t* src,
+                   size_t size,
+                   uint8_t* dst,
+                   size_t dst_size) noexcept {
+  const uint8_t* ip = src;
+  const uint8_t* const end = src + size;
+  size_t op = 0;
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    size_t literal_size = (token >> 4);
+    if ((literal_size == 15) && !ReadLength(ip, end, literal_size)) {
+      return false;
+    }
+    if ((literal_size > (size_t)(end - ip)) ||
+        (literal_size > dst_size - op)) {
+      return false;
+    }
+    if (literal_size > 0) {
+      memcpy(dst + op, ip, literal_size);
+    }
+    ip += literal_size;
+    op += literal_size;
+    if (ip == end) {
+      // The last sequence has no match.
+      break;
+    }
+    if (end - ip < 2) {
+      return false;
+    }
+    const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    if ((offset == 0) || (offset > op)) {
+      return false;
+    }
+    size_t match_size = (token & 0xF);
+    if ((match_size == 15) && !ReadLength(ip, end, match_size)) {
+      return false;
+    }
+    match_size += kMinMatch;
+    if (match_size > dst_size - op) {
+      return false;
+    }
+    // The match can overlap the bytes it produces, so copy byte by byte
+    // unless it is far enough behind.
+    if (offset >= match_size) {
+      memcpy(dst + op, dst + op - offset, match_size);
+    } else {
+      for (size_t i = 0; i < match_size; ++i) {
+        dst[op + i] = dst[op + i - offset];
+      }
+    }
+    op += match_size;
+  }
+  return (op == dst_size);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Compression and decompression of buffers in the LZ4 block format, as
+/// specified at https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md,
+/// and readable by any LZ4 implementation. The compressor is a single-pass
+/// greedy one, favoring speed over ratio, and does not allocate.
+
+/// Get the maximum size of |size| bytes once compressed.
+constexpr size_t Lz4CompressBound(size_t size) noexcept {
+  return (size + (size / 255) + 16);
+}
+
+/// Compress |size| bytes from |src| into |dst|, of |capacity| bytes. Return
+/// the compressed size, or zero if it exceeds |capacity|.
+size_t Lz4Compress(const uint8_t* src,
+                   size_t size,
+                   uint8_t* dst,
+                   size_t capacity) noexcept;
+
+/// Decompress |size| bytes of a compressed block from |src| into |dst|, which
+/// must receive exactly |dst_size| bytes. Return |false| if the block is
+/// malformed, or does not decompress to exactly |dst_size| bytes. This never
+/// reads or writes out of bounds, even on malformed input.
+bool Lz4Decompress(const uint8_t* src,
+                   size_t size,
+                   uint8_t* dst,
+                   size_t dst_size) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -3,11 +3,14 @@
 
 #include "pch.h"
 
+#include "audio_conversion.h"
 #include "audio_frame.h"
 #include "audio_frame_observer.h"
 #include "audio_track_read_buffer.h"
+#include "media/remote_audio_track.h"
 #include "peer_connection.h"
 #include "remote_audio_track_interop.h"
+#include "tracing.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -18,122 +21,440 @@ void AudioTrackReadBuffer::OnData(const void* audio_data,
                                   int sample_rate,
                                   size_t number_of_channels,
                                   size_t number_of_frames) {
-  std::lock_guard<std::mutex> lock(frames_mutex_);
-  // maintain buffering limits, after adding this frame
-  const size_t maxFrames = std::max(buffer_size_ms_ / 10, 1);
-  while (frames_.size() > maxFrames) {
-    frames_.pop_front();
-    has_overrun_ = true;
-  }
-  // add the new frame
-  frames_.emplace_back();
-  auto& frame = frames_.back();
+  MRS_TRACE_SCOPE2(Media, "AudioTrackReadBuffer::OnData", "buffer",
+                   (intptr_t)this, "frames", number_of_frames);
+  if (ToggleAudioMixer::IsDrainingOnThisThread()) {
+    // Stale audio drained by the mixer while the track resumes.
+    return;
+  }
+  const size_t size =
+      (size_t)(bits_per_sample / 8) * number_of_channels * number_of_frames;
+  const size_t write_index = write_index_.load(std::memory_order_relaxed);
+  const size_t read_index = read_index_.load(std::memory_order_acquire);
+  if ((write_index - read_index >= frames_.size()) ||
+      (size > kMaxFrameBytes)) {
+    // The reader fell behind by the whole buffer duration. Drop the new frame
+    // rather than the oldest one, which the reader might be accessing.
+    has_overrun_.store(true, std::memory_order_relaxed);
+    overrun_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const size_t slot = write_index % frames_.size();
+  std::uint8_t* const dst = frame_data_.data() + slot * kMaxFrameBytes;
+  memcpy(dst, audio_data, size);
+  Frame& frame = frames_[slot];
+  frame.audio_data = dst;
   frame.bits_per_sample = bits_per_sample;
   frame.sample_rate = sample_rate;
   frame.number_of_channels = rtc::checked_cast<uint32_t>(number_of_channels);
   frame.number_of_frames = rtc::checked_cast<uint32_t>(number_of_frames);
-  size_t size =
-      (size_t)(bits_per_sample / 8) * number_of_channels * number_of_frames;
-  auto src_bytes = static_cast<const std::uint8_t*>(audio_data);
-  frame.audio_data.insert(frame.audio_data.begin(), src_bytes,
-                          src_bytes + size);
+  frame.size_bytes = size;
+  // Publish the frame to the reader
+  write_index_.store(write_index + 1, std::memory_order_release);
 }
 
 AudioTrackReadBuffer::AudioTrackReadBuffer(
     rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
-    int bufferMs)
-    : track_(std::move(track)),
-      buffer_size_ms_(bufferMs >= 10 ? bufferMs : 500) {
-  track_->AddSink(this);
+    RemoteAudioTrack* consumer_of,
+    int bufferMs,
+    mrsAudioResamplingQuality quality)
+    : track_(std::move(track)), consumer_of_(consumer_of), buffer_(quality) {
+  // Keep one more frame than the buffer duration, for the frame being read
+  const int buffer_size_ms = (bufferMs >= 10 ? bufferMs : 500);
+  const size_t slot_count = (size_t)std::max(buffer_size_ms / 10, 1) + 1;
+  frames_.resize(slot_count);
+  frame_data_.resize(slot_count * kMaxFrameBytes);
+  memory_charge_.Set(frames_.size() * sizeof(Frame) + frame_data_.size());
+  if (track_) {
+    track_->AddSink(this);
+  }
 }
 
 AudioTrackReadBuffer::~AudioTrackReadBuffer() {
-  track_->RemoveSink(this);
+  if (track_) {
+    track_->RemoveSink(this);
+  }
+  if (consumer_of_) {
+    consumer_of_->RemoveConsumer();
+  }
+}
+
+void AudioTrackReadBuffer::EnableAdaptiveLatency(int min_latency_ms,
+                                                 int max_latency_ms) noexcept {
+  RTC_DCHECK_GE(min_latency_ms, 0);
+  RTC_DCHECK_GT(max_latency_ms, min_latency_ms);
+  min_latency_ms_.store(min_latency_ms, std::memory_order_relaxed);
+  max_latency_ms_.store(max_latency_ms, std::memory_order_relaxed);
+}
+
+void AudioTrackReadBuffer::DisableAdaptiveLatency() noexcept {
+  max_latency_ms_.store(0, std::memory_order_relaxed);
+}
+
+void AudioTrackReadBuffer::GetStats(
+    mrsAudioTrackReadBufferStats& stats) noexcept {
+  stats.latency_ms = latency_ms_.load(std::memory_order_relaxed);
+  const int min_fill_ms =
+      min_fill_ms_.exchange(INT_MAX, std::memory_order_relaxed);
+  const int max_fill_ms = max_fill_ms_.exchange(-1, std::memory_order_relaxed);
+  if (min_fill_ms <= max_fill_ms) {
+    stats.min_fill_ms = min_fill_ms;
+    stats.max_fill_ms = max_fill_ms;
+  } else {
+    // No read since the previous call
+    stats.min_fill_ms = stats.latency_ms;
+    stats.max_fill_ms = stats.latency_ms;
+  }
+  stats.underrun_count = underrun_count_.load(std::memory_order_relaxed);
+  stats.overrun_count = overrun_count_.load(std::memory_order_relaxed);
+}
+
+int AudioTrackReadBuffer::GetFillMs(int sample_rate, int num_channels) const
+    noexcept {
+  const size_t frame_count = write_index_.load(std::memory_order_acquire) -
+                             read_index_.load(std::memory_order_relaxed);
+  int fill_ms = static_cast<int>(frame_count) * 10;
+  if ((sample_rate == buffer_.rate_) && (num_channels == buffer_.channels_)) {
+    // Data already converted, which is dropped on format change otherwise
+    fill_ms += buffer_.available() * 1000 / (sample_rate * num_channels);
+  }
+  return fill_ms;
+}
+
+void AudioTrackReadBuffer::UpdateFillStats(int fill_ms) noexcept {
+  // Only the reader increases the minimum and decreases the maximum, while
+  // GetStats() only resets them, so a race at worst loses one measurement.
+  latency_ms_.store(fill_ms, std::memory_order_relaxed);
+  if (fill_ms < min_fill_ms_.load(std::memory_order_relaxed)) {
+    min_fill_ms_.store(fill_ms, std::memory_order_relaxed);
+  }
+  if (fill_ms > max_fill_ms_.load(std::memory_order_relaxed)) {
+    max_fill_ms_.store(fill_ms, std::memory_order_relaxed);
+  }
+}
+
+int AudioTrackReadBuffer::UpdateDriftCorrection(int fill_ms,
+                                                int sample_rate) noexcept {
+  const int max_latency_ms = max_latency_ms_.load(std::memory_order_relaxed);
+  const int min_latency_ms = min_latency_ms_.load(std::memory_order_relaxed);
+  const bool adaptive = (max_latency_ms > 0);
+  if (adaptive != adaptive_) {
+    adaptive_ = adaptive;
+    rebuffering_ = adaptive;
+    drift_correction_ = 0;
+  }
+  if (!adaptive_) {
+    return 0;
+  }
+  if (rebuffering_) {
+    if (fill_ms < min_latency_ms) {
+      return 0;
+    }
+    rebuffering_ = false;
+  }
+
+  // Only start correcting when leaving the window, to avoid pitch changes
+  // from the jitter of the network, but then go back to the middle of it
+  // rather than oscillating around the edge.
+  const int target_ms = (min_latency_ms + max_latency_ms) / 2;
+  if (fill_ms > max_latency_ms) {
+    drift_correction_ = -1;
+  } else if (fill_ms < min_latency_ms) {
+    drift_correction_ = 1;
+  } else if (((drift_correction_ < 0) && (fill_ms <= target_ms)) ||
+             ((drift_correction_ > 0) && (fill_ms >= target_ms))) {
+    drift_correction_ = 0;
+  }
+
+  // Round to a multiple of 100 Hz, so that each 10ms frame resamples to a
+  // whole number of samples.
+  const int step_hz =
+      std::max(sample_rate * kDriftCorrectionPermille / 1000 / 100, 1) * 100;
+  return drift_correction_ * step_hz;
+}
+
+size_t AudioTrackReadBuffer::Output::SampleSize() const noexcept {
+  return (format.sample_type == mrsAudioTrackReadBufferSampleType::kInt16
+              ? sizeof(short)
+              : sizeof(float));
+}
+
+void AudioTrackReadBuffer::Output::Store(int index, float value) const
+    noexcept {
+  if (format.sample_type == mrsAudioTrackReadBufferSampleType::kFloat32) {
+    static_cast<float*>(data)[OffsetOf(index)] = value;
+  } else {
+    static_cast<short*>(data)[OffsetOf(index)] =
+        (short)std::lrintf(value * 32767.0f);
+  }
+}
+
+void AudioTrackReadBuffer::Pad(mrsAudioTrackReadBufferPadBehavior pad_behavior,
+                               int sample_rate,
+                               const Output& out,
+                               int dst,
+                               int len) noexcept {
+  constexpr float freq = 2 * 222 * float(M_PI);
+  switch (pad_behavior) {
+    case mrsAudioTrackReadBufferPadBehavior::kDoNotPad:
+      break;
+    case mrsAudioTrackReadBufferPadBehavior::kPadWithZero:
+      if (out.format.interleaved) {
+        const size_t sample_size = out.SampleSize();
+        std::memset(static_cast<uint8_t*>(out.data) + dst * sample_size, 0,
+                    len * sample_size);
+      } else {
+        for (int i = 0; i < len; ++i) {
+          out.Store(dst + i, 0.0f);
+        }
+      }
+      break;
+    case mrsAudioTrackReadBufferPadBehavior::kPadWithSine:
+      for (int i = 0; i < len; ++i) {
+        out.Store(dst + i, 0.15f * sinf((freq * (sinwave_iter_ + i)) /
+                                        (sample_rate * out.num_channels)));
+      }
+      sinwave_iter_ = (sinwave_iter_ + len) % 628318530 /*twopi*/;
+      sinwave_iter_ += len;
+      break;
+    default:
+      RTC_NOTREACHED();
+      break;
+  }
 }
 
-AudioTrackReadBuffer::Buffer::Buffer() {
-  resampler_ = std::make_unique<webrtc::Resampler>();
+size_t AudioTrackReadBuffer::LinearResampler::Resample(
+    const short* src,
+    size_t src_count,
+    int channels,
+    int src_rate,
+    int dst_rate,
+    short* dst,
+    size_t dst_capacity) noexcept {
+  const size_t src_frames = src_count / channels;
+  if (src_frames == 0) {
+    return 0;
+  }
+  if (channels != channels_) {
+    // Start from the first frame, without any previous one to interpolate.
+    channels_ = channels;
+    dst_rate_ = dst_rate;
+    position_ = 0;
+    for (int c = 0; c < channels; ++c) {
+      last_[c] = src[c];
+    }
+  } else if (dst_rate != dst_rate_) {
+    position_ = position_ * dst_rate / dst_rate_;
+    dst_rate_ = dst_rate;
+  }
+
+  // Interpolate between the frames |x[i]| and |x[i + 1]|, where |x[0]| is
+  // |last_| and |x[i]| is the frame |i - 1| of |src| for |i| > 0.
+  const int64_t end = (int64_t)src_frames * dst_rate;
+  size_t count = 0;
+  while ((position_ < end) && (count + channels <= dst_capacity)) {
+    const size_t index = (size_t)(position_ / dst_rate);
+    const int64_t frac = position_ % dst_rate;
+    for (int c = 0; c < channels; ++c) {
+      const int a = (index == 0 ? last_[c] : src[(index - 1) * channels + c]);
+      const int b = src[index * channels + c];
+      dst[count + c] = (short)(a + (b - a) * frac / dst_rate);
+    }
+    count += channels;
+    position_ += src_rate;
+  }
+  position_ = std::max<int64_t>(position_ - end, 0);
+  for (int c = 0; c < channels; ++c) {
+    last_[c] = src[(src_frames - 1) * channels + c];
+  }
+  return count;
+}
+
+AudioTrackReadBuffer::Buffer::Buffer(mrsAudioResamplingQuality quality)
+    : quality_(quality) {
+  resamplers_.reserve(kMaxCachedResamplers);
 }
 AudioTrackReadBuffer::Buffer::~Buffer() {}
 
+webrtc::Resampler& AudioTrackReadBuffer::Buffer::GetResampler(int src_rate,
+                                                              int dst_rate,
+                                                              int channels) {
+  ++resampler_uses_;
+  CachedResampler* lru = nullptr;
+  for (CachedResampler& entry : resamplers_) {
+    if ((entry.src_rate == src_rate) && (entry.dst_rate == dst_rate) &&
+        (entry.channels == channels)) {
+      entry.last_use = resampler_uses_;
+      return *entry.resampler;
+    }
+    if (!lru || (entry.last_use < lru->last_use)) {
+      lru = &entry;
+    }
+  }
+  if (resamplers_.size() < kMaxCachedResamplers) {
+    resamplers_.push_back(CachedResampler{
+        src_rate, dst_rate, channels, resampler_uses_,
+        std::make_unique<webrtc::Resampler>(src_rate, dst_rate, channels)});
+    return *resamplers_.back().resampler;
+  }
+  lru->src_rate = src_rate;
+  lru->dst_rate = dst_rate;
+  lru->channels = channels;
+  lru->last_use = resampler_uses_;
+  lru->resampler->Reset(src_rate, dst_rate, channels);
+  return *lru->resampler;
+}
+
+int AudioTrackReadBuffer::Buffer::readSome(const Output& out,
+                                           int dst,
+                                           int dst_len) noexcept {
+  const int take = std::min(available(), dst_len);
+  const short* const src = data_.data();
+  const bool to_float =
+      (out.format.sample_type == mrsAudioTrackReadBufferSampleType::kFloat32);
+  if ((src_channels_ == channels_) &&
+      (out.format.interleaved || (channels_ == 1))) {
+    // Same layout, at most a sample type conversion
+    if (to_float) {
+      ConvertS16ToF32(src + used_, static_cast<float*>(out.data) + dst, take);
+    } else {
+      memcpy(static_cast<short*>(out.data) + dst, src + used_,
+             take * sizeof(short));
+    }
+  } else if (out.format.interleaved && to_float && (used_ % 2 == 0) &&
+             (take % 2 == 0)) {
+    // Mono to stereo, on whole frames
+    UpmixMonoS16ToStereoF32(src + used_ / 2,
+                            static_cast<float*>(out.data) + dst, take / 2);
+  } else {
+    // Planar output, or mono to stereo in any other case
+    for (int i = 0; i < take; ++i) {
+      const short value = src[(used_ + i) * src_channels_ / channels_];
+      const size_t offset = out.OffsetOf(dst + i);
+      if (to_float) {
+        static_cast<float*>(out.data)[offset] = (float)value / 32768.0f;
+      } else {
+        static_cast<short*>(out.data)[offset] = value;
+      }
+    }
+  }
+  used_ += take;
+  return take;
+}
+
 void AudioTrackReadBuffer::Buffer::addFrame(const Frame& frame,
                                             int dst_sample_rate,
-                                            int dst_channels) {
+                                            int dst_channels,
+                                            int rate_adjustment) {
+  MRS_TRACE_SCOPE2(Media, "AudioTrackReadBuffer::addFrame", "buffer",
+                   (intptr_t)this, "frames", frame.number_of_frames);
   assert(frame.number_of_channels == 1 || frame.number_of_channels == 2);
   assert(dst_channels == 1 || dst_channels == 2);
 
-  // We may require up to 2 intermediate buffers
-  // We always write into buffer_next and then swap front/back buffers
-  std::vector<short> buffer_front;
-  std::vector<short> buffer_back;
-
-  const short* curr_data; //< Current version of the processed data.
-  size_t src_count;  //< Includes samples from *all* channels.
+  // Intermediate steps write into |scratch_|, in place when the previous step
+  // already produced its output there, and the resampler writes into
+  // |resampled_|. Both keep their capacity across frames, so once the format
+  // is stable no step allocates.
+  const short* curr_data;  //< Current version of the processed data.
+  size_t src_count;        //< Includes samples from *all* channels.
   int curr_channels = frame.number_of_channels;
 
   // ensure source is 16 bit
   if (frame.bits_per_sample == 16) {
-    curr_data = (short*)frame.audio_data.data();
+    curr_data = (const short*)frame.audio_data;
     src_count = frame.number_of_frames * frame.number_of_channels;
   } else if (frame.bits_per_sample == 8) {
-    buffer_front.resize(frame.audio_data.size());
-    short* data = buffer_front.data();
+    scratch_.resize(frame.size_bytes);
+    short* data = scratch_.data();
     // 8 bit data is unsigned8, 16 bit is signed16
-    for (int i = 0; i < (int)frame.audio_data.size(); ++i) {
-      data[i] = ((int)frame.audio_data[i] * 256) - 32768;
-    }
+    ConvertU8ToS16(frame.audio_data, data, frame.size_bytes);
     curr_data = data;
-    src_count = buffer_front.size();
-    swap(buffer_front, buffer_back);
+    src_count = scratch_.size();
   } else {
     FATAL();
     return;
   }
 
   if (frame.number_of_channels == 2 && dst_channels == 1) {
-    // average L&R
-    buffer_front.resize(src_count / 2);
-    short* data = buffer_front.data();
-    for (int i = 0; i < (int)src_count; ++i) {
-      data[i] = (curr_data[2 * i] + curr_data[2 * i + 1]) / 2;
+    // average L&R; sample i only depends on samples 2i and 2i+1, so this is
+    // safe in place, and shrinking |scratch_| never reallocates it.
+    src_count /= 2;
+    if (curr_data != scratch_.data()) {
+      scratch_.resize(src_count);
     }
-
+    short* data = scratch_.data();
+    DownmixStereoToMonoS16(curr_data, data, src_count);
     curr_data = data;
-    src_count = buffer_front.size();
     curr_channels = 1;
-    swap(buffer_front, buffer_back);
   }
 
-  if ((int)frame.sample_rate != dst_sample_rate) {
+  bool resampled = false;
+  if (quality_ == mrsAudioResamplingQuality::kPassthrough) {
+    // Keep the rate of the frame
+    resampled = true;
+  } else if (quality_ == mrsAudioResamplingQuality::kFast) {
+    const int out_sample_rate = dst_sample_rate + rate_adjustment;
+    if ((int)frame.sample_rate != out_sample_rate) {
+      resampled_.resize((src_count * out_sample_rate / frame.sample_rate) +
+                        2 * curr_channels);
+      src_count = linear_resampler_.Resample(
+          curr_data, src_count, curr_channels, frame.sample_rate,
+          out_sample_rate, resampled_.data(), resampled_.size());
+      curr_data = resampled_.data();
+    } else {
+      linear_resampler_.Reset();
+    }
+    resampled = true;
+  } else if (rate_adjustment != 0) {
+    // correct drift; this needs whole 10ms frames, so fall back to the plain
+    // rate conversion below for any other frame size
+    const int out_sample_rate = dst_sample_rate + rate_adjustment;
+    resampled_.resize((size_t)(out_sample_rate / 100) * curr_channels);
+    if (drift_resampler_.InitializeIfNeeded(frame.sample_rate, out_sample_rate,
+                                            curr_channels) == 0) {
+      const int count = drift_resampler_.Resample(
+          curr_data, src_count, resampled_.data(), resampled_.size());
+      if (count >= 0) {
+        curr_data = resampled_.data();
+        src_count = (size_t)count;
+        resampled = true;
+      }
+    }
+  }
+
+  if (!resampled && (int)frame.sample_rate != dst_sample_rate) {
     // match sample rate
-    buffer_front.resize((src_count * dst_sample_rate / frame.sample_rate) + 1);
-    short* data = buffer_front.data();
-    resampler_->ResetIfNeeded(frame.sample_rate, dst_sample_rate, curr_channels);
+    resampled_.resize((src_count * dst_sample_rate / frame.sample_rate) + 1);
+    short* data = resampled_.data();
+    webrtc::Resampler& resampler =
+        GetResampler(frame.sample_rate, dst_sample_rate, curr_channels);
     size_t count;
-    int res = resampler_->Push(curr_data, src_count, data, buffer_front.size(), count);
+    int res =
+        resampler.Push(curr_data, src_count, data, resampled_.size(), count);
     RTC_DCHECK(res == 0);
 
     curr_data = data;
     src_count = count;
-    swap(buffer_front, buffer_back);
   }
 
-  // Convert s16 to f32
-  if (curr_channels == 1 && dst_channels == 2) {
-    // duplicate
-    data_.resize(src_count * 2);
-    for (int i = 0; i < (int)src_count; ++i) {
-      float val = (float)curr_data[i] / 32768.0f;
-      data_[2 * i + 0] = val;
-      data_[2 * i + 1] = val;
-    }
+  // Keep s16 data, which readSome() converts to the output format and
+  // upmixes to stereo if needed in a single pass. The gains of the track are
+  // applied by the copy, which costs no extra pass.
+  const size_t frame_count = src_count / curr_channels;
+  if (gain_ramp_.IsUnity()) {
+    data_.assign(curr_data, curr_data + src_count);
+  } else if ((curr_channels == 1) && (dst_channels == 2) &&
+             !gain_ramp_.IsBalanced()) {
+    // Panning a mono track needs stereo data.
+    data_.resize(frame_count * 2);
+    gain_ramp_.ApplyUpmix(curr_data, data_.data(), frame_count);
+    curr_channels = 2;
   } else {
     data_.resize(src_count);
-    for (size_t i = 0; i < src_count; ++i) {
-      data_[i] = (float)curr_data[i] / 32768.0f;
-    }
+    gain_ramp_.Apply(curr_data, data_.data(), frame_count, curr_channels);
   }
   used_ = 0;
+  src_channels_ = curr_channels;
   channels_ = dst_channels;
   rate_ = dst_sample_rate;
 }
@@ -141,20 +462,49 @@ void AudioTrackReadBuffer::Buffer::addFrame(const Frame& frame,
 void AudioTrackReadBuffer::Read(int sample_rate,
                                 int num_channels,
                                 mrsAudioTrackReadBufferPadBehavior pad_behavior,
-                                float* samples_out,
+                                const OutputFormat& format,
+                                void* samples_out,
                                 int num_samples_max,
                                 int* num_samples_read_out,
                                 bool* has_overrun_out) noexcept {
-  float* dst = samples_out;
+  MRS_TRACE_SCOPE2(Media, "AudioTrackReadBuffer::Read", "buffer",
+                   (intptr_t)this, "samples", num_samples_max);
+  const Output out{format, num_channels, num_samples_max / num_channels,
+                   samples_out};
+  int dst = 0;                    // index of the next point to write
   int dst_len = num_samples_max;  // number of points remaining
 
   *has_overrun_out = false;
 
+  const int fill_ms = GetFillMs(sample_rate, num_channels);
+  UpdateFillStats(fill_ms);
+  const int rate_adjustment = UpdateDriftCorrection(fill_ms, sample_rate);
+  if (rebuffering_) {
+    // Adaptive mode waiting for enough data to absorb the network jitter
+    if (has_overrun_.exchange(false, std::memory_order_relaxed)) {
+      *has_overrun_out = true;
+    }
+    Pad(pad_behavior, sample_rate, out, dst, dst_len);
+    *num_samples_read_out = 0;
+    return;
+  }
+
+  if (consumer_of_) {
+    float left = 1.0f;
+    float right = 1.0f;
+    consumer_of_->GetChannelGains(left, right);
+    if (num_channels == 1) {
+      // Panning has no effect on mono output.
+      left = right = std::max(left, right);
+    }
+    buffer_.gain_ramp_.SetTarget(left, right, sample_rate);
+  }
+
   while (dst_len > 0) {
     if (sample_rate == buffer_.rate_ && num_channels == buffer_.channels_ &&
         buffer_.available()) {
       // There is still data in the buffer and the format matches, read some.
-      int len = buffer_.readSome(dst, dst_len);
+      int len = buffer_.readSome(out, dst, dst_len);
       dst += len;
       dst_len -= len;
     } else {
@@ -163,50 +513,35 @@ void AudioTrackReadBuffer::Read(int sample_rate,
       // ensure the next frame matches. This may drop some data but will only
       // happen when the output sample rate/channels change (i.e. rarely)
 
-      absl::optional<Frame> frame;
-      {
-        std::unique_lock<std::mutex> lock(frames_mutex_);
-
-        // Read and reset the overrun flag.
-        *has_overrun_out = *has_overrun_out || has_overrun_;
-        has_overrun_ = false;
-
-        // Pop the next frame.
-        if (!frames_.empty()) {
-          frame = std::move(frames_.front());
-          frames_.pop_front();
-        }
+      // Read and reset the overrun flag.
+      if (has_overrun_.exchange(false, std::memory_order_relaxed)) {
+        *has_overrun_out = true;
       }
 
-      if (frame) {
-        buffer_.addFrame(*frame, sample_rate, num_channels);
+      // Pop the next frame, converting it directly from its ring slot.
+      const size_t read_index = read_index_.load(std::memory_order_relaxed);
+      if (read_index != write_index_.load(std::memory_order_acquire)) {
+        buffer_.addFrame(frames_[read_index % frames_.size()], sample_rate,
+                         num_channels, rate_adjustment);
+        // Release the slot to the writer once its data is consumed
+        read_index_.store(read_index + 1, std::memory_order_release);
       } else {
-        // no more input! fill with sin wave
-        constexpr float freq = 2 * 222 * float(M_PI);
-        switch (pad_behavior) {
-          case mrsAudioTrackReadBufferPadBehavior::kDoNotPad:
-            break;
-          case mrsAudioTrackReadBufferPadBehavior::kPadWithZero:
-            std::memset(dst, 0, dst_len * sizeof(float));
-            break;
-          case mrsAudioTrackReadBufferPadBehavior::kPadWithSine:
-            for (int i = 0; i < dst_len; ++i) {
-              dst[i] = 0.15f * sinf((freq * (sinwave_iter_ + i)) /
-                                    (sample_rate * num_channels));
-            }
-            sinwave_iter_ = (sinwave_iter_ + dst_len) % 628318530 /*twopi*/;
-            sinwave_iter_ += dst_len;
-            break;
-          default:
-            RTC_NOTREACHED();
-            break;
+        // no more input! pad the rest
+        if (!underrun_) {
+          underrun_ = true;
+          underrun_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (adaptive_) {
+          rebuffering_ = true;
         }
+        Pad(pad_behavior, sample_rate, out, dst, dst_len);
 
         *num_samples_read_out = num_samples_max - dst_len;
         return;  // and return
       }
     }
   }
+  underrun_ = false;
   *num_samples_read_out = num_samples_max;
 }
 
@@ -3,13 +3,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <climits>
+#include <vector>
+
 #include "api/call/audio_sink.h"
+#include "common_audio/resampler/include/push_resampler.h"
 #include "common_audio/resampler/include/resampler.h"
 
 #include "export.h"
+#include "gain_ramp.h"
+#include "memory_accounting.h"
 #include "refptr.h"
 
+enum class mrsAudioResamplingQuality : int32_t;
 enum class mrsAudioTrackReadBufferPadBehavior;
+enum class mrsAudioTrackReadBufferSampleType : int32_t;
+struct mrsAudioTrackReadBufferOptions;
+struct mrsAudioTrackReadBufferStats;
 
 namespace Microsoft {
 namespace MixedReality {
@@ -17,27 +28,73 @@ namespace WebRTC {
 
 struct AudioFrame;
 class PeerConnection;
+class RemoteAudioTrack;
 
 /// Implementation of |mrsAudioTrackReadBufferHandle|.
+///
+/// Incoming frames are stored in a preallocated single-producer single-consumer
+/// ring, so that neither the WebRTC audio thread delivering frames nor the
+/// thread calling |Read()| ever locks or allocates, once the output format is
+/// stable. Only one thread at a time may call |Read()|.
+///
+/// In adaptive mode, the reader keeps the buffered duration within a latency
+/// window. It waits for the buffer to fill up to the low end of the window
+/// before starting, or resuming after an underrun, and corrects the clock
+/// drift between the sender and the reader by resampling frames to a slightly
+/// lower or higher rate while the fill level is outside the window, until it
+/// gets back to the middle of the window.
 class AudioTrackReadBuffer : public webrtc::AudioTrackSinkInterface {
  public:
   /// Create a new stream which buffers |bufferMs| milliseconds of audio.
   /// WebRTC delivers audio at 10ms intervals so pass a multiple of 10.
+  /// If |track| is null, the buffer is fed by the application calling
+  /// |OnData()| itself instead. If |consumer_of| is not null, the buffer
+  /// releases its registration as a consumer of that track on destruction.
+  /// The default |quality| is |mrsAudioResamplingQuality::kHigh|.
   AudioTrackReadBuffer(rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
-                       int bufferMs = 500);
+                       RemoteAudioTrack* consumer_of = nullptr,
+                       int bufferMs = 500,
+                       mrsAudioResamplingQuality quality = {});
 
   /// Destructs the stream.
   ~AudioTrackReadBuffer();
 
-  /// See |mrsAudioTrackReadBufferRead|.
+  /// Layout of the samples written by |Read()|.
+  struct OutputFormat {
+    mrsAudioTrackReadBufferSampleType sample_type;
+    /// Interleave the channels, or write one plane per channel otherwise.
+    bool interleaved;
+  };
+
+  /// See |mrsAudioTrackReadBufferReadWithFormat|.
   void Read(int sample_rate,
             int num_channels,
             mrsAudioTrackReadBufferPadBehavior pad_behavior,
-            float* samples_out,
+            const OutputFormat& format,
+            void* samples_out,
             int num_samples_max,
             int* num_samples_read_out,
             bool* has_overrun_out) noexcept;
 
+  /// Whether the buffer is fed by the application rather than by a track.
+  bool IsPushBuffer() const noexcept { return !track_; }
+
+  /// Capacity of the buffer, in milliseconds.
+  int GetCapacityMs() const noexcept {
+    return static_cast<int>(frames_.size() - 1) * 10;
+  }
+
+  /// Enable the adaptive mode, targeting the given latency window. See
+  /// |mrsAudioTrackReadBufferSetLatencyWindow|. This can be called from any
+  /// thread, and takes effect at the next |Read()|.
+  void EnableAdaptiveLatency(int min_latency_ms, int max_latency_ms) noexcept;
+
+  /// Disable the adaptive mode. This can be called from any thread.
+  void DisableAdaptiveLatency() noexcept;
+
+  /// See |mrsAudioTrackReadBufferGetStats|. This can be called from any thread.
+  void GetStats(mrsAudioTrackReadBufferStats& stats) noexcept;
+
   /// AudioTrackSinkInterface implementation.
   virtual void OnData(const void* audio_data,
                       int bits_per_sample,
@@ -47,44 +104,201 @@ class AudioTrackReadBuffer : public webrtc::AudioTrackSinkInterface {
 
 
  private:
+  /// Maximum size in bytes of the PCM data of a single 10ms frame, for 16-bit
+  /// stereo audio at up to 96kHz. Larger frames are dropped.
+  static constexpr const size_t kMaxFrameBytes = 96000 / 100 * 2 * 2;
+
+  /// Rate adjustment applied to correct the clock drift in adaptive mode, in
+  /// thousandths of the output sample rate. This is small enough to not be
+  /// noticeable on speech and music.
+  static constexpr const int kDriftCorrectionPermille = 5;
+
+  /// Buffered duration, in milliseconds, for the given output format.
+  int GetFillMs(int sample_rate, int num_channels) const noexcept;
+
+  /// Update the fill level statistics with a new measurement.
+  void UpdateFillStats(int fill_ms) noexcept;
+
+  /// Update the adaptive mode state for the current fill level, and return the
+  /// rate adjustment in Hz to apply to the next frames.
+  int UpdateDriftCorrection(int fill_ms, int sample_rate) noexcept;
+
+  /// Destination of |Read()|. Samples are addressed by their index in
+  /// interleaved order, whatever the actual layout.
+  struct Output {
+    OutputFormat format;
+    int num_channels;
+    /// Number of samples in each channel plane, for planar output.
+    int plane_length;
+    void* data;
+
+    size_t SampleSize() const noexcept;
+    size_t OffsetOf(int index) const noexcept {
+      return (format.interleaved
+                  ? (size_t)index
+                  : (size_t)(index % num_channels) * plane_length +
+                        index / num_channels);
+    }
+    /// Store a sample in the [-1:1] range, converting it to the sample type.
+    void Store(int index, float value) const noexcept;
+  };
+
+  /// Pad the |len| samples of |out| starting at index |dst| on underrun.
+  void Pad(mrsAudioTrackReadBufferPadBehavior pad_behavior,
+           int sample_rate,
+           const Output& out,
+           int dst,
+           int len) noexcept;
+
   const rtc::scoped_refptr<webrtc::AudioTrackInterface> track_;
+
+  /// Track this buffer is registered as a consumer of, if any.
+  const RefPtr<RemoteAudioTrack> consumer_of_;
+
+  /// Format of a frame stored in a ring slot.
   struct Frame {
-    std::vector<std::uint8_t> audio_data;
+    const std::uint8_t* audio_data;
     uint32_t bits_per_sample;
     uint32_t sample_rate;
     uint32_t number_of_channels;
     uint32_t number_of_frames;
+    size_t size_bytes;
   };
-  // Incoming frames received from webrtc - see also buffer_
-  std::deque<Frame> frames_;
-  // protects frames_ and has_overrun_ in Read() and audioFrameCallback()
-  std::mutex frames_mutex_;
-  // max ms of audio data stored in frames_
-  int buffer_size_ms_{};
+
+  // Incoming frames received from webrtc - see also buffer_. Slot |i| holds
+  // its format in |frames_[i]| and its PCM data at |i * kMaxFrameBytes| in
+  // |frame_data_|. Both are allocated once in the constructor.
+  std::vector<Frame> frames_;
+  std::vector<std::uint8_t> frame_data_;
+
+  // Accounting of |frames_| and |frame_data_| as audio read buffer memory.
+  MemoryCharge memory_charge_{MemoryCategory::kAudioReadBuffers};
+
+  // Total number of frames written by OnData() and read by Read(). The slot
+  // of a frame is its index modulo the number of slots. Each index is only
+  // written by one side, and read by the other to detect a full or empty ring.
+  std::atomic<size_t> write_index_{0};
+  std::atomic<size_t> read_index_{0};
+
   // for debugging, we emit a sin on underrun.
   int sinwave_iter_{};
   // Have frames been dropped due to overrun after last call to Read()?
-  bool has_overrun_{};
+  std::atomic_bool has_overrun_{false};
+
+  // Latency window of the adaptive mode, in milliseconds. A zero maximum
+  // disables the adaptive mode. Written from any thread, and sampled by the
+  // reader at each Read().
+  std::atomic<int> min_latency_ms_{0};
+  std::atomic<int> max_latency_ms_{0};
+
+  // Adaptive mode state, only accessed by the reader.
+  bool adaptive_ = false;
+  // Waiting for the buffer to fill up to the low end of the latency window.
+  bool rebuffering_ = false;
+  // Direction of the ongoing drift correction: positive to slow down playback
+  // and let the buffer fill up, negative to speed it up, zero for none.
+  int drift_correction_ = 0;
+  // Did the last Read() run out of data?
+  bool underrun_ = false;
+
+  // Statistics, written by the reader and by OnData(), and read by GetStats()
+  // from any thread. The minimum and maximum are reset on each GetStats().
+  std::atomic<int> latency_ms_{0};
+  std::atomic<int> min_fill_ms_{INT_MAX};
+  std::atomic<int> max_fill_ms_{-1};
+  std::atomic<uint64_t> underrun_count_{0};
+  std::atomic<uint64_t> overrun_count_{0};
 
-  // Outgoing data resamples to f32 format
+  /// Linear interpolation resampler for interleaved 16-bit audio, much cheaper
+  /// than |webrtc::Resampler|. It converts any ratio, including the rates of
+  /// the drift correction, and keeps its phase across frames and rate changes
+  /// so that the output is continuous.
+  class LinearResampler {
+   public:
+    /// Resample the |src_count| samples of |src| from |src_rate| to
+    /// |dst_rate|, writing at most |dst_capacity| samples to |dst|, and return
+    /// the number of samples written.
+    size_t Resample(const short* src,
+                    size_t src_count,
+                    int channels,
+                    int src_rate,
+                    int dst_rate,
+                    short* dst,
+                    size_t dst_capacity) noexcept;
+
+    /// Forget the previous frames, to start again from the next one.
+    void Reset() noexcept { channels_ = 0; }
+
+   private:
+    int channels_ = 0;
+    int dst_rate_ = 0;
+    /// Position of the next output sample past |last_|, in units of
+    /// 1/|dst_rate_| source frame.
+    int64_t position_ = 0;
+    /// Last source frame of the previous call.
+    short last_[2] = {};
+  };
+
+  // Outgoing data resampled to the output rate, and downmixed to mono if
+  // needed. It stays in s16 format, with |src_channels_| channels, until
+  // readSome() converts it to the output format and |channels_| channels.
   struct Buffer {
-    std::unique_ptr<webrtc::Resampler> resampler_ = nullptr;
-    std::vector<float> data_;
-    int used_ = 0;
+    std::vector<short> data_;
+    int used_ = 0;  //< In output samples, including upmixed ones.
+    int src_channels_ = 0;
     int channels_ = 0;
     int rate_ = 0;
+    // Gains of the track, applied while copying the frames into |data_|.
+    GainRamp gain_ramp_;
 
-    Buffer();
+    explicit Buffer(mrsAudioResamplingQuality quality);
     ~Buffer();
-    int available() const { return (int)data_.size() - used_; }
-    int readSome(float* dst, int dstLen) {
-      int take = std::min(available(), dstLen);
-      memcpy(dst, data_.data() + used_, take * sizeof(float));
-      used_ += take;
-      return take;
+    int available() const {
+      return data_.empty()
+                 ? 0
+                 : (int)data_.size() * channels_ / src_channels_ - used_;
     }
-    // Extract/resample data from frame and add it to our buffer.
-    void addFrame(const Frame& frame, int dstSampleRate, int dstChannels);
+    // Write up to |dstLen| samples to |out| starting at index |dst|, and
+    // return the number of samples written.
+    int readSome(const Output& out, int dst, int dstLen) noexcept;
+    // Extract/resample data from frame and add it to our buffer. The data is
+    // resampled to |dstSampleRate| plus |rateAdjustment|, but still played at
+    // |dstSampleRate|, to correct the clock drift.
+    void addFrame(const Frame& frame,
+                  int dstSampleRate,
+                  int dstChannels,
+                  int rateAdjustment = 0);
+
+   private:
+    // Maximum number of formats in |resamplers_|.
+    static constexpr const size_t kMaxCachedResamplers = 4;
+
+    // Get the fixed ratio resampler of a format, reusing the one in
+    // |resamplers_| if any, or else the least recently used one.
+    webrtc::Resampler& GetResampler(int src_rate, int dst_rate, int channels);
+
+    const mrsAudioResamplingQuality quality_;
+    // Intermediate conversion buffers, kept to reuse their capacity.
+    std::vector<short> scratch_;
+    std::vector<short> resampled_;
+    // Fixed ratio resamplers of the formats used last. Switching back and
+    // forth between formats, for example when the output rate of the audio
+    // engine changes, then keeps the filter state of each format instead of
+    // resetting and reallocating it.
+    struct CachedResampler {
+      int src_rate;
+      int dst_rate;
+      int channels;
+      uint64_t last_use;
+      std::unique_ptr<webrtc::Resampler> resampler;
+    };
+    std::vector<CachedResampler> resamplers_;
+    uint64_t resampler_uses_ = 0;
+    // Arbitrary ratio resampler for the drift correction, which the fixed
+    // ratios of |resamplers_| cannot handle.
+    webrtc::PushResampler<short> drift_resampler_;
+    // Resampler of |mrsAudioResamplingQuality::kFast|.
+    LinearResampler linear_resampler_;
   };
   // Only accessed from callers of Read - no locking needed.
   Buffer buffer_;
@@ -3,8 +3,16 @@
 
 #include "pch.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+#include "android_video.h"
 #include "interop/global_factory.h"
 #include "media/device_video_track_source.h"
+#include "media/video_capture_device_cache.h"
 #include "video_track_source_interop.h"
 
 namespace {
@@ -49,6 +57,26 @@ class SimpleMediaConstraints : public webrtc::MediaConstraintsInterface {
   Constraints optional_;
 };
 
+/// Relative cost of converting a captured frame of the given FOURCC pixel
+/// format into the I420 frames consumed by the encoders.
+int GetConversionCost(uint32_t fourcc) noexcept {
+  switch (libyuv::CanonicalFourCC(fourcc)) {
+    case libyuv::FOURCC_I420:
+    case libyuv::FOURCC_YV12:
+      return 0;  // Plane copy, if any
+    case libyuv::FOURCC_NV12:
+    case libyuv::FOURCC_NV21:
+      return 1;  // Chroma deinterleaving
+    case libyuv::FOURCC_YUY2:
+    case libyuv::FOURCC_UYVY:
+      return 2;  // Packed to planar, and chroma downsampling
+    case libyuv::FOURCC_MJPG:
+      return 4;  // Full JPEG decoding
+    default:
+      return 3;  // RGB to YUV color conversion
+  }
+}
+
 #if defined(WINUWP)
 using WebRtcFactoryPtr =
     std::shared_ptr<wrapper::impl::org::webRtc::WebRtcFactory>;
@@ -147,26 +175,21 @@ mrsResult OpenVideoCaptureDevice(
   // List all available video capture devices, or match by ID if specified.
   std::vector<std::string> device_names;
   {
-    std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
-        webrtc::VideoCaptureFactory::CreateDeviceInfo());
-    if (!info) {
-      return Result::kUnknownError;
+    std::vector<VideoCaptureDeviceInfo> devices;
+    const mrsResult res =
+        VideoCaptureDeviceCache::Instance().GetOrEnumerateDevices(devices);
+    if (res != Result::kSuccess) {
+      return res;
     }
 
-    const int num_devices = info->NumberOfDevices();
-    constexpr uint32_t kSize = 256;
     if (!IsStringNullOrEmpty(config.video_device_id)) {
       // Look for the one specific device the user asked for
-      std::string video_device_id_str = config.video_device_id;
-      for (int i = 0; i < num_devices; ++i) {
-        char name[kSize] = {};
-        char id[kSize] = {};
-        if (info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-          if (video_device_id_str == id) {
-            // Keep only the device the user selected
-            device_names.push_back(name);
-            break;
-          }
+      const std::string video_device_id_str = config.video_device_id;
+      for (auto&& device : devices) {
+        if (video_device_id_str == device.id) {
+          // Keep only the device the user selected
+          device_names.push_back(device.name);
+          break;
         }
       }
       if (device_names.empty()) {
@@ -177,12 +200,8 @@ mrsResult OpenVideoCaptureDevice(
       }
     } else {
       // List all available devices
-      for (int i = 0; i < num_devices; ++i) {
-        char name[kSize] = {};
-        char id[kSize] = {};
-        if (info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-          device_names.push_back(name);
-        }
+      for (auto&& device : devices) {
+        device_names.push_back(device.name);
       }
       if (device_names.empty()) {
         RTC_LOG(LS_ERROR) << "Could not find any video catpure device.";
@@ -207,12 +226,145 @@ mrsResult OpenVideoCaptureDevice(
 #endif
 }
 
+/// Creation of a source started with |DeviceVideoTrackSource::CreateAsync()|.
+struct CreateOperation {
+  uint32_t id{0};
+  mrsLocalVideoDeviceInitConfig config;
+  std::string video_device_id;
+  std::string video_profile_id;
+  DeviceVideoTrackSource::CreatedCallback callback;
+  bool cancelled{false};
+};
+
+/// Queue of the asynchronous source creations, processed one at a time by a
+/// background thread which runs while the queue is not empty.
+class CreateQueue {
+ public:
+  static CreateQueue& Instance() noexcept {
+    // Never destroyed, as the thread may outlive static destructors.
+    static CreateQueue* const instance = new CreateQueue();
+    return *instance;
+  }
+
+  uint32_t Push(CreateOperation operation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (++next_id_ == 0) {
+      ++next_id_;
+    }
+    operation.id = next_id_;
+    queue_.push_back(std::move(operation));
+    if (!running_) {
+      std::thread(&CreateQueue::Run, this).detach();
+      running_ = true;
+    }
+    return next_id_;
+  }
+
+  bool Cancel(uint32_t id) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id == current_id_) {
+      cancel_current_ = true;
+      return true;
+    }
+    for (CreateOperation& operation : queue_) {
+      if (operation.id == id) {
+        operation.cancelled = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  void Run() noexcept {
+    for (;;) {
+      CreateOperation operation;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+          running_ = false;
+          return;
+        }
+        operation = std::move(queue_.front());
+        queue_.pop_front();
+        current_id_ = operation.id;
+        cancel_current_ = operation.cancelled;
+      }
+
+      ErrorOr<RefPtr<DeviceVideoTrackSource>> result =
+          Error(Result::kCancelled);
+      if (!operation.cancelled) {
+        // Point to the strings owned by the operation, now that it moved.
+        mrsLocalVideoDeviceInitConfig& config = operation.config;
+        config.video_device_id =
+            (config.video_device_id ? operation.video_device_id.c_str()
+                                    : nullptr);
+        config.video_profile_id =
+            (config.video_profile_id ? operation.video_profile_id.c_str()
+                                     : nullptr);
+        result = DeviceVideoTrackSource::Create(config);
+      }
+
+      bool cancelled;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled = cancel_current_;
+        current_id_ = 0;
+      }
+      if (cancelled) {
+        // Releases the source, if it was opened.
+        result = Error(Result::kCancelled);
+      }
+      if (result.ok()) {
+        operation.callback(Result::kSuccess, result.MoveValue().release());
+      } else {
+        operation.callback(result.error().result(), nullptr);
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::deque<CreateOperation> queue_;
+  uint32_t next_id_{0};
+  uint32_t current_id_{0};
+  bool cancel_current_{false};
+  bool running_{false};
+};
+
 }  // namespace
 
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+bool DeviceVideoTrackSource::SelectNativeCaptureFormat(
+    const std::vector<cricket::VideoFormat>& formats,
+    const mrsLocalVideoDeviceInitConfig& config,
+    cricket::VideoFormat& format_out) noexcept {
+  // Same default as the capturer without constraints
+  const int width = (config.width > 0 ? (int)config.width : 640);
+  const int height = (config.height > 0 ? (int)config.height : 480);
+  const double framerate = (config.framerate > 0 ? config.framerate : 30.0);
+  const cricket::VideoFormat* best = nullptr;
+  std::tuple<int, double, int, double> best_score;
+  for (const cricket::VideoFormat& format : formats) {
+    const double fps =
+        cricket::VideoFormat::IntervalToFpsFloat(format.interval);
+    const std::tuple<int, double, int, double> score{
+        std::abs(format.width - width) + std::abs(format.height - height),
+        std::abs(fps - framerate), GetConversionCost(format.fourcc), -fps};
+    if (!best || (score < best_score)) {
+      best = &format;
+      best_score = score;
+    }
+  }
+  if (!best) {
+    return false;
+  }
+  format_out = *best;
+  return true;
+}
+
 ErrorOr<RefPtr<DeviceVideoTrackSource>> DeviceVideoTrackSource::Create(
     const mrsLocalVideoDeviceInitConfig& init_config) noexcept {
   RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
@@ -230,25 +382,44 @@ ErrorOr<RefPtr<DeviceVideoTrackSource>> DeviceVideoTrackSource::Create(
   }
   RTC_CHECK(video_capturer.get());
 
+  // Select the native capture format, and constrain the capturer to its exact
+  // resolution and framerate. Constraints cannot express the pixel format, but
+  // the capturer only falls back to a different format of the same resolution
+  // and framerate if it prefers it.
+  mrsLocalVideoDeviceInitConfig config = init_config;
+  if (init_config.prefer_native_format != mrsBool::kFalse) {
+    cricket::VideoFormat format;
+    const std::vector<cricket::VideoFormat>* const formats =
+        video_capturer->GetSupportedFormats();
+    if (formats && SelectNativeCaptureFormat(*formats, init_config, format)) {
+      RTC_LOG(LS_INFO) << "Selected native capture format "
+                       << format.ToString();
+      config.width = (uint32_t)format.width;
+      config.height = (uint32_t)format.height;
+      config.framerate =
+          cricket::VideoFormat::IntervalToFpsFloat(format.interval);
+    }
+  }
+
   // Apply the same constraints used for opening the video capturer
   auto videoConstraints = std::make_unique<SimpleMediaConstraints>();
-  if (init_config.width > 0) {
+  if (config.width > 0) {
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MinWidth(init_config.width));
+        SimpleMediaConstraints::MinWidth(config.width));
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MaxWidth(init_config.width));
+        SimpleMediaConstraints::MaxWidth(config.width));
   }
-  if (init_config.height > 0) {
+  if (config.height > 0) {
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MinHeight(init_config.height));
+        SimpleMediaConstraints::MinHeight(config.height));
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MaxHeight(init_config.height));
+        SimpleMediaConstraints::MaxHeight(config.height));
   }
-  if (init_config.framerate > 0) {
+  if (config.framerate > 0) {
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MinFrameRate(init_config.framerate));
+        SimpleMediaConstraints::MinFrameRate(config.framerate));
     videoConstraints->mandatory_.push_back(
-        SimpleMediaConstraints::MaxFrameRate(init_config.framerate));
+        SimpleMediaConstraints::MaxFrameRate(config.framerate));
   }
 
   // Create the video track source
@@ -269,6 +440,44 @@ ErrorOr<RefPtr<DeviceVideoTrackSource>> DeviceVideoTrackSource::Create(
   return wrapper;
 }
 
+ErrorOr<uint32_t> DeviceVideoTrackSource::CreateAsync(
+    const mrsLocalVideoDeviceInitConfig& init_config,
+    CreatedCallback callback) noexcept {
+  CreateOperation operation;
+  operation.config = init_config;
+  // Copy the strings, which the caller may free once this returns.
+  if (init_config.video_device_id) {
+    operation.video_device_id = init_config.video_device_id;
+  }
+  if (init_config.video_profile_id) {
+    operation.video_profile_id = init_config.video_profile_id;
+  }
+  operation.callback = callback;
+  try {
+    return CreateQueue::Instance().Push(std::move(operation));
+  } catch (...) {
+    return Error(Result::kUnknownError);
+  }
+}
+
+Result DeviceVideoTrackSource::CancelCreateAsync(uint32_t id) noexcept {
+  return (CreateQueue::Instance().Cancel(id) ? Result::kSuccess
+                                             : Result::kNotFound);
+}
+
+ErrorOr<RefPtr<DeviceVideoTrackSource>>
+DeviceVideoTrackSource::CreateFromAndroidCapturer(
+    bool is_screencast,
+    void** j_capturer_observer_out) noexcept {
+  ErrorOr<rtc::scoped_refptr<webrtc::VideoTrackSourceInterface>> source =
+      CreateAndroidCapturerSource(is_screencast, j_capturer_observer_out);
+  if (!source.ok()) {
+    return source.MoveError();
+  }
+  return RefPtr<DeviceVideoTrackSource>(new DeviceVideoTrackSource(
+      GlobalFactory::InstancePtr(), source.MoveValue()));
+}
+
 DeviceVideoTrackSource::DeviceVideoTrackSource(
     RefPtr<GlobalFactory> global_factory,
     rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> source) noexcept
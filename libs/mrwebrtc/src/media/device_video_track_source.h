@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <vector>
+
+#include "callback.h"
 #include "mrs_errors.h"
 #include "refptr.h"
 #include "tracked_object.h"
@@ -12,6 +15,10 @@
 
 #include "api/mediastreaminterface.h"
 
+namespace cricket {
+struct VideoFormat;
+}
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -23,6 +30,37 @@ class DeviceVideoTrackSource : public VideoTrackSource {
   static ErrorOr<RefPtr<DeviceVideoTrackSource>> Create(
       const mrsLocalVideoDeviceInitConfig& init_config) noexcept;
 
+  using CreatedCallback = Callback<mrsResult, mrsDeviceVideoTrackSourceHandle>;
+
+  /// Start creating a source like |Create()| on a background thread, and
+  /// invoke |callback| on that thread once done, with a new reference to the
+  /// source on success. Devices are opened one at a time, in the order of the
+  /// calls. Return an ID for |CancelCreateAsync()|, never zero.
+  static ErrorOr<uint32_t> CreateAsync(
+      const mrsLocalVideoDeviceInitConfig& init_config,
+      CreatedCallback callback) noexcept;
+
+  /// Cancel a creation started with |CreateAsync()|. Its callback is still
+  /// invoked, with |Result::kCancelled|, and any source opened is released.
+  /// Return |Result::kNotFound| if the creation already completed.
+  static Result CancelCreateAsync(uint32_t id) noexcept;
+
+  /// Create a source fed by a Java video capturer on Android. See
+  /// |CreateAndroidCapturerSource()|.
+  static ErrorOr<RefPtr<DeviceVideoTrackSource>> CreateFromAndroidCapturer(
+      bool is_screencast,
+      void** j_capturer_observer_out) noexcept;
+
+  /// Select among the capture |formats| natively supported by a device the
+  /// one best matching the resolution and framerate of |config|, if any, then
+  /// having the cheapest conversion to I420, and finally the highest
+  /// framerate. This is the format opened with |prefer_native_format|.
+  /// Return false if |formats| is empty.
+  static bool SelectNativeCaptureFormat(
+      const std::vector<cricket::VideoFormat>& formats,
+      const mrsLocalVideoDeviceInitConfig& config,
+      cricket::VideoFormat& format_out) noexcept;
+
  protected:
   DeviceVideoTrackSource(
       RefPtr<GlobalFactory> global_factory,
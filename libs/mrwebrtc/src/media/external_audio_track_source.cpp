@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "audio_conversion.h"
+#include "interop/global_factory.h"
+#include "media/external_audio_track_source.h"
+
+namespace {
+
+enum {
+  /// Deliver the next 10 ms of audio.
+  MSG_DELIVER_FRAME,
+};
+
+constexpr int64_t kFrameDurationUs = 10 * rtc::kNumMicrosecsPerMillisec;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+
+ExternalAudioSource::ExternalAudioSource(
+    const mrsExternalAudioTrackSourceSettings& settings)
+    : settings_(settings),
+      samples_per_frame_(settings.sampling_rate_hz / 100 *
+                         settings.channel_count),
+      capacity_(samples_per_frame_ * settings.buffer_ms / 10),
+      ring_(new int16_t[capacity_]),
+      frame_(samples_per_frame_) {}
+
+void ExternalAudioSource::Start(rtc::Thread* thread) noexcept {
+  thread_ = thread;
+  next_frame_time_us_ = rtc::TimeMicros() + kFrameDurationUs;
+  ScheduleNextFrame();
+}
+
+void ExternalAudioSource::Stop() noexcept {
+  if (!thread_) {
+    return;
+  }
+  // Clear on the delivery thread, so that no delivery is in progress once this
+  // returns.
+  thread_->Invoke<void>(RTC_FROM_HERE, [this]() { thread_->Clear(this); });
+  thread_ = nullptr;
+}
+
+uint32_t ExternalAudioSource::Push(const void* data,
+                                   uint32_t frame_count) noexcept {
+  const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+  const size_t free_samples = capacity_ - (size_t)(write_pos - read_pos);
+  const size_t channel_count = settings_.channel_count;
+  const size_t pushed_frames =
+      std::min((size_t)frame_count, free_samples / channel_count);
+  const size_t sample_count = pushed_frames * channel_count;
+
+  // Copy in up to two spans, if wrapping around the end of the ring.
+  const size_t begin = (size_t)(write_pos % capacity_);
+  const size_t first_count = std::min(sample_count, capacity_ - begin);
+  if (settings_.sample_type == mrsExternalAudioSampleType::kFloat32) {
+    const float* const src = static_cast<const float*>(data);
+    ConvertF32ToS16(src, &ring_[begin], first_count);
+    ConvertF32ToS16(src + first_count, &ring_[0], sample_count - first_count);
+  } else {
+    const int16_t* const src = static_cast<const int16_t*>(data);
+    memcpy(&ring_[begin], src, first_count * sizeof(int16_t));
+    memcpy(&ring_[0], src + first_count,
+           (sample_count - first_count) * sizeof(int16_t));
+  }
+  write_pos_.store(write_pos + sample_count, std::memory_order_release);
+  return (uint32_t)pushed_frames;
+}
+
+void ExternalAudioSource::RegisterObserver(
+    webrtc::ObserverInterface* observer) {
+  observer_ = observer;
+}
+
+void ExternalAudioSource::UnregisterObserver(
+    webrtc::ObserverInterface* observer) {
+  RTC_DCHECK_EQ(observer_, observer);
+  observer_ = nullptr;
+}
+
+void ExternalAudioSource::AddSink(webrtc::AudioTrackSinkInterface* sink) {
+  rtc::CritScope lock(&sinks_lock_);
+  sinks_.push_back(sink);
+}
+
+void ExternalAudioSource::RemoveSink(webrtc::AudioTrackSinkInterface* sink) {
+  rtc::CritScope lock(&sinks_lock_);
+  auto it = std::find(sinks_.begin(), sinks_.end(), sink);
+  if (it != sinks_.end()) {
+    sinks_.erase(it);
+  }
+}
+
+// Note - This is called on the delivery thread only.
+void ExternalAudioSource::OnMessage(rtc::Message* message) {
+  if (message->message_id != MSG_DELIVER_FRAME) {
+    return;
+  }
+  // Deliver all the frames due, to keep the cadence after a late wake-up.
+  // After a long stall, skip the missed frames instead of sending a burst.
+  const int64_t now_us = rtc::TimeMicros();
+  if (next_frame_time_us_ + 10 * kFrameDurationUs < now_us) {
+    next_frame_time_us_ = now_us;
+  }
+  while (next_frame_time_us_ <= now_us) {
+    DeliverFrame();
+    next_frame_time_us_ += kFrameDurationUs;
+  }
+  ScheduleNextFrame();
+}
+
+void ExternalAudioSource::DeliverFrame() {
+  // Consume the audio even without sinks, so that audio pushed before a track
+  // uses the source is not sent late.
+  const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  const uint64_t write_pos = write_pos_.load(std::memory_order_acquire);
+  const size_t sample_count =
+      std::min(samples_per_frame_, (size_t)(write_pos - read_pos));
+  const size_t begin = (size_t)(read_pos % capacity_);
+  const size_t first_count = std::min(sample_count, capacity_ - begin);
+  memcpy(frame_.data(), &ring_[begin], first_count * sizeof(int16_t));
+  memcpy(frame_.data() + first_count, &ring_[0],
+         (sample_count - first_count) * sizeof(int16_t));
+  read_pos_.store(read_pos + sample_count, std::memory_order_release);
+  std::fill(frame_.begin() + sample_count, frame_.end(), (int16_t)0);
+
+  rtc::CritScope lock(&sinks_lock_);
+  for (webrtc::AudioTrackSinkInterface* sink : sinks_) {
+    sink->OnData(frame_.data(), 16, (int)settings_.sampling_rate_hz,
+                 settings_.channel_count, settings_.sampling_rate_hz / 100);
+  }
+}
+
+void ExternalAudioSource::ScheduleNextFrame() {
+  // Round up to the next millisecond, the resolution of |PostAt()|, to never
+  // deliver a frame ahead of its deadline.
+  const int64_t deadline_ms =
+      (next_frame_time_us_ + rtc::kNumMicrosecsPerMillisec - 1) /
+      rtc::kNumMicrosecsPerMillisec;
+  thread_->PostAt(RTC_FROM_HERE, deadline_ms, this, MSG_DELIVER_FRAME);
+}
+
+}  // namespace detail
+
+ErrorOr<RefPtr<ExternalAudioTrackSource>> ExternalAudioTrackSource::Create(
+    const mrsExternalAudioTrackSourceSettings& settings) noexcept {
+  if ((settings.sampling_rate_hz < 8000) ||
+      (settings.sampling_rate_hz > 192000) ||
+      (settings.sampling_rate_hz % 100 != 0) ||
+      (settings.channel_count < 1) || (settings.channel_count > 2) ||
+      (settings.buffer_ms < 10) || (settings.buffer_ms > 1000) ||
+      ((settings.sample_type != mrsExternalAudioSampleType::kFloat32) &&
+       (settings.sample_type != mrsExternalAudioSampleType::kInt16))) {
+    return Error(Result::kInvalidParameter);
+  }
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  rtc::Thread* const thread = global_factory->GetCaptureSchedulerThread();
+  if (!thread) {
+    return Error(Result::kInvalidOperation);
+  }
+  rtc::scoped_refptr<detail::ExternalAudioSource> source =
+      new rtc::RefCountedObject<detail::ExternalAudioSource>(settings);
+  RefPtr<ExternalAudioTrackSource> wrapper =
+      new ExternalAudioTrackSource(std::move(global_factory), source);
+  source->Start(thread);
+  return wrapper;
+}
+
+ExternalAudioTrackSource::ExternalAudioTrackSource(
+    RefPtr<GlobalFactory> global_factory,
+    rtc::scoped_refptr<detail::ExternalAudioSource> source) noexcept
+    : AudioTrackSource(std::move(global_factory),
+                       ObjectType::kExternalAudioTrackSource,
+                       std::move(source)) {}
+
+ExternalAudioTrackSource::~ExternalAudioTrackSource() {
+  // The tracks may keep the source alive, but the delivery thread belongs to
+  // the library, which may shut down once this wrapper is destroyed.
+  GetSourceImpl()->Stop();
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
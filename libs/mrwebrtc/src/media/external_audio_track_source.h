@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "external_audio_track_source_interop.h"
+#include "media/audio_track_source.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+
+#include "api/mediastreaminterface.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/thread.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+
+/// Audio source delivering to its sinks, every 10 ms on the capture scheduler
+/// thread, 10 ms of the audio pushed by the application. The audio is pushed
+/// into a single-producer, single-consumer ring of 16-bit samples, so neither
+/// side takes a lock.
+class ExternalAudioSource : public webrtc::AudioSourceInterface,
+                            public rtc::MessageHandler {
+ public:
+  explicit ExternalAudioSource(
+      const mrsExternalAudioTrackSourceSettings& settings);
+
+  /// Start delivering the audio on |thread|.
+  void Start(rtc::Thread* thread) noexcept;
+
+  /// Stop delivering the audio, and wait for any delivery in progress.
+  void Stop() noexcept;
+
+  /// Copy up to |frame_count| frames into the ring, converting them to 16-bit
+  /// samples if needed, and return the number of frames copied. This must not
+  /// be called concurrently.
+  uint32_t Push(const void* data, uint32_t frame_count) noexcept;
+
+  //
+  // NotifierInterface
+  //
+
+  void RegisterObserver(webrtc::ObserverInterface* observer) override;
+  void UnregisterObserver(webrtc::ObserverInterface* observer) override;
+
+  //
+  // MediaSourceInterface
+  //
+
+  SourceState state() const override { return SourceState::kLive; }
+  bool remote() const override { return false; }
+
+  //
+  // AudioSourceInterface
+  //
+
+  void SetVolume(double /*volume*/) override {}
+  void RegisterAudioObserver(AudioObserver* /*observer*/) override {}
+  void UnregisterAudioObserver(AudioObserver* /*observer*/) override {}
+  void AddSink(webrtc::AudioTrackSinkInterface* sink) override;
+  void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override;
+
+  //
+  // MessageHandler
+  //
+
+  void OnMessage(rtc::Message* message) override;
+
+ private:
+  /// Deliver the next 10 ms of audio to the sinks, padded with silence if the
+  /// ring holds less.
+  void DeliverFrame();
+
+  void ScheduleNextFrame();
+
+  const mrsExternalAudioTrackSourceSettings settings_;
+  const size_t samples_per_frame_;
+
+  /// Ring of interleaved samples, indexed by the positions modulo its
+  /// capacity. The positions only increase.
+  const size_t capacity_;
+  std::unique_ptr<int16_t[]> ring_;
+  std::atomic<uint64_t> write_pos_{0};
+  std::atomic<uint64_t> read_pos_{0};
+
+  /// Frame delivered to the sinks. Only accessed on the delivery thread.
+  std::vector<int16_t> frame_;
+
+  rtc::CriticalSection sinks_lock_;
+  std::vector<webrtc::AudioTrackSinkInterface*> sinks_
+      RTC_GUARDED_BY(sinks_lock_);
+  webrtc::ObserverInterface* observer_{nullptr};
+
+  rtc::Thread* thread_{nullptr};
+  int64_t next_frame_time_us_{0};
+};
+
+}  // namespace detail
+
+/// Audio track source sending audio pushed by the application, like
+/// synthesized or mixed audio, without going through an audio device.
+class ExternalAudioTrackSource : public AudioTrackSource {
+ public:
+  static ErrorOr<RefPtr<ExternalAudioTrackSource>> Create(
+      const mrsExternalAudioTrackSourceSettings& settings) noexcept;
+
+  ~ExternalAudioTrackSource() override;
+
+  /// See |detail::ExternalAudioSource::Push()|.
+  uint32_t PushAudio(const void* data, uint32_t frame_count) noexcept {
+    return GetSourceImpl()->Push(data, frame_count);
+  }
+
+ protected:
+  ExternalAudioTrackSource(
+      RefPtr<GlobalFactory> global_factory,
+      rtc::scoped_refptr<detail::ExternalAudioSource> source) noexcept;
+
+  detail::ExternalAudioSource* GetSourceImpl() const noexcept {
+    return static_cast<detail::ExternalAudioSource*>(source_.get());
+  }
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
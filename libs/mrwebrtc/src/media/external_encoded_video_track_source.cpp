@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "encoded_frame_relay.h"
+#include "interop/global_factory.h"
+#include "media/external_encoded_video_track_source.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Forwards the needs of the encoders to the application callbacks, until the
+/// source is destroyed.
+class ExternalEncodedVideoTrackSource::Producer : public EncodedFrameProducer {
+ public:
+  void SetKeyFrameRequestedCallback(
+      KeyFrameRequestedCallback callback) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keyframe_requested_callback_ = callback;
+  }
+
+  void SetTargetBitrateChangedCallback(
+      TargetBitrateChangedCallback callback) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bitrate_changed_callback_ = callback;
+  }
+
+  // EncodedFrameProducer
+  void RequestKeyFrame() noexcept override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keyframe_requested_callback_) {
+      keyframe_requested_callback_();
+    }
+  }
+
+  void OnTargetBitrateChanged(uint32_t bitrate_bps,
+                              uint32_t framerate) noexcept override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bitrate_changed_callback_) {
+      bitrate_changed_callback_(bitrate_bps, framerate);
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  KeyFrameRequestedCallback keyframe_requested_callback_
+      RTC_GUARDED_BY(mutex_);
+  TargetBitrateChangedCallback bitrate_changed_callback_
+      RTC_GUARDED_BY(mutex_);
+};
+
+ErrorOr<RefPtr<ExternalEncodedVideoTrackSource>>
+ExternalEncodedVideoTrackSource::Create(
+    RefPtr<GlobalFactory> global_factory) noexcept {
+#if defined(WINUWP)
+  // The UWP encoders are not wrapped to send encoded frames as is.
+  (void)global_factory;
+  return Error(Result::kUnsupported);
+#else   // defined(WINUWP)
+  rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source =
+      new rtc::RefCountedObject<detail::CustomTrackSourceAdapter>();
+  // Frames are pushed by the application as soon as the source is created, so
+  // it is already live.
+  source->state_ = webrtc::MediaSourceInterface::SourceState::kLive;
+  return RefPtr<ExternalEncodedVideoTrackSource>(
+      new ExternalEncodedVideoTrackSource(std::move(global_factory),
+                                          std::move(source)));
+#endif  // defined(WINUWP)
+}
+
+ExternalEncodedVideoTrackSource::ExternalEncodedVideoTrackSource(
+    RefPtr<GlobalFactory> global_factory,
+    rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source) noexcept
+    : VideoTrackSource(std::move(global_factory),
+                       ObjectType::kExternalEncodedVideoTrackSource,
+                       std::move(source)),
+      producer_(std::make_shared<Producer>()) {}
+
+ExternalEncodedVideoTrackSource::~ExternalEncodedVideoTrackSource() {
+  // Encoders may still hold frames referencing the producer.
+  producer_->SetKeyFrameRequestedCallback({});
+  producer_->SetTargetBitrateChangedCallback({});
+  GetSourceImpl()->state_ = webrtc::MediaSourceInterface::SourceState::kEnded;
+}
+
+void ExternalEncodedVideoTrackSource::SetKeyFrameRequestedCallback(
+    KeyFrameRequestedCallback callback) noexcept {
+  producer_->SetKeyFrameRequestedCallback(callback);
+}
+
+void ExternalEncodedVideoTrackSource::SetTargetBitrateChangedCallback(
+    TargetBitrateChangedCallback callback) noexcept {
+  producer_->SetTargetBitrateChangedCallback(callback);
+}
+
+Result ExternalEncodedVideoTrackSource::PushFrame(
+    const mrsEncodedVideoFrame& frame,
+    int64_t timestamp_ms) noexcept {
+  if (!frame.codec_name || !frame.data || (frame.size == 0)) {
+    return Result::kInvalidParameter;
+  }
+  const bool is_keyframe = (frame.is_keyframe != mrsBool::kFalse);
+  if ((frame.width > 0) && (frame.height > 0)) {
+    width_ = (int)frame.width;
+    height_ = (int)frame.height;
+  } else if (is_keyframe || (width_ == 0) || (height_ == 0)) {
+    RTC_LOG(LS_ERROR) << "Missing resolution of external encoded video frame.";
+    return Result::kInvalidParameter;
+  }
+  const webrtc::VideoCodecType codec_type =
+      webrtc::PayloadStringToCodecType(frame.codec_name);
+  if ((codec_type != webrtc::kVideoCodecVP8) &&
+      (codec_type != webrtc::kVideoCodecH264)) {
+    RTC_LOG(LS_ERROR) << "Unsupported codec " << frame.codec_name
+                      << " for external encoded video frames.";
+    return Result::kInvalidParameter;
+  }
+  rtc::scoped_refptr<EncodedVideoFrameBuffer> buffer =
+      EncodedVideoFrameBuffer::Create(
+          static_cast<const uint8_t*>(frame.data), frame.size, codec_type,
+          is_keyframe, width_, height_, next_index_++, producer_);
+  const int64_t timestamp_us =
+      (timestamp_ms != 0 ? timestamp_ms * 1000 : rtc::TimeMicros());
+  webrtc::VideoFrame video_frame{webrtc::VideoFrame::Builder()
+                                     .set_video_frame_buffer(std::move(buffer))
+                                     .set_timestamp_us(timestamp_us)
+                                     .build()};
+  GetSourceImpl()->DispatchFrame(video_frame);
+  return Result::kSuccess;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
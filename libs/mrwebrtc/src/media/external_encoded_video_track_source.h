@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+
+#include "callback.h"
+#include "external_video_track_source.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+#include "video_track_source.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Callback fired when the encoders sending the frames of an external encoded
+/// video track source need a key frame.
+using KeyFrameRequestedCallback = Callback<>;
+
+/// Callback fired when the target bitrate of an encoder sending the frames of
+/// an external encoded video track source changed, with the bitrate in bits
+/// per second and the framerate in frames per second.
+using TargetBitrateChangedCallback = Callback<uint32_t, uint32_t>;
+
+/// Video track source fed by the application with already-encoded H.264 or
+/// VP8 frames, for example produced by a hardware encoder. Local video tracks
+/// created from this source send the frames as is, without decoding nor
+/// re-encoding them, on transceivers which negotiated the same codec.
+///
+/// The frames are never decoded; the frame callbacks of the source receive
+/// black frames of the same resolution.
+class ExternalEncodedVideoTrackSource : public VideoTrackSource {
+ public:
+  /// Create a new source. This fails with |Result::kUnsupported| on platforms
+  /// where encoded frames cannot be sent as is.
+  static ErrorOr<RefPtr<ExternalEncodedVideoTrackSource>> Create(
+      RefPtr<GlobalFactory> global_factory) noexcept;
+
+  ~ExternalEncodedVideoTrackSource() override;
+
+  /// Register the callback invoked when a key frame is needed, for example
+  /// when a new remote peer starts receiving the frames. The application must
+  /// then push a key frame as soon as possible.
+  void SetKeyFrameRequestedCallback(
+      KeyFrameRequestedCallback callback) noexcept;
+
+  /// Register the callback invoked when the target bitrate of an encoder
+  /// sending the frames changed. The application should adapt the bitrate of
+  /// its encoder accordingly. When several tracks send the frames, each of
+  /// their encoders reports its own target.
+  void SetTargetBitrateChangedCallback(
+      TargetBitrateChangedCallback callback) noexcept;
+
+  /// Submit an encoded frame, which is copied and delivered to all video
+  /// tracks on the caller's thread before this returns. H.264 frames are
+  /// complete access units in Annex B format. Key frames must carry their
+  /// resolution, which delta frames may omit. The timestamp is in
+  /// milliseconds in the clock of |rtc::TimeMillis()|, or zero to use the
+  /// current time. This must not be called concurrently from several threads.
+  Result PushFrame(const mrsEncodedVideoFrame& frame,
+                   int64_t timestamp_ms) noexcept;
+
+ protected:
+  class Producer;
+
+  ExternalEncodedVideoTrackSource(
+      RefPtr<GlobalFactory> global_factory,
+      rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source) noexcept;
+
+  detail::CustomTrackSourceAdapter* GetSourceImpl() const {
+    return (detail::CustomTrackSourceAdapter*)source_.get();
+  }
+
+ private:
+  /// Receiver of the key frame requests and bitrate changes of the encoders,
+  /// which may outlive the source while encoders still hold frames.
+  std::shared_ptr<Producer> producer_;
+
+  /// Resolution of the last frame which carried one.
+  int width_{0};
+  int height_{0};
+
+  /// Index of the next frame.
+  uint64_t next_index_{1};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -3,18 +3,144 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "color_conversion.h"
+#include "encoded_frame_relay.h"
 #include "interop/global_factory.h"
+#include "latency_marker.h"
 #include "media/external_video_track_source.h"
+#include "media/native_video_frame_buffer.h"
+#include "media/synthetic_frame_generator.h"
+#include "tracing.h"
 
 namespace {
 
 using namespace Microsoft::MixedReality::WebRTC;
 
 enum {
-  /// Request a new video frame from the source.
-  MSG_REQUEST_FRAME
+  /// Request a new video frame from the source, and schedule the next one.
+  MSG_REQUEST_FRAME,
+
+  /// Request a new video frame from the source, which signaled it has one.
+  MSG_REQUEST_FRAME_ON_DEMAND,
+
+  /// Resume the periodic frame requests if a sink consumes the frames again.
+  MSG_RESUME_REQUESTS
 };
 
+/// Copy an I420 video frame into a frame buffer from the given pool. The alpha
+/// plane, if any, is discarded.
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> CreateBufferFromI420A(
+    const I420AVideoFrame& frame_view,
+    FrameBufferPool& pool) {
+  const int width = (int)frame_view.width_;
+  const int height = (int)frame_view.height_;
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      pool.CreateBuffer(width, height);
+  libyuv::I420Copy((const uint8_t*)frame_view.ydata_, frame_view.ystride_,
+                   (const uint8_t*)frame_view.udata_, frame_view.ustride_,
+                   (const uint8_t*)frame_view.vdata_, frame_view.vstride_,
+                   buffer->MutableDataY(), buffer->StrideY(),
+                   buffer->MutableDataU(), buffer->StrideU(),
+                   buffer->MutableDataV(), buffer->StrideV(), width, height);
+  return buffer;
+}
+
+/// Wrap the planes of an I420 video frame, including its alpha plane if any,
+/// into a frame buffer without copying them. |release_callback| is invoked once
+/// the buffer is destroyed. A fully opaque alpha plane is dropped, so that the
+/// multiplex encoder only encodes the YUV planes of the frame. The encoder
+/// sends frames with and without alpha on the same stream, so the alpha stream
+/// resumes with the next frame which is not opaque, without renegotiating.
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> WrapBufferFromI420A(
+    const I420AVideoFrame& frame_view,
+    Callback<> release_callback) {
+  const rtc::Callback0<void> no_longer_used(
+      [release_callback]() { release_callback(); });
+  if (frame_view.adata_ &&
+      !IsPlaneOpaque((const uint8_t*)frame_view.adata_, frame_view.astride_,
+                     (int)frame_view.width_, (int)frame_view.height_)) {
+    return webrtc::WrapI420ABuffer(
+        (int)frame_view.width_, (int)frame_view.height_,
+        (const uint8_t*)frame_view.ydata_, frame_view.ystride_,
+        (const uint8_t*)frame_view.udata_, frame_view.ustride_,
+        (const uint8_t*)frame_view.vdata_, frame_view.vstride_,
+        (const uint8_t*)frame_view.adata_, frame_view.astride_,
+        no_longer_used);
+  }
+  return webrtc::WrapI420Buffer(
+      (int)frame_view.width_, (int)frame_view.height_,
+      (const uint8_t*)frame_view.ydata_, frame_view.ystride_,
+      (const uint8_t*)frame_view.udata_, frame_view.ustride_,
+      (const uint8_t*)frame_view.vdata_, frame_view.vstride_, no_longer_used);
+}
+
+/// Convert an ARGB32 video frame into an I420 frame buffer from the given pool.
+/// The first time the frame needs truncating, this logs a warning and sets
+/// |has_warned|.
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> CreateBufferFromArgb32(
+    const Argb32VideoFrame& frame_view,
+    FrameBufferPool& pool,
+    bool& has_warned) {
+  // Check that the input frame fits within the constraints of chroma
+  // downsampling (width and height multiple of 2).
+  uint32_t width = frame_view.width_;
+  if (width & 0x1) {
+    if (!has_warned) {
+      RTC_LOG(LS_WARNING) << "ARGB32 video frame has width " << width
+                          << " which is not a multiple of 2, so cannot be "
+                             "chroma-downsampled. "
+                             "Truncating to "
+                          << (width - 1) << " before I420 conversion.";
+      has_warned = true;
+    }
+    --width;
+  }
+  uint32_t height = frame_view.height_;
+  if (height & 0x1) {
+    if (!has_warned) {
+      RTC_LOG(LS_WARNING) << "ARGB32 video frame has height " << height
+                          << " which is not a multiple of 2, so cannot be "
+                             "chroma-downsampled. "
+                             "Truncating to "
+                          << (height - 1) << " before I420 conversion.";
+      has_warned = true;
+    }
+    --height;
+  }
+
+  // Get an I420 buffer from the pool
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      pool.CreateBuffer(width, height);
+
+  // Convert to I420 and copy to buffer
+  ConvertArgb32ToI420((const uint8_t*)frame_view.argb32_data_,
+                      frame_view.stride_, buffer->MutableDataY(),
+                      buffer->StrideY(), buffer->MutableDataU(),
+                      buffer->StrideU(), buffer->MutableDataV(),
+                      buffer->StrideV(), width, height);
+
+  return buffer;
+}
+
+/// Convert an NV12 video frame into an I420 frame buffer from the given pool.
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> CreateBufferFromNv12(
+    const Nv12VideoFrame& frame_view,
+    FrameBufferPool& pool) {
+  const int width = (int)frame_view.width_;
+  const int height = (int)frame_view.height_;
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      pool.CreateBuffer(width, height);
+  libyuv::NV12ToI420((const uint8_t*)frame_view.ydata_, frame_view.ystride_,
+                     (const uint8_t*)frame_view.uvdata_, frame_view.uvstride_,
+                     buffer->MutableDataY(), buffer->StrideY(),
+                     buffer->MutableDataU(), buffer->StrideU(),
+                     buffer->MutableDataV(), buffer->StrideV(), width, height);
+  return buffer;
+}
+
 /// Buffer adapter for an I420 video frame.
 class I420ABufferAdapter : public detail::BufferAdapter {
  public:
@@ -24,16 +150,13 @@ class I420ABufferAdapter : public detail::BufferAdapter {
                       std::uint32_t request_id,
                       std::int64_t timestamp_ms) noexcept override {
     // Request a single I420 frame
-    I420AVideoFrameRequest request{track_source, timestamp_ms, request_id};
+    I420AVideoFrameRequest request{track_source, timestamp_ms, request_id,
+                                   track_source.GetSinkWants()};
     return video_source_->FrameRequested(request);
   }
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
       const I420AVideoFrame& frame_view) override {
-    return webrtc::I420Buffer::Copy(
-        (int)frame_view.width_, (int)frame_view.height_,
-        (const uint8_t*)frame_view.ydata_, frame_view.ystride_,
-        (const uint8_t*)frame_view.udata_, frame_view.ustride_,
-        (const uint8_t*)frame_view.vdata_, frame_view.vstride_);
+    return CreateBufferFromI420A(frame_view, buffer_pool_);
   }
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
       const Argb32VideoFrame& /*frame_view*/) override {
@@ -53,7 +176,8 @@ class Argb32BufferAdapter : public detail::BufferAdapter {
                       std::uint32_t request_id,
                       std::int64_t timestamp_ms) noexcept override {
     // Request a single ARGB32 frame
-    Argb32VideoFrameRequest request{track_source, timestamp_ms, request_id};
+    Argb32VideoFrameRequest request{track_source, timestamp_ms, request_id,
+                                    track_source.GetSinkWants()};
     return video_source_->FrameRequested(request);
   }
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
@@ -62,49 +186,60 @@ class Argb32BufferAdapter : public detail::BufferAdapter {
   }
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
       const Argb32VideoFrame& frame_view) override {
-    // Check that the input frame fits within the constraints of chroma
-    // downsampling (width and height multiple of 2).
-    uint32_t width = frame_view.width_;
-    if (width & 0x1) {
-      if (!has_warned_) {
-        RTC_LOG(LS_WARNING) << "ARGB32 video frame has width " << width
-                            << " which is not a multiple of 2, so cannot be "
-                               "chroma-downsampled. "
-                               "Truncating to "
-                            << (width - 1) << " before I420 conversion.";
-        has_warned_ = true;
-      }
-      --width;
-    }
-    uint32_t height = frame_view.height_;
-    if (height & 0x1) {
-      if (!has_warned_) {
-        RTC_LOG(LS_WARNING) << "ARGB32 video frame has height " << height
-                            << " which is not a multiple of 2, so cannot be "
-                               "chroma-downsampled. "
-                               "Truncating to "
-                            << (height - 1) << " before I420 conversion.";
-        has_warned_ = true;
-      }
-      --height;
-    }
+    return CreateBufferFromArgb32(frame_view, buffer_pool_, has_warned_);
+  }
 
-    // Create I420 buffer
-    rtc::scoped_refptr<webrtc::I420Buffer> buffer =
-        webrtc::I420Buffer::Create(width, height);
+ private:
+  RefPtr<Argb32ExternalVideoSource> video_source_;
+  bool has_warned_ = false;
+};
+
+/// Buffer adapter for a synthetic source, completing each frame request with a
+/// test pattern generated natively, without invoking any callback.
+class SyntheticBufferAdapter : public detail::BufferAdapter {
+ public:
+  explicit SyntheticBufferAdapter(const mrsSyntheticVideoSourceConfig& config)
+      : generator_(config) {}
+  Result RequestFrame(ExternalVideoTrackSource& track_source,
+                      std::uint32_t request_id,
+                      std::int64_t timestamp_ms) noexcept override {
+    return track_source.CompleteRequest(request_id, timestamp_ms,
+                                        generator_.NextFrame(buffer_pool_));
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const I420AVideoFrame& frame_view) override {
+    return CreateBufferFromI420A(frame_view, buffer_pool_);
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Argb32VideoFrame& frame_view) override {
+    return CreateBufferFromArgb32(frame_view, buffer_pool_, has_warned_);
+  }
 
-    // Convert to I420 and copy to buffer
-    libyuv::ARGBToI420((const uint8_t*)frame_view.argb32_data_,
-                       frame_view.stride_, buffer->MutableDataY(),
-                       buffer->StrideY(), buffer->MutableDataU(),
-                       buffer->StrideU(), buffer->MutableDataV(),
-                       buffer->StrideV(), width, height);
+ private:
+  /// Generator of the frames, only used on the capture thread.
+  SyntheticFrameGenerator generator_;
+  bool has_warned_ = false;
+};
 
-    return buffer;
+/// Buffer adapter for a push-model source. Frames are pushed directly with
+/// |ExternalVideoTrackSource::PushFrame()|, and never requested.
+class PushBufferAdapter : public detail::BufferAdapter {
+ public:
+  Result RequestFrame(ExternalVideoTrackSource& /*track_source*/,
+                      std::uint32_t /*request_id*/,
+                      std::int64_t /*timestamp_ms*/) noexcept override {
+    return Result::kUnsupported;
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const I420AVideoFrame& frame_view) override {
+    return CreateBufferFromI420A(frame_view, buffer_pool_);
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Argb32VideoFrame& frame_view) override {
+    return CreateBufferFromArgb32(frame_view, buffer_pool_, has_warned_);
   }
 
  private:
-  RefPtr<Argb32ExternalVideoSource> video_source_;
   bool has_warned_ = false;
 };
 
@@ -114,7 +249,96 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
-constexpr const size_t kMaxPendingRequestCount = 64;
+mrsExternalVideoSinkWants detail::CustomTrackSourceAdapter::GetSinkWants()
+    const {
+  // Combine the wants of all sinks, like |rtc::VideoBroadcaster| does before
+  // forwarding them to the video adapter.
+  int max_pixel_count = std::numeric_limits<int>::max();
+  int target_pixel_count = std::numeric_limits<int>::max();
+  int max_framerate = std::numeric_limits<int>::max();
+  {
+    rtc::CritScope lock(&wants_lock_);
+    for (auto&& pair : sink_wants_) {
+      const rtc::VideoSinkWants& wants = pair.second;
+      max_pixel_count = std::min(max_pixel_count, wants.max_pixel_count);
+      if (wants.target_pixel_count) {
+        target_pixel_count =
+            std::min(target_pixel_count, *wants.target_pixel_count);
+      }
+      max_framerate = std::min(max_framerate, wants.max_framerate_fps);
+    }
+  }
+  mrsExternalVideoSinkWants result;
+  if (max_pixel_count != std::numeric_limits<int>::max()) {
+    result.max_pixel_count = static_cast<uint32_t>(max_pixel_count);
+  }
+  if (target_pixel_count != std::numeric_limits<int>::max()) {
+    result.target_pixel_count = static_cast<uint32_t>(
+        std::min(target_pixel_count, max_pixel_count));
+  }
+  if (max_framerate != std::numeric_limits<int>::max()) {
+    result.max_framerate = static_cast<float>(max_framerate);
+  }
+  return result;
+}
+
+detail::CustomTrackSourceAdapter::Demand
+detail::CustomTrackSourceAdapter::GetDemand() const {
+  Demand demand = Demand::kNone;
+  rtc::CritScope lock(&wants_lock_);
+  for (auto&& pair : sink_wants_) {
+    if (!VideoFrameObserver::IsSinkActive(pair.first)) {
+      continue;
+    }
+    if (!pair.second.black_frames) {
+      return Demand::kFrames;
+    }
+    demand = Demand::kBlackFrames;
+  }
+  return demand;
+}
+
+void detail::CustomTrackSourceAdapter::SetSinksChangedCallback(
+    std::function<void()> callback) {
+  rtc::CritScope lock(&wants_lock_);
+  sinks_changed_callback_ = std::move(callback);
+}
+
+void detail::CustomTrackSourceAdapter::AddOrUpdateSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+    const rtc::VideoSinkWants& wants) {
+  rtc::AdaptedVideoTrackSource::AddOrUpdateSink(sink, wants);
+  rtc::CritScope lock(&wants_lock_);
+  auto it = std::find_if(sink_wants_.begin(), sink_wants_.end(),
+                         [sink](auto&& pair) { return pair.first == sink; });
+  if (it != sink_wants_.end()) {
+    it->second = wants;
+  } else {
+    sink_wants_.emplace_back(sink, wants);
+  }
+  if (sinks_changed_callback_) {
+    sinks_changed_callback_();
+  }
+}
+
+void detail::CustomTrackSourceAdapter::RemoveSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  rtc::AdaptedVideoTrackSource::RemoveSink(sink);
+  rtc::CritScope lock(&wants_lock_);
+  auto it = std::find_if(sink_wants_.begin(), sink_wants_.end(),
+                         [sink](auto&& pair) { return pair.first == sink; });
+  if (it != sink_wants_.end()) {
+    sink_wants_.erase(it);
+  }
+  if (sinks_changed_callback_) {
+    sinks_changed_callback_();
+  }
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> detail::BufferAdapter::FillBuffer(
+    const Nv12VideoFrame& frame_view) {
+  return CreateBufferFromNv12(frame_view, buffer_pool_);
+}
 
 RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::create(
     RefPtr<GlobalFactory> global_factory,
@@ -129,6 +353,21 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::create(
   return source;
 }
 
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createForPush(
+    RefPtr<GlobalFactory> global_factory) {
+  RefPtr<ExternalVideoTrackSource> source =
+      create(std::move(global_factory), std::make_unique<PushBufferAdapter>());
+  source->push_mode_ = true;
+  return source;
+}
+
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createSynthetic(
+    RefPtr<GlobalFactory> global_factory,
+    const mrsSyntheticVideoSourceConfig& config) {
+  return create(std::move(global_factory),
+                std::make_unique<SyntheticBufferAdapter>(config));
+}
+
 ExternalVideoTrackSource::ExternalVideoTrackSource(
     RefPtr<GlobalFactory> global_factory,
     std::unique_ptr<detail::BufferAdapter> adapter,
@@ -136,15 +375,55 @@ ExternalVideoTrackSource::ExternalVideoTrackSource(
     : VideoTrackSource(std::move(global_factory),
                        ObjectType::kExternalVideoTrackSource,
                        source),
-      adapter_(std::forward<std::unique_ptr<detail::BufferAdapter>>(adapter)),
-      capture_thread_(rtc::Thread::Create()) {
-  capture_thread_->SetName("ExternalVideoTrackSource capture thread", this);
-}
+      adapter_(std::forward<std::unique_ptr<detail::BufferAdapter>>(adapter)) {}
 
 ExternalVideoTrackSource::~ExternalVideoTrackSource() {
   StopCapture();
 }
 
+Result ExternalVideoTrackSource::Configure(
+    const mrsExternalVideoTrackSourceSettings& settings) {
+  if (GetSourceImpl()->state_ != SourceState::kInitializing) {
+    RTC_LOG(LS_ERROR) << "Cannot configure external video track source "
+                      << GetName().c_str() << " after capture started.";
+    return Result::kInvalidOperation;
+  }
+  if (push_mode_) {
+    // Push sources never request frames
+    return Result::kInvalidOperation;
+  }
+  switch (settings.scheduling) {
+    case mrsExternalVideoFrameScheduling::kPeriodic:
+      if (!(settings.framerate > 0.0f) || (settings.framerate > 1000.0f)) {
+        RTC_LOG(LS_ERROR) << "Invalid framerate " << settings.framerate
+                          << " for external video track source.";
+        return Result::kInvalidParameter;
+      }
+      frame_interval_us_ =
+          static_cast<int64_t>(rtc::kNumMicrosecsPerSec / settings.framerate);
+      on_demand_ = false;
+      break;
+    case mrsExternalVideoFrameScheduling::kOnDemand:
+      on_demand_ = true;
+      break;
+    default:
+      return Result::kInvalidParameter;
+  }
+  use_dedicated_thread_ = settings.dedicated_thread;
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::NotifyFrameAvailable() {
+  if (!on_demand_) {
+    return Result::kInvalidOperation;
+  }
+  if (GetSourceImpl()->state_ != SourceState::kLive) {
+    return Result::kInvalidOperation;
+  }
+  capture_thread_->Post(RTC_FROM_HERE, this, MSG_REQUEST_FRAME_ON_DEMAND);
+  return Result::kSuccess;
+}
+
 void ExternalVideoTrackSource::FinishCreation() {
   StartCapture();
 }
@@ -158,101 +437,490 @@ void ExternalVideoTrackSource::StartCapture() {
   RTC_LOG(LS_INFO) << "Starting capture for external video track source "
                    << GetName().c_str();
 
-  // Start capture thread
+  // Push sources deliver frames on the caller's thread, and do not need any
+  // capture thread.
+  if (push_mode_) {
+    GetSourceImpl()->state_ = SourceState::kLive;
+    return;
+  }
+
+  // Multiplex the frame requests on the shared scheduler thread, unless a
+  // dedicated thread was requested.
+  if (!use_dedicated_thread_) {
+    capture_thread_ = global_factory_->GetCaptureSchedulerThread();
+  }
+  if (!capture_thread_) {
+    dedicated_thread_ = rtc::Thread::Create();
+    dedicated_thread_->SetName("ExternalVideoTrackSource capture thread", this);
+    dedicated_thread_->Start();
+    capture_thread_ = dedicated_thread_.get();
+  }
+  {
+    rtc::CritScope lock(&request_lock_);
+    pending_requests_.Clear();
+  }
   GetSourceImpl()->state_ = SourceState::kLive;
-  pending_requests_.clear();
-  capture_thread_->Start();
 
-  // Schedule first frame request for 10ms from now
-  int64_t now = rtc::TimeMillis();
-  capture_thread_->PostAt(RTC_FROM_HERE, now + 10, this, MSG_REQUEST_FRAME);
+  // Schedule first frame request for 10ms from now, unless the application
+  // signals the frames itself. Periodic requests pause while no sink consumes
+  // the frames, and resume once the sinks change.
+  if (!on_demand_) {
+    requests_paused_ = false;
+    rtc::Thread* const thread = capture_thread_;
+    GetSourceImpl()->SetSinksChangedCallback([thread, this]() {
+      thread->Post(RTC_FROM_HERE, this, MSG_RESUME_REQUESTS);
+    });
+    next_request_time_us_ =
+        rtc::TimeMicros() + 10 * rtc::kNumMicrosecsPerMillisec;
+    ScheduleNextRequest();
+  }
 }
 
-Result ExternalVideoTrackSource::CompleteRequest(
+Result ExternalVideoTrackSource::ConsumeRequest(
     uint32_t request_id,
-    int64_t timestamp_ms,
-    const I420AVideoFrame& frame_view) {
-  // Validate pending request ID and retrieve frame timestamp
-  int64_t timestamp_ms_original = -1;
+    absl::optional<int64_t> capture_time_us,
+    int64_t& timestamp_us) {
+  int64_t mapped_capture_time_us = -1;
+  if (capture_time_us) {
+    mapped_capture_time_us = MapCaptureTimeUs(*capture_time_us);
+    if (mapped_capture_time_us < 0) {
+      return Result::kInvalidParameter;
+    }
+  }
+  int64_t timestamp_ms = -1;
   {
     rtc::CritScope lock(&request_lock_);
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end();
-         ++it) {
-      if (it->first == request_id) {
-        timestamp_ms_original = it->second;
-        // Remove outdated requests, including current one
-        ++it;
-        pending_requests_.erase(pending_requests_.begin(), it);
-        break;
-      }
+    // Remove outdated requests, including current one
+    timestamp_ms = pending_requests_.Consume(request_id);
+  }
+  if (timestamp_ms < 0) {
+    return Result::kInvalidParameter;
+  }
+  timestamp_us = NextTimestampUs(timestamp_ms, mapped_capture_time_us);
+  return Result::kSuccess;
+}
+
+template <typename FrameView>
+void ExternalVideoTrackSource::AdaptAndDispatchFrame(
+    const FrameView& frame_view,
+    int64_t timestamp_us,
+    FrameMetadata metadata) {
+  detail::FrameAdaptation adaptation;
+  if (!GetSourceImpl()->AdaptFrameSize((int)frame_view.width_,
+                                       (int)frame_view.height_, timestamp_us,
+                                       adaptation)) {
+    return;
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer;
+  {
+    MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::FillBuffer", "source",
+                     (intptr_t)this, "timestamp_us", timestamp_us);
+    buffer = adapter_->FillBuffer(frame_view);
+  }
+  DispatchAdaptedFrame(std::move(buffer), timestamp_us, adaptation,
+                       std::move(metadata));
+}
+
+void ExternalVideoTrackSource::DispatchFrame(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    int64_t timestamp_us,
+    FrameMetadata metadata) {
+  detail::FrameAdaptation adaptation;
+  if (!GetSourceImpl()->AdaptFrameSize(buffer->width(), buffer->height(),
+                                       timestamp_us, adaptation)) {
+    return;
+  }
+  DispatchAdaptedFrame(std::move(buffer), timestamp_us, adaptation,
+                       std::move(metadata));
+}
+
+void ExternalVideoTrackSource::DispatchAdaptedFrame(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    int64_t timestamp_us,
+    const detail::FrameAdaptation& adaptation,
+    FrameMetadata metadata) {
+  const bool is_adapted = (adaptation.width_ != buffer->width()) ||
+                          (adaptation.height_ != buffer->height()) ||
+                          (adaptation.crop_width_ != buffer->width()) ||
+                          (adaptation.crop_height_ != buffer->height());
+  const bool stamp_marker =
+      latency_markers_.load(std::memory_order_relaxed) &&
+      (adaptation.width_ >= LatencyMarkerCodec::kMinWidth);
+  if ((is_adapted || stamp_marker) &&
+      (buffer->type() != webrtc::VideoFrameBuffer::Type::kNative)) {
+    // The buffer can be smaller than the frame it was filled from, if it was
+    // truncated for chroma downsampling.
+    const int crop_width =
+        std::min(adaptation.crop_width_, buffer->width() - adaptation.crop_x_);
+    const int crop_height = std::min(adaptation.crop_height_,
+                                     buffer->height() - adaptation.crop_y_);
+    rtc::scoped_refptr<webrtc::I420Buffer> scaled_buffer =
+        scaled_buffer_pool_.CreateBuffer(adaptation.width_,
+                                         adaptation.height_);
+    scaled_buffer->CropAndScaleFrom(*buffer->ToI420(), adaptation.crop_x_,
+                                    adaptation.crop_y_, crop_width,
+                                    crop_height);
+    if (stamp_marker) {
+      // Stamp after scaling, so the marker is not blurred by it.
+      LatencyMarker marker;
+      marker.frame_number_ = next_marker_frame_number_.fetch_add(1);
+      marker.capture_time_utc_us_ =
+          rtc::TimeUTCMicros() - (rtc::TimeMicros() - timestamp_us);
+      LatencyMarkerCodec::Write(
+          marker, scaled_buffer->MutableDataY(), scaled_buffer->StrideY(),
+          scaled_buffer->MutableDataU(), scaled_buffer->StrideU(),
+          scaled_buffer->MutableDataV(), scaled_buffer->StrideV(),
+          scaled_buffer->width(), scaled_buffer->height());
     }
-    if (timestamp_ms_original < 0) {
+    buffer = std::move(scaled_buffer);
+  }
+  webrtc::VideoFrame frame{webrtc::VideoFrame::Builder()
+                               .set_video_frame_buffer(std::move(buffer))
+                               .set_timestamp_us(timestamp_us)
+                               .build()};
+  if (metadata) {
+    AttachFrameMetadata(frame, std::move(metadata));
+  }
+  if (keyframe_on_resume_.load(std::memory_order_relaxed) &&
+      keyframe_on_resume_.exchange(false, std::memory_order_relaxed)) {
+    // The frames skipped were never encoded, so start again from a key frame
+    // for the receivers to resume decoding without waiting for one.
+    RequestKeyFrameForFrame(frame);
+  }
+  GetSourceImpl()->DispatchFrame(frame);
+}
+
+Result ExternalVideoTrackSource::CopyFrameMetadata(
+    const void* data,
+    size_t size,
+    FrameMetadata& metadata) noexcept {
+  if ((size > kMaxFrameMetadataSize) || (!data && (size > 0))) {
+    return Result::kInvalidParameter;
+  }
+  metadata = nullptr;
+  if (size > 0) {
+    metadata = std::make_shared<const rtc::Buffer>(
+        static_cast<const uint8_t*>(data), size);
+  }
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::SetContentHint(
+    mrsVideoContentHint content_hint,
+    mrsOptBool denoising) noexcept {
+  switch (content_hint) {
+    case mrsVideoContentHint::kNone:
+    case mrsVideoContentHint::kMotion:
+    case mrsVideoContentHint::kDetail:
+    case mrsVideoContentHint::kText:
+      break;
+    default:
       return Result::kInvalidParameter;
-    }
   }
+  if ((denoising != mrsOptBool::kTrue) && (denoising != mrsOptBool::kFalse) &&
+      (denoising != mrsOptBool::kUnset)) {
+    return Result::kInvalidParameter;
+  }
+  GetSourceImpl()->SetContentHint(content_hint, denoising);
+  return Result::kSuccess;
+}
+
+void ExternalVideoTrackSource::SyncCaptureClock(int64_t app_time_us) noexcept {
+  capture_clock_offset_us_.store(rtc::TimeMicros() - app_time_us,
+                                 std::memory_order_relaxed);
+}
+
+int64_t ExternalVideoTrackSource::MapCaptureTimeUs(
+    int64_t capture_time_us) const noexcept {
+  const int64_t time_us =
+      capture_time_us +
+      capture_clock_offset_us_.load(std::memory_order_relaxed);
+  return (time_us > 0 ? time_us : -1);
+}
 
-  // Apply user override if any
-  if (timestamp_ms != timestamp_ms_original) {
-    timestamp_ms = timestamp_ms_original;
+int64_t ExternalVideoTrackSource::NextTimestampUs(
+    int64_t timestamp_ms,
+    int64_t capture_time_us) noexcept {
+  int64_t timestamp_us = capture_time_us;
+  if (timestamp_us < 0) {
+    timestamp_us = timestamp_ms * rtc::kNumMicrosecsPerMillisec;
+  } else {
+    // A capture time in the future would delay the playout of the frame.
+    timestamp_us = std::min(timestamp_us, rtc::TimeMicros());
   }
+  // The encoder and the receiver expect increasing timestamps; a capture
+  // time older than the previous frame can come from a clock drift.
+  int64_t last_us = last_timestamp_us_.load(std::memory_order_relaxed);
+  do {
+    timestamp_us = std::max(timestamp_us, last_us + 1);
+  } while (!last_timestamp_us_.compare_exchange_weak(
+      last_us, timestamp_us, std::memory_order_relaxed));
+  return timestamp_us;
+}
 
-  // Create and dispatch the video frame
-  webrtc::VideoFrame frame{
-      webrtc::VideoFrame::Builder()
-          .set_video_frame_buffer(adapter_->FillBuffer(frame_view))
-          .set_timestamp_ms(timestamp_ms)
-          .build()};
-  GetSourceImpl()->DispatchFrame(frame);
+Result ExternalVideoTrackSource::CompleteRequest(
+    uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    const I420AVideoFrame& frame_view,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  // Validate pending request ID and retrieve frame timestamp. The timestamp
+  // passed by the caller is ignored, to keep timestamps monotonic; capture
+  // times are passed as |capture_time_us| instead.
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::CompleteRequestNoCopy(
+    uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    const I420AVideoFrame& frame_view,
+    Callback<> release_callback,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  DispatchFrame(WrapBufferFromI420A(frame_view, release_callback),
+                timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::CompleteRequest(
+    uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    const Argb32VideoFrame& frame_view,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  // Validate pending request ID and retrieve frame timestamp. The timestamp
+  // passed by the caller is ignored, to keep timestamps monotonic; capture
+  // times are passed as |capture_time_us| instead.
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::CompleteRequest(
+    uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    const Nv12VideoFrame& frame_view,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
   return Result::kSuccess;
 }
 
 Result ExternalVideoTrackSource::CompleteRequest(
     uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    const mrsNativeVideoFrame& frame,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  DispatchFrame(NativeVideoFrameBuffer::Create(frame), timestamp_us,
+                std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::CompleteRequest(
+    uint32_t request_id,
+    int64_t /*timestamp_ms*/,
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  MRS_TRACE_SCOPE2(Media, "ExternalVideoTrackSource::CompleteRequest",
+                   "source", (intptr_t)this, "request_id", request_id);
+  int64_t timestamp_us = 0;
+  const Result result =
+      ConsumeRequest(request_id, capture_time_us, timestamp_us);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  DispatchFrame(std::move(buffer), timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::PreparePush(
     int64_t timestamp_ms,
-    const Argb32VideoFrame& frame_view) {
-  // Validate pending request ID and retrieve frame timestamp
-  int64_t timestamp_ms_original = -1;
-  {
-    rtc::CritScope lock(&request_lock_);
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end();
-         ++it) {
-      if (it->first == request_id) {
-        timestamp_ms_original = it->second;
-        // Remove outdated requests, including current one
-        ++it;
-        pending_requests_.erase(pending_requests_.begin(), it);
-        break;
-      }
-    }
-    if (timestamp_ms_original < 0) {
+    absl::optional<int64_t> capture_time_us,
+    int64_t& timestamp_us) noexcept {
+  if (!push_mode_ || (GetSourceImpl()->state_ != SourceState::kLive)) {
+    return Result::kInvalidOperation;
+  }
+  int64_t mapped_capture_time_us = -1;
+  if (capture_time_us) {
+    mapped_capture_time_us = MapCaptureTimeUs(*capture_time_us);
+    if (mapped_capture_time_us < 0) {
       return Result::kInvalidParameter;
     }
   }
+  if (timestamp_ms <= 0) {
+    timestamp_ms = rtc::TimeMillis();
+  }
+  timestamp_us = NextTimestampUs(timestamp_ms, mapped_capture_time_us);
+  return Result::kSuccess;
+}
 
-  // Apply user override if any
-  if (timestamp_ms != timestamp_ms_original) {
-    timestamp_ms = timestamp_ms_original;
+Result ExternalVideoTrackSource::PushFrame(
+    const I420AVideoFrame& frame_view,
+    int64_t timestamp_ms,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  int64_t timestamp_us = 0;
+  const Result result =
+      PreparePush(timestamp_ms, capture_time_us, timestamp_us);
+  if ((result != Result::kSuccess) || !IsFrameWanted()) {
+    return result;
   }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
 
-  // Create and dispatch the video frame
-  webrtc::VideoFrame frame{
-      webrtc::VideoFrame::Builder()
-          .set_video_frame_buffer(adapter_->FillBuffer(frame_view))
-          .set_timestamp_ms(timestamp_ms)
-          .build()};
-  GetSourceImpl()->DispatchFrame(frame);
+Result ExternalVideoTrackSource::PushFrame(
+    const Argb32VideoFrame& frame_view,
+    int64_t timestamp_ms,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  int64_t timestamp_us = 0;
+  const Result result =
+      PreparePush(timestamp_ms, capture_time_us, timestamp_us);
+  if ((result != Result::kSuccess) || !IsFrameWanted()) {
+    return result;
+  }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::PushFrame(
+    const Nv12VideoFrame& frame_view,
+    int64_t timestamp_ms,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  int64_t timestamp_us = 0;
+  const Result result =
+      PreparePush(timestamp_ms, capture_time_us, timestamp_us);
+  if ((result != Result::kSuccess) || !IsFrameWanted()) {
+    return result;
+  }
+  AdaptAndDispatchFrame(frame_view, timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::PushFrame(
+    const mrsNativeVideoFrame& frame,
+    int64_t timestamp_ms,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  int64_t timestamp_us = 0;
+  const Result result =
+      PreparePush(timestamp_ms, capture_time_us, timestamp_us);
+  if ((result != Result::kSuccess) || !IsFrameWanted()) {
+    return result;
+  }
+  DispatchFrame(NativeVideoFrameBuffer::Create(frame), timestamp_us,
+                std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::PushFrame(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    int64_t timestamp_ms,
+    absl::optional<int64_t> capture_time_us,
+    FrameMetadata metadata) {
+  int64_t timestamp_us = 0;
+  const Result result =
+      PreparePush(timestamp_ms, capture_time_us, timestamp_us);
+  if ((result != Result::kSuccess) || !IsFrameWanted()) {
+    return result;
+  }
+  DispatchFrame(std::move(buffer), timestamp_us, std::move(metadata));
+  return Result::kSuccess;
+}
+
+Result ExternalVideoTrackSource::ReadFromSharedMemory(
+    const char* mapping_name,
+    const char* doorbell_event_name) {
+  if (!push_mode_ || shared_memory_reader_) {
+    return Result::kInvalidOperation;
+  }
+  const Result result = SharedMemoryFrameReader::Open(
+      mapping_name, doorbell_event_name, shared_memory_reader_);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  shared_memory_reader_->Start(this);
   return Result::kSuccess;
 }
 
+mrsExternalVideoSinkWants ExternalVideoTrackSource::GetSinkWants() const {
+  return GetSourceImpl()->GetSinkWants();
+}
+
+FrameBufferPoolStats ExternalVideoTrackSource::GetBufferPoolStats()
+    const noexcept {
+  if (!adapter_) {
+    return {};
+  }
+  return adapter_->GetBufferPoolStats();
+}
+
 void ExternalVideoTrackSource::StopCapture() {
+  if (shared_memory_reader_) {
+    shared_memory_reader_->Stop();
+  }
   detail::CustomTrackSourceAdapter* const src = GetSourceImpl();
   if (src->state_ != SourceState::kEnded) {
     RTC_LOG(LS_INFO) << "Stopping capture for external video track source "
                      << GetName().c_str();
-    capture_thread_->Stop();
     src->state_ = SourceState::kEnded;
+    src->SetSinksChangedCallback(nullptr);
+    if (dedicated_thread_) {
+      dedicated_thread_->Stop();
+    } else if (capture_thread_) {
+      // Wait for any request in progress for this source on the shared thread,
+      // then drop the pending ones, without stopping the other sources.
+      rtc::Thread* const thread = capture_thread_;
+      thread->Invoke<void>(RTC_FROM_HERE,
+                           [thread, this]() { thread->Clear(this); });
+    }
   }
-  pending_requests_.clear();
+  rtc::CritScope lock(&request_lock_);
+  pending_requests_.Clear();
 }
 
 void ExternalVideoTrackSource::Shutdown() noexcept {
@@ -262,32 +930,98 @@ void ExternalVideoTrackSource::Shutdown() noexcept {
 
 // Note - This is called on the capture thread only.
 void ExternalVideoTrackSource::OnMessage(rtc::Message* message) {
+  // Drop requests posted concurrently with |StopCapture()|
+  if (GetSourceImpl()->state_ != SourceState::kLive) {
+    return;
+  }
   switch (message->message_id) {
     case MSG_REQUEST_FRAME:
-      const int64_t now = rtc::TimeMillis();
-
-      // Request a frame from the external video source
-      uint32_t request_id = 0;
+      // Pause without scheduling the next request while no sink consumes the
+      // frames, until |ResumeRequests()|.
+      if (!IsFrameWanted()) {
+        requests_paused_ = true;
+        break;
+      }
+      RequestFrame();
+      // Advance the deadline by exactly one interval, so that the time spent
+      // in the request does not accumulate. If the source fell behind by more
+      // than one interval, for example after a slow request, skip the missed
+      // frames instead of requesting them in a burst.
+      next_request_time_us_ += frame_interval_us_;
       {
-        rtc::CritScope lock(&request_lock_);
-        // Discard an old request if no space available. This allows restarting
-        // after a long delay, otherwise skipping the request generally also
-        // prevent the user from calling CompleteFrame() to make some space for
-        // more. The queue is still useful for just-in-time or short delays.
-        if (pending_requests_.size() >= kMaxPendingRequestCount) {
-          pending_requests_.erase(pending_requests_.begin());
+        const int64_t now_us = rtc::TimeMicros();
+        if (next_request_time_us_ + frame_interval_us_ < now_us) {
+          next_request_time_us_ = now_us;
         }
-        request_id = next_request_id_++;
-        pending_requests_.emplace_back(request_id, now);
       }
-      adapter_->RequestFrame(*this, request_id, now);
+      ScheduleNextRequest();
+      break;
+    case MSG_REQUEST_FRAME_ON_DEMAND:
+      if (IsFrameWanted()) {
+        RequestFrame();
+      }
+      break;
+    case MSG_RESUME_REQUESTS:
+      ResumeRequests();
+      break;
+  }
+}
 
-      // Schedule a new request for 30ms from now
-      //< TODO - this is unreliable and prone to drifting; figure out something
-      // better
-      capture_thread_->PostAt(RTC_FROM_HERE, now + 30, this, MSG_REQUEST_FRAME);
+bool ExternalVideoTrackSource::IsFrameWanted() noexcept {
+  using Demand = detail::CustomTrackSourceAdapter::Demand;
+  switch (GetSourceImpl()->GetDemand()) {
+    case Demand::kFrames:
+      black_frame_produced_.store(false, std::memory_order_relaxed);
+      if (frames_skipped_.exchange(false, std::memory_order_relaxed)) {
+        keyframe_on_resume_.store(true, std::memory_order_relaxed);
+      }
+      return true;
+    case Demand::kBlackFrames:
+      if (!black_frame_produced_.exchange(true, std::memory_order_relaxed)) {
+        return true;
+      }
+      break;
+    case Demand::kNone:
+      black_frame_produced_.store(false, std::memory_order_relaxed);
       break;
   }
+  frames_skipped_.store(true, std::memory_order_relaxed);
+  return false;
+}
+
+void ExternalVideoTrackSource::ResumeRequests() {
+  if (!requests_paused_ || (GetSourceImpl()->GetDemand() ==
+                            detail::CustomTrackSourceAdapter::Demand::kNone)) {
+    return;
+  }
+  requests_paused_ = false;
+  next_request_time_us_ = rtc::TimeMicros();
+  ScheduleNextRequest();
+}
+
+void ExternalVideoTrackSource::RequestFrame() {
+  const int64_t now = rtc::TimeMillis();
+
+  // Request a frame from the external video source
+  uint32_t request_id = 0;
+  {
+    rtc::CritScope lock(&request_lock_);
+    // Discard an old request if no space available. This allows restarting
+    // after a long delay, otherwise skipping the request generally also
+    // prevent the user from calling CompleteFrame() to make some space for
+    // more. The queue is still useful for just-in-time or short delays.
+    request_id = pending_requests_.Push(now);
+  }
+  adapter_->RequestFrame(*this, request_id, now);
+}
+
+void ExternalVideoTrackSource::ScheduleNextRequest() {
+  // Round up to the next millisecond, the resolution of |PostAt()|, to never
+  // request a frame ahead of its deadline.
+  const int64_t deadline_ms =
+      (next_request_time_us_ + rtc::kNumMicrosecsPerMillisec - 1) /
+      rtc::kNumMicrosecsPerMillisec;
+  capture_thread_->PostAt(RTC_FROM_HERE, deadline_ms, this, MSG_REQUEST_FRAME);
 }
 
 RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createFromI420A(
@@ -3,9 +3,20 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "absl/types/optional.h"
+
+#include "callback.h"
 #include "external_video_track_source_interop.h"
+#include "frame_buffer_pool.h"
+#include "frame_metadata.h"
 #include "mrs_errors.h"
 #include "refptr.h"
+#include "shared_memory_frame_reader.h"
 #include "tracked_object.h"
 #include "video_frame.h"
 #include "video_track_source.h"
@@ -35,17 +46,101 @@ class BufferAdapter {
       const I420AVideoFrame& frame_view) = 0;
   virtual rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
       const Argb32VideoFrame& frame_view) = 0;
+
+  /// Allocate a new video frame buffer with an NV12 video frame. Since the
+  /// conversion does not depend on the source, all adapters share it by
+  /// default.
+  virtual rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Nv12VideoFrame& frame_view);
+
+  /// Get the statistics of the pool of buffers allocated by |FillBuffer()|.
+  FrameBufferPoolStats GetBufferPoolStats() const noexcept {
+    return buffer_pool_.GetStats();
+  }
+
+ protected:
+  /// Pool of frame buffers filled with the frames provided by the source.
+  FrameBufferPool buffer_pool_;
+};
+
+/// Output size and crop rectangle of a frame adapted to the sink wants.
+struct FrameAdaptation {
+  int width_ = 0;
+  int height_ = 0;
+  int crop_width_ = 0;
+  int crop_height_ = 0;
+  int crop_x_ = 0;
+  int crop_y_ = 0;
 };
 
 /// Adapter to bridge a video track source to the underlying core
 /// implementation.
 struct CustomTrackSourceAdapter : public rtc::AdaptedVideoTrackSource {
+  /// Demand of the sinks for the frames of the source.
+  enum class Demand {
+    /// No sink consumes the frames.
+    kNone,
+    /// Only sinks of disabled tracks consume the frames, which they replace
+    /// with black frames.
+    kBlackFrames,
+    /// At least one sink consumes the frames as they are.
+    kFrames
+  };
+
   void DispatchFrame(const webrtc::VideoFrame& frame) { OnFrame(frame); }
 
+  /// Adapt a frame of the given size captured at |time_us| to the resolution
+  /// and framerate wanted by the sinks. Return |false| if the frame should be
+  /// dropped, without spending any time to produce it.
+  bool AdaptFrameSize(int width,
+                      int height,
+                      int64_t time_us,
+                      FrameAdaptation& adaptation) {
+    return AdaptFrame(width, height, time_us, &adaptation.width_,
+                      &adaptation.height_, &adaptation.crop_width_,
+                      &adaptation.crop_height_, &adaptation.crop_x_,
+                      &adaptation.crop_y_);
+  }
+
+  /// Get the combined wants of all sinks.
+  mrsExternalVideoSinkWants GetSinkWants() const;
+
+  /// Get the demand of the sinks for the frames. Frame observers only count
+  /// while they have callbacks, see |VideoFrameObserver::IsSinkActive()|.
+  Demand GetDemand() const;
+
+  /// Set the callback invoked after a sink was added, updated, or removed,
+  /// which may change the demand. The callback is invoked on the thread
+  /// updating the sink, and is never invoked again once this returns with an
+  /// empty callback.
+  void SetSinksChangedCallback(std::function<void()> callback);
+
+  // VideoSourceInterface
+  void AddOrUpdateSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+                       const rtc::VideoSinkWants& wants) override;
+  void RemoveSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) override;
+
+  /// Set the hint about the content of the frames and the denoising
+  /// preference, read by the video senders when they are configured.
+  void SetContentHint(mrsVideoContentHint content_hint,
+                      mrsOptBool denoising) noexcept {
+    content_hint_.store(content_hint, std::memory_order_relaxed);
+    denoising_.store(denoising, std::memory_order_relaxed);
+  }
+
   // VideoTrackSourceInterface
-  bool is_screencast() const override { return false; }
+  bool is_screencast() const override {
+    const mrsVideoContentHint content_hint =
+        content_hint_.load(std::memory_order_relaxed);
+    return (content_hint == mrsVideoContentHint::kDetail) ||
+           (content_hint == mrsVideoContentHint::kText);
+  }
   absl::optional<bool> needs_denoising() const override {
-    return absl::nullopt;
+    const mrsOptBool denoising = denoising_.load(std::memory_order_relaxed);
+    if (denoising == mrsOptBool::kUnset) {
+      return absl::nullopt;
+    }
+    return (denoising == mrsOptBool::kTrue);
   }
 
   // MediaSourceInterface
@@ -53,6 +148,69 @@ struct CustomTrackSourceAdapter : public rtc::AdaptedVideoTrackSource {
   bool remote() const override { return false; }
 
   SourceState state_ = SourceState::kInitializing;
+
+ private:
+  rtc::CriticalSection wants_lock_;
+
+  /// Wants of each sink, to combine them like |rtc::VideoBroadcaster| does.
+  std::vector<std::pair<rtc::VideoSinkInterface<webrtc::VideoFrame>*,
+                        rtc::VideoSinkWants>>
+      sink_wants_ RTC_GUARDED_BY(wants_lock_);
+
+  /// Callback invoked after the sinks changed, if any.
+  std::function<void()> sinks_changed_callback_ RTC_GUARDED_BY(wants_lock_);
+
+  /// Hint about the content of the frames.
+  std::atomic<mrsVideoContentHint> content_hint_{mrsVideoContentHint::kNone};
+
+  /// Denoising preference, or |kUnset| for the default of the codec.
+  std::atomic<mrsOptBool> denoising_{mrsOptBool::kUnset};
+};
+
+/// Fixed-capacity ring of pending frame requests. Request IDs are allocated
+/// sequentially, so the pending requests always form the contiguous ID range
+/// [|first_id_|, |next_id_|), and each one lives in the slot indexed by its ID
+/// modulo the capacity. Adding and completing a request are constant-time and
+/// never allocate. This is not thread-safe; the caller provides the locking.
+class PendingRequestRing {
+ public:
+  /// Maximum number of pending requests. This must be a power of two so that
+  /// the slot index stays continuous across the wrap-around of request IDs.
+  static constexpr const uint32_t kCapacity = 64;
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "Capacity must be a power of two.");
+
+  /// Add a new request with the given timestamp and return its ID. If the ring
+  /// is full then the oldest request is discarded.
+  uint32_t Push(int64_t timestamp_ms) noexcept {
+    if (next_id_ - first_id_ >= kCapacity) {
+      ++first_id_;
+    }
+    const uint32_t request_id = next_id_++;
+    timestamps_[request_id % kCapacity] = timestamp_ms;
+    return request_id;
+  }
+
+  /// Remove the request with the given ID along with all older requests, and
+  /// return its timestamp, or -1 if that request is not pending.
+  int64_t Consume(uint32_t request_id) noexcept {
+    // Unsigned arithmetic keeps the offset valid across ID wrap-around, and
+    // makes IDs older than |first_id_| look out of range.
+    if (request_id - first_id_ >= next_id_ - first_id_) {
+      return -1;
+    }
+    first_id_ = request_id + 1;
+    return timestamps_[request_id % kCapacity];
+  }
+
+  /// Discard all pending requests. IDs keep increasing, so that completing a
+  /// request issued before clearing fails.
+  void Clear() noexcept { first_id_ = next_id_; }
+
+ private:
+  std::array<int64_t, kCapacity> timestamps_{};
+  uint32_t first_id_ = 0;
+  uint32_t next_id_ = 0;
 };
 
 }  // namespace detail
@@ -69,6 +227,10 @@ struct I420AVideoFrameRequest {
   /// Unique identifier of the request.
   const std::uint32_t request_id_;
 
+  /// Resolution and framerate wanted by the consumers of the frame. Producing
+  /// the frame within those limits avoids it being downscaled or dropped.
+  const mrsExternalVideoSinkWants sink_wants_;
+
   /// Complete the request by making the track source consume the given video
   /// frame and have it deliver the frame to all its video tracks.
   Result CompleteRequest(const I420AVideoFrame& frame_view);
@@ -99,6 +261,10 @@ struct Argb32VideoFrameRequest {
   /// Unique identifier of the request.
   const std::uint32_t request_id_;
 
+  /// Resolution and framerate wanted by the consumers of the frame. Producing
+  /// the frame within those limits avoids it being downscaled or dropped.
+  const mrsExternalVideoSinkWants sink_wants_;
+
   /// Complete the request by making the track source consume the given video
   /// frame and have it deliver the frame to all its video tracks.
   Result CompleteRequest(const Argb32VideoFrame& frame_view);
@@ -137,12 +303,33 @@ class ExternalVideoTrackSource : public VideoTrackSource,
       RefPtr<GlobalFactory> global_factory,
       RefPtr<Argb32ExternalVideoSource> video_source);
 
+  /// Helper to create an external video track source in push mode, where the
+  /// application submits frames with |PushFrame()| on its own schedule instead
+  /// of answering frame requests.
+  static RefPtr<ExternalVideoTrackSource> createForPush(
+      RefPtr<GlobalFactory> global_factory);
+
+  /// Helper to create an external video track source generating test patterns
+  /// natively on each frame request. The configuration must be valid, see
+  /// |SyntheticFrameGenerator::IsValidConfig()|.
+  static RefPtr<ExternalVideoTrackSource> createSynthetic(
+      RefPtr<GlobalFactory> global_factory,
+      const mrsSyntheticVideoSourceConfig& config);
+
   static RefPtr<ExternalVideoTrackSource> create(
       RefPtr<GlobalFactory> global_factory,
       std::unique_ptr<detail::BufferAdapter> adapter);
 
   ~ExternalVideoTrackSource() override;
 
+  /// Configure the scheduling of the frame requests. This is only valid before
+  /// |FinishCreation()| is called.
+  Result Configure(const mrsExternalVideoTrackSourceSettings& settings);
+
+  /// Signal that a new frame is available, to request it immediately. This is
+  /// only valid with on-demand scheduling, once capture started.
+  Result NotifyFrameAvailable();
+
   /// Finish the creation of the video track source, and start capturing.
   /// See |mrsExternalVideoTrackSourceFinishCreation()| for details.
   void FinishCreation();
@@ -151,19 +338,166 @@ class ExternalVideoTrackSource : public VideoTrackSource,
   /// calling the video frame callback.
   void StartCapture();
 
+  // The methods completing requests and pushing frames below take an optional
+  // |capture_time_us|, the capture time of the frame in microseconds of the
+  // application clock synchronized with |SyncCaptureClock()|, which becomes
+  // the timestamp of the frame. They fail if it maps before the origin of the
+  // clock of |rtc::TimeMicros()|. See
+  // |mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithCaptureTime()|.
+  // They also take optional |metadata| delivered along with the frame, made
+  // with |CopyFrameMetadata()|, which is dropped with the frame if the frame
+  // is dropped.
+
   /// Complete a given video frame request with the provided I420A frame.
   /// The caller must know the source expects an I420A frame; there is no check
   /// to confirm the source is I420A-based or ARGB32-based.
-  Result CompleteRequest(uint32_t request_id,
-                         int64_t timestamp_ms,
-                         const I420AVideoFrame& frame);
+  Result CompleteRequest(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      const I420AVideoFrame& frame,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Complete a given video frame request with the provided I420A frame,
+  /// without copying it. The frame planes, including the alpha plane if any,
+  /// are referenced directly and must remain valid and unmodified until
+  /// |release_callback| is invoked, once the last reference to the frame is
+  /// released. That callback can be invoked from any thread, and possibly
+  /// before this call returns. If this call fails, the frame is not referenced
+  /// and the callback is never invoked.
+  Result CompleteRequestNoCopy(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      const I420AVideoFrame& frame,
+      Callback<> release_callback,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
 
   /// Complete a given video frame request with the provided ARGB32 frame.
   /// The caller must know the source expects an ARGB32 frame; there is no check
   /// to confirm the source is I420A-based or ARGB32-based.
-  Result CompleteRequest(uint32_t request_id,
-                         int64_t timestamp_ms,
-                         const Argb32VideoFrame& frame);
+  Result CompleteRequest(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      const Argb32VideoFrame& frame,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Complete a given video frame request with the provided NV12 frame, which
+  /// is converted to I420 regardless of the kind of source.
+  Result CompleteRequest(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      const Nv12VideoFrame& frame,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Complete a given video frame request with the provided native frame,
+  /// delivered as a |kNative| frame buffer without reading it. Its release
+  /// callback is invoked once the last reference to the frame is released,
+  /// unless this call fails.
+  Result CompleteRequest(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      const mrsNativeVideoFrame& frame,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Complete a given video frame request with an existing frame buffer,
+  /// referenced without copy.
+  Result CompleteRequest(
+      uint32_t request_id,
+      int64_t timestamp_ms,
+      rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+      absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Submit an I420A frame to a source created in push mode. The frame is
+  /// copied and delivered to all video tracks on the caller's thread before
+  /// this returns. The timestamp is in milliseconds in the clock of
+  /// |rtc::TimeMillis()|, or zero to use the current time. A capture time
+  /// replaces the timestamp.
+  Result PushFrame(const I420AVideoFrame& frame,
+                   int64_t timestamp_ms,
+                   absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Submit an ARGB32 frame to a source created in push mode. The frame is
+  /// converted to I420 and delivered to all video tracks on the caller's
+  /// thread before this returns. The timestamp is in milliseconds in the clock
+  /// of |rtc::TimeMillis()|, or zero to use the current time. A capture time
+  /// replaces the timestamp.
+  Result PushFrame(const Argb32VideoFrame& frame,
+                   int64_t timestamp_ms,
+                   absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Submit an NV12 frame to a source created in push mode. The frame is
+  /// converted to I420 and delivered to all video tracks on the caller's thread
+  /// before this returns.
+  Result PushFrame(const Nv12VideoFrame& frame,
+                   int64_t timestamp_ms,
+                   absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Submit a native frame to a source created in push mode. The frame is
+  /// delivered as a |kNative| frame buffer to all video tracks on the caller's
+  /// thread before this returns.
+  Result PushFrame(const mrsNativeVideoFrame& frame,
+                   int64_t timestamp_ms,
+                   absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Submit an existing frame buffer to a source created in push mode. The
+  /// buffer is referenced without copy, and delivered to all video tracks on
+  /// the caller's thread before this returns.
+  Result PushFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                   int64_t timestamp_ms,
+                   absl::optional<int64_t> capture_time_us = absl::nullopt,
+      FrameMetadata metadata = nullptr);
+
+  /// Start reading frames from a shared memory frame ring written by another
+  /// process, and pushing them to this source, which must be created in push
+  /// mode. See |mrsExternalVideoTrackSourceCreateFromSharedMemory()|.
+  Result ReadFromSharedMemory(const char* mapping_name,
+                              const char* doorbell_event_name);
+
+  /// Get the statistics of the pool of frame buffers used to copy or convert
+  /// the frames provided by the application.
+  FrameBufferPoolStats GetBufferPoolStats() const noexcept;
+
+  /// Get the resolution and framerate currently wanted by the consumers of the
+  /// frames of this source.
+  mrsExternalVideoSinkWants GetSinkWants() const;
+
+  /// Enable or disable stamping a |LatencyMarker| into the pixels of each
+  /// frame, with a frame number and the capture time, for the receiver to
+  /// measure the end-to-end latency of the frames. This overwrites the top-left
+  /// corner of the frames, and forces a copy of frames completed without copy.
+  void SetLatencyMarkers(bool enabled) noexcept {
+    latency_markers_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /// Copy application metadata to pass along with a frame completed or pushed
+  /// on a source, into |metadata|, which is NULL for empty metadata. The
+  /// metadata is delivered along with the frame to the frame callbacks of the
+  /// local and remote video tracks, as long as the remote peer also uses this
+  /// library. This fails if the metadata is larger than
+  /// |kMaxFrameMetadataSize|.
+  static Result CopyFrameMetadata(const void* data,
+                                  size_t size,
+                                  FrameMetadata& metadata) noexcept;
+
+  /// Synchronize the clock of the application capture times with the clock of
+  /// |rtc::TimeMicros()|, given the current time of the application clock in
+  /// microseconds. See |mrsExternalVideoTrackSourceSyncCaptureClock()|.
+  void SyncCaptureClock(int64_t app_time_us) noexcept;
+
+  /// Set the hint about the content of the frames of this source, and whether
+  /// the encoders should denoise them. See
+  /// |mrsExternalVideoTrackSourceSetContentHint()|.
+  Result SetContentHint(mrsVideoContentHint content_hint,
+                        mrsOptBool denoising) noexcept;
 
   /// Stop the video capture. This will stop producing video frames.
   void StopCapture();
@@ -182,15 +516,137 @@ class ExternalVideoTrackSource : public VideoTrackSource,
     return (detail::CustomTrackSourceAdapter*)source_.get();
   }
 
+  /// Request a frame from the external source. This is called on the capture
+  /// thread only.
+  void RequestFrame();
+
+  /// Check that a frame can be pushed, and get its timestamp in microseconds,
+  /// substituting the current time for a zero |timestamp_ms|.
+  Result PreparePush(int64_t timestamp_ms,
+                     absl::optional<int64_t> capture_time_us,
+                     int64_t& timestamp_us) noexcept;
+
+  /// Remove a pending request and all older ones, and get the timestamp of the
+  /// frame completing it, in microseconds. This fails if no request with that
+  /// ID is pending, without consuming any request if the capture time is
+  /// invalid.
+  Result ConsumeRequest(uint32_t request_id,
+                        absl::optional<int64_t> capture_time_us,
+                        int64_t& timestamp_us);
+
+  /// Adapt a frame to the sink wants and, unless it is dropped, fill a buffer
+  /// with it and deliver it to all tracks. Dropped frames are never copied or
+  /// converted.
+  template <typename FrameView>
+  void AdaptAndDispatchFrame(const FrameView& frame_view,
+                             int64_t timestamp_us,
+                             FrameMetadata metadata);
+
+  /// Adapt an existing frame buffer to the sink wants and, unless it is
+  /// dropped, deliver it to all tracks.
+  void DispatchFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                     int64_t timestamp_us,
+                     FrameMetadata metadata);
+
+  /// Crop and scale a frame buffer as adapted, then wrap it into a video frame
+  /// with the given metadata, if any, and deliver it to all tracks. Native
+  /// buffers are delivered unscaled, for the hardware encoder to scale them.
+  void DispatchAdaptedFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                            int64_t timestamp_us,
+                            const detail::FrameAdaptation& adaptation,
+                            FrameMetadata metadata);
+
+  /// Map a capture time of the application clock to the clock of
+  /// |rtc::TimeMicros()|, or return -1 if it maps before the origin of that
+  /// clock.
+  int64_t MapCaptureTimeUs(int64_t capture_time_us) const noexcept;
+
+  /// Get the timestamp of the next frame, in microseconds: its capture time
+  /// |capture_time_us| mapped with |MapCaptureTimeUs()| if not negative, or
+  /// else |timestamp_ms|. Timestamps are kept increasing and not later than
+  /// the current time.
+  int64_t NextTimestampUs(int64_t timestamp_ms,
+                          int64_t capture_time_us) noexcept;
+
+  /// Schedule the next periodic frame request on the capture thread.
+  void ScheduleNextRequest();
+
+  /// Check if any sink consumes the next frame, to skip producing frames no
+  /// sink consumes. Once the sinks only want black frames, a single frame is
+  /// still produced for them to replace with a black frame, so that the remote
+  /// peer does not keep showing the last frame.
+  bool IsFrameWanted() noexcept;
+
+  /// Resume the periodic frame requests paused because no sink consumed the
+  /// frames, if a sink consumes them again. This is called on the capture
+  /// thread only.
+  void ResumeRequests();
+
   std::unique_ptr<detail::BufferAdapter> adapter_;
-  std::unique_ptr<rtc::Thread> capture_thread_;
 
-  /// Collection of pending frame requests
-  std::deque<std::pair<uint32_t, int64_t>> pending_requests_
-      RTC_GUARDED_BY(request_lock_);  //< TODO : circular buffer to avoid alloc
+  /// Thread issuing the frame requests; either the scheduler thread shared by
+  /// all sources, or |dedicated_thread_|. This is set when capture starts.
+  rtc::Thread* capture_thread_ = nullptr;
+
+  /// Thread owned by this source if it does not use the shared scheduler.
+  std::unique_ptr<rtc::Thread> dedicated_thread_;
+
+  /// Request a dedicated capture thread instead of the shared one.
+  bool use_dedicated_thread_ = false;
+
+  /// Interval between two periodic frame requests, in microseconds.
+  int64_t frame_interval_us_ = rtc::kNumMicrosecsPerSec / 30;
+
+  /// Request frames only when signaled with |NotifyFrameAvailable()| instead
+  /// of periodically.
+  bool on_demand_ = false;
+
+  /// Frames are pushed with |PushFrame()| instead of requested, and the
+  /// capture thread is never started.
+  bool push_mode_ = false;
 
-  /// Next available ID for a frame request.
-  uint32_t next_request_id_ RTC_GUARDED_BY(request_lock_){};
+  /// Reader pushing the frames of a shared memory frame ring, if any. This is
+  /// stopped when capture stops.
+  std::unique_ptr<SharedMemoryFrameReader> shared_memory_reader_;
+
+  /// Deadline of the next periodic frame request, in microseconds, in the
+  /// clock of |rtc::TimeMicros()|. Requests are scheduled relative to this
+  /// deadline rather than to the time a request completes, so that the
+  /// effective framerate does not drift below the target.
+  int64_t next_request_time_us_ = 0;
+
+  /// Periodic frame requests are paused until a sink consumes the frames
+  /// again. Only accessed on the capture thread.
+  bool requests_paused_ = false;
+
+  /// Frames were skipped because no sink consumed them.
+  std::atomic_bool frames_skipped_{false};
+
+  /// A frame was produced for the sinks only wanting black frames.
+  std::atomic_bool black_frame_produced_{false};
+
+  /// Request a key frame for the next frame dispatched, to resume after
+  /// frames were skipped.
+  std::atomic_bool keyframe_on_resume_{false};
+
+  /// Pool of buffers for the frames downscaled to the sink wants, or copied
+  /// to stamp a latency marker.
+  FrameBufferPool scaled_buffer_pool_;
+
+  /// Stamp a latency marker into each frame dispatched.
+  std::atomic_bool latency_markers_{false};
+
+  /// Frame number of the next latency marker.
+  std::atomic<uint32_t> next_marker_frame_number_{0};
+
+  /// Offset from the application clock to the clock of |rtc::TimeMicros()|.
+  std::atomic<int64_t> capture_clock_offset_us_{0};
+
+  /// Timestamp of the last frame dispatched, in microseconds.
+  std::atomic<int64_t> last_timestamp_us_{0};
+
+  /// Collection of pending frame requests.
+  detail::PendingRequestRing pending_requests_ RTC_GUARDED_BY(request_lock_);
 
   /// Lock for frame requests.
   rtc::CriticalSection request_lock_;
@@ -212,6 +668,15 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromArgb32(
     mrsRequestExternalArgb32VideoFrameCallback callback,
     void* user_data);
 
+/// Create an external video track source in push mode.
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateForPush(
+    RefPtr<GlobalFactory> global_factory);
+
+/// Create an external video track source generating test patterns natively.
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateSynthetic(
+    RefPtr<GlobalFactory> global_factory,
+    const mrsSyntheticVideoSourceConfig& config);
+
 }  // namespace detail
 
 }  // namespace WebRTC
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "media/frame_buffer_pool.h"
+
+namespace {
+
+/// Size in bytes of an I420 frame buffer of the given resolution.
+size_t I420BufferSize(int width, int height) noexcept {
+  const size_t chroma_size =
+      static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+  return static_cast<size_t>(width) * height + 2 * chroma_size;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+FrameBufferPool::FrameBufferPool(size_t max_buffer_count)
+    : pool_(/*zero_initialize=*/false, max_buffer_count) {
+  known_buffers_.reserve(max_buffer_count);
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> FrameBufferPool::CreateBuffer(
+    int width,
+    int height) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer;
+  {
+    rtc::CritScope lock(&lock_);
+    if ((width != width_) || (height != height_)) {
+      // The pool drops buffers of a different resolution by itself, but only
+      // lazily. Release them eagerly to trim the memory after a resize.
+      pool_.Release();
+      known_buffers_.clear();
+      width_ = width;
+      height_ = height;
+    }
+    buffer = pool_.CreateBuffer(width, height);
+    if (buffer) {
+      if (std::find(known_buffers_.begin(), known_buffers_.end(),
+                    buffer.get()) != known_buffers_.end()) {
+        hit_count_.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+      }
+      known_buffers_.push_back(buffer.get());
+    }
+    memory_charge_.Set(known_buffers_.size() * I420BufferSize(width, height));
+  }
+  miss_count_.fetch_add(1, std::memory_order_relaxed);
+  if (!buffer) {
+    // All pooled buffers are still in use; fall back to a one-off allocation.
+    buffer = webrtc::I420Buffer::Create(width, height);
+  }
+  return buffer;
+}
+
+FrameBufferPoolStats FrameBufferPool::GetStats() const noexcept {
+  FrameBufferPoolStats stats;
+  stats.hit_count_ = hit_count_.load(std::memory_order_relaxed);
+  stats.miss_count_ = miss_count_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "common_video/include/i420_buffer_pool.h"
+#include "rtc_base/criticalsection.h"
+
+#include "memory_accounting.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Statistics of a frame buffer pool, to help tune its capacity.
+struct FrameBufferPoolStats {
+  /// Number of buffers reused from the pool.
+  uint64_t hit_count_ = 0;
+
+  /// Number of buffers newly allocated, either because all buffers in the pool
+  /// were in use, or because the frame resolution changed.
+  uint64_t miss_count_ = 0;
+};
+
+/// Thread-safe pool of I420 frame buffers, to avoid a heap allocation for each
+/// frame produced by a video source. All buffers of the pool have the same
+/// resolution; requesting a buffer with a different resolution releases all
+/// previously pooled buffers. Buffers still referenced elsewhere, for example
+/// by an encoder, are not reused until released.
+class FrameBufferPool {
+ public:
+  /// Default maximum number of buffers allocated by the pool. This needs to
+  /// cover the frames buffered by the encoder and the frame observers.
+  static constexpr const size_t kDefaultMaxBufferCount = 8;
+
+  explicit FrameBufferPool(size_t max_buffer_count = kDefaultMaxBufferCount);
+
+  /// Get a buffer of the given resolution, either reused from the pool or
+  /// newly allocated. If the pool is exhausted, this allocates a buffer outside
+  /// of the pool. The content of the buffer is undefined.
+  rtc::scoped_refptr<webrtc::I420Buffer> CreateBuffer(int width, int height);
+
+  /// Get the pool statistics accumulated since the pool was created.
+  FrameBufferPoolStats GetStats() const noexcept;
+
+ private:
+  rtc::CriticalSection lock_;
+  webrtc::I420BufferPool pool_ RTC_GUARDED_BY(lock_);
+
+  /// Buffers already handed out by the pool at the current resolution, used to
+  /// tell a reused buffer from a newly allocated one.
+  std::vector<const webrtc::I420Buffer*> known_buffers_ RTC_GUARDED_BY(lock_);
+
+  /// Resolution of the pooled buffers.
+  int width_ RTC_GUARDED_BY(lock_) = 0;
+  int height_ RTC_GUARDED_BY(lock_) = 0;
+
+  /// Accounting of the buffers in |known_buffers_| as buffer pool memory.
+  MemoryCharge memory_charge_ RTC_GUARDED_BY(lock_){
+      MemoryCategory::kBufferPools};
+
+  std::atomic<uint64_t> hit_count_{0};
+  std::atomic<uint64_t> miss_count_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
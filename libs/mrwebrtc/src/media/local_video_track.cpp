@@ -3,6 +3,8 @@
 
 #include "pch.h"
 
+#include "encoded_frame_relay.h"
+#include "frame_metadata.h"
 #include "interop/global_factory.h"
 #include "local_video_track.h"
 #include "peer_connection.h"
@@ -19,9 +21,10 @@ LocalVideoTrack::LocalVideoTrack(
   RTC_CHECK(track_);
   name_ = track_->id();
   kind_ = mrsTrackKind::kVideoTrack;
-  rtc::VideoSinkWants sink_settings{};
-  sink_settings.rotation_applied = true;
-  track_->AddOrUpdateSink(this, sink_settings);
+  // The track only consumes the frames of its source for its own callbacks;
+  // its encoder, if any, is another sink of the source.
+  SetPassiveSink(true);
+  UpdateSink();
 }
 
 LocalVideoTrack::LocalVideoTrack(
@@ -44,9 +47,8 @@ LocalVideoTrack::LocalVideoTrack(
   name_ = track_->id();
   kind_ = mrsTrackKind::kVideoTrack;
   transceiver_->OnLocalTrackAdded(this);
-  rtc::VideoSinkWants sink_settings{};
-  sink_settings.rotation_applied = true;
-  track_->AddOrUpdateSink(this, sink_settings);
+  SetPassiveSink(true);
+  UpdateSink();
 }
 
 LocalVideoTrack::~LocalVideoTrack() {
@@ -66,6 +68,143 @@ bool LocalVideoTrack::IsEnabled() const noexcept {
   return track_->enabled();
 }
 
+Result LocalVideoTrack::RequestKeyFrame() noexcept {
+#if defined(WINUWP)
+  // The UWP encoders are not wrapped to honor the key frame requests.
+  return Result::kUnsupported;
+#else
+  keyframe_request_count_.fetch_add(1, std::memory_order_relaxed);
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result LocalVideoTrack::SetContentHint(
+    mrsVideoContentHint content_hint) noexcept {
+  webrtc::VideoTrackInterface::ContentHint rtc_hint;
+  switch (content_hint) {
+    case mrsVideoContentHint::kNone:
+      rtc_hint = webrtc::VideoTrackInterface::ContentHint::kNone;
+      break;
+    case mrsVideoContentHint::kMotion:
+      rtc_hint = webrtc::VideoTrackInterface::ContentHint::kFluid;
+      break;
+    case mrsVideoContentHint::kDetail:
+    case mrsVideoContentHint::kText:
+      // There is no dedicated text hint in this version of WebRTC.
+      rtc_hint = webrtc::VideoTrackInterface::ContentHint::kDetailed;
+      break;
+    default:
+      return Result::kInvalidParameter;
+  }
+  content_hint_.store(content_hint, std::memory_order_relaxed);
+  // The RTP sender observes the track, and reconfigures its encoder on change.
+  track_->set_content_hint(rtc_hint);
+  ApplyContentDegradationPreference();
+  return Result::kSuccess;
+}
+
+Result LocalVideoTrack::SetPlayoutDelay(int min_delay_ms,
+                                        int max_delay_ms) noexcept {
+#if defined(WINUWP)
+  // The UWP encoders are not wrapped to stamp the playout delay.
+  return Result::kUnsupported;
+#else
+  // The RTP header extension carries each bound with a 10 ms granularity on
+  // 12 bits.
+  constexpr int kMaxPlayoutDelayMs =
+      0xFFF * webrtc::kPlayoutDelayGranularityMs;
+  const bool unset = (min_delay_ms < 0) && (max_delay_ms < 0);
+  if (!unset && ((min_delay_ms < 0) || (min_delay_ms > max_delay_ms) ||
+                 (max_delay_ms > kMaxPlayoutDelayMs))) {
+    return Result::kInvalidParameter;
+  }
+  playout_delay_.store(
+      unset ? webrtc::PlayoutDelay{-1, -1}
+            : webrtc::PlayoutDelay{min_delay_ms, max_delay_ms},
+      std::memory_order_relaxed);
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result LocalVideoTrack::SetEncoderOptions(
+    const mrsVideoEncoderOptions& options) noexcept {
+#if defined(WINUWP)
+  // The UWP encoders are not wrapped to apply the options.
+  return Result::kUnsupported;
+#else
+  if ((options.preset < mrsVideoEncoderPreset::kDefault) ||
+      (options.preset > mrsVideoEncoderPreset::kQuality)) {
+    return Result::kInvalidParameter;
+  }
+  encoder_options_.store(options, std::memory_order_relaxed);
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+void LocalVideoTrack::ApplyContentDegradationPreference() noexcept {
+  // In Plan B the RTP sender only exists once negotiated to send.
+  if (!transceiver_ || !transceiver_->GetRtpSender()) {
+    return;
+  }
+  switch (content_hint_.load(std::memory_order_relaxed)) {
+    case mrsVideoContentHint::kMotion:
+      transceiver_->SetContentDegradationPreference(
+          mrsDegradationPreference::kMaintainFramerate);
+      break;
+    case mrsVideoContentHint::kDetail:
+    case mrsVideoContentHint::kText:
+      transceiver_->SetContentDegradationPreference(
+          mrsDegradationPreference::kMaintainResolution);
+      break;
+    default:
+      break;
+  }
+}
+
+void LocalVideoTrack::OnCallbacksChanged() noexcept {
+  // Update the sink for the source to re-evaluate whether any of its sinks
+  // consumes the frames.
+  UpdateSink();
+}
+
+void LocalVideoTrack::UpdateSink() noexcept {
+  // Let the frame observer apply the rotation, if requested, rather than
+  // have the source rotate the pixels of every frame.
+  rtc::VideoSinkWants sink_settings{};
+  sink_settings.rotation_applied = false;
+  track_->AddOrUpdateSink(this, sink_settings);
+}
+
+void LocalVideoTrack::OnFrame(const webrtc::VideoFrame& frame) noexcept {
+  // The track receives the same frames as its encoder, which may encode them
+  // before or after this runs. So mark frames until an encoder fulfilled one
+  // of the requests.
+  if (keyframe_request_ && keyframe_request_->IsFulfilled()) {
+    keyframe_fulfilled_index_ = keyframe_request_index_;
+    keyframe_request_ = nullptr;
+  }
+  const uint32_t request_count =
+      keyframe_request_count_.load(std::memory_order_relaxed);
+  if (request_count != keyframe_fulfilled_index_) {
+    keyframe_request_ = RequestKeyFrameForFrame(frame);
+    keyframe_request_index_ = request_count;
+  }
+  // The RTP sender only sends the header extension until the receivers
+  // acknowledge a change, so stamping every frame costs no bandwidth.
+  const webrtc::PlayoutDelay playout_delay =
+      playout_delay_.load(std::memory_order_relaxed);
+  if ((playout_delay.min_ms >= 0) || (playout_delay.max_ms >= 0)) {
+    SetFramePlayoutDelay(frame, playout_delay);
+  }
+  // Frames without options reset the encoder to its default options.
+  const mrsVideoEncoderOptions encoder_options =
+      encoder_options_.load(std::memory_order_relaxed);
+  if (HasEncoderOptions(encoder_options)) {
+    SetFrameEncoderOptions(frame, encoder_options);
+  }
+  VideoFrameObserver::OnFrame(frame);
+}
+
 webrtc::VideoTrackInterface* LocalVideoTrack::impl() const {
   return track_.get();
 }
@@ -91,6 +230,7 @@ void LocalVideoTrack::OnAddedToPeerConnection(
   sender_ = std::move(sender);  // NULL in Plan B
   transceiver_ = transceiver;
   transceiver_->OnLocalTrackAdded(this);
+  ApplyContentDegradationPreference();
 }
 
 void LocalVideoTrack::OnRemovedFromPeerConnection(
@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "callback.h"
+#include "common_types.h"
 #include "interop_api.h"
 #include "media/media_track.h"
 #include "refptr.h"
@@ -24,6 +28,7 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class KeyFrameRequest;
 class PeerConnection;
 class Transceiver;
 
@@ -67,6 +72,23 @@ class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
     return transceiver_;
   }
 
+  /// Force the encoder of the track to produce a key frame for the next frame,
+  /// for example when a new viewer joins mid-stream. Other tracks sharing the
+  /// same source may produce a key frame too. This is not supported on UWP.
+  Result RequestKeyFrame() noexcept;
+
+  /// Set the hint about the content of the track. See
+  /// |mrsLocalVideoTrackSetContentHint()|.
+  Result SetContentHint(mrsVideoContentHint content_hint) noexcept;
+
+  /// Set the range of the playout delay requested to the receivers of the
+  /// track. See |mrsLocalVideoTrackSetPlayoutDelay()|.
+  Result SetPlayoutDelay(int min_delay_ms, int max_delay_ms) noexcept;
+
+  /// Set the options of the encoder of the track. See
+  /// |mrsLocalVideoTrackSetEncoderOptions()|.
+  Result SetEncoderOptions(const mrsVideoEncoderOptions& options) noexcept;
+
   //
   // Advanced use
   //
@@ -95,7 +117,21 @@ class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
 
   void RemoveFromPeerConnection(webrtc::PeerConnectionInterface& peer);
 
+ protected:
+  // VideoSinkInterface interface
+  void OnFrame(const webrtc::VideoFrame& frame) noexcept override;
+
+  // VideoFrameObserver interface
+  void OnCallbacksChanged() noexcept override;
+
  private:
+  /// Add or update the track as a sink of its source.
+  void UpdateSink() noexcept;
+
+  /// Set the degradation preference of the RTP sender of the transceiver, if
+  /// any, according to the content hint of the track.
+  void ApplyContentDegradationPreference() noexcept;
+
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::VideoTrackInterface> track_;
 
@@ -105,6 +141,29 @@ class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
   /// Weak back-pointer to the Transceiver this track is associated with, if
   /// any. This avoids a circular reference with the transceiver itself.
   Transceiver* transceiver_{nullptr};
+
+  /// Number of calls to |RequestKeyFrame()|.
+  std::atomic<uint32_t> keyframe_request_count_{0};
+
+  /// Last request made to the encoders for a key frame and not fulfilled yet,
+  /// if any, and the value of |keyframe_request_count_| it was made for. Only
+  /// accessed on the thread delivering the frames of the source.
+  std::shared_ptr<KeyFrameRequest> keyframe_request_;
+  uint32_t keyframe_request_index_{0};
+
+  /// Value of |keyframe_request_count_| for the last fulfilled request.
+  uint32_t keyframe_fulfilled_index_{0};
+
+  /// Hint about the content of the track set with |SetContentHint()|.
+  std::atomic<mrsVideoContentHint> content_hint_{mrsVideoContentHint::kNone};
+
+  /// Playout delay set with |SetPlayoutDelay()|, or {-1, -1} if none.
+  std::atomic<webrtc::PlayoutDelay> playout_delay_{
+      webrtc::PlayoutDelay{-1, -1}};
+
+  /// Encoder options set with |SetEncoderOptions()|.
+  std::atomic<mrsVideoEncoderOptions> encoder_options_{
+      mrsVideoEncoderOptions{}};
 };
 
 }  // namespace WebRTC
@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "audio_conversion.h"
+#include "media/audio_track_read_buffer.h"
+#include "media/mixed_audio_read_buffer.h"
+#include "media/remote_audio_track.h"
+#include "remote_audio_track_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+MixedAudioReadBuffer::MixedAudioReadBuffer() noexcept = default;
+
+MixedAudioReadBuffer::~MixedAudioReadBuffer() noexcept = default;
+
+std::vector<MixedAudioReadBuffer::Input>::iterator
+MixedAudioReadBuffer::FindInput(RemoteAudioTrack& track) {
+  return std::find_if(inputs_.begin(), inputs_.end(),
+                      [&track](const Input& input) {
+                        return (input.track == &track);
+                      });
+}
+
+Result MixedAudioReadBuffer::AddTrack(RemoteAudioTrack& track,
+                                      float gain) noexcept {
+  // Create the buffer outside of the lock, since resuming the track waits for
+  // the lock of the audio mixer, held while it mixes, which should not block
+  // |Read()|.
+  std::unique_ptr<AudioTrackReadBuffer> buffer = track.CreateReadBuffer();
+  {
+    rtc::CritScope lock(&crit_);
+    if (FindInput(track) == inputs_.end()) {
+      inputs_.push_back(Input{&track, std::move(buffer), gain});
+      return Result::kSuccess;
+    }
+  }
+  RTC_LOG(LS_ERROR) << "Audio track is already mixed by this buffer.";
+  return Result::kInvalidOperation;
+}
+
+Result MixedAudioReadBuffer::RemoveTrack(RemoteAudioTrack& track) noexcept {
+  std::unique_ptr<AudioTrackReadBuffer> buffer;
+  {
+    rtc::CritScope lock(&crit_);
+    auto it = FindInput(track);
+    if (it == inputs_.end()) {
+      return Result::kNotFound;
+    }
+    buffer = std::move(it->buffer);
+    inputs_.erase(it);
+  }
+  // Destroy the buffer, which releases the track, outside of the lock.
+  buffer.reset();
+  return Result::kSuccess;
+}
+
+Result MixedAudioReadBuffer::SetTrackGain(RemoteAudioTrack& track,
+                                          float gain) noexcept {
+  rtc::CritScope lock(&crit_);
+  auto it = FindInput(track);
+  if (it == inputs_.end()) {
+    return Result::kNotFound;
+  }
+  it->gain = gain;
+  return Result::kSuccess;
+}
+
+void MixedAudioReadBuffer::Read(int sample_rate,
+                                int num_channels,
+                                float* samples_out,
+                                int num_samples,
+                                bool* has_overrun_out) noexcept {
+  *has_overrun_out = false;
+  std::fill_n(samples_out, num_samples, 0.0f);
+  if (scratch_.size() < (size_t)num_samples) {
+    scratch_.resize(num_samples);
+  }
+
+  // Tracks which ran out of data are padded with silence, so that they do not
+  // shorten the mix of the others.
+  const AudioTrackReadBuffer::OutputFormat format{
+      mrsAudioTrackReadBufferSampleType::kFloat32, true};
+  rtc::CritScope lock(&crit_);
+  for (Input& input : inputs_) {
+    int num_samples_read;
+    bool has_overrun;
+    input.buffer->Read(sample_rate, num_channels,
+                       mrsAudioTrackReadBufferPadBehavior::kPadWithZero, format,
+                       scratch_.data(), num_samples, &num_samples_read,
+                       &has_overrun);
+    *has_overrun_out = (*has_overrun_out || has_overrun);
+    if (input.gain != 0.0f) {
+      MixAccumulateF32(scratch_.data(), input.gain, samples_out,
+                       (size_t)num_samples);
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/criticalsection.h"
+
+#include "result.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class AudioTrackReadBuffer;
+class RemoteAudioTrack;
+
+/// Implementation of |mrsMixedAudioReadBufferHandle|.
+///
+/// Buffers the audio of several remote audio tracks and mixes it natively, so
+/// that a single |Read()| produces the mix of all tracks. Each track is
+/// buffered by its own |AudioTrackReadBuffer|, which resamples it only once,
+/// directly to the output format, and the tracks are then accumulated with
+/// their own gain. Only one thread at a time may call |Read()|.
+class MixedAudioReadBuffer {
+ public:
+  MixedAudioReadBuffer() noexcept;
+  ~MixedAudioReadBuffer() noexcept;
+
+  /// Add a track to the mix with the given linear gain. The track is
+  /// registered as consumed for as long as it is part of the mix.
+  Result AddTrack(RemoteAudioTrack& track, float gain) noexcept;
+
+  /// Remove a track from the mix.
+  Result RemoveTrack(RemoteAudioTrack& track) noexcept;
+
+  /// Change the gain of a track of the mix, from the next |Read()|.
+  Result SetTrackGain(RemoteAudioTrack& track, float gain) noexcept;
+
+  /// See |mrsMixedAudioReadBufferRead|.
+  void Read(int sample_rate,
+            int num_channels,
+            float* samples_out,
+            int num_samples,
+            bool* has_overrun_out) noexcept;
+
+ private:
+  struct Input {
+    /// Track, only used to identify the input. The buffer keeps it alive.
+    RemoteAudioTrack* track;
+    std::unique_ptr<AudioTrackReadBuffer> buffer;
+    float gain;
+  };
+
+  /// Find the input of the given track, or return |inputs_.end()|.
+  std::vector<Input>::iterator FindInput(RemoteAudioTrack& track);
+
+  /// Serializes changes of the inputs with |Read()|. This is the only lock
+  /// taken per read, whatever the number of tracks.
+  rtc::CriticalSection crit_;
+
+  std::vector<Input> inputs_ RTC_GUARDED_BY(crit_);
+
+  /// Samples of a single track read before being mixed, kept to reuse its
+  /// capacity. Only accessed by |Read()|.
+  std::vector<float> scratch_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "media/native_video_frame_buffer.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+
+/// Buffers alive, to recognize them among the other |kNative| buffers without
+/// relying on RTTI, which WebRTC is built without.
+std::mutex g_live_buffers_mutex;
+std::unordered_set<const webrtc::VideoFrameBuffer*> g_live_buffers
+    RTC_GUARDED_BY(g_live_buffers_mutex);
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<NativeVideoFrameBuffer> NativeVideoFrameBuffer::Create(
+    const mrsNativeVideoFrame& frame) {
+  return new rtc::RefCountedObject<NativeVideoFrameBuffer>(frame);
+}
+
+bool NativeVideoFrameBuffer::IsInstance(
+    const webrtc::VideoFrameBuffer* buffer) {
+  if (buffer->type() != Type::kNative) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+  return (g_live_buffers.find(buffer) != g_live_buffers.end());
+}
+
+NativeVideoFrameBuffer::NativeVideoFrameBuffer(
+    const mrsNativeVideoFrame& frame)
+    : frame_(frame) {
+  std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+  g_live_buffers.insert(this);
+}
+
+NativeVideoFrameBuffer::~NativeVideoFrameBuffer() {
+  {
+    std::lock_guard<std::mutex> lock(g_live_buffers_mutex);
+    g_live_buffers.erase(this);
+  }
+  if (frame_.release_callback) {
+    (*frame_.release_callback)(frame_.user_data);
+  }
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface>
+NativeVideoFrameBuffer::ToI420() {
+  rtc::CritScope lock(&lock_);
+  if (!i420_buffer_) {
+    i420_buffer_ = webrtc::I420Buffer::Create(width(), height());
+    mrsResult result = mrsResult::kUnsupported;
+    if (frame_.to_i420_callback) {
+      result = (*frame_.to_i420_callback)(
+          frame_.user_data, frame_.native_handle,
+          i420_buffer_->MutableDataY(), i420_buffer_->StrideY(),
+          i420_buffer_->MutableDataU(), i420_buffer_->StrideU(),
+          i420_buffer_->MutableDataV(), i420_buffer_->StrideV());
+    }
+    if (result != mrsResult::kSuccess) {
+      RTC_LOG(LS_ERROR) << "Failed to convert native video frame to I420, "
+                           "substituting a black frame. Error code: "
+                        << (int)result;
+      webrtc::I420Buffer::SetBlack(i420_buffer_.get());
+    }
+  }
+  return i420_buffer_;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
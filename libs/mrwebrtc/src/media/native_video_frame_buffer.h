@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "external_video_track_source_interop.h"
+
+#include "api/video/video_frame_buffer.h"
+#include "rtc_base/criticalsection.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Frame buffer of type |kNative| wrapping a platform-specific object provided
+/// by the application, like a D3D11 shared texture. Hardware encoders aware of
+/// that object can consume it directly with |native_handle()|, while any other
+/// consumer calling |ToI420()| triggers a one-time conversion through the
+/// application callback. The application is notified when the buffer is
+/// destroyed, to recycle the native object.
+class NativeVideoFrameBuffer : public webrtc::VideoFrameBuffer {
+ public:
+  /// Create a new buffer wrapping the given native frame.
+  static rtc::scoped_refptr<NativeVideoFrameBuffer> Create(
+      const mrsNativeVideoFrame& frame);
+
+  /// Check whether |buffer| is a |NativeVideoFrameBuffer|, among the other
+  /// |kNative| buffers.
+  static bool IsInstance(const webrtc::VideoFrameBuffer* buffer);
+
+  /// Opaque handle to the native object holding the frame.
+  void* native_handle() const noexcept { return frame_.native_handle; }
+
+  // webrtc::VideoFrameBuffer
+  Type type() const override { return Type::kNative; }
+  int width() const override { return static_cast<int>(frame_.width); }
+  int height() const override { return static_cast<int>(frame_.height); }
+  rtc::scoped_refptr<webrtc::I420BufferInterface> ToI420() override;
+
+ protected:
+  explicit NativeVideoFrameBuffer(const mrsNativeVideoFrame& frame);
+  ~NativeVideoFrameBuffer() override;
+
+ private:
+  const mrsNativeVideoFrame frame_;
+
+  rtc::CriticalSection lock_;
+
+  /// I420 conversion of the native frame, created on first use.
+  rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer_ RTC_GUARDED_BY(lock_);
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
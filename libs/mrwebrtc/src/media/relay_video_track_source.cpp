@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "encoded_frame_relay.h"
+#include "interop/global_factory.h"
+#include "media/relay_video_track_source.h"
+#include "media/remote_video_track.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ErrorOr<RefPtr<RelayVideoTrackSource>> RelayVideoTrackSource::Create(
+    RemoteVideoTrack& track) noexcept {
+  std::shared_ptr<EncodedFrameTap> tap = track.GetEncodedFrameTap();
+  if (!tap) {
+    return Error(Result::kUnsupported);
+  }
+  rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source =
+      new rtc::RefCountedObject<detail::CustomTrackSourceAdapter>();
+  // Relayed frames flow as soon as the source is created, so it is already
+  // live.
+  source->state_ = webrtc::MediaSourceInterface::SourceState::kLive;
+  RefPtr<RelayVideoTrackSource> relay_source =
+      new RelayVideoTrackSource(GlobalFactory::InstancePtr(), std::move(source),
+                                std::move(tap));
+  relay_source->SetName(track.GetName());
+  relay_source->tap_->AddSink(relay_source.get());
+  // Without any key frame, the first relayed frames cannot be decoded.
+  relay_source->tap_->RequestKeyFrame();
+  return relay_source;
+}
+
+RelayVideoTrackSource::RelayVideoTrackSource(
+    RefPtr<GlobalFactory> global_factory,
+    rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source,
+    std::shared_ptr<EncodedFrameTap> tap) noexcept
+    : VideoTrackSource(std::move(global_factory),
+                       ObjectType::kRelayVideoTrackSource,
+                       std::move(source)),
+      tap_(std::move(tap)) {}
+
+RelayVideoTrackSource::~RelayVideoTrackSource() {
+  tap_->RemoveSink(this);
+  GetSourceImpl()->state_ = webrtc::MediaSourceInterface::SourceState::kEnded;
+}
+
+void RelayVideoTrackSource::OnEncodedFrame(
+    const webrtc::EncodedImage& image,
+    webrtc::VideoCodecType codec_type) noexcept {
+  const bool is_keyframe = (image._frameType == webrtc::kVideoFrameKey);
+  if (is_keyframe && (image._encodedWidth > 0) && (image._encodedHeight > 0)) {
+    width_ = (int)image._encodedWidth;
+    height_ = (int)image._encodedHeight;
+  }
+  if ((width_ == 0) || (height_ == 0)) {
+    // Frames before the first key frame are useless anyway.
+    return;
+  }
+  rtc::scoped_refptr<EncodedVideoFrameBuffer> buffer =
+      EncodedVideoFrameBuffer::Create(image._buffer, image._length, codec_type,
+                                      is_keyframe, width_, height_,
+                                      next_index_++, tap_);
+  webrtc::VideoFrame frame{webrtc::VideoFrame::Builder()
+                               .set_video_frame_buffer(std::move(buffer))
+                               .set_timestamp_us(rtc::TimeMicros())
+                               .set_rotation(image.rotation_)
+                               .build()};
+  GetSourceImpl()->DispatchFrame(frame);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
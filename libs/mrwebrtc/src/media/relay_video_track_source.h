@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+
+#include "encoded_frame_tap.h"
+#include "external_video_track_source.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+#include "video_track_source.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class RemoteVideoTrack;
+
+/// Video track source relaying the encoded frames of a remote video track,
+/// without decoding nor re-encoding them. Any number of local video tracks
+/// can use it, each sending the frames as is on its own RTP stream, with the
+/// stream identifiers and payload type of its own peer connection. Key frame
+/// requests from the remote peers receiving those tracks are forwarded to the
+/// remote peer sending the relayed track.
+///
+/// The relayed frames are never decoded; the frame callbacks of the source
+/// receive black frames of the same resolution.
+class RelayVideoTrackSource : public VideoTrackSource, public EncodedFrameSink {
+ public:
+  /// Create a relay source for the given remote track. This fails with
+  /// |Result::kUnsupported| on platforms without access to the encoded frames
+  /// of remote tracks.
+  static ErrorOr<RefPtr<RelayVideoTrackSource>> Create(
+      RemoteVideoTrack& track) noexcept;
+
+  ~RelayVideoTrackSource() override;
+
+  // EncodedFrameSink
+  void OnEncodedFrame(const webrtc::EncodedImage& image,
+                      webrtc::VideoCodecType codec_type) noexcept override;
+
+ protected:
+  RelayVideoTrackSource(
+      RefPtr<GlobalFactory> global_factory,
+      rtc::scoped_refptr<detail::CustomTrackSourceAdapter> source,
+      std::shared_ptr<EncodedFrameTap> tap) noexcept;
+
+  detail::CustomTrackSourceAdapter* GetSourceImpl() const {
+    return (detail::CustomTrackSourceAdapter*)source_.get();
+  }
+
+ private:
+  std::shared_ptr<EncodedFrameTap> tap_;
+
+  /// Resolution of the last key frame, which delta frames do not carry. Only
+  /// accessed on the decoding thread.
+  int width_{0};
+  int height_{0};
+
+  /// Index of the next relayed frame. Only accessed on the decoding thread.
+  uint64_t next_index_{1};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
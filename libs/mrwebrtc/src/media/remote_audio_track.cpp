@@ -24,7 +24,8 @@ RemoteAudioTrack::RemoteAudioTrack(
                  owner),
       track_(std::move(track)),
       receiver_(std::move(receiver)),
-      transceiver_(transceiver) {
+      transceiver_(transceiver),
+      audio_mixer_(owner.audio_mixer()) {
   RTC_CHECK(owner_);
   RTC_CHECK(track_);
   RTC_CHECK(receiver_);
@@ -59,10 +60,23 @@ void RemoteAudioTrack::OnTrackRemoved(PeerConnection& owner) {
   transceiver_ = nullptr;
 }
 
+void RemoteAudioTrack::OnData(const void* audio_data,
+                              int bits_per_sample,
+                              int sample_rate,
+                              size_t number_of_channels,
+                              size_t number_of_frames) noexcept {
+  // Discard the stale audio the mixer drains when the track resumes.
+  if (ToggleAudioMixer::IsDrainingOnThisThread()) {
+    return;
+  }
+  AudioFrameObserver::OnData(audio_data, bits_per_sample, sample_rate,
+                             number_of_channels, number_of_frames);
+}
+
 void RemoteAudioTrack::OutputToDevice(bool output) noexcept {
   output_to_device_ = output;
   if (ssrc_) {
-    global_factory_->audio_mixer()->OutputSource(*ssrc_, output);
+    audio_mixer_->OutputSource(*ssrc_, output);
   }
   // else SSRC is unknown and we can't change the output state now. InitSsrc
   // will do it when called.
@@ -70,17 +84,118 @@ void RemoteAudioTrack::OutputToDevice(bool output) noexcept {
 
 void RemoteAudioTrack::InitSsrc(int ssrc) {
   RTC_DCHECK(!ssrc_);
+  rtc::CritScope lock(&consumer_lock_);
   ssrc_ = ssrc;
 
   // Now that we know the SSRC id, we can initialize the output state.
   // Note that the value is true by default but might have been changed
   // if OutputToDevice has been called in the track creation callback.
-  global_factory_->audio_mixer()->OutputSource(ssrc, output_to_device_);
+  rtc::scoped_refptr<ToggleAudioMixer> mixer = audio_mixer_;
+  mixer->OutputSource(ssrc, output_to_device_);
+  mixer->SetSourceConsumed(ssrc, consumer_count_ > 0);
+  float left = 1.0f;
+  float right = 1.0f;
+  GetChannelGains(left, right);
+  mixer->SetSourceGains(ssrc, left, right);
+}
+
+void RemoteAudioTrack::SetGain(float gain, float pan) noexcept {
+  rtc::CritScope lock(&consumer_lock_);
+  gain_ = gain;
+  pan_ = pan;
+  UpdateMixerGains();
+}
+
+void RemoteAudioTrack::SetMuted(bool muted) noexcept {
+  rtc::CritScope lock(&consumer_lock_);
+  muted_ = muted;
+  UpdateMixerGains();
+}
+
+void RemoteAudioTrack::SetSubscribed(bool subscribed) noexcept {
+  rtc::CritScope lock(&consumer_lock_);
+  subscribed_ = subscribed;
+  UpdateMixerGains();
+}
+
+void RemoteAudioTrack::GetChannelGains(float& left,
+                                       float& right) const noexcept {
+  if (muted_ || !subscribed_) {
+    left = right = 0.0f;
+    return;
+  }
+  // Balance law: a centered pan leaves both channels at the gain, and panning
+  // only attenuates the opposite channel.
+  const float gain = gain_;
+  const float pan = pan_;
+  left = gain * std::min(1.0f, 1.0f - pan);
+  right = gain * std::min(1.0f, 1.0f + pan);
+}
+
+void RemoteAudioTrack::UpdateMixerGains() noexcept {
+  if (ssrc_) {
+    float left = 1.0f;
+    float right = 1.0f;
+    GetChannelGains(left, right);
+    audio_mixer_->SetSourceGains(*ssrc_, left, right);
+  }
+  // else InitSsrc() sets the gains once the SSRC is known.
+}
+
+std::unique_ptr<AudioTrackReadBuffer>
+RemoteAudioTrack::CreateReadBuffer(
+    const mrsAudioTrackReadBufferOptions& options) noexcept {
+  // Register the consumer first, for the track to resume before the buffer
+  // receives any frame.
+  AddConsumer();
+  return std::make_unique<AudioTrackReadBuffer>(
+      track_, this, options.buffer_ms, options.resampling_quality);
+}
+
+void RemoteAudioTrack::SetCallback(AudioFrameReadyCallback callback) noexcept {
+  const bool has_callback = static_cast<bool>(callback);
+  rtc::CritScope lock(&consumer_lock_);
+  if (has_callback && !has_callback_) {
+    has_callback_ = true;
+    AddConsumer();
+  }
+  AudioFrameObserver::SetCallback(std::move(callback));
+  if (!has_callback && has_callback_) {
+    has_callback_ = false;
+    RemoveConsumer();
+  }
 }
 
-std::unique_ptr<AudioTrackReadBuffer> RemoteAudioTrack::CreateReadBuffer() const
-    noexcept {
-  return std::make_unique<AudioTrackReadBuffer>(track_);
+void RemoteAudioTrack::SetAudioLevelCallback(
+    AudioLevelChangedCallback callback,
+    float threshold) noexcept {
+  const bool has_callback = static_cast<bool>(callback);
+  rtc::CritScope lock(&consumer_lock_);
+  if (has_callback && !has_level_callback_) {
+    has_level_callback_ = true;
+    AddConsumer();
+  }
+  AudioFrameObserver::SetAudioLevelCallback(std::move(callback), threshold);
+  if (!has_callback && has_level_callback_) {
+    has_level_callback_ = false;
+    RemoveConsumer();
+  }
+}
+
+void RemoteAudioTrack::AddConsumer() noexcept {
+  // The lock is reentrant, for SetCallback().
+  rtc::CritScope lock(&consumer_lock_);
+  if ((consumer_count_++ == 0) && ssrc_) {
+    audio_mixer_->SetSourceConsumed(*ssrc_, true);
+  }
+}
+
+void RemoteAudioTrack::RemoveConsumer() noexcept {
+  rtc::CritScope lock(&consumer_lock_);
+  RTC_DCHECK_GT(consumer_count_, 0);
+  if ((--consumer_count_ == 0) && ssrc_) {
+    audio_mixer_->SetSourceConsumed(*ssrc_, false);
+  }
 }
 
 }  // namespace WebRTC
@@ -62,8 +62,40 @@ class RemoteAudioTrack : public MediaTrack, public AudioFrameObserver {
     return output_to_device_;
   }
 
-  /// See |mrsAudioTrackReadBufferCreate|.
-  std::unique_ptr<AudioTrackReadBuffer> CreateReadBuffer() const noexcept;
+  /// See |mrsRemoteAudioTrackSetGain|.
+  void SetGain(float gain, float pan) noexcept;
+
+  /// See |mrsRemoteAudioTrackSetMuted|.
+  void SetMuted(bool muted) noexcept;
+
+  /// Silence or restore the track while its transceiver is unsubscribed,
+  /// regardless of |SetMuted()|.
+  void SetSubscribed(bool subscribed) noexcept;
+
+  /// Get the gains of the left and right channels for the gain, pan, and mute
+  /// state of the track. This can be called from any thread.
+  void GetChannelGains(float& left, float& right) const noexcept;
+
+  /// See |mrsRemoteAudioTrackCreateReadBufferWithOptions|.
+  std::unique_ptr<AudioTrackReadBuffer> CreateReadBuffer(
+      const mrsAudioTrackReadBufferOptions& options) noexcept;
+
+  /// Register a frame callback, like |AudioFrameObserver::SetCallback()|, and
+  /// keep track of it as a consumer of the track.
+  void SetCallback(AudioFrameReadyCallback callback) noexcept;
+
+  /// Register a level callback, like
+  /// |AudioFrameObserver::SetAudioLevelCallback()|, and keep track of it as a
+  /// consumer of the track, so that the level is measured even when the track
+  /// is not output to the audio device.
+  void SetAudioLevelCallback(AudioLevelChangedCallback callback,
+                             float threshold) noexcept;
+
+  /// Register and unregister a consumer of the audio frames of the track, like
+  /// a read buffer. Tracks with no consumer and not output to the audio device
+  /// are not decoded.
+  void AddConsumer() noexcept;
+  void RemoveConsumer() noexcept;
 
   //
   // Advanced use
@@ -94,7 +126,18 @@ class RemoteAudioTrack : public MediaTrack, public AudioFrameObserver {
   /// Automatically called - do not use.
   void InitSsrc(int ssrc);
 
+ protected:
+  // AudioTrackSinkInterface interface
+  void OnData(const void* audio_data,
+              int bits_per_sample,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames) noexcept override;
+
  private:
+  /// Forward the gains of the track to the audio mixer, once the SSRC is
+  /// known.
+  void UpdateMixerGains() noexcept RTC_EXCLUSIVE_LOCKS_REQUIRED(consumer_lock_);
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::AudioTrackInterface> track_;
 
@@ -107,12 +150,38 @@ class RemoteAudioTrack : public MediaTrack, public AudioFrameObserver {
   /// gets destroyed when detached from the transceiver.
   Transceiver* transceiver_{nullptr};
 
+  /// Audio mixer of the peer connection, which outputs the track.
+  rtc::scoped_refptr<ToggleAudioMixer> audio_mixer_;
+
   /// SSRC id of the corresponding RtpReceiver.
   absl::optional<int> ssrc_;
 
   /// Indicates whether or not this track is output automatically to the
   /// system audio device.
   bool output_to_device_{true};
+
+  /// Gain, pan, and mute state, written by the application and read by the
+  /// audio threads consuming the track.
+  std::atomic<float> gain_{1.0f};
+  std::atomic<float> pan_{0.0f};
+  std::atomic_bool muted_{false};
+
+  /// Whether the transceiver of the track is subscribed. The track is silent
+  /// while unsubscribed.
+  std::atomic_bool subscribed_{true};
+
+  /// Serializes the changes of consumers, so that the audio mixer sees them in
+  /// order.
+  rtc::CriticalSection consumer_lock_;
+
+  /// Number of read buffers and frame callbacks consuming the track.
+  int consumer_count_ RTC_GUARDED_BY(consumer_lock_){0};
+
+  /// Is a frame callback registered?
+  bool has_callback_ RTC_GUARDED_BY(consumer_lock_){false};
+
+  /// Is a level callback registered?
+  bool has_level_callback_ RTC_GUARDED_BY(consumer_lock_){false};
 };
 
 }  // namespace WebRTC
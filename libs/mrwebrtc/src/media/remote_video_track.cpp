@@ -30,14 +30,26 @@ RemoteVideoTrack::RemoteVideoTrack(
   RTC_CHECK(transceiver_->GetMediaKind() == mrsMediaKind::kVideo);
   name_ = track_->id();
   kind_ = mrsTrackKind::kVideoTrack;
+  if (auto taps = global_factory_->encoded_frame_taps()) {
+    // The receive stream feeding the track has the same ID as the track.
+    encoded_frame_tap_ = taps->GetOrCreate(name_);
+    SetFrameMetadataTap(encoded_frame_tap_);
+  }
   transceiver_->OnRemoteTrackAdded(this);
+  // Receive the frames with their rotation, to deliver it to the callbacks
+  // instead of dropping the rotated frames.
   rtc::VideoSinkWants sink_settings{};
-  sink_settings.rotation_applied = true;
+  sink_settings.rotation_applied = false;
   track_->AddOrUpdateSink(this, sink_settings);
 }
 
 RemoteVideoTrack::~RemoteVideoTrack() {
   track_->RemoveSink(this);
+  StopRecording();
+  if (encoded_frame_tap_) {
+    encoded_frame_tap_->SetCallback({});
+    encoded_frame_tap_->SetDecodingEnabled(true);
+  }
   RTC_CHECK(!owner_);
 }
 
@@ -49,6 +61,81 @@ void RemoteVideoTrack::SetEnabled(bool enabled) const noexcept {
   track_->set_enabled(enabled);
 }
 
+Result RemoteVideoTrack::SetEncodedFrameCallback(
+    EncodedVideoFrameCallback callback) noexcept {
+  if (!encoded_frame_tap_) {
+    return Result::kUnsupported;
+  }
+  encoded_frame_tap_->SetCallback(callback);
+  return Result::kSuccess;
+}
+
+Result RemoteVideoTrack::SetDecodingEnabled(bool enabled) noexcept {
+  if (!encoded_frame_tap_) {
+    return Result::kUnsupported;
+  }
+  decoding_enabled_ = enabled;
+  encoded_frame_tap_->SetDecodingEnabled(enabled && subscribed_);
+  return Result::kSuccess;
+}
+
+Result RemoteVideoTrack::SetLowPriorityDecoding(bool low_priority) noexcept {
+  if (!encoded_frame_tap_) {
+    return Result::kUnsupported;
+  }
+  if (encoded_frame_tap_->IsLowPriorityDecoding() != low_priority) {
+    encoded_frame_tap_->SetLowPriorityDecoding(low_priority);
+    encoded_frame_tap_->RequestKeyFrame();
+  }
+  return Result::kSuccess;
+}
+
+void RemoteVideoTrack::SetSubscribed(bool subscribed) noexcept {
+  subscribed_ = subscribed;
+  if (encoded_frame_tap_) {
+    encoded_frame_tap_->SetDecodingEnabled(decoding_enabled_ && subscribed);
+  }
+}
+
+Result RemoteVideoTrack::RequestKeyFrame() noexcept {
+  if (!encoded_frame_tap_) {
+    return Result::kUnsupported;
+  }
+  encoded_frame_tap_->RequestKeyFrame();
+  return Result::kSuccess;
+}
+
+Result RemoteVideoTrack::StartRecording(const char* path) noexcept {
+  if (!encoded_frame_tap_) {
+    return Result::kUnsupported;
+  }
+  ErrorOr<std::unique_ptr<EncodedFrameRecorder>> recorder =
+      EncodedFrameRecorder::Create(path);
+  if (!recorder.ok()) {
+    return recorder.error().result();
+  }
+  StopRecording();
+  std::lock_guard<std::mutex> lock(recorder_mutex_);
+  recorder_ = recorder.MoveValue();
+  encoded_frame_tap_->AddSink(recorder_.get());
+  // Recording starts at the next key frame, which is requested right away
+  // instead of waiting for the next periodic one.
+  encoded_frame_tap_->RequestKeyFrame();
+  return Result::kSuccess;
+}
+
+uint32_t RemoteVideoTrack::StopRecording() noexcept {
+  std::lock_guard<std::mutex> lock(recorder_mutex_);
+  if (!recorder_) {
+    return 0;
+  }
+  // Once removed, the sink is not invoked anymore and can be destroyed.
+  encoded_frame_tap_->RemoveSink(recorder_.get());
+  const uint32_t frame_count = recorder_->frame_count();
+  recorder_ = nullptr;
+  return frame_count;
+}
+
 webrtc::VideoTrackInterface* RemoteVideoTrack::impl() const {
   return track_.get();
 }
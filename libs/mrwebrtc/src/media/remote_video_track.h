@@ -4,6 +4,8 @@
 #pragma once
 
 #include "callback.h"
+#include "encoded_frame_recording.h"
+#include "encoded_frame_tap.h"
 #include "interop_api.h"
 #include "media_track.h"
 #include "refptr.h"
@@ -52,6 +54,38 @@ class RemoteVideoTrack : public MediaTrack, public VideoFrameObserver {
   /// See |SetEnabled(bool)|.
   MRS_NODISCARD bool IsEnabled() const noexcept;
 
+  /// Register a callback invoked with each encoded frame of the track before
+  /// it is decoded. This is not supported on UWP.
+  Result SetEncodedFrameCallback(EncodedVideoFrameCallback callback) noexcept;
+
+  /// Enable or disable decoding the frames of the track. This is not supported
+  /// on UWP.
+  Result SetDecodingEnabled(bool enabled) noexcept;
+
+  /// Decode the frames of the track on a single thread, for example for the
+  /// tracks shown in the background, leaving the other decoding threads to the
+  /// other tracks. A key frame is requested from the remote peer to apply the
+  /// change. This is not supported on UWP.
+  Result SetLowPriorityDecoding(bool low_priority) noexcept;
+
+  /// Stop or resume decoding the frames of the track while its transceiver is
+  /// unsubscribed, regardless of |SetDecodingEnabled()|.
+  void SetSubscribed(bool subscribed) noexcept;
+
+  /// Ask the remote peer to send a key frame (PLI), for example to start
+  /// recording the encoded frames without waiting for the next periodic key
+  /// frame. The delta frames received until the key frame are not decoded.
+  /// This is not supported on UWP.
+  Result RequestKeyFrame() noexcept;
+
+  /// Start recording the encoded frames of the track to a file, replacing any
+  /// recording in progress. This is not supported on UWP.
+  Result StartRecording(const char* path) noexcept;
+
+  /// Stop recording the encoded frames of the track, if recording, and return
+  /// the number of frames recorded.
+  uint32_t StopRecording() noexcept;
+
   //
   // Advanced use
   //
@@ -70,6 +104,11 @@ class RemoteVideoTrack : public MediaTrack, public VideoFrameObserver {
     return transceiver_;
   }
 
+  /// Get the tap of the encoded frames of the track, or NULL if not supported.
+  MRS_NODISCARD std::shared_ptr<EncodedFrameTap> GetEncodedFrameTap() const {
+    return encoded_frame_tap_;
+  }
+
   MRS_NODISCARD webrtc::MediaStreamTrackInterface* GetMediaImpl()
       const override {
     return impl();
@@ -85,6 +124,20 @@ class RemoteVideoTrack : public MediaTrack, public VideoFrameObserver {
   /// RTP sender this track is associated with.
   rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver_;
 
+  /// Tap of the encoded frames of the receive stream feeding the track, or
+  /// NULL if not supported.
+  std::shared_ptr<EncodedFrameTap> encoded_frame_tap_;
+
+  /// Decoding state set by the application and by the subscription of the
+  /// transceiver; frames are decoded only if both allow it.
+  std::atomic_bool decoding_enabled_{true};
+  std::atomic_bool subscribed_{true};
+
+  /// Recorder of the encoded frames of the track, if recording.
+  std::mutex recorder_mutex_;
+  std::unique_ptr<EncodedFrameRecorder> recorder_
+      RTC_GUARDED_BY(recorder_mutex_);
+
   /// Weak back-pointer to the Transceiver this track is associated with. This
   /// avoids a circular reference with the transceiver itself.
   /// Note that unlike local tracks, this is never NULL since the remote track
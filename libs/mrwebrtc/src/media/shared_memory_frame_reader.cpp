@@ -0,0 +1,305 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/shared_memory_frame_reader.h"
+
+#include "media/external_video_track_source.h"
+#include "rtc_base/stringutils.h"
+#include "tracing.h"
+#include "utils.h"
+
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+namespace detail {
+
+/// View of a shared memory frame ring mapped into the current process.
+struct SharedFrameRing {
+  SharedFrameRing(HANDLE mapping, uint8_t* view, size_t size) noexcept
+      : mapping_(mapping), view_(view), size_(size) {}
+  ~SharedFrameRing() {
+    ::UnmapViewOfFile(view_);
+    ::CloseHandle(mapping_);
+  }
+
+  const mrsSharedFrameRingHeader& header() const noexcept {
+    return *reinterpret_cast<const mrsSharedFrameRingHeader*>(view_);
+  }
+
+  uint8_t* slot(uint32_t index) const noexcept {
+    return view_ + header().header_size + (size_t)index * header().slot_size;
+  }
+
+  /// Check that the header describes a ring fitting in the mapping, with
+  /// slots aligned for their atomic state and 64-bit fields.
+  bool IsValid() const noexcept {
+    if (size_ < sizeof(mrsSharedFrameRingHeader)) {
+      return false;
+    }
+    const mrsSharedFrameRingHeader& h = header();
+    return (h.magic == kMrsSharedFrameRingMagic) &&
+           (h.version == kMrsSharedFrameRingVersion) &&
+           (h.header_size >= sizeof(mrsSharedFrameRingHeader)) &&
+           (h.header_size % 8 == 0) && (h.slot_count > 0) &&
+           (h.slot_size >= sizeof(mrsSharedFrameSlotHeader)) &&
+           (h.slot_size % 8 == 0) &&
+           (h.header_size + (uint64_t)h.slot_count * h.slot_size <= size_);
+  }
+
+  HANDLE mapping_;
+  uint8_t* view_;
+  size_t size_;
+};
+
+}  // namespace detail
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+volatile LONG* SlotState(uint8_t* slot) noexcept {
+  return reinterpret_cast<volatile LONG*>(
+      &reinterpret_cast<mrsSharedFrameSlotHeader*>(slot)->state);
+}
+
+/// Atomically switch the state of a slot from |from| to |to|, and return
+/// whether the slot was in state |from|.
+bool SwitchSlotState(uint8_t* slot,
+                     mrsSharedFrameSlotState from,
+                     mrsSharedFrameSlotState to) noexcept {
+  return (::InterlockedCompareExchange(SlotState(slot), (LONG)to,
+                                       (LONG)from) == (LONG)from);
+}
+
+/// Check that the I420 planes described by a slot header lie within the slot.
+bool IsSlotFrameValid(const mrsSharedFrameSlotHeader& header,
+                      uint32_t slot_size) noexcept {
+  if ((header.width == 0) || (header.height == 0)) {
+    return false;
+  }
+  const uint64_t chroma_width = (header.width + 1) / 2;
+  const uint64_t chroma_height = (header.height + 1) / 2;
+  auto plane_fits = [slot_size](uint32_t offset, int32_t stride,
+                                uint64_t width, uint64_t height) {
+    return (stride > 0) && ((uint64_t)stride >= width) &&
+           (offset >= sizeof(mrsSharedFrameSlotHeader)) &&
+           (offset + (uint64_t)stride * (height - 1) + width <= slot_size);
+  };
+  return plane_fits(header.yoffset, header.ystride, header.width,
+                    header.height) &&
+         plane_fits(header.uoffset, header.ustride, chroma_width,
+                    chroma_height) &&
+         plane_fits(header.voffset, header.vstride, chroma_width,
+                    chroma_height);
+}
+
+/// I420 frame buffer wrapping the planes of a slot of a shared memory frame
+/// ring, handing the slot back to the producer when destroyed.
+class SharedSlotFrameBuffer : public webrtc::I420BufferInterface {
+ public:
+  SharedSlotFrameBuffer(std::shared_ptr<detail::SharedFrameRing> ring,
+                        uint8_t* slot) noexcept
+      : ring_(std::move(ring)),
+        slot_(slot),
+        header_(*reinterpret_cast<const mrsSharedFrameSlotHeader*>(slot)) {}
+
+  int width() const override { return (int)header_.width; }
+  int height() const override { return (int)header_.height; }
+  const uint8_t* DataY() const override { return slot_ + header_.yoffset; }
+  const uint8_t* DataU() const override { return slot_ + header_.uoffset; }
+  const uint8_t* DataV() const override { return slot_ + header_.voffset; }
+  int StrideY() const override { return header_.ystride; }
+  int StrideU() const override { return header_.ustride; }
+  int StrideV() const override { return header_.vstride; }
+
+  const mrsSharedFrameSlotHeader& header() const noexcept { return header_; }
+
+ protected:
+  ~SharedSlotFrameBuffer() override {
+    ::InterlockedExchange(SlotState(slot_),
+                          (LONG)mrsSharedFrameSlotState::kFree);
+  }
+
+ private:
+  std::shared_ptr<detail::SharedFrameRing> ring_;
+  uint8_t* const slot_;
+
+  /// Copy of the slot header, which the producer could otherwise corrupt
+  /// while the frame is in use.
+  const mrsSharedFrameSlotHeader header_;
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result SharedMemoryFrameReader::Open(
+    const char* mapping_name,
+    const char* doorbell_event_name,
+    std::unique_ptr<SharedMemoryFrameReader>& reader_out) {
+  if (IsStringNullOrEmpty(mapping_name) ||
+      IsStringNullOrEmpty(doorbell_event_name)) {
+    return Result::kInvalidParameter;
+  }
+  HANDLE mapping = ::OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE,
+                                      rtc::ToUtf16(mapping_name).c_str());
+  if (!mapping) {
+    RTC_LOG(LS_ERROR) << "Failed to open shared memory frame ring "
+                      << mapping_name << ": error " << ::GetLastError();
+    return Result::kNotFound;
+  }
+  void* view =
+      ::MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION info{};
+  if (!view || !::VirtualQuery(view, &info, sizeof(info))) {
+    RTC_LOG(LS_ERROR) << "Failed to map shared memory frame ring "
+                      << mapping_name << ": error " << ::GetLastError();
+    if (view) {
+      ::UnmapViewOfFile(view);
+    }
+    ::CloseHandle(mapping);
+    return Result::kUnknownError;
+  }
+  auto ring = std::make_shared<detail::SharedFrameRing>(
+      mapping, static_cast<uint8_t*>(view), info.RegionSize);
+  if (!ring->IsValid()) {
+    RTC_LOG(LS_ERROR) << "Invalid header for shared memory frame ring "
+                      << mapping_name;
+    return Result::kInvalidParameter;
+  }
+  HANDLE doorbell_event = ::OpenEventW(
+      SYNCHRONIZE, FALSE, rtc::ToUtf16(doorbell_event_name).c_str());
+  if (!doorbell_event) {
+    RTC_LOG(LS_ERROR) << "Failed to open doorbell event "
+                      << doorbell_event_name << ": error " << ::GetLastError();
+    return Result::kNotFound;
+  }
+  HANDLE stop_event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (!stop_event) {
+    ::CloseHandle(doorbell_event);
+    return Result::kUnknownError;
+  }
+  reader_out.reset(new SharedMemoryFrameReader(std::move(ring), doorbell_event,
+                                               stop_event));
+  return Result::kSuccess;
+}
+
+SharedMemoryFrameReader::SharedMemoryFrameReader(
+    std::shared_ptr<detail::SharedFrameRing> ring,
+    void* doorbell_event,
+    void* stop_event) noexcept
+    : ring_(std::move(ring)),
+      doorbell_event_(doorbell_event),
+      stop_event_(stop_event) {}
+
+SharedMemoryFrameReader::~SharedMemoryFrameReader() {
+  Stop();
+  ::CloseHandle(stop_event_);
+  ::CloseHandle(doorbell_event_);
+}
+
+void SharedMemoryFrameReader::Start(ExternalVideoTrackSource* source) {
+  RTC_DCHECK(!thread_.joinable());
+  source_ = source;
+  thread_ = std::thread(&SharedMemoryFrameReader::Run, this);
+}
+
+void SharedMemoryFrameReader::Stop() noexcept {
+  if (thread_.joinable()) {
+    ::SetEvent(stop_event_);
+    thread_.join();
+  }
+}
+
+void SharedMemoryFrameReader::Run() {
+  const HANDLE handles[] = {stop_event_, doorbell_event_};
+  while (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) ==
+         WAIT_OBJECT_0 + 1) {
+    ReadLatestFrame();
+  }
+}
+
+void SharedMemoryFrameReader::ReadLatestFrame() {
+  MRS_TRACE_SCOPE1(Media, "SharedMemoryFrameReader::ReadLatestFrame", "source",
+                   (intptr_t)source_);
+  const mrsSharedFrameRingHeader& ring_header = ring_->header();
+  uint8_t* latest = nullptr;
+  uint64_t latest_sequence = 0;
+  for (uint32_t i = 0; i < ring_header.slot_count; ++i) {
+    uint8_t* const slot = ring_->slot(i);
+    if (*SlotState(slot) != (LONG)mrsSharedFrameSlotState::kReady) {
+      continue;
+    }
+    const uint64_t sequence =
+        reinterpret_cast<const mrsSharedFrameSlotHeader*>(slot)->sequence;
+    uint8_t* stale = slot;
+    if (!latest || (sequence > latest_sequence)) {
+      stale = latest;
+      latest = slot;
+      latest_sequence = sequence;
+    }
+    // Only the consumer moves a slot out of |kReady|, so this cannot fail.
+    if (stale) {
+      SwitchSlotState(stale, mrsSharedFrameSlotState::kReady,
+                      mrsSharedFrameSlotState::kFree);
+    }
+  }
+  if (!latest || !SwitchSlotState(latest, mrsSharedFrameSlotState::kReady,
+                                  mrsSharedFrameSlotState::kReading)) {
+    return;
+  }
+  // Wrap the slot before validating it, so that it is freed in all cases.
+  rtc::scoped_refptr<SharedSlotFrameBuffer> buffer =
+      new rtc::RefCountedObject<SharedSlotFrameBuffer>(ring_, latest);
+  const mrsSharedFrameSlotHeader& header = buffer->header();
+  if (!IsSlotFrameValid(header, ring_header.slot_size)) {
+    RTC_LOG(LS_WARNING) << "Dropping invalid frame #" << header.sequence
+                        << " from shared memory frame ring.";
+    return;
+  }
+  source_->PushFrame(std::move(buffer), header.timestamp_ms);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#else  // defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+struct SharedFrameRing {};
+}  // namespace detail
+
+Result SharedMemoryFrameReader::Open(
+    const char* /*mapping_name*/,
+    const char* /*doorbell_event_name*/,
+    std::unique_ptr<SharedMemoryFrameReader>& /*reader_out*/) {
+  return Result::kUnsupported;
+}
+
+SharedMemoryFrameReader::~SharedMemoryFrameReader() = default;
+
+void SharedMemoryFrameReader::Start(ExternalVideoTrackSource* /*source*/) {}
+
+void SharedMemoryFrameReader::Stop() noexcept {}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#endif  // defined(MR_SHARING_WIN) && !defined(WINUWP)
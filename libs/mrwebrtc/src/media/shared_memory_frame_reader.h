@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <thread>
+
+#include "external_video_track_source_interop.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class ExternalVideoTrackSource;
+
+namespace detail {
+struct SharedFrameRing;
+}  // namespace detail
+
+/// Reader of the frames written by another process to a shared memory frame
+/// ring, as described by |mrsSharedFrameRingHeader|. The reader waits on the
+/// doorbell event of the ring on a dedicated thread, and pushes the most
+/// recent frame ready to an external video track source, as a frame buffer
+/// wrapping the slot memory without copy. The slot is handed back to the
+/// producer once that frame buffer is destroyed.
+class SharedMemoryFrameReader {
+ public:
+  /// Open the file mapping and doorbell event created by the producer, and
+  /// validate the header of the ring. This returns |kUnsupported| on platforms
+  /// other than Windows desktop, |kNotFound| if the mapping or the event do
+  /// not exist, and |kInvalidParameter| if the ring header is not valid.
+  static Result Open(const char* mapping_name,
+                     const char* doorbell_event_name,
+                     std::unique_ptr<SharedMemoryFrameReader>& reader_out);
+
+  ~SharedMemoryFrameReader();
+
+  /// Start reading frames and pushing them to |source|, which must outlive
+  /// the reader or call |Stop()| before it is destroyed.
+  void Start(ExternalVideoTrackSource* source);
+
+  /// Stop reading frames, and wait for the frame being pushed, if any. Frames
+  /// already pushed keep their slot until released. This is idempotent.
+  void Stop() noexcept;
+
+ private:
+  SharedMemoryFrameReader(std::shared_ptr<detail::SharedFrameRing> ring,
+                          void* doorbell_event,
+                          void* stop_event) noexcept;
+
+  /// Wait for the doorbell until stopped. This runs on |thread_|.
+  void Run();
+
+  /// Push the frame of the ready slot with the highest sequence number, if
+  /// any, and hand the older ready slots back to the producer.
+  void ReadLatestFrame();
+
+  /// Mapping of the ring, shared with the frame buffers wrapping its slots so
+  /// that it stays mapped until they are all released.
+  std::shared_ptr<detail::SharedFrameRing> ring_;
+
+  /// Auto-reset event signaled by the producer when a slot becomes ready.
+  void* doorbell_event_{nullptr};
+
+  /// Manual-reset event signaled to stop |thread_|.
+  void* stop_event_{nullptr};
+
+  ExternalVideoTrackSource* source_{nullptr};
+  std::thread thread_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/synthetic_frame_generator.h"
+
+#include <algorithm>
+
+namespace {
+
+/// Maximum width and height of the generated frames, in pixels.
+constexpr uint32_t kMaxSyntheticFrameSize = 8192;
+
+/// Number of pixels the moving pattern scrolls by each frame.
+constexpr int kScrollSpeed = 4;
+
+/// YUV values of the color bars: white, yellow, cyan, green, magenta, red,
+/// blue, and black.
+constexpr uint8_t kBarY[] = {235, 210, 170, 145, 106, 81, 41, 16};
+constexpr uint8_t kBarU[] = {128, 16, 166, 54, 202, 90, 240, 128};
+constexpr uint8_t kBarV[] = {128, 146, 16, 34, 222, 240, 110, 128};
+constexpr int kBarCount = sizeof(kBarY);
+
+/// Fill the first row of a plane with color bars, then copy it to all rows.
+void FillBarPlane(uint8_t* data,
+                  int stride,
+                  int width,
+                  int height,
+                  const uint8_t (&values)[kBarCount]) {
+  for (int x = 0; x < width; ++x) {
+    data[x] = values[(int64_t)x * kBarCount / width];
+  }
+  for (int y = 1; y < height; ++y) {
+    memcpy(data + (ptrdiff_t)y * stride, data, width);
+  }
+}
+
+void FillPlane(uint8_t* data,
+               int stride,
+               int width,
+               int height,
+               uint8_t value) {
+  for (int y = 0; y < height; ++y) {
+    memset(data + (ptrdiff_t)y * stride, value, width);
+  }
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+bool SyntheticFrameGenerator::IsValidConfig(
+    const mrsSyntheticVideoSourceConfig& config) noexcept {
+  return (config.width > 0) && (config.width <= kMaxSyntheticFrameSize) &&
+         (config.height > 0) && (config.height <= kMaxSyntheticFrameSize) &&
+         (config.complexity >= mrsSyntheticVideoComplexity::kStatic) &&
+         (config.complexity <= mrsSyntheticVideoComplexity::kNoise);
+}
+
+SyntheticFrameGenerator::SyntheticFrameGenerator(
+    const mrsSyntheticVideoSourceConfig& config)
+    : width_((int)config.width),
+      height_((int)config.height),
+      complexity_(config.complexity) {
+  RTC_DCHECK(IsValidConfig(config));
+  if (complexity_ == mrsSyntheticVideoComplexity::kModerateMotion) {
+    luma_ramp_.resize((size_t)width_ * 2);
+    for (size_t i = 0; i < luma_ramp_.size(); ++i) {
+      luma_ramp_[i] = (uint8_t)(i * 2);
+    }
+  }
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> SyntheticFrameGenerator::NextFrame(
+    FrameBufferPool& pool) {
+  ++frame_number_;
+  if (complexity_ == mrsSyntheticVideoComplexity::kStatic) {
+    // Frame buffers are never written once delivered, so all frames can share
+    // the same buffer, which costs nothing to produce.
+    if (!static_frame_) {
+      static_frame_ = webrtc::I420Buffer::Create(width_, height_);
+      DrawColorBars(*static_frame_);
+    }
+    return static_frame_;
+  }
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      pool.CreateBuffer(width_, height_);
+  if (complexity_ == mrsSyntheticVideoComplexity::kNoise) {
+    DrawNoise(*buffer);
+  } else {
+    DrawMotion(*buffer);
+  }
+  return buffer;
+}
+
+void SyntheticFrameGenerator::DrawColorBars(webrtc::I420Buffer& buffer) const {
+  FillBarPlane(buffer.MutableDataY(), buffer.StrideY(), width_, height_,
+               kBarY);
+  FillBarPlane(buffer.MutableDataU(), buffer.StrideU(), buffer.ChromaWidth(),
+               buffer.ChromaHeight(), kBarU);
+  FillBarPlane(buffer.MutableDataV(), buffer.StrideV(), buffer.ChromaWidth(),
+               buffer.ChromaHeight(), kBarV);
+}
+
+void SyntheticFrameGenerator::DrawMotion(webrtc::I420Buffer& buffer) const {
+  // Each row is a window into the ramp, shifted by one pixel per row and by
+  // |kScrollSpeed| pixels per frame, which scrolls a diagonal gradient.
+  const int scroll = (int)((frame_number_ * kScrollSpeed) % width_);
+  uint8_t* const ydata = buffer.MutableDataY();
+  for (int y = 0; y < height_; ++y) {
+    const int offset = (scroll + y) % width_;
+    memcpy(ydata + (ptrdiff_t)y * buffer.StrideY(), &luma_ramp_[offset],
+           width_);
+  }
+  const uint8_t u = (uint8_t)frame_number_;
+  FillPlane(buffer.MutableDataU(), buffer.StrideU(), buffer.ChromaWidth(),
+            buffer.ChromaHeight(), u);
+  FillPlane(buffer.MutableDataV(), buffer.StrideV(), buffer.ChromaWidth(),
+            buffer.ChromaHeight(), (uint8_t)(255 - u));
+}
+
+void SyntheticFrameGenerator::DrawNoise(webrtc::I420Buffer& buffer) {
+  auto fill = [this](uint8_t* data, int stride, int width, int height) {
+    for (int y = 0; y < height; ++y) {
+      uint8_t* row = data + (ptrdiff_t)y * stride;
+      for (int x = 0; x < width; x += 8) {
+        // xorshift64, cheap enough to generate noise for many sources.
+        noise_state_ ^= noise_state_ << 13;
+        noise_state_ ^= noise_state_ >> 7;
+        noise_state_ ^= noise_state_ << 17;
+        memcpy(row + x, &noise_state_, std::min(8, width - x));
+      }
+    }
+  };
+  fill(buffer.MutableDataY(), buffer.StrideY(), width_, height_);
+  fill(buffer.MutableDataU(), buffer.StrideU(), buffer.ChromaWidth(),
+       buffer.ChromaHeight());
+  fill(buffer.MutableDataV(), buffer.StrideV(), buffer.ChromaWidth(),
+       buffer.ChromaHeight());
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+
+#include "external_video_track_source_interop.h"
+#include "frame_buffer_pool.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Generator of the test patterns of a synthetic video track source. This is
+/// not thread-safe; frames are generated on the capture thread only.
+class SyntheticFrameGenerator {
+ public:
+  /// Check that a configuration is valid for |SyntheticFrameGenerator()|.
+  static bool IsValidConfig(
+      const mrsSyntheticVideoSourceConfig& config) noexcept;
+
+  explicit SyntheticFrameGenerator(
+      const mrsSyntheticVideoSourceConfig& config);
+
+  /// Generate the next frame. Static frames share a single buffer generated
+  /// once, while the others are generated into a buffer from |pool|.
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> NextFrame(
+      FrameBufferPool& pool);
+
+ private:
+  /// Draw the still test pattern, a set of vertical color bars.
+  void DrawColorBars(webrtc::I420Buffer& buffer) const;
+
+  /// Draw a diagonal gradient scrolled by the frame number, with colors
+  /// cycling over a few seconds.
+  void DrawMotion(webrtc::I420Buffer& buffer) const;
+
+  /// Fill the buffer with random noise.
+  void DrawNoise(webrtc::I420Buffer& buffer);
+
+  const int width_;
+  const int height_;
+  const mrsSyntheticVideoComplexity complexity_;
+
+  /// Single frame of static sources.
+  rtc::scoped_refptr<webrtc::I420Buffer> static_frame_;
+
+  /// Luma gradient, twice as wide as the frames, each row of the moving
+  /// pattern being a window into it.
+  std::vector<uint8_t> luma_ramp_;
+
+  uint32_t frame_number_{0};
+
+  /// State of the xorshift generator of the noise.
+  uint64_t noise_state_{0x9E3779B97F4A7C15ull};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -4,6 +4,7 @@
 #include "pch.h"
 
 #include "interop/global_factory.h"
+#include "media/base/mediaconstants.h"
 #include "peer_connection.h"
 #include "transceiver.h"
 #include "utils.h"
@@ -165,7 +166,7 @@ Result Transceiver::SetDirection(Direction new_direction) noexcept {
   if (transceiver_) {  // Unified Plan
     // Change the RTP transceiver direction; this will trigger a
     // |RenegotiationNeeded| event.
-    transceiver_->SetDirection(ToRtp(new_direction));
+    transceiver_->SetDirection(ToRtp(GetWireDirection()));
   } else {  // Plan B
     RTC_DCHECK(plan_b_);
     // Force a manual |RenegotiationNeeded| event for parity with Unified Plan.
@@ -175,6 +176,59 @@ Result Transceiver::SetDirection(Direction new_direction) noexcept {
   return Result::kSuccess;
 }
 
+Result Transceiver::SetSubscribed(bool subscribed) noexcept {
+  if (subscribed_.exchange(subscribed) == subscribed) {
+    return Result::kSuccess;
+  }
+  // Stop decoding right away, as the media keeps flowing until the remote peer
+  // applies the new direction.
+  ApplySubscriptionToRemoteTrack();
+  // Renegotiate if the direction changes, to let the remote peer stop or
+  // resume sending.
+  if ((desired_direction_ == Direction::kSendRecv) ||
+      (desired_direction_ == Direction::kRecvOnly)) {
+    if (transceiver_) {  // Unified Plan
+      transceiver_->SetDirection(ToRtp(GetWireDirection()));
+    } else {  // Plan B
+      RTC_DCHECK(plan_b_);
+      owner_->InvokeRenegotiationNeeded();
+    }
+  }
+  if (subscribed) {
+    // Announce the remote track received while unsubscribed, if any.
+    owner_->AnnounceRemoteTrack(*this);
+  }
+  return Result::kSuccess;
+}
+
+Transceiver::Direction Transceiver::GetWireDirection() const noexcept {
+  if (subscribed_) {
+    return desired_direction_;
+  }
+  switch (desired_direction_) {
+    case Direction::kSendRecv:
+      return Direction::kSendOnly;
+    case Direction::kRecvOnly:
+      return Direction::kInactive;
+    default:
+      return desired_direction_;
+  }
+}
+
+void Transceiver::ApplySubscriptionToRemoteTrack() noexcept {
+  if (!remote_track_) {
+    return;
+  }
+  if (GetMediaKind() == MediaKind::kAudio) {
+    auto const track = (RemoteAudioTrack*)remote_track_.get();
+    track->SetSubscribed(subscribed_);
+  } else {
+    RTC_DCHECK(GetMediaKind() == MediaKind::kVideo);
+    auto const track = (RemoteVideoTrack*)remote_track_.get();
+    track->SetSubscribed(subscribed_);
+  }
+}
+
 bool Transceiver::HasSender(webrtc::RtpSenderInterface* sender) const {
   if (transceiver_) {
     return (transceiver_->sender() == sender);
@@ -191,6 +245,228 @@ bool Transceiver::HasReceiver(webrtc::RtpReceiverInterface* receiver) const {
   }
 }
 
+webrtc::RtpSenderInterface* Transceiver::GetRtpSender() const noexcept {
+  if (transceiver_) {
+    return transceiver_->sender().get();
+  } else {
+    return plan_b_->rtp_sender_.get();
+  }
+}
+
+webrtc::RtpReceiverInterface* Transceiver::GetRtpReceiver() const noexcept {
+  if (transceiver_) {
+    return transceiver_->receiver().get();
+  } else {
+    return plan_b_->rtp_receiver_.get();
+  }
+}
+
+Result Transceiver::SetEncodingParameters(
+    const mrsRtpEncodingParameters* encodings,
+    int count) noexcept {
+  webrtc::RtpSenderInterface* const sender = GetRtpSender();
+  if (!sender) {
+    RTC_LOG(LS_ERROR) << "Transceiver " << name_
+                      << " has no RTP sender yet to set encodings of.";
+    return Result::kInvalidOperation;
+  }
+  webrtc::RtpParameters parameters = sender->GetParameters();
+  if (count != (int)parameters.encodings.size()) {
+    RTC_LOG(LS_ERROR) << "Transceiver " << name_ << " has "
+                      << parameters.encodings.size() << " encodings, but "
+                      << count << " were provided.";
+    return Result::kInvalidParameter;
+  }
+  Error scalability_error = CheckScalabilityMode(
+      GetMediaKind(), encodings, count, global_factory_->GetVp9Layers());
+  if (!scalability_error.ok()) {
+    RTC_LOG(LS_ERROR) << scalability_error.message();
+    return scalability_error.result();
+  }
+  for (int i = 0; i < count; ++i) {
+    ErrorOr<webrtc::RtpEncodingParameters> new_encoding =
+        EncodingParametersToRtc(encodings[i]);
+    if (!new_encoding.ok()) {
+      RTC_LOG(LS_ERROR) << new_encoding.error().message();
+      return new_encoding.error().result();
+    }
+    // Only update the fields exposed, keeping the SSRC and other fields
+    // negotiated by the implementation.
+    const webrtc::RtpEncodingParameters& src = new_encoding.value();
+    webrtc::RtpEncodingParameters& dst = parameters.encodings[i];
+    if (!src.rid.empty() && (src.rid != dst.rid)) {
+      RTC_LOG(LS_ERROR) << "Cannot change the RID of encoding #" << i
+                        << " of transceiver " << name_ << ".";
+      return Result::kInvalidParameter;
+    }
+    dst.scale_resolution_down_by = src.scale_resolution_down_by;
+    dst.max_bitrate_bps = src.max_bitrate_bps;
+    dst.max_framerate = src.max_framerate;
+    dst.active = src.active;
+    dst.bitrate_priority = src.bitrate_priority;
+  }
+  webrtc::RTCError error = sender->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to set encodings of transceiver " << name_
+                      << ": " << error.message();
+  }
+  return ResultFromRTCErrorType(error.type());
+}
+
+Result Transceiver::SetDegradationPreference(
+    mrsDegradationPreference preference) noexcept {
+  const Result result = ApplyDegradationPreference(preference);
+  if (result == Result::kSuccess) {
+    has_degradation_preference_.store(true, std::memory_order_relaxed);
+  }
+  return result;
+}
+
+Result Transceiver::SetContentDegradationPreference(
+    mrsDegradationPreference preference) noexcept {
+  if (has_degradation_preference_.load(std::memory_order_relaxed)) {
+    return Result::kSuccess;
+  }
+  return ApplyDegradationPreference(preference);
+}
+
+Result Transceiver::ApplyDegradationPreference(
+    mrsDegradationPreference preference) noexcept {
+  if (kind_ != mrsMediaKind::kVideo) {
+    return Result::kInvalidMediaKind;
+  }
+  webrtc::DegradationPreference rtc_preference;
+  switch (preference) {
+    case mrsDegradationPreference::kDisabled:
+      rtc_preference = webrtc::DegradationPreference::DISABLED;
+      break;
+    case mrsDegradationPreference::kMaintainFramerate:
+      rtc_preference = webrtc::DegradationPreference::MAINTAIN_FRAMERATE;
+      break;
+    case mrsDegradationPreference::kMaintainResolution:
+      rtc_preference = webrtc::DegradationPreference::MAINTAIN_RESOLUTION;
+      break;
+    case mrsDegradationPreference::kBalanced:
+      rtc_preference = webrtc::DegradationPreference::BALANCED;
+      break;
+    default:
+      return Result::kInvalidParameter;
+  }
+  webrtc::RtpSenderInterface* const sender = GetRtpSender();
+  if (!sender) {
+    RTC_LOG(LS_ERROR) << "Transceiver " << name_
+                      << " has no RTP sender yet to set the degradation "
+                         "preference of.";
+    return Result::kInvalidOperation;
+  }
+  webrtc::RtpParameters parameters = sender->GetParameters();
+  parameters.degradation_preference = rtc_preference;
+  webrtc::RTCError error = sender->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to set degradation preference of transceiver "
+                      << name_ << ": " << error.message();
+  }
+  return ResultFromRTCErrorType(error.type());
+}
+
+Result Transceiver::SetCodecPreferences(
+    std::vector<SdpCodecPreference> preferences) noexcept {
+  if (!IsUnifiedPlan()) {
+    // Plan B emulated transceivers of the same kind share a media line.
+    return Result::kUnsupported;
+  }
+  std::lock_guard<std::mutex> lock(codec_preferences_mutex_);
+  codec_preferences_ = std::move(preferences);
+  return Result::kSuccess;
+}
+
+std::vector<SdpCodecPreference> Transceiver::GetCodecPreferences() const {
+  std::lock_guard<std::mutex> lock(codec_preferences_mutex_);
+  return codec_preferences_;
+}
+
+Result Transceiver::SetAudioCodecOptions(
+    const mrsAudioCodecOptions& options) noexcept {
+  if (kind_ != mrsMediaKind::kAudio) {
+    return Result::kInvalidMediaKind;
+  }
+  if (!IsUnifiedPlan()) {
+    // Plan B emulated transceivers of the same kind share a media line.
+    return Result::kUnsupported;
+  }
+  if (((options.ptime_ms != 0) &&
+       ((options.ptime_ms < 10) || (options.ptime_ms > 120))) ||
+      (options.max_bitrate_bps < 0)) {
+    return Result::kInvalidParameter;
+  }
+  std::map<std::string, std::string> params;
+  auto set_bool_param = [&params](const char* name, mrsOptBool value) {
+    if (value != mrsOptBool::kUnset) {
+      params[name] = (value == mrsOptBool::kFalse ? "0" : "1");
+    }
+  };
+  set_bool_param(cricket::kCodecParamUseDtx, options.dtx);
+  set_bool_param(cricket::kCodecParamUseInbandFec, options.fec);
+  // The receiver asks for stereo, while the sender declares it sends stereo.
+  set_bool_param(cricket::kCodecParamStereo, options.stereo);
+  set_bool_param(cricket::kCodecParamSPropStereo, options.stereo);
+  if (options.ptime_ms > 0) {
+    params[cricket::kCodecParamPtime] = std::to_string(options.ptime_ms);
+  }
+  {
+    std::lock_guard<std::mutex> lock(codec_preferences_mutex_);
+    audio_codec_params_ = std::move(params);
+  }
+  audio_max_bitrate_bps_.store(options.max_bitrate_bps,
+                               std::memory_order_relaxed);
+  return ApplyAudioMaxBitrate();
+}
+
+std::map<std::string, std::string> Transceiver::GetAudioCodecParams() const {
+  std::lock_guard<std::mutex> lock(codec_preferences_mutex_);
+  return audio_codec_params_;
+}
+
+Result Transceiver::SubscribeQualityLimitation(
+    const mrsQualityLimitationConfig& config,
+    QualityLimitationCallback callback) noexcept {
+  if (kind_ != mrsMediaKind::kVideo) {
+    return Result::kInvalidMediaKind;
+  }
+  return owner_->SubscribeQualityLimitation(*this, config, callback);
+}
+
+Result Transceiver::ApplyAudioMaxBitrate() noexcept {
+  const int max_bitrate_bps =
+      audio_max_bitrate_bps_.load(std::memory_order_relaxed);
+  if (max_bitrate_bps < 0) {
+    return Result::kSuccess;
+  }
+  webrtc::RtpSenderInterface* const sender = GetRtpSender();
+  if (!sender) {
+    return Result::kSuccess;
+  }
+  // The sender has no encoding until negotiated, in which case this is called
+  // again once it is.
+  webrtc::RtpParameters parameters = sender->GetParameters();
+  if (parameters.encodings.empty()) {
+    return Result::kSuccess;
+  }
+  const absl::optional<int> new_bitrate =
+      (max_bitrate_bps > 0 ? absl::optional<int>(max_bitrate_bps)
+                           : absl::nullopt);
+  if (parameters.encodings[0].max_bitrate_bps == new_bitrate) {
+    return Result::kSuccess;
+  }
+  parameters.encodings[0].max_bitrate_bps = new_bitrate;
+  webrtc::RTCError error = sender->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to set maximum bitrate of transceiver "
+                      << name_ << ": " << error.message();
+  }
+  return ResultFromRTCErrorType(error.type());
+}
+
 Result Transceiver::SetLocalTrackImpl(RefPtr<MediaTrack> local_track) noexcept {
   if (local_track_ == local_track) {
     return Result::kSuccess;
@@ -495,9 +771,10 @@ void Transceiver::OnSessionDescUpdated(bool remote, bool forced) {
       }
     }
 
-    // Check desired direction
+    // Check desired direction, which differs from the one of the RTP
+    // transceiver while unsubscribed.
     auto desired = transceiver_->direction();
-    {
+    if (subscribed_) {
       auto newValue = FromRtp(desired);
       if (newValue != desired_direction_) {
         desired_direction_ = newValue;
@@ -518,6 +795,10 @@ void Transceiver::OnSessionDescUpdated(bool remote, bool forced) {
     // TODO - Check desired direction?
   }
 
+  if (kind_ == mrsMediaKind::kAudio) {
+    ApplyAudioMaxBitrate();
+  }
+
   // Invoke interop callback if any
   if (changed || forced) {
     FireStateUpdatedEvent(remote
@@ -9,6 +9,8 @@
 #include "media/local_video_track.h"
 #include "media/remote_audio_track.h"
 #include "media/remote_video_track.h"
+#include "quality_limitation_monitor.h"
+#include "sdp_utils.h"
 #include "tracked_object.h"
 
 namespace rtc {
@@ -83,6 +85,56 @@ class Transceiver : public TrackedObject {
   /// offers/answers.
   Result SetDirection(Direction new_direction) noexcept;
 
+  /// Subscribe to or unsubscribe from the media received by the transceiver.
+  /// See |mrsTransceiverSetSubscribed()|.
+  Result SetSubscribed(bool subscribed) noexcept;
+
+  MRS_NODISCARD bool IsSubscribed() const noexcept { return subscribed_; }
+
+  /// Get the direction to use in the next SDP offers and answers, which is the
+  /// desired direction without receiving while unsubscribed.
+  MRS_NODISCARD Direction GetWireDirection() const noexcept;
+
+  /// Set the parameters of the encodings of the RTP sender. See
+  /// |mrsTransceiverSetEncodingParameters()|.
+  Result SetEncodingParameters(const mrsRtpEncodingParameters* encodings,
+                               int count) noexcept;
+
+  /// Set the degradation preference of the RTP sender. See
+  /// |mrsTransceiverSetDegradationPreference()|.
+  Result SetDegradationPreference(
+      mrsDegradationPreference preference) noexcept;
+
+  /// Set the degradation preference of the RTP sender suited to the content of
+  /// its local video track, unless the application already set one with
+  /// |SetDegradationPreference()|.
+  Result SetContentDegradationPreference(
+      mrsDegradationPreference preference) noexcept;
+
+  /// Set the codecs preferred for the media line of the transceiver in the
+  /// next SDP offers and answers. See |mrsTransceiverSetCodecPreferences()|.
+  Result SetCodecPreferences(
+      std::vector<SdpCodecPreference> preferences) noexcept;
+
+  /// Get the codecs preferred for the media line of the transceiver, or an
+  /// empty list if none.
+  MRS_NODISCARD std::vector<SdpCodecPreference> GetCodecPreferences() const;
+
+  /// Set the options of the Opus encoder of the transceiver. See
+  /// |mrsTransceiverSetAudioCodecOptions()|.
+  Result SetAudioCodecOptions(const mrsAudioCodecOptions& options) noexcept;
+
+  /// Get the Opus format parameters overridden by the audio codec options of
+  /// the transceiver, or an empty map if none.
+  MRS_NODISCARD std::map<std::string, std::string> GetAudioCodecParams() const;
+
+  /// Subscribe to the quality limitation changes of the video sender, or
+  /// unsubscribe if |callback| is empty. See
+  /// |mrsTransceiverSubscribeQualityLimitation()|.
+  Result SubscribeQualityLimitation(
+      const mrsQualityLimitationConfig& config,
+      QualityLimitationCallback callback) noexcept;
+
   MRS_NODISCARD bool IsUnifiedPlan() const {
     RTC_DCHECK(!plan_b_ != !transceiver_);
     return (transceiver_ != nullptr);
@@ -93,6 +145,14 @@ class Transceiver : public TrackedObject {
   MRS_NODISCARD bool HasSender(webrtc::RtpSenderInterface* sender) const;
   MRS_NODISCARD bool HasReceiver(webrtc::RtpReceiverInterface* receiver) const;
 
+  /// Get the RTP sender of the transceiver, if any. In Plan B this only exists
+  /// while the desired direction allows sending.
+  MRS_NODISCARD webrtc::RtpSenderInterface* GetRtpSender() const noexcept;
+
+  /// Get the RTP receiver of the transceiver, if any. In Plan B this only
+  /// exists once a remote track was received.
+  MRS_NODISCARD webrtc::RtpReceiverInterface* GetRtpReceiver() const noexcept;
+
   Result SetLocalTrack(std::nullptr_t) noexcept {
     return SetLocalTrackImpl(nullptr);
   }
@@ -146,6 +206,24 @@ class Transceiver : public TrackedObject {
   void OnRemoteTrackRemoved(RemoteAudioTrack* track);
   void OnRemoteTrackRemoved(RemoteVideoTrack* track);
 
+  /// Mark the remote track as announced by the track added callbacks of the
+  /// peer connection. Return false if it was already announced, in which case
+  /// the callbacks must not be invoked again.
+  bool MarkRemoteTrackAnnounced() noexcept {
+    return !remote_track_announced_.exchange(true);
+  }
+
+  /// Clear the announced state of the remote track being removed, and return
+  /// whether it was announced, that is whether the track removed callbacks
+  /// must be invoked.
+  bool ClearRemoteTrackAnnounced() noexcept {
+    return remote_track_announced_.exchange(false);
+  }
+
+  /// Apply the subscription state to the remote track, if any, to stop or
+  /// resume decoding and playing it.
+  void ApplySubscriptionToRemoteTrack() noexcept;
+
   //
   // Interop callbacks
   //
@@ -213,7 +291,8 @@ class Transceiver : public TrackedObject {
   void OnAssociated(int mline_index);
 
   /// Callback on local description updated, to check for any change in the
-  /// transceiver direction and update its state.
+  /// transceiver direction and update its state, and to apply the maximum
+  /// audio bitrate to the newly negotiated encoding.
   void OnSessionDescUpdated(bool remote, bool forced = false);
 
   /// Fire the StateUpdated event, invoking the |state_updated_callback_| if
@@ -279,6 +358,10 @@ class Transceiver : public TrackedObject {
 
   Result SetLocalTrackImpl(RefPtr<MediaTrack> local_track) noexcept;
 
+  /// Apply a degradation preference to the RTP sender.
+  Result ApplyDegradationPreference(
+      mrsDegradationPreference preference) noexcept;
+
  protected:
   struct PlanBEmulation;
 
@@ -316,6 +399,14 @@ class Transceiver : public TrackedObject {
   /// Next desired direction, as set by user via |SetDirection()|.
   Direction desired_direction_ = Direction::kInactive;
 
+  /// Whether the application subscribed to the media received by the
+  /// transceiver. See |SetSubscribed()|.
+  std::atomic_bool subscribed_{true};
+
+  /// Whether the remote track was announced to the application by the track
+  /// added callbacks, which are deferred while unsubscribed.
+  std::atomic_bool remote_track_announced_{false};
+
   /// If the owner PeerConnection uses Unified Plan, pointer to the actual
   /// transceiver implementation object. Otherwise NULL for Plan B.
   /// This is also used as a cache of which Plan is in use, to avoid querying
@@ -338,6 +429,27 @@ class Transceiver : public TrackedObject {
   StateUpdatedCallback state_updated_callback_ RTC_GUARDED_BY(cb_mutex_);
 
   std::mutex cb_mutex_;
+
+  /// Apply the maximum bitrate of the audio codec options to the encoding of
+  /// the RTP sender, if already negotiated.
+  Result ApplyAudioMaxBitrate() noexcept;
+
+  /// Codecs preferred for the media line of the transceiver, if any.
+  std::vector<SdpCodecPreference> codec_preferences_
+      RTC_GUARDED_BY(codec_preferences_mutex_);
+
+  /// Opus format parameters overridden by the audio codec options.
+  std::map<std::string, std::string> audio_codec_params_
+      RTC_GUARDED_BY(codec_preferences_mutex_);
+
+  mutable std::mutex codec_preferences_mutex_;
+
+  /// The application set the degradation preference, which the content hint
+  /// of the local track does not override.
+  std::atomic_bool has_degradation_preference_{false};
+
+  /// Maximum bitrate of the audio codec options, or -1 if never set.
+  std::atomic_int audio_max_bitrate_bps_{-1};
 };
 
 }  // namespace WebRTC
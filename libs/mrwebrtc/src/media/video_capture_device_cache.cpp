@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <atomic>
+
+#include "media/video_capture_device_cache.h"
+
+#if defined(WEBRTC_WIN) && !defined(WINUWP)
+#include <cfgmgr32.h>
+#endif
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+#if !defined(WINUWP)
+
+/// Convert a WebRTC VideoType format into its FOURCC counterpart.
+uint32_t FourCCFromVideoType(webrtc::VideoType videoType) {
+  switch (videoType) {
+    default:
+    case webrtc::VideoType::kUnknown:
+      return (uint32_t)libyuv::FOURCC_ANY;
+    case webrtc::VideoType::kI420:
+      return (uint32_t)libyuv::FOURCC_I420;
+    case webrtc::VideoType::kIYUV:
+      return (uint32_t)libyuv::FOURCC_IYUV;
+    case webrtc::VideoType::kRGB24:
+      // this seems unintuitive, but is how defined in the core implementation
+      return (uint32_t)libyuv::FOURCC_24BG;
+    case webrtc::VideoType::kABGR:
+      return (uint32_t)libyuv::FOURCC_ABGR;
+    case webrtc::VideoType::kARGB:
+      return (uint32_t)libyuv::FOURCC_ARGB;
+    case webrtc::VideoType::kARGB4444:
+      return (uint32_t)libyuv::FOURCC_R444;
+    case webrtc::VideoType::kRGB565:
+      return (uint32_t)libyuv::FOURCC_RGBP;
+    case webrtc::VideoType::kARGB1555:
+      return (uint32_t)libyuv::FOURCC_RGBO;
+    case webrtc::VideoType::kYUY2:
+      return (uint32_t)libyuv::FOURCC_YUY2;
+    case webrtc::VideoType::kYV12:
+      return (uint32_t)libyuv::FOURCC_YV12;
+    case webrtc::VideoType::kUYVY:
+      return (uint32_t)libyuv::FOURCC_UYVY;
+    case webrtc::VideoType::kMJPEG:
+      return (uint32_t)libyuv::FOURCC_MJPG;
+    case webrtc::VideoType::kNV21:
+      return (uint32_t)libyuv::FOURCC_NV21;
+    case webrtc::VideoType::kNV12:
+      return (uint32_t)libyuv::FOURCC_NV12;
+    case webrtc::VideoType::kBGRA:
+      return (uint32_t)libyuv::FOURCC_BGRA;
+  };
+}
+
+#endif  // !defined(WINUWP)
+
+#if defined(WEBRTC_WIN) && !defined(WINUWP)
+
+/// KSCATEGORY_CAPTURE, under which DirectShow capture devices register their
+/// interface. Defined here to avoid pulling the kernel streaming headers.
+constexpr GUID kCaptureInterfaceClass = {
+    0x65E8773DL,
+    0x8F56,
+    0x11D0,
+    {0xA3, 0xB9, 0x00, 0xA0, 0xC9, 0x22, 0x31, 0x96}};
+
+DWORD CALLBACK OnDeviceNotification(HCMNOTIFICATION /*notify*/,
+                                    PVOID context,
+                                    CM_NOTIFY_ACTION action,
+                                    PCM_NOTIFY_EVENT_DATA /*event_data*/,
+                                    DWORD /*event_data_size*/) {
+  if ((action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL) ||
+      (action == CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL)) {
+    static_cast<VideoCaptureDeviceCache*>(context)->Invalidate();
+  }
+  return ERROR_SUCCESS;
+}
+
+#endif  // defined(WEBRTC_WIN) && !defined(WINUWP)
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+VideoCaptureDeviceCache& VideoCaptureDeviceCache::Instance() noexcept {
+  // Never destroyed, as the notifications may be delivered until the process
+  // exits.
+  static VideoCaptureDeviceCache* const instance =
+      new VideoCaptureDeviceCache();
+  return *instance;
+}
+
+bool VideoCaptureDeviceCache::GetDevices(
+    std::vector<VideoCaptureDeviceInfo>& devices_out,
+    uint64_t& generation_out) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartWatchingNoLock();
+  generation_out = generation_;
+  if (!has_devices_) {
+    return false;
+  }
+  devices_out = devices_;
+  return true;
+}
+
+void VideoCaptureDeviceCache::SetDevices(
+    std::vector<VideoCaptureDeviceInfo> devices,
+    uint64_t generation) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (notified_ && (generation == generation_)) {
+    devices_ = std::move(devices);
+    has_devices_ = true;
+  }
+}
+
+bool VideoCaptureDeviceCache::GetFormats(
+    const std::string& device_id,
+    std::vector<VideoCaptureFormatInfo>& formats_out,
+    uint64_t& generation_out) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartWatchingNoLock();
+  generation_out = generation_;
+  auto it = formats_.find(device_id);
+  if (it == formats_.end()) {
+    return false;
+  }
+  formats_out = it->second;
+  return true;
+}
+
+void VideoCaptureDeviceCache::SetFormats(
+    const std::string& device_id,
+    std::vector<VideoCaptureFormatInfo> formats,
+    uint64_t generation) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (notified_ && (generation == generation_)) {
+    formats_[device_id] = std::move(formats);
+  }
+}
+
+#if !defined(WINUWP)
+
+Result VideoCaptureDeviceCache::GetOrEnumerateDevices(
+    std::vector<VideoCaptureDeviceInfo>& devices_out) noexcept {
+  uint64_t generation;
+  if (GetDevices(devices_out, generation)) {
+    return Result::kSuccess;
+  }
+  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
+      webrtc::VideoCaptureFactory::CreateDeviceInfo());
+  if (!info) {
+    RTC_LOG(LS_ERROR) << "Failed to start video capture devices enumeration.";
+    return Result::kUnknownError;
+  }
+  devices_out.clear();
+  const int num_devices = info->NumberOfDevices();
+  for (int i = 0; i < num_devices; ++i) {
+    constexpr uint32_t kSize = 256;
+    char name[kSize] = {0};
+    char id[kSize] = {0};
+    if (info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
+      devices_out.push_back({id, name});
+    }
+  }
+  SetDevices(devices_out, generation);
+  return Result::kSuccess;
+}
+
+Result VideoCaptureDeviceCache::GetOrEnumerateFormats(
+    const std::string& device_id,
+    std::vector<VideoCaptureFormatInfo>& formats_out) noexcept {
+  uint64_t generation;
+  if (GetFormats(device_id, formats_out, generation)) {
+    return Result::kSuccess;
+  }
+  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
+      webrtc::VideoCaptureFactory::CreateDeviceInfo());
+  if (!info) {
+    return Result::kUnknownError;
+  }
+  formats_out.clear();
+  const int32_t num_capabilities =
+      info->NumberOfCapabilities(device_id.c_str());
+  for (int32_t cap_idx = 0; cap_idx < num_capabilities; ++cap_idx) {
+    webrtc::VideoCaptureCapability capability{};
+    if (info->GetCapability(device_id.c_str(), cap_idx, capability) != -1) {
+      const uint32_t fourcc = FourCCFromVideoType(capability.videoType);
+      if (fourcc != libyuv::FOURCC_ANY) {
+        formats_out.push_back({(uint32_t)capability.width,
+                               (uint32_t)capability.height,
+                               (double)capability.maxFPS, fourcc});
+      }
+    }
+  }
+  SetFormats(device_id, formats_out, generation);
+  return Result::kSuccess;
+}
+
+#endif  // !defined(WINUWP)
+
+void VideoCaptureDeviceCache::Invalidate() noexcept {
+  DevicesChangedCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    has_devices_ = false;
+    devices_.clear();
+    formats_.clear();
+    callback = devices_changed_callback_;
+  }
+  RTC_LOG(LS_INFO) << "Video capture devices changed.";
+  if (callback) {
+    callback();
+  }
+}
+
+void VideoCaptureDeviceCache::SetDevicesChangedCallback(
+    DevicesChangedCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  devices_changed_callback_ = callback;
+  StartWatchingNoLock();
+}
+
+void VideoCaptureDeviceCache::StartWatchingNoLock() noexcept {
+  if (watching_) {
+    return;
+  }
+  watching_ = true;
+#if defined(WINUWP)
+  try {
+    // Keep the watcher alive with the cache, which is never destroyed.
+    static winrt::Windows::Devices::Enumeration::DeviceWatcher watcher =
+        winrt::Windows::Devices::Enumeration::DeviceInformation::CreateWatcher(
+            winrt::Windows::Devices::Enumeration::DeviceClass::VideoCapture);
+    // The watcher first reports all the existing devices as added, which are
+    // already enumerated by the cache.
+    static std::atomic_bool enumerated{false};
+    watcher.Added([this](auto&&, auto&&) {
+      if (enumerated.load(std::memory_order_acquire)) {
+        Invalidate();
+      }
+    });
+    watcher.Removed([this](auto&&, auto&&) { Invalidate(); });
+    watcher.EnumerationCompleted([](auto&&, auto&&) {
+      enumerated.store(true, std::memory_order_release);
+    });
+    watcher.Start();
+    notified_ = true;
+  } catch (...) {
+    RTC_LOG(LS_WARNING) << "Failed to watch video capture devices, which will "
+                           "not be cached.";
+  }
+#elif defined(WEBRTC_WIN)
+  CM_NOTIFY_FILTER filter{};
+  filter.cbSize = sizeof(filter);
+  filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+  filter.u.DeviceInterface.ClassGuid = kCaptureInterfaceClass;
+  // Never unregistered, like the cache is never destroyed.
+  HCMNOTIFICATION notification{};
+  if (CM_Register_Notification(&filter, this, &OnDeviceNotification,
+                               &notification) == CR_SUCCESS) {
+    notified_ = true;
+  } else {
+    RTC_LOG(LS_WARNING) << "Failed to watch video capture devices, which will "
+                           "not be cached.";
+  }
+#endif
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
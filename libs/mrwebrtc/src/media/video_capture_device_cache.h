@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "callback.h"
+#include "result.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Video capture device, as enumerated by the operating system.
+struct VideoCaptureDeviceInfo {
+  std::string id;
+  std::string name;
+};
+
+/// Capture format of a video capture device.
+struct VideoCaptureFormatInfo {
+  uint32_t width;
+  uint32_t height;
+  double framerate;
+  uint32_t fourcc;
+};
+
+/// Process-wide cache of the video capture devices and of their capture
+/// formats, which are slow to enumerate. The cache is invalidated when the
+/// operating system reports a video capture device added or removed, which is
+/// watched from the first use of the cache. On platforms where the devices
+/// cannot be watched, nothing is cached. This is multithread-safe.
+class VideoCaptureDeviceCache {
+ public:
+  using DevicesChangedCallback = Callback<>;
+
+  static VideoCaptureDeviceCache& Instance() noexcept;
+
+  /// Get the cached devices. If not cached, return |false| and the generation
+  /// of the cache to pass to |SetDevices()| once enumerated.
+  bool GetDevices(std::vector<VideoCaptureDeviceInfo>& devices_out,
+                  uint64_t& generation_out) noexcept;
+
+  /// Cache the devices enumerated since |GetDevices()| returned |generation|,
+  /// unless the cache was invalidated in the meantime.
+  void SetDevices(std::vector<VideoCaptureDeviceInfo> devices,
+                  uint64_t generation) noexcept;
+
+  /// Get the cached capture formats of a device, like |GetDevices()|.
+  bool GetFormats(const std::string& device_id,
+                  std::vector<VideoCaptureFormatInfo>& formats_out,
+                  uint64_t& generation_out) noexcept;
+
+  /// Cache the capture formats of a device, like |SetDevices()|.
+  void SetFormats(const std::string& device_id,
+                  std::vector<VideoCaptureFormatInfo> formats,
+                  uint64_t generation) noexcept;
+
+#if !defined(WINUWP)
+  /// Get the cached devices, or enumerate them synchronously if not cached.
+  Result GetOrEnumerateDevices(
+      std::vector<VideoCaptureDeviceInfo>& devices_out) noexcept;
+
+  /// Get the cached capture formats of a device, or enumerate them
+  /// synchronously if not cached.
+  Result GetOrEnumerateFormats(
+      const std::string& device_id,
+      std::vector<VideoCaptureFormatInfo>& formats_out) noexcept;
+#endif  // !defined(WINUWP)
+
+  /// Drop the cached devices and formats, and invoke the devices changed
+  /// callback if any.
+  void Invalidate() noexcept;
+
+  /// Set the callback invoked when the devices change, on a background thread
+  /// of the operating system. This starts watching the devices.
+  void SetDevicesChangedCallback(DevicesChangedCallback callback) noexcept;
+
+ private:
+  VideoCaptureDeviceCache() = default;
+
+  /// Start watching the operating system for device changes, once.
+  void StartWatchingNoLock() noexcept;
+
+  std::mutex mutex_;
+
+  /// Incremented on each invalidation, to discard the enumerations which
+  /// started before it.
+  uint64_t generation_{0};
+
+  bool has_devices_{false};
+
+  /// Watching was attempted, and succeeded if |notified_|.
+  bool watching_{false};
+  bool notified_{false};
+
+  std::vector<VideoCaptureDeviceInfo> devices_;
+  std::unordered_map<std::string, std::vector<VideoCaptureFormatInfo>>
+      formats_;
+  DevicesChangedCallback devices_changed_callback_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -3,9 +3,29 @@
 
 #include "pch.h"
 
+#include "rtc_base/keep_ref_until_done.h"
+
+#include "frame_metadata.h"
 #include "interop/global_factory.h"
 #include "media/video_track_source.h"
 
+namespace {
+
+/// Handler running a task posted to a thread once, then deleting itself.
+class PostedTask : public rtc::MessageHandler {
+ public:
+  explicit PostedTask(std::function<void()> task) : task_(std::move(task)) {}
+  void OnMessage(rtc::Message* /*msg*/) override {
+    task_();
+    delete this;
+  }
+
+ private:
+  std::function<void()> task_;
+};
+
+}  // namespace
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -35,6 +55,143 @@ void VideoSourceAdapter::UnregisterObserver(
 //  }
 //}
 
+FrameHeightRoundingAdapter::FrameHeightRoundingAdapter(
+    rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> source,
+    FrameHeightRoundMode mode) noexcept
+    : source_(std::move(source)), mode_(mode) {}
+
+FrameHeightRoundingAdapter::~FrameHeightRoundingAdapter() {
+  source_->RemoveSink(this);
+}
+
+void FrameHeightRoundingAdapter::AddOrUpdateSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+    const rtc::VideoSinkWants& wants) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  broadcaster_.AddOrUpdateSink(sink, wants);
+  source_->AddOrUpdateSink(this, broadcaster_.wants());
+}
+
+void FrameHeightRoundingAdapter::RemoveSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  broadcaster_.RemoveSink(sink);
+  if (broadcaster_.frame_wanted()) {
+    source_->AddOrUpdateSink(this, broadcaster_.wants());
+  } else {
+    // Let the source know when no sink consumes its frames anymore.
+    source_->RemoveSink(this);
+  }
+}
+
+void FrameHeightRoundingAdapter::OnFrame(const webrtc::VideoFrame& frame) {
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer =
+      frame.video_frame_buffer();
+  const int height = buffer->height();
+  if ((mode_ == FrameHeightRoundMode::kNone) || ((height % 16) == 0) ||
+      (buffer->type() == webrtc::VideoFrameBuffer::Type::kNative)) {
+    broadcaster_.OnFrame(frame);
+    return;
+  }
+  // Offsets are kept even, for the chroma rows to start at a whole row.
+  if (mode_ == FrameHeightRoundMode::kCrop) {
+    const int rounded_height = (height & ~15);
+    if (rounded_height == 0) {
+      broadcaster_.OnFrame(frame);
+      return;
+    }
+    const int top = ((height - rounded_height) / 2) & ~1;
+    buffer = Crop(std::move(buffer), top, rounded_height);
+  } else {
+    const int rounded_height = ((height + 15) & ~15);
+    const int top = ((rounded_height - height) / 2) & ~1;
+    buffer = Pad(*buffer->ToI420(), top, rounded_height);
+  }
+  webrtc::VideoFrame rounded_frame{webrtc::VideoFrame::Builder()
+                                       .set_video_frame_buffer(buffer)
+                                       .set_timestamp_rtp(frame.timestamp())
+                                       .set_timestamp_us(frame.timestamp_us())
+                                       .set_rotation(frame.rotation())
+                                       .build()};
+  rounded_frame.set_ntp_time_ms(frame.ntp_time_ms());
+  // The metadata of the frame is found from its buffer, which changed.
+  if (FrameMetadata metadata = FindFrameMetadata(frame)) {
+    AttachFrameMetadata(rounded_frame, std::move(metadata));
+  }
+  const webrtc::PlayoutDelay delay = FindFramePlayoutDelay(frame);
+  if ((delay.min_ms >= 0) || (delay.max_ms >= 0)) {
+    SetFramePlayoutDelay(rounded_frame, delay);
+  }
+  broadcaster_.OnFrame(rounded_frame);
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> FrameHeightRoundingAdapter::Crop(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    int top,
+    int height) noexcept {
+  const int chroma_top = top / 2;
+  if (buffer->type() == webrtc::VideoFrameBuffer::Type::kI420A) {
+    const webrtc::I420ABufferInterface* const src = buffer->GetI420A();
+    return webrtc::WrapI420ABuffer(
+        src->width(), height, src->DataY() + top * src->StrideY(),
+        src->StrideY(), src->DataU() + chroma_top * src->StrideU(),
+        src->StrideU(), src->DataV() + chroma_top * src->StrideV(),
+        src->StrideV(), src->DataA() + top * src->StrideA(), src->StrideA(),
+        rtc::KeepRefUntilDone(buffer));
+  }
+  // Other formats are converted first, like the encoders would.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> src = buffer->ToI420();
+  const int width = src->width();
+  const uint8_t* const y = src->DataY() + top * src->StrideY();
+  const uint8_t* const u = src->DataU() + chroma_top * src->StrideU();
+  const uint8_t* const v = src->DataV() + chroma_top * src->StrideV();
+  const int stride_y = src->StrideY();
+  const int stride_u = src->StrideU();
+  const int stride_v = src->StrideV();
+  return webrtc::WrapI420Buffer(width, height, y, stride_y, u, stride_u, v,
+                                stride_v, rtc::KeepRefUntilDone(src));
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> FrameHeightRoundingAdapter::Pad(
+    const webrtc::I420BufferInterface& buffer,
+    int top,
+    int height) noexcept {
+  const int width = buffer.width();
+  const int src_height = buffer.height();
+  rtc::scoped_refptr<webrtc::I420Buffer> dst =
+      pool_.CreateBuffer(width, height);
+  const int chroma_top = top / 2;
+  libyuv::I420Copy(buffer.DataY(), buffer.StrideY(), buffer.DataU(),
+                   buffer.StrideU(), buffer.DataV(), buffer.StrideV(),
+                   dst->MutableDataY() + top * dst->StrideY(), dst->StrideY(),
+                   dst->MutableDataU() + chroma_top * dst->StrideU(),
+                   dst->StrideU(),
+                   dst->MutableDataV() + chroma_top * dst->StrideV(),
+                   dst->StrideV(), width, src_height);
+  // Replicate the edge rows, which costs fewer bits to encode than a flat
+  // border.
+  auto fill_plane = [](uint8_t* data, int stride, int row_size, int top,
+                       int rows, int total_rows) {
+    for (int row = 0; row < top; ++row) {
+      memcpy(data + row * stride, data + top * stride, row_size);
+    }
+    const uint8_t* const last = data + (top + rows - 1) * stride;
+    for (int row = top + rows; row < total_rows; ++row) {
+      memcpy(data + row * stride, last, row_size);
+    }
+  };
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_rows = (src_height + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  fill_plane(dst->MutableDataY(), dst->StrideY(), width, top, src_height,
+             height);
+  fill_plane(dst->MutableDataU(), dst->StrideU(), chroma_width, chroma_top,
+             chroma_rows, chroma_height);
+  fill_plane(dst->MutableDataV(), dst->StrideV(), chroma_width, chroma_top,
+             chroma_rows, chroma_height);
+  return dst;
+}
+
 VideoTrackSource::VideoTrackSource(
     RefPtr<GlobalFactory> global_factory,
     ObjectType video_track_source_type,
@@ -42,79 +199,180 @@ VideoTrackSource::VideoTrackSource(
     : TrackedObject(std::move(global_factory), video_track_source_type),
       source_(std::move(source)) {
   RTC_CHECK(source_);
-  RTC_CHECK((video_track_source_type == ObjectType::kDeviceVideoTrackSource) ||
-            (video_track_source_type == ObjectType::kExternalVideoTrackSource));
+  RTC_CHECK(
+      (video_track_source_type == ObjectType::kDeviceVideoTrackSource) ||
+      (video_track_source_type == ObjectType::kExternalVideoTrackSource) ||
+      (video_track_source_type == ObjectType::kRelayVideoTrackSource) ||
+      (video_track_source_type ==
+       ObjectType::kExternalEncodedVideoTrackSource));
 }
 
 VideoTrackSource::~VideoTrackSource() {
   if (observer_) {
-    // Track sources need to be manipulated from the worker thread
-    rtc::Thread* const worker_thread =
-        GlobalFactory::InstancePtr()->GetWorkerThread();
-    worker_thread->Invoke<void>(
-        RTC_FROM_HERE, [&]() { source_->RemoveSink(observer_.get()); });
+    // Wait for the removal, and any pending update, before the source and the
+    // callbacks of the observer may be destroyed.
+    UpdateSink(std::move(observer_), /* add = */ false, /* async = */ false);
   }
 }
 
-void VideoTrackSource::SetCallback(I420AFrameReadyCallback callback) noexcept {
+void VideoTrackSource::SetAsyncSinkUpdates(
+    bool enabled,
+    SinkUpdatedCallback callback) noexcept {
   std::lock_guard<std::mutex> lock(observer_mutex_);
-  if (callback) {
-    // When assigning a new callback, create and register an observer.
-    if (!observer_) {
-      observer_ = std::make_unique<VideoFrameObserver>();
-      // Track sources need to be manipulated from the worker thread
-      rtc::Thread* const worker_thread =
-          GlobalFactory::InstancePtr()->GetWorkerThread();
-      worker_thread->Invoke<void>(RTC_FROM_HERE, [&]() {
-        rtc::VideoSinkWants sink_settings{};
-        sink_settings.rotation_applied = true;
-        source_->AddOrUpdateSink(observer_.get(), sink_settings);
-      });
+  async_sink_updates_ = enabled;
+  sink_updated_callback_ = callback;
+}
+
+void VideoTrackSource::UpdateSink(std::shared_ptr<VideoFrameObserver> observer,
+                                  bool add,
+                                  bool async) noexcept {
+  SinkUpdatedCallback callback = (async ? sink_updated_callback_
+                                        : SinkUpdatedCallback{});
+  std::function<void()> task = [source = source_,
+                                observer = std::move(observer), add,
+                                callback]() {
+    if (add) {
+      rtc::VideoSinkWants sink_settings{};
+      // Let the frame observer apply the rotation, if requested, rather
+      // than have the source rotate the pixels of every frame.
+      sink_settings.rotation_applied = false;
+      source->AddOrUpdateSink(observer.get(), sink_settings);
+    } else {
+      source->RemoveSink(observer.get());
     }
-    observer_->SetCallback(callback);
+    callback();
+  };
+
+  // Track sources need to be manipulated from the worker thread
+  rtc::Thread* const worker_thread =
+      GlobalFactory::InstancePtr()->GetWorkerThread();
+  if (worker_thread->IsCurrent()) {
+    task();
+  } else if (async) {
+    worker_thread->Post(RTC_FROM_HERE, new PostedTask(std::move(task)));
   } else {
-    // When clearing the existing callback, unregister and destroy the observer.
-    // This ensures the native source knows when there is no more observer, and
-    // can potentially optimize its behavior.
-    if (observer_) {
-      // Track sources need to be manipulated from the worker thread
-      rtc::Thread* const worker_thread =
-          GlobalFactory::InstancePtr()->GetWorkerThread();
-      worker_thread->Invoke<void>(
-          RTC_FROM_HERE, [&]() { source_->RemoveSink(observer_.get()); });
-      observer_.reset();
-    }
+    rtc::Event done(false, false);
+    worker_thread->Post(RTC_FROM_HERE, new PostedTask([&task, &done]() {
+                          task();
+                          done.Set();
+                        }));
+    done.Wait(rtc::Event::kForever);
   }
 }
 
-void VideoTrackSource::SetCallback(Argb32FrameReadyCallback callback) noexcept {
+void VideoTrackSource::EnsureObserver() noexcept {
+  if (observer_) {
+    return;
+  }
+  observer_ = std::make_shared<VideoFrameObserver>();
+  observer_->SetArgbBufferPoolSize(argb_buffer_pool_size_);
+  observer_->SetDeliveryOptions(delivery_options_);
+  UpdateSink(observer_, /* add = */ true, async_sink_updates_);
+}
+
+void VideoTrackSource::ReleaseObserverIfUnused() noexcept {
+  if (!observer_ || observer_->HasCallbacks()) {
+    return;
+  }
+  UpdateSink(std::move(observer_), /* add = */ false, async_sink_updates_);
+  observer_ = nullptr;
+}
+
+template <typename FrameCallback>
+void VideoTrackSource::SetCallbackImpl(FrameCallback callback) noexcept {
   std::lock_guard<std::mutex> lock(observer_mutex_);
   if (callback) {
     // When assigning a new callback, create and register an observer.
-    if (!observer_) {
-      observer_ = std::make_unique<VideoFrameObserver>();
-      // Track sources need to be manipulated from the worker thread
-      rtc::Thread* const worker_thread =
-          GlobalFactory::InstancePtr()->GetWorkerThread();
-      worker_thread->Invoke<void>(RTC_FROM_HERE, [&]() {
-        rtc::VideoSinkWants sink_settings{};
-        sink_settings.rotation_applied = true;
-        source_->AddOrUpdateSink(observer_.get(), sink_settings);
-      });
-    }
+    EnsureObserver();
     observer_->SetCallback(callback);
-  } else {
-    // When clearing the existing callback, unregister and destroy the observer.
-    // This ensures the native source knows when there is no more observer, and
-    // can potentially optimize its behavior.
-    if (observer_) {
-      // Track sources need to be manipulated from the worker thread
-      rtc::Thread* const worker_thread =
-          GlobalFactory::InstancePtr()->GetWorkerThread();
-      worker_thread->Invoke<void>(
-          RTC_FROM_HERE, [&]() { source_->RemoveSink(observer_.get()); });
-      observer_.reset();
-    }
+  } else if (observer_) {
+    // When clearing the existing callback, unregister and destroy the observer
+    // if that was the last one.
+    observer_->SetCallback(callback);
+    ReleaseObserverIfUnused();
+  }
+}
+
+template <typename FrameCallback>
+FrameSubscriberId VideoTrackSource::AddSubscriberImpl(
+    FrameCallback callback) noexcept {
+  if (!callback) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(observer_mutex_);
+  EnsureObserver();
+  return observer_->AddSubscriber(std::move(callback));
+}
+
+void VideoTrackSource::SetCallback(I420AFrameReadyCallback callback) noexcept {
+  SetCallbackImpl(std::move(callback));
+}
+
+void VideoTrackSource::SetCallback(Argb32FrameReadyCallback callback) noexcept {
+  SetCallbackImpl(std::move(callback));
+}
+
+void VideoTrackSource::SetCallback(Nv12FrameReadyCallback callback) noexcept {
+  SetCallbackImpl(std::move(callback));
+}
+
+void VideoTrackSource::SetCallback(VideoFrameLeaseCallback callback) noexcept {
+  SetCallbackImpl(std::move(callback));
+}
+
+void VideoTrackSource::SetCallback(Argb32FrameLeaseCallback callback) noexcept {
+  SetCallbackImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoTrackSource::AddSubscriber(
+    I420AFrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoTrackSource::AddSubscriber(
+    Argb32FrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoTrackSource::AddSubscriber(
+    Nv12FrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoTrackSource::AddSubscriber(
+    VideoFrameLeaseCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoTrackSource::AddSubscriber(
+    Argb32FrameLeaseCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+bool VideoTrackSource::RemoveSubscriber(FrameSubscriberId id) noexcept {
+  std::lock_guard<std::mutex> lock(observer_mutex_);
+  if (!observer_) {
+    return false;
+  }
+  const bool removed = observer_->RemoveSubscriber(id);
+  ReleaseObserverIfUnused();
+  return removed;
+}
+
+void VideoTrackSource::SetArgbBufferPoolSize(int pool_size) noexcept {
+  std::lock_guard<std::mutex> lock(observer_mutex_);
+  argb_buffer_pool_size_ = pool_size;
+  if (observer_) {
+    observer_->SetArgbBufferPoolSize(pool_size);
+  }
+}
+
+void VideoTrackSource::SetDeliveryOptions(
+    const VideoFrameDeliveryOptions& options) noexcept {
+  std::lock_guard<std::mutex> lock(observer_mutex_);
+  delivery_options_ = options;
+  if (observer_) {
+    observer_->SetDeliveryOptions(options);
   }
 }
 
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "interop_api.h"
+#include "media/frame_buffer_pool.h"
 #include "mrs_errors.h"
 #include "refptr.h"
 #include "tracked_object.h"
@@ -11,6 +13,7 @@
 #include "video_track_source_interop.h"
 
 #include "api/mediastreaminterface.h"
+#include "media/base/videobroadcaster.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -63,6 +66,87 @@ class VideoSourceAdapter : public webrtc::VideoTrackSourceInterface {
   webrtc::ObserverInterface* observer_{nullptr};
 };
 
+/// Adapter between a local video source and the tracks created with a frame
+/// height round mode, rounding the height of the frames of the source to a
+/// multiple of 16 pixels before they reach the encoders, whatever the encoder
+/// factory. Cropping only offsets the planes of the frames, without copying
+/// them, while padding copies them into pooled buffers, replicating their edge
+/// rows. Frames in native buffers are forwarded unchanged.
+class FrameHeightRoundingAdapter
+    : public webrtc::VideoTrackSourceInterface,
+      public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  FrameHeightRoundingAdapter(
+      rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> source,
+      FrameHeightRoundMode mode) noexcept;
+  ~FrameHeightRoundingAdapter() override;
+
+  //
+  // NotifierInterface
+  //
+
+  void RegisterObserver(webrtc::ObserverInterface* observer) override {
+    source_->RegisterObserver(observer);
+  }
+  void UnregisterObserver(webrtc::ObserverInterface* observer) override {
+    source_->UnregisterObserver(observer);
+  }
+
+  //
+  // MediaSourceInterface
+  //
+
+  SourceState state() const override { return source_->state(); }
+  bool remote() const override { return source_->remote(); }
+
+  //
+  // VideoTrackSourceInterface
+  //
+
+  bool is_screencast() const override { return source_->is_screencast(); }
+  absl::optional<bool> needs_denoising() const override {
+    return source_->needs_denoising();
+  }
+  bool GetStats(Stats* stats) override { return source_->GetStats(stats); }
+  void AddOrUpdateSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+                       const rtc::VideoSinkWants& wants) override;
+  void RemoveSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) override;
+
+  //
+  // VideoSinkInterface
+  //
+
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+  void OnDiscardedFrame() override { broadcaster_.OnDiscardedFrame(); }
+
+ private:
+  /// Crop a buffer to |height| rows, starting at row |top|, without copy.
+  static rtc::scoped_refptr<webrtc::VideoFrameBuffer> Crop(
+      rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+      int top,
+      int height) noexcept;
+
+  /// Copy a buffer into a pooled buffer of |height| rows, starting at row
+  /// |top|, and fill the rows around it with its edge rows.
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> Pad(
+      const webrtc::I420BufferInterface& buffer,
+      int top,
+      int height) noexcept;
+
+  const rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> source_;
+  const FrameHeightRoundMode mode_;
+  rtc::VideoBroadcaster broadcaster_;
+  FrameBufferPool pool_;
+
+  /// Serializes the sink updates, which update the wants of this adapter on
+  /// the source from those of all the sinks.
+  std::mutex sink_mutex_;
+};
+
+/// Callback fired once the frame sink of a video track source was updated
+/// asynchronously.
+using SinkUpdatedCallback = Callback<>;
+
 /// Base class for a video track source acting as a frame source for one or more
 /// video tracks.
 class VideoTrackSource : public TrackedObject {
@@ -75,6 +159,34 @@ class VideoTrackSource : public TrackedObject {
 
   void SetCallback(I420AFrameReadyCallback callback) noexcept;
   void SetCallback(Argb32FrameReadyCallback callback) noexcept;
+  void SetCallback(Nv12FrameReadyCallback callback) noexcept;
+  void SetCallback(VideoFrameLeaseCallback callback) noexcept;
+  void SetCallback(Argb32FrameLeaseCallback callback) noexcept;
+
+  /// Add a frame subscriber to the frame observer. See
+  /// |VideoFrameObserver::AddSubscriber()|.
+  FrameSubscriberId AddSubscriber(I420AFrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Argb32FrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Nv12FrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(VideoFrameLeaseCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Argb32FrameLeaseCallback callback) noexcept;
+
+  /// Remove a frame subscriber previously added with |AddSubscriber()|.
+  bool RemoveSubscriber(FrameSubscriberId id) noexcept;
+
+  /// Set the number of pooled ARGB32 buffers of the frame observer. See
+  /// |VideoFrameObserver::SetArgbBufferPoolSize()|.
+  void SetArgbBufferPoolSize(int pool_size) noexcept;
+
+  /// Set the options for the delivery of converted frames of the frame
+  /// observer. See |VideoFrameObserver::SetDeliveryOptions()|.
+  void SetDeliveryOptions(const VideoFrameDeliveryOptions& options) noexcept;
+
+  /// Enable or disable asynchronous sink updates. When enabled, registering
+  /// the first frame callback or subscriber, or removing the last one, posts
+  /// the change of the sink of the native source to the worker thread instead
+  /// of waiting for it, and invokes |callback| on the worker thread once done.
+  void SetAsyncSinkUpdates(bool enabled, SinkUpdatedCallback callback) noexcept;
 
   inline rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> impl() const
       noexcept {
@@ -83,8 +195,52 @@ class VideoTrackSource : public TrackedObject {
 
  protected:
   rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> source_;
-  std::unique_ptr<VideoFrameObserver> observer_;
+  /// Observer registered as the sink of the native source. This is shared with
+  /// the pending sink updates, to outlive its registration.
+  std::shared_ptr<VideoFrameObserver> observer_;
   std::mutex observer_mutex_;
+
+  /// Number of pooled ARGB32 buffers to apply to |observer_| on creation.
+  int argb_buffer_pool_size_ = 1;
+
+  /// Options for the delivery of converted frames to apply to |observer_| on
+  /// creation.
+  VideoFrameDeliveryOptions delivery_options_{};
+
+  /// Post the sink updates to the worker thread without waiting for them, and
+  /// invoke |sink_updated_callback_| once each update is done.
+  bool async_sink_updates_{false};
+  SinkUpdatedCallback sink_updated_callback_;
+
+ private:
+  /// Add or remove an observer as sink of the native source on the worker
+  /// thread, and wait for the update unless |async| is true. The updates are
+  /// always posted, even synchronous ones, so that they apply in order. The
+  /// caller must hold |observer_mutex_|, unless destroying the source.
+  void UpdateSink(std::shared_ptr<VideoFrameObserver> observer,
+                  bool add,
+                  bool async) noexcept;
+
+  /// Create and register the observer if not already done. The caller must
+  /// hold |observer_mutex_|.
+  void EnsureObserver() noexcept;
+
+  /// Unregister and destroy the observer if it has no callback and no
+  /// subscriber anymore. This ensures the native source knows when there is
+  /// no more observer, and can potentially optimize its behavior. The caller
+  /// must hold |observer_mutex_|.
+  void ReleaseObserverIfUnused() noexcept;
+
+  /// Assign a frame callback of any type to the observer, creating and
+  /// registering the observer as needed, or destroying it when the last
+  /// callback is cleared.
+  template <typename FrameCallback>
+  void SetCallbackImpl(FrameCallback callback) noexcept;
+
+  /// Add a frame subscriber of any type to the observer, creating and
+  /// registering the observer as needed.
+  template <typename FrameCallback>
+  FrameSubscriberId AddSubscriberImpl(FrameCallback callback) noexcept;
 };
 
 }  // namespace WebRTC
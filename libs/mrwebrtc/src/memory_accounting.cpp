@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <atomic>
+
+#include "memory_accounting.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+struct CategoryCounters {
+  std::atomic<uint64_t> current_bytes_{0};
+  std::atomic<uint64_t> peak_bytes_{0};
+};
+
+CategoryCounters g_categories[kMemoryCategoryCount];
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void MemoryAccounting::Add(MemoryCategory category, size_t bytes) noexcept {
+  CategoryCounters& counters = g_categories[(int)category];
+  const uint64_t current =
+      counters.current_bytes_.fetch_add(bytes, std::memory_order_relaxed) +
+      bytes;
+  uint64_t peak = counters.peak_bytes_.load(std::memory_order_relaxed);
+  while ((current > peak) &&
+         !counters.peak_bytes_.compare_exchange_weak(
+             peak, current, std::memory_order_relaxed)) {
+  }
+}
+
+void MemoryAccounting::Remove(MemoryCategory category, size_t bytes) noexcept {
+  CategoryCounters& counters = g_categories[(int)category];
+  counters.current_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryUsage MemoryAccounting::GetUsage(MemoryCategory category) noexcept {
+  const CategoryCounters& counters = g_categories[(int)category];
+  MemoryUsage usage;
+  usage.current_bytes_ = counters.current_bytes_.load(std::memory_order_relaxed);
+  usage.peak_bytes_ = counters.peak_bytes_.load(std::memory_order_relaxed);
+  return usage;
+}
+
+void MemoryAccounting::ResetPeaks() noexcept {
+  for (CategoryCounters& counters : g_categories) {
+    counters.peak_bytes_.store(
+        counters.current_bytes_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+}
+
+void MemoryCharge::Set(size_t bytes) noexcept {
+  if (bytes > bytes_) {
+    MemoryAccounting::Add(category_, bytes - bytes_);
+  } else if (bytes < bytes_) {
+    MemoryAccounting::Remove(category_, bytes_ - bytes);
+  }
+  bytes_ = bytes;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
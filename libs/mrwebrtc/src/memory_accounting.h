@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Category of native memory accounted by |MemoryAccounting|.
+enum class MemoryCategory : int {
+  /// Video frames queued for the application, not yet consumed.
+  kFrameBuffers,
+  /// Scratch buffers used for converting and scaling video frames.
+  kScratchBuffers,
+  /// Buffers of the audio samples of remote tracks read by the application.
+  kAudioReadBuffers,
+  /// Messages queued for sending or receiving on data channels.
+  kDataChannelQueues,
+  /// Video frame buffers kept in pools for reuse.
+  kBufferPools,
+};
+
+constexpr int kMemoryCategoryCount = (int)MemoryCategory::kBufferPools + 1;
+
+/// Amount of memory held in a category.
+struct MemoryUsage {
+  /// Number of bytes currently held.
+  uint64_t current_bytes_ = 0;
+
+  /// Maximum number of bytes simultaneously held since the last call to
+  /// |MemoryAccounting::ResetPeaks()|, or since the process started.
+  uint64_t peak_bytes_ = 0;
+};
+
+/// Process-wide accounting of the long-lived native buffers allocated by the
+/// library, by category. This only tracks the buffers the library allocates
+/// itself, not the memory held by the WebRTC implementation. All functions are
+/// lock-free and multithread-safe.
+class MemoryAccounting {
+ public:
+  /// Account for |bytes| more bytes held in |category|.
+  static void Add(MemoryCategory category, size_t bytes) noexcept;
+
+  /// Account for |bytes| less bytes held in |category|.
+  static void Remove(MemoryCategory category, size_t bytes) noexcept;
+
+  /// Get the amount of memory held in |category|.
+  static MemoryUsage GetUsage(MemoryCategory category) noexcept;
+
+  /// Reset the peak of all categories to their current amount.
+  static void ResetPeaks() noexcept;
+};
+
+/// Memory held by a single owner in a category, which follows the size of a
+/// buffer of that owner and releases it on destruction. This is not
+/// multithread-safe; the owner must serialize calls to |Set()|.
+class MemoryCharge {
+ public:
+  explicit MemoryCharge(MemoryCategory category) noexcept
+      : category_(category) {}
+  ~MemoryCharge() noexcept { Set(0); }
+
+  MemoryCharge(const MemoryCharge&) = delete;
+  MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+  /// Set the number of bytes currently held by the owner.
+  void Set(size_t bytes) noexcept;
+
+  size_t bytes() const noexcept { return bytes_; }
+
+ private:
+  const MemoryCategory category_;
+  size_t bytes_ = 0;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "message_ring.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+MessageRing::MessageRing(size_t capacity,
+                         size_t max_messages,
+                         OverflowPolicy policy) noexcept
+    : policy_(policy), data_(capacity), entries_(max_messages) {
+  RTC_DCHECK_GT(max_messages, 0u);
+  memory_charge_.Set(data_.size() + entries_.size() * sizeof(Entry));
+}
+
+bool MessageRing::Allocate(size_t size, size_t* offset) const noexcept {
+  if (count_ == entries_.size()) {
+    return false;
+  }
+  if (count_ == 0) {
+    *offset = 0;
+    return (size <= data_.size());
+  }
+  const size_t read_offset = entries_[front_].offset;
+  // Equal offsets are either a full ring, or only empty messages
+  if ((write_offset_ > read_offset) ||
+      ((write_offset_ == read_offset) && (stored_bytes_ == 0))) {
+    // Free space at the end, and at the start before the oldest message
+    if (size <= data_.size() - write_offset_) {
+      *offset = write_offset_;
+      return true;
+    }
+    *offset = 0;
+    return (size <= read_offset);
+  }
+  // Already wrapped around; the free space is before the oldest message
+  *offset = write_offset_;
+  return (size <= read_offset - write_offset_);
+}
+
+void MessageRing::DropFront() noexcept {
+  stored_bytes_ -= entries_[front_].size;
+  front_ = (front_ + 1) % entries_.size();
+  --count_;
+  ++dropped_count_;
+}
+
+bool MessageRing::Push(const void* data, size_t size) noexcept {
+  size_t offset;
+  while (!Allocate(size, &offset)) {
+    if ((policy_ == OverflowPolicy::kDropNewest) || (count_ == 0)) {
+      ++dropped_count_;
+      return false;
+    }
+    DropFront();
+  }
+  if (size > 0) {
+    memcpy(data_.data() + offset, data, size);
+  }
+  entries_[(front_ + count_) % entries_.size()] = Entry{offset, size};
+  ++count_;
+  stored_bytes_ += size;
+  write_offset_ = offset + size;
+  return true;
+}
+
+void MessageRing::PopFront(void* dst) noexcept {
+  RTC_DCHECK(!empty());
+  const Entry& entry = entries_[front_];
+  if (entry.size > 0) {
+    memcpy(dst, data_.data() + entry.offset, entry.size);
+  }
+  stored_bytes_ -= entry.size;
+  front_ = (front_ + 1) % entries_.size();
+  --count_;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
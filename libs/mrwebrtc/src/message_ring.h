@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "memory_accounting.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Bounded queue of variable-size messages, stored contiguously in a
+/// preallocated byte ring, with a preallocated index of the messages. Pushing
+/// and popping messages never allocates. This is not thread-safe.
+class MessageRing {
+ public:
+  /// Behavior of |Push()| when a message does not fit.
+  enum class OverflowPolicy {
+    /// Drop the message pushed.
+    kDropNewest,
+    /// Drop the oldest messages until the message pushed fits.
+    kDropOldest,
+  };
+
+  /// Create a ring holding up to |max_messages| messages totaling up to
+  /// |capacity| bytes.
+  MessageRing(size_t capacity,
+              size_t max_messages,
+              OverflowPolicy policy) noexcept;
+
+  /// Copy a message at the back of the ring. Return |false| if the message
+  /// was dropped, because it is larger than the ring capacity, or it does not
+  /// fit and the overflow policy drops the newest message.
+  bool Push(const void* data, size_t size) noexcept;
+
+  /// Check if the ring holds no message.
+  bool empty() const noexcept { return (count_ == 0); }
+
+  /// Size of the oldest message. The ring must not be empty.
+  size_t FrontSize() const noexcept { return entries_[front_].size; }
+
+  /// Copy the oldest message to |dst|, which must hold |FrontSize()| bytes,
+  /// and remove it from the ring. The ring must not be empty.
+  void PopFront(void* dst) noexcept;
+
+  /// Number of messages dropped on overflow since the ring was created.
+  uint64_t dropped_count() const noexcept { return dropped_count_; }
+
+ private:
+  struct Entry {
+    size_t offset;
+    size_t size;
+  };
+
+  /// Find room for |size| contiguous bytes, and return its offset, or return
+  /// |false| if there is not enough room.
+  bool Allocate(size_t size, size_t* offset) const noexcept;
+
+  void DropFront() noexcept;
+
+  const OverflowPolicy policy_;
+  std::vector<uint8_t> data_;
+
+  /// Index of the messages stored in |data_|, as a ring of |count_| entries
+  /// starting at |front_|.
+  std::vector<Entry> entries_;
+  size_t front_{0};
+  size_t count_{0};
+
+  /// Offset in |data_| past the newest message. A message which does not fit
+  /// between this and the end of |data_| wraps around to the start.
+  size_t write_offset_{0};
+
+  /// Total size of the messages, to tell a full ring from an empty one.
+  size_t stored_bytes_{0};
+
+  uint64_t dropped_count_{0};
+
+  /// Accounting of |data_| and |entries_| as data channel queue memory.
+  MemoryCharge memory_charge_{MemoryCategory::kDataChannelQueues};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -48,6 +48,10 @@ absl::string_view ToString(Result code) {
       return "SCTP not negotiated";
     case Result::kInvalidDataChannelId:
       return "Invalid DataChannel ID";
+    case Result::kDataChannelSendQueueFull:
+      return "DataChannel send queue full";
+    case Result::kDataChannelStreamAborted:
+      return "DataChannel stream aborted";
   }
 }
 
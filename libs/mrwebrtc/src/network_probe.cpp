@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "api/stats/rtcstats_objects.h"
+
+#include "data_channel.h"
+#include "network_probe.h"
+#include "simple_stats.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Interval between two stats samples of a probe, in milliseconds.
+constexpr const int kSampleIntervalMs = 250;
+
+/// Size of the padding messages. Padding is only sent while the data channel
+/// buffers less than |kMaxPaddingBuffered| bytes, to let the SCTP congestion
+/// control pace it without delaying the messages sent after the probe much.
+constexpr const size_t kPaddingMessageSize = 16 * 1024;
+constexpr const size_t kMaxPaddingBuffered = 256 * 1024;
+
+/// Fraction of the bitrate measured suggested as start bitrate, leaving some
+/// headroom for the fluctuations of the network.
+constexpr const double kStartBitrateRatio = 0.85;
+
+/// Collector forwarding a report to its probe, if still alive.
+class ProbeCollector : public webrtc::RTCStatsCollectorCallback {
+ public:
+  ProbeCollector(std::weak_ptr<NetworkProbe> probe, bool last) noexcept
+      : probe_(std::move(probe)), last_(last) {}
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override {
+    if (std::shared_ptr<NetworkProbe> probe = probe_.lock()) {
+      probe->OnReport(*report, last_);
+    }
+  }
+
+ private:
+  std::weak_ptr<NetworkProbe> probe_;
+  const bool last_;
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+NetworkProbe::NetworkProbe(const mrsNetworkProbeConfig& config,
+                           std::weak_ptr<DataChannel> data_channel,
+                           NetworkProbeCallback callback) noexcept
+    : config_(config),
+      data_channel_(std::move(data_channel)),
+      callback_(callback) {}
+
+void NetworkProbe::OnTick(webrtc::PeerConnectionInterface& peer) noexcept {
+  if (final_report_requested_) {
+    return;
+  }
+  const int64_t now_ms = rtc::TimeMillis();
+  if (start_ms_ == 0) {
+    start_ms_ = now_ms;
+    next_sample_ms_ = now_ms;
+  }
+  if (now_ms - start_ms_ >= config_.duration_ms) {
+    final_report_requested_ = true;
+    Collect(peer, /* last = */ true);
+    return;
+  }
+  SendPadding();
+  if (now_ms >= next_sample_ms_) {
+    next_sample_ms_ = now_ms + kSampleIntervalMs;
+    Collect(peer, /* last = */ false);
+  }
+}
+
+void NetworkProbe::Collect(webrtc::PeerConnectionInterface& peer,
+                           bool last) noexcept {
+  rtc::scoped_refptr<ProbeCollector> collector =
+      new rtc::RefCountedObject<ProbeCollector>(shared_from_this(), last);
+  peer.GetStats(collector);
+}
+
+void NetworkProbe::SendPadding() noexcept {
+  std::shared_ptr<DataChannel> data_channel = data_channel_.lock();
+  if (!data_channel) {
+    return;
+  }
+  // Spread the padding evenly over the ticks.
+  int64_t budget =
+      (int64_t)config_.max_padding_bitrate_bps * kTickIntervalMs / 8000;
+  while (budget > 0) {
+    const size_t size = std::min(kPaddingMessageSize, (size_t)budget);
+    if (!data_channel->SendPadding(size, kMaxPaddingBuffered)) {
+      break;
+    }
+    padding_sent_ = true;
+    budget -= (int64_t)size;
+  }
+}
+
+void NetworkProbe::OnReport(const webrtc::RTCStatsReport& report,
+                            bool last) noexcept {
+  if (done_) {
+    return;
+  }
+
+  // Sum the counters of all transports and received streams, and take the
+  // candidate pair of the first connected transport, which carries all
+  // streams when bundling.
+  Sample sample;
+  sample.timestamp_us = report.timestamp_us();
+  const webrtc::RTCIceCandidatePairStats* pair_stats = nullptr;
+  for (const webrtc::RTCStats& stats : report) {
+    if (stats.type() == webrtc::RTCTransportStats::kType) {
+      const auto& transport_stats =
+          stats.cast_to<webrtc::RTCTransportStats>();
+      sample.bytes_sent += GetValueIfDefined(transport_stats.bytes_sent);
+      const auto& pair_id = transport_stats.selected_candidate_pair_id;
+      if (!pair_stats && pair_id.is_defined()) {
+        const webrtc::RTCStats* pair = report.Get(*pair_id);
+        if (pair &&
+            (pair->type() == webrtc::RTCIceCandidatePairStats::kType)) {
+          pair_stats = &pair->cast_to<webrtc::RTCIceCandidatePairStats>();
+        }
+      }
+    } else if (stats.type() == webrtc::RTCInboundRTPStreamStats::kType) {
+      const auto& rtp_stats = stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
+      sample.packets_received += GetValueIfDefined(rtp_stats.packets_received);
+      sample.packets_lost += GetValueIfDefined(rtp_stats.packets_lost);
+    }
+  }
+  if (pair_stats) {
+    sample.requests_sent = GetValueIfDefined(pair_stats->requests_sent);
+    sample.responses_received =
+        GetValueIfDefined(pair_stats->responses_received);
+    const double round_trip_time =
+        GetValueIfDefined(pair_stats->current_round_trip_time);
+    if (round_trip_time > 0.0) {
+      min_round_trip_time_ = (round_trip_time_count_ == 0
+                                  ? round_trip_time
+                                  : std::min(min_round_trip_time_,
+                                             round_trip_time));
+      round_trip_time_sum_ += round_trip_time;
+      ++round_trip_time_count_;
+    }
+    max_estimated_bitrate_ =
+        std::max(max_estimated_bitrate_,
+                 GetValueIfDefined(pair_stats->available_outgoing_bitrate));
+
+    // Counters restart from zero when the transport is recreated.
+    if (!has_first_sample_ || (sample.bytes_sent < last_sample_.bytes_sent)) {
+      has_first_sample_ = true;
+      first_sample_ = sample;
+    }
+    last_sample_ = sample;
+  }
+  if (last) {
+    Complete();
+  }
+}
+
+void NetworkProbe::Complete() noexcept {
+  const int64_t elapsed_us =
+      last_sample_.timestamp_us - first_sample_.timestamp_us;
+  if (!has_first_sample_ || (elapsed_us <= 0)) {
+    // The connection was lost during the probe.
+    Fail(Result::kInvalidOperation);
+    return;
+  }
+  done_ = true;
+  mrsNetworkProbeResult result{};
+  result.result = Result::kSuccess;
+  result.estimated_bitrate = max_estimated_bitrate_;
+  result.measured_bitrate =
+      ((last_sample_.bytes_sent - first_sample_.bytes_sent) * 8.0 * 1e6) /
+      elapsed_us;
+  if (round_trip_time_count_ > 0) {
+    result.min_round_trip_time = min_round_trip_time_;
+    result.round_trip_time = round_trip_time_sum_ / round_trip_time_count_;
+  }
+
+  // The loss count decreases when duplicates are received, and the last
+  // connectivity checks may still be waiting for their response.
+  const int64_t received_delta =
+      last_sample_.packets_received - first_sample_.packets_received;
+  const int64_t lost_delta =
+      last_sample_.packets_lost - first_sample_.packets_lost;
+  const uint64_t requests_delta =
+      last_sample_.requests_sent - first_sample_.requests_sent;
+  const uint64_t responses_delta =
+      last_sample_.responses_received - first_sample_.responses_received;
+  if (received_delta > 0) {
+    if (lost_delta > 0) {
+      result.loss_fraction = std::min(
+          1.0, (double)lost_delta / (double)(received_delta + lost_delta));
+    }
+  } else if (requests_delta > responses_delta) {
+    result.loss_fraction =
+        (double)(requests_delta - responses_delta) / (double)requests_delta;
+  }
+
+  // Without a video stream the congestion controller does not probe, and its
+  // estimate remains at its start value, so prefer the bitrate measured with
+  // the padding if any.
+  const double bitrate =
+      padding_sent_ ? result.measured_bitrate : result.estimated_bitrate;
+  result.suggested_start_bitrate_bps = (int)(bitrate * kStartBitrateRatio);
+  callback_(&result);
+}
+
+void NetworkProbe::Fail(Result result) noexcept {
+  if (done_) {
+    return;
+  }
+  done_ = true;
+  mrsNetworkProbeResult probe_result{};
+  probe_result.result = result;
+  callback_(&probe_result);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
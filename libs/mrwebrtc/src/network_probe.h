@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+
+#include "api/peerconnectioninterface.h"
+#include "api/stats/rtcstatsreport.h"
+
+#include "callback.h"
+#include "interop_api.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class DataChannel;
+
+/// Callback delivering the result of a network probe.
+using NetworkProbeCallback = Callback<const mrsNetworkProbeResult*>;
+
+/// Probe of the network conditions of a peer connection, sending padding on a
+/// data channel and sampling the stats of the connection for a short duration.
+/// This is only accessed on the signaling thread.
+class NetworkProbe : public std::enable_shared_from_this<NetworkProbe> {
+ public:
+  /// Interval between two ticks of the probe, in milliseconds.
+  static constexpr const int kTickIntervalMs = 50;
+
+  NetworkProbe(const mrsNetworkProbeConfig& config,
+               std::weak_ptr<DataChannel> data_channel,
+               NetworkProbeCallback callback) noexcept;
+
+  /// The result was delivered.
+  bool done() const noexcept { return done_; }
+
+  /// Send the padding of this tick, and request a report from the peer
+  /// connection when a sample is due. Once the duration elapsed, request the
+  /// final report, whose arrival completes the probe.
+  void OnTick(webrtc::PeerConnectionInterface& peer) noexcept;
+
+  /// Accumulate the sample of a report requested by |OnTick()|.
+  void OnReport(const webrtc::RTCStatsReport& report, bool last) noexcept;
+
+  /// Deliver a result with |result| as error, unless already done.
+  void Fail(Result result) noexcept;
+
+ private:
+  /// Counters of a report.
+  struct Sample {
+    int64_t timestamp_us{0};
+    uint64_t bytes_sent{0};
+    uint64_t requests_sent{0};
+    uint64_t responses_received{0};
+    int64_t packets_received{0};
+    int64_t packets_lost{0};
+  };
+
+  void Collect(webrtc::PeerConnectionInterface& peer, bool last) noexcept;
+  void SendPadding() noexcept;
+  void Complete() noexcept;
+
+  const mrsNetworkProbeConfig config_;
+  const std::weak_ptr<DataChannel> data_channel_;
+  const NetworkProbeCallback callback_;
+
+  int64_t start_ms_{0};
+  int64_t next_sample_ms_{0};
+  bool final_report_requested_{false};
+  bool padding_sent_{false};
+  bool done_{false};
+
+  /// Counters of the first report of the connection, and of the last one.
+  bool has_first_sample_{false};
+  Sample first_sample_;
+  Sample last_sample_;
+
+  /// Round trip times and congestion controller estimates sampled.
+  int round_trip_time_count_{0};
+  double round_trip_time_sum_{0.0};
+  double min_round_trip_time_{0.0};
+  double max_estimated_bitrate_{0.0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -55,6 +55,7 @@
 #include "api/transport/bitrate_settings.h"
 #include "api/video/i420_buffer.h"
 #include "api/videosourceproxy.h"
+#include "common_video/include/video_frame_buffer.h"
 #include "media/base/adaptedvideotracksource.h"
 #include "media/engine/internaldecoderfactory.h"
 #include "media/engine/internalencoderfactory.h"
@@ -5,21 +5,27 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "api/crypto/cryptooptions.h"
 #include "audio_frame_observer.h"
 #include "common_audio/resampler/include/resampler.h"
 #include "data_channel.h"
 #include "interop/global_factory.h"
 #include "interop_api.h"
+#include "media/base/mediaconstants.h"
 #include "media/local_audio_track.h"
 #include "media/local_video_track.h"
 #include "media/remote_audio_track.h"
 #include "media/remote_video_track.h"
+#include "pc/sessiondescription.h"
 #include "peer_connection.h"
+#include "port_allocator.h"
 #include "sdp_utils.h"
 #include "utils.h"
 #include "video_frame_observer.h"
 
+#include <condition_variable>
 #include <functional>
+#include <thread>
 
 // Include implementation because we cannot access the mline index from the
 // RtpTransceiverInterface. This is a not-so-clean workaround.
@@ -132,6 +138,37 @@ namespace {
 
 using namespace Microsoft::MixedReality::WebRTC;
 
+enum {
+  /// Deliver the pending batch of local ICE candidates on the signaling
+  /// thread.
+  MSG_FLUSH_ICE_CANDIDATES,
+  /// Restart ICE if the connection is still lost.
+  MSG_RESTART_ICE,
+  /// Collect the stats of the subscription and schedule the next collection.
+  MSG_COLLECT_STATS,
+  /// Check the bandwidth estimate and schedule the next check.
+  MSG_CHECK_BANDWIDTH_ESTIMATE,
+  /// Check the quality limitation of the monitor of the message data, if still
+  /// subscribed, and schedule the next check.
+  MSG_CHECK_QUALITY_LIMITATION,
+  /// Advance the network probe and schedule its next tick.
+  MSG_PROBE_NETWORK,
+  /// Create the data channels added with |AddDataChannelsAsync()|.
+  MSG_ADD_DATA_CHANNELS,
+  /// Resume the send queues of the data channels held back by a channel of a
+  /// higher priority.
+  MSG_DRAIN_DATA_CHANNELS
+};
+
+/// Message data of |MSG_CHECK_QUALITY_LIMITATION|, which does not keep the
+/// monitor alive once unsubscribed.
+using QualityLimitationMessageData =
+    rtc::TypedMessageData<std::weak_ptr<QualityLimitationMonitor>>;
+
+/// Delay before checking again whether to restart ICE when a restart is due
+/// during an SDP exchange.
+constexpr const int kIceRestartRetryDelayMs = 500;
+
 class CreateSessionDescObserver
     : public webrtc::CreateSessionDescriptionObserver {
  public:
@@ -272,17 +309,135 @@ webrtc::PeerConnectionInterface::BundlePolicy BundlePolicyToNative(
   return static_cast<Native>(value);
 }
 
+webrtc::PeerConnectionInterface::ContinualGatheringPolicy
+ContinualGatheringPolicyToNative(mrsContinualGatheringPolicy value) {
+  using Native = webrtc::PeerConnectionInterface::ContinualGatheringPolicy;
+  using Impl = mrsContinualGatheringPolicy;
+  static_assert((int)Native::GATHER_ONCE == (int)Impl::kGatherOnce, "");
+  static_assert(
+      (int)Native::GATHER_CONTINUALLY == (int)Impl::kGatherContinually, "");
+  return static_cast<Native>(value);
+}
+
 }  // namespace
 
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+bool PeerConnection::RemoveListener(CallbackListenerId id) noexcept {
+  if (id == kRegisteredCallbackId) {
+    return false;
+  }
+  bool removed = false;
+  callbacks_.Update([id, &removed](Callbacks& callbacks) {
+    auto remove = [id, &removed](auto& list) { removed |= list.Set(id, {}); };
+    remove(callbacks.data_channel_added_callback_);
+    remove(callbacks.data_channel_removed_callback_);
+    remove(callbacks.transceiver_added_callback_);
+    remove(callbacks.connected_callback_);
+    remove(callbacks.local_sdp_ready_to_send_callback_);
+    remove(callbacks.ice_candidate_ready_to_send_callback_);
+    remove(callbacks.ice_candidates_ready_to_send_callback_);
+    remove(callbacks.ice_state_changed_callback_);
+    remove(callbacks.ice_gathering_state_changed_callback_);
+    remove(callbacks.renegotiation_needed_callback_);
+    remove(callbacks.audio_track_added_callback_);
+    remove(callbacks.audio_track_removed_callback_);
+    remove(callbacks.video_track_added_callback_);
+    remove(callbacks.video_track_removed_callback_);
+  });
+  return removed;
+}
+
+std::vector<DataChannelSettings> DataChannelSettings::FromConfigs(
+    const mrsDataChannelConfig* configs,
+    uint32_t count) {
+  std::vector<DataChannelSettings> settings(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const mrsDataChannelConfig& config = configs[i];
+    settings[i].id = config.id;
+    if (config.label) {
+      settings[i].label = config.label;
+    }
+    settings[i].ordered = (config.flags & mrsDataChannelConfigFlags::kOrdered);
+    settings[i].reliable =
+        (config.flags & mrsDataChannelConfigFlags::kReliable);
+    settings[i].compressed =
+        (config.flags & mrsDataChannelConfigFlags::kCompressed);
+    settings[i].max_retransmits = config.max_retransmits;
+    settings[i].max_packet_lifetime_ms = config.max_packet_lifetime_ms;
+    settings[i].priority = config.priority;
+  }
+  return settings;
+}
+
 ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
     int id,
     absl::string_view label,
     bool ordered,
-    bool reliable) noexcept {
+    bool reliable,
+    bool compressed,
+    int max_retransmits,
+    int max_packet_lifetime_ms,
+    mrsDataChannelPriority priority) noexcept {
+  std::vector<DataChannelSettings> settings(1);
+  settings[0].id = id;
+  settings[0].label.assign(label.data(), label.size());
+  settings[0].ordered = ordered;
+  settings[0].reliable = reliable;
+  settings[0].compressed = compressed;
+  settings[0].max_retransmits = max_retransmits;
+  settings[0].max_packet_lifetime_ms = max_packet_lifetime_ms;
+  settings[0].priority = priority;
+  ErrorOr<std::vector<std::shared_ptr<DataChannel>>> data_channels =
+      AddDataChannels(std::move(settings));
+  if (!data_channels.ok()) {
+    return data_channels.error();
+  }
+  return std::move(data_channels.value()[0]);
+}
+
+ErrorOr<std::vector<std::shared_ptr<DataChannel>>>
+PeerConnection::AddDataChannels(
+    std::vector<DataChannelSettings> settings) noexcept {
+  std::vector<webrtc::DataChannelInit> configs;
+  Error result = PrepareDataChannels(settings, configs);
+  if (!result.ok()) {
+    return result;
+  }
+
+  // Create all channels in a single dispatch to the signaling thread, where
+  // the calls to the proxies of the WebRTC objects do not block anymore.
+  std::vector<std::shared_ptr<DataChannel>> data_channels;
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&]() {
+    result = CreateDataChannels(settings, configs, data_channels);
+  });
+  if (!result.ok()) {
+    return result;
+  }
+  return data_channels;
+}
+
+Error PeerConnection::AddDataChannelsAsync(
+    std::vector<DataChannelSettings> settings,
+    DataChannelsAddedCallback callback) noexcept {
+  PendingDataChannels pending{std::move(settings), {}, callback};
+  Error result = PrepareDataChannels(pending.settings, pending.configs);
+  if (!result.ok()) {
+    return result;
+  }
+  {
+    std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    pending_data_channels_.push_back(std::move(pending));
+  }
+  signaling_thread_->Post(RTC_FROM_HERE, this, MSG_ADD_DATA_CHANNELS);
+  return Error::OK();
+}
+
+Error PeerConnection::PrepareDataChannels(
+    const std::vector<DataChannelSettings>& settings,
+    std::vector<webrtc::DataChannelInit>& configs) noexcept {
   if (IsClosed()) {
     return Error(Result::kPeerConnectionClosed);
   }
@@ -291,34 +446,94 @@ ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
     // stuck in the kConnecting state forever.
     return Error(Result::kSctpNotNegotiated);
   }
-  webrtc::DataChannelInit config{};
-  config.ordered = ordered;
-  config.reliable = reliable;
-  if (id < 0) {
-    // In-band data channel with automatic ID assignment
-    config.id = -1;
-    config.negotiated = false;
-  } else if (id <= 0xFFFF) {
-    // Out-of-band negotiated data channel with pre-established ID
-    config.id = id;
-    config.negotiated = true;
-  } else {
-    // Valid IDs are 0-65535 (16 bits)
-    return Error(Result::kOutOfRange);
+  configs.clear();
+  configs.reserve(settings.size());
+  for (const DataChannelSettings& channel : settings) {
+    // -1 leaves the limit unset, and the SCTP partial reliability extension
+    // encodes limits on 16 bits, where 0xFFFF also stands for unset.
+    constexpr int kMaxReliabilityLimit = 0xFFFE;
+    const int max_retransmits = channel.max_retransmits;
+    const int max_packet_lifetime_ms = channel.max_packet_lifetime_ms;
+    if ((max_retransmits < -1) || (max_packet_lifetime_ms < -1)) {
+      return Error(Result::kInvalidParameter);
+    }
+    if ((max_retransmits > kMaxReliabilityLimit) ||
+        (max_packet_lifetime_ms > kMaxReliabilityLimit)) {
+      return Error(Result::kOutOfRange);
+    }
+    const bool partially_reliable =
+        ((max_retransmits >= 0) || (max_packet_lifetime_ms >= 0));
+    if ((max_retransmits >= 0) && (max_packet_lifetime_ms >= 0)) {
+      RTC_LOG(LS_ERROR) << "Cannot limit both the retransmissions and the "
+                           "packet lifetime of a data channel.";
+      return Error(Result::kInvalidParameter);
+    }
+    if (partially_reliable && channel.reliable) {
+      RTC_LOG(LS_ERROR) << "Cannot limit the retransmissions of a reliable "
+                           "data channel.";
+      return Error(Result::kInvalidParameter);
+    }
+    if ((channel.priority < mrsDataChannelPriority::kVeryLow) ||
+        (channel.priority > mrsDataChannelPriority::kHigh)) {
+      return Error(Result::kInvalidParameter);
+    }
+    webrtc::DataChannelInit config{};
+    config.ordered = channel.ordered;
+    config.reliable = channel.reliable;
+    config.maxRetransmits = max_retransmits;
+    config.maxRetransmitTime = max_packet_lifetime_ms;
+    if (channel.compressed) {
+      config.protocol = DataChannel::kCompressedProtocol;
+    }
+    if (channel.id < 0) {
+      // In-band data channel with automatic ID assignment
+      config.id = -1;
+      config.negotiated = false;
+    } else if (channel.id <= 0xFFFF) {
+      // Out-of-band negotiated data channel with pre-established ID
+      config.id = channel.id;
+      config.negotiated = true;
+    } else {
+      // Valid IDs are 0-65535 (16 bits)
+      return Error(Result::kOutOfRange);
+    }
+    configs.push_back(std::move(config));
   }
-  std::string labelString{label};
-  if (rtc::scoped_refptr<webrtc::DataChannelInterface> impl =
-          peer_->CreateDataChannel(labelString, &config)) {
+  return Error::OK();
+}
+
+Error PeerConnection::CreateDataChannels(
+    const std::vector<DataChannelSettings>& settings,
+    const std::vector<webrtc::DataChannelInit>& configs,
+    std::vector<std::shared_ptr<DataChannel>>& data_channels) noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  RTC_DCHECK_EQ(settings.size(), configs.size());
+  if (IsClosed()) {
+    return Error(Result::kPeerConnectionClosed);
+  }
+  data_channels.reserve(settings.size());
+  for (size_t i = 0; i < settings.size(); ++i) {
+    const std::string& label = settings[i].label;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> impl =
+        peer_->CreateDataChannel(label, &configs[i]);
+    if (!impl) {
+      // Keep the channels already created, which were announced below.
+      return Error(Result::kUnknownError);
+    }
+
     // Create the native object
-    auto data_channel = std::make_shared<DataChannel>(this, std::move(impl));
+    auto data_channel = std::make_shared<DataChannel>(this, signaling_thread_,
+                                                      std::move(impl));
+    data_channel->SetSendPriority(settings[i].priority);
     {
       std::lock_guard<std::mutex> lock(data_channel_mutex_);
+      data_channel->SetLimits(data_channel_limits_);
       data_channels_.push_back(data_channel);
-      if (!labelString.empty()) {
-        data_channel_from_label_.emplace(std::move(labelString), data_channel);
+      if (!label.empty()) {
+        data_channel_from_label_.emplace(label, data_channel);
       }
-      if (config.id >= 0) {
-        data_channel_from_id_.emplace(config.id, data_channel);
+      if (configs[i].id >= 0) {
+        data_channel_from_id_.emplace(configs[i].id, data_channel);
       }
     }
 
@@ -326,16 +541,84 @@ ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
     // OnDataChannel() message, so invoke the DataChannelAdded event right now.
     // For out-of-band channels, the standard doesn't ask to raise that event,
     // but we do it anyway for convenience and for consistency.
-    // Call from the signaling thread so that user callbacks can access the
+    // This runs on the signaling thread so that user callbacks can access the
     // channel state (e.g. register channel callbacks) without it being changed
     // concurrently by WebRTC.
-    global_factory_->GetSignalingThread()->Invoke<void>(RTC_FROM_HERE, [&]() {
-      OnDataChannelAdded(*data_channel.get());
-    });
+    OnDataChannelAdded(*data_channel.get());
+    data_channels.push_back(std::move(data_channel));
+  }
+  return Error::OK();
+}
+
+void PeerConnection::AddPendingDataChannels() noexcept {
+  std::vector<PendingDataChannels> batches;
+  {
+    std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    batches.swap(pending_data_channels_);
+  }
+  for (PendingDataChannels& batch : batches) {
+    std::vector<std::shared_ptr<DataChannel>> data_channels;
+    const Error result =
+        CreateDataChannels(batch.settings, batch.configs, data_channels);
+    std::vector<mrsDataChannelHandle> handles;
+    handles.reserve(data_channels.size());
+    for (const std::shared_ptr<DataChannel>& data_channel : data_channels) {
+      handles.push_back(data_channel.get());
+    }
+    batch.callback(result.result(), handles.data(), (uint32_t)handles.size());
+  }
+}
 
-    return data_channel;
+void PeerConnection::OnDataChannelSendPending(mrsDataChannelPriority priority,
+                                              bool pending) noexcept {
+  std::atomic<int>& count = data_channel_send_pending_[(size_t)priority];
+  if (pending) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if ((count.fetch_sub(1, std::memory_order_relaxed) == 1) &&
+      (priority > mrsDataChannelPriority::kVeryLow)) {
+    // Post rather than drain now, since this is called while a channel drains
+    // its own send queue.
+    signaling_thread_->Post(RTC_FROM_HERE, this, MSG_DRAIN_DATA_CHANNELS);
+  }
+}
+
+bool PeerConnection::HasDataChannelSendPendingAbove(
+    mrsDataChannelPriority priority) const noexcept {
+  for (size_t i = (size_t)priority + 1; i < data_channel_send_pending_.size();
+       ++i) {
+    if (data_channel_send_pending_[i].load(std::memory_order_relaxed) > 0) {
+      return true;
+    }
   }
-  return Error(Result::kUnknownError);
+  return false;
+}
+
+void PeerConnection::DrainDataChannels() noexcept {
+  std::vector<std::shared_ptr<DataChannel>> data_channels;
+  {
+    std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    data_channels = data_channels_;
+  }
+  std::stable_sort(data_channels.begin(), data_channels.end(),
+                   [](const std::shared_ptr<DataChannel>& lhs,
+                      const std::shared_ptr<DataChannel>& rhs) {
+                     return lhs->send_priority() > rhs->send_priority();
+                   });
+  for (const std::shared_ptr<DataChannel>& data_channel : data_channels) {
+    data_channel->DrainSendQueue();
+  }
+}
+
+std::shared_ptr<DataChannel> PeerConnection::GetDataChannelById(
+    int id) noexcept {
+  std::lock_guard<std::mutex> lock(data_channel_mutex_);
+  auto it = data_channel_from_id_.find(id);
+  if (it != data_channel_from_id_.end()) {
+    return it->second;
+  }
+  return nullptr;
 }
 
 void PeerConnection::RemoveDataChannel(
@@ -383,8 +666,8 @@ void PeerConnection::RemoveDataChannel(
 
   // Invoke the DataChannelRemoved callback
   {
-    std::lock_guard<std::mutex> lock(data_channel_removed_callback_mutex_);
-    auto removed_cb = data_channel_removed_callback_;
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    const auto& removed_cb = callbacks->data_channel_removed_callback_;
     if (removed_cb) {
       mrsDataChannelHandle data_native_handle = (void*)&data_channel;
       removed_cb(data_native_handle);
@@ -397,8 +680,8 @@ void PeerConnection::RemoveDataChannel(
 }
 
 void PeerConnection::RemoveAllDataChannels() noexcept {
-  std::lock_guard<std::mutex> lock_cb(data_channel_removed_callback_mutex_);
-  auto removed_cb = data_channel_removed_callback_;
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& removed_cb = callbacks->data_channel_removed_callback_;
   std::lock_guard<std::mutex> lock(data_channel_mutex_);
   for (auto&& data_channel : data_channels_) {
     // Close the WebRTC data channel
@@ -438,8 +721,8 @@ void PeerConnection::OnDataChannelAdded(
 
   // Invoke the DataChannelAdded callback
   {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    auto added_cb = data_channel_added_callback_;
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    const auto& added_cb = callbacks->data_channel_added_callback_;
     if (added_cb) {
       mrsDataChannelAddedInfo info{};
       info.handle = (void*)&data_channel;
@@ -447,6 +730,8 @@ void PeerConnection::OnDataChannelAdded(
       info.flags = data_channel.flags();
       std::string label_str = data_channel.label();  // keep alive
       info.label = label_str.c_str();
+      info.max_retransmits = data_channel.max_retransmits();
+      info.max_packet_lifetime_ms = data_channel.max_packet_lifetime_ms();
       added_cb(&info);
 
       // The user assumes an initial state of kConnecting; if this has already
@@ -494,7 +779,26 @@ Error PeerConnection::AddIceCandidate(
   return Error(Result::kSuccess);
 }
 
-bool PeerConnection::CreateOffer() noexcept {
+Error PeerConnection::AddIceCandidates(const mrsIceCandidate* candidates,
+                                       int count) noexcept {
+  if (!peer_) {
+    return Error(Result::kInvalidOperation);
+  }
+  // Calls to the peer connection proxy from the signaling thread are direct,
+  // so this costs a single thread hop for the whole batch.
+  return signaling_thread_->Invoke<Error>(
+      RTC_FROM_HERE, [this, candidates, count]() {
+        for (int i = 0; i < count; ++i) {
+          Error result = AddIceCandidate(candidates[i]);
+          if (!result.ok()) {
+            return result;
+          }
+        }
+        return Error(Result::kSuccess);
+      });
+}
+
+bool PeerConnection::CreateOffer(bool ice_restart) noexcept {
   if (!peer_) {
     return false;
   }
@@ -512,6 +816,7 @@ bool PeerConnection::CreateOffer() noexcept {
   // |offer_to_receive_video|. Those are global per-SDP session options but in
   // Plan B there is a single media line per media kind, so it doesn't matter.
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_options{};
+  offer_options.ice_restart = ice_restart;
   if (IsPlanB()) {
     offer_options.offer_to_receive_audio = false;
     offer_options.offer_to_receive_video = false;
@@ -520,7 +825,7 @@ bool PeerConnection::CreateOffer() noexcept {
       std::string encoded_stream_id =
           tr->BuildEncodedStreamIDForPlanB(mline_index);
       const char* media_kind_str = nullptr;
-      const Transceiver::Direction dir = tr->GetDesiredDirection();
+      const Transceiver::Direction dir = tr->GetWireDirection();
       const bool need_sender = ((dir == Transceiver::Direction::kSendOnly) ||
                                 (dir == Transceiver::Direction::kSendRecv));
       const bool need_receiver = ((dir == Transceiver::Direction::kRecvOnly) ||
@@ -539,8 +844,14 @@ bool PeerConnection::CreateOffer() noexcept {
           offer_options.offer_to_receive_video = true;
         }
       }
+      webrtc::RtpSenderInterface* const prev_sender = tr->GetRtpSender();
       tr->SyncSenderPlanB(need_sender, peer_, media_kind_str,
                           encoded_stream_id.c_str());
+      {
+        rtc::CritScope lock(&transceivers_mutex_);
+        transceiver_from_sender_.erase(prev_sender);
+        IndexTransceiver(*tr);
+      }
       ++mline_index;
     }
   }
@@ -577,14 +888,32 @@ void PeerConnection::Close() noexcept {
   // Close the connection
   pc->Close();
 
+  // Discard any batch of local ICE candidates not delivered yet and any
+  // pending ICE restart. This runs on the signaling thread to ensure no
+  // message is being handled once done.
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [this]() {
+    signaling_thread_->Clear(this);
+    ice_candidate_flush_posted_ = false;
+    pending_ice_candidates_.clear();
+    stats_subscription_ = nullptr;
+    bandwidth_estimate_monitor_ = nullptr;
+    quality_limitation_monitors_.clear();
+    if (network_probe_) {
+      network_probe_->Fail(Result::kPeerConnectionClosed);
+      network_probe_ = nullptr;
+    }
+    // Fail the pending asynchronous data channel creations.
+    AddPendingDataChannels();
+  });
+
   {
     rtc::CritScope lock(&transceivers_mutex_);
 
     // Force-remove remote tracks. It doesn't look like the TrackRemoved
     // callback is called when Close() is used, so force it here.
-    std::lock_guard<std::mutex> cb_lock{media_track_callback_mutex_};
-    auto audio_cb = audio_track_removed_callback_;
-    auto video_cb = video_track_removed_callback_;
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    const auto& audio_cb = callbacks->audio_track_removed_callback_;
+    const auto& video_cb = callbacks->video_track_removed_callback_;
     for (auto&& transceiver : transceivers_) {
       if (auto remote_track = transceiver->GetRemoteTrack()) {
         if (remote_track->GetKind() == mrsTrackKind::kAudioTrack) {
@@ -607,6 +936,10 @@ void PeerConnection::Close() noexcept {
 
     // Clear and destroy transceivers (unless some implementation somewhere has
     // a reference, which should not happen).
+    transceiver_from_rtp_transceiver_.clear();
+    transceiver_from_sender_.clear();
+    transceiver_from_receiver_.clear();
+    transceiver_from_mline_index_.clear();
     transceivers_.clear();
   }
 
@@ -622,6 +955,78 @@ void PeerConnection::Close() noexcept {
   pc = nullptr;
 }
 
+Result PeerConnection::CloseMany(std::vector<RefPtr<PeerConnection>> peers,
+                                 int timeout_ms) noexcept {
+  // Closing a connection blocks on its signaling thread, so closing several
+  // connections sharing the same thread on separate threads would not be any
+  // faster.
+  std::unordered_map<rtc::Thread*, std::vector<RefPtr<PeerConnection>>>
+      peers_from_thread;
+  for (RefPtr<PeerConnection>& peer : peers) {
+    rtc::Thread* const signaling_thread = peer->signaling_thread_;
+    peers_from_thread[signaling_thread].push_back(std::move(peer));
+  }
+
+  // State shared with the closing threads, which may outlive this call.
+  struct CloseState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending_count RTC_GUARDED_BY(mutex){0};
+  };
+  auto state = std::make_shared<CloseState>();
+  state->pending_count = peers.size();
+  try {
+    for (auto&& pair : peers_from_thread) {
+      std::thread([state, group = std::move(pair.second)]() mutable {
+        for (RefPtr<PeerConnection>& peer : group) {
+          peer->Close();
+          peer = nullptr;
+          std::lock_guard<std::mutex> lock(state->mutex);
+          if (--state->pending_count == 0) {
+            state->cv.notify_all();
+          }
+        }
+      }).detach();
+    }
+  } catch (...) {
+    return Result::kUnknownError;
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  auto all_closed = [&state]() { return (state->pending_count == 0); };
+  if (timeout_ms < 0) {
+    state->cv.wait(lock, all_closed);
+  } else if (!state->cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                 all_closed)) {
+    RTC_LOG(LS_WARNING) << state->pending_count
+                        << " peer connection(s) still closing after "
+                        << timeout_ms << " ms.";
+    lock.unlock();
+    GlobalFactory::StaticReportLiveObjects();
+    return Result::kTimeout;
+  }
+  return Result::kSuccess;
+}
+
+Error PeerConnection::PrewarmIce(int pool_size) noexcept {
+  if (!peer_) {
+    return Error(Result::kInvalidOperation, "The peer connection is closed.");
+  }
+  webrtc::PeerConnectionInterface::RTCConfiguration rtc_config =
+      peer_->GetConfiguration();
+  if (rtc_config.ice_candidate_pool_size >= pool_size) {
+    return Error(Result::kSuccess);
+  }
+  // Growing the pool immediately starts gathering the new pooled candidates,
+  // which the first local description then takes over.
+  rtc_config.ice_candidate_pool_size = pool_size;
+  webrtc::RTCError error;
+  if (!peer_->SetConfiguration(rtc_config, &error)) {
+    return ErrorFromRTCError(std::move(error));
+  }
+  return Error(Result::kSuccess);
+}
+
 bool PeerConnection::IsClosed() const noexcept {
   return (peer_ == nullptr);
 }
@@ -645,11 +1050,45 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
   }
   std::vector<std::string> stream_ids =
       Transceiver::DecodeStreamIDs(config.stream_ids);
+  if ((config.send_encodings_count < 0) ||
+      ((config.send_encodings_count > 0) && !config.send_encodings)) {
+    return Error(Result::kInvalidParameter, "Invalid send encodings.");
+  }
+  std::vector<webrtc::RtpEncodingParameters> send_encodings;
+  send_encodings.reserve(config.send_encodings_count);
+  for (int i = 0; i < config.send_encodings_count; ++i) {
+    ErrorOr<webrtc::RtpEncodingParameters> encoding =
+        EncodingParametersToRtc(config.send_encodings[i]);
+    if (!encoding.ok()) {
+      return encoding.MoveError();
+    }
+    send_encodings.push_back(encoding.MoveValue());
+  }
+  Error scalability_error = CheckScalabilityMode(
+      config.media_kind, config.send_encodings, config.send_encodings_count,
+      global_factory_->GetVp9Layers());
+  if (!scalability_error.ok()) {
+    return scalability_error;
+  }
+  if (send_encodings.size() > 1) {
+    // Simulcast layers are told apart by their RID.
+    std::unordered_set<std::string> rids;
+    for (auto&& encoding : send_encodings) {
+      if (encoding.rid.empty() || !rids.insert(encoding.rid).second) {
+        return Error(Result::kInvalidParameter,
+                     "Simulcast encodings need distinct RIDs.");
+      }
+    }
+  }
 
   RefPtr<Transceiver> transceiver;
   const int mline_index = -1;  // just created, so not associated yet
   switch (peer_->GetConfiguration().sdp_semantics) {
     case webrtc::SdpSemantics::kPlanB: {
+      if (!send_encodings.empty()) {
+        return Error(Result::kUnsupported,
+                     "Send encodings require Unified Plan.");
+      }
       // Plan B doesn't have transceivers; just create a wrapper.
       transceiver = Transceiver::CreateForPlanB(
           global_factory_, config.media_kind, *this, mline_index, name,
@@ -663,6 +1102,7 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       webrtc::RtpTransceiverInit init{};
       init.direction = Transceiver::ToRtp(config.desired_direction);
       init.stream_ids = stream_ids;
+      init.send_encodings = std::move(send_encodings);
       const cricket::MediaType rtc_media_type =
           MediaKindToRtc(config.media_kind);
       webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>
@@ -681,15 +1121,12 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       return Error(Result::kUnknownError, "Unknown SDP semantic.");
   }
   RTC_DCHECK(transceiver);
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
+  AddTransceiverWrapper(transceiver);
 
   // Invoke the TransceiverAdded callback
   {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    if (auto cb = transceiver_added_callback_) {
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    if (const auto& cb = callbacks->transceiver_added_callback_) {
       mrsTransceiverAddedInfo info{};
       info.transceiver_handle = transceiver.get();
       info.transceiver_name = name.c_str();
@@ -725,6 +1162,10 @@ Error PeerConnection::SetRemoteDescriptionAsync(
   if (!session_description) {
     return Error(mrsResult::kInvalidParameter, error.description.c_str());
   }
+  if (IsUnifiedPlan()) {
+    // The format parameters of the remote description configure the encoders.
+    ApplyAudioCodecOptions(*session_description);
+  }
   rtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface> observer =
       new rtc::RefCountedObject<SetRemoteSessionDescObserver>(
           [this, callback](mrsResult result, const char* error_message) {
@@ -764,8 +1205,8 @@ void PeerConnection::OnSignalingChange(
       // but this callback would not be invoked then because there's no
       // transition.
       {
-        std::lock_guard<std::mutex> lock(connected_callback_mutex_);
-        connected_callback_();
+        RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+        callbacks->connected_callback_();
       }
       break;
     case webrtc::PeerConnectionInterface::kHaveLocalOffer:
@@ -830,11 +1271,18 @@ void PeerConnection::OnDataChannel(
         (uint32_t)config.flags |
         (uint32_t)mrsDataChannelConfigFlags::kReliable);
   }
+  if (impl->protocol() == DataChannel::kCompressedProtocol) {
+    config.flags = (mrsDataChannelConfigFlags)(
+        (uint32_t)config.flags |
+        (uint32_t)mrsDataChannelConfigFlags::kCompressed);
+  }
 
   // Create a new native object
-  auto data_channel = std::make_shared<DataChannel>(this, impl);
+  auto data_channel = std::make_shared<DataChannel>(
+      this, signaling_thread_, impl);
   {
     std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    data_channel->SetLimits(data_channel_limits_);
     data_channels_.push_back(data_channel);
     if (!label.empty()) {
       // Move |label| into the map to avoid copy
@@ -850,22 +1298,56 @@ void PeerConnection::OnDataChannel(
 
   // Invoke the DataChannelAdded callback
   {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    auto added_cb = data_channel_added_callback_;
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    const auto& added_cb = callbacks->data_channel_added_callback_;
     if (added_cb) {
       mrsDataChannelAddedInfo info{};
       info.handle = data_channel.get();
       info.id = config.id;
       info.flags = config.flags;
       info.label = config.label;
+      info.max_retransmits = data_channel->max_retransmits();
+      info.max_packet_lifetime_ms = data_channel->max_packet_lifetime_ms();
       added_cb(&info);
     }
   }
 }
 
+void PeerConnection::BeginBatchUpdate() noexcept {
+  std::lock_guard<std::mutex> lock(batch_update_mutex_);
+  ++batch_update_depth_;
+}
+
+Result PeerConnection::EndBatchUpdate() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(batch_update_mutex_);
+    if (batch_update_depth_ == 0) {
+      return Result::kInvalidOperation;
+    }
+    if ((--batch_update_depth_ > 0) || !renegotiation_needed_pending_) {
+      return Result::kSuccess;
+    }
+    renegotiation_needed_pending_ = false;
+  }
+  // Invoke outside the lock, as the callbacks typically create an offer.
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->renegotiation_needed_callback_;
+  if (cb) {
+    cb();
+  }
+  return Result::kSuccess;
+}
+
 void PeerConnection::OnRenegotiationNeeded() noexcept {
-  std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
-  auto cb = renegotiation_needed_callback_;
+  {
+    std::lock_guard<std::mutex> lock(batch_update_mutex_);
+    if (batch_update_depth_ > 0) {
+      renegotiation_needed_pending_ = true;
+      return;
+    }
+  }
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->renegotiation_needed_callback_;
   if (cb) {
     cb();
   }
@@ -873,8 +1355,34 @@ void PeerConnection::OnRenegotiationNeeded() noexcept {
 
 void PeerConnection::OnIceConnectionChange(
     webrtc::PeerConnectionInterface::IceConnectionState new_state) noexcept {
-  std::lock_guard<std::mutex> lock(ice_state_changed_callback_mutex_);
-  auto cb = ice_state_changed_callback_;
+  switch (new_state) {
+    case webrtc::PeerConnectionInterface::kIceConnectionConnected:
+    case webrtc::PeerConnectionInterface::kIceConnectionCompleted:
+      ice_restart_attempts_ = 0;
+      signaling_thread_->Clear(this, MSG_RESTART_ICE);
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionDisconnected:
+      // Give the connection a chance to recover on its own first.
+      if ((ice_restart_policy_.enabled == mrsBool::kTrue) &&
+          (ice_restart_policy_.disconnected_delay_ms >= 0)) {
+        signaling_thread_->Clear(this, MSG_RESTART_ICE);
+        signaling_thread_->PostDelayed(
+            RTC_FROM_HERE, ice_restart_policy_.disconnected_delay_ms, this,
+            MSG_RESTART_ICE);
+      }
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionFailed:
+      // Restart outside of the observer callback.
+      if (ice_restart_policy_.enabled == mrsBool::kTrue) {
+        signaling_thread_->Clear(this, MSG_RESTART_ICE);
+        signaling_thread_->Post(RTC_FROM_HERE, this, MSG_RESTART_ICE);
+      }
+      break;
+    default:
+      break;
+  }
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->ice_state_changed_callback_;
   if (cb) {
     cb(IceStateFromImpl(new_state));
   }
@@ -882,8 +1390,11 @@ void PeerConnection::OnIceConnectionChange(
 
 void PeerConnection::OnIceGatheringChange(
     webrtc::PeerConnectionInterface::IceGatheringState new_state) noexcept {
-  std::lock_guard<std::mutex> lock(ice_gathering_state_changed_callback_mutex_);
-  auto cb = ice_gathering_state_changed_callback_;
+  if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+    FlushIceCandidates();
+  }
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->ice_gathering_state_changed_callback_;
   if (cb) {
     cb(IceGatheringStateFromImpl(new_state));
   }
@@ -891,21 +1402,267 @@ void PeerConnection::OnIceGatheringChange(
 
 void PeerConnection::OnIceCandidate(
     const webrtc::IceCandidateInterface* candidate) noexcept {
-  std::lock_guard<std::mutex> lock(ice_candidate_ready_to_send_callback_mutex_);
-  auto cb = ice_candidate_ready_to_send_callback_;
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->ice_candidate_ready_to_send_callback_;
+  const bool batched = (bool)callbacks->ice_candidates_ready_to_send_callback_;
+  if (!cb && !batched) {
+    return;
+  }
+  std::string sdp;
+  if (!candidate->ToString(&sdp)) {
+    RTC_LOG(LS_ERROR) << "Failed to stringify ICE candidate into SDP format.";
+    return;
+  }
+  std::string sdp_mid = candidate->sdp_mid();
   if (cb) {
-    std::string sdp;
-    if (!candidate->ToString(&sdp)) {
-      RTC_LOG(LS_ERROR) << "Failed to stringify ICE candidate into SDP format.";
-      return;
-    }
-    std::string sdp_mid = candidate->sdp_mid();
     mrsIceCandidate ice_candidate{};
     ice_candidate.sdp_mid = sdp_mid.c_str();
     ice_candidate.sdp_mline_index = candidate->sdp_mline_index();
     ice_candidate.content = sdp.c_str();
     cb(&ice_candidate);
   }
+  if (batched) {
+    pending_ice_candidates_.push_back(PendingIceCandidate{
+        std::move(sdp_mid), std::move(sdp), candidate->sdp_mline_index()});
+    const int window_ms =
+        ice_candidate_batch_window_ms_.load(std::memory_order_relaxed);
+    if (window_ms == 0) {
+      FlushIceCandidates();
+    } else if ((window_ms > 0) && !ice_candidate_flush_posted_) {
+      signaling_thread_->PostDelayed(
+          RTC_FROM_HERE, window_ms, this, MSG_FLUSH_ICE_CANDIDATES);
+      ice_candidate_flush_posted_ = true;
+    }
+  }
+}
+
+void PeerConnection::FlushIceCandidates() noexcept {
+  if (ice_candidate_flush_posted_) {
+    signaling_thread_->Clear(this, MSG_FLUSH_ICE_CANDIDATES);
+    ice_candidate_flush_posted_ = false;
+  }
+  if (pending_ice_candidates_.empty()) {
+    return;
+  }
+  // Take the batch before invoking the callbacks, which may gather more
+  // candidates or close the peer connection.
+  std::vector<PendingIceCandidate> pending(std::move(pending_ice_candidates_));
+  pending_ice_candidates_.clear();
+  std::vector<mrsIceCandidate> ice_candidates(pending.size());
+  for (size_t i = 0; i < pending.size(); ++i) {
+    ice_candidates[i].sdp_mid = pending[i].sdp_mid.c_str();
+    ice_candidates[i].content = pending[i].content.c_str();
+    ice_candidates[i].sdp_mline_index = pending[i].sdp_mline_index;
+  }
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  const auto& cb = callbacks->ice_candidates_ready_to_send_callback_;
+  if (cb) {
+    cb(ice_candidates.data(), (int)ice_candidates.size());
+  }
+}
+
+void PeerConnection::SetIceRestartPolicy(
+    const mrsIceRestartPolicy& policy) noexcept {
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&]() {
+    ice_restart_policy_ = policy;
+    ice_restart_attempts_ = 0;
+    if (policy.enabled != mrsBool::kTrue) {
+      signaling_thread_->Clear(this, MSG_RESTART_ICE);
+    }
+  });
+}
+
+Result PeerConnection::SubscribeStats(const mrsStatsSubscriptionConfig& config,
+                                      StatsSnapshotCallback callback) noexcept {
+  return signaling_thread_->Invoke<Result>(RTC_FROM_HERE, [&]() {
+    signaling_thread_->Clear(this, MSG_COLLECT_STATS);
+    stats_subscription_ = nullptr;
+    if (!callback) {
+      return Result::kSuccess;
+    }
+    if (!peer_) {
+      return Result::kPeerConnectionClosed;
+    }
+    stats_subscription_ = std::make_shared<StatsSubscription>(config, callback);
+    signaling_thread_->PostDelayed(RTC_FROM_HERE, config.interval_ms, this,
+                                   MSG_COLLECT_STATS);
+    return Result::kSuccess;
+  });
+}
+
+Result PeerConnection::SubscribeBandwidthEstimate(
+    const mrsBandwidthEstimateConfig& config,
+    BandwidthEstimateCallback callback) noexcept {
+  return signaling_thread_->Invoke<Result>(RTC_FROM_HERE, [&]() {
+    signaling_thread_->Clear(this, MSG_CHECK_BANDWIDTH_ESTIMATE);
+    bandwidth_estimate_monitor_ = nullptr;
+    if (!callback) {
+      return Result::kSuccess;
+    }
+    if (!peer_) {
+      return Result::kPeerConnectionClosed;
+    }
+    bandwidth_estimate_monitor_ =
+        std::make_shared<BandwidthEstimateMonitor>(config, callback);
+    signaling_thread_->PostDelayed(RTC_FROM_HERE, config.interval_ms, this,
+                                   MSG_CHECK_BANDWIDTH_ESTIMATE);
+    return Result::kSuccess;
+  });
+}
+
+Result PeerConnection::ProbeNetwork(const mrsNetworkProbeConfig& config,
+                                    NetworkProbeCallback callback) noexcept {
+  return signaling_thread_->Invoke<Result>(RTC_FROM_HERE, [&]() {
+    if (!peer_) {
+      return Result::kPeerConnectionClosed;
+    }
+    const webrtc::PeerConnectionInterface::IceConnectionState state =
+        peer_->ice_connection_state();
+    if ((network_probe_ && !network_probe_->done()) ||
+        ((state != webrtc::PeerConnectionInterface::kIceConnectionConnected) &&
+         (state != webrtc::PeerConnectionInterface::kIceConnectionCompleted))) {
+      return Result::kInvalidOperation;
+    }
+    std::weak_ptr<DataChannel> data_channel;
+    if (config.data_channel) {
+      std::lock_guard<std::mutex> lock(data_channel_mutex_);
+      auto it = std::find_if(
+          data_channels_.begin(), data_channels_.end(),
+          [&config](const std::shared_ptr<DataChannel>& channel) {
+            return (channel.get() == config.data_channel);
+          });
+      if (it == data_channels_.end()) {
+        return Result::kNotFound;
+      }
+      data_channel = *it;
+    }
+    // A probe completed is replaced, and its pending tick advances the new
+    // one, if any.
+    const bool tick_pending = (network_probe_ != nullptr);
+    network_probe_ = std::make_shared<NetworkProbe>(
+        config, std::move(data_channel), callback);
+    if (!tick_pending) {
+      signaling_thread_->Post(RTC_FROM_HERE, this, MSG_PROBE_NETWORK);
+    }
+    return Result::kSuccess;
+  });
+}
+
+Result PeerConnection::SubscribeQualityLimitation(
+    Transceiver& transceiver,
+    const mrsQualityLimitationConfig& config,
+    QualityLimitationCallback callback) noexcept {
+  return signaling_thread_->Invoke<Result>(RTC_FROM_HERE, [&]() {
+    // The pending check of a removed monitor is skipped once it expires.
+    auto it = std::find_if(
+        quality_limitation_monitors_.begin(),
+        quality_limitation_monitors_.end(),
+        [&transceiver](const std::shared_ptr<QualityLimitationMonitor>& m) {
+          return (&m->transceiver() == &transceiver);
+        });
+    if (it != quality_limitation_monitors_.end()) {
+      quality_limitation_monitors_.erase(it);
+    }
+    if (!callback) {
+      return Result::kSuccess;
+    }
+    if (!peer_) {
+      return Result::kPeerConnectionClosed;
+    }
+    auto monitor = std::make_shared<QualityLimitationMonitor>(
+        transceiver, config, callback);
+    quality_limitation_monitors_.push_back(monitor);
+    signaling_thread_->PostDelayed(
+        RTC_FROM_HERE, config.interval_ms, this, MSG_CHECK_QUALITY_LIMITATION,
+        new QualityLimitationMessageData(std::move(monitor)));
+    return Result::kSuccess;
+  });
+}
+
+void PeerConnection::RestartIceIfNeeded() noexcept {
+  if (!peer_ || (ice_restart_policy_.enabled != mrsBool::kTrue)) {
+    return;
+  }
+  const webrtc::PeerConnectionInterface::IceConnectionState state =
+      peer_->ice_connection_state();
+  if ((state != webrtc::PeerConnectionInterface::kIceConnectionDisconnected) &&
+      (state != webrtc::PeerConnectionInterface::kIceConnectionFailed)) {
+    return;
+  }
+  if (peer_->signaling_state() != webrtc::PeerConnectionInterface::kStable) {
+    // The exchange in progress may itself restore the connection.
+    signaling_thread_->PostDelayed(
+        RTC_FROM_HERE, kIceRestartRetryDelayMs, this, MSG_RESTART_ICE);
+    return;
+  }
+  if ((ice_restart_policy_.max_attempts > 0) &&
+      (ice_restart_attempts_ >= ice_restart_policy_.max_attempts)) {
+    RTC_LOG(LS_WARNING) << "Giving up restarting ICE after "
+                        << ice_restart_attempts_ << " attempts.";
+    return;
+  }
+  ++ice_restart_attempts_;
+  RTC_LOG(LS_INFO) << "Restarting ICE, attempt #" << ice_restart_attempts_
+                   << ".";
+  CreateOffer(/*ice_restart=*/true);
+}
+
+void PeerConnection::OnMessage(rtc::Message* message) {
+  switch (message->message_id) {
+    case MSG_FLUSH_ICE_CANDIDATES:
+      ice_candidate_flush_posted_ = false;
+      FlushIceCandidates();
+      break;
+    case MSG_RESTART_ICE:
+      RestartIceIfNeeded();
+      break;
+    case MSG_ADD_DATA_CHANNELS:
+      AddPendingDataChannels();
+      break;
+    case MSG_DRAIN_DATA_CHANNELS:
+      DrainDataChannels();
+      break;
+    case MSG_COLLECT_STATS:
+      if (stats_subscription_ && peer_) {
+        stats_subscription_->Collect(*peer_);
+        signaling_thread_->PostDelayed(
+            RTC_FROM_HERE, stats_subscription_->interval_ms(), this,
+            MSG_COLLECT_STATS);
+      }
+      break;
+    case MSG_CHECK_BANDWIDTH_ESTIMATE:
+      if (bandwidth_estimate_monitor_ && peer_) {
+        bandwidth_estimate_monitor_->Collect(*peer_);
+        signaling_thread_->PostDelayed(
+            RTC_FROM_HERE, bandwidth_estimate_monitor_->interval_ms(), this,
+            MSG_CHECK_BANDWIDTH_ESTIMATE);
+      }
+      break;
+    case MSG_PROBE_NETWORK:
+      if (network_probe_ && peer_) {
+        if (network_probe_->done()) {
+          network_probe_ = nullptr;
+          break;
+        }
+        network_probe_->OnTick(*peer_);
+        signaling_thread_->PostDelayed(RTC_FROM_HERE,
+                                       NetworkProbe::kTickIntervalMs, this,
+                                       MSG_PROBE_NETWORK);
+      }
+      break;
+    case MSG_CHECK_QUALITY_LIMITATION: {
+      std::unique_ptr<QualityLimitationMessageData> data(
+          static_cast<QualityLimitationMessageData*>(message->pdata));
+      std::shared_ptr<QualityLimitationMonitor> monitor = data->data().lock();
+      if (monitor && peer_) {
+        monitor->Collect(*peer_);
+        signaling_thread_->PostDelayed(RTC_FROM_HERE, monitor->interval_ms(),
+                                       this, MSG_CHECK_QUALITY_LIMITATION,
+                                       data.release());
+      }
+      break;
+    }
+  }
 }
 
 void PeerConnection::OnAddTrack(
@@ -924,7 +1681,8 @@ void PeerConnection::OnAddTrack(
   if (track_kind_str == webrtc::MediaStreamTrackInterface::kAudioKind) {
     RefPtr<RemoteAudioTrack> track_wrapper =
         AddRemoteMediaTrack<mrsMediaKind::kAudio>(
-            std::move(track), receiver.get(), &audio_track_added_callback_);
+            std::move(track), receiver.get(),
+            &Callbacks::audio_track_added_callback_);
     if (audio_mixer_) {
       // The track won't be output by the mixer until OutputSource is called.
       // We need to get the ssrc of the receiver in order to match the track to
@@ -953,8 +1711,9 @@ void PeerConnection::OnAddTrack(
       peer_->GetStats(receiver, stats_observer);
     }
   } else if (track_kind_str == webrtc::MediaStreamTrackInterface::kVideoKind) {
-    AddRemoteMediaTrack<mrsMediaKind::kVideo>(std::move(track), receiver.get(),
-                                              &video_track_added_callback_);
+    AddRemoteMediaTrack<mrsMediaKind::kVideo>(
+        std::move(track), receiver.get(),
+        &Callbacks::video_track_added_callback_);
   }
 }
 
@@ -999,10 +1758,10 @@ void PeerConnection::OnRemoveTrack(
   const std::string& track_kind_str = track->kind();
   if (track_kind_str == webrtc::MediaStreamTrackInterface::kAudioKind) {
     RemoveRemoteMediaTrack<mrsMediaKind::kAudio>(
-        receiver.get(), &audio_track_removed_callback_);
+        receiver.get(), &Callbacks::audio_track_removed_callback_);
   } else if (track_kind_str == webrtc::MediaStreamTrackInterface::kVideoKind) {
     RemoveRemoteMediaTrack<mrsMediaKind::kVideo>(
-        receiver.get(), &video_track_removed_callback_);
+        receiver.get(), &Callbacks::video_track_removed_callback_);
   }
 }
 
@@ -1024,8 +1783,8 @@ void PeerConnection::OnLocalDescCreated(
 
         // Fire interop callback, if any
         {
-          std::lock_guard<std::mutex> lock(local_sdp_ready_to_send_callback_mutex_);
-          if (auto cb = local_sdp_ready_to_send_callback_) {
+          RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+          if (const auto& cb = callbacks->local_sdp_ready_to_send_callback_) {
             auto desc = peer_->local_description();
             const mrsSdpMessageType type = ApiTypeFromSdpType(desc->GetType());
             std::string sdp;
@@ -1034,22 +1793,144 @@ void PeerConnection::OnLocalDescCreated(
           }
         }
       });
+  if (IsUnifiedPlan()) {
+    ApplyCodecPreferences(*desc);
+    ApplyAudioCodecOptions(*desc);
+  }
   // SetLocalDescription will invoke observer.OnSuccess() once done, which
   // will in turn invoke the |local_sdp_ready_to_send_callback_| registered if
   // any, or do nothing otherwise. The observer is a mandatory parameter.
   peer_->SetLocalDescription(observer, desc);
 }
 
+void PeerConnection::ApplyCodecPreferences(
+    webrtc::SessionDescriptionInterface& desc) {
+  cricket::SessionDescription* const session_desc = desc.description();
+  if (!session_desc) {
+    return;
+  }
+  cricket::ContentInfos& contents = session_desc->contents();
+  for (auto&& rtp_tr : peer_->GetTransceivers()) {
+    RefPtr<Transceiver> wrapper = FindWrapperFromRtpTransceiver(rtp_tr);
+    if (!wrapper) {
+      continue;
+    }
+    std::vector<SdpCodecPreference> preferences =
+        wrapper->GetCodecPreferences();
+    if (preferences.empty()) {
+      continue;
+    }
+    // The media line of new transceivers is already assigned when creating an
+    // offer, even though their mid is only assigned once it is applied.
+    const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_tr);
+    if ((mline_index < 0) || ((size_t)mline_index >= contents.size())) {
+      continue;
+    }
+    cricket::MediaContentDescription* const media_desc =
+        contents[mline_index].description;
+    if (!media_desc ||
+        !SdpApplyCodecPreferences(preferences, *media_desc)) {
+      RTC_LOG(LS_WARNING) << "None of the preferred codecs of transceiver "
+                          << wrapper->GetName() << " is supported.";
+    }
+  }
+}
+
+void PeerConnection::ApplyAudioCodecOptions(
+    webrtc::SessionDescriptionInterface& desc) {
+  cricket::SessionDescription* const session_desc = desc.description();
+  if (!session_desc) {
+    return;
+  }
+  cricket::ContentInfos& contents = session_desc->contents();
+  for (auto&& rtp_tr : peer_->GetTransceivers()) {
+    if (rtp_tr->media_type() != cricket::MediaType::MEDIA_TYPE_AUDIO) {
+      continue;
+    }
+    RefPtr<Transceiver> wrapper = FindWrapperFromRtpTransceiver(rtp_tr);
+    if (!wrapper) {
+      continue;
+    }
+    std::map<std::string, std::string> params = wrapper->GetAudioCodecParams();
+    if (params.empty()) {
+      continue;
+    }
+    const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_tr);
+    if ((mline_index < 0) || ((size_t)mline_index >= contents.size())) {
+      continue;
+    }
+    cricket::MediaContentDescription* const media_desc =
+        contents[mline_index].description;
+    if (media_desc) {
+      SdpSetCodecParameters(cricket::kOpusCodecName, params, *media_desc);
+    }
+  }
+}
+
+void PeerConnection::AddTransceiverWrapper(RefPtr<Transceiver> transceiver) {
+  rtc::CritScope lock(&transceivers_mutex_);
+  if (auto rtp_tr = transceiver->impl()) {
+    RTC_DCHECK(transceiver_from_rtp_transceiver_.find(rtp_tr.get()) ==
+               transceiver_from_rtp_transceiver_.end());
+    transceiver_from_rtp_transceiver_.emplace(rtp_tr.get(), transceiver.get());
+  }
+  IndexTransceiver(*transceiver);
+  transceivers_.push_back(std::move(transceiver));
+}
+
+void PeerConnection::IndexTransceiver(Transceiver& transceiver) {
+  if (webrtc::RtpSenderInterface* const sender = transceiver.GetRtpSender()) {
+    transceiver_from_sender_[sender] = &transceiver;
+  }
+  if (webrtc::RtpReceiverInterface* const receiver =
+          transceiver.GetRtpReceiver()) {
+    transceiver_from_receiver_[receiver] = &transceiver;
+  }
+  const int mline_index = transceiver.GetMlineIndex();
+  if (mline_index >= 0) {
+    transceiver_from_mline_index_[mline_index] = &transceiver;
+  }
+}
+
 RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpTransceiver(
     webrtc::RtpTransceiverInterface* rtp_tr) const {
   RTC_DCHECK(rtp_tr);
   rtc::CritScope lock(&transceivers_mutex_);
-  auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                         [&rtp_tr](const RefPtr<Transceiver>& tr) {
-                           return (tr->impl() == rtp_tr);
-                         });
-  if (it != transceivers_.end()) {
-    return *it;
+  auto it = transceiver_from_rtp_transceiver_.find(rtp_tr);
+  if (it != transceiver_from_rtp_transceiver_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpSender(
+    webrtc::RtpSenderInterface* sender) const {
+  RTC_DCHECK(sender);
+  rtc::CritScope lock(&transceivers_mutex_);
+  auto it = transceiver_from_sender_.find(sender);
+  if (it != transceiver_from_sender_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpReceiver(
+    webrtc::RtpReceiverInterface* receiver) const {
+  RTC_DCHECK(receiver);
+  rtc::CritScope lock(&transceivers_mutex_);
+  auto it = transceiver_from_receiver_.find(receiver);
+  if (it != transceiver_from_receiver_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+RefPtr<Transceiver> PeerConnection::FindWrapperFromMlineIndex(
+    int mline_index) const {
+  rtc::CritScope lock(&transceivers_mutex_);
+  auto it = transceiver_from_mline_index_.find(mline_index);
+  if (it != transceiver_from_mline_index_.end()) {
+    return it->second;
   }
   return nullptr;
 }
@@ -1083,16 +1964,9 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
 
   // Try to find an existing |Transceiver| instance for the given RTP receiver
   // of the remote track.
-  {
-    auto it_tr = std::find_if(transceivers_.begin(), transceivers_.end(),
-                              [receiver](const RefPtr<Transceiver>& tr) {
-                                return tr->HasReceiver(receiver);
-                              });
-    if (it_tr != transceivers_.end()) {
-      RTC_DCHECK(media_kind == (*it_tr)->GetMediaKind());
-      Transceiver* transceiver = static_cast<Transceiver*>(it_tr->get());
-      return transceiver;
-    }
+  if (RefPtr<Transceiver> transceiver = FindWrapperFromRtpReceiver(receiver)) {
+    RTC_DCHECK(media_kind == transceiver->GetMediaKind());
+    return transceiver.get();
   }
 
   if (IsUnifiedPlan()) {
@@ -1120,9 +1994,14 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
         ExtractTransceiverStreamIDsFromReceiver(receiver);
 
     // Create a new transceiver wrapper for it
-    return CreateTransceiverUnifiedPlan(media_kind, mline_index,
-                                        std::move(name), std::move(stream_ids),
-                                        std::move(impl));
+    ErrorOr<Transceiver*> transceiver = CreateTransceiverUnifiedPlan(
+        media_kind, mline_index, std::move(name), std::move(stream_ids),
+        std::move(impl));
+    if (transceiver.ok() && !auto_subscribe_.load(std::memory_order_relaxed)) {
+      // Answer without receiving, so that the remote peer does not send.
+      transceiver.value()->SetSubscribed(false);
+    }
+    return transceiver;
   } else {
     RTC_DCHECK(IsPlanB());
     // In Plan B, since there is no guarantee about the order of tracks, they
@@ -1147,15 +2026,15 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
         global_factory_, media_kind, *this, mline_index, name,
         std::move(stream_ids), desired_direction);
     transceiver->SetReceiverPlanB(receiver);
-    {
-      rtc::CritScope lock(&transceivers_mutex_);
-      transceivers_.push_back(transceiver);
+    AddTransceiverWrapper(transceiver);
+    if (!auto_subscribe_.load(std::memory_order_relaxed)) {
+      transceiver->SetSubscribed(false);
     }
 
     // Invoke the TransceiverAdded callback
     {
-      std::lock_guard<std::mutex> lock(callbacks_mutex_);
-      if (auto cb = transceiver_added_callback_) {
+      RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+      if (const auto& cb = callbacks->transceiver_added_callback_) {
         mrsTransceiverAddedInfo info{};
         info.transceiver_handle = transceiver.get();
         info.transceiver_name = name.c_str();
@@ -1172,34 +2051,22 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
 }
 
 void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
-  // Get RTP transceivers sorted by address in memory
   auto rtp_transceivers = peer_->GetTransceivers();
-  std::sort(
-      rtp_transceivers.begin(), rtp_transceivers.end(),
-      [](auto const& t1, auto const& t2) { return (t1.get() < t2.get()); });
-  // Get transceiver wrappers sorted by RTP transceiver address in memory
-  std::vector<RefPtr<Transceiver>> wrappers;
+  size_t num_wrappers;
   {
     rtc::CritScope lock(&transceivers_mutex_);
-    wrappers = transceivers_;
+    num_wrappers = transceivers_.size();
   }
-  std::sort(wrappers.begin(), wrappers.end(),
-            [](auto const& t1, auto const& t2) {
-              return (t1->impl().get() < t2->impl().get());
-            });
-  // Match transceiver wrappers with their implementation, and create wrappers
-  // for the ones without one yet.
-  RTC_DCHECK_GE(rtp_transceivers.size(), wrappers.size());
-  auto it_wrapper = wrappers.begin();
+  RTC_DCHECK_GE(rtp_transceivers.size(), num_wrappers);
   RTC_LOG(LS_INFO) << "Synchronizing " << rtp_transceivers.size()
-                   << " RTP transceivers with " << wrappers.size()
+                   << " RTP transceivers with " << num_wrappers
                    << " transceiver wrappers (remote = " << remote << ").";
+  // Match transceiver wrappers with their implementation, and create wrappers
+  // for the ones without one yet.
   for (auto&& rtp_tr : rtp_transceivers) {
     const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_tr);
-    // Compare the current item on the sorted arrays of RTP transceiver and
-    // transceiver wrappers; if the current items don't match, this means
-    // there's a missing wrapper for an existing RTP transceiver, so create it.
-    if ((it_wrapper == wrappers.end()) || ((*it_wrapper)->impl() != rtp_tr)) {
+    RefPtr<Transceiver> wrapper = FindWrapperFromRtpTransceiver(rtp_tr);
+    if (!wrapper) {
       std::string name = rtp_tr->mid().value_or(std::string{});
       RTC_LOG(LS_INFO) << "Creating new wrapper for RTP transceiver mid='"
                        << name.c_str() << "' (#" << mline_index << ")";
@@ -1213,18 +2080,18 @@ void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
                              "new RTP transceiver.";
         continue;
       }
-      it_wrapper = wrappers.insert(it_wrapper, err.MoveValue());
+      wrapper = err.MoveValue();
     }
-    RTC_DCHECK(it_wrapper != wrappers.end());
     // Ensure the Transceiver object is in sync with its RTP counterpart
-    (*it_wrapper)->OnSessionDescUpdated(remote);
+    wrapper->OnSessionDescUpdated(remote);
     // Check if newly associated
-    if ((*it_wrapper)->GetMlineIndex() != mline_index) {
+    if (wrapper->GetMlineIndex() != mline_index) {
       RTC_DCHECK(mline_index >= 0);
       RTC_DCHECK(!remote);  // already created associated with remote
-      (*it_wrapper)->OnAssociated(mline_index);
+      wrapper->OnAssociated(mline_index);
+      rtc::CritScope lock(&transceivers_mutex_);
+      IndexTransceiver(*wrapper);
     }
-    ++it_wrapper;
   }
 }
 
@@ -1239,13 +2106,10 @@ ErrorOr<Transceiver*> PeerConnection::CreateTransceiverUnifiedPlan(
   RefPtr<Transceiver> transceiver = Transceiver::CreateForUnifiedPlan(
       global_factory_, media_kind, *this, mline_index, std::move(name),
       stream_ids, std::move(rtp_transceiver), desired_direction);
+  AddTransceiverWrapper(transceiver);
   {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
-  {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    if (auto cb = transceiver_added_callback_) {
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    if (const auto& cb = callbacks->transceiver_added_callback_) {
       std::string encoded_stream_ids = Transceiver::EncodeStreamIDs(stream_ids);
       mrsTransceiverAddedInfo info{};
       info.transceiver_handle = transceiver.get();
@@ -1332,6 +2196,34 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
   if (!pc_factory) {
     return Error(Result::kUnknownError);
   }
+  if (config.thread_group > 0) {
+    pc_factory = global_factory->GetPeerConnectionFactory(config.thread_group);
+    if (!pc_factory) {
+      return Error(Result::kInvalidParameter, "Invalid thread group.");
+    }
+  }
+
+  if (config.ice_candidate_pool_size < 0) {
+    return Error(Result::kInvalidParameter,
+                 "Invalid negative ICE candidate pool size.");
+  }
+  if ((config.min_port < 0) || (config.max_port < config.min_port) ||
+      (config.max_port > 65535)) {
+    return Error(Result::kInvalidParameter, "Invalid port range.");
+  }
+  if (config.audio_jitter_buffer_max_packets < 0) {
+    return Error(Result::kInvalidParameter,
+                 "Invalid negative audio jitter buffer size.");
+  }
+  if ((config.data_channel_count > 0) && !config.data_channels) {
+    return Error(Result::kInvalidParameter);
+  }
+  for (uint32_t i = 0; i < config.data_channel_count; ++i) {
+    if (config.data_channels[i].id < 0) {
+      return Error(Result::kInvalidDataChannelId,
+                   "Data channels of the configuration must be negotiated.");
+    }
+  }
 
   // Setup the connection configuration
   webrtc::PeerConnectionInterface::RTCConfiguration rtc_config;
@@ -1343,32 +2235,111 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
   rtc_config.enable_dtls_srtp = true;          // Always true for security
   rtc_config.type = ICETransportTypeToNative(config.ice_transport_type);
   rtc_config.bundle_policy = BundlePolicyToNative(config.bundle_policy);
+  rtc_config.ice_candidate_pool_size = config.ice_candidate_pool_size;
+  if (config.disable_tcp_candidates != mrsBool::kFalse) {
+    rtc_config.tcp_candidate_policy =
+        webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+  }
+  rtc_config.disable_ipv6 = (config.disable_ipv6 != mrsBool::kFalse);
+  rtc_config.disable_link_local_networks =
+      (config.disable_link_local_networks != mrsBool::kFalse);
+  if (CertificatePool* const pool = global_factory->GetCertificatePool()) {
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate = pool->Take(
+        config.certificate_identity ? config.certificate_identity : "");
+    if (certificate) {
+      rtc_config.certificates.push_back(std::move(certificate));
+    }
+  }
+  rtc_config.continual_gathering_policy =
+      ContinualGatheringPolicyToNative(config.continual_gathering_policy);
+  if (config.audio_jitter_buffer_max_packets > 0) {
+    rtc_config.audio_jitter_buffer_max_packets =
+        config.audio_jitter_buffer_max_packets;
+  }
+  rtc_config.audio_jitter_buffer_fast_accelerate =
+      (config.audio_jitter_buffer_fast_accelerate != mrsBool::kFalse);
+  rtc_config.set_dscp(config.enable_dscp != mrsBool::kFalse);
+  {
+    webrtc::CryptoOptions crypto_options;
+    crypto_options.srtp.enable_gcm_crypto_suites =
+        (config.enable_gcm_crypto_suites != mrsBool::kFalse);
+    crypto_options.srtp.enable_aes128_sha1_32_crypto_cipher =
+        (config.enable_aes128_sha1_32_crypto_cipher != mrsBool::kFalse);
+    crypto_options.srtp.enable_encrypted_rtp_header_extensions =
+        (config.enable_encrypted_rtp_header_extensions != mrsBool::kFalse);
+    rtc_config.crypto_options = crypto_options;
+  }
   rtc_config.sdp_semantics =
       (config.sdp_semantic == mrsSdpSemantic::kUnifiedPlan
            ? webrtc::SdpSemantics::kUnifiedPlan
            : webrtc::SdpSemantics::kPlanB);
-  auto peer = new PeerConnection(std::move(global_factory));
+  std::unique_ptr<cricket::PortAllocator> allocator;
+  if (NeedsCustomPortAllocator(config)) {
+    rtc::Thread* const network_thread =
+        global_factory->GetNetworkThread(config.thread_group);
+    if (!network_thread) {
+      return Error(Result::kUnsupported,
+                   "Port range and network interface lists are not "
+                   "supported on this platform.");
+    }
+    allocator = CreatePortAllocator(config, network_thread);
+  }
+  auto peer =
+      new PeerConnection(std::move(global_factory), config.thread_group);
   webrtc::PeerConnectionDependencies dependencies(peer);
+  dependencies.allocator = std::move(allocator);
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> impl =
       pc_factory->CreatePeerConnection(rtc_config, std::move(dependencies));
   if (impl.get() == nullptr) {
     return Error(Result::kUnknownError);
   }
   peer->peer_ = std::move(impl);
-  return RefPtr<PeerConnection>(peer);
+  RefPtr<PeerConnection> peer_ref(peer);
+
+  // Create the negotiated data channels before the connection is handed out,
+  // so that they are all included in the first offer and open as soon as the
+  // SCTP association is established, without DCEP handshake.
+  if (config.data_channel_count > 0) {
+    ErrorOr<std::vector<std::shared_ptr<DataChannel>>> data_channels =
+        peer->AddDataChannels(DataChannelSettings::FromConfigs(
+            config.data_channels, config.data_channel_count));
+    if (!data_channels.ok()) {
+      return data_channels.error();
+    }
+  }
+  return std::move(peer_ref);
 }
 
 void PeerConnection::GetStats(webrtc::RTCStatsCollectorCallback* callback) {
   peer_->GetStats(callback);
 }
 
+bool PeerConnection::GetLegacyStats(webrtc::StatsObserver* observer) {
+  return peer_->GetStats(
+      observer, nullptr,
+      webrtc::PeerConnectionInterface::kStatsOutputLevelStandard);
+}
+
 void PeerConnection::InvokeRenegotiationNeeded() {
   OnRenegotiationNeeded();
 }
 
-PeerConnection::PeerConnection(RefPtr<GlobalFactory> global_factory)
+void PeerConnection::AnnounceRemoteTrack(Transceiver& transceiver) noexcept {
+  if (transceiver.GetMediaKind() == mrsMediaKind::kAudio) {
+    AnnounceRemoteMediaTrack<mrsMediaKind::kAudio>(
+        transceiver, &Callbacks::audio_track_added_callback_);
+  } else {
+    RTC_DCHECK(transceiver.GetMediaKind() == mrsMediaKind::kVideo);
+    AnnounceRemoteMediaTrack<mrsMediaKind::kVideo>(
+        transceiver, &Callbacks::video_track_added_callback_);
+  }
+}
+
+PeerConnection::PeerConnection(RefPtr<GlobalFactory> global_factory,
+                               uint32_t thread_group)
     : TrackedObject(std::move(global_factory), ObjectType::kPeerConnection),
-      audio_mixer_(global_factory_->audio_mixer()) {}
+      signaling_thread_(global_factory_->GetSignalingThread(thread_group)),
+      audio_mixer_(global_factory_->audio_mixer(thread_group)) {}
 
 }  // namespace WebRTC
 }  // namespace MixedReality
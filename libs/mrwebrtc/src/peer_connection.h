@@ -3,13 +3,20 @@
 
 #pragma once
 
+#include <array>
+
 #include "audio_frame_observer.h"
+#include "bandwidth_estimate_monitor.h"
 #include "callback.h"
 #include "data_channel.h"
 #include "media/transceiver.h"
 #include "mrs_errors.h"
+#include "network_probe.h"
 #include "peer_connection_interop.h"
+#include "quality_limitation_monitor.h"
+#include "rcu_snapshot.h"
 #include "refptr.h"
+#include "stats_subscription.h"
 #include "toggle_audio_mixer.h"
 #include "tracked_object.h"
 #include "utils.h"
@@ -39,6 +46,24 @@ struct BitrateSettings {
   absl::optional<int> max_bitrate_bps;
 };
 
+/// Settings of a data channel to create. See
+/// |PeerConnection::AddDataChannel()|.
+struct DataChannelSettings {
+  /// Convert the interop configurations of data channels into their settings.
+  static std::vector<DataChannelSettings> FromConfigs(
+      const mrsDataChannelConfig* configs,
+      uint32_t count);
+
+  int id{-1};
+  std::string label;
+  bool ordered{true};
+  bool reliable{true};
+  bool compressed{false};
+  int max_retransmits{-1};
+  int max_packet_lifetime_ms{-1};
+  mrsDataChannelPriority priority{mrsDataChannelPriority::kLow};
+};
+
 /// The PeerConnection class is the entry point to most of WebRTC.
 /// It encapsulates a single connection between a local peer and a remote peer,
 /// and hosts some critical events for signaling.
@@ -72,13 +97,31 @@ struct BitrateSettings {
 /// establish a connection, in order to perform the first handshake with the
 /// correct tracks offer/answer right away.
 class PeerConnection : public TrackedObject,
-                       public webrtc::PeerConnectionObserver {
+                       public webrtc::PeerConnectionObserver,
+                       public rtc::MessageHandler {
  public:
   /// Create a new PeerConnection based on the given |config|.
   /// This serves as the constructor for PeerConnection.
   static ErrorOr<RefPtr<PeerConnection>> create(
       const mrsPeerConnectionConfiguration& config);
 
+  //
+  // Events
+  //
+  // Each event has at most one registered callback, assigned with the
+  // corresponding |RegisterXxxCallback()| method, and any number of listeners
+  // added with the corresponding |AddXxxListener()| method, which are all
+  // invoked in turn when the event fires. Callbacks are read without any lock,
+  // and may register or remove callbacks and listeners themselves.
+  //
+
+  /// Remove a listener previously added with any of the |AddXxxListener()|
+  /// methods. Once this returns, the listener is never invoked again, unless
+  /// this was called from a callback of this peer connection, in which case
+  /// the event being dispatched may still invoke it. Return |true| if the
+  /// listener was found and removed.
+  bool RemoveListener(CallbackListenerId id) noexcept;
+
   //
   // Signaling
   //
@@ -100,8 +143,16 @@ class PeerConnection : public TrackedObject,
   /// Only one callback can be registered at a time.
   void RegisterLocalSdpReadytoSendCallback(
       LocalSdpReadytoSendCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(local_sdp_ready_to_send_callback_mutex_);
-    local_sdp_ready_to_send_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::local_sdp_ready_to_send_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddLocalSdpReadytoSendListener(
+      LocalSdpReadytoSendCallback callback) noexcept {
+    return AddListener(&Callbacks::local_sdp_ready_to_send_callback_,
+                       std::move(callback));
   }
 
   /// Callback invoked when a local ICE candidate message is ready to be sent to
@@ -116,11 +167,66 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterIceCandidateReadytoSendCallback(
       IceCandidateReadytoSendCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(
-        ice_candidate_ready_to_send_callback_mutex_);
-    ice_candidate_ready_to_send_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::ice_candidate_ready_to_send_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddIceCandidateReadytoSendListener(
+      IceCandidateReadytoSendCallback callback) noexcept {
+    return AddListener(&Callbacks::ice_candidate_ready_to_send_callback_,
+                       std::move(callback));
+  }
+
+  /// Callback invoked when a batch of local ICE candidates is ready to be sent
+  /// to the remote peer via the signalling solution. The first parameter is an
+  /// array of candidates, valid only during the call, and the second one its
+  /// size.
+  using IceCandidatesReadytoSendCallback =
+      Callback<const mrsIceCandidate*, int>;
+
+  /// Register a custom |IceCandidatesReadytoSendCallback| invoked when a batch
+  /// of local ICE candidates is ready to be sent, as configured with
+  /// |SetIceCandidateBatchWindow()|. This is invoked in addition to the
+  /// |IceCandidateReadytoSendCallback|, which still receives each candidate as
+  /// soon as it is gathered. Only one callback can be registered at a time.
+  void RegisterIceCandidatesReadytoSendCallback(
+      IceCandidatesReadytoSendCallback&& callback) noexcept {
+    SetRegisteredCallback(&Callbacks::ice_candidates_ready_to_send_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddIceCandidatesReadytoSendListener(
+      IceCandidatesReadytoSendCallback callback) noexcept {
+    return AddListener(&Callbacks::ice_candidates_ready_to_send_callback_,
+                       std::move(callback));
   }
 
+  /// Set how long local ICE candidates are held before being delivered
+  /// together to the |IceCandidatesReadytoSendCallback|, counted from the
+  /// first candidate of each batch. Zero delivers each candidate on its own as
+  /// soon as it is gathered, and a negative value holds all candidates until
+  /// gathering completes. Any pending batch is always delivered when gathering
+  /// completes, before the |IceGatheringStateChangedCallback| is invoked.
+  void SetIceCandidateBatchWindow(int window_ms) noexcept {
+    ice_candidate_batch_window_ms_.store(window_ms, std::memory_order_relaxed);
+  }
+
+  /// Set whether the transceivers created by applying a remote description
+  /// are subscribed to the media they receive. See
+  /// |mrsPeerConnectionSetAutoSubscribe()|.
+  void SetAutoSubscribe(bool auto_subscribe) noexcept {
+    auto_subscribe_.store(auto_subscribe, std::memory_order_relaxed);
+  }
+
+  /// Invoke the TrackAdded callback for the remote track of a transceiver
+  /// which was just subscribed, if that track was received while
+  /// unsubscribed.
+  void AnnounceRemoteTrack(Transceiver& transceiver) noexcept;
+
   /// Callback invoked when the state of the ICE connection changed.
   /// Note that the current implementation (M71) mixes the state of ICE and
   /// DTLS, so this does not correspond exactly to the ICE connection state of
@@ -131,8 +237,16 @@ class PeerConnection : public TrackedObject,
   /// ICE connection changed. Only one callback can be registered at a time.
   void RegisterIceStateChangedCallback(
       IceStateChangedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(ice_state_changed_callback_mutex_);
-    ice_state_changed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::ice_state_changed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddIceStateChangedListener(
+      IceStateChangedCallback callback) noexcept {
+    return AddListener(&Callbacks::ice_state_changed_callback_,
+                       std::move(callback));
   }
 
   /// Callback invoked when the state of the ICE gathering changed.
@@ -143,9 +257,16 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterIceGatheringStateChangedCallback(
       IceGatheringStateChangedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(
-        ice_gathering_state_changed_callback_mutex_);
-    ice_gathering_state_changed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::ice_gathering_state_changed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddIceGatheringStateChangedListener(
+      IceGatheringStateChangedCallback callback) noexcept {
+    return AddListener(&Callbacks::ice_gathering_state_changed_callback_,
+                       std::move(callback));
   }
 
   /// Callback invoked when some SDP negotiation needs to be initiated, often
@@ -163,8 +284,16 @@ class PeerConnection : public TrackedObject,
   /// renegotiation is needed. Only one callback can be registered at a time.
   void RegisterRenegotiationNeededCallback(
       RenegotiationNeededCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
-    renegotiation_needed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::renegotiation_needed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddRenegotiationNeededListener(
+      RenegotiationNeededCallback callback) noexcept {
+    return AddListener(&Callbacks::renegotiation_needed_callback_,
+                       std::move(callback));
   }
 
   /// Notify the WebRTC engine that an ICE candidate has been received from the
@@ -173,6 +302,14 @@ class PeerConnection : public TrackedObject,
   /// other peer.
   Error AddIceCandidate(const mrsIceCandidate& candidate) noexcept;
 
+  /// Notify the WebRTC engine of several ICE candidates received from the
+  /// remote peer at once, for example a batch delivered by the
+  /// |IceCandidatesReadytoSendCallback| of that peer. All candidates are added
+  /// in order with a single dispatch to the signaling thread. This stops at the
+  /// first candidate which cannot be added, and returns its error; the
+  /// candidates before it remain added.
+  Error AddIceCandidates(const mrsIceCandidate* candidates, int count) noexcept;
+
   /// Callback invoked when |SetRemoteDescriptionAsync()| finished applying a
   /// remote description, successfully or not. The first parameter is the result
   /// of the operation, and the second one contains the error message if the
@@ -200,8 +337,13 @@ class PeerConnection : public TrackedObject,
   /// Register a custom |ConnectedCallback| invoked when the connection is
   /// established. Only one callback can be registered at a time.
   void RegisterConnectedCallback(ConnectedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(connected_callback_mutex_);
-    connected_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::connected_callback_, std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddConnectedListener(ConnectedCallback callback) noexcept {
+    return AddListener(&Callbacks::connected_callback_, std::move(callback));
   }
 
   /// Set the connection bitrate limits. These settings limit the network
@@ -216,8 +358,45 @@ class PeerConnection : public TrackedObject,
 
   /// Create an SDP offer to attempt to establish a connection with the remote
   /// peer. Once the offer message is ready, the |LocalSdpReadytoSendCallback|
-  /// callback is invoked to deliver the message.
-  bool CreateOffer() noexcept;
+  /// callback is invoked to deliver the message. If |ice_restart| is |true|,
+  /// the offer restarts ICE with new credentials, to re-establish the transport
+  /// of an existing session, for example after a network change, while
+  /// keeping all transceivers, data channels, and the DTLS session.
+  bool CreateOffer(bool ice_restart = false) noexcept;
+
+  /// Set the policy to automatically restart ICE when the connection is lost.
+  /// See |mrsPeerConnectionSetIceRestartPolicy()|.
+  void SetIceRestartPolicy(const mrsIceRestartPolicy& policy) noexcept;
+
+  /// Subscribe to periodic stats snapshots, replacing any previous
+  /// subscription, or unsubscribe if |callback| is empty. Once this returns,
+  /// the previous callback is not invoked anymore.
+  /// See |mrsPeerConnectionSubscribeStats()|.
+  Result SubscribeStats(const mrsStatsSubscriptionConfig& config,
+                        StatsSnapshotCallback callback) noexcept;
+
+  /// Subscribe to the bandwidth estimates, replacing any previous
+  /// subscription, or unsubscribe if |callback| is empty. Once this returns,
+  /// the previous callback is not invoked anymore.
+  /// See |mrsPeerConnectionSubscribeBandwidthEstimate()|.
+  Result SubscribeBandwidthEstimate(
+      const mrsBandwidthEstimateConfig& config,
+      BandwidthEstimateCallback callback) noexcept;
+
+  /// Start a network probe, delivering its result to |callback| once done.
+  /// See |mrsPeerConnectionProbeNetwork()|.
+  Result ProbeNetwork(const mrsNetworkProbeConfig& config,
+                      NetworkProbeCallback callback) noexcept;
+
+  /// Subscribe to the quality limitation changes of the video sender of a
+  /// transceiver, replacing any previous subscription for that transceiver, or
+  /// unsubscribe if |callback| is empty. Once this returns, the previous
+  /// callback is not invoked anymore.
+  /// See |mrsTransceiverSubscribeQualityLimitation()|.
+  Result SubscribeQualityLimitation(
+      Transceiver& transceiver,
+      const mrsQualityLimitationConfig& config,
+      QualityLimitationCallback callback) noexcept;
 
   /// Create an SDP answer to accept a previously-received offer to establish a
   /// connection wit the remote peer. Once the answer message is ready, the
@@ -229,10 +408,36 @@ class PeerConnection : public TrackedObject,
   /// object instead to create a new connection. No-op if already closed.
   void Close() noexcept;
 
+  /// Close several connections, like |Close()|. The connections using
+  /// different signaling threads are closed concurrently on separate threads.
+  /// This waits at most |timeout_ms| milliseconds, or indefinitely if
+  /// negative, and returns |Result::kTimeout| if some connections are still
+  /// closing by then, in which case they finish closing in the background.
+  static Result CloseMany(std::vector<RefPtr<PeerConnection>> peers,
+                          int timeout_ms) noexcept;
+
   /// Check if the connection is closed. This returns |true| once |Close()| has
   /// been called.
   bool IsClosed() const noexcept;
 
+  /// Start gathering ICE candidates ahead of the negotiation, by growing the
+  /// pool of pre-gathered candidates to at least |pool_size|. This must be
+  /// called before the first local description is created, after which the
+  /// pool cannot be changed anymore.
+  Error PrewarmIce(int pool_size) noexcept;
+
+  /// Start a batch of changes, for example adding several transceivers,
+  /// during which the renegotiation needed event is not raised. If the event
+  /// was raised during the batch, it is raised once when the batch ends, so
+  /// that all changes are negotiated with a single offer. Batches can be
+  /// nested, in which case only the outermost one raises the event.
+  void BeginBatchUpdate() noexcept;
+
+  /// End a batch started with |BeginBatchUpdate()|, and raise the pending
+  /// renegotiation needed event, if any, if this was the outermost batch. This
+  /// fails with |Result::kInvalidOperation| if no batch was started.
+  Result EndBatchUpdate() noexcept;
+
   //
   // Transceivers
   //
@@ -245,8 +450,16 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterTransceiverAddedCallback(
       TransceiverAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    transceiver_added_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::transceiver_added_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddTransceiverAddedListener(
+      TransceiverAddedCallback callback) noexcept {
+    return AddListener(&Callbacks::transceiver_added_callback_,
+                       std::move(callback));
   }
 
   /// Add a new audio or video transceiver to the peer connection.
@@ -268,8 +481,16 @@ class PeerConnection : public TrackedObject,
   /// at a time.
   void RegisterVideoTrackAddedCallback(
       VideoTrackAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    video_track_added_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::video_track_added_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddVideoTrackAddedListener(
+      VideoTrackAddedCallback callback) noexcept {
+    return AddListener(&Callbacks::video_track_added_callback_,
+                       std::move(callback));
   }
 
   /// Callback invoked when a remote video track is removed from the peer
@@ -282,8 +503,16 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterVideoTrackRemovedCallback(
       VideoTrackRemovedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    video_track_removed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::video_track_removed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddVideoTrackRemovedListener(
+      VideoTrackRemovedCallback callback) noexcept {
+    return AddListener(&Callbacks::video_track_removed_callback_,
+                       std::move(callback));
   }
 
   /// Rounding mode of video frame height for |SetFrameHeightRoundMode()|.
@@ -311,7 +540,9 @@ class PeerConnection : public TrackedObject,
   /// Defaults to FrameHeightRoundMode::kCrop to avoid severe artifacts produced
   /// by the H.264 hardware encoder on HoloLens 1 due to a bug. The default
   /// value is applied when creating the first peer connection, so can be
-  /// overridden with |SetFrameHeightRoundMode()| after that.
+  /// overridden with |SetFrameHeightRoundMode()| after that. Local video
+  /// tracks can round their frames themselves for any encoder instead, see
+  /// |FrameHeightRoundingAdapter|.
   static void SetFrameHeightRoundMode(FrameHeightRoundMode value);
 
   //
@@ -327,8 +558,16 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterAudioTrackAddedCallback(
       AudioTrackAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    audio_track_added_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::audio_track_added_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddAudioTrackAddedListener(
+      AudioTrackAddedCallback callback) noexcept {
+    return AddListener(&Callbacks::audio_track_added_callback_,
+                       std::move(callback));
   }
 
   /// Callback invoked when a remote audio track is removed from the peer
@@ -341,8 +580,16 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterAudioTrackRemovedCallback(
       AudioTrackRemovedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    audio_track_removed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::audio_track_removed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddAudioTrackRemovedListener(
+      AudioTrackRemovedCallback callback) noexcept {
+    return AddListener(&Callbacks::audio_track_removed_callback_,
+                       std::move(callback));
   }
 
   //
@@ -362,8 +609,16 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterDataChannelAddedCallback(
       DataChannelAddedCallback callback) noexcept {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    data_channel_added_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::data_channel_added_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddDataChannelAddedListener(
+      DataChannelAddedCallback callback) noexcept {
+    return AddListener(&Callbacks::data_channel_added_callback_,
+                       std::move(callback));
   }
 
   /// Register a custom callback invoked when a data channel is removed by the
@@ -371,16 +626,63 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterDataChannelRemovedCallback(
       DataChannelRemovedCallback callback) noexcept {
-    std::lock_guard<std::mutex> lock(data_channel_removed_callback_mutex_);
-    data_channel_removed_callback_ = std::move(callback);
+    SetRegisteredCallback(&Callbacks::data_channel_removed_callback_,
+                          std::move(callback));
+  }
+
+  /// Add a listener of the same event, invoked in addition to the registered
+  /// callback. See |RemoveListener()|.
+  CallbackListenerId AddDataChannelRemovedListener(
+      DataChannelRemovedCallback callback) noexcept {
+    return AddListener(&Callbacks::data_channel_removed_callback_,
+                       std::move(callback));
   }
 
   /// Create a new data channel and add it to the peer connection.
   /// This invokes the DataChannelAdded callback.
-  ErrorOr<std::shared_ptr<DataChannel>> AddDataChannel(int id,
-                                                       absl::string_view label,
-                                                       bool ordered,
-                                                       bool reliable) noexcept;
+  ErrorOr<std::shared_ptr<DataChannel>> AddDataChannel(
+      int id,
+      absl::string_view label,
+      bool ordered,
+      bool reliable,
+      bool compressed = false,
+      int max_retransmits = -1,
+      int max_packet_lifetime_ms = -1,
+      mrsDataChannelPriority priority = mrsDataChannelPriority::kLow) noexcept;
+
+  /// Create several data channels at once, in a single dispatch to the
+  /// signaling thread. All settings are validated before any channel is
+  /// created. If the creation of a channel fails, the channels already created
+  /// are kept and announced, and the error is returned.
+  /// This invokes the DataChannelAdded callback for each data channel.
+  ErrorOr<std::vector<std::shared_ptr<DataChannel>>> AddDataChannels(
+      std::vector<DataChannelSettings> settings) noexcept;
+
+  /// Callback fired once a batch of data channels added with
+  /// |AddDataChannelsAsync()| is created, with the handles of the channels
+  /// created, in order. On error, only the channels created before the error
+  /// are reported.
+  using DataChannelsAddedCallback =
+      Callback<mrsResult, const mrsDataChannelHandle*, uint32_t>;
+
+  /// Same as |AddDataChannels()|, but without blocking on the signaling
+  /// thread. The settings are validated before this returns, and the channels
+  /// are created later on the signaling thread, where the callback is invoked
+  /// after their DataChannelAdded callbacks. Batches not created yet when the
+  /// peer connection is closed fail with |Result::kPeerConnectionClosed|.
+  Error AddDataChannelsAsync(std::vector<DataChannelSettings> settings,
+                             DataChannelsAddedCallback callback) noexcept;
+
+  /// Set the limits of the data channels created from now on. See
+  /// |mrsPeerConnectionSetDataChannelLimits()|.
+  void SetDataChannelLimits(const mrsDataChannelLimits& limits) noexcept {
+    std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    data_channel_limits_ = limits;
+  }
+
+  /// Get the data channel with the given ID, if any. Data channels opened
+  /// locally without pre-negotiated ID are not found.
+  std::shared_ptr<DataChannel> GetDataChannelById(int id) noexcept;
 
   /// Close a given data channel and remove it from the peer connection.
   /// This invokes the DataChannelRemoved callback.
@@ -395,13 +697,32 @@ class PeerConnection : public TrackedObject,
   /// automatically by non-negotiated data channels; do not call manually.
   void OnDataChannelAdded(const DataChannel& data_channel) noexcept;
 
+  /// Notification from a data channel that it has data queued or buffered by
+  /// the transport at the given priority, or not anymore. Once no channel of a
+  /// priority has data pending, the send queues of the lower priorities resume
+  /// draining.
+  void OnDataChannelSendPending(mrsDataChannelPriority priority,
+                                bool pending) noexcept;
+
+  /// Check whether a data channel of a higher priority than |priority| has
+  /// data pending, in which case the channels of |priority| hold the messages
+  /// of their send queue back.
+  MRS_NODISCARD bool HasDataChannelSendPendingAbove(
+      mrsDataChannelPriority priority) const noexcept;
+
   void OnStreamChanged(
       rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) noexcept;
 
   // Internal use.
   void GetStats(webrtc::RTCStatsCollectorCallback* callback);
+  bool GetLegacyStats(webrtc::StatsObserver* observer);
   void InvokeRenegotiationNeeded();
 
+  /// Get the audio mixer of the thread group serving the connection.
+  rtc::scoped_refptr<ToggleAudioMixer> audio_mixer() const {
+    return audio_mixer_;
+  }
+
   //
   // PeerConnectionObserver interface
   //
@@ -459,6 +780,21 @@ class PeerConnection : public TrackedObject,
 
   void OnLocalDescCreated(webrtc::SessionDescriptionInterface* desc) noexcept;
 
+  /// Apply the codec preferences of the transceivers to their media line in a
+  /// local description just created, before it is applied.
+  void ApplyCodecPreferences(webrtc::SessionDescriptionInterface& desc);
+
+  /// Apply the audio codec options of the transceivers to their media line in
+  /// a local description just created or a remote description just received,
+  /// before it is applied.
+  void ApplyAudioCodecOptions(webrtc::SessionDescriptionInterface& desc);
+
+  //
+  // MessageHandler interface
+  //
+
+  void OnMessage(rtc::Message* message) override;
+
   //
   // Internal
   //
@@ -468,75 +804,185 @@ class PeerConnection : public TrackedObject,
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_;
 
  protected:
-  /// User callback invoked when the peer connection received a new data channel
-  /// from the remote peer and added it locally.
-  DataChannelAddedCallback data_channel_added_callback_
-      RTC_GUARDED_BY(data_channel_added_callback_mutex_);
-
-  /// User callback invoked when the peer connection received a data channel
-  /// remove message from the remote peer and removed it locally.
-  DataChannelRemovedCallback data_channel_removed_callback_
-      RTC_GUARDED_BY(data_channel_removed_callback_mutex_);
-
-  /// User callback invoked when a transceiver is added to the peer connection,
-  /// whether manually with |AddTransceiver()| or automatically during
-  /// |SetRemoteDescription()|.
-  TransceiverAddedCallback transceiver_added_callback_
-      RTC_GUARDED_BY(callbacks_mutex_);
-
-  /// User callback invoked when the peer connection is established.
-  /// This is generally invoked even if ICE didn't finish.
-  ConnectedCallback connected_callback_
-      RTC_GUARDED_BY(connected_callback_mutex_);
-
-  /// User callback invoked when a local SDP message has been crafted by the
-  /// core engine and is ready to be sent by the signaling solution.
-  LocalSdpReadytoSendCallback local_sdp_ready_to_send_callback_
-      RTC_GUARDED_BY(local_sdp_ready_to_send_callback_mutex_);
-
-  /// User callback invoked when a local ICE message has been crafted by the
-  /// core engine and is ready to be sent by the signaling solution.
-  IceCandidateReadytoSendCallback ice_candidate_ready_to_send_callback_
-      RTC_GUARDED_BY(ice_candidate_ready_to_send_callback_mutex_);
-
-  /// User callback invoked when the ICE connection state changed.
-  IceStateChangedCallback ice_state_changed_callback_
-      RTC_GUARDED_BY(ice_state_changed_callback_mutex_);
-
-  /// User callback invoked when the ICE gathering state changed.
-  IceGatheringStateChangedCallback ice_gathering_state_changed_callback_
-      RTC_GUARDED_BY(ice_gathering_state_changed_callback_mutex_);
-
-  /// User callback invoked when SDP renegotiation is needed.
-  RenegotiationNeededCallback renegotiation_needed_callback_
-      RTC_GUARDED_BY(renegotiation_needed_callback_mutex_);
-
-  /// User callback invoked when a remote audio track is added.
-  AudioTrackAddedCallback audio_track_added_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
-
-  /// User callback invoked when a remote audio track is removed.
-  AudioTrackRemovedCallback audio_track_removed_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
-
-  /// User callback invoked when a remote video track is added.
-  VideoTrackAddedCallback video_track_added_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
-
-  /// User callback invoked when a remote video track is removed.
-  VideoTrackRemovedCallback video_track_removed_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
-
-  std::mutex data_channel_added_callback_mutex_;
-  std::mutex data_channel_removed_callback_mutex_;
-  std::mutex callbacks_mutex_;
-  std::mutex connected_callback_mutex_;
-  std::mutex local_sdp_ready_to_send_callback_mutex_;
-  std::mutex ice_candidate_ready_to_send_callback_mutex_;
-  std::mutex ice_state_changed_callback_mutex_;
-  std::mutex ice_gathering_state_changed_callback_mutex_;
-  std::mutex renegotiation_needed_callback_mutex_;
-  std::mutex media_track_callback_mutex_;
+  /// Registered callbacks and listeners of all events, each list holding the
+  /// registered callback under |kRegisteredCallbackId| if any.
+  struct Callbacks {
+    /// Callbacks invoked when the peer connection received a new data
+    /// channel from the remote peer and added it locally.
+    CallbackList<DataChannelAddedCallback> data_channel_added_callback_;
+
+    /// Callbacks invoked when the peer connection received a data channel
+    /// remove message from the remote peer and removed it locally.
+    CallbackList<DataChannelRemovedCallback> data_channel_removed_callback_;
+
+    /// Callbacks invoked when a transceiver is added to the peer connection,
+    /// whether manually with |AddTransceiver()| or automatically during
+    /// |SetRemoteDescription()|.
+    CallbackList<TransceiverAddedCallback> transceiver_added_callback_;
+
+    /// Callbacks invoked when the peer connection is established.
+    /// This is generally invoked even if ICE didn't finish.
+    CallbackList<ConnectedCallback> connected_callback_;
+
+    /// Callbacks invoked when a local SDP message has been crafted by the
+    /// core engine and is ready to be sent by the signaling solution.
+    CallbackList<LocalSdpReadytoSendCallback> local_sdp_ready_to_send_callback_;
+
+    /// Callbacks invoked when a local ICE message has been crafted by the
+    /// core engine and is ready to be sent by the signaling solution.
+    CallbackList<IceCandidateReadytoSendCallback>
+        ice_candidate_ready_to_send_callback_;
+
+    /// Callbacks invoked when a batch of local ICE messages is ready to be
+    /// sent by the signaling solution.
+    CallbackList<IceCandidatesReadytoSendCallback>
+        ice_candidates_ready_to_send_callback_;
+
+    /// Callbacks invoked when the ICE connection state changed.
+    CallbackList<IceStateChangedCallback> ice_state_changed_callback_;
+
+    /// Callbacks invoked when the ICE gathering state changed.
+    CallbackList<IceGatheringStateChangedCallback>
+        ice_gathering_state_changed_callback_;
+
+    /// Callbacks invoked when SDP renegotiation is needed.
+    CallbackList<RenegotiationNeededCallback> renegotiation_needed_callback_;
+
+    /// Callbacks invoked when a remote audio track is added.
+    CallbackList<AudioTrackAddedCallback> audio_track_added_callback_;
+
+    /// Callbacks invoked when a remote audio track is removed.
+    CallbackList<AudioTrackRemovedCallback> audio_track_removed_callback_;
+
+    /// Callbacks invoked when a remote video track is added.
+    CallbackList<VideoTrackAddedCallback> video_track_added_callback_;
+
+    /// Callbacks invoked when a remote video track is removed.
+    CallbackList<VideoTrackRemovedCallback> video_track_removed_callback_;
+  };
+
+  /// Identifier of the callback assigned by the |RegisterXxxCallback()|
+  /// methods in each list.
+  static constexpr CallbackListenerId kRegisteredCallbackId = 0;
+
+  /// Assign the registered callback of an event, or remove it if |callback| is
+  /// empty.
+  template <typename CallbackT>
+  void SetRegisteredCallback(CallbackList<CallbackT> Callbacks::*list,
+                             CallbackT callback) noexcept {
+    callbacks_.Update([list, &callback](Callbacks& callbacks) {
+      (callbacks.*list).Set(kRegisteredCallbackId, std::move(callback));
+    });
+  }
+
+  /// Add a listener of an event with a new identifier, or return zero if
+  /// |callback| is empty. This doesn't wait for the events being dispatched,
+  /// so it never blocks behind a callback in progress.
+  template <typename CallbackT>
+  CallbackListenerId AddListener(CallbackList<CallbackT> Callbacks::*list,
+                                 CallbackT callback) noexcept {
+    if (!callback) {
+      return 0;
+    }
+    const CallbackListenerId id = next_listener_id_.fetch_add(1);
+    callbacks_.Publish([list, id, &callback](Callbacks& callbacks) {
+      (callbacks.*list).Set(id, std::move(callback));
+    });
+    return id;
+  }
+
+  /// Callbacks and listeners of all events. These are read on the signaling
+  /// thread for each event without any lock, and rarely modified.
+  RcuSnapshot<Callbacks> callbacks_;
+
+  /// Identifier of the next listener added with any |AddXxxListener()|.
+  std::atomic<CallbackListenerId> next_listener_id_{1};
+
+  /// Local ICE candidate held until its batch is delivered.
+  struct PendingIceCandidate {
+    std::string sdp_mid;
+    std::string content;
+    int sdp_mline_index;
+  };
+
+  /// Deliver the pending batch of local ICE candidates, if any.
+  void FlushIceCandidates() noexcept;
+
+  /// Restart ICE if the connection is still lost, according to
+  /// |ice_restart_policy_|.
+  void RestartIceIfNeeded() noexcept;
+
+  /// Validate the settings of data channels to add, and convert them into the
+  /// WebRTC configurations of the channels.
+  Error PrepareDataChannels(
+      const std::vector<DataChannelSettings>& settings,
+      std::vector<webrtc::DataChannelInit>& configs) noexcept;
+
+  /// Create validated data channels and invoke their DataChannelAdded
+  /// callbacks. This must be called on the signaling thread.
+  Error CreateDataChannels(
+      const std::vector<DataChannelSettings>& settings,
+      const std::vector<webrtc::DataChannelInit>& configs,
+      std::vector<std::shared_ptr<DataChannel>>& data_channels) noexcept;
+
+  /// Create the batches of data channels added with |AddDataChannelsAsync()|,
+  /// or fail them if the peer connection is closed.
+  void AddPendingDataChannels() noexcept;
+
+  /// Drain the send queues of all data channels, from the highest priority to
+  /// the lowest, once the channels of a priority have no data pending anymore.
+  void DrainDataChannels() noexcept;
+
+  /// Batch window of local ICE candidates, in milliseconds. See
+  /// |SetIceCandidateBatchWindow()|.
+  std::atomic<int> ice_candidate_batch_window_ms_{0};
+
+  /// Subscription of the transceivers created by applying a remote
+  /// description. See |SetAutoSubscribe()|.
+  std::atomic_bool auto_subscribe_{true};
+
+  /// Local ICE candidates of the batch being collected. This and
+  /// |ice_candidate_flush_posted_| are only accessed on the signaling thread.
+  std::vector<PendingIceCandidate> pending_ice_candidates_;
+
+  /// Whether a message is posted to deliver |pending_ice_candidates_| at the
+  /// end of the batch window.
+  bool ice_candidate_flush_posted_{false};
+
+  /// Policy to automatically restart ICE. This and |ice_restart_attempts_| are
+  /// only accessed on the signaling thread.
+  mrsIceRestartPolicy ice_restart_policy_{};
+
+  /// Number of automatic ICE restarts since the connection was last
+  /// established.
+  int ice_restart_attempts_{0};
+
+  /// Periodic stats subscription, if any. Only accessed on the signaling
+  /// thread.
+  std::shared_ptr<StatsSubscription> stats_subscription_;
+
+  /// Bandwidth estimate subscription, if any. Only accessed on the signaling
+  /// thread.
+  std::shared_ptr<BandwidthEstimateMonitor> bandwidth_estimate_monitor_;
+
+  /// Network probe running, if any. Only accessed on the signaling thread.
+  std::shared_ptr<NetworkProbe> network_probe_;
+
+  /// Quality limitation subscriptions, at most one per transceiver. Only
+  /// accessed on the signaling thread.
+  std::vector<std::shared_ptr<QualityLimitationMonitor>>
+      quality_limitation_monitors_;
+
+  /// Mutex for the batch update state.
+  std::mutex batch_update_mutex_;
+
+  /// Number of nested batches started with |BeginBatchUpdate()| and not ended
+  /// yet.
+  int batch_update_depth_ RTC_GUARDED_BY(batch_update_mutex_){0};
+
+  /// The renegotiation needed event was raised during the current batch.
+  bool renegotiation_needed_pending_ RTC_GUARDED_BY(batch_update_mutex_) =
+      false;
 
   class StreamObserver : public webrtc::ObserverInterface {
    public:
@@ -563,6 +1009,19 @@ class PeerConnection : public TrackedObject,
   std::vector<RefPtr<Transceiver>> transceivers_
       RTC_GUARDED_BY(transceivers_mutex_);
 
+  /// Indexes of the transceivers of |transceivers_| by RTP transceiver, RTP
+  /// sender, RTP receiver, and media line index, for constant-time lookup.
+  /// Transceivers are only destroyed on |Close()|, so the indexes hold raw
+  /// pointers to the instances kept alive by |transceivers_|.
+  std::unordered_map<webrtc::RtpTransceiverInterface*, Transceiver*>
+      transceiver_from_rtp_transceiver_ RTC_GUARDED_BY(transceivers_mutex_);
+  std::unordered_map<webrtc::RtpSenderInterface*, Transceiver*>
+      transceiver_from_sender_ RTC_GUARDED_BY(transceivers_mutex_);
+  std::unordered_map<webrtc::RtpReceiverInterface*, Transceiver*>
+      transceiver_from_receiver_ RTC_GUARDED_BY(transceivers_mutex_);
+  std::unordered_map<int, Transceiver*> transceiver_from_mline_index_
+      RTC_GUARDED_BY(transceivers_mutex_);
+
   /// Mutex for the collections of transceivers.
   rtc::CriticalSection transceivers_mutex_;
 
@@ -581,9 +1040,27 @@ class PeerConnection : public TrackedObject,
   std::unordered_multimap<std::string, std::shared_ptr<DataChannel>>
       data_channel_from_label_ RTC_GUARDED_BY(data_channel_mutex_);
 
+  /// Batch of data channels added with |AddDataChannelsAsync()|.
+  struct PendingDataChannels {
+    std::vector<DataChannelSettings> settings;
+    std::vector<webrtc::DataChannelInit> configs;
+    DataChannelsAddedCallback callback;
+  };
+
+  /// Batches of data channels waiting to be created on the signaling thread.
+  std::vector<PendingDataChannels> pending_data_channels_
+      RTC_GUARDED_BY(data_channel_mutex_);
+
+  /// Limits of the data channels created. See |SetDataChannelLimits()|.
+  mrsDataChannelLimits data_channel_limits_ RTC_GUARDED_BY(data_channel_mutex_);
+
   /// Mutex for data structures related to data channels.
   std::mutex data_channel_mutex_;
 
+  /// Number of data channels with data pending to send, per priority. This is
+  /// updated on the signaling thread, except when a channel is removed.
+  std::array<std::atomic<int>, 4> data_channel_send_pending_{};
+
   /// Flag to indicate if SCTP was negotiated during the initial SDP handshake
   /// (m=application), which allows subsequently to use data channels. If this
   /// is false then data channels will never connnect. This is set to true if a
@@ -596,10 +1073,13 @@ class PeerConnection : public TrackedObject,
   /// looks like this is only a problem for negotiated (out-of-band) channels.
   bool sctp_negotiated_ = true;
 
+  /// Signaling thread of the thread group serving the connection.
+  rtc::Thread* const signaling_thread_;
+
   rtc::scoped_refptr<ToggleAudioMixer> audio_mixer_;
 
  private:
-  PeerConnection(RefPtr<GlobalFactory> global_factory);
+  PeerConnection(RefPtr<GlobalFactory> global_factory, uint32_t thread_group);
   PeerConnection(const PeerConnection&) = delete;
   ~PeerConnection() noexcept { Close(); }
   PeerConnection& operator=(const PeerConnection&) = delete;
@@ -613,11 +1093,32 @@ class PeerConnection : public TrackedObject,
             webrtc::SdpSemantics::kUnifiedPlan);
   }
 
+  /// Add a new transceiver to |transceivers_| and to its indexes.
+  void AddTransceiverWrapper(RefPtr<Transceiver> transceiver);
+
+  /// Add the current RTP sender, RTP receiver, and media line index of a
+  /// transceiver already in |transceivers_| to its indexes, after any of them
+  /// changed. This must be called with |transceivers_mutex_| held.
+  void IndexTransceiver(Transceiver& transceiver);
+
   /// Find the |Transceiver| wrapper of an RTP transceiver, or |nullptr| if the
   /// RTP transceiver doesn't have a wrapper yet.
   RefPtr<Transceiver> FindWrapperFromRtpTransceiver(
       webrtc::RtpTransceiverInterface* tr) const;
 
+  /// Find the |Transceiver| wrapper owning an RTP sender, or |nullptr| if none.
+  RefPtr<Transceiver> FindWrapperFromRtpSender(
+      webrtc::RtpSenderInterface* sender) const;
+
+  /// Find the |Transceiver| wrapper owning an RTP receiver, or |nullptr| if
+  /// none.
+  RefPtr<Transceiver> FindWrapperFromRtpReceiver(
+      webrtc::RtpReceiverInterface* receiver) const;
+
+  /// Find the |Transceiver| wrapper associated with a media line, or |nullptr|
+  /// if none.
+  RefPtr<Transceiver> FindWrapperFromMlineIndex(int mline_index) const;
+
   /// Extract the media line index from an RTP transceiver, or -1 if not
   /// associated.
   static int ExtractMlineIndexFromRtpTransceiver(
@@ -683,12 +1184,12 @@ class PeerConnection : public TrackedObject,
         mrsRemoteAudioTrackHandle track_handle,
         mrsTransceiverHandle transceiver_handle,
         const char* track_name,
-        const MediaTrackAddedCallbackT& callback) noexcept {
+        const CallbackList<MediaTrackAddedCallbackT>& callbacks) noexcept {
       mrsRemoteAudioTrackAddedInfo info{};
       info.track_handle = track_handle;
       info.audio_transceiver_handle = transceiver_handle;
       info.track_name = track_name;
-      callback(&info);
+      callbacks(&info);
     }
   };
 
@@ -707,12 +1208,12 @@ class PeerConnection : public TrackedObject,
         mrsRemoteVideoTrackHandle track_handle,
         mrsTransceiverHandle transceiver_handle,
         const char* track_name,
-        const MediaTrackAddedCallbackT& callback) noexcept {
+        const CallbackList<MediaTrackAddedCallbackT>& callbacks) noexcept {
       mrsRemoteVideoTrackAddedInfo info{};
       info.track_handle = track_handle;
       info.audio_transceiver_handle = transceiver_handle;
       info.track_name = track_name;
-      callback(&info);
+      callbacks(&info);
     }
   };
 
@@ -724,8 +1225,8 @@ class PeerConnection : public TrackedObject,
   AddRemoteMediaTrack(
       rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
       webrtc::RtpReceiverInterface* receiver,
-      typename MediaTrait<MEDIA_KIND>::MediaTrackAddedCallbackT*
-          track_added_cb) {
+      CallbackList<typename MediaTrait<MEDIA_KIND>::MediaTrackAddedCallbackT>
+          Callbacks::*track_added_cb) {
     using Media = MediaTrait<MEDIA_KIND>;
 
     rtc::scoped_refptr<typename Media::RtcMediaTrackInterfaceT> media_track(
@@ -752,56 +1253,70 @@ class PeerConnection : public TrackedObject,
                                           std::move(receiver));
 
     // Invoke the TrackAdded callback, which will set the native handle on the
-    // interop wrapper (if created above)
-    {
-      std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-      // Read the function pointer inside the lock to avoid race condition
-      auto cb = *track_added_cb;
-      if (cb) {
-        Media::ExecTrackAdded(remote_media_track.get(), transceiver,
-                              remote_media_track->GetName().c_str(), cb);
-      }
+    // interop wrapper (if created above). While the transceiver is
+    // unsubscribed, the track is not decoded and this is deferred until
+    // subscribing.
+    transceiver->ApplySubscriptionToRemoteTrack();
+    if (transceiver->IsSubscribed()) {
+      AnnounceRemoteMediaTrack<MEDIA_KIND>(*transceiver, track_added_cb);
     }
     return remote_media_track;
   }
 
+  /// Invoke the TrackAdded callback for the remote media (audio or video)
+  /// track of a transceiver, unless it has no remote track or it was already
+  /// announced.
+  template <mrsMediaKind MEDIA_KIND>
+  void AnnounceRemoteMediaTrack(
+      Transceiver& transceiver,
+      CallbackList<typename MediaTrait<MEDIA_KIND>::MediaTrackAddedCallbackT>
+          Callbacks::*track_added_cb) {
+    using Media = MediaTrait<MEDIA_KIND>;
+    RefPtr<typename Media::RemoteMediaTrackT> media_track(
+        static_cast<typename Media::RemoteMediaTrackT*>(
+            transceiver.GetRemoteTrack()));
+    if (!media_track || !transceiver.MarkRemoteTrackAnnounced()) {
+      return;
+    }
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    const auto& cb = (*callbacks).*track_added_cb;
+    if (cb) {
+      Media::ExecTrackAdded(media_track.get(), &transceiver,
+                            media_track->GetName().c_str(), cb);
+    }
+  }
+
   /// Destroy an existing remote media (audio or video) track wrapper for an
   /// existing RTP media receiver which stopped receiving (Unified Plan) or is
   /// about to be destroyed itself (Plan B).
   template <mrsMediaKind MEDIA_KIND>
   void RemoveRemoteMediaTrack(
       webrtc::RtpReceiverInterface* receiver,
-      typename MediaTrait<MEDIA_KIND>::MediaTrackRemovedCallbackT*
-          track_removed_cb) {
+      CallbackList<typename MediaTrait<MEDIA_KIND>::MediaTrackRemovedCallbackT>
+          Callbacks::*track_removed_cb) {
     using Media = MediaTrait<MEDIA_KIND>;
 
     rtc::CritScope tracks_lock(&transceivers_mutex_);
-    auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                           [receiver](const RefPtr<Transceiver>& tr) {
-                             return tr->HasReceiver(receiver);
-                           });
-    if (it == transceivers_.end()) {
+    auto it = transceiver_from_receiver_.find(receiver);
+    if (it == transceiver_from_receiver_.end()) {
       RTC_LOG(LS_ERROR)
           << "Trying to remove receiver " << receiver->id().c_str()
           << " from peer connection " << GetName()
           << " but no transceiver was found which owns such receiver.";
       return;
     }
-    RefPtr<Transceiver> transceiver = *it;
+    RefPtr<Transceiver> transceiver = it->second;
     RTC_DCHECK(transceiver->GetMediaKind() == MEDIA_KIND);
     RefPtr<typename Media::RemoteMediaTrackT> media_track(
         static_cast<typename Media::RemoteMediaTrackT*>(
             transceiver->GetRemoteTrack()));
     media_track->OnTrackRemoved(*this);
 
-    // Invoke the TrackRemoved callback
-    {
-      std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-      // Read the function pointer inside the lock to avoid race condition
-      auto cb = *track_removed_cb;
-      if (cb) {
-        cb(media_track.get(), transceiver.get());
-      }
+    // Invoke the TrackRemoved callback, unless the track was never announced
+    // because the transceiver was unsubscribed.
+    if (transceiver->ClearRemoteTrackAnnounced()) {
+      RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+      ((*callbacks).*track_removed_cb)(media_track.get(), transceiver.get());
     }
     // |media_track| goes out of scope and destroys the C++ instance
   }
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "port_allocator.h"
+
+#include "absl/strings/ascii.h"
+#include "p2p/base/basicpacketsocketfactory.h"
+#include "p2p/client/basicportallocator.h"
+#include "rtc_base/network.h"
+#include "rtc_base/stringencode.h"
+
+#include "utils.h"
+
+namespace {
+
+/// Parse a semicolon-separated list of interface name patterns, lowercased
+/// for case-insensitive matching.
+std::vector<std::string> ParseInterfaceList(const char* list) {
+  std::vector<std::string> patterns;
+  if (Microsoft::MixedReality::WebRTC::IsStringNullOrEmpty(list)) {
+    return patterns;
+  }
+  rtc::split(list, ';', &patterns);
+  for (std::string& pattern : patterns) {
+    pattern = absl::AsciiStrToLower(pattern);
+  }
+  patterns.erase(std::remove(patterns.begin(), patterns.end(), std::string{}),
+                 patterns.end());
+  return patterns;
+}
+
+/// Network manager only reporting the network interfaces allowed by the
+/// configuration of a peer connection.
+class FilteringNetworkManager : public rtc::BasicNetworkManager {
+ public:
+  FilteringNetworkManager(std::vector<std::string> allowlist,
+                          std::vector<std::string> denylist) noexcept
+      : allowlist_(std::move(allowlist)), denylist_(std::move(denylist)) {}
+
+  void GetNetworks(NetworkList* networks) const override {
+    rtc::BasicNetworkManager::GetNetworks(networks);
+    networks->erase(
+        std::remove_if(networks->begin(), networks->end(),
+                       [this](const rtc::Network* network) {
+                         return !IsAllowed(*network);
+                       }),
+        networks->end());
+  }
+
+ private:
+  /// Check if any pattern of a list is part of the name or the description of
+  /// an interface. On Windows the name is the GUID of the adapter, and the
+  /// description its friendly name, like "vEthernet (Default Switch)".
+  static bool Matches(const std::vector<std::string>& patterns,
+                      const std::string& name,
+                      const std::string& description) {
+    for (const std::string& pattern : patterns) {
+      if ((name.find(pattern) != std::string::npos) ||
+          (description.find(pattern) != std::string::npos)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool IsAllowed(const rtc::Network& network) const {
+    const std::string name = absl::AsciiStrToLower(network.name());
+    const std::string description =
+        absl::AsciiStrToLower(network.description());
+    if (!allowlist_.empty() && !Matches(allowlist_, name, description)) {
+      return false;
+    }
+    return !Matches(denylist_, name, description);
+  }
+
+  const std::vector<std::string> allowlist_;
+  const std::vector<std::string> denylist_;
+};
+
+/// Network manager and socket factory of a port allocator, as a base class
+/// constructed before and destroyed after |cricket::BasicPortAllocator|, whose
+/// sessions use them until destroyed.
+struct PortAllocatorResources {
+  PortAllocatorResources(
+      std::unique_ptr<rtc::NetworkManager> network_manager,
+      std::unique_ptr<rtc::PacketSocketFactory> socket_factory) noexcept
+      : network_manager_(std::move(network_manager)),
+        socket_factory_(std::move(socket_factory)) {}
+
+  std::unique_ptr<rtc::NetworkManager> network_manager_;
+  std::unique_ptr<rtc::PacketSocketFactory> socket_factory_;
+};
+
+/// Port allocator owning its network manager and socket factory.
+class OwningPortAllocator : private PortAllocatorResources,
+                            public cricket::BasicPortAllocator {
+ public:
+  OwningPortAllocator(
+      std::unique_ptr<rtc::NetworkManager> network_manager,
+      std::unique_ptr<rtc::PacketSocketFactory> socket_factory) noexcept
+      : PortAllocatorResources(std::move(network_manager),
+                               std::move(socket_factory)),
+        cricket::BasicPortAllocator(network_manager_.get(),
+                                    socket_factory_.get()) {}
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+bool NeedsCustomPortAllocator(
+    const mrsPeerConnectionConfiguration& config) noexcept {
+  return (config.min_port > 0) || (config.max_port > 0) ||
+         !IsStringNullOrEmpty(config.network_interface_allowlist) ||
+         !IsStringNullOrEmpty(config.network_interface_denylist);
+}
+
+std::unique_ptr<cricket::PortAllocator> CreatePortAllocator(
+    const mrsPeerConnectionConfiguration& config,
+    rtc::Thread* network_thread) noexcept {
+  auto network_manager = absl::make_unique<FilteringNetworkManager>(
+      ParseInterfaceList(config.network_interface_allowlist),
+      ParseInterfaceList(config.network_interface_denylist));
+  auto socket_factory =
+      absl::make_unique<rtc::BasicPacketSocketFactory>(network_thread);
+  auto allocator = absl::make_unique<OwningPortAllocator>(
+      std::move(network_manager), std::move(socket_factory));
+  if ((config.min_port > 0) || (config.max_port > 0)) {
+    allocator->SetPortRange(config.min_port, config.max_port);
+  }
+  return std::move(allocator);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+
+#include "p2p/base/portallocator.h"
+#include "rtc_base/thread.h"
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Check if a peer connection configuration restricts the local ports or the
+/// network interfaces, which requires a dedicated port allocator created with
+/// |CreatePortAllocator()|.
+bool NeedsCustomPortAllocator(
+    const mrsPeerConnectionConfiguration& config) noexcept;
+
+/// Create the port allocator of a peer connection, restricted to the local
+/// port range and the network interfaces of its configuration. The allocator
+/// owns the network manager and socket factory it uses, and must be used and
+/// destroyed on |network_thread|, as the peer connection does.
+std::unique_ptr<cricket::PortAllocator> CreatePortAllocator(
+    const mrsPeerConnectionConfiguration& config,
+    rtc::Thread* network_thread) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/transceiver.h"
+#include "quality_limitation_monitor.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Get an integer value of a stats report, or zero if not reported.
+int GetIntValue(const webrtc::StatsReport& report,
+                webrtc::StatsReport::StatsValueName name) {
+  const webrtc::StatsReport::Value* value = report.FindValue(name);
+  if (!value || (value->type() != webrtc::StatsReport::Value::kInt)) {
+    return 0;
+  }
+  return value->int_val();
+}
+
+/// Get a boolean value of a stats report, or false if not reported.
+bool GetBoolValue(const webrtc::StatsReport& report,
+                  webrtc::StatsReport::StatsValueName name) {
+  const webrtc::StatsReport::Value* value = report.FindValue(name);
+  if (!value || (value->type() != webrtc::StatsReport::Value::kBool)) {
+    return false;
+  }
+  return value->bool_val();
+}
+
+/// Observer forwarding the reports to their monitor, if still alive.
+class MonitorObserver : public webrtc::StatsObserver {
+ public:
+  explicit MonitorObserver(
+      std::weak_ptr<QualityLimitationMonitor> monitor) noexcept
+      : monitor_(std::move(monitor)) {}
+
+  void OnComplete(const webrtc::StatsReports& reports) override {
+    if (std::shared_ptr<QualityLimitationMonitor> monitor = monitor_.lock()) {
+      monitor->OnReports(reports);
+    }
+  }
+
+ private:
+  std::weak_ptr<QualityLimitationMonitor> monitor_;
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void QualityLimitationMonitor::Collect(
+    webrtc::PeerConnectionInterface& peer) noexcept {
+  if (collecting_) {
+    return;
+  }
+  webrtc::RtpSenderInterface* const sender = transceiver_.GetRtpSender();
+  if (!sender) {
+    return;
+  }
+  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track =
+      sender->track();
+  if (!track) {
+    return;
+  }
+  track_id_ = track->id();
+  collecting_ = true;
+  // The standard stats of this version of WebRTC do not report the adaptation
+  // of the encoder, so use the legacy stats of the send stream.
+  rtc::scoped_refptr<MonitorObserver> observer =
+      new rtc::RefCountedObject<MonitorObserver>(shared_from_this());
+  if (!peer.GetStats(observer, nullptr,
+                     webrtc::PeerConnectionInterface::
+                         kStatsOutputLevelStandard)) {
+    collecting_ = false;
+  }
+}
+
+void QualityLimitationMonitor::OnReports(
+    const webrtc::StatsReports& reports) noexcept {
+  collecting_ = false;
+
+  // Find the stats of the video stream sending the track.
+  const webrtc::StatsReport* send_report = nullptr;
+  for (const webrtc::StatsReport* report : reports) {
+    if (report->type() != webrtc::StatsReport::kStatsReportTypeSsrc) {
+      continue;
+    }
+    const webrtc::StatsReport::Value* track_id =
+        report->FindValue(webrtc::StatsReport::kStatsValueNameTrackId);
+    if (track_id && (track_id->ToString() == track_id_) &&
+        report->FindValue(webrtc::StatsReport::kStatsValueNameFrameWidthSent)) {
+      send_report = report;
+      break;
+    }
+  }
+  if (!send_report) {
+    return;
+  }
+
+  mrsQualityLimitationEvent event{};
+  event.frame_width = (uint32_t)GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameFrameWidthSent);
+  event.frame_height = (uint32_t)GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameFrameHeightSent);
+  event.framerate = GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameFrameRateSent);
+  event.input_width = (uint32_t)GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameFrameWidthInput);
+  event.input_height = (uint32_t)GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameFrameHeightInput);
+  event.adaptation_changes = GetIntValue(
+      *send_report, webrtc::StatsReport::kStatsValueNameAdaptationChanges);
+  if (event.frame_width == 0) {
+    // Nothing encoded yet.
+    return;
+  }
+
+  // The CPU takes precedence when both limit the resolution, as lowering the
+  // resolution for the CPU also lowers the bitrate needed.
+  if (GetBoolValue(*send_report,
+                   webrtc::StatsReport::kStatsValueNameCpuLimitedResolution)) {
+    event.reason = mrsQualityLimitationReason::kCpu;
+  } else if (GetBoolValue(*send_report,
+                          webrtc::StatsReport::
+                              kStatsValueNameBandwidthLimitedResolution)) {
+    event.reason = mrsQualityLimitationReason::kBandwidth;
+  } else if ((uint64_t)event.frame_width * event.frame_height <
+             (uint64_t)event.input_width * event.input_height) {
+    event.reason = mrsQualityLimitationReason::kOther;
+  } else {
+    event.reason = mrsQualityLimitationReason::kNone;
+  }
+
+  const int64_t now_ms = rtc::TimeMillis();
+  const bool changed = !has_state_ || (event.reason != reason_) ||
+                       (event.frame_width != frame_width_) ||
+                       (event.frame_height != frame_height_);
+  if (has_state_) {
+    total_durations_ms_[(int)reason_] += now_ms - last_check_ms_;
+    event.previous_reason = reason_;
+    event.previous_duration_ms = now_ms - state_start_ms_;
+    if (event.reason != reason_) {
+      reason_ = event.reason;
+      state_start_ms_ = now_ms;
+    }
+  } else {
+    has_state_ = true;
+    reason_ = event.reason;
+    state_start_ms_ = now_ms;
+  }
+  last_check_ms_ = now_ms;
+  frame_width_ = event.frame_width;
+  frame_height_ = event.frame_height;
+  if (!changed) {
+    return;
+  }
+  event.timestamp_ms = now_ms;
+  for (int i = 0; i < 4; ++i) {
+    event.total_durations_ms[i] = total_durations_ms_[i];
+  }
+  callback_(&event);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "api/peerconnectioninterface.h"
+#include "api/statstypes.h"
+
+#include "callback.h"
+#include "transceiver_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class Transceiver;
+
+/// Callback delivering a quality limitation change.
+using QualityLimitationCallback = Callback<const mrsQualityLimitationEvent*>;
+
+/// Periodic check of the send stream stats of a video transceiver, delivering
+/// the changes of the reason limiting the encoded resolution. This is only
+/// accessed on the signaling thread.
+class QualityLimitationMonitor
+    : public std::enable_shared_from_this<QualityLimitationMonitor> {
+ public:
+  QualityLimitationMonitor(Transceiver& transceiver,
+                           const mrsQualityLimitationConfig& config,
+                           QualityLimitationCallback callback) noexcept
+      : transceiver_(transceiver), config_(config), callback_(callback) {}
+
+  Transceiver& transceiver() const noexcept { return transceiver_; }
+
+  int interval_ms() const noexcept { return config_.interval_ms; }
+
+  /// Request the stats of the track sent by the transceiver, and check them
+  /// once ready, unless the monitor is destroyed first. This is a no-op while
+  /// the previous stats are being collected, or if no track is sent.
+  void Collect(webrtc::PeerConnectionInterface& peer) noexcept;
+
+  /// Check the send stream stats of the reports requested by |Collect()|, and
+  /// deliver an event to the callback if the limitation changed.
+  void OnReports(const webrtc::StatsReports& reports) noexcept;
+
+ private:
+  Transceiver& transceiver_;
+  const mrsQualityLimitationConfig config_;
+  const QualityLimitationCallback callback_;
+
+  /// Stats are being collected.
+  bool collecting_{false};
+
+  /// Identifier of the track whose stats are being collected.
+  std::string track_id_;
+
+  /// Current state, once the stream is sent.
+  bool has_state_{false};
+  mrsQualityLimitationReason reason_{mrsQualityLimitationReason::kNone};
+  int64_t state_start_ms_{0};
+  int64_t last_check_ms_{0};
+  int64_t total_durations_ms_[4]{};
+  uint32_t frame_width_{0};
+  uint32_t frame_height_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
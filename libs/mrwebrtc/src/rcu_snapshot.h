@@ -0,0 +1,202 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Immutable snapshot of a value of type |T|, published with read-copy-update
+/// semantics. Readers access the current snapshot without taking any lock,
+/// while writers copy the snapshot, modify the copy, and atomically publish it
+/// in place of the previous one.
+///
+/// Readers enter one of two epochs, and count themselves in that epoch while
+/// they access the snapshot. A writer waiting for the previous snapshot to be
+/// released switches new readers to the other epoch, then blocks until the
+/// readers of the epoch it left are done. Readers starting after the switch
+/// never delay that writer, so a steady flow of readers cannot starve it.
+///
+/// This is intended for data read very frequently on a hot path, like the
+/// frame callbacks of an observer read for each media frame, and rarely
+/// modified.
+template <typename T>
+class RcuSnapshot {
+ public:
+  /// Scoped read access to the current snapshot. The snapshot stays valid for
+  /// the lifetime of this object, which should be kept short since it delays
+  /// any concurrent |Update()|.
+  class ReadScope {
+   public:
+    explicit ReadScope(const RcuSnapshot& snapshot) noexcept
+        : snapshot_(snapshot), prev_(t_read_scopes_) {
+      // Sequentially consistent ordering pairs with |Synchronize()|: either
+      // the writer sees this reader in the epoch it waits for, or this reader
+      // sees the epoch switch and retries in the new epoch.
+      for (;;) {
+        epoch_ = snapshot_.epoch_.load(std::memory_order_seq_cst);
+        snapshot_.readers_[epoch_].fetch_add(1, std::memory_order_seq_cst);
+        if (snapshot_.epoch_.load(std::memory_order_seq_cst) == epoch_) {
+          break;
+        }
+        snapshot_.ReleaseReader(epoch_);
+      }
+      value_ = snapshot_.current_.load(std::memory_order_seq_cst);
+      t_read_scopes_ = this;
+    }
+    ~ReadScope() noexcept {
+      t_read_scopes_ = prev_;
+      snapshot_.ReleaseReader(epoch_);
+    }
+    ReadScope(const ReadScope&) = delete;
+    ReadScope& operator=(const ReadScope&) = delete;
+
+    const T& operator*() const noexcept { return *value_; }
+    const T* operator->() const noexcept { return value_; }
+
+   private:
+    friend class RcuSnapshot;
+    const RcuSnapshot& snapshot_;
+    const ReadScope* const prev_;
+    const T* value_;
+    int epoch_;
+  };
+
+  RcuSnapshot() : current_(new T()) {}
+  ~RcuSnapshot() noexcept { delete current_.load(); }
+  RcuSnapshot(const RcuSnapshot&) = delete;
+  RcuSnapshot& operator=(const RcuSnapshot&) = delete;
+
+  /// Modify the value by invoking |func(T&)| on a copy of the current
+  /// snapshot, then publish that copy without waiting for the readers of the
+  /// previous snapshot. The previous snapshot is retired, and destroyed by the
+  /// next |Synchronize()|. Use this only for changes after which readers may
+  /// safely keep observing the previous value for a while, like adding a new
+  /// callback.
+  template <typename Func>
+  void Publish(Func&& func) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    PublishLocked(std::forward<Func>(func));
+  }
+
+  /// Wait for all the readers which might access a snapshot published before
+  /// this call to complete, then destroy the retired snapshots. Readers
+  /// starting during the wait access the current snapshot and are not waited
+  /// for.
+  ///
+  /// If called from within a read scope of this same snapshot on the current
+  /// thread (for example from a callback modifying its own registration), this
+  /// cannot wait for that scope to end and returns immediately. The enclosing
+  /// read scope, and any other reader already in progress, may then keep
+  /// observing the previous value until they end.
+  void Synchronize() {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    SynchronizeLocked();
+  }
+
+  /// Modify the value by invoking |func(T&)| on a copy of the current
+  /// snapshot, then publish that copy and |Synchronize()|, so that once this
+  /// returns no reader observes the previous value anymore, except when called
+  /// from within a read scope as described for |Synchronize()|. Writers are
+  /// serialized with each other, but never block readers.
+  template <typename Func>
+  void Update(Func&& func) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    PublishLocked(std::forward<Func>(func));
+    SynchronizeLocked();
+  }
+
+ private:
+  template <typename Func>
+  void PublishLocked(Func&& func) {
+    std::unique_ptr<T> value =
+        std::make_unique<T>(*current_.load(std::memory_order_relaxed));
+    func(*value);
+    retired_.emplace_back(
+        current_.exchange(value.release(), std::memory_order_seq_cst));
+  }
+
+  void SynchronizeLocked() {
+    if (retired_.empty() || IsReadingOnThisThread()) {
+      return;
+    }
+    // Only |Synchronize()| switches epochs, and it waits for the epoch it
+    // leaves to drain before returning, so any reader still able to access a
+    // retired snapshot is counted in the current epoch.
+    const int epoch = epoch_.load(std::memory_order_relaxed);
+    epoch_.store(1 - epoch, std::memory_order_seq_cst);
+    writer_waiting_.store(true, std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> wait_lock(wait_mutex_);
+      wait_cv_.wait(wait_lock, [this, epoch]() {
+        return (readers_[epoch].load(std::memory_order_seq_cst) == 0);
+      });
+    }
+    writer_waiting_.store(false, std::memory_order_relaxed);
+    retired_.clear();
+  }
+
+  void ReleaseReader(int epoch) const noexcept {
+    // Sequentially consistent ordering pairs with the store of
+    // |writer_waiting_|: either the writer sees the count reach zero, or this
+    // reader sees the writer waiting and wakes it up.
+    if ((readers_[epoch].fetch_sub(1, std::memory_order_seq_cst) == 1) &&
+        writer_waiting_.load(std::memory_order_seq_cst)) {
+      std::lock_guard<std::mutex> wait_lock(wait_mutex_);
+      wait_cv_.notify_all();
+    }
+  }
+
+  bool IsReadingOnThisThread() const noexcept {
+    for (const ReadScope* scope = t_read_scopes_; scope;
+         scope = scope->prev_) {
+      if (&scope->snapshot_ == this) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Current snapshot, owned by this object.
+  std::atomic<const T*> current_;
+
+  /// Epoch new readers enter, either 0 or 1.
+  std::atomic<int> epoch_{0};
+
+  /// Number of read scopes currently active in each epoch, on any thread.
+  mutable std::atomic<int> readers_[2]{{0}, {0}};
+
+  /// Whether a writer is blocked until the readers of an epoch are done.
+  std::atomic<bool> writer_waiting_{false};
+
+  /// Mutex serializing writers. This is never acquired by readers.
+  std::mutex writer_mutex_;
+
+  /// Mutex and condition variable a waiting writer blocks on, notified by the
+  /// last reader leaving an epoch while that writer is waiting.
+  mutable std::mutex wait_mutex_;
+  mutable std::condition_variable wait_cv_;
+
+  /// Previous snapshots replaced since the last |Synchronize()|, pending
+  /// destruction once no reader can access them anymore.
+  std::vector<std::unique_ptr<const T>> retired_;
+
+  /// Stack of the read scopes active on the current thread, innermost first.
+  static thread_local const ReadScope* t_read_scopes_;
+};
+
+template <typename T>
+thread_local const typename RcuSnapshot<T>::ReadScope*
+    RcuSnapshot<T>::t_read_scopes_ = nullptr;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
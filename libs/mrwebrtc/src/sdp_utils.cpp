@@ -6,7 +6,12 @@
 
 #include "sdp_utils.h"
 
+#include <cinttypes>
+#include <cstdio>
+
+#include "absl/strings/match.h"
 #include "api/jsepsessiondescription.h"
+#include "media/base/mediaconstants.h"
 #include "pc/sessiondescription.h"
 #include "pc/webrtcsdp.h"
 
@@ -47,6 +52,80 @@ bool SetPreferredCodec(
   return true;
 }
 
+/// Check if a codec matches a codec preference.
+bool MatchesPreference(const cricket::Codec& codec,
+                       const Microsoft::MixedReality::WebRTC::
+                           SdpCodecPreference& preference) {
+  if (!absl::EqualsIgnoreCase(codec.name, preference.name)) {
+    return false;
+  }
+  std::string value;
+  for (auto&& param : preference.params) {
+    if (!codec.GetParam(param.first, &value) || (value != param.second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Keep only the preferred codecs of a media content description, in order
+/// of preference, and the retransmission codecs associated with them.
+template <typename C>
+bool ApplyCodecPreferences(
+    const std::vector<Microsoft::MixedReality::WebRTC::SdpCodecPreference>&
+        preferences,
+    cricket::MediaContentDescriptionImpl<C>* desc) {
+  const std::vector<C>& codecs = desc->codecs();
+  std::vector<C> new_codecs;
+  new_codecs.reserve(codecs.size());
+  for (auto&& preference : preferences) {
+    for (auto&& codec : codecs) {
+      if (MatchesPreference(codec, preference) &&
+          std::none_of(new_codecs.begin(), new_codecs.end(),
+                       [&codec](const C& c) { return (c.id == codec.id); })) {
+        new_codecs.push_back(codec);
+      }
+    }
+  }
+  if (new_codecs.empty()) {
+    return false;
+  }
+  const size_t preferred_count = new_codecs.size();
+  for (auto&& codec : codecs) {
+    int apt = -1;
+    if (absl::EqualsIgnoreCase(codec.name, cricket::kRtxCodecName) &&
+        codec.GetParam(cricket::kCodecParamAssociatedPayloadType, &apt) &&
+        std::any_of(new_codecs.begin(), new_codecs.begin() + preferred_count,
+                    [apt](const C& c) { return (c.id == apt); })) {
+      new_codecs.push_back(codec);
+    }
+  }
+  desc->set_codecs(new_codecs);
+  return true;
+}
+
+/// Set format parameters on the codecs of a media content description with a
+/// given name.
+template <typename C>
+bool SetCodecParameters(absl::string_view codec_name,
+                        const std::map<std::string, std::string>& params,
+                        cricket::MediaContentDescriptionImpl<C>* desc) {
+  std::vector<C> codecs = desc->codecs();
+  bool found = false;
+  for (auto&& codec : codecs) {
+    if (absl::EqualsIgnoreCase(codec.name, codec_name)) {
+      for (auto&& param : params) {
+        codec.SetParam(param.first, param.second);
+      }
+      found = true;
+    }
+  }
+  if (found) {
+    desc->set_codecs(codecs);
+  }
+  return found;
+}
+
 bool TryExtractSuffix(const std::string& str,
                       const std::string& prefix,
                       std::string& suffixOut) {
@@ -60,6 +139,151 @@ bool TryExtractSuffix(const std::string& str,
   return false;
 }
 
+/// Version tag starting the compact form of an SDP message.
+constexpr const char kCompactHeader[] = "#mrsc1";
+
+/// Lines of an SDP message, without line endings.
+using SdpLines = std::vector<std::string>;
+
+SdpLines SplitSdpLines(const std::string& sdp) {
+  SdpLines lines;
+  size_t start = 0;
+  while (start < sdp.size()) {
+    size_t end = sdp.find('\n', start);
+    if (end == std::string::npos) {
+      end = sdp.size();
+    }
+    size_t length = end - start;
+    if ((length > 0) && (sdp[end - 1] == '\r')) {
+      --length;
+    }
+    lines.emplace_back(sdp, start, length);
+    start = end + 1;
+  }
+  return lines;
+}
+
+/// Split the lines of an SDP message into its session section, followed by
+/// one section per "m=" line.
+std::vector<SdpLines> SplitSdpSections(const SdpLines& lines) {
+  std::vector<SdpLines> sections(1);
+  for (const std::string& line : lines) {
+    if (absl::StartsWith(line, "m=")) {
+      sections.emplace_back();
+    }
+    sections.back().push_back(line);
+  }
+  return sections;
+}
+
+/// Hash identifying the base of a delta, as 16 hexadecimal digits of the
+/// 64-bit FNV-1a hash of its lines, so that line endings do not matter.
+std::string HashSdpLines(const SdpLines& lines) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const std::string& line : lines) {
+    for (const char c : line) {
+      hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+    }
+    hash = (hash ^ (uint8_t)'\n') * 0x100000001b3ull;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016" PRIx64, hash);
+  return hex;
+}
+
+/// Check if a line is part of the codec and header extension attributes which
+/// media sections often repeat.
+bool IsBlockLine(const std::string& line) {
+  return absl::StartsWith(line, "a=rtpmap:") ||
+         absl::StartsWith(line, "a=fmtp:") ||
+         absl::StartsWith(line, "a=rtcp-fb:") ||
+         absl::StartsWith(line, "a=extmap:");
+}
+
+/// Line of the compact form before deduplication, either a command or a line
+/// of the SDP message.
+struct CompactToken {
+  bool is_command;
+  std::string text;
+};
+
+/// Append the edits turning |base| into |lines|, from their longest common
+/// subsequence of lines.
+void AppendSectionEdits(const SdpLines& base,
+                        const SdpLines& lines,
+                        std::vector<CompactToken>& tokens) {
+  const size_t n = base.size();
+  const size_t m = lines.size();
+  // lengths[i * (m + 1) + j] is the length of the longest common subsequence
+  // of base[i:] and lines[j:].
+  std::vector<uint32_t> lengths((n + 1) * (m + 1), 0);
+  for (size_t i = n; i-- > 0;) {
+    for (size_t j = m; j-- > 0;) {
+      uint32_t& length = lengths[i * (m + 1) + j];
+      if (base[i] == lines[j]) {
+        length = lengths[(i + 1) * (m + 1) + j + 1] + 1;
+      } else {
+        length = std::max(lengths[(i + 1) * (m + 1) + j],
+                          lengths[i * (m + 1) + j + 1]);
+      }
+    }
+  }
+  size_t copy_count = 0;
+  size_t skip_count = 0;
+  auto flush = [&tokens, &copy_count, &skip_count]() {
+    if (skip_count > 0) {
+      tokens.push_back({true, "#k" + std::to_string(skip_count)});
+      skip_count = 0;
+    }
+    if (copy_count > 0) {
+      tokens.push_back({true, "#c" + std::to_string(copy_count)});
+      copy_count = 0;
+    }
+  };
+  size_t i = 0;
+  size_t j = 0;
+  while (j < m) {
+    if ((i < n) && (base[i] == lines[j])) {
+      if (skip_count > 0) {
+        flush();
+      }
+      ++copy_count;
+      ++i;
+      ++j;
+    } else if ((i < n) && (lengths[(i + 1) * (m + 1) + j] >=
+                           lengths[i * (m + 1) + j + 1])) {
+      if (copy_count > 0) {
+        flush();
+      }
+      ++skip_count;
+      ++i;
+    } else {
+      flush();
+      tokens.push_back({false, lines[j]});
+      ++j;
+    }
+  }
+  // The base lines left are dropped, so only trailing copies are needed.
+  skip_count = 0;
+  flush();
+}
+
+/// Parse the count of a command, starting at |offset| of |line|.
+bool ParseCommandCount(const std::string& line, size_t offset, size_t* count) {
+  if ((offset >= line.size()) || (line.size() - offset > 9)) {
+    return false;
+  }
+  size_t value = 0;
+  for (size_t i = offset; i < line.size(); ++i) {
+    if ((line[i] < '0') || (line[i] > '9')) {
+      return false;
+    }
+    value = value * 10 + (size_t)(line[i] - '0');
+  }
+  *count = value;
+  return true;
+}
+
 }  // namespace
 
 namespace Microsoft {
@@ -150,6 +374,36 @@ std::string SdpForceCodecs(
   return webrtc::SdpSerialize(jdesc);
 }
 
+bool SdpApplyCodecPreferences(
+    const std::vector<SdpCodecPreference>& preferences,
+    cricket::MediaContentDescription& media_desc) {
+  switch (media_desc.type()) {
+    case cricket::MediaType::MEDIA_TYPE_AUDIO:
+      return ApplyCodecPreferences<cricket::AudioCodec>(preferences,
+                                                        media_desc.as_audio());
+    case cricket::MediaType::MEDIA_TYPE_VIDEO:
+      return ApplyCodecPreferences<cricket::VideoCodec>(preferences,
+                                                        media_desc.as_video());
+    default:
+      return false;
+  }
+}
+
+bool SdpSetCodecParameters(absl::string_view codec_name,
+                           const std::map<std::string, std::string>& params,
+                           cricket::MediaContentDescription& media_desc) {
+  switch (media_desc.type()) {
+    case cricket::MediaType::MEDIA_TYPE_AUDIO:
+      return SetCodecParameters<cricket::AudioCodec>(codec_name, params,
+                                                     media_desc.as_audio());
+    case cricket::MediaType::MEDIA_TYPE_VIDEO:
+      return SetCodecParameters<cricket::VideoCodec>(codec_name, params,
+                                                     media_desc.as_video());
+    default:
+      return false;
+  }
+}
+
 webrtc::PeerConnectionInterface::IceServers DecodeIceServers(
     const std::string& str) {
   if (str.empty())
@@ -235,6 +489,194 @@ webrtc::SdpType SdpTypeFromApiType(mrsSdpMessageType api_type) {
   }
 }
 
+std::string SdpEncodeCompact(const std::string& sdp, const std::string& base) {
+  const SdpLines lines = SplitSdpLines(sdp);
+  std::vector<CompactToken> tokens;
+  std::string header(kCompactHeader);
+  if (base.empty()) {
+    tokens.reserve(lines.size());
+    for (const std::string& line : lines) {
+      tokens.push_back({false, line});
+    }
+  } else {
+    const SdpLines base_lines = SplitSdpLines(base);
+    header += ' ';
+    header += HashSdpLines(base_lines);
+    const std::vector<SdpLines> base_sections = SplitSdpSections(base_lines);
+    const std::vector<SdpLines> sections = SplitSdpSections(lines);
+    for (size_t i = 0; i < sections.size(); ++i) {
+      if (i >= base_sections.size()) {
+        tokens.push_back({true, "#+"});
+        for (const std::string& line : sections[i]) {
+          tokens.push_back({false, line});
+        }
+      } else if (sections[i] == base_sections[i]) {
+        tokens.push_back({true, "#="});
+      } else {
+        tokens.push_back({true, "#~"});
+        AppendSectionEdits(base_sections[i], sections[i], tokens);
+      }
+    }
+  }
+
+  // Find the runs of codec and extension lines, and count how many times the
+  // same run appears.
+  std::vector<std::pair<size_t, size_t>> runs;
+  std::map<std::string, int> run_counts;
+  for (size_t i = 0; i < tokens.size();) {
+    size_t end = i;
+    while ((end < tokens.size()) && !tokens[end].is_command &&
+           IsBlockLine(tokens[end].text)) {
+      ++end;
+    }
+    if (end - i >= 2) {
+      std::string key;
+      for (size_t k = i; k < end; ++k) {
+        key += tokens[k].text;
+        key += '\n';
+      }
+      ++run_counts[key];
+      runs.emplace_back(i, end);
+      i = end;
+    } else {
+      i = std::max(end, i + 1);
+    }
+  }
+
+  // Define the runs appearing more than once as blocks on first use, and
+  // replace the next uses with the block.
+  std::string compact(std::move(header));
+  compact += '\n';
+  std::map<std::string, size_t> block_ids;
+  auto run_it = runs.begin();
+  for (size_t i = 0; i < tokens.size();) {
+    if ((run_it != runs.end()) && (run_it->first == i)) {
+      const size_t end = run_it->second;
+      ++run_it;
+      std::string key;
+      for (size_t k = i; k < end; ++k) {
+        key += tokens[k].text;
+        key += '\n';
+      }
+      if (run_counts[key] > 1) {
+        auto block_it = block_ids.find(key);
+        if (block_it != block_ids.end()) {
+          compact += "#b" + std::to_string(block_it->second) + '\n';
+        } else {
+          block_ids.emplace(key, block_ids.size());
+          compact += "#d" + std::to_string(end - i) + '\n';
+          compact += key;
+        }
+        i = end;
+        continue;
+      }
+    }
+    const CompactToken& token = tokens[i];
+    if (!token.is_command && !token.text.empty() && (token.text[0] == '#')) {
+      // Escape the lines which would otherwise read as commands.
+      compact += '#';
+    }
+    compact += token.text;
+    compact += '\n';
+    ++i;
+  }
+  return compact;
+}
+
+bool SdpDecodeCompact(const std::string& compact,
+                      const std::string& base,
+                      std::string& sdp_out) {
+  const SdpLines lines = SplitSdpLines(compact);
+  if (lines.empty() || !absl::StartsWith(lines[0], kCompactHeader)) {
+    return false;
+  }
+  const size_t header_length = sizeof(kCompactHeader) - 1;
+  std::vector<SdpLines> base_sections;
+  if (lines[0].size() > header_length) {
+    if (lines[0][header_length] != ' ') {
+      return false;
+    }
+    const SdpLines base_lines = SplitSdpLines(base);
+    if (lines[0].compare(header_length + 1, std::string::npos,
+                         HashSdpLines(base_lines)) != 0) {
+      return false;
+    }
+    base_sections = SplitSdpSections(base_lines);
+  }
+
+  SdpLines out;
+  std::vector<SdpLines> blocks;
+  size_t next_section = 0;
+  const SdpLines* edited = nullptr;
+  size_t edited_pos = 0;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    const std::string& line = lines[i];
+    if (line.empty() || (line[0] != '#')) {
+      out.push_back(line);
+      continue;
+    }
+    const char command = (line.size() > 1 ? line[1] : '\0');
+    size_t count = 0;
+    switch (command) {
+      case '#':
+        out.emplace_back(line, 1);
+        break;
+      case '=':
+      case '~':
+      case '+':
+        if ((line.size() != 2) ||
+            ((command != '+') && (next_section >= base_sections.size()))) {
+          return false;
+        }
+        if (command == '=') {
+          const SdpLines& section = base_sections[next_section];
+          out.insert(out.end(), section.begin(), section.end());
+        }
+        edited = (command == '~' ? &base_sections[next_section] : nullptr);
+        edited_pos = 0;
+        ++next_section;
+        break;
+      case 'c':
+      case 'k':
+        if (!edited || !ParseCommandCount(line, 2, &count) ||
+            (count > edited->size() - edited_pos)) {
+          return false;
+        }
+        if (command == 'c') {
+          out.insert(out.end(), edited->begin() + edited_pos,
+                     edited->begin() + edited_pos + count);
+        }
+        edited_pos += count;
+        break;
+      case 'd':
+        if (!ParseCommandCount(line, 2, &count) ||
+            (count > lines.size() - i - 1)) {
+          return false;
+        }
+        blocks.emplace_back(lines.begin() + i + 1,
+                            lines.begin() + i + 1 + count);
+        out.insert(out.end(), blocks.back().begin(), blocks.back().end());
+        i += count;
+        break;
+      case 'b':
+        if (!ParseCommandCount(line, 2, &count) || (count >= blocks.size())) {
+          return false;
+        }
+        out.insert(out.end(), blocks[count].begin(), blocks[count].end());
+        break;
+      default:
+        return false;
+    }
+  }
+
+  sdp_out.clear();
+  for (const std::string& line : out) {
+    sdp_out += line;
+    sdp_out += "\r\n";
+  }
+  return true;
+}
+
 mrsSdpMessageType ApiTypeFromSdpType(webrtc::SdpType type) {
   switch (type) {
     case webrtc::SdpType::kOffer:
@@ -9,6 +9,10 @@
 #include "callback.h"
 #include "interop_api.h"
 
+namespace cricket {
+class MediaContentDescription;
+}
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -43,6 +47,58 @@ std::string SdpForceCodecs(
     const std::string& video_codec_name,
     const std::map<std::string, std::string>& extra_video_codec_params);
 
+/// Preference for the codecs with a given SDP name, compared
+/// case-insensitively, and with at least the given format parameters.
+struct SdpCodecPreference {
+  std::string name;
+  std::map<std::string, std::string> params;
+};
+
+/// Keep only the preferred codecs of a media description, in order of
+/// preference, along with the retransmission codecs of the codecs kept. This
+/// is the equivalent of |RtpTransceiverInterface::SetCodecPreferences()|,
+/// applied to a description already created in place of its serialized SDP.
+/// If no codec is preferred, the description is unchanged and this returns
+/// |false|.
+bool SdpApplyCodecPreferences(
+    const std::vector<SdpCodecPreference>& preferences,
+    cricket::MediaContentDescription& media_desc);
+
+/// Set format parameters on all the codecs of a media description with a given
+/// SDP name, compared case-insensitively, overwriting any previous value.
+/// Returns |false| if the description has no such codec.
+bool SdpSetCodecParameters(absl::string_view codec_name,
+                           const std::map<std::string, std::string>& params,
+                           cricket::MediaContentDescription& media_desc);
+
+/// Encode an SDP message into a compact form for the signaling service, which
+/// |SdpDecodeCompact()| turns back into the same message, with CRLF line
+/// endings like the messages WebRTC produces. Runs of codec and header
+/// extension attributes repeated across media sections are sent once. If
+/// |base| is not empty, the result is a delta against that message,
+/// typically the description previously exchanged before a renegotiation,
+/// where the unchanged lines of each media section are copied from |base|.
+///
+/// The compact form is text, with one line per SDP line or per command:
+///   compact = header *( command / sdp-line )
+///   header = "#mrsc1" [ " " base-hash ] "\n"
+///   command = "#" ( "=" / "~" / "+" / "c" count / "k" count / "d" count /
+///             "b" id ) "\n"
+/// where in a delta, each section starts with "#=" to copy the section of the
+/// base at the same index, "#~" to edit it, or "#+" for a new section, and
+/// edits copy ("#c") or skip ("#k") lines of the base section, dropping the
+/// base lines left at the end of the section. "#d" defines the next lines as a
+/// block, and "#b" repeats a block previously defined.
+std::string SdpEncodeCompact(const std::string& sdp,
+                             const std::string& base = {});
+
+/// Decode the compact form of an SDP message produced by |SdpEncodeCompact()|,
+/// passing the same |base| message for a delta. Returns |false| if the
+/// compact form is malformed, or if it is a delta against another base.
+bool SdpDecodeCompact(const std::string& compact,
+                      const std::string& base,
+                      std::string& sdp_out);
+
 /// Decode a marshalled ICE server string.
 /// Syntax is:
 ///   string = blocks
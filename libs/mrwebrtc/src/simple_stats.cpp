@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "simple_stats.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+const char* GetTrackIdentifier(const webrtc::RTCMediaStreamTrackStats& src) {
+  return (src.track_identifier.is_defined() ? src.track_identifier->c_str()
+                                            : "");
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void FillTrackStats(mrsAudioSenderStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept {
+  dest.track_stats_timestamp_us = src.timestamp_us();
+  dest.track_identifier = GetTrackIdentifier(src);
+  dest.audio_level = GetValueIfDefined(src.audio_level);
+  dest.total_audio_energy = GetValueIfDefined(src.total_audio_energy);
+  dest.total_samples_duration = GetValueIfDefined(src.total_samples_duration);
+}
+
+void FillRtpStats(mrsAudioSenderStats& dest,
+                  const webrtc::RTCOutboundRTPStreamStats& src) noexcept {
+  dest.rtp_stats_timestamp_us = src.timestamp_us();
+  dest.packets_sent = GetValueIfDefined(src.packets_sent);
+  dest.bytes_sent = GetValueIfDefined(src.bytes_sent);
+  dest.nack_count = GetValueIfDefined(src.nack_count);
+}
+
+void FillTrackStats(mrsAudioReceiverStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept {
+  dest.track_stats_timestamp_us = src.timestamp_us();
+  dest.track_identifier = GetTrackIdentifier(src);
+  // This seems to be undefined in some not well specified cases.
+  dest.audio_level = GetValueIfDefined(src.audio_level);
+  dest.total_audio_energy = GetValueIfDefined(src.total_audio_energy);
+  dest.total_samples_received = GetValueIfDefined(src.total_samples_received);
+  dest.total_samples_duration = GetValueIfDefined(src.total_samples_duration);
+  dest.jitter_buffer_delay = GetValueIfDefined(src.jitter_buffer_delay);
+}
+
+void FillRtpStats(mrsAudioReceiverStats& dest,
+                  const webrtc::RTCInboundRTPStreamStats& src) noexcept {
+  dest.rtp_stats_timestamp_us = src.timestamp_us();
+  dest.packets_received = GetValueIfDefined(src.packets_received);
+  dest.bytes_received = GetValueIfDefined(src.bytes_received);
+  dest.packets_lost = GetValueIfDefined(src.packets_lost);
+  dest.jitter = GetValueIfDefined(src.jitter);
+  dest.nack_count = GetValueIfDefined(src.nack_count);
+}
+
+void FillTrackStats(mrsVideoSenderStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept {
+  dest.track_stats_timestamp_us = src.timestamp_us();
+  dest.track_identifier = GetTrackIdentifier(src);
+  dest.frames_sent = GetValueIfDefined(src.frames_sent);
+  dest.huge_frames_sent = GetValueIfDefined(src.huge_frames_sent);
+}
+
+void FillRtpStats(mrsVideoSenderStats& dest,
+                  const webrtc::RTCOutboundRTPStreamStats& src) noexcept {
+  dest.rtp_stats_timestamp_us = src.timestamp_us();
+  dest.packets_sent = GetValueIfDefined(src.packets_sent);
+  dest.bytes_sent = GetValueIfDefined(src.bytes_sent);
+  dest.frames_encoded = GetValueIfDefined(src.frames_encoded);
+  dest.nack_count = GetValueIfDefined(src.nack_count);
+  dest.pli_count = GetValueIfDefined(src.pli_count);
+  dest.fir_count = GetValueIfDefined(src.fir_count);
+  dest.qp_sum = GetValueIfDefined(src.qp_sum);
+}
+
+void FillTrackStats(mrsVideoReceiverStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept {
+  dest.track_stats_timestamp_us = src.timestamp_us();
+  dest.track_identifier = GetTrackIdentifier(src);
+  dest.frames_received = GetValueIfDefined(src.frames_received);
+  dest.frames_dropped = GetValueIfDefined(src.frames_dropped);
+  dest.jitter_buffer_delay = GetValueIfDefined(src.jitter_buffer_delay);
+}
+
+void FillRtpStats(mrsVideoReceiverStats& dest,
+                  const webrtc::RTCInboundRTPStreamStats& src) noexcept {
+  dest.rtp_stats_timestamp_us = src.timestamp_us();
+  dest.packets_received = GetValueIfDefined(src.packets_received);
+  dest.bytes_received = GetValueIfDefined(src.bytes_received);
+  dest.frames_decoded = GetValueIfDefined(src.frames_decoded);
+  dest.packets_lost = GetValueIfDefined(src.packets_lost);
+  dest.jitter = GetValueIfDefined(src.jitter);
+  dest.nack_count = GetValueIfDefined(src.nack_count);
+  dest.pli_count = GetValueIfDefined(src.pli_count);
+  dest.fir_count = GetValueIfDefined(src.fir_count);
+  dest.qp_sum = GetValueIfDefined(src.qp_sum);
+}
+
+void FillDataChannelStats(mrsDataChannelStats& dest,
+                          const webrtc::RTCDataChannelStats& src) noexcept {
+  dest.timestamp_us = src.timestamp_us();
+  dest.data_channel_identifier = GetValueIfDefined(src.datachannelid);
+  dest.messages_sent = GetValueIfDefined(src.messages_sent);
+  dest.bytes_sent = GetValueIfDefined(src.bytes_sent);
+  dest.messages_received = GetValueIfDefined(src.messages_received);
+  dest.bytes_received = GetValueIfDefined(src.bytes_received);
+}
+
+void FillTransportStats(mrsTransportStats& dest,
+                        const webrtc::RTCTransportStats& src,
+                        const webrtc::RTCStatsReport& report) noexcept {
+  dest.timestamp_us = src.timestamp_us();
+  dest.bytes_sent = GetValueIfDefined(src.bytes_sent);
+  dest.bytes_received = GetValueIfDefined(src.bytes_received);
+  dest.current_round_trip_time = 0.0;
+  dest.available_outgoing_bitrate = 0.0;
+  if (src.selected_candidate_pair_id.is_defined()) {
+    const webrtc::RTCStats* stats =
+        report.Get(*src.selected_candidate_pair_id);
+    if (stats &&
+        (stats->type() == webrtc::RTCIceCandidatePairStats::kType)) {
+      const auto& pair_stats =
+          stats->cast_to<webrtc::RTCIceCandidatePairStats>();
+      dest.current_round_trip_time =
+          GetValueIfDefined(pair_stats.current_round_trip_time);
+      dest.available_outgoing_bitrate =
+          GetValueIfDefined(pair_stats.available_outgoing_bitrate);
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
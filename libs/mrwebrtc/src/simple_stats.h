@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "api/stats/rtcstats_objects.h"
+#include "api/stats/rtcstatsreport.h"
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Get the value of a stats member, or a default value if undefined.
+template <class T>
+T GetValueIfDefined(const webrtc::RTCStatsMember<T>& member) {
+  return member.is_defined() ? *member : T{};
+}
+
+//
+// Fill the simple stats structs from the WebRTC stats objects they join. The
+// strings pointed to by the simple stats are owned by the stats objects.
+//
+
+void FillTrackStats(mrsAudioSenderStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept;
+void FillRtpStats(mrsAudioSenderStats& dest,
+                  const webrtc::RTCOutboundRTPStreamStats& src) noexcept;
+
+void FillTrackStats(mrsAudioReceiverStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept;
+void FillRtpStats(mrsAudioReceiverStats& dest,
+                  const webrtc::RTCInboundRTPStreamStats& src) noexcept;
+
+void FillTrackStats(mrsVideoSenderStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept;
+void FillRtpStats(mrsVideoSenderStats& dest,
+                  const webrtc::RTCOutboundRTPStreamStats& src) noexcept;
+
+void FillTrackStats(mrsVideoReceiverStats& dest,
+                    const webrtc::RTCMediaStreamTrackStats& src) noexcept;
+void FillRtpStats(mrsVideoReceiverStats& dest,
+                  const webrtc::RTCInboundRTPStreamStats& src) noexcept;
+
+void FillDataChannelStats(mrsDataChannelStats& dest,
+                          const webrtc::RTCDataChannelStats& src) noexcept;
+
+/// Fill the stats of a transport, including the stats of its selected
+/// candidate pair found in |report|, if any.
+void FillTransportStats(mrsTransportStats& dest,
+                        const webrtc::RTCTransportStats& src,
+                        const webrtc::RTCStatsReport& report) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
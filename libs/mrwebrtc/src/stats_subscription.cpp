@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "simple_stats.h"
+#include "stats_subscription.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Check the type of a stats object. Types are compared by address, as each
+/// stats class returns its own static type string.
+template <class T>
+bool IsOfType(const webrtc::RTCStats& stats) {
+  return (stats.type() == T::kType);
+}
+
+/// Get the track stats referenced by an RTP stream, or NULL if none.
+template <class T>
+const webrtc::RTCMediaStreamTrackStats* GetTrackStats(
+    const webrtc::RTCStatsReport& report,
+    const T& rtp_stats) {
+  if (!rtp_stats.track_id.is_defined()) {
+    // Removing a track leaves a "trackless" RTP stream.
+    return nullptr;
+  }
+  const webrtc::RTCStats* stats = report.Get(*rtp_stats.track_id);
+  if (!stats || !IsOfType<webrtc::RTCMediaStreamTrackStats>(*stats)) {
+    return nullptr;
+  }
+  return &stats->cast_to<webrtc::RTCMediaStreamTrackStats>();
+}
+
+/// Check if an RTP stream carries audio, without copying its kind.
+template <class T>
+bool IsAudio(const T& rtp_stats) {
+  return rtp_stats.kind.is_defined() && (*rtp_stats.kind == "audio");
+}
+
+/// Check if two entries have the same values, ignoring their timestamps and
+/// string pointers, which change with each report.
+bool HaveSameValues(const mrsStatsEntry& lhs,
+                    const mrsStatsEntry& rhs) noexcept {
+  if (lhs.kind != rhs.kind) {
+    return false;
+  }
+  switch (lhs.kind) {
+    case mrsStatsEntryKind::kDataChannel: {
+      const mrsDataChannelStats& l = lhs.data_channel;
+      const mrsDataChannelStats& r = rhs.data_channel;
+      return (l.data_channel_identifier == r.data_channel_identifier) &&
+             (l.messages_sent == r.messages_sent) &&
+             (l.bytes_sent == r.bytes_sent) &&
+             (l.messages_received == r.messages_received) &&
+             (l.bytes_received == r.bytes_received);
+    }
+    case mrsStatsEntryKind::kAudioSender: {
+      const mrsAudioSenderStats& l = lhs.audio_sender;
+      const mrsAudioSenderStats& r = rhs.audio_sender;
+      return (l.audio_level == r.audio_level) &&
+             (l.total_audio_energy == r.total_audio_energy) &&
+             (l.total_samples_duration == r.total_samples_duration) &&
+             (l.packets_sent == r.packets_sent) &&
+             (l.bytes_sent == r.bytes_sent) &&
+             (l.nack_count == r.nack_count);
+    }
+    case mrsStatsEntryKind::kAudioReceiver: {
+      const mrsAudioReceiverStats& l = lhs.audio_receiver;
+      const mrsAudioReceiverStats& r = rhs.audio_receiver;
+      return (l.audio_level == r.audio_level) &&
+             (l.total_audio_energy == r.total_audio_energy) &&
+             (l.total_samples_received == r.total_samples_received) &&
+             (l.total_samples_duration == r.total_samples_duration) &&
+             (l.packets_received == r.packets_received) &&
+             (l.bytes_received == r.bytes_received) &&
+             (l.packets_lost == r.packets_lost) && (l.jitter == r.jitter) &&
+             (l.nack_count == r.nack_count) &&
+             (l.jitter_buffer_delay == r.jitter_buffer_delay);
+    }
+    case mrsStatsEntryKind::kVideoSender: {
+      const mrsVideoSenderStats& l = lhs.video_sender;
+      const mrsVideoSenderStats& r = rhs.video_sender;
+      return (l.frames_sent == r.frames_sent) &&
+             (l.huge_frames_sent == r.huge_frames_sent) &&
+             (l.packets_sent == r.packets_sent) &&
+             (l.bytes_sent == r.bytes_sent) &&
+             (l.frames_encoded == r.frames_encoded) &&
+             (l.nack_count == r.nack_count) && (l.pli_count == r.pli_count) &&
+             (l.fir_count == r.fir_count) && (l.qp_sum == r.qp_sum);
+    }
+    case mrsStatsEntryKind::kVideoReceiver: {
+      const mrsVideoReceiverStats& l = lhs.video_receiver;
+      const mrsVideoReceiverStats& r = rhs.video_receiver;
+      return (l.frames_received == r.frames_received) &&
+             (l.frames_dropped == r.frames_dropped) &&
+             (l.packets_received == r.packets_received) &&
+             (l.bytes_received == r.bytes_received) &&
+             (l.frames_decoded == r.frames_decoded) &&
+             (l.packets_lost == r.packets_lost) && (l.jitter == r.jitter) &&
+             (l.nack_count == r.nack_count) && (l.pli_count == r.pli_count) &&
+             (l.fir_count == r.fir_count) && (l.qp_sum == r.qp_sum) &&
+             (l.jitter_buffer_delay == r.jitter_buffer_delay);
+    }
+    case mrsStatsEntryKind::kTransport: {
+      const mrsTransportStats& l = lhs.transport;
+      const mrsTransportStats& r = rhs.transport;
+      return (l.bytes_sent == r.bytes_sent) &&
+             (l.bytes_received == r.bytes_received) &&
+             (l.current_round_trip_time == r.current_round_trip_time) &&
+             (l.available_outgoing_bitrate == r.available_outgoing_bitrate);
+    }
+  }
+  return false;
+}
+
+/// Collector forwarding a report to its subscription, if still alive.
+class SubscriptionCollector : public webrtc::RTCStatsCollectorCallback {
+ public:
+  explicit SubscriptionCollector(
+      std::weak_ptr<StatsSubscription> subscription) noexcept
+      : subscription_(std::move(subscription)) {}
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override {
+    if (std::shared_ptr<StatsSubscription> subscription =
+            subscription_.lock()) {
+      subscription->OnReport(*report);
+    }
+  }
+
+ private:
+  std::weak_ptr<StatsSubscription> subscription_;
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void StatsSubscription::Collect(
+    webrtc::PeerConnectionInterface& peer) noexcept {
+  if (collecting_) {
+    return;
+  }
+  collecting_ = true;
+  rtc::scoped_refptr<SubscriptionCollector> collector =
+      new rtc::RefCountedObject<SubscriptionCollector>(shared_from_this());
+  peer.GetStats(collector);
+}
+
+mrsStatsEntry& StatsSubscription::AddEntry(mrsStatsEntryKind kind,
+                                           const std::string& key) {
+  // Assign in place to reuse the storage of the strings.
+  if (entry_count_ < entries_.size()) {
+    entries_[entry_count_] = mrsStatsEntry{};
+    keys_[entry_count_] = key;
+  } else {
+    entries_.emplace_back();
+    keys_.push_back(key);
+  }
+  mrsStatsEntry& entry = entries_[entry_count_++];
+  entry.kind = kind;
+  return entry;
+}
+
+bool StatsSubscription::IsUnchanged(size_t index) const noexcept {
+  // Objects are usually reported in the same order, so check the same index
+  // first.
+  size_t previous = index;
+  if ((previous >= previous_entry_count_) ||
+      (previous_keys_[previous] != keys_[index])) {
+    previous = 0;
+    while ((previous < previous_entry_count_) &&
+           (previous_keys_[previous] != keys_[index])) {
+      ++previous;
+    }
+    if (previous == previous_entry_count_) {
+      return false;
+    }
+  }
+  return HaveSameValues(entries_[index], previous_entries_[previous]);
+}
+
+void StatsSubscription::OnReport(
+    const webrtc::RTCStatsReport& report) noexcept {
+  collecting_ = false;
+  entry_count_ = 0;
+  for (const webrtc::RTCStats& stats : report) {
+    if (IsOfType<webrtc::RTCOutboundRTPStreamStats>(stats)) {
+      const auto& rtp_stats =
+          stats.cast_to<webrtc::RTCOutboundRTPStreamStats>();
+      const webrtc::RTCMediaStreamTrackStats* track_stats =
+          GetTrackStats(report, rtp_stats);
+      if (!track_stats) {
+        continue;
+      }
+      if (IsAudio(rtp_stats)) {
+        mrsAudioSenderStats& dest =
+            AddEntry(mrsStatsEntryKind::kAudioSender, stats.id()).audio_sender;
+        FillTrackStats(dest, *track_stats);
+        FillRtpStats(dest, rtp_stats);
+      } else {
+        mrsVideoSenderStats& dest =
+            AddEntry(mrsStatsEntryKind::kVideoSender, stats.id()).video_sender;
+        FillTrackStats(dest, *track_stats);
+        FillRtpStats(dest, rtp_stats);
+      }
+    } else if (IsOfType<webrtc::RTCInboundRTPStreamStats>(stats)) {
+      const auto& rtp_stats =
+          stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
+      const webrtc::RTCMediaStreamTrackStats* track_stats =
+          GetTrackStats(report, rtp_stats);
+      if (!track_stats) {
+        continue;
+      }
+      if (IsAudio(rtp_stats)) {
+        mrsAudioReceiverStats& dest =
+            AddEntry(mrsStatsEntryKind::kAudioReceiver, stats.id())
+                .audio_receiver;
+        FillTrackStats(dest, *track_stats);
+        FillRtpStats(dest, rtp_stats);
+      } else {
+        mrsVideoReceiverStats& dest =
+            AddEntry(mrsStatsEntryKind::kVideoReceiver, stats.id())
+                .video_receiver;
+        FillTrackStats(dest, *track_stats);
+        FillRtpStats(dest, rtp_stats);
+      }
+    } else if (IsOfType<webrtc::RTCDataChannelStats>(stats)) {
+      FillDataChannelStats(
+          AddEntry(mrsStatsEntryKind::kDataChannel, stats.id()).data_channel,
+          stats.cast_to<webrtc::RTCDataChannelStats>());
+    } else if (IsOfType<webrtc::RTCTransportStats>(stats)) {
+      FillTransportStats(
+          AddEntry(mrsStatsEntryKind::kTransport, stats.id()).transport,
+          stats.cast_to<webrtc::RTCTransportStats>(), report);
+    }
+  }
+
+  if (((uint32_t)config_.flags &
+       (uint32_t)mrsStatsSubscriptionFlags::kChangedOnly) != 0) {
+    changed_entries_.clear();
+    for (size_t i = 0; i < entry_count_; ++i) {
+      if (!IsUnchanged(i)) {
+        changed_entries_.push_back(entries_[i]);
+      }
+    }
+    if (!changed_entries_.empty()) {
+      callback_(changed_entries_.data(), (uint32_t)changed_entries_.size());
+    }
+  } else {
+    callback_(entries_.data(), (uint32_t)entry_count_);
+  }
+
+  // Keep this snapshot to compare the next one against it, and reuse the
+  // storage of the previous one.
+  std::swap(entries_, previous_entries_);
+  std::swap(keys_, previous_keys_);
+  previous_entry_count_ = entry_count_;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/peerconnectioninterface.h"
+#include "api/stats/rtcstatsreport.h"
+
+#include "callback.h"
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Callback delivering a stats snapshot as an array of entries.
+using StatsSnapshotCallback = Callback<const mrsStatsEntry*, uint32_t>;
+
+/// Periodic collection of the stats of a peer connection into flat snapshots.
+/// This is only accessed on the signaling thread.
+class StatsSubscription
+    : public std::enable_shared_from_this<StatsSubscription> {
+ public:
+  StatsSubscription(const mrsStatsSubscriptionConfig& config,
+                    StatsSnapshotCallback callback) noexcept
+      : config_(config), callback_(callback) {}
+
+  int interval_ms() const noexcept { return config_.interval_ms; }
+
+  /// Request a new report from the peer connection, and deliver its snapshot
+  /// once ready, unless the subscription is destroyed first. This is a no-op
+  /// while the previous report is being collected, if it is still not ready
+  /// after the interval.
+  void Collect(webrtc::PeerConnectionInterface& peer) noexcept;
+
+  /// Build a snapshot of a report requested by |Collect()| and deliver it to
+  /// the callback.
+  void OnReport(const webrtc::RTCStatsReport& report) noexcept;
+
+ private:
+  /// Append a zero-initialized entry for the object with the given stats ID.
+  mrsStatsEntry& AddEntry(mrsStatsEntryKind kind, const std::string& key);
+
+  /// Check if an entry has the same values as the entry of the same object in
+  /// the previous snapshot, if any.
+  bool IsUnchanged(size_t index) const noexcept;
+
+  const mrsStatsSubscriptionConfig config_;
+  const StatsSnapshotCallback callback_;
+
+  /// A report is being collected.
+  bool collecting_{false};
+
+  /// Entries of the snapshot being built and of the previous one, and the
+  /// stats ID of the object of each entry. The vectors keep their capacity
+  /// across snapshots, so steady-state collection does not allocate.
+  std::vector<mrsStatsEntry> entries_;
+  std::vector<std::string> keys_;
+  size_t entry_count_{0};
+  std::vector<mrsStatsEntry> previous_entries_;
+  std::vector<std::string> previous_keys_;
+  size_t previous_entry_count_{0};
+
+  /// Entries delivered with |mrsStatsSubscriptionFlags::kChangedOnly|.
+  std::vector<mrsStatsEntry> changed_entries_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
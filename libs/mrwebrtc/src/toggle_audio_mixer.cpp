@@ -5,12 +5,66 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "color_conversion.h"
 #include "toggle_audio_mixer.h"
+#include "tracing.h"
+
+namespace {
+
+std::atomic<int> g_parallel_pump_threshold{0};
+
+/// Maximum number of 10ms frames pumped to drain the audio buffered by the
+/// decoder of a paused source. The jitter buffer is bounded anyway, and time
+/// stretches its content when it holds too much, so this is rarely reached.
+constexpr const int kMaxDrainFrameCount = 100;
+
+/// Whether |DrainSource()| is running on the current thread.
+thread_local bool t_draining = false;
+
+}  // namespace
 
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+void ToggleAudioMixer::SetParallelPumpThreshold(int source_count) noexcept {
+  g_parallel_pump_threshold.store(source_count, std::memory_order_relaxed);
+}
+
+bool ToggleAudioMixer::IsDrainingOnThisThread() noexcept {
+  return t_draining;
+}
+
+void ToggleAudioMixer::GainSource::SetGains(float left, float right) noexcept {
+  left_ = left;
+  right_ = right;
+}
+
+webrtc::AudioMixer::Source::AudioFrameInfo
+ToggleAudioMixer::GainSource::GetAudioFrameWithInfo(
+    int sample_rate_hz,
+    webrtc::AudioFrame* audio_frame) {
+  const AudioFrameInfo info =
+      source_->GetAudioFrameWithInfo(sample_rate_hz, audio_frame);
+  ramp_.SetTarget(left_, right_, sample_rate_hz);
+  if ((info != AudioFrameInfo::kNormal) || ramp_.IsUnity() ||
+      (audio_frame->num_channels_ > 2)) {
+    return info;
+  }
+  // Apply the gains on the frame just produced, while still in cache. The
+  // base impl owns the mixing loop, so this is the only pass the gains add.
+  const size_t frame_count = audio_frame->samples_per_channel_;
+  int16_t* const data = audio_frame->mutable_data();
+  if ((audio_frame->num_channels_ == 1) && !ramp_.IsBalanced()) {
+    mono_samples_.assign(data, data + frame_count);
+    ramp_.ApplyUpmix(mono_samples_.data(), data, frame_count);
+    audio_frame->num_channels_ = 2;
+  } else {
+    ramp_.Apply(data, data, frame_count, (int)audio_frame->num_channels_);
+  }
+  return info;
+}
+
 ToggleAudioMixer::ToggleAudioMixer()
     : base_impl_(webrtc::AudioMixerImpl::Create()) {}
 
@@ -19,9 +73,11 @@ bool ToggleAudioMixer::AddSource(Source* audio_source) {
 
   rtc::CritScope lock(&crit_);
   // By default add the source as not output.
-  auto result =
-      source_from_id_.insert({audio_source->Ssrc(), {audio_source, false}});
-  if (!result.second) {
+  auto result = source_from_id_.insert(
+      {audio_source->Ssrc(), {audio_source, false, true}});
+  if (result.second) {
+    redirected_sources_.push_back(audio_source);
+  } else {
     // The source has already been added through PlaySource. Update the Source*.
     auto& known_source = result.first->second;
     RTC_DCHECK(!known_source.source)
@@ -32,6 +88,8 @@ bool ToggleAudioMixer::AddSource(Source* audio_source) {
     // through the base impl.
     if (known_source.is_output) {
       TryAddToBaseImpl(known_source);
+    } else if (known_source.is_consumed) {
+      redirected_sources_.push_back(audio_source);
     }
   }
 
@@ -39,14 +97,78 @@ bool ToggleAudioMixer::AddSource(Source* audio_source) {
 }
 
 void ToggleAudioMixer::TryAddToBaseImpl(KnownSource& known_source) {
-  bool added_succesfully = base_impl_->AddSource(known_source.source);
-  if (!added_succesfully) {
+  if (!known_source.gain_source ||
+      (known_source.gain_source->source() != known_source.source)) {
+    known_source.gain_source =
+        std::make_unique<GainSource>(known_source.source);
+    known_source.gain_source->SetGains(known_source.left_gain,
+                                       known_source.right_gain);
+  }
+  bool added_succesfully =
+      base_impl_->AddSource(known_source.gain_source.get());
+  if (added_succesfully) {
+    ++output_source_count_;
+  } else {
     RTC_LOG_F(LS_ERROR) << "Cannot mix source "
                           << known_source.source->Ssrc();
     known_source.is_output = false;
+    if (known_source.is_consumed) {
+      redirected_sources_.push_back(known_source.source);
+    }
   }
 }
 
+void ToggleAudioMixer::RemoveRedirectedSource(Source* audio_source) {
+  auto it = std::find(redirected_sources_.begin(), redirected_sources_.end(),
+                      audio_source);
+  RTC_DCHECK(it != redirected_sources_.end());
+  if (it != redirected_sources_.end()) {
+    // Order does not matter, avoid shifting the other sources.
+    *it = redirected_sources_.back();
+    redirected_sources_.pop_back();
+  }
+}
+
+void ToggleAudioMixer::ScheduleDrain(Source* audio_source) {
+  if (std::find(drain_sources_.begin(), drain_sources_.end(), audio_source) ==
+      drain_sources_.end()) {
+    drain_sources_.push_back(audio_source);
+  }
+}
+
+void ToggleAudioMixer::CancelDrain(Source* audio_source) {
+  auto it =
+      std::find(drain_sources_.begin(), drain_sources_.end(), audio_source);
+  if (it != drain_sources_.end()) {
+    *it = drain_sources_.back();
+    drain_sources_.pop_back();
+  }
+}
+
+void ToggleAudioMixer::DrainSource(Source* audio_source) {
+  // While paused the source keeps receiving packets, which its jitter buffer
+  // would otherwise play back, time stretched, once resumed. Pump it until
+  // the buffer runs dry and the decoder starts concealing, so that it resumes
+  // at the live edge. The frames are discarded, by the frame sinks of the
+  // source for the ones it delivers to its consumers.
+  MRS_TRACE_SCOPE1(Media, "ToggleAudioMixer::DrainSource", "ssrc",
+                   audio_source->Ssrc());
+  if (!drain_frame_) {
+    drain_frame_ = std::make_unique<webrtc::AudioFrame>();
+  }
+  t_draining = true;
+  const int sample_rate = audio_source->PreferredSampleRate();
+  for (int i = 0; i < kMaxDrainFrameCount; ++i) {
+    const auto audio_frame_info =
+        audio_source->GetAudioFrameWithInfo(sample_rate, drain_frame_.get());
+    if ((audio_frame_info != Source::AudioFrameInfo::kNormal) ||
+        (drain_frame_->speech_type_ != webrtc::AudioFrame::kNormalSpeech)) {
+      break;
+    }
+  }
+  t_draining = false;
+}
+
 void ToggleAudioMixer::RemoveSource(Source* audio_source) {
   RTC_DCHECK(audio_source);
 
@@ -58,8 +180,12 @@ void ToggleAudioMixer::RemoveSource(Source* audio_source) {
 
   if (iter->second.is_output) {
     // Stop mixing the source.
-    base_impl_->RemoveSource(audio_source);
+    base_impl_->RemoveSource(iter->second.gain_source.get());
+    --output_source_count_;
+  } else if (iter->second.is_consumed) {
+    RemoveRedirectedSource(audio_source);
   }
+  CancelDrain(audio_source);
   // Forget the source.
   source_from_id_.erase(iter);
 }
@@ -68,19 +194,25 @@ static const int16_t zerobuf[200]{};
 
 void ToggleAudioMixer::Mix(size_t number_of_channels,
                            webrtc::AudioFrame* audio_frame_for_mixing) {
-  std::vector<Source*> redirected_sources;
+  MRS_TRACE_SCOPE1(Media, "ToggleAudioMixer::Mix", "channels",
+                   number_of_channels);
   bool some_source_is_output = false;
   {
     rtc::CritScope lock(&crit_);
 
-    // Collect the redirected sources.
-    for (auto&& pair : source_from_id_) {
-      if (!pair.second.is_output) {
-        redirected_sources.push_back(pair.second.source);
-      } else {
-        some_source_is_output = true;
-      }
+    // Drain the sources resuming since the previous mix, before they are
+    // pumped or mixed below. This decodes on the audio device thread rather
+    // than on the thread resuming the source.
+    for (Source* source : drain_sources_) {
+      DrainSource(source);
     }
+    drain_sources_.clear();
+
+    // Copy the redirected sources, without allocating once the capacity is
+    // large enough.
+    pump_sources_.assign(redirected_sources_.begin(),
+                         redirected_sources_.end());
+    some_source_is_output = (output_source_count_ > 0);
 
     if (some_source_is_output) {
       // Mix output sources using the base impl. Do inside the lock in case
@@ -89,17 +221,7 @@ void ToggleAudioMixer::Mix(size_t number_of_channels,
     }
   }
 
-  for (auto& source : redirected_sources) {
-    // This pumps the source and fires the frame observer callbacks
-    // which in turn fill the AudioTrackReadBuffer buffers
-    const auto audio_frame_info = source->GetAudioFrameWithInfo(
-        source->PreferredSampleRate(), audio_frame_for_mixing);
-
-    if (audio_frame_info == Source::AudioFrameInfo::kError) {
-      RTC_LOG_F(LS_WARNING) << "failed to GetAudioFrameWithInfo() from source";
-      continue;
-    }
-  }
+  PumpRedirectedSources();
 
   if (!some_source_is_output) {
     // Return an empty frame.
@@ -109,28 +231,125 @@ void ToggleAudioMixer::Mix(size_t number_of_channels,
   }
 }
 
+void ToggleAudioMixer::PumpRedirectedSources() {
+  const size_t count = pump_sources_.size();
+  if (count == 0) {
+    return;
+  }
+  const int threshold =
+      g_parallel_pump_threshold.load(std::memory_order_relaxed);
+  const bool parallel = (threshold > 0) && (count >= (size_t)threshold);
+
+  // Pump into separate frames rather than into the mixing frame, which holds
+  // the mix of the output sources. Sources pumped in parallel each need their
+  // own frame.
+  const size_t frame_count = (parallel ? count : 1);
+  while (pump_frames_.size() < frame_count) {
+    pump_frames_.push_back(std::make_unique<webrtc::AudioFrame>());
+  }
+
+  auto pump = [this](int begin, int end, bool own_frame) {
+    for (int i = begin; i < end; ++i) {
+      // This pumps the source and fires the frame observer callbacks
+      // which in turn fill the AudioTrackReadBuffer buffers
+      Source* const source = pump_sources_[i];
+      webrtc::AudioFrame* const frame = pump_frames_[own_frame ? i : 0].get();
+      const auto audio_frame_info =
+          source->GetAudioFrameWithInfo(source->PreferredSampleRate(), frame);
+
+      if (audio_frame_info == Source::AudioFrameInfo::kError) {
+        RTC_LOG_F(LS_WARNING)
+            << "failed to GetAudioFrameWithInfo() from source";
+        continue;
+      }
+    }
+  };
+  if (parallel) {
+    // Each source is pumped by a single thread, and the next mix only starts
+    // once all are done, so the frames of a source remain in order.
+    ForEachRangeParallel(static_cast<int>(count), [&pump](int begin, int end) {
+      pump(begin, end, true);
+    });
+  } else {
+    pump(0, static_cast<int>(count), false);
+  }
+}
+
 void ToggleAudioMixer::OutputSource(int ssrc, bool output) {
   rtc::CritScope lock(&crit_);
 
   // If the source is unknown add a KnownSource with null Source* to remember
   // the choice.
-  const auto result = source_from_id_.insert({ssrc, {nullptr, output}});
+  const auto result = source_from_id_.insert({ssrc, {nullptr, output, true}});
   KnownSource& known_source = result.first->second;
   if (known_source.source) {
     // The source has already been added through AddSource. Modify the output
     // state.
     if (output && !known_source.is_output) {
       // Add the source to the ones mixed by the base impl.
+      if (known_source.is_consumed) {
+        RemoveRedirectedSource(known_source.source);
+      } else {
+        ScheduleDrain(known_source.source);
+      }
+      known_source.is_output = true;
       TryAddToBaseImpl(known_source);
     } else if (!output && known_source.is_output) {
       // Remove the source from the ones mixed by the base impl.
-      base_impl_->RemoveSource(known_source.source);
+      base_impl_->RemoveSource(known_source.gain_source.get());
+      --output_source_count_;
+      known_source.is_output = false;
+      if (known_source.is_consumed) {
+        redirected_sources_.push_back(known_source.source);
+      } else {
+        // Paused again, and drained whenever it resumes.
+        CancelDrain(known_source.source);
+      }
     }
     // else the state of the source is unchanged.
+  } else {
+    // Not added yet; remember the choice for AddSource.
     known_source.is_output = output;
   }
 }
 
+void ToggleAudioMixer::SetSourceConsumed(int ssrc, bool consumed) {
+  rtc::CritScope lock(&crit_);
+
+  // As with OutputSource(), remember the choice for an unknown source.
+  const auto result =
+      source_from_id_.insert({ssrc, {nullptr, false, consumed}});
+  KnownSource& known_source = result.first->second;
+  if (known_source.is_consumed == consumed) {
+    return;
+  }
+  known_source.is_consumed = consumed;
+  if (!known_source.source || known_source.is_output) {
+    // Output sources are pumped by the base impl in any case.
+    return;
+  }
+  if (consumed) {
+    ScheduleDrain(known_source.source);
+    redirected_sources_.push_back(known_source.source);
+  } else {
+    RemoveRedirectedSource(known_source.source);
+    CancelDrain(known_source.source);
+  }
+}
+
+void ToggleAudioMixer::SetSourceGains(int ssrc, float left, float right) {
+  rtc::CritScope lock(&crit_);
+
+  // As with OutputSource(), remember the gains for an unknown source.
+  const auto result = source_from_id_.insert({ssrc, {nullptr, false, true}});
+  KnownSource& known_source = result.first->second;
+  known_source.left_gain = left;
+  known_source.right_gain = right;
+  if (known_source.gain_source) {
+    known_source.gain_source->SetGains(left, right);
+  }
+}
+
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
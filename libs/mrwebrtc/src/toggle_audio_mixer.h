@@ -3,11 +3,25 @@
 
 #pragma once
 
+#include "gain_ramp.h"
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
 /// Can mix selected audio sources only.
+///
+/// Sources not output to the audio device are redirected: they are still
+/// pumped on each mix, to fire their frame observers, but their audio is not
+/// mixed. The sets of output and redirected sources are maintained
+/// incrementally as sources are added, removed, and toggled, so that |Mix()|
+/// does not need to walk all known sources.
+///
+/// Redirected sources with no consumer are paused: they are not pumped at all,
+/// which skips their decoding. When a source resumes, the audio its decoder
+/// buffered in the meantime is drained by the next |Mix()|, on the audio
+/// device thread, before the source is pumped or mixed again. The frame sinks
+/// of the source discard the drained audio, see |IsDrainingOnThisThread()|.
 class ToggleAudioMixer : public webrtc::AudioMixer {
  public:
   ToggleAudioMixer();
@@ -21,17 +35,101 @@ class ToggleAudioMixer : public webrtc::AudioMixer {
   // Select if the source with the given id must be output to the audio device.
   void OutputSource(int ssrc, bool output);
 
+  /// Select if the source with the given id has any consumer beside the audio
+  /// device, like a frame callback or a read buffer, and must be pumped even
+  /// when not output. Sources are consumed by default until this is called.
+  /// Call this before the first consumer attaches, and after the last one
+  /// detaches, so that consumers never see stale audio.
+  void SetSourceConsumed(int ssrc, bool consumed);
+
+  /// Set the gains of the left and right channels of the source with the
+  /// given id when output to the audio device. Gain changes ramp smoothly.
+  void SetSourceGains(int ssrc, float left, float right);
+
+  /// Set the minimum number of redirected sources for |Mix()| to pump them in
+  /// parallel on a worker pool. Zero disables parallel pumping.
+  static void SetParallelPumpThreshold(int source_count) noexcept;
+
+  /// Whether the current thread is draining the stale audio of a resuming
+  /// source. The frame sinks of the sources discard the frames they receive
+  /// meanwhile, which no consumer must see.
+  static bool IsDrainingOnThisThread() noexcept;
+
  private:
+  /// Source mixed in place of an output source, applying its gains to the
+  /// frames it produces, in place, as the base impl pumps them. Mono frames
+  /// are upmixed to stereo when panned.
+  class GainSource : public Source {
+   public:
+    explicit GainSource(Source* source) noexcept : source_(source) {}
+    Source* source() const noexcept { return source_; }
+    void SetGains(float left, float right) noexcept;
+
+    // Source implementation.
+    AudioFrameInfo GetAudioFrameWithInfo(
+        int sample_rate_hz,
+        webrtc::AudioFrame* audio_frame) override;
+    int Ssrc() const override { return source_->Ssrc(); }
+    int PreferredSampleRate() const override {
+      return source_->PreferredSampleRate();
+    }
+
+   private:
+    Source* const source_;
+
+    /// Target gains, only written with the lock of the mixer held, which
+    /// |Mix()| also holds while the base impl pumps the sources.
+    float left_{1.0f};
+    float right_{1.0f};
+
+    /// Ramp and upmix buffer, only accessed on the audio device thread.
+    GainRamp ramp_;
+    std::vector<int16_t> mono_samples_;
+  };
+
   struct KnownSource {
     Source* source;
     bool is_output;
+    bool is_consumed;
+    float left_gain{1.0f};
+    float right_gain{1.0f};
+
+    /// Wrapper of |source| mixed by the base impl while output.
+    std::unique_ptr<GainSource> gain_source;
   };
 
   void TryAddToBaseImpl(KnownSource& audio_source);
+  void RemoveRedirectedSource(Source* audio_source);
+  void ScheduleDrain(Source* audio_source);
+  void CancelDrain(Source* audio_source);
+  void DrainSource(Source* audio_source);
+  void PumpRedirectedSources();
 
   rtc::CriticalSection crit_;
   rtc::scoped_refptr<webrtc::AudioMixerImpl> base_impl_;
   std::map<int, KnownSource> source_from_id_;
+
+  /// Sources added and consumed but not output, pumped by |Mix()| without
+  /// being mixed.
+  std::vector<Source*> redirected_sources_ RTC_GUARDED_BY(crit_);
+
+  /// Number of sources currently mixed by |base_impl_|.
+  int output_source_count_ RTC_GUARDED_BY(crit_) = 0;
+
+  /// Sources resumed since the previous mix, drained by the next |Mix()|
+  /// before being pumped.
+  std::vector<Source*> drain_sources_ RTC_GUARDED_BY(crit_);
+
+  /// Frame the stale audio of resuming sources is drained into.
+  std::unique_ptr<webrtc::AudioFrame> drain_frame_ RTC_GUARDED_BY(crit_);
+
+  /// Copy of |redirected_sources_| pumped by |Mix()| outside the lock. Only
+  /// accessed on the audio device thread, and reused to avoid allocations.
+  std::vector<Source*> pump_sources_;
+
+  /// Frames the redirected sources are pumped into, one per source pumped in
+  /// parallel. Only accessed on the audio device thread, and grown as needed.
+  std::vector<std::unique_ptr<webrtc::AudioFrame>> pump_frames_;
 };
 
 }  // namespace WebRTC
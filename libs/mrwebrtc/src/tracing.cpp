@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "tracing.h"
+
+#if defined(MR_SHARING_WIN)
+
+// Same provider as the managed MainEventSource.
+// {00AEE89E-B531-4F20-A2C5-D02F37CB6AA1}
+TRACELOGGING_DEFINE_PROVIDER(
+    g_mrsTraceProvider,
+    "Microsoft.MixedReality.WebRTC",
+    (0x00aee89e, 0xb531, 0x4f20, 0xa2, 0xc5, 0xd0, 0x2f, 0x37, 0xcb, 0x6a,
+     0xa1));
+
+namespace {
+
+/// Registration of the provider for the lifetime of the module. The provider
+/// must be unregistered before the module is unloaded.
+struct ProviderRegistration {
+  ProviderRegistration() noexcept { TraceLoggingRegister(g_mrsTraceProvider); }
+  ~ProviderRegistration() noexcept {
+    TraceLoggingUnregister(g_mrsTraceProvider);
+  }
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+namespace tracing {
+
+void RegisterProvider() noexcept {
+  static ProviderRegistration s_registration;
+}
+
+}  // namespace tracing
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#endif  // defined(MR_SHARING_WIN)
@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+
+// Scoped trace events around the hot paths of the library.
+//
+// On Windows these are TraceLogging (ETW) events of the
+// "Microsoft.MixedReality.WebRTC" provider, with the same GUID as the managed
+// event source, so the WPR profile in tools/tracing/ records both. Each scope
+// writes a start event carrying its arguments and a stop event with the same
+// activity ID. The keywords of the categories match those of the managed
+// event source, and the Interop category of the callbacks invoked into the
+// application is specific to the native library.
+//
+// On Android these are ATrace sections, which can be recorded with Perfetto
+// or systrace, and which do not carry arguments. Elsewhere, or on Android
+// before API level 23, these are WebRTC trace events.
+//
+// Usage:
+//   MRS_TRACE_SCOPE(Media, "Name");
+//   MRS_TRACE_SCOPE1(Media, "Name", "arg_name", arg_value);
+//   MRS_TRACE_SCOPE2(Media, "Name", "arg1", value1, "arg2", value2);
+// where the category is one of the MRS_TRACE_KEYWORD_xxx suffixes, and names
+// are string literals. Arguments are recorded as 64-bit signed integers.
+//
+// Scopes are verbose events, which cost a single check of the state of the
+// provider when not recorded.
+
+#define MRS_TRACE_KEYWORD_Connection 0x1
+#define MRS_TRACE_KEYWORD_Sdp 0x2
+#define MRS_TRACE_KEYWORD_Media 0x4
+#define MRS_TRACE_KEYWORD_DataChannel 0x8
+#define MRS_TRACE_KEYWORD_Interop 0x10
+
+#define MRS_TRACE_CONCAT_IMPL(a, b) a##b
+#define MRS_TRACE_CONCAT(a, b) MRS_TRACE_CONCAT_IMPL(a, b)
+#define MRS_TRACE_VAR MRS_TRACE_CONCAT(mrs_trace_scope_, __LINE__)
+
+#if defined(MR_SHARING_WIN)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+
+TRACELOGGING_DECLARE_PROVIDER(g_mrsTraceProvider);
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+namespace tracing {
+
+/// Register the trace provider, if not already done. This is called when the
+/// library is initialized; events written before are discarded.
+void RegisterProvider() noexcept;
+
+/// Activity of a trace scope, writing the stop event of the scope on
+/// destruction if the start event was written.
+template <uint64_t Keyword>
+class ScopedActivity {
+ public:
+  ScopedActivity() noexcept
+      : enabled_(TraceLoggingProviderEnabled(g_mrsTraceProvider,
+                                             WINEVENT_LEVEL_VERBOSE,
+                                             Keyword)) {
+    if (enabled_) {
+      EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &activity_id_);
+    }
+  }
+
+  ~ScopedActivity() noexcept {
+    if (enabled_) {
+      TraceLoggingWriteActivity(g_mrsTraceProvider, "Stop", &activity_id_,
+                                nullptr, TraceLoggingKeyword(Keyword),
+                                TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                                TraceLoggingOpcode(WINEVENT_OPCODE_STOP));
+    }
+  }
+
+  bool enabled() const noexcept { return enabled_; }
+  const GUID* activity_id() const noexcept { return &activity_id_; }
+
+ private:
+  const bool enabled_;
+  GUID activity_id_{};
+};
+
+}  // namespace tracing
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+/// Write the start event of the scope |var| with the fields |...|, which
+/// start with the keyword, level and opcode of the event.
+#define MRS_TRACE_SCOPE_IMPL(var, category, name, ...)                      \
+  ::Microsoft::MixedReality::WebRTC::tracing::ScopedActivity<               \
+      MRS_TRACE_KEYWORD_##category>                                         \
+      var;                                                                  \
+  if (var.enabled()) {                                                      \
+    TraceLoggingWriteActivity(g_mrsTraceProvider, name, var.activity_id(),  \
+                              nullptr, __VA_ARGS__);                        \
+  }
+#define MRS_TRACE_START_FIELDS(category)                \
+  TraceLoggingKeyword(MRS_TRACE_KEYWORD_##category),    \
+      TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),        \
+      TraceLoggingOpcode(WINEVENT_OPCODE_START)
+
+#define MRS_TRACE_SCOPE(category, name)               \
+  MRS_TRACE_SCOPE_IMPL(MRS_TRACE_VAR, category, name, \
+                       MRS_TRACE_START_FIELDS(category))
+#define MRS_TRACE_SCOPE1(category, name, arg1_name, arg1) \
+  MRS_TRACE_SCOPE_IMPL(MRS_TRACE_VAR, category, name,     \
+                       MRS_TRACE_START_FIELDS(category),  \
+                       TraceLoggingInt64((int64_t)(arg1), arg1_name))
+#define MRS_TRACE_SCOPE2(category, name, arg1_name, arg1, arg2_name, arg2) \
+  MRS_TRACE_SCOPE_IMPL(MRS_TRACE_VAR, category, name,                      \
+                       MRS_TRACE_START_FIELDS(category),                   \
+                       TraceLoggingInt64((int64_t)(arg1), arg1_name),      \
+                       TraceLoggingInt64((int64_t)(arg2), arg2_name))
+
+#elif defined(MR_SHARING_ANDROID) && (__ANDROID_API__ >= 23)
+
+#include <android/trace.h>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+namespace tracing {
+
+inline void RegisterProvider() noexcept {}
+
+/// ATrace section of a trace scope.
+class ScopedSection {
+ public:
+  explicit ScopedSection(const char* name) noexcept
+      : enabled_(ATrace_isEnabled()) {
+    if (enabled_) {
+      ATrace_beginSection(name);
+    }
+  }
+  ~ScopedSection() noexcept {
+    if (enabled_) {
+      ATrace_endSection();
+    }
+  }
+
+ private:
+  const bool enabled_;
+};
+
+}  // namespace tracing
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#define MRS_TRACE_SCOPE(category, name) \
+  ::Microsoft::MixedReality::WebRTC::tracing::ScopedSection MRS_TRACE_VAR(name)
+#define MRS_TRACE_SCOPE1(category, name, arg1_name, arg1) \
+  MRS_TRACE_SCOPE(category, name)
+#define MRS_TRACE_SCOPE2(category, name, arg1_name, arg1, arg2_name, arg2) \
+  MRS_TRACE_SCOPE(category, name)
+
+#else
+
+#include "rtc_base/trace_event.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+namespace tracing {
+
+inline void RegisterProvider() noexcept {}
+
+}  // namespace tracing
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+#define MRS_TRACE_SCOPE(category, name) \
+  TRACE_EVENT0("mrwebrtc," #category, name)
+#define MRS_TRACE_SCOPE1(category, name, arg1_name, arg1) \
+  TRACE_EVENT1("mrwebrtc," #category, name, arg1_name, (int64_t)(arg1))
+#define MRS_TRACE_SCOPE2(category, name, arg1_name, arg1, arg2_name, arg2) \
+  TRACE_EVENT2("mrwebrtc," #category, name, arg1_name, (int64_t)(arg1),   \
+               arg2_name, (int64_t)(arg2))
+
+#endif
@@ -31,8 +31,14 @@ enum class ObjectType : int {
   kDeviceAudioTrackSource,
   kDeviceVideoTrackSource,
   kExternalVideoTrackSource,
+  kRelayVideoTrackSource,
+  kExternalEncodedVideoTrackSource,
+  kExternalAudioTrackSource,
 };
 
+/// Number of values of |ObjectType|.
+constexpr int kObjectTypeCount = (int)ObjectType::kExternalAudioTrackSource + 1;
+
 /// Object tracked for interop, exposing helper methods for debugging purpose.
 /// This is the base class for both mrsObject and mrsRefCountedObject, as
 /// internally all objects are reference-counted for historical reasons, but as
@@ -7,6 +7,7 @@
 #include "mrs_errors.h"
 #include "result.h"
 #include "remote_audio_track_interop.h"
+#include "sdp_utils.h"
 #include "utils.h"
 
 namespace Microsoft {
@@ -72,6 +73,104 @@ cricket::MediaType MediaKindToRtc(mrsMediaKind media_kind) {
   }
 }
 
+ErrorOr<webrtc::RtpEncodingParameters> EncodingParametersToRtc(
+    const mrsRtpEncodingParameters& params) {
+  if (!IsStringNullOrEmpty(params.rid) && !SdpIsValidToken(params.rid)) {
+    rtc::StringBuilder str("Invalid encoding RID: ");
+    str << params.rid;
+    return Error(Result::kInvalidParameter, str.Release());
+  }
+  if (!(params.scale_resolution_down_by >= 1.0)) {
+    return Error(Result::kInvalidParameter,
+                 "Encoding resolution scale factor must be at least 1.");
+  }
+  if ((params.max_bitrate_bps < 0) || (params.max_framerate < 0)) {
+    return Error(Result::kInvalidParameter,
+                 "Encoding bitrate and framerate limits cannot be negative.");
+  }
+  if (!(params.bitrate_priority > 0.0)) {
+    return Error(Result::kInvalidParameter,
+                 "Encoding bitrate priority must be positive.");
+  }
+  if (!IsStringNullOrEmpty(params.scalability_mode)) {
+    ErrorOr<ScalabilityMode> mode =
+        ParseScalabilityMode(params.scalability_mode);
+    if (!mode.ok()) {
+      return mode.MoveError();
+    }
+  }
+  webrtc::RtpEncodingParameters encoding;
+  if (!IsStringNullOrEmpty(params.rid)) {
+    encoding.rid = params.rid;
+  }
+  // Leave the default unset, which implementations not supporting resolution
+  // scaling accept.
+  if (params.scale_resolution_down_by > 1.0) {
+    encoding.scale_resolution_down_by = params.scale_resolution_down_by;
+  }
+  if (params.max_bitrate_bps > 0) {
+    encoding.max_bitrate_bps = params.max_bitrate_bps;
+  }
+  if (params.max_framerate > 0) {
+    encoding.max_framerate = params.max_framerate;
+  }
+  encoding.active = (params.active != mrsBool::kFalse);
+  encoding.bitrate_priority = params.bitrate_priority;
+  return encoding;
+}
+
+ErrorOr<ScalabilityMode> ParseScalabilityMode(const char* mode) {
+  // Only the modes the VP9 encoder supports with its default layer structure
+  // are accepted, and none of the "S" modes of independent spatial layers.
+  if ((strlen(mode) != 4) || (mode[0] != 'L') || (mode[1] < '1') ||
+      (mode[1] > '3') || (mode[2] != 'T') || (mode[3] < '1') ||
+      (mode[3] > '3')) {
+    rtc::StringBuilder str("Invalid scalability mode: ");
+    str << mode;
+    return Error(Result::kInvalidParameter, str.Release());
+  }
+  ScalabilityMode scalability_mode;
+  scalability_mode.spatial_layers = mode[1] - '0';
+  scalability_mode.temporal_layers = mode[3] - '0';
+  return scalability_mode;
+}
+
+Error CheckScalabilityMode(mrsMediaKind media_kind,
+                           const mrsRtpEncodingParameters* encodings,
+                           int count,
+                           const ScalabilityMode& vp9_layers) {
+  for (int i = 0; i < count; ++i) {
+    if (IsStringNullOrEmpty(encodings[i].scalability_mode)) {
+      continue;
+    }
+    if (media_kind != mrsMediaKind::kVideo) {
+      return Error(Result::kInvalidParameter,
+                   "Scalability modes only apply to video encodings.");
+    }
+    if (count > 1) {
+      return Error(Result::kUnsupported,
+                   "Scalability modes cannot be combined with simulcast.");
+    }
+    ErrorOr<ScalabilityMode> mode =
+        ParseScalabilityMode(encodings[i].scalability_mode);
+    if (!mode.ok()) {
+      return mode.MoveError();
+    }
+    // This version of WebRTC configures the layers of all VP9 encoders at
+    // once, so an encoding cannot have layers of its own.
+    if ((mode.value().spatial_layers != vp9_layers.spatial_layers) ||
+        (mode.value().temporal_layers != vp9_layers.temporal_layers)) {
+      rtc::StringBuilder str("Scalability mode ");
+      str << encodings[i].scalability_mode
+          << " differs from the VP9 scalability mode L"
+          << vp9_layers.spatial_layers << "T" << vp9_layers.temporal_layers
+          << " of the library.";
+      return Error(Result::kInvalidParameter, str.Release());
+    }
+  }
+  return Error::OK();
+}
+
 const char* ToString(cricket::MediaType media_type) {
   switch (media_type) {
     case cricket::MediaType::MEDIA_TYPE_AUDIO:
@@ -128,6 +227,12 @@ absl::string_view ObjectTypeToString(ObjectType type) {
       return "DeviceVideoTrackSource";
     case ObjectType::kExternalVideoTrackSource:
       return "ExternalVideoTrackSource";
+    case ObjectType::kRelayVideoTrackSource:
+      return "RelayVideoTrackSource";
+    case ObjectType::kExternalEncodedVideoTrackSource:
+      return "ExternalEncodedVideoTrackSource";
+    case ObjectType::kExternalAudioTrackSource:
+      return "ExternalAudioTrackSource";
     default:
       RTC_NOTREACHED();
       return "<UnknownObjectType>";
@@ -52,6 +52,28 @@ Error ErrorFromRTCError(webrtc::RTCError&& error);
 mrsMediaKind MediaKindFromRtc(cricket::MediaType media_type);
 cricket::MediaType MediaKindToRtc(mrsMediaKind media_kind);
 
+/// Check the parameters of an encoding and convert them to their WebRTC
+/// counterpart.
+ErrorOr<webrtc::RtpEncodingParameters> EncodingParametersToRtc(
+    const mrsRtpEncodingParameters& params);
+
+/// Layers of an SVC encoding.
+struct ScalabilityMode {
+  int spatial_layers{1};
+  int temporal_layers{1};
+};
+
+/// Parse a scalability mode name, like "L3T3".
+ErrorOr<ScalabilityMode> ParseScalabilityMode(const char* mode);
+
+/// Check that the scalability mode of the encodings of a transceiver of the
+/// given media kind, if any, applies to them, and matches the |vp9_layers| of
+/// all the VP9 encoders of the process.
+Error CheckScalabilityMode(mrsMediaKind media_kind,
+                           const mrsRtpEncodingParameters* encodings,
+                           int count,
+                           const ScalabilityMode& vp9_layers);
+
 const char* ToString(cricket::MediaType media_type);
 const char* ToString(webrtc::RtpTransceiverDirection dir);
 const char* ToString(bool value);
@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "video_codec_factory.h"
+
+#include "absl/strings/match.h"
+#include "api/video_codecs/video_decoder_software_fallback_wrapper.h"
+#include "api/video_codecs/video_encoder_software_fallback_wrapper.h"
+#include "media/base/h264_profile_level_id.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace {
+
+/// Check if two formats designate the same codec. H.264 formats also need the
+/// same profile, which decoders and encoders cannot convert between.
+bool IsSameFormat(const webrtc::SdpVideoFormat& a,
+                  const webrtc::SdpVideoFormat& b) {
+  if (!absl::EqualsIgnoreCase(a.name, b.name)) {
+    return false;
+  }
+  if (absl::EqualsIgnoreCase(a.name, "H264")) {
+    return webrtc::H264::IsSameH264Profile(a.parameters, b.parameters);
+  }
+  return true;
+}
+
+bool IsFormatSupported(const std::vector<webrtc::SdpVideoFormat>& formats,
+                       const webrtc::SdpVideoFormat& format) {
+  for (auto&& supported : formats) {
+    if (IsSameFormat(supported, format)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Append to the formats of |primary| the formats of |fallback| not already
+/// listed, so that the primary formats are preferred during negotiation.
+std::vector<webrtc::SdpVideoFormat> MergeFormats(
+    std::vector<webrtc::SdpVideoFormat> primary,
+    const std::vector<webrtc::SdpVideoFormat>& fallback) {
+  const size_t primary_count = primary.size();
+  for (auto&& format : fallback) {
+    bool found = false;
+    for (size_t i = 0; i < primary_count; ++i) {
+      if (IsSameFormat(primary[i], format)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      primary.push_back(format);
+    }
+  }
+  return primary;
+}
+
+/// Name of the field trial configuring the layers of the VP9 encoders.
+constexpr char kVp9LayersFieldTrial[] = "WebRTC-SupportVP9SVC/";
+
+/// Field trials of the application, without the trial of the VP9 layers.
+std::string& AppFieldTrials() {
+  static std::string trials;
+  return trials;
+}
+
+/// Field trials currently applied, which WebRTC keeps a pointer to.
+std::unique_ptr<std::string>& AppliedFieldTrials() {
+  static std::unique_ptr<std::string> trials;
+  return trials;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void ApplyVp9Layers(int spatial_layers, int temporal_layers) noexcept {
+  RTC_DCHECK((spatial_layers >= 1) && (spatial_layers <= 3));
+  RTC_DCHECK((temporal_layers >= 1) && (temporal_layers <= 3));
+  // Keep the field trials the application set since the last call, if any.
+  std::unique_ptr<std::string>& applied = AppliedFieldTrials();
+  const char* const current = webrtc::field_trial::GetFieldTrialString();
+  if (!applied || (current != applied->c_str())) {
+    AppFieldTrials() = (current ? current : "");
+  }
+  auto trials = absl::make_unique<std::string>(AppFieldTrials());
+  if ((spatial_layers > 1) || (temporal_layers > 1)) {
+    if (trials->find(kVp9LayersFieldTrial) != std::string::npos) {
+      RTC_LOG(LS_WARNING) << "The field trials of the application already "
+                             "configure the VP9 layers; ignoring the VP9 "
+                             "scalability mode.";
+    } else {
+      rtc::StringBuilder trial(kVp9LayersFieldTrial);
+      trial << "EnabledByFlag_" << spatial_layers << "SL" << temporal_layers
+            << "TL/";
+      trials->append(trial.str());
+    }
+  }
+  // WebRTC keeps a pointer to the string, so only release the previous one
+  // once replaced.
+  webrtc::field_trial::InitFieldTrialsFromString(trials->c_str());
+  applied = std::move(trials);
+}
+
+std::vector<webrtc::SdpVideoFormat>
+FallbackVideoEncoderFactory::GetSupportedFormats() const {
+  return MergeFormats(primary_->GetSupportedFormats(),
+                      fallback_.GetSupportedFormats());
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+FallbackVideoEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  if (IsFormatSupported(primary_->GetSupportedFormats(), format)) {
+    return primary_->QueryVideoEncoder(format);
+  }
+  return fallback_.QueryVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+FallbackVideoEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  const bool has_fallback =
+      IsFormatSupported(fallback_.GetSupportedFormats(), format);
+  if (IsFormatSupported(primary_->GetSupportedFormats(), format)) {
+    if (std::unique_ptr<webrtc::VideoEncoder> encoder =
+            primary_->CreateVideoEncoder(format)) {
+      if (!has_fallback) {
+        return encoder;
+      }
+      return webrtc::CreateVideoEncoderSoftwareFallbackWrapper(
+          fallback_.CreateVideoEncoder(format), std::move(encoder));
+    }
+    RTC_LOG(LS_WARNING) << "Custom video encoder factory failed to create a "
+                        << format.name << " encoder; using built-in encoder.";
+  }
+  if (has_fallback) {
+    return fallback_.CreateVideoEncoder(format);
+  }
+  return nullptr;
+}
+
+std::vector<webrtc::SdpVideoFormat>
+FallbackVideoDecoderFactory::GetSupportedFormats() const {
+  return MergeFormats(primary_->GetSupportedFormats(),
+                      fallback_.GetSupportedFormats());
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+FallbackVideoDecoderFactory::CreateVideoDecoder(
+    const webrtc::SdpVideoFormat& format) {
+  const bool has_fallback =
+      IsFormatSupported(fallback_.GetSupportedFormats(), format);
+  if (IsFormatSupported(primary_->GetSupportedFormats(), format)) {
+    if (std::unique_ptr<webrtc::VideoDecoder> decoder =
+            primary_->CreateVideoDecoder(format)) {
+      if (!has_fallback) {
+        return decoder;
+      }
+      return webrtc::CreateVideoDecoderSoftwareFallbackWrapper(
+          fallback_.CreateVideoDecoder(format), std::move(decoder));
+    }
+    RTC_LOG(LS_WARNING) << "Custom video decoder factory failed to create a "
+                        << format.name << " decoder; using built-in decoder.";
+  }
+  if (has_fallback) {
+    return fallback_.CreateVideoDecoder(format);
+  }
+  return nullptr;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "api/video_codecs/video_decoder_factory.h"
+#include "api/video_codecs/video_encoder_factory.h"
+#include "media/engine/internaldecoderfactory.h"
+#include "media/engine/internalencoderfactory.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Set the number of spatial and temporal layers of the VP9 encoders, from 1
+/// to 3 each. This version of WebRTC reads them from a process-wide field
+/// trial each time it configures a VP9 encoder, so this must only be called
+/// while no encoder exists, when the library initializes. The trial is
+/// appended to the field trials of the application, which are kept, and a
+/// single layer of each kind leaves them unchanged.
+void ApplyVp9Layers(int spatial_layers, int temporal_layers) noexcept;
+
+/// Video encoder factory preferring the encoders of a custom factory, for
+/// example hardware encoders, over the built-in software encoders. Formats
+/// supported by both are created with a software fallback, which takes over if
+/// the custom encoder fails to initialize or encode.
+class FallbackVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  explicit FallbackVideoEncoderFactory(
+      std::unique_ptr<webrtc::VideoEncoderFactory> primary) noexcept
+      : primary_(std::move(primary)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoEncoderFactory> primary_;
+  webrtc::InternalEncoderFactory fallback_;
+};
+
+/// Video decoder factory preferring the decoders of a custom factory, for
+/// example hardware decoders, over the built-in software decoders. Formats
+/// supported by both are created with a software fallback, which takes over if
+/// the custom decoder fails to initialize or decode.
+class FallbackVideoDecoderFactory : public webrtc::VideoDecoderFactory {
+ public:
+  explicit FallbackVideoDecoderFactory(
+      std::unique_ptr<webrtc::VideoDecoderFactory> primary) noexcept
+      : primary_(std::move(primary)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoDecoder> CreateVideoDecoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoderFactory> primary_;
+  webrtc::InternalDecoderFactory fallback_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -4,6 +4,15 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <mutex>
+
+#include "system_wrappers/include/clock.h"
+
+#include "color_conversion.h"
+#include "encoded_frame_tap.h"
+#include "latency_marker.h"
+#include "tracing.h"
 #include "video_frame_observer.h"
 
 namespace {
@@ -11,6 +20,74 @@ namespace {
 // Aligning pointer to 64 bytes for improved performance, e.g. use SIMD.
 constexpr int kBufferAlignment = 64;
 
+/// Maximum row stride alignment of the packed planes, in bytes.
+constexpr uint32_t kMaxPackedStrideAlignment = 256;
+
+enum {
+  /// Deliver the pending frame on the delivery thread.
+  MSG_DELIVER_FRAME
+};
+
+using RtcBufferType = webrtc::VideoFrameBuffer::Type;
+using Microsoft::MixedReality::WebRTC::VideoFrameBufferType;
+static_assert((int)VideoFrameBufferType::kNative == (int)RtcBufferType::kNative,
+              "");
+static_assert((int)VideoFrameBufferType::kI420 == (int)RtcBufferType::kI420,
+              "");
+static_assert((int)VideoFrameBufferType::kI420A == (int)RtcBufferType::kI420A,
+              "");
+static_assert((int)VideoFrameBufferType::kI444 == (int)RtcBufferType::kI444,
+              "");
+static_assert((int)VideoFrameBufferType::kI010 == (int)RtcBufferType::kI010,
+              "");
+
+/// Fill the plane pointers and strides of a lease from a planar YUV buffer.
+void FillLeasePlanes(const webrtc::PlanarYuv8Buffer& buffer,
+                     Microsoft::MixedReality::WebRTC::VideoFrameLease& lease) {
+  lease.ydata_ = buffer.DataY();
+  lease.udata_ = buffer.DataU();
+  lease.vdata_ = buffer.DataV();
+  lease.ystride_ = buffer.StrideY();
+  lease.ustride_ = buffer.StrideU();
+  lease.vstride_ = buffer.StrideV();
+}
+
+/// Copy the timestamps of a frame into a frame view.
+template <typename FrameView>
+void FillTimestamps(const webrtc::VideoFrame& frame, FrameView& view) {
+  view.timestamp_us_ = frame.timestamp_us();
+  view.ntp_time_ms_ = frame.ntp_time_ms();
+  view.rtp_timestamp_ = frame.timestamp();
+}
+
+/// Copy the metadata of a frame, if any, into a frame view.
+template <typename FrameView>
+void FillMetadata(const rtc::Buffer* metadata, FrameView& view) {
+  view.metadata_ = (metadata ? metadata->data() : nullptr);
+  view.metadata_size_ = (metadata ? (uint32_t)metadata->size() : 0);
+}
+
+/// Frame observers marked as passive sinks with |SetPassiveSink()|.
+std::mutex g_passive_sinks_mutex;
+std::vector<const Microsoft::MixedReality::WebRTC::VideoFrameObserver*>
+    g_passive_sinks RTC_GUARDED_BY(g_passive_sinks_mutex);
+
+/// Compute the latency of a frame between its capture and now, in
+/// microseconds, or -1 if unknown.
+int64_t ComputeFrameLatencyUs(const webrtc::VideoFrame& frame) {
+  if (frame.ntp_time_ms() > 0) {
+    // Capture time, possibly on a remote peer, in the local NTP clock
+    const int64_t now_ntp_ms =
+        webrtc::Clock::GetRealTimeClock()->CurrentNtpInMilliseconds();
+    return (now_ntp_ms - frame.ntp_time_ms()) * rtc::kNumMicrosecsPerMillisec;
+  }
+  if (frame.timestamp_us() > 0) {
+    // Local capture time in the monotonic clock
+    return (rtc::TimeMicros() - frame.timestamp_us());
+  }
+  return -1;
+}
+
 }  // namespace
 
 namespace Microsoft {
@@ -27,130 +104,744 @@ ArgbBuffer::ArgbBuffer(int width, int height, int stride) noexcept
   RTC_DCHECK_GT(width, 0);
   RTC_DCHECK_GT(height, 0);
   RTC_DCHECK_GE(stride, 4 * width);
+  memory_charge_.Set(Size());
 }
 
 rtc::scoped_refptr<webrtc::I420BufferInterface> ArgbBuffer::ToI420() {
   rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer =
       webrtc::I420Buffer::Create(width_, height_, stride_, stride_ / 2,
                                  stride_ / 2);
-  libyuv::ARGBToI420(Data(), Stride(), i420_buffer->MutableDataY(),
-                     i420_buffer->StrideY(), i420_buffer->MutableDataU(),
-                     i420_buffer->StrideU(), i420_buffer->MutableDataV(),
-                     i420_buffer->StrideV(), width_, height_);
+  ConvertArgb32ToI420(Data(), Stride(), i420_buffer->MutableDataY(),
+                      i420_buffer->StrideY(), i420_buffer->MutableDataU(),
+                      i420_buffer->StrideU(), i420_buffer->MutableDataV(),
+                      i420_buffer->StrideV(), width_, height_);
   return i420_buffer;
 }
 
+VideoFrameObserver::~VideoFrameObserver() {
+  SetPassiveSink(false);
+  SetAsyncDelivery(false);
+}
+
+template <typename FrameCallback>
+void VideoFrameObserver::SetSubscriber(FrameSubscriberId id,
+                                       FrameCallback callback) noexcept {
+  callbacks_.Update([id, &callback](Callbacks& callbacks) {
+    callbacks.ListOf(callback).Set(id, std::move(callback));
+  });
+  CheckCallbacksChanged();
+}
+
+template <typename FrameCallback>
+FrameSubscriberId VideoFrameObserver::AddSubscriberImpl(
+    FrameCallback callback) noexcept {
+  if (!callback) {
+    return 0;
+  }
+  const FrameSubscriberId id = next_subscriber_id_.fetch_add(1);
+  // A new subscriber replaces nothing, so this doesn't need to wait for the
+  // frame deliveries in progress.
+  callbacks_.Publish([id, &callback](Callbacks& callbacks) {
+    callbacks.ListOf(callback).Set(id, std::move(callback));
+  });
+  CheckCallbacksChanged();
+  return id;
+}
+
 void VideoFrameObserver::SetCallback(
     I420AFrameReadyCallback callback) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  i420a_callback_ = std::move(callback);
+  SetSubscriber(kCallbackSubscriberId, std::move(callback));
 }
 
 void VideoFrameObserver::SetCallback(
     Argb32FrameReadyCallback callback) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  argb_callback_ = std::move(callback);
+  SetSubscriber(kCallbackSubscriberId, std::move(callback));
+}
+
+void VideoFrameObserver::SetCallback(Nv12FrameReadyCallback callback) noexcept {
+  SetSubscriber(kCallbackSubscriberId, std::move(callback));
+}
+
+void VideoFrameObserver::SetCallback(
+    VideoFrameLeaseCallback callback) noexcept {
+  SetSubscriber(kCallbackSubscriberId, std::move(callback));
+}
+
+void VideoFrameObserver::SetCallback(
+    Argb32FrameLeaseCallback callback) noexcept {
+  SetSubscriber(kCallbackSubscriberId, std::move(callback));
+}
+
+FrameSubscriberId VideoFrameObserver::AddSubscriber(
+    I420AFrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoFrameObserver::AddSubscriber(
+    Argb32FrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoFrameObserver::AddSubscriber(
+    Nv12FrameReadyCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoFrameObserver::AddSubscriber(
+    VideoFrameLeaseCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+FrameSubscriberId VideoFrameObserver::AddSubscriber(
+    Argb32FrameLeaseCallback callback) noexcept {
+  return AddSubscriberImpl(std::move(callback));
+}
+
+bool VideoFrameObserver::RemoveSubscriber(FrameSubscriberId id) noexcept {
+  if (id == kCallbackSubscriberId) {
+    return false;
+  }
+  bool removed = false;
+  callbacks_.Update([id, &removed](Callbacks& callbacks) {
+    auto remove = [id, &removed](auto& list) { removed |= list.Set(id, {}); };
+    remove(callbacks.i420a_callback_);
+    remove(callbacks.argb_callback_);
+    remove(callbacks.nv12_callback_);
+    remove(callbacks.lease_callback_);
+    remove(callbacks.argb_lease_callback_);
+  });
+  CheckCallbacksChanged();
+  return removed;
+}
+
+bool VideoFrameObserver::HasCallbacks() const noexcept {
+  RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+  return (callbacks->i420a_callback_ || callbacks->argb_callback_ ||
+          callbacks->nv12_callback_ || callbacks->lease_callback_ ||
+          callbacks->argb_lease_callback_);
+}
+
+bool VideoFrameObserver::IsSinkActive(
+    const rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) noexcept {
+  std::lock_guard<std::mutex> lock(g_passive_sinks_mutex);
+  for (const VideoFrameObserver* observer : g_passive_sinks) {
+    if (static_cast<const rtc::VideoSinkInterface<webrtc::VideoFrame>*>(
+            observer) == sink) {
+      return observer->HasCallbacks();
+    }
+  }
+  return true;
+}
+
+void VideoFrameObserver::SetPassiveSink(bool passive) noexcept {
+  std::lock_guard<std::mutex> lock(g_passive_sinks_mutex);
+  auto it = std::find(g_passive_sinks.begin(), g_passive_sinks.end(), this);
+  if (passive && (it == g_passive_sinks.end())) {
+    g_passive_sinks.push_back(this);
+  } else if (!passive && (it != g_passive_sinks.end())) {
+    g_passive_sinks.erase(it);
+  }
+}
+
+void VideoFrameObserver::CheckCallbacksChanged() noexcept {
+  const bool has_callbacks = HasCallbacks();
+  if (had_callbacks_.exchange(has_callbacks) != has_callbacks) {
+    OnCallbacksChanged();
+  }
+}
+
+void VideoFrameObserver::SetArgbBufferPoolSize(int pool_size) noexcept {
+  // The pool itself is only accessed on the delivery path, which trims it.
+  argb_buffer_pool_size_.store(static_cast<size_t>(std::max(pool_size, 1)));
 }
 
 ArgbBuffer* VideoFrameObserver::GetArgbScratchBuffer(int width, int height) {
-  const size_t needed_size = Argb32FrameSize(width, height);
-  if (auto* buffer = argb_scratch_buffer_.get()) {
-    if (buffer->Size() >= needed_size) {
-      return buffer;
+  const size_t pool_size = argb_buffer_pool_size_.load();
+  // Release the buffers in excess; checked out buffers are owned by their
+  // consumer until returned, and will be destroyed with the last reference.
+  if (argb_buffer_pool_.size() > pool_size) {
+    argb_buffer_pool_.resize(pool_size);
+  }
+  const int stride = width * 4;
+  for (auto&& buffer : argb_buffer_pool_) {
+    if (!buffer->HasOneRef()) {
+      // Buffer checked out by some consumer
+      continue;
+    }
+    // The conversion writes rows with the stride of the buffer, and the buffer
+    // reports its dimensions to the consumers leasing it, so a buffer large
+    // enough for a frame of another shape cannot be reused.
+    if ((buffer->width() != width) || (buffer->height() != height) ||
+        (buffer->Stride() != stride)) {
+      buffer = new rtc::RefCountedObject<ArgbBuffer>(width, height, stride);
+    }
+    return buffer.get();
+  }
+  if (argb_buffer_pool_.size() < pool_size) {
+    argb_buffer_pool_.emplace_back(
+        new rtc::RefCountedObject<ArgbBuffer>(width, height, stride));
+    return argb_buffer_pool_.back().get();
+  }
+  return nullptr;
+}
+
+void VideoFrameObserver::DeliverArgbFrame(const Callbacks& callbacks,
+                                          const webrtc::VideoFrame& frame,
+                                          const uint8_t* yptr,
+                                          int ystride,
+                                          const uint8_t* uptr,
+                                          int ustride,
+                                          const uint8_t* vptr,
+                                          int vstride,
+                                          const uint8_t* aptr,
+                                          int astride,
+                                          int width,
+                                          int height) {
+  MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::DeliverArgbFrame", "observer",
+                   (intptr_t)this, "timestamp_us", frame.timestamp_us());
+  ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
+  if (!argb_buffer) {
+    RTC_LOG(LS_VERBOSE) << "Dropping ARGB32 frame; all "
+                        << argb_buffer_pool_size_.load()
+                        << " pooled buffers are checked out.";
+    return;
+  }
+  ConvertI420ToArgb32(yptr, ystride, uptr, ustride, vptr, vstride, aptr,
+                      astride, argb_buffer->Data(), argb_buffer->Stride(),
+                      width, height);
+  Argb32VideoFrame argb32_frame;
+  argb32_frame.argb32_data_ = argb_buffer->Data();
+  argb32_frame.stride_ = argb_buffer->Stride();
+  argb32_frame.width_ = width;
+  argb32_frame.height_ = height;
+  FillTimestamps(frame, argb32_frame);
+  FillMetadata(delivered_metadata_.get(), argb32_frame);
+  argb32_frame.rotation_ = delivered_rotation_;
+  callbacks.argb_callback_(argb32_frame);
+  callbacks.argb_lease_callback_(
+      argb32_frame, static_cast<webrtc::VideoFrameBuffer*>(argb_buffer));
+}
+
+void VideoFrameObserver::DeliverNv12Frame(const Callbacks& callbacks,
+                                          const webrtc::VideoFrame& frame,
+                                          const uint8_t* yptr,
+                                          int ystride,
+                                          const uint8_t* uptr,
+                                          int ustride,
+                                          const uint8_t* vptr,
+                                          int vstride,
+                                          int width,
+                                          int height) {
+  MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::DeliverNv12Frame", "observer",
+                   (intptr_t)this, "timestamp_us", frame.timestamp_us());
+  const size_t needed_size = Nv12FrameSize(width, height);
+  if (nv12_scratch_size_ < needed_size) {
+    nv12_scratch_buffer_.reset(static_cast<uint8_t*>(
+        webrtc::AlignedMalloc(needed_size, kBufferAlignment)));
+    nv12_scratch_size_ = needed_size;
+    UpdateScratchMemoryCharge();
+  }
+  uint8_t* const dst_y = nv12_scratch_buffer_.get();
+  uint8_t* const dst_uv = dst_y + static_cast<size_t>(height) * width;
+  const int dst_uv_stride = ((width + 1) / 2) * 2;
+  libyuv::I420ToNV12(yptr, ystride, uptr, ustride, vptr, vstride, dst_y, width,
+                     dst_uv, dst_uv_stride, width, height);
+  Nv12VideoFrame nv12_frame;
+  nv12_frame.ydata_ = dst_y;
+  nv12_frame.uvdata_ = dst_uv;
+  nv12_frame.ystride_ = width;
+  nv12_frame.uvstride_ = dst_uv_stride;
+  nv12_frame.width_ = width;
+  nv12_frame.height_ = height;
+  FillTimestamps(frame, nv12_frame);
+  FillMetadata(delivered_metadata_.get(), nv12_frame);
+  nv12_frame.rotation_ = delivered_rotation_;
+  callbacks.nv12_callback_(nv12_frame);
+}
+
+void VideoFrameObserver::PackI420AFrame(
+    const VideoFrameDeliveryOptions& options,
+    const uint8_t* yptr,
+    int ystride,
+    const uint8_t* uptr,
+    int ustride,
+    const uint8_t* vptr,
+    int vstride,
+    const uint8_t* aptr,
+    int astride,
+    int width,
+    int height,
+    I420AVideoFrame& i420a_frame) {
+  MRS_TRACE_SCOPE1(Media, "VideoFrameObserver::PackI420AFrame", "observer",
+                   (intptr_t)this);
+  const int alignment =
+      static_cast<int>(std::max(options.packed_stride_alignment_, 1u));
+  auto align = [alignment](int size) {
+    return (size + alignment - 1) & ~(alignment - 1);
+  };
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const int dst_ystride = align(width);
+  const int dst_chroma_stride = align(chroma_width);
+  const int dst_astride = (aptr ? dst_ystride : 0);
+  const size_t ysize = static_cast<size_t>(dst_ystride) * height;
+  const size_t chroma_size =
+      static_cast<size_t>(dst_chroma_stride) * chroma_height;
+  const size_t needed_size =
+      ysize + 2 * chroma_size + static_cast<size_t>(dst_astride) * height;
+  if (packed_scratch_size_ < needed_size) {
+    packed_scratch_buffer_.reset(static_cast<uint8_t*>(
+        webrtc::AlignedMalloc(needed_size, kBufferAlignment)));
+    packed_scratch_size_ = needed_size;
+    UpdateScratchMemoryCharge();
+  }
+  uint8_t* const dst_y = packed_scratch_buffer_.get();
+  uint8_t* const dst_u = dst_y + ysize;
+  uint8_t* const dst_v = dst_u + chroma_size;
+  uint8_t* const dst_a = (aptr ? dst_v + chroma_size : nullptr);
+  // Bands start on even rows, so they map to disjoint chroma rows.
+  ForEachRowBand(width, height, [&](int row_begin, int row_end) {
+    const int chroma_begin = row_begin / 2;
+    const int chroma_end = (row_end + 1) / 2;
+    CopyPlaneRows(yptr, ystride, dst_y, dst_ystride, width, height, row_begin,
+                  row_end, false, false);
+    CopyPlaneRows(uptr, ustride, dst_u, dst_chroma_stride, chroma_width,
+                  chroma_height, chroma_begin, chroma_end, false, false);
+    CopyPlaneRows(vptr, vstride, dst_v, dst_chroma_stride, chroma_width,
+                  chroma_height, chroma_begin, chroma_end, false, false);
+    if (aptr) {
+      CopyPlaneRows(aptr, astride, dst_a, dst_astride, width, height,
+                    row_begin, row_end, false, false);
+    }
+  });
+  i420a_frame.ydata_ = dst_y;
+  i420a_frame.udata_ = dst_u;
+  i420a_frame.vdata_ = dst_v;
+  i420a_frame.adata_ = dst_a;
+  i420a_frame.ystride_ = dst_ystride;
+  i420a_frame.ustride_ = dst_chroma_stride;
+  i420a_frame.vstride_ = dst_chroma_stride;
+  i420a_frame.astride_ = dst_astride;
+  i420a_frame.packed_data_ = dst_y;
+  i420a_frame.packed_size_ = static_cast<uint32_t>(needed_size);
+}
+
+void VideoFrameObserver::UpdateScratchMemoryCharge() noexcept {
+  scratch_memory_charge_.Set(nv12_scratch_size_ + packed_scratch_size_ +
+                             scaled_alpha_buffer_.capacity() +
+                             rotated_alpha_buffer_.capacity());
+}
+
+void VideoFrameObserver::SetDeliveryOptions(
+    const VideoFrameDeliveryOptions& options) noexcept {
+  callbacks_.Update([&options](Callbacks& callbacks) {
+    callbacks.delivery_options_ = options;
+  });
+  delivery_options_changed_.store(true);
+}
+
+bool VideoFrameObserver::IsValidDeliveryOptions(
+    const VideoFrameDeliveryOptions& options) noexcept {
+  const uint32_t alignment = options.packed_stride_alignment_;
+  return (options.max_framerate_ >= 0.0f) &&
+         (alignment <= kMaxPackedStrideAlignment) &&
+         ((alignment & (alignment - 1)) == 0);
+}
+
+bool VideoFrameObserver::CheckFramerateLimit(
+    const VideoFrameDeliveryOptions& options,
+    int64_t timestamp_us) {
+  if (delivery_options_changed_.exchange(false)) {
+    next_delivery_time_us_ = -1;
+  }
+  if (options.max_framerate_ <= 0.0f) {
+    return true;
+  }
+  if ((next_delivery_time_us_ >= 0) &&
+      (timestamp_us < next_delivery_time_us_)) {
+    return false;
+  }
+  // Schedule from the previous deadline rather than from the current frame, to
+  // avoid drifting below the target rate when the source framerate is not a
+  // multiple of it. Reset after a gap longer than one interval.
+  const int64_t interval_us = static_cast<int64_t>(
+      rtc::kNumMicrosecsPerSec / options.max_framerate_);
+  if ((next_delivery_time_us_ < 0) ||
+      (timestamp_us - next_delivery_time_us_ > interval_us)) {
+    next_delivery_time_us_ = timestamp_us;
+  }
+  next_delivery_time_us_ += interval_us;
+  return true;
+}
+
+LatencySummary VideoFrameObserver::GetLatencySummary() const noexcept {
+  return latency_histogram_.GetSummary();
+}
+
+void VideoFrameObserver::ResetLatencyStats() noexcept {
+  latency_histogram_.Reset();
+  marker_histogram_.Reset();
+  marker_decoded_count_.store(0, std::memory_order_relaxed);
+  marker_missing_count_.store(0, std::memory_order_relaxed);
+}
+
+LatencyMarkerStats VideoFrameObserver::GetLatencyMarkerStats() const noexcept {
+  LatencyMarkerStats stats;
+  stats.decoded_count_ = marker_decoded_count_.load(std::memory_order_relaxed);
+  stats.missing_count_ = marker_missing_count_.load(std::memory_order_relaxed);
+  stats.latency_ = marker_histogram_.GetSummary();
+  return stats;
+}
+
+void VideoFrameObserver::DecodeLatencyMarker(
+    const webrtc::VideoFrame& frame) noexcept {
+  MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::DecodeLatencyMarker",
+                   "observer", (intptr_t)this, "timestamp_us",
+                   frame.timestamp_us());
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer =
+      frame.video_frame_buffer()->ToI420();
+  if (!i420_buffer) {
+    return;
+  }
+  LatencyMarker marker;
+  if (!LatencyMarkerCodec::Read(i420_buffer->DataY(), i420_buffer->StrideY(),
+                                i420_buffer->width(), i420_buffer->height(),
+                                marker)) {
+    return;
+  }
+  marker_histogram_.Record(rtc::TimeUTCMicros() - marker.capture_time_utc_us_);
+  marker_decoded_count_.fetch_add(1, std::memory_order_relaxed);
+  if (last_marker_frame_number_.has_value()) {
+    // A frame number going backward means the sender restarted.
+    const uint32_t gap = marker.frame_number_ - *last_marker_frame_number_;
+    if ((gap > 1) && (gap < 0x80000000u)) {
+      marker_missing_count_.fetch_add(gap - 1, std::memory_order_relaxed);
+    }
+  }
+  last_marker_frame_number_ = marker.frame_number_;
+}
+
+void VideoFrameObserver::SetAsyncDelivery(bool enabled) noexcept {
+  std::unique_ptr<rtc::Thread> old_thread;
+  {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    if (enabled == (delivery_thread_ != nullptr)) {
+      return;
+    }
+    if (enabled) {
+      delivery_thread_ = rtc::Thread::Create();
+      delivery_thread_->SetName("VideoFrameObserver delivery thread", this);
+      delivery_thread_->Start();
+      async_enabled_.store(true);
+      return;
     }
+    async_enabled_.store(false);
+    old_thread = std::move(delivery_thread_);
+    pending_frame_.reset();
   }
-  argb_scratch_buffer_ = ArgbBuffer::Create(width, height);
-  return argb_scratch_buffer_.get();
+  // Stop outside the lock, since the delivery thread may be waiting for it.
+  old_thread->Stop();
+}
+
+bool VideoFrameObserver::IsAsyncDelivery() const noexcept {
+  std::lock_guard<std::mutex> lock(async_mutex_);
+  return (delivery_thread_ != nullptr);
+}
+
+uint64_t VideoFrameObserver::GetAsyncDroppedFrameCount() const noexcept {
+  std::lock_guard<std::mutex> lock(async_mutex_);
+  return async_dropped_frame_count_;
 }
 
 void VideoFrameObserver::OnFrame(const webrtc::VideoFrame& frame) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (!i420a_callback_ && !argb_callback_) {
+  MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::OnFrame", "observer",
+                   (intptr_t)this, "timestamp_us", frame.timestamp_us());
+  frame_timing_.RecordFrame(rtc::TimeMicros());
+  if (async_enabled_.load()) {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    if (delivery_thread_) {
+      // Latest frame wins; only post a message if none is in flight already,
+      // otherwise that message will pick up this newer frame.
+      if (pending_frame_.has_value()) {
+        ++async_dropped_frame_count_;
+      } else {
+        delivery_thread_->Post(RTC_FROM_HERE, this, MSG_DELIVER_FRAME);
+      }
+      pending_frame_ = frame;
+      return;
+    }
+  }
+  DeliverFrame(frame);
+}
+
+// Note - This is called on the delivery thread only.
+void VideoFrameObserver::OnMessage(rtc::Message* message) {
+  switch (message->message_id) {
+    case MSG_DELIVER_FRAME: {
+      absl::optional<webrtc::VideoFrame> frame;
+      {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        frame = std::move(pending_frame_);
+        pending_frame_.reset();
+      }
+      if (frame.has_value()) {
+        DeliverFrame(frame.value());
+      }
+    } break;
+  }
+}
+
+void VideoFrameObserver::DeliverFrame(
+    const webrtc::VideoFrame& frame) noexcept {
+  // Deliveries only overlap briefly while switching between synchronous and
+  // asynchronous delivery, or with sources producing frames from several
+  // threads; drop the frame rather than waiting.
+  if (delivering_.test_and_set(std::memory_order_acquire)) {
+    overlap_dropped_frame_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  {
+    RcuSnapshot<Callbacks>::ReadScope callbacks(callbacks_);
+    DeliverFrame(frame, *callbacks);
+  }
+  delivering_.clear(std::memory_order_release);
+}
+
+void VideoFrameObserver::DeliverFrame(const webrtc::VideoFrame& frame,
+                                      const Callbacks& callbacks) noexcept {
+  if (marker_decoding_.load(std::memory_order_relaxed)) {
+    DecodeLatencyMarker(frame);
+  }
+
+  if (!callbacks.i420a_callback_ && !callbacks.argb_callback_ &&
+      !callbacks.nv12_callback_ && !callbacks.lease_callback_ &&
+      !callbacks.argb_lease_callback_) {
     return;
   }
 
+  latency_histogram_.Record(ComputeFrameLatencyUs(frame));
+
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer(
       frame.video_frame_buffer());
 
-  const int width = frame.width();
-  const int height = frame.height();
-
-  if (buffer->type() != webrtc::VideoFrameBuffer::Type::kI420A) {
-    // The buffer is not encoded in I420 with alpha channel; use I420 without
-    // alpha channel as interchange format for the callback, and convert the
-    // buffer to that (or do nothing if already in I420).
-    rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer =
-        buffer->ToI420();
-    const uint8_t* const yptr = i420_buffer->DataY();
-    const uint8_t* const uptr = i420_buffer->DataU();
-    const uint8_t* const vptr = i420_buffer->DataV();
-
-    if (i420a_callback_) {
-      I420AVideoFrame i420a_frame;
-      i420a_frame.ydata_ = yptr;
-      i420a_frame.udata_ = uptr;
-      i420a_frame.vdata_ = vptr;
-      i420a_frame.adata_ = nullptr;
-      i420a_frame.ystride_ = i420_buffer->StrideY();
-      i420a_frame.ustride_ = i420_buffer->StrideU();
-      i420a_frame.vstride_ = i420_buffer->StrideV();
-      i420a_frame.astride_ = 0;
-      i420a_frame.width_ = width;
-      i420a_frame.height_ = height;
-      i420a_callback_(i420a_frame);
-    }
+  int width = frame.width();
+  int height = frame.height();
 
-    if (argb_callback_) {
-      ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
-      libyuv::I420ToARGB(yptr, i420_buffer->StrideY(), uptr,
-                         i420_buffer->StrideU(), vptr, i420_buffer->StrideV(),
-                         argb_buffer->Data(), argb_buffer->Stride(), width,
-                         height);
-      Argb32VideoFrame argb32_frame;
-      argb32_frame.argb32_data_ = argb_buffer->Data();
-      argb32_frame.stride_ = argb_buffer->Stride();
-      argb32_frame.width_ = width;
-      argb32_frame.height_ = height;
-      argb_callback_(argb32_frame);
+  if (callbacks.lease_callback_) {
+    // Hand over the original buffer without any copy or conversion. The
+    // references added here are owned by the callees, and released through
+    // |mrsVideoFrameBufferRemoveRef()|.
+    VideoFrameLease lease{};
+    lease.type_ = static_cast<VideoFrameBufferType>(buffer->type());
+    lease.width_ = width;
+    lease.height_ = height;
+    switch (buffer->type()) {
+      case webrtc::VideoFrameBuffer::Type::kI420:
+        FillLeasePlanes(*buffer->GetI420(), lease);
+        break;
+      case webrtc::VideoFrameBuffer::Type::kI420A: {
+        const webrtc::I420ABufferInterface* const i420a = buffer->GetI420A();
+        FillLeasePlanes(*i420a, lease);
+        lease.adata_ = i420a->DataA();
+        lease.astride_ = i420a->StrideA();
+        break;
+      }
+      case webrtc::VideoFrameBuffer::Type::kI444:
+        FillLeasePlanes(*buffer->GetI444(), lease);
+        break;
+      default:
+        // Native and 10-bit buffers have no 8-bit plane to expose.
+        break;
+    }
+    lease.buffer_handle_ = buffer.get();
+    for (auto&& entry : callbacks.lease_callback_.entries_) {
+      // Each subscriber owns its own reference
+      buffer->AddRef();
+      entry.callback_(lease);
     }
+  }
+
+  if (!callbacks.i420a_callback_ && !callbacks.argb_callback_ &&
+      !callbacks.nv12_callback_ && !callbacks.argb_lease_callback_) {
+    return;
+  }
 
+  // Skip frames exceeding the delivery framerate before any conversion
+  const VideoFrameDeliveryOptions& options = callbacks.delivery_options_;
+  if (!CheckFramerateLimit(options, frame.timestamp_us())) {
+    return;
+  }
+
+  // Remote frames carry the metadata sent with them, if any, while local
+  // frames have it attached by their source.
+  delivered_metadata_ =
+      (frame_metadata_tap_
+           ? frame_metadata_tap_->FindFrameMetadata(frame.timestamp())
+           : FindFrameMetadata(frame));
+
+  // Use I420 with optional alpha channel as interchange format for the
+  // callbacks. If the buffer is not encoded in I420 with alpha channel, then
+  // convert it to I420 without alpha channel (or do nothing if already I420).
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer;
+  const uint8_t* yptr;
+  const uint8_t* uptr;
+  const uint8_t* vptr;
+  const uint8_t* aptr = nullptr;
+  int ystride, ustride, vstride;
+  int astride = 0;
+  if (buffer->type() == webrtc::VideoFrameBuffer::Type::kI420A) {
+    const webrtc::I420ABufferInterface* const i420a_buffer =
+        buffer->GetI420A();
+    yptr = i420a_buffer->DataY();
+    uptr = i420a_buffer->DataU();
+    vptr = i420a_buffer->DataV();
+    aptr = i420a_buffer->DataA();
+    ystride = i420a_buffer->StrideY();
+    ustride = i420a_buffer->StrideU();
+    vstride = i420a_buffer->StrideV();
+    astride = i420a_buffer->StrideA();
   } else {
-    // The buffer is encoded in I420 with alpha channel, use it directly.
-    webrtc::I420ABufferInterface* i420a_buffer = buffer->GetI420A();
-    const uint8_t* const yptr = i420a_buffer->DataY();
-    const uint8_t* const uptr = i420a_buffer->DataU();
-    const uint8_t* const vptr = i420a_buffer->DataV();
-    const uint8_t* const aptr = i420a_buffer->DataA();
-
-    if (i420a_callback_) {
-      I420AVideoFrame i420a_frame;
+    MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::ToI420", "observer",
+                     (intptr_t)this, "timestamp_us", frame.timestamp_us());
+    i420_buffer = buffer->ToI420();
+    yptr = i420_buffer->DataY();
+    uptr = i420_buffer->DataU();
+    vptr = i420_buffer->DataV();
+    ystride = i420_buffer->StrideY();
+    ustride = i420_buffer->StrideU();
+    vstride = i420_buffer->StrideV();
+  }
+
+  // Downscale the frame to fit the maximum size of the delivery options, if
+  // any, preserving the aspect ratio.
+  double scale = 1.0;
+  if ((options.max_width_ > 0) &&
+      (static_cast<uint32_t>(width) > options.max_width_)) {
+    scale = static_cast<double>(options.max_width_) / width;
+  }
+  if ((options.max_height_ > 0) &&
+      (static_cast<uint32_t>(height) > options.max_height_)) {
+    scale = std::min(
+        scale, static_cast<double>(options.max_height_) / height);
+  }
+  rtc::scoped_refptr<webrtc::I420Buffer> scaled_buffer;
+  if (scale < 1.0) {
+    // Keep even dimensions for chroma downsampling
+    const int scaled_width = std::max(2, static_cast<int>(width * scale) & ~1);
+    const int scaled_height =
+        std::max(2, static_cast<int>(height * scale) & ~1);
+    scaled_buffer =
+        scaled_buffer_pool_.CreateBuffer(scaled_width, scaled_height);
+    if (scaled_buffer) {
+      libyuv::I420Scale(yptr, ystride, uptr, ustride, vptr, vstride, width,
+                        height, scaled_buffer->MutableDataY(),
+                        scaled_buffer->StrideY(), scaled_buffer->MutableDataU(),
+                        scaled_buffer->StrideU(), scaled_buffer->MutableDataV(),
+                        scaled_buffer->StrideV(), scaled_width, scaled_height,
+                        libyuv::kFilterBox);
+      if (aptr) {
+        scaled_alpha_buffer_.resize(static_cast<size_t>(scaled_width) *
+                                    scaled_height);
+        UpdateScratchMemoryCharge();
+        libyuv::ScalePlane(aptr, astride, width, height,
+                           scaled_alpha_buffer_.data(), scaled_width,
+                           scaled_width, scaled_height, libyuv::kFilterBox);
+        aptr = scaled_alpha_buffer_.data();
+        astride = scaled_width;
+      }
+      yptr = scaled_buffer->DataY();
+      uptr = scaled_buffer->DataU();
+      vptr = scaled_buffer->DataV();
+      ystride = scaled_buffer->StrideY();
+      ustride = scaled_buffer->StrideU();
+      vstride = scaled_buffer->StrideV();
+      width = scaled_width;
+      height = scaled_height;
+    }
+  }
+
+  // Frames are delivered with their rotation for the renderers to apply it,
+  // unless the delivery options request upright pixels. The rotation runs
+  // after downscaling, to touch as few pixels as possible.
+  delivered_rotation_ = static_cast<VideoRotation>(frame.rotation());
+  rtc::scoped_refptr<webrtc::I420Buffer> rotated_buffer;
+  if (options.apply_rotation_ &&
+      (frame.rotation() != webrtc::kVideoRotation_0)) {
+    MRS_TRACE_SCOPE2(Media, "VideoFrameObserver::Rotate", "observer",
+                     (intptr_t)this, "timestamp_us", frame.timestamp_us());
+    const bool transpose = (frame.rotation() == webrtc::kVideoRotation_90) ||
+                           (frame.rotation() == webrtc::kVideoRotation_270);
+    const int rotated_width = (transpose ? height : width);
+    const int rotated_height = (transpose ? width : height);
+    const libyuv::RotationMode mode =
+        static_cast<libyuv::RotationMode>(frame.rotation());
+    rotated_buffer =
+        rotated_buffer_pool_.CreateBuffer(rotated_width, rotated_height);
+    if (rotated_buffer) {
+      libyuv::I420Rotate(
+          yptr, ystride, uptr, ustride, vptr, vstride,
+          rotated_buffer->MutableDataY(), rotated_buffer->StrideY(),
+          rotated_buffer->MutableDataU(), rotated_buffer->StrideU(),
+          rotated_buffer->MutableDataV(), rotated_buffer->StrideV(), width,
+          height, mode);
+      if (aptr) {
+        rotated_alpha_buffer_.resize(static_cast<size_t>(rotated_width) *
+                                     rotated_height);
+        UpdateScratchMemoryCharge();
+        libyuv::RotatePlane(aptr, astride, rotated_alpha_buffer_.data(),
+                            rotated_width, width, height, mode);
+        aptr = rotated_alpha_buffer_.data();
+        astride = rotated_width;
+      }
+      yptr = rotated_buffer->DataY();
+      uptr = rotated_buffer->DataU();
+      vptr = rotated_buffer->DataV();
+      ystride = rotated_buffer->StrideY();
+      ustride = rotated_buffer->StrideU();
+      vstride = rotated_buffer->StrideV();
+      width = rotated_width;
+      height = rotated_height;
+      delivered_rotation_ = VideoRotation::k0;
+    }
+  }
+
+  if (callbacks.i420a_callback_) {
+    I420AVideoFrame i420a_frame;
+    if (options.pack_planes_) {
+      PackI420AFrame(options, yptr, ystride, uptr, ustride, vptr, vstride,
+                     aptr, astride, width, height, i420a_frame);
+    } else {
       i420a_frame.ydata_ = yptr;
       i420a_frame.udata_ = uptr;
       i420a_frame.vdata_ = vptr;
       i420a_frame.adata_ = aptr;
-      i420a_frame.ystride_ = i420a_buffer->StrideY();
-      i420a_frame.ustride_ = i420a_buffer->StrideU();
-      i420a_frame.vstride_ = i420a_buffer->StrideV();
-      i420a_frame.astride_ = i420a_buffer->StrideA();
-      i420a_frame.width_ = width;
-      i420a_frame.height_ = height;
-      i420a_callback_(i420a_frame);
+      i420a_frame.ystride_ = ystride;
+      i420a_frame.ustride_ = ustride;
+      i420a_frame.vstride_ = vstride;
+      i420a_frame.astride_ = astride;
+      i420a_frame.packed_data_ = nullptr;
+      i420a_frame.packed_size_ = 0;
     }
+    i420a_frame.width_ = width;
+    i420a_frame.height_ = height;
+    FillTimestamps(frame, i420a_frame);
+    FillMetadata(delivered_metadata_.get(), i420a_frame);
+    i420a_frame.rotation_ = delivered_rotation_;
+    callbacks.i420a_callback_(i420a_frame);
+  }
 
-    if (argb_callback_) {
-      ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
-      libyuv::I420AlphaToARGB(
-          yptr, i420a_buffer->StrideY(), uptr, i420a_buffer->StrideU(), vptr,
-          i420a_buffer->StrideV(), aptr, i420a_buffer->StrideA(),
-          argb_buffer->Data(), argb_buffer->Stride(), width, height, 0);
-      Argb32VideoFrame argb32_frame;
-      argb32_frame.argb32_data_ = argb_buffer->Data();
-      argb32_frame.stride_ = argb_buffer->Stride();
-      argb32_frame.width_ = width;
-      argb32_frame.height_ = height;
-      argb_callback_(argb32_frame);
-    }
+  if (callbacks.argb_callback_ || callbacks.argb_lease_callback_) {
+    DeliverArgbFrame(callbacks, frame, yptr, ystride, uptr, ustride, vptr,
+                     vstride, aptr, astride, width, height);
+  }
+
+  if (callbacks.nv12_callback_) {
+    // NV12 has no alpha plane; the alpha channel is dropped, if any
+    DeliverNv12Frame(callbacks, frame, yptr, ystride, uptr, ustride, vptr,
+                     vstride, width, height);
   }
+
+  delivered_metadata_ = nullptr;
 }
 
 }  // namespace WebRTC
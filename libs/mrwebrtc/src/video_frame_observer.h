@@ -3,12 +3,26 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <vector>
 
+#include "absl/types/optional.h"
 #include "api/video/video_frame.h"
 #include "api/video/video_sink_interface.h"
+#include "common_video/include/i420_buffer_pool.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/refcountedobject.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/timeutils.h"
 
 #include "callback.h"
+#include "frame_metadata.h"
+#include "frame_timing_stats.h"
+#include "latency_histogram.h"
+#include "memory_accounting.h"
+#include "rcu_snapshot.h"
 #include "video_frame.h"
 
 #include "rtc_base/memory/aligned_malloc.h"
@@ -17,18 +31,50 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class EncodedFrameTap;
+
 /// Callback fired on newly available video frame, encoded as I420.
 using I420AFrameReadyCallback = Callback<const I420AVideoFrame&>;
 
 /// Callback fired on newly available video frame, encoded as ARGB.
 using Argb32FrameReadyCallback = Callback<const Argb32VideoFrame&>;
 
+/// Callback fired on newly available video frame, encoded as NV12.
+using Nv12FrameReadyCallback = Callback<const Nv12VideoFrame&>;
+
+/// Callback fired on newly available video frame, delivered as a lease over the
+/// original frame buffer without any copy or conversion.
+using VideoFrameLeaseCallback = Callback<const VideoFrameLease&>;
+
+/// Callback fired on newly available video frame, encoded as ARGB, along with
+/// an opaque handle to the pooled buffer holding the frame data. The callee can
+/// check out that buffer with |mrsVideoFrameBufferAddRef()| to keep using it
+/// after the callback returned, and return it later to the pool with
+/// |mrsVideoFrameBufferRemoveRef()|.
+using Argb32FrameLeaseCallback = Callback<const Argb32VideoFrame&, void*>;
+
+/// Identifier of a frame subscriber registered with
+/// |VideoFrameObserver::AddSubscriber()|. Zero is never a valid identifier.
+using FrameSubscriberId = CallbackListenerId;
+
+/// List of subscribers of a given frame callback type, all invoked in turn with
+/// the same frame data.
+template <typename FrameCallback>
+using FrameCallbackList = CallbackList<FrameCallback>;
+
 /// Helper function to calculate the minimum size of an ARGB32 frame given its
 /// dimensions in pixels.
 constexpr inline size_t Argb32FrameSize(int width, int height) {
   return (static_cast<size_t>(height) * width) * 4;
 }
 
+/// Helper function to calculate the minimum size of an NV12 frame given its
+/// dimensions in pixels, with tightly packed rows.
+constexpr inline size_t Nv12FrameSize(int width, int height) {
+  return (static_cast<size_t>(height) * width) +
+         (static_cast<size_t>((height + 1) / 2) * ((width + 1) / 2) * 2);
+}
+
 // Plain 32-bit ARGB buffer in standard memory.
 class ArgbBuffer : public webrtc::VideoFrameBuffer {
  public:
@@ -94,11 +140,36 @@ class ArgbBuffer : public webrtc::VideoFrameBuffer {
 
   /// Raw buffer of ARGB32 data for the frame.
   const std::unique_ptr<uint8_t, webrtc::AlignedFreeDeleter> data_;
+
+  /// Accounting of |data_| as scratch buffer memory.
+  MemoryCharge memory_charge_{MemoryCategory::kScratchBuffers};
+};
+
+/// Statistics of the latency markers decoded from the frames delivered to a
+/// |VideoFrameObserver|.
+struct LatencyMarkerStats {
+  /// Number of frames with a valid latency marker.
+  uint64_t decoded_count_ = 0;
+
+  /// Number of frames missing from the sequence of frame numbers of the
+  /// markers, dropped anywhere between the sender and the observer.
+  uint64_t missing_count_ = 0;
+
+  /// End-to-end latency of the frames with a valid marker.
+  LatencySummary latency_;
 };
 
 /// Video frame observer to get notified of newly available video frames.
-class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+///
+/// Callbacks are read on the per-frame path without any lock. Assigning a
+/// callback waits for any frame delivery already in progress with the previous
+/// callbacks to complete, so that once |SetCallback()| returns the previous
+/// callback is never invoked again, unless called from within that callback.
+class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame>,
+                           public rtc::MessageHandler {
  public:
+  ~VideoFrameObserver() override;
+
   /// Register a callback to get notified on frame available,
   /// and received that frame as a I420-encoded buffer.
   /// This is not exclusive and can be used along another ARGB callback.
@@ -109,29 +180,375 @@ class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
   /// This is not exclusive and can be used along another I420 callback.
   void SetCallback(Argb32FrameReadyCallback callback) noexcept;
 
+  /// Register a callback to get notified on frame available, and receive that
+  /// frame as an NV12-encoded buffer.
+  /// This is not exclusive and can be used along the other callbacks.
+  void SetCallback(Nv12FrameReadyCallback callback) noexcept;
+
+  /// Register a callback to get notified on frame available, and receive a
+  /// lease over the original frame buffer. The callee owns a reference to the
+  /// buffer, which it must release with |mrsVideoFrameBufferRemoveRef()|.
+  /// This is not exclusive and can be used along the other callbacks.
+  void SetCallback(VideoFrameLeaseCallback callback) noexcept;
+
+  /// Register a callback to get notified on frame available, and receive that
+  /// frame as a raw decoded ARGB buffer checked out from the buffer pool.
+  /// This is not exclusive and can be used along the other callbacks.
+  void SetCallback(Argb32FrameLeaseCallback callback) noexcept;
+
+  /// Add a subscriber to get notified on frame available, in addition to the
+  /// callback assigned with |SetCallback()| and to any other subscriber. Each
+  /// frame is converted at most once per format, and all subscribers of a
+  /// format receive the same read-only frame data. This returns the
+  /// identifier of the new subscriber, to be used with |RemoveSubscriber()|,
+  /// or zero if |callback| is empty.
+  FrameSubscriberId AddSubscriber(I420AFrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Argb32FrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Nv12FrameReadyCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(VideoFrameLeaseCallback callback) noexcept;
+  FrameSubscriberId AddSubscriber(Argb32FrameLeaseCallback callback) noexcept;
+
+  /// Remove a subscriber previously added with |AddSubscriber()|. Once this
+  /// returns, the subscriber is never invoked again, unless called from within
+  /// that subscriber. This returns |false| if no such subscriber exists.
+  bool RemoveSubscriber(FrameSubscriberId id) noexcept;
+
+  /// Check if any callback or subscriber is registered.
+  bool HasCallbacks() const noexcept;
+
+  /// Check if a sink of a video source consumes the frames it receives. This
+  /// is always the case, unless the sink is a frame observer marked as passive
+  /// with |SetPassiveSink()| which has no callback.
+  static bool IsSinkActive(
+      const rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) noexcept;
+
+  /// Set the maximum number of ARGB32 buffers in the scratch buffer pool. This
+  /// bounds the number of frames a consumer can keep checked out at the same
+  /// time. When all buffers are checked out, ARGB32 frames are dropped until a
+  /// buffer is returned. The default is a single buffer. Values less than 1
+  /// are clamped to 1.
+  void SetArgbBufferPoolSize(int pool_size) noexcept;
+
+  /// Set the options controlling the delivery of frames to the I420A, ARGB32
+  /// and NV12 callbacks, to downscale frames and limit the delivery framerate.
+  void SetDeliveryOptions(const VideoFrameDeliveryOptions& options) noexcept;
+
+  /// Check if delivery options are valid, with a non-negative framerate limit
+  /// and a valid packed stride alignment.
+  static bool IsValidDeliveryOptions(
+      const VideoFrameDeliveryOptions& options) noexcept;
+
+  /// Get the percentiles of the latency between the capture of the frames and
+  /// their delivery to the frame callbacks. For remote frames, the capture
+  /// time is only known once the remote peer sent an RTCP sender report.
+  LatencySummary GetLatencySummary() const noexcept;
+
+  /// Discard the latency samples recorded so far, including the latency
+  /// marker statistics.
+  void ResetLatencyStats() noexcept;
+
+  /// Enable or disable decoding the |LatencyMarker| stamped into the pixels of
+  /// the frames by the sender, to record the end-to-end latency of each frame
+  /// from its capture to its delivery to the frame callbacks. Frames are
+  /// decoded even if no callback is registered. The sender and the receiver
+  /// must have synchronized UTC clocks, which is always the case within the
+  /// same process.
+  void SetLatencyMarkerDecoding(bool enabled) noexcept {
+    marker_decoding_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /// Get the statistics of the latency markers decoded since the last reset.
+  LatencyMarkerStats GetLatencyMarkerStats() const noexcept;
+
+  /// Get the statistics of the arrival of the frames at this observer since
+  /// the last reset, including the freezes and pauses of the stream. Frames
+  /// are timed on arrival, before any delivery option drops them.
+  FrameTimingSummary GetFrameTimingSummary() const noexcept {
+    return frame_timing_.GetSummary(rtc::TimeMicros());
+  }
+
+  /// Discard the frame timing statistics recorded so far.
+  void ResetFrameTimingStats() noexcept { frame_timing_.Reset(); }
+
+  /// Enable or disable asynchronous frame delivery. When enabled, |OnFrame()|
+  /// only keeps a reference to the frame, and the color conversion and the
+  /// invoking of the callbacks happen on a dedicated delivery thread. At most
+  /// one frame is pending delivery; a newer frame replaces any frame not yet
+  /// delivered, so a slow consumer never blocks the thread producing frames.
+  /// The replaced frames are counted by |GetAsyncDroppedFrameCount()|. While
+  /// switching, a frame delivered synchronously can overlap with the last
+  /// frame delivered asynchronously, in which case the newer frame is dropped
+  /// and counted by |GetOverlapDroppedFrameCount()|.
+  void SetAsyncDelivery(bool enabled) noexcept;
+
+  /// Check if asynchronous frame delivery is enabled.
+  bool IsAsyncDelivery() const noexcept;
+
+  /// Get the number of frames dropped because a newer frame arrived before
+  /// they were delivered, when asynchronous delivery is enabled.
+  uint64_t GetAsyncDroppedFrameCount() const noexcept;
+
+  /// Get the number of frames dropped because they arrived while another
+  /// frame was being delivered, either while switching between synchronous
+  /// and asynchronous delivery, or when the source produces frames from
+  /// several threads at once.
+  uint64_t GetOverlapDroppedFrameCount() const noexcept {
+    return overlap_dropped_frame_count_.load(std::memory_order_relaxed);
+  }
+
  protected:
+  /// Set the tap of the receive stream feeding this observer, from which the
+  /// metadata sent along with the remote frames is read. This must be called
+  /// before any frame is delivered. Local frames find their metadata without
+  /// it.
+  void SetFrameMetadataTap(std::shared_ptr<EncodedFrameTap> tap) noexcept {
+    frame_metadata_tap_ = std::move(tap);
+  }
+
+  /// Mark this observer as a passive sink of its video source, which only
+  /// consumes the frames while it has callbacks. Sources can then stop
+  /// producing frames while all their sinks are passive, see
+  /// |IsSinkActive()|.
+  void SetPassiveSink(bool passive) noexcept;
+
+  /// Invoked after the first callback or subscriber was registered, or after
+  /// the last one was removed.
+  virtual void OnCallbacksChanged() noexcept {}
+
+  /// Set of callbacks and delivery options, published as an immutable
+  /// snapshot so that the per-frame path reads it without any lock.
+  struct Callbacks {
+    /// Registered callbacks for receiving I420-encoded frame.
+    FrameCallbackList<I420AFrameReadyCallback> i420a_callback_;
+
+    /// Registered callbacks for receiving raw decoded ARGB frame.
+    FrameCallbackList<Argb32FrameReadyCallback> argb_callback_;
+
+    /// Registered callbacks for receiving NV12-encoded frame.
+    FrameCallbackList<Nv12FrameReadyCallback> nv12_callback_;
+
+    /// Registered callbacks for receiving a lease over the frame buffer.
+    FrameCallbackList<VideoFrameLeaseCallback> lease_callback_;
+
+    /// Registered callbacks for receiving raw decoded ARGB frame along with a
+    /// handle to its pooled buffer.
+    FrameCallbackList<Argb32FrameLeaseCallback> argb_lease_callback_;
+
+    /// Options for the delivery of converted frames.
+    VideoFrameDeliveryOptions delivery_options_{};
+
+    /// Get the subscriber list for a given callback type.
+    auto& ListOf(const I420AFrameReadyCallback&) { return i420a_callback_; }
+    auto& ListOf(const Argb32FrameReadyCallback&) { return argb_callback_; }
+    auto& ListOf(const Nv12FrameReadyCallback&) { return nv12_callback_; }
+    auto& ListOf(const VideoFrameLeaseCallback&) { return lease_callback_; }
+    auto& ListOf(const Argb32FrameLeaseCallback&) {
+      return argb_lease_callback_;
+    }
+  };
+
+  /// Identifier of the subscriber assigned by |SetCallback()|.
+  static constexpr FrameSubscriberId kCallbackSubscriberId = 0;
+
+  /// Assign the callback of a subscriber, or remove it if |callback| is empty.
+  template <typename FrameCallback>
+  void SetSubscriber(FrameSubscriberId id, FrameCallback callback) noexcept;
+
+  /// Add a subscriber with a new identifier.
+  template <typename FrameCallback>
+  FrameSubscriberId AddSubscriberImpl(FrameCallback callback) noexcept;
+
+  /// Invoke |OnCallbacksChanged()| if |HasCallbacks()| changed since the last
+  /// change of the callbacks.
+  void CheckCallbacksChanged() noexcept;
+
   /// Get a temporary scratch buffer for an ARGB32 frame of the given
   /// dimensions. The returned buffer does not need to be deallocated, but can
-  /// be reused by a later call so concurrent access is not supported.
-  /// Before calling this method the caller needs to acquire |mutex_|, and keep
-  /// it for the duration of its access.
+  /// be reused by a later call for a frame of the same dimensions once no
+  /// consumer holds a reference to it anymore, and is reallocated otherwise.
+  /// This returns NULL if all buffers of the pool are checked out.
+  /// This must only be called on the delivery path.
   ArgbBuffer* GetArgbScratchBuffer(int width, int height);
 
+  /// Convert an I420 frame, with optional alpha plane, to ARGB32 into a pooled
+  /// scratch buffer, and invoke the ARGB32 callbacks with it.
+  void DeliverArgbFrame(const Callbacks& callbacks,
+                        const webrtc::VideoFrame& frame,
+                        const uint8_t* yptr,
+                        int ystride,
+                        const uint8_t* uptr,
+                        int ustride,
+                        const uint8_t* vptr,
+                        int vstride,
+                        const uint8_t* aptr,
+                        int astride,
+                        int width,
+                        int height);
+
+  /// Convert an I420 frame to NV12 into the NV12 scratch buffer, and invoke the
+  /// NV12 callback with it.
+  void DeliverNv12Frame(const Callbacks& callbacks,
+                        const webrtc::VideoFrame& frame,
+                        const uint8_t* yptr,
+                        int ystride,
+                        const uint8_t* uptr,
+                        int ustride,
+                        const uint8_t* vptr,
+                        int vstride,
+                        int width,
+                        int height);
+
+  /// Copy the planes of an I420 frame, with optional alpha plane, into the
+  /// packed scratch buffer, and point the planes of |i420a_frame| into it.
+  void PackI420AFrame(const VideoFrameDeliveryOptions& options,
+                      const uint8_t* yptr,
+                      int ystride,
+                      const uint8_t* uptr,
+                      int ustride,
+                      const uint8_t* vptr,
+                      int vstride,
+                      const uint8_t* aptr,
+                      int astride,
+                      int width,
+                      int height,
+                      I420AVideoFrame& i420a_frame);
+
+  /// Decode the latency marker of a frame, if any, and record its latency.
+  void DecodeLatencyMarker(const webrtc::VideoFrame& frame) noexcept;
+
+  /// Check if a frame with the given timestamp passes the framerate limit of
+  /// the delivery options, and update the framerate limiter state.
+  bool CheckFramerateLimit(const VideoFrameDeliveryOptions& options,
+                           int64_t timestamp_us);
+
+  /// Update the memory accounting of the scratch buffers after one of them
+  /// was resized.
+  void UpdateScratchMemoryCharge() noexcept;
+
+  /// Convert and deliver a frame to all registered callbacks. This reads the
+  /// callbacks without any lock, and only ever runs on one thread at a time;
+  /// a frame arriving while another one is being delivered is dropped, and
+  /// counted in |overlap_dropped_frame_count_|.
+  void DeliverFrame(const webrtc::VideoFrame& frame) noexcept;
+
+  /// Convert and deliver a frame to the given callbacks.
+  void DeliverFrame(const webrtc::VideoFrame& frame,
+                    const Callbacks& callbacks) noexcept;
+
   // VideoSinkInterface interface
   void OnFrame(const webrtc::VideoFrame& frame) noexcept override;
 
+  // MessageHandler interface
+  void OnMessage(rtc::Message* message) override;
+
  private:
-  /// Registered callback for receiving I420-encoded frame.
-  I420AFrameReadyCallback i420a_callback_ RTC_GUARDED_BY(mutex_);
+  /// Registered callbacks and delivery options.
+  RcuSnapshot<Callbacks> callbacks_;
+
+  /// Latency between frame capture and delivery to the callbacks.
+  LatencyHistogram latency_histogram_;
+
+  /// Arrival times of the frames, timed in |OnFrame()|.
+  FrameTimingStats frame_timing_;
+
+  /// Tap of the receive stream feeding this observer, if any.
+  std::shared_ptr<EncodedFrameTap> frame_metadata_tap_;
+
+  /// Decode the latency markers of the frames delivered.
+  std::atomic_bool marker_decoding_{false};
+
+  /// End-to-end latency of the frames, from their latency markers.
+  LatencyHistogram marker_histogram_;
+  std::atomic<uint64_t> marker_decoded_count_{0};
+  std::atomic<uint64_t> marker_missing_count_{0};
+
+  /// Identifier of the next subscriber added with |AddSubscriber()|.
+  std::atomic<FrameSubscriberId> next_subscriber_id_{1};
+
+  /// Value of |HasCallbacks()| after the last change of the callbacks.
+  std::atomic_bool had_callbacks_{false};
+
+  /// Set while a frame is being delivered. This guards all the delivery state
+  /// below, which is only accessed by the thread delivering a frame.
+  std::atomic_flag delivering_ = ATOMIC_FLAG_INIT;
+
+  /// Number of frames dropped because another frame was being delivered.
+  std::atomic<uint64_t> overlap_dropped_frame_count_{0};
+
+  /// Pool of reusable ARGB scratch buffers to avoid per-frame allocation. A
+  /// buffer is free when the pool holds the only reference to it.
+  std::vector<rtc::scoped_refptr<rtc::RefCountedObject<ArgbBuffer>>>
+      argb_buffer_pool_;
+
+  /// Maximum number of buffers in |argb_buffer_pool_|.
+  std::atomic<size_t> argb_buffer_pool_size_{1};
+
+  /// Set when the delivery options changed, to reset the framerate limiter.
+  std::atomic<bool> delivery_options_changed_{false};
+
+  /// Timestamp before which frames are skipped to limit the framerate, or -1
+  /// if no frame was delivered yet.
+  int64_t next_delivery_time_us_ = -1;
+
+  /// Frame number of the last latency marker decoded, to count the missing
+  /// frames, if any marker was decoded yet.
+  absl::optional<uint32_t> last_marker_frame_number_;
+
+  /// Metadata of the frame being delivered, if any.
+  FrameMetadata delivered_metadata_;
+
+  /// Pool of I420 buffers for frames downscaled per the delivery options.
+  webrtc::I420BufferPool scaled_buffer_pool_;
+
+  /// Reusable scratch buffer for the downscaled alpha plane of I420A frames.
+  std::vector<uint8_t> scaled_alpha_buffer_;
+
+  /// Pool of I420 buffers for frames rotated per the delivery options.
+  webrtc::I420BufferPool rotated_buffer_pool_;
+
+  /// Reusable scratch buffer for the rotated alpha plane of I420A frames.
+  std::vector<uint8_t> rotated_alpha_buffer_;
+
+  /// Rotation of the frame being delivered, after the delivery options were
+  /// applied.
+  VideoRotation delivered_rotation_{VideoRotation::k0};
+
+  /// Reusable NV12 scratch buffer to avoid per-frame allocation.
+  std::unique_ptr<uint8_t, webrtc::AlignedFreeDeleter> nv12_scratch_buffer_;
+
+  /// Capacity of |nv12_scratch_buffer_|, in bytes.
+  size_t nv12_scratch_size_ = 0;
+
+  /// Reusable scratch buffer for the packed planes of I420A frames.
+  std::unique_ptr<uint8_t, webrtc::AlignedFreeDeleter> packed_scratch_buffer_;
+
+  /// Capacity of |packed_scratch_buffer_|, in bytes.
+  size_t packed_scratch_size_ = 0;
+
+  /// Accounting of |scaled_alpha_buffer_|, |rotated_alpha_buffer_|,
+  /// |nv12_scratch_buffer_|, and |packed_scratch_buffer_| as scratch buffer
+  /// memory.
+  MemoryCharge scratch_memory_charge_{MemoryCategory::kScratchBuffers};
+
+  /// Whether asynchronous delivery is enabled. This mirrors whether
+  /// |delivery_thread_| is set, so that |OnFrame()| in synchronous mode does
+  /// not need to acquire |async_mutex_|.
+  std::atomic<bool> async_enabled_{false};
+
+  /// Mutex protecting the asynchronous delivery state. This is never held
+  /// while delivering a frame, to avoid blocking the producer thread.
+  mutable std::mutex async_mutex_;
 
-  /// Registered callback for receiving raw decoded ARGB frame.
-  Argb32FrameReadyCallback argb_callback_ RTC_GUARDED_BY(mutex_);
+  /// Thread converting and delivering frames when asynchronous delivery is
+  /// enabled, or NULL otherwise.
+  std::unique_ptr<rtc::Thread> delivery_thread_ RTC_GUARDED_BY(async_mutex_);
 
-  /// Mutex protecting all callbacks as well as the ARGB32 scratch buffer.
-  std::mutex mutex_;
+  /// Latest frame pending asynchronous delivery, if any.
+  absl::optional<webrtc::VideoFrame> pending_frame_
+      RTC_GUARDED_BY(async_mutex_);
 
-  /// Reusable ARGB scratch buffer to avoid per-frame allocation.
-  rtc::scoped_refptr<ArgbBuffer> argb_scratch_buffer_ RTC_GUARDED_BY(mutex_);
+  /// Number of pending frames replaced by a newer one before delivery.
+  uint64_t async_dropped_frame_count_ RTC_GUARDED_BY(async_mutex_) = 0;
 };
 
 }  // namespace WebRTC
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "video_frame_queue.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Replace a lease over a native buffer by a lease over an I420 copy of it.
+void ConvertToI420(VideoFrameLease& lease) {
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer(
+      static_cast<webrtc::VideoFrameBuffer*>(lease.buffer_handle_));
+  buffer->Release();  // Adopt the reference of the lease
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 = buffer->ToI420();
+  lease = VideoFrameLease{};
+  if (!i420) {
+    return;
+  }
+  lease.type_ = VideoFrameBufferType::kI420;
+  lease.width_ = i420->width();
+  lease.height_ = i420->height();
+  lease.ydata_ = i420->DataY();
+  lease.udata_ = i420->DataU();
+  lease.vdata_ = i420->DataV();
+  lease.ystride_ = i420->StrideY();
+  lease.ustride_ = i420->StrideU();
+  lease.vstride_ = i420->StrideV();
+  lease.buffer_handle_ = i420.release();
+}
+
+/// Size in bytes of the planes of a lease over an I420 or I420A buffer.
+size_t LeaseSize(const VideoFrameLease& lease) noexcept {
+  const size_t height = lease.height_;
+  const size_t chroma_height = (height + 1) / 2;
+  return height * (size_t)(lease.ystride_ + lease.astride_) +
+         chroma_height * (size_t)(lease.ustride_ + lease.vstride_);
+}
+
+void ReleaseLease(const VideoFrameLease& lease) {
+  static_cast<webrtc::VideoFrameBuffer*>(lease.buffer_handle_)->Release();
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+constexpr uint32_t VideoFrameQueue::kMaxDepth;
+
+VideoFrameQueue::VideoFrameQueue(uint32_t depth) noexcept : entries_(depth) {
+  RTC_DCHECK_GE(depth, 1u);
+  RTC_DCHECK_LE(depth, kMaxDepth);
+}
+
+VideoFrameQueue::~VideoFrameQueue() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (count_ > 0) {
+    ReleaseLease(PopFrontNoLock());
+  }
+}
+
+void MRS_CALL VideoFrameQueue::StaticEnqueue(
+    void* user_data,
+    const VideoFrameLease& lease) noexcept {
+  static_cast<VideoFrameQueue*>(user_data)->Enqueue(lease);
+}
+
+void VideoFrameQueue::Enqueue(const VideoFrameLease& lease) noexcept {
+  VideoFrameLease frame = lease;
+  if ((frame.type_ == VideoFrameBufferType::kNative) ||
+      (frame.type_ == VideoFrameBufferType::kI010)) {
+    // Convert outside the lock, as this can be slow for GPU textures
+    ConvertToI420(frame);
+    if (!frame.buffer_handle_) {
+      return;
+    }
+  }
+  const int64_t now_us = rtc::TimeMicros();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == entries_.size()) {
+    // Latest wins; drop the oldest frame
+    ReleaseLease(PopFrontNoLock());
+    ++dropped_count_;
+  }
+  Entry& entry = entries_[(front_ + count_) % entries_.size()];
+  entry.lease = frame;
+  entry.enqueue_time_us = now_us;
+  entry.size = LeaseSize(frame);
+  ++count_;
+  ++enqueued_count_;
+  memory_charge_.Set(memory_charge_.bytes() + entry.size);
+}
+
+bool VideoFrameQueue::TryDequeue(VideoFrameLease& lease) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return false;
+  }
+  queue_latency_.Record(rtc::TimeMicros() - entries_[front_].enqueue_time_us);
+  lease = PopFrontNoLock();
+  ++dequeued_count_;
+  return true;
+}
+
+const VideoFrameLease& VideoFrameQueue::PopFrontNoLock() noexcept {
+  const Entry& entry = entries_[front_];
+  front_ = (front_ + 1) % entries_.size();
+  --count_;
+  memory_charge_.Set(memory_charge_.bytes() - entry.size);
+  return entry.lease;
+}
+
+VideoFrameQueueStats VideoFrameQueue::GetStats() const noexcept {
+  VideoFrameQueueStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.enqueued_count_ = enqueued_count_;
+    stats.dequeued_count_ = dequeued_count_;
+    stats.dropped_count_ = dropped_count_;
+    stats.queued_count_ = (uint32_t)count_;
+  }
+  stats.queue_latency_ = queue_latency_.GetSummary();
+  return stats;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
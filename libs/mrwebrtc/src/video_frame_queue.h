@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "memory_accounting.h"
+#include "video_frame_observer.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Statistics of a |VideoFrameQueue|.
+struct VideoFrameQueueStats {
+  /// Number of frames enqueued since the queue was created.
+  uint64_t enqueued_count_ = 0;
+
+  /// Number of frames dequeued since the queue was created.
+  uint64_t dequeued_count_ = 0;
+
+  /// Number of frames dropped because the queue was full when a newer frame
+  /// arrived.
+  uint64_t dropped_count_ = 0;
+
+  /// Number of frames currently in the queue.
+  uint32_t queued_count_ = 0;
+
+  /// Time spent by the dequeued frames in the queue.
+  LatencySummary queue_latency_;
+};
+
+/// Fixed-depth queue of video frames, fed as a frame lease subscriber of a
+/// video track source or a video track, and drained by the application. The
+/// queue holds references to the original frame buffers, which are pooled by
+/// the sources and decoders, so enqueuing a frame does not copy nor allocate.
+/// Once full, a new frame replaces the oldest one.
+///
+/// Frames of native buffers are converted to I420 when enqueued, so that all
+/// dequeued frames expose their planes.
+class VideoFrameQueue {
+ public:
+  /// Maximum depth of a queue.
+  static constexpr uint32_t kMaxDepth = 16;
+
+  /// Create a queue holding up to |depth| frames, between 1 and |kMaxDepth|.
+  explicit VideoFrameQueue(uint32_t depth) noexcept;
+
+  /// Release the frames still in the queue. The queue must not be subscribed
+  /// to any frame source anymore.
+  ~VideoFrameQueue() noexcept;
+
+  /// Get the callback feeding the queue, to subscribe to a frame source.
+  VideoFrameLeaseCallback GetCallback() noexcept {
+    return {&StaticEnqueue, this};
+  }
+
+  /// Enqueue a frame, taking ownership of its lease.
+  void Enqueue(const VideoFrameLease& lease) noexcept;
+
+  /// Dequeue the oldest frame. On success the caller owns the lease, and must
+  /// release it with |mrsVideoFrameBufferRemoveRef()|. Return |false| if the
+  /// queue is empty.
+  bool TryDequeue(VideoFrameLease& lease) noexcept;
+
+  /// Get the statistics of the queue.
+  VideoFrameQueueStats GetStats() const noexcept;
+
+ private:
+  struct Entry {
+    VideoFrameLease lease;
+    int64_t enqueue_time_us;
+    size_t size;
+  };
+
+  /// Remove the frame at the front of the queue, and return its lease.
+  const VideoFrameLease& PopFrontNoLock() noexcept
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  static void MRS_CALL StaticEnqueue(void* user_data,
+                                     const VideoFrameLease& lease) noexcept;
+
+  mutable std::mutex mutex_;
+
+  /// Ring of |count_| frames starting at |front_|, allocated once.
+  std::vector<Entry> entries_ RTC_GUARDED_BY(mutex_);
+  size_t front_ RTC_GUARDED_BY(mutex_) = 0;
+  size_t count_ RTC_GUARDED_BY(mutex_) = 0;
+
+  uint64_t enqueued_count_ RTC_GUARDED_BY(mutex_) = 0;
+  uint64_t dequeued_count_ RTC_GUARDED_BY(mutex_) = 0;
+  uint64_t dropped_count_ RTC_GUARDED_BY(mutex_) = 0;
+
+  /// Accounting of the frames in the queue as frame buffer memory.
+  MemoryCharge memory_charge_ RTC_GUARDED_BY(mutex_){
+      MemoryCategory::kFrameBuffers};
+
+  LatencyHistogram queue_latency_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,542 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "video_texture_uploader.h"
+
+#include <atomic>
+#include <unordered_map>
+
+#include "color_conversion.h"
+
+#if defined(MR_SHARING_WIN)
+#include <d3d11.h>
+#include <wrl\client.h>
+#if !defined(WINUWP)
+#include <d3dcompiler.h>
+#endif
+#elif defined(MR_SHARING_ANDROID)
+#include <GLES3/gl3.h>
+#endif
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Uploaders registered for render events, by event identifier. Render events
+/// hold the mutex while uploading, so that uploaders are never destroyed
+/// during an upload.
+std::mutex g_uploaders_mutex;
+std::unordered_map<int32_t, VideoTextureUploader*> g_uploaders
+    RTC_GUARDED_BY(g_uploaders_mutex);
+std::atomic<int32_t> g_next_event_id{1};
+
+void ReleaseLease(const VideoFrameLease& lease) noexcept {
+  static_cast<webrtc::VideoFrameBuffer*>(lease.buffer_handle_)->Release();
+}
+
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+/// Compute shader converting the I420 planes of a frame from BT.601 limited
+/// range to RGBA, one thread per pixel.
+constexpr const char kI420ToRgbaShader[] = R"(
+Texture2D<float> y_plane : register(t0);
+Texture2D<float> u_plane : register(t1);
+Texture2D<float> v_plane : register(t2);
+RWTexture2D<unorm float4> rgba : register(u0);
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID) {
+  uint width, height;
+  rgba.GetDimensions(width, height);
+  if ((id.x >= width) || (id.y >= height)) {
+    return;
+  }
+  float y = 1.164383 * (y_plane[id.xy] - 0.062745);
+  float u = u_plane[id.xy / 2] - 0.501961;
+  float v = v_plane[id.xy / 2] - 0.501961;
+  rgba[id.xy] = float4(saturate(y + 1.596027 * v),
+                       saturate(y - 0.391762 * u - 0.812968 * v),
+                       saturate(y + 2.017232 * u), 1.0);
+}
+)";
+
+/// Size of the thread groups of the shader in each dimension.
+constexpr const uint32_t kThreadGroupSize = 8;
+
+/// Get |D3DCompile()|, loading the compiler on first use so that the library
+/// does not depend on it when the shader is not used. The compiler is never
+/// unloaded.
+pD3DCompile GetD3DCompile() noexcept {
+  static const pD3DCompile compile = []() -> pD3DCompile {
+    HMODULE module = LoadLibraryW(D3DCOMPILER_DLL_W);
+    if (!module) {
+      return nullptr;
+    }
+    return reinterpret_cast<pD3DCompile>(GetProcAddress(module, "D3DCompile"));
+  }();
+  return compile;
+}
+
+#endif  // defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+using Microsoft::WRL::ComPtr;
+
+/// Converter of I420 frames to RGBA textures with a compute shader, on the
+/// device of the textures. The planes are uploaded into textures owned by the
+/// converter, and the shader writes the RGBA texture directly if it can be
+/// bound for unordered access, or else an intermediate texture which is then
+/// copied into it. This runs on the render thread of the application, with
+/// the immediate context of the device, and restores the compute state it
+/// changes.
+class D3D11ColorConverter {
+ public:
+  /// Create a converter for |device|, or return NULL if the device or the
+  /// shader compiler does not support compute shaders.
+  static std::unique_ptr<D3D11ColorConverter> Create(
+      ID3D11Device* device) noexcept;
+
+  ID3D11Device* device() const noexcept { return device_.Get(); }
+
+  /// Convert the frame of |lease| into |output|, which must have the size of
+  /// the frame.
+  bool Convert(ID3D11DeviceContext* context,
+               const VideoFrameLease& lease,
+               ID3D11Texture2D* output) noexcept;
+
+  /// Release the reference to the last output texture.
+  void ReleaseOutput() noexcept;
+
+ private:
+  explicit D3D11ColorConverter(ID3D11Device* device) noexcept
+      : device_(device) {}
+
+  /// Recreate the plane textures if the frame size changed.
+  bool EnsurePlanes(uint32_t width, uint32_t height) noexcept;
+
+  /// Create the view written by the shader for |output|, if not done yet.
+  bool EnsureOutput(ID3D11Texture2D* output) noexcept;
+
+  ComPtr<ID3D11Device> device_;
+  ComPtr<ID3D11ComputeShader> shader_;
+
+  /// Y, U, and V planes of the last frame, and their size.
+  ComPtr<ID3D11Texture2D> planes_[3];
+  ComPtr<ID3D11ShaderResourceView> plane_views_[3];
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+
+  /// Last output texture, texture written by the shader for it, which is the
+  /// output texture itself or an intermediate texture, and view of the latter.
+  ComPtr<ID3D11Texture2D> output_;
+  ComPtr<ID3D11Texture2D> target_;
+  ComPtr<ID3D11UnorderedAccessView> target_view_;
+};
+
+std::unique_ptr<D3D11ColorConverter> D3D11ColorConverter::Create(
+    ID3D11Device* device) noexcept {
+  if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0) {
+    RTC_LOG(LS_INFO) << "Device feature level too low for the color "
+                        "conversion shader.";
+    return nullptr;
+  }
+  pD3DCompile compile = GetD3DCompile();
+  if (!compile) {
+    RTC_LOG(LS_WARNING) << "Cannot load the shader compiler for the color "
+                           "conversion shader.";
+    return nullptr;
+  }
+  ComPtr<ID3DBlob> code;
+  ComPtr<ID3DBlob> errors;
+  HRESULT hr = compile(kI420ToRgbaShader, sizeof(kI420ToRgbaShader) - 1,
+                       "i420_to_rgba", nullptr, nullptr, "main", "cs_5_0",
+                       D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &code, &errors);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to compile the color conversion shader: "
+                      << (errors ? static_cast<const char*>(
+                                       errors->GetBufferPointer())
+                                 : "unknown error");
+    return nullptr;
+  }
+  std::unique_ptr<D3D11ColorConverter> converter(
+      new D3D11ColorConverter(device));
+  hr = device->CreateComputeShader(code->GetBufferPointer(),
+                                   code->GetBufferSize(), nullptr,
+                                   &converter->shader_);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to create the color conversion shader: "
+                      << hr;
+    return nullptr;
+  }
+  return converter;
+}
+
+bool D3D11ColorConverter::Convert(ID3D11DeviceContext* context,
+                                  const VideoFrameLease& lease,
+                                  ID3D11Texture2D* output) noexcept {
+  if (!EnsurePlanes(lease.width_, lease.height_) || !EnsureOutput(output)) {
+    return false;
+  }
+  context->UpdateSubresource(planes_[0].Get(), 0, nullptr, lease.ydata_,
+                             (UINT)lease.ystride_, 0);
+  context->UpdateSubresource(planes_[1].Get(), 0, nullptr, lease.udata_,
+                             (UINT)lease.ustride_, 0);
+  context->UpdateSubresource(planes_[2].Get(), 0, nullptr, lease.vdata_,
+                             (UINT)lease.vstride_, 0);
+
+  // Save the compute state changed here, which the engine may rely on.
+  ID3D11ComputeShader* previous_shader = nullptr;
+  ID3D11ShaderResourceView* previous_views[3]{};
+  ID3D11UnorderedAccessView* previous_target_view = nullptr;
+  context->CSGetShader(&previous_shader, nullptr, nullptr);
+  context->CSGetShaderResources(0, 3, previous_views);
+  context->CSGetUnorderedAccessViews(0, 1, &previous_target_view);
+
+  ID3D11ShaderResourceView* views[3]{plane_views_[0].Get(),
+                                     plane_views_[1].Get(),
+                                     plane_views_[2].Get()};
+  ID3D11UnorderedAccessView* target_view = target_view_.Get();
+  context->CSSetShader(shader_.Get(), nullptr, 0);
+  context->CSSetShaderResources(0, 3, views);
+  context->CSSetUnorderedAccessViews(0, 1, &target_view, nullptr);
+  context->Dispatch((lease.width_ + kThreadGroupSize - 1) / kThreadGroupSize,
+                    (lease.height_ + kThreadGroupSize - 1) / kThreadGroupSize,
+                    1);
+
+  context->CSSetShader(previous_shader, nullptr, 0);
+  context->CSSetShaderResources(0, 3, previous_views);
+  context->CSSetUnorderedAccessViews(0, 1, &previous_target_view, nullptr);
+  if (previous_shader) {
+    previous_shader->Release();
+  }
+  for (ID3D11ShaderResourceView* view : previous_views) {
+    if (view) {
+      view->Release();
+    }
+  }
+  if (previous_target_view) {
+    previous_target_view->Release();
+  }
+
+  if (target_ != output_) {
+    context->CopySubresourceRegion(output, 0, 0, 0, 0, target_.Get(), 0,
+                                   nullptr);
+  }
+  return true;
+}
+
+void D3D11ColorConverter::ReleaseOutput() noexcept {
+  target_view_.Reset();
+  target_.Reset();
+  output_.Reset();
+}
+
+bool D3D11ColorConverter::EnsurePlanes(uint32_t width,
+                                       uint32_t height) noexcept {
+  if ((width == width_) && (height == height_)) {
+    return true;
+  }
+  width_ = 0;
+  height_ = 0;
+  for (int i = 0; i < 3; ++i) {
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = (i == 0 ? width : (width + 1) / 2);
+    desc.Height = (i == 0 ? height : (height + 1) / 2);
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    plane_views_[i].Reset();
+    planes_[i].Reset();
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &planes_[i])) ||
+        FAILED(device_->CreateShaderResourceView(planes_[i].Get(), nullptr,
+                                                 &plane_views_[i]))) {
+      return false;
+    }
+  }
+  width_ = width;
+  height_ = height;
+  return true;
+}
+
+bool D3D11ColorConverter::EnsureOutput(ID3D11Texture2D* output) noexcept {
+  if (output == output_.Get()) {
+    return true;
+  }
+  ReleaseOutput();
+  D3D11_TEXTURE2D_DESC desc{};
+  output->GetDesc(&desc);
+  ComPtr<ID3D11Texture2D> target;
+  if (desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) {
+    target = output;
+  } else {
+    D3D11_TEXTURE2D_DESC target_desc{};
+    target_desc.Width = desc.Width;
+    target_desc.Height = desc.Height;
+    target_desc.MipLevels = 1;
+    target_desc.ArraySize = 1;
+    target_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    target_desc.SampleDesc.Count = 1;
+    target_desc.Usage = D3D11_USAGE_DEFAULT;
+    target_desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(device_->CreateTexture2D(&target_desc, nullptr, &target))) {
+      return false;
+    }
+  }
+  // Typeless textures need the format of the view.
+  D3D11_UNORDERED_ACCESS_VIEW_DESC view_desc{};
+  view_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  view_desc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+  view_desc.Texture2D.MipSlice = 0;
+  if (FAILED(device_->CreateUnorderedAccessView(target.Get(), &view_desc,
+                                                &target_view_))) {
+    return false;
+  }
+  output_ = output;
+  target_ = std::move(target);
+  return true;
+}
+
+#endif  // defined(MR_SHARING_WIN) && !defined(WINUWP)
+
+bool VideoTextureUploader::IsApiSupported(mrsVideoTextureApi api) noexcept {
+#if defined(MR_SHARING_WIN)
+  return (api == mrsVideoTextureApi::kD3D11);
+#elif defined(MR_SHARING_ANDROID)
+  return (api == mrsVideoTextureApi::kOpenGLES3);
+#else
+  return false;
+#endif
+}
+
+VideoTextureUploader::VideoTextureUploader(VideoFrameQueue& queue,
+                                           mrsVideoTextureApi api)
+    : queue_(queue), api_(api), event_id_(g_next_event_id.fetch_add(1)) {
+  RTC_DCHECK(IsApiSupported(api));
+  std::lock_guard<std::mutex> lock(g_uploaders_mutex);
+  g_uploaders.emplace(event_id_, this);
+}
+
+VideoTextureUploader::~VideoTextureUploader() noexcept {
+  std::lock_guard<std::mutex> lock(g_uploaders_mutex);
+  g_uploaders.erase(event_id_);
+}
+
+Result VideoTextureUploader::SetTextures(
+    const mrsVideoTextures* textures) noexcept {
+  if (textures) {
+    if ((textures->width == 0) || (textures->height == 0)) {
+      return Result::kInvalidParameter;
+    }
+    if (textures->rgba_texture) {
+      if (textures->y_texture || textures->u_texture || textures->v_texture) {
+        return Result::kInvalidParameter;
+      }
+      if (api_ != mrsVideoTextureApi::kD3D11) {
+        return Result::kUnsupported;
+      }
+    } else if (!textures->y_texture || !textures->u_texture ||
+               !textures->v_texture) {
+      return Result::kInvalidParameter;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  textures_ = (textures ? *textures : mrsVideoTextures{});
+  rgba_buffer_ = std::vector<uint8_t>();
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+  // Do not keep the previous texture alive, and retry the shader on the next
+  // texture, which may belong to another device.
+  if (converter_) {
+    converter_->ReleaseOutput();
+  }
+  converter_failed_ = false;
+#endif
+  return Result::kSuccess;
+}
+
+mrsVideoTextureUploaderStats VideoTextureUploader::GetStats() const noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void MRS_CALL VideoTextureUploader::OnRenderEvent(int32_t event_id) noexcept {
+  std::lock_guard<std::mutex> lock(g_uploaders_mutex);
+  auto it = g_uploaders.find(event_id);
+  if (it != g_uploaders.end()) {
+    it->second->UploadLatestFrame();
+  }
+}
+
+void VideoTextureUploader::UploadLatestFrame() noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!textures_.y_texture && !textures_.rgba_texture) {
+    // Leave the frames in the queue for when the textures are set.
+    return;
+  }
+  VideoFrameLease lease{};
+  VideoFrameLease next{};
+  while (queue_.TryDequeue(next)) {
+    if (lease.buffer_handle_) {
+      ReleaseLease(lease);
+      ++stats_.skipped_count;
+    }
+    lease = next;
+  }
+  if (!lease.buffer_handle_) {
+    return;
+  }
+  stats_.frame_width = lease.width_;
+  stats_.frame_height = lease.height_;
+  bool uploaded = false;
+  if (((lease.type_ == VideoFrameBufferType::kI420) ||
+       (lease.type_ == VideoFrameBufferType::kI420A)) &&
+      (lease.width_ == textures_.width) &&
+      (lease.height_ == textures_.height)) {
+    if (textures_.rgba_texture) {
+      uploaded = UploadRgba(lease);
+    } else {
+      const uint32_t chroma_width = (lease.width_ + 1) / 2;
+      const uint32_t chroma_height = (lease.height_ + 1) / 2;
+      uploaded =
+          UploadPlane(textures_.y_texture, lease.ydata_, lease.ystride_,
+                      lease.width_, lease.height_) &&
+          UploadPlane(textures_.u_texture, lease.udata_, lease.ustride_,
+                      chroma_width, chroma_height) &&
+          UploadPlane(textures_.v_texture, lease.vdata_, lease.vstride_,
+                      chroma_width, chroma_height);
+    }
+  }
+  ++(uploaded ? stats_.uploaded_count : stats_.skipped_count);
+  ReleaseLease(lease);
+}
+
+bool VideoTextureUploader::UploadPlane(void* texture,
+                                       const void* data,
+                                       int32_t stride,
+                                       uint32_t width,
+                                       uint32_t height) noexcept {
+#if defined(MR_SHARING_WIN)
+  RTC_DCHECK(api_ == mrsVideoTextureApi::kD3D11);
+  auto d3d_texture = static_cast<ID3D11Texture2D*>(texture);
+  D3D11_TEXTURE2D_DESC desc{};
+  d3d_texture->GetDesc(&desc);
+  if ((desc.Width != width) || (desc.Height != height) ||
+      (desc.Format != DXGI_FORMAT_R8_UNORM)) {
+    return false;
+  }
+  ID3D11Device* device = nullptr;
+  d3d_texture->GetDevice(&device);
+  ID3D11DeviceContext* context = nullptr;
+  device->GetImmediateContext(&context);
+  context->UpdateSubresource(d3d_texture, 0, nullptr, data, (UINT)stride, 0);
+  context->Release();
+  device->Release();
+  return true;
+#elif defined(MR_SHARING_ANDROID)
+  RTC_DCHECK(api_ == mrsVideoTextureApi::kOpenGLES3);
+  // Restore the state changed here, which the engine may rely on.
+  GLint previous_texture = 0;
+  GLint previous_alignment = 4;
+  GLint previous_row_length = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &previous_row_length);
+  glBindTexture(GL_TEXTURE_2D, (GLuint)(uintptr_t)texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)width, (GLsizei)height,
+                  GL_RED, GL_UNSIGNED_BYTE, data);
+  const bool success = (glGetError() == GL_NO_ERROR);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, previous_row_length);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+  glBindTexture(GL_TEXTURE_2D, (GLuint)previous_texture);
+  return success;
+#else
+  (void)texture;
+  (void)data;
+  (void)stride;
+  (void)width;
+  (void)height;
+  return false;
+#endif
+}
+
+bool VideoTextureUploader::UploadRgba(const VideoFrameLease& lease) noexcept {
+#if defined(MR_SHARING_WIN)
+  RTC_DCHECK(api_ == mrsVideoTextureApi::kD3D11);
+  auto texture = static_cast<ID3D11Texture2D*>(textures_.rgba_texture);
+  D3D11_TEXTURE2D_DESC desc{};
+  texture->GetDesc(&desc);
+  if ((desc.Width != lease.width_) || (desc.Height != lease.height_) ||
+      ((desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM) &&
+       (desc.Format != DXGI_FORMAT_R8G8B8A8_TYPELESS)) ||
+      (desc.Usage != D3D11_USAGE_DEFAULT) || (desc.SampleDesc.Count != 1)) {
+    return false;
+  }
+  Microsoft::WRL::ComPtr<ID3D11Device> device;
+  texture->GetDevice(&device);
+  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+  device->GetImmediateContext(&context);
+
+#if !defined(WINUWP)
+  if (converter_ && (converter_->device() != device.Get())) {
+    converter_.reset();
+  }
+  if (!converter_ && !converter_failed_) {
+    converter_ = D3D11ColorConverter::Create(device.Get());
+    if (!converter_) {
+      RTC_LOG(LS_WARNING) << "Color conversion shader not available, "
+                             "converting video frames on the CPU.";
+      converter_failed_ = true;
+    }
+  }
+  if (converter_ && converter_->Convert(context.Get(), lease, texture)) {
+    return true;
+  }
+#endif  // !defined(WINUWP)
+
+  // Fall back to the CPU. libyuv names formats by little-endian words, so
+  // ABGR is RGBA in memory.
+  const int width = (int)lease.width_;
+  const int height = (int)lease.height_;
+  const int stride = width * 4;
+  rgba_buffer_.resize((size_t)stride * height);
+  uint8_t* const rgba = rgba_buffer_.data();
+  auto yptr = static_cast<const uint8_t*>(lease.ydata_);
+  auto uptr = static_cast<const uint8_t*>(lease.udata_);
+  auto vptr = static_cast<const uint8_t*>(lease.vdata_);
+  ForEachRowBand(width, height, [&](int row_begin, int row_end) {
+    const int chroma_row = row_begin / 2;
+    libyuv::I420ToABGR(yptr + (size_t)row_begin * lease.ystride_,
+                       lease.ystride_,
+                       uptr + (size_t)chroma_row * lease.ustride_,
+                       lease.ustride_,
+                       vptr + (size_t)chroma_row * lease.vstride_,
+                       lease.vstride_, rgba + (size_t)row_begin * stride,
+                       stride, width, row_end - row_begin);
+  });
+  context->UpdateSubresource(texture, 0, nullptr, rgba, (UINT)stride, 0);
+  ++stats_.cpu_converted_count;
+  return true;
+#else
+  (void)lease;
+  return false;
+#endif
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "mrs_errors.h"
+#include "video_frame_queue.h"
+#include "video_texture_uploader_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+class D3D11ColorConverter;
+#endif
+
+/// Uploader of the frames of a |VideoFrameQueue| to GPU textures, driven by
+/// render events issued on the render thread of the application. The planes
+/// of the frame buffers are written directly into the textures, without any
+/// intermediate copy, or converted to RGBA by a compute shader with Direct3D
+/// 11.
+class VideoTextureUploader {
+ public:
+  /// Check if a graphics API is supported on the current platform.
+  static bool IsApiSupported(mrsVideoTextureApi api) noexcept;
+
+  /// Create an uploader dequeuing frames from |queue|, which must outlive it,
+  /// and register it for render events.
+  VideoTextureUploader(VideoFrameQueue& queue, mrsVideoTextureApi api);
+
+  /// Unregister the uploader. Once this returns, no render event uses it.
+  ~VideoTextureUploader() noexcept;
+
+  /// Identifier of the render events of this uploader.
+  int32_t event_id() const noexcept { return event_id_; }
+
+  /// Set the textures receiving the frames, or clear them if |textures| is
+  /// NULL.
+  Result SetTextures(const mrsVideoTextures* textures) noexcept;
+
+  mrsVideoTextureUploaderStats GetStats() const noexcept;
+
+  /// Render event function, uploading the latest frame of the uploader
+  /// registered with |event_id|, if any.
+  static void MRS_CALL OnRenderEvent(int32_t event_id) noexcept;
+
+ private:
+  /// Dequeue all frames of the queue, and upload the latest one. This runs on
+  /// the render thread of the application, with the graphics context current.
+  void UploadLatestFrame() noexcept;
+
+  /// Upload a plane of |width| x |height| bytes to |texture|.
+  bool UploadPlane(void* texture,
+                   const void* data,
+                   int32_t stride,
+                   uint32_t width,
+                   uint32_t height) noexcept;
+
+  /// Convert the frame of |lease| to RGBA into the RGBA texture, on the GPU if
+  /// possible, or else on the CPU.
+  bool UploadRgba(const VideoFrameLease& lease) noexcept;
+
+  VideoFrameQueue& queue_;
+  const mrsVideoTextureApi api_;
+  const int32_t event_id_;
+
+  mutable std::mutex mutex_;
+  mrsVideoTextures textures_ RTC_GUARDED_BY(mutex_){};
+  mrsVideoTextureUploaderStats stats_ RTC_GUARDED_BY(mutex_){};
+
+  /// Frame converted on the CPU when the conversion shader is not available.
+  std::vector<uint8_t> rgba_buffer_ RTC_GUARDED_BY(mutex_);
+
+#if defined(MR_SHARING_WIN) && !defined(WINUWP)
+  /// Converter of the device of the RGBA texture, created on the first upload.
+  std::unique_ptr<D3D11ColorConverter> converter_ RTC_GUARDED_BY(mutex_);
+
+  /// Whether creating the converter failed for the current RGBA texture, to
+  /// fall back to the CPU without retrying on each frame.
+  bool converter_failed_ RTC_GUARDED_BY(mutex_){false};
+#endif
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
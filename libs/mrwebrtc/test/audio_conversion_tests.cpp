@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "audio_conversion.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+using detail::AudioKernelLevel;
+
+namespace {
+
+/// Lengths exercising the vectorized loops of each version along with their
+/// scalar tail, below, at and past each vector width.
+const size_t kLengths[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 481};
+
+/// Number of elements past the end of each output, which the kernels must not
+/// write.
+constexpr size_t kGuardLength = 16;
+
+class AudioConversionTests : public testing::Test {
+ protected:
+  void TearDown() override {
+    detail::SetAudioKernelLevel(detail::GetSupportedAudioKernelLevel());
+  }
+
+  /// Run |kernel| with the scalar version of the kernels, then with each
+  /// vectorized version supported by the CPU, and check that they all produce
+  /// the same |output|. The kernel fills |output| entirely on each run,
+  /// including its guard elements.
+  template <typename T, typename Kernel>
+  void ExpectSameAsScalar(std::vector<T>& output, Kernel&& kernel) {
+    detail::SetAudioKernelLevel(AudioKernelLevel::kScalar);
+    kernel();
+    const std::vector<T> expected = output;
+    const AudioKernelLevel supported = detail::GetSupportedAudioKernelLevel();
+    for (AudioKernelLevel level :
+         {AudioKernelLevel::kSimd, AudioKernelLevel::kAvx2}) {
+      if (level > supported) {
+        break;
+      }
+      detail::SetAudioKernelLevel(level);
+      kernel();
+      EXPECT_EQ(expected, output) << "Kernel level " << (int)level;
+    }
+  }
+
+  std::mt19937 random_{42};
+};
+
+/// Create |count| random 16-bit samples, starting with the extreme values.
+std::vector<int16_t> MakeS16Samples(std::mt19937& random, size_t count) {
+  std::uniform_int_distribution<int> dist(-32768, 32767);
+  const int16_t extremes[] = {-32768, 32767, -32767, 0, -1, 1, -32768, -32768};
+  std::vector<int16_t> samples(count);
+  for (size_t i = 0; i < count; ++i) {
+    samples[i] =
+        (i < std::size(extremes) ? extremes[i] : (int16_t)dist(random));
+  }
+  return samples;
+}
+
+}  // namespace
+
+TEST_F(AudioConversionTests, ConvertU8ToS16) {
+  for (size_t length : kLengths) {
+    std::vector<uint8_t> src(length);
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = (uint8_t)(i * 37 + (i % 3 == 0 ? 255 : 0));
+    }
+    std::vector<int16_t> dst(length + kGuardLength);
+    ExpectSameAsScalar(dst, [&]() {
+      std::fill(dst.begin(), dst.end(), (int16_t)0x5A5A);
+      ConvertU8ToS16(src.data(), dst.data(), length);
+    });
+    for (size_t i = 0; i < length; ++i) {
+      ASSERT_EQ(((int)src[i] - 128) * 256, dst[i]);
+    }
+    for (size_t i = length; i < dst.size(); ++i) {
+      ASSERT_EQ(0x5A5A, dst[i]);
+    }
+  }
+}
+
+TEST_F(AudioConversionTests, ConvertS16ToF32) {
+  for (size_t length : kLengths) {
+    const std::vector<int16_t> src = MakeS16Samples(random_, length);
+    std::vector<float> dst(length + kGuardLength);
+    ExpectSameAsScalar(dst, [&]() {
+      std::fill(dst.begin(), dst.end(), 42.0f);
+      ConvertS16ToF32(src.data(), dst.data(), length);
+    });
+    for (size_t i = 0; i < length; ++i) {
+      ASSERT_EQ((float)src[i] / 32768.0f, dst[i]);
+    }
+    for (size_t i = length; i < dst.size(); ++i) {
+      ASSERT_EQ(42.0f, dst[i]);
+    }
+  }
+}
+
+TEST_F(AudioConversionTests, ConvertF32ToS16) {
+  // Out-of-range values saturate, and halfway values round to even
+  const float special[] = {-1.0f,
+                           1.0f,
+                           -1.5f,
+                           1.5f,
+                           -1e9f,
+                           1e9f,
+                           std::numeric_limits<float>::max(),
+                           std::numeric_limits<float>::lowest(),
+                           0.5f / 32768.0f,
+                           1.5f / 32768.0f,
+                           -0.5f / 32768.0f,
+                           -2.5f / 32768.0f,
+                           32766.5f / 32768.0f,
+                           -32767.5f / 32768.0f,
+                           0.0f,
+                           -0.0f};
+  std::uniform_real_distribution<float> dist(-1.2f, 1.2f);
+  for (size_t length : kLengths) {
+    std::vector<float> src(length);
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = (i < std::size(special) ? special[i] : dist(random_));
+    }
+    std::vector<int16_t> dst(length + kGuardLength);
+    ExpectSameAsScalar(dst, [&]() {
+      std::fill(dst.begin(), dst.end(), (int16_t)0x5A5A);
+      ConvertF32ToS16(src.data(), dst.data(), length);
+    });
+    const int16_t expected[] = {-32768, 32767, -32768, 32767, -32768, 32767,
+                                32767,  -32768, 0,     2,     0,      -2,
+                                32766,  -32768, 0,     0};
+    for (size_t i = 0; i < std::min(length, std::size(expected)); ++i) {
+      ASSERT_EQ(expected[i], dst[i]) << "Value " << src[i];
+    }
+    for (size_t i = length; i < dst.size(); ++i) {
+      ASSERT_EQ(0x5A5A, dst[i]);
+    }
+  }
+}
+
+TEST_F(AudioConversionTests, DownmixStereoToMonoS16) {
+  for (size_t length : kLengths) {
+    const std::vector<int16_t> src = MakeS16Samples(random_, length * 2);
+    std::vector<int16_t> dst(length + kGuardLength);
+    ExpectSameAsScalar(dst, [&]() {
+      std::fill(dst.begin(), dst.end(), (int16_t)0x5A5A);
+      DownmixStereoToMonoS16(src.data(), dst.data(), length);
+    });
+    for (size_t i = length; i < dst.size(); ++i) {
+      ASSERT_EQ(0x5A5A, dst[i]);
+    }
+
+    // In place, each mono sample overwrites the first half of the buffer,
+    // while the stereo samples not yet averaged stay intact
+    std::vector<int16_t> in_place(length * 2 + kGuardLength);
+    ExpectSameAsScalar(in_place, [&]() {
+      std::copy(src.begin(), src.end(), in_place.begin());
+      std::fill(in_place.begin() + length * 2, in_place.end(),
+                (int16_t)0x5A5A);
+      DownmixStereoToMonoS16(in_place.data(), in_place.data(), length);
+    });
+    ASSERT_TRUE(std::equal(dst.begin(), dst.begin() + length,
+                           in_place.begin()));
+    for (size_t i = length * 2; i < in_place.size(); ++i) {
+      ASSERT_EQ(0x5A5A, in_place[i]);
+    }
+  }
+
+  // The average rounds toward negative infinity, and never overflows
+  const int16_t src[] = {-32768, -32768, 32767, 32767, -32768, 32767, -1, 0};
+  int16_t dst[4];
+  DownmixStereoToMonoS16(src, dst, 4);
+  ASSERT_EQ(-32768, dst[0]);
+  ASSERT_EQ(32767, dst[1]);
+  ASSERT_EQ(-1, dst[2]);
+  ASSERT_EQ(-1, dst[3]);
+}
+
+TEST_F(AudioConversionTests, UpmixMonoS16ToStereoF32) {
+  for (size_t length : kLengths) {
+    const std::vector<int16_t> src = MakeS16Samples(random_, length);
+    std::vector<float> dst(length * 2 + kGuardLength);
+    ExpectSameAsScalar(dst, [&]() {
+      std::fill(dst.begin(), dst.end(), 42.0f);
+      UpmixMonoS16ToStereoF32(src.data(), dst.data(), length);
+    });
+    for (size_t i = 0; i < length; ++i) {
+      ASSERT_EQ((float)src[i] / 32768.0f, dst[2 * i]);
+      ASSERT_EQ(dst[2 * i], dst[2 * i + 1]);
+    }
+    for (size_t i = length * 2; i < dst.size(); ++i) {
+      ASSERT_EQ(42.0f, dst[i]);
+    }
+  }
+}
+
+TEST_F(AudioConversionTests, MeasureLevelS16) {
+  for (size_t length : kLengths) {
+    const std::vector<int16_t> src = MakeS16Samples(random_, length);
+    std::vector<uint64_t> result(2);
+    ExpectSameAsScalar(result, [&]() {
+      uint64_t sum_of_squares = 42;
+      int peak = 42;
+      MeasureLevelS16(src.data(), length, &sum_of_squares, &peak);
+      result[0] = sum_of_squares;
+      result[1] = (uint64_t)peak;
+    });
+    uint64_t sum = 0;
+    int peak = 0;
+    for (int16_t value : src) {
+      sum += (uint64_t)((int)value * (int)value);
+      peak = std::max(peak, std::abs((int)value));
+    }
+    ASSERT_EQ(sum, result[0]);
+    ASSERT_EQ((uint64_t)peak, result[1]);
+  }
+
+  // The peak of a full-scale negative sample is 32768
+  const std::vector<int16_t> full_scale(17, -32768);
+  uint64_t sum_of_squares;
+  int peak;
+  MeasureLevelS16(full_scale.data(), full_scale.size(), &sum_of_squares,
+                  &peak);
+  ASSERT_EQ(32768, peak);
+  ASSERT_EQ(17ull * 32768 * 32768, sum_of_squares);
+}
+
+TEST_F(AudioConversionTests, MixAccumulateF32) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (size_t length : kLengths) {
+    std::vector<float> src(length);
+    std::vector<float> initial(length);
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = dist(random_);
+      initial[i] = dist(random_);
+    }
+    for (float gain : {0.0f, 0.7f, 1.0f, 3.0f}) {
+      std::vector<float> dst(length + kGuardLength);
+      ExpectSameAsScalar(dst, [&]() {
+        std::copy(initial.begin(), initial.end(), dst.begin());
+        std::fill(dst.begin() + length, dst.end(), 42.0f);
+        MixAccumulateF32(src.data(), gain, dst.data(), length);
+      });
+      for (size_t i = 0; i < length; ++i) {
+        // The mix is not clipped
+        ASSERT_EQ(initial[i] + src[i] * gain, dst[i]);
+      }
+      for (size_t i = length; i < dst.size(); ++i) {
+        ASSERT_EQ(42.0f, dst[i]);
+      }
+    }
+  }
+}
+
+TEST_F(AudioConversionTests, ScaleS16Ramp) {
+  // Unity, attenuation, ramps, and gains saturating full-scale samples
+  const float gains[][4] = {{1.0f, 1.0f, 0.0f, 0.0f},
+                            {0.5f, 0.25f, 0.0f, 0.0f},
+                            {0.0f, 1.0f, 0.002f, -0.002f},
+                            {2.0f, 3.0f, 0.01f, 0.0f}};
+  for (int channels : {1, 2}) {
+    for (size_t length : kLengths) {
+      const size_t count = length * channels;
+      const std::vector<int16_t> src = MakeS16Samples(random_, count);
+      for (const float* g : gains) {
+        const float gain[2] = {g[0], g[1]};
+        const float step[2] = {g[2], g[3]};
+        std::vector<int16_t> dst(count + kGuardLength);
+        ExpectSameAsScalar(dst, [&]() {
+          std::fill(dst.begin(), dst.end(), (int16_t)0x5A5A);
+          ScaleS16Ramp(src.data(), dst.data(), length, channels, gain, step);
+        });
+        for (size_t i = count; i < dst.size(); ++i) {
+          ASSERT_EQ(0x5A5A, dst[i]);
+        }
+
+        // In place produces the same result
+        std::vector<int16_t> in_place(count + kGuardLength);
+        ExpectSameAsScalar(in_place, [&]() {
+          std::copy(src.begin(), src.end(), in_place.begin());
+          std::fill(in_place.begin() + count, in_place.end(),
+                    (int16_t)0x5A5A);
+          ScaleS16Ramp(in_place.data(), in_place.data(), length, channels,
+                       gain, step);
+        });
+        ASSERT_EQ(dst, in_place);
+      }
+    }
+  }
+
+  // Saturation clamps to the 16-bit range
+  const int16_t src[] = {-32768, 32767, 20000, -20000};
+  int16_t dst[4];
+  const float gain[2] = {2.0f, 2.0f};
+  const float step[2] = {0.0f, 0.0f};
+  ScaleS16Ramp(src, dst, 2, 2, gain, step);
+  ASSERT_EQ(-32768, dst[0]);
+  ASSERT_EQ(32767, dst[1]);
+  ASSERT_EQ(32767, dst[2]);
+  ASSERT_EQ(-32768, dst[3]);
+}
+
+TEST_F(AudioConversionTests, UpmixMonoS16ToStereoS16Ramp) {
+  const float gains[][4] = {{1.0f, 1.0f, 0.0f, 0.0f},
+                            {0.8f, 0.2f, -0.001f, 0.001f},
+                            {2.5f, 0.0f, 0.0f, 0.01f}};
+  for (size_t length : kLengths) {
+    const std::vector<int16_t> src = MakeS16Samples(random_, length);
+    for (const float* g : gains) {
+      const float gain[2] = {g[0], g[1]};
+      const float step[2] = {g[2], g[3]};
+      std::vector<int16_t> dst(length * 2 + kGuardLength);
+      ExpectSameAsScalar(dst, [&]() {
+        std::fill(dst.begin(), dst.end(), (int16_t)0x5A5A);
+        UpmixMonoS16ToStereoS16Ramp(src.data(), dst.data(), length, gain,
+                                    step);
+      });
+      for (size_t i = length * 2; i < dst.size(); ++i) {
+        ASSERT_EQ(0x5A5A, dst[i]);
+      }
+
+      // This matches scaling the duplicated samples
+      std::vector<int16_t> stereo(length * 2);
+      for (size_t i = 0; i < length; ++i) {
+        stereo[2 * i] = stereo[2 * i + 1] = src[i];
+      }
+      std::vector<int16_t> scaled(length * 2);
+      ScaleS16Ramp(stereo.data(), scaled.data(), length, 2, gain, step);
+      ASSERT_TRUE(std::equal(scaled.begin(), scaled.end(), dst.begin()));
+    }
+  }
+}
@@ -3,8 +3,17 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
 #include "audio_frame.h"
 #include "device_audio_track_source_interop.h"
+#include "external_audio_track_source_interop.h"
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "remote_audio_track_interop.h"
@@ -30,6 +39,9 @@ using AudioTrackAddedCallback =
 // PeerConnectionAudioFrameCallback
 using AudioFrameCallback = InteropCallback<const AudioFrame&>;
 
+// AudioLevelCallback
+using AudioLevelCallback = InteropCallback<const mrsAudioLevel&>;
+
 bool IsSilent_uint8(const uint8_t* data,
                     uint32_t size,
                     uint8_t& min,
@@ -248,6 +260,295 @@ TEST_P(AudioTrackTests, Simple) {
   mrsRefCountedObjectRemoveRef(audio_source1);
 }
 
+TEST_P(AudioTrackTests, FrameAggregation) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteAudioTrackHandle audio_track2{};
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&audio_track2,
+       &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+        audio_track2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Stream audio from #1 to #2
+  mrsTransceiverHandle audio_transceiver1{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &audio_transceiver1));
+  mrsLocalAudioDeviceInitConfig device_config{};
+  mrsDeviceAudioTrackSourceHandle audio_source1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &audio_source1));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "test_audio_track";
+  mrsLocalAudioTrackHandle audio_track1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, audio_source1,
+                                               &audio_track1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver1, audio_track1));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, audio_track2);
+
+  // Invalid periods
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteAudioTrackSetFrameAggregationPeriod(nullptr, 40));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackSetFrameAggregationPeriod(audio_track2, -10));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackSetFrameAggregationPeriod(audio_track2, 2000));
+
+  // Deliver batches of 40ms
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetFrameAggregationPeriod(audio_track2, 40));
+  std::atomic<uint32_t> call_count{0};
+  std::atomic<int64_t> last_timestamp_us{0};
+  AudioFrameCallback audio2_cb = [&](const AudioFrame& frame) {
+    ASSERT_NE(nullptr, frame.data_);
+    ASSERT_LT(0u, frame.sampling_rate_hz_);
+    // Frames are only delivered early on format change, which should not
+    // happen while streaming from the same device.
+    if (call_count > 0) {
+      EXPECT_LE(frame.sampling_rate_hz_ * 40 / 1000, frame.sample_count_);
+      EXPECT_LT(last_timestamp_us, frame.timestamp_us_);
+    }
+    last_timestamp_us = frame.timestamp_us_;
+    ++call_count;
+  };
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(audio2_cb));
+
+  Event ev;
+  ev.WaitFor(3s);
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
+
+  // 3s is 75 batches of 40ms, or 300 frames without aggregation
+  ASSERT_LT(30u, call_count.load());
+  ASSERT_GT(100u, call_count.load());
+
+  // Clean-up
+  mrsRefCountedObjectRemoveRef(audio_track1);
+  mrsRefCountedObjectRemoveRef(audio_source1);
+}
+
+TEST_P(AudioTrackTests, AudioLevel) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteAudioTrackHandle audio_track2{};
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&audio_track2,
+       &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+        audio_track2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Stream audio from #1 to #2
+  mrsTransceiverHandle audio_transceiver1{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &audio_transceiver1));
+  mrsLocalAudioDeviceInitConfig device_config{};
+  mrsDeviceAudioTrackSourceHandle audio_source1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &audio_source1));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "test_audio_track";
+  mrsLocalAudioTrackHandle audio_track1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, audio_source1,
+                                               &audio_track1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver1, audio_track1));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, audio_track2);
+
+  // Invalid arguments
+  mrsAudioLevel level{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteAudioTrackGetAudioLevel(nullptr, &level));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackGetAudioLevel(audio_track2, nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteAudioTrackRegisterAudioLevelCallback(nullptr, 0.0f,
+                                                          nullptr, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackRegisterAudioLevelCallback(audio_track2, -1.0f,
+                                                          nullptr, nullptr));
+
+  // A zero threshold reports the level of every frame
+  std::atomic<uint32_t> call_count{0};
+  AudioLevelCallback level2_cb = [&call_count](const mrsAudioLevel& level) {
+    EXPECT_LE(0.0f, level.rms);
+    EXPECT_LE(level.rms, level.peak + 1e-6f);
+    EXPECT_GE(1.0f, level.peak);
+    ++call_count;
+  };
+  ASSERT_EQ(Result::kSuccess, mrsRemoteAudioTrackRegisterAudioLevelCallback(
+                                  audio_track2, 0.0f, CB(level2_cb)));
+
+  Event ev;
+  ev.WaitFor(1s);
+  ASSERT_EQ(Result::kSuccess, mrsRemoteAudioTrackRegisterAudioLevelCallback(
+                                  audio_track2, 0.0f, nullptr, nullptr));
+
+  // 1s is 100 frames of 10ms
+  ASSERT_LT(50u, call_count.load());
+  ASSERT_GT(150u, call_count.load());
+
+  // The polled level is consistent with the callback one
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackGetAudioLevel(audio_track2, &level));
+  ASSERT_LE(0.0f, level.rms);
+  ASSERT_LE(level.rms, level.peak + 1e-6f);
+  ASSERT_GE(1.0f, level.peak);
+
+  // Clean-up
+  mrsRefCountedObjectRemoveRef(audio_track1);
+  mrsRefCountedObjectRemoveRef(audio_source1);
+}
+
+TEST_P(AudioTrackTests, MixedReadBuffer) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteAudioTrackHandle audio_track2{};
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&audio_track2,
+       &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+        audio_track2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Stream audio from #1 to #2
+  mrsTransceiverHandle audio_transceiver1{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &audio_transceiver1));
+  mrsLocalAudioDeviceInitConfig device_config{};
+  mrsDeviceAudioTrackSourceHandle audio_source1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &audio_source1));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "test_audio_track";
+  mrsLocalAudioTrackHandle audio_track1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, audio_source1,
+                                               &audio_track1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver1, audio_track1));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, audio_track2);
+
+  mrsMixedAudioReadBufferHandle mix{};
+  ASSERT_EQ(Result::kSuccess, mrsMixedAudioReadBufferCreate(&mix));
+  ASSERT_NE(nullptr, mix);
+  ASSERT_EQ(Result::kSuccess,
+            mrsMixedAudioReadBufferAddTrack(mix, audio_track2, 0.5f));
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsMixedAudioReadBufferAddTrack(mix, audio_track2, 0.5f));
+  ASSERT_EQ(Result::kSuccess,
+            mrsMixedAudioReadBufferSetTrackGain(mix, audio_track2, 1.0f));
+
+  // Reads always fill the whole output, padding with silence
+  float samples[480 * 2];
+  mrsBool has_overrun;
+  for (int i = 0; i < 20; ++i) {
+    std::fill(std::begin(samples), std::end(samples), 42.0f);
+    ASSERT_EQ(Result::kSuccess,
+              mrsMixedAudioReadBufferRead(mix, 48000, 2, samples, 480 * 2,
+                                          &has_overrun));
+    for (float sample : samples) {
+      ASSERT_GE(1.0f, std::fabs(sample));
+    }
+    Event ev;
+    ev.WaitFor(10ms);
+  }
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsMixedAudioReadBufferRemoveTrack(mix, audio_track2));
+  ASSERT_EQ(Result::kNotFound,
+            mrsMixedAudioReadBufferRemoveTrack(mix, audio_track2));
+  ASSERT_EQ(Result::kNotFound,
+            mrsMixedAudioReadBufferSetTrackGain(mix, audio_track2, 1.0f));
+
+  // Read buffers reject unknown resampling qualities
+  mrsAudioTrackReadBufferOptions options{};
+  options.resampling_quality = (mrsAudioResamplingQuality)42;
+  mrsAudioTrackReadBufferHandle read_buffer{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackCreateReadBufferWithOptions(
+                audio_track2, &options, &read_buffer));
+  ASSERT_EQ(nullptr, read_buffer);
+  options.resampling_quality = mrsAudioResamplingQuality::kFast;
+  ASSERT_EQ(Result::kSuccess, mrsRemoteAudioTrackCreateReadBufferWithOptions(
+                                  audio_track2, &options, &read_buffer));
+  ASSERT_NE(nullptr, read_buffer);
+
+  // Track gains apply to read buffers, and muting ramps down to silence
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteAudioTrackSetGain(nullptr, 1.0f, 0.0f));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackSetGain(audio_track2, -1.0f, 0.0f));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackSetGain(audio_track2, 1.0f, 1.5f));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackSetGain(audio_track2, std::nanf(""), 0.0f));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetGain(audio_track2, 0.5f, -0.5f));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetMuted(audio_track2, mrsBool::kTrue));
+  for (int i = 0; i < 10; ++i) {
+    int num_samples_read = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsAudioTrackReadBufferRead(
+                  read_buffer, 48000, 2,
+                  mrsAudioTrackReadBufferPadBehavior::kPadWithZero, samples,
+                  480 * 2, &num_samples_read, &has_overrun));
+    // Skip the ramp, and the audio buffered before muting
+    if (i >= 5) {
+      for (float sample : samples) {
+        ASSERT_EQ(0.0f, sample);
+      }
+    }
+    Event ev;
+    ev.WaitFor(10ms);
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetMuted(audio_track2, mrsBool::kFalse));
+  mrsAudioTrackReadBufferDestroy(read_buffer);
+
+  // Clean-up
+  mrsMixedAudioReadBufferDestroy(mix);
+  mrsRefCountedObjectRemoveRef(audio_track1);
+  mrsRefCountedObjectRemoveRef(audio_source1);
+}
+
 TEST_P(AudioTrackTests, Muted) {
   mrsPeerConnectionConfiguration pc_config{};
   pc_config.sdp_semantic = GetParam();
@@ -393,4 +694,900 @@ TEST_P(AudioTrackTests, Muted) {
   mrsRefCountedObjectRemoveRef(audio_source1);
 }
 
+namespace {
+
+/// Model of the native gain ramp of a read buffer, computing the gains
+/// expected for each frame it converts.
+struct GainRampModel {
+  float current[2]{1.0f, 1.0f};
+  float target[2]{1.0f, 1.0f};
+  float step[2]{0.0f, 0.0f};
+  int remaining_frames = 0;
+
+  void SetTarget(float left, float right, int sample_rate) {
+    if ((left == target[0]) && (right == target[1])) {
+      return;
+    }
+    target[0] = left;
+    target[1] = right;
+    remaining_frames = sample_rate * 20 / 1000;
+    for (int c = 0; c < 2; ++c) {
+      step[c] = (target[c] - current[c]) / (float)remaining_frames;
+    }
+  }
+
+  /// Gain of channel |c| for frame |i| of the next block.
+  float GainAt(int c, int i) const {
+    return (i < remaining_frames ? current[c] + step[c] * (float)i
+                                 : target[c]);
+  }
+
+  /// Advance the ramp past a block of |frame_count| frames.
+  void Advance(int frame_count) {
+    if (frame_count >= remaining_frames) {
+      current[0] = target[0];
+      current[1] = target[1];
+      remaining_frames = 0;
+    } else {
+      current[0] += step[0] * (float)frame_count;
+      current[1] += step[1] * (float)frame_count;
+      remaining_frames -= frame_count;
+    }
+  }
+};
+
+int16_t ScaleSample(int16_t sample, float gain) {
+  const long value = std::lround((float)sample * gain);
+  return (int16_t)std::min(32767L, std::max(-32768L, value));
+}
+
+}  // namespace
+
+TEST_P(AudioTrackTests, ReadBufferGainAndPan) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteAudioTrackHandle audio_track2{};
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&audio_track2,
+       &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+        audio_track2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Stream a 440 Hz tone from #1 to #2
+  mrsTransceiverHandle audio_transceiver1{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &audio_transceiver1));
+  mrsExternalAudioTrackSourceSettings source_settings{};
+  source_settings.buffer_ms = 1000;
+  mrsExternalAudioTrackSourceHandle audio_source1{};
+  ASSERT_EQ(Result::kSuccess, mrsExternalAudioTrackSourceCreate(
+                                  &source_settings, &audio_source1));
+  uint64_t tone_pos = 0;
+  std::vector<int16_t> tone(960);
+  auto push_tone = [&]() {
+    for (size_t i = 0; i < tone.size(); ++i) {
+      tone[i] = (int16_t)(8000.0 * std::sin(2.0 * 3.14159265358979 * 440.0 *
+                                            (double)(tone_pos + i) / 48000.0));
+    }
+    uint32_t frames_pushed = 0;
+    ASSERT_EQ(Result::kSuccess, mrsExternalAudioTrackSourcePushAudio(
+                                    audio_source1, tone.data(),
+                                    (uint32_t)tone.size(), &frames_pushed));
+    tone_pos += frames_pushed;
+  };
+  for (int i = 0; i < 50; ++i) {
+    push_tone();
+  }
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "test_audio_track";
+  mrsLocalAudioTrackHandle audio_track1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, audio_source1,
+                                               &audio_track1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver1, audio_track1));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, audio_track2);
+
+  // Frame callbacks receive the audio unchanged, which is the reference the
+  // output of the read buffer is checked against. Register it before creating
+  // the read buffer, so that it receives all the frames of the read buffer.
+  std::mutex frames_mutex;
+  std::vector<std::vector<int16_t>> frames;
+  int frame_rate = 0;
+  int frame_channels = 0;
+  AudioFrameCallback audio2_cb = [&](const AudioFrame& frame) {
+    ASSERT_EQ(16u, frame.bits_per_sample_);
+    const int16_t* const data = (const int16_t*)frame.data_;
+    std::lock_guard<std::mutex> lock(frames_mutex);
+    frame_rate = (int)frame.sampling_rate_hz_;
+    frame_channels = (int)frame.channel_count_;
+    frames.emplace_back(data,
+                        data + frame.sample_count_ * frame.channel_count_);
+  };
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(audio2_cb));
+  for (int i = 0; i < 100; ++i) {
+    {
+      std::lock_guard<std::mutex> lock(frames_mutex);
+      if (!frames.empty()) {
+        break;
+      }
+    }
+    push_tone();
+    Event ev;
+    ev.WaitFor(10ms);
+  }
+  int sample_rate = 0;
+  int src_channels = 0;
+  {
+    std::lock_guard<std::mutex> lock(frames_mutex);
+    ASSERT_FALSE(frames.empty());
+    sample_rate = frame_rate;
+    src_channels = frame_channels;
+  }
+  ASSERT_TRUE((src_channels == 1) || (src_channels == 2));
+
+  // Read stereo 10 ms blocks at the rate of the track, so that each read
+  // converts exactly one frame, without resampling, with the gains set before
+  // the read.
+  mrsAudioTrackReadBufferHandle read_buffer{};
+  ASSERT_EQ(Result::kSuccess, mrsRemoteAudioTrackCreateReadBufferWithOptions(
+                                  audio_track2, nullptr, &read_buffer));
+  const int frame_count = sample_rate / 100;
+  struct Block {
+    std::vector<int16_t> samples;
+    float target[2];
+    // Last block read with these gains, by which the ramp has ended.
+    bool settled;
+  };
+  std::vector<Block> blocks;
+  struct GainSetting {
+    float gain;
+    float pan;
+    bool muted;
+    // Expected gains of the left and right channels
+    float left;
+    float right;
+  };
+  const GainSetting settings[] = {{1.0f, 0.0f, false, 1.0f, 1.0f},
+                                  {0.5f, 0.0f, false, 0.5f, 0.5f},
+                                  {1.0f, -1.0f, false, 1.0f, 0.0f},
+                                  {0.8f, 0.5f, false, 0.4f, 0.8f},
+                                  {1.5f, -0.25f, false, 1.5f, 1.125f},
+                                  {1.5f, -0.25f, true, 0.0f, 0.0f}};
+  // 40 ms per setting, longer than the ramp.
+  constexpr int kBlocksPerSetting = 4;
+  mrsAudioTrackReadBufferOutputFormat format{};
+  format.sample_type = mrsAudioTrackReadBufferSampleType::kInt16;
+  for (const GainSetting& setting : settings) {
+    ASSERT_EQ(Result::kSuccess, mrsRemoteAudioTrackSetGain(
+                                    audio_track2, setting.gain, setting.pan));
+    ASSERT_EQ(Result::kSuccess,
+              mrsRemoteAudioTrackSetMuted(
+                  audio_track2,
+                  setting.muted ? mrsBool::kTrue : mrsBool::kFalse));
+    int block_count = 0;
+    for (int i = 0; (i < 200) && (block_count < kBlocksPerSetting); ++i) {
+      push_tone();
+      Block block{std::vector<int16_t>((size_t)frame_count * 2),
+                  {setting.left, setting.right},
+                  block_count == kBlocksPerSetting - 1};
+      int num_samples_read = 0;
+      mrsBool has_overrun = mrsBool::kFalse;
+      ASSERT_EQ(Result::kSuccess,
+                mrsAudioTrackReadBufferReadWithFormat(
+                    read_buffer, sample_rate, 2,
+                    mrsAudioTrackReadBufferPadBehavior::kPadWithZero, &format,
+                    block.samples.data(), frame_count * 2, &num_samples_read,
+                    &has_overrun));
+      ASSERT_EQ(mrsBool::kFalse, has_overrun);
+      if (num_samples_read == 0) {
+        Event ev;
+        ev.WaitFor(5ms);
+        continue;
+      }
+      ASSERT_EQ(frame_count * 2, num_samples_read);
+      blocks.push_back(std::move(block));
+      ++block_count;
+    }
+    ASSERT_EQ(kBlocksPerSetting, block_count);
+  }
+  mrsAudioTrackReadBufferDestroy(read_buffer);
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetMuted(audio_track2, mrsBool::kFalse));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackSetGain(audio_track2, 1.0f, 0.0f));
+
+  // The blocks read with unity gains are the frames unchanged. Locate the
+  // first one carrying the tone among the reference frames, to align both.
+  std::lock_guard<std::mutex> lock(frames_mutex);
+  auto get_source = [&](const std::vector<int16_t>& frame, int i, int c) {
+    return frame[(size_t)i * src_channels + (src_channels == 2 ? c : 0)];
+  };
+  size_t offset = frames.size();
+  for (size_t j = 0;
+       (j < (size_t)kBlocksPerSetting) && (offset == frames.size()); ++j) {
+    const std::vector<int16_t>& block = blocks[j].samples;
+    if (*std::max_element(block.begin(), block.end()) < 1000) {
+      continue;
+    }
+    for (size_t k = j; k < frames.size(); ++k) {
+      if (frames[k].size() != (size_t)frame_count * src_channels) {
+        continue;
+      }
+      bool match = true;
+      for (int i = 0; (i < frame_count) && match; ++i) {
+        match = (block[2 * i] == get_source(frames[k], i, 0)) &&
+                (block[2 * i + 1] == get_source(frames[k], i, 1));
+      }
+      if (match) {
+        offset = k - j;
+        break;
+      }
+    }
+  }
+  ASSERT_NE(frames.size(), offset) << "The tone was not received";
+  ASSERT_LE(offset + blocks.size(), frames.size());
+
+  // Each block is its frame scaled by the ramping gains, which reach the
+  // gains of the setting before its last block.
+  GainRampModel model;
+  for (size_t j = 0; j < blocks.size(); ++j) {
+    const Block& block = blocks[j];
+    const std::vector<int16_t>& frame = frames[offset + j];
+    model.SetTarget(block.target[0], block.target[1], sample_rate);
+    if (block.settled) {
+      ASSERT_EQ(0, model.remaining_frames);
+    }
+    for (int i = 0; i < frame_count; ++i) {
+      for (int c = 0; c < 2; ++c) {
+        const float gain =
+            (block.settled ? block.target[c] : model.GainAt(c, i));
+        const int16_t expected = ScaleSample(get_source(frame, i, c), gain);
+        ASSERT_GE(1, std::abs(expected - block.samples[2 * i + c]))
+            << "Block " << j << " frame " << i << " channel " << c;
+      }
+    }
+    model.Advance(frame_count);
+  }
+
+  // Clean-up
+  mrsRefCountedObjectRemoveRef(audio_track1);
+  mrsRefCountedObjectRemoveRef(audio_source1);
+}
+
 #endif  // MRSW_EXCLUDE_DEVICE_TESTS
+
+namespace {
+
+/// Read buffer fed by the test itself, destroyed with this object.
+class PushReadBuffer {
+ public:
+  explicit PushReadBuffer(int buffer_ms,
+                          mrsAudioResamplingQuality quality =
+                              mrsAudioResamplingQuality::kPassthrough) {
+    mrsAudioTrackReadBufferOptions options{};
+    options.buffer_ms = buffer_ms;
+    options.resampling_quality = quality;
+    EXPECT_EQ(Result::kSuccess,
+              mrsAudioTrackReadBufferCreateForPush(&options, &handle_));
+  }
+  ~PushReadBuffer() { mrsAudioTrackReadBufferDestroy(handle_); }
+  operator mrsAudioTrackReadBufferHandle() const { return handle_; }
+
+ private:
+  mrsAudioTrackReadBufferHandle handle_{};
+};
+
+/// Create |frame_count| frames of 16-bit audio where the samples of frame |k|
+/// are |k * samples_per_frame + i|, so that any sample identifies its frame.
+std::vector<int16_t> MakeRampFrame(int k, int frame_count, int channels) {
+  const int samples_per_frame = frame_count * channels;
+  std::vector<int16_t> samples((size_t)samples_per_frame);
+  for (int i = 0; i < samples_per_frame; ++i) {
+    samples[i] = (int16_t)((k * samples_per_frame + i) % 30000);
+  }
+  return samples;
+}
+
+mrsResult PushFrame(mrsAudioTrackReadBufferHandle buffer,
+                    const std::vector<int16_t>& samples,
+                    int sample_rate,
+                    int channels) {
+  mrsAudioFrame frame{};
+  frame.data_ = samples.data();
+  frame.bits_per_sample_ = 16;
+  frame.sampling_rate_hz_ = sample_rate;
+  frame.channel_count_ = channels;
+  frame.sample_count_ = (uint32_t)(samples.size() / channels);
+  return mrsAudioTrackReadBufferPushFrame(buffer, &frame);
+}
+
+/// Push frame |k| of a 48 kHz mono ramp.
+void PushRampFrame(mrsAudioTrackReadBufferHandle buffer, int k) {
+  ASSERT_EQ(Result::kSuccess,
+            PushFrame(buffer, MakeRampFrame(k, 480, 1), 48000, 1));
+}
+
+/// Result of reading interleaved 16-bit samples.
+struct ReadResult {
+  std::vector<int16_t> samples;
+  int num_samples_read = 0;
+  bool has_overrun = false;
+};
+
+ReadResult ReadS16(mrsAudioTrackReadBufferHandle buffer,
+                   int sample_rate,
+                   int channels,
+                   int num_samples) {
+  ReadResult result;
+  result.samples.resize((size_t)num_samples);
+  mrsAudioTrackReadBufferOutputFormat format{};
+  format.sample_type = mrsAudioTrackReadBufferSampleType::kInt16;
+  mrsBool has_overrun = mrsBool::kFalse;
+  EXPECT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferReadWithFormat(
+                buffer, sample_rate, channels,
+                mrsAudioTrackReadBufferPadBehavior::kPadWithZero, &format,
+                result.samples.data(), num_samples, &result.num_samples_read,
+                &has_overrun));
+  result.has_overrun = (has_overrun != mrsBool::kFalse);
+  return result;
+}
+
+mrsAudioTrackReadBufferStats GetStats(mrsAudioTrackReadBufferHandle buffer) {
+  mrsAudioTrackReadBufferStats stats{};
+  EXPECT_EQ(Result::kSuccess, mrsAudioTrackReadBufferGetStats(buffer, &stats));
+  return stats;
+}
+
+}  // namespace
+
+TEST_F(AudioTrackTests, ReadBufferPushFrame) {
+  mrsAudioTrackReadBufferOptions options{};
+  options.buffer_ms = 0;
+  mrsAudioTrackReadBufferHandle handle{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferCreateForPush(&options, &handle));
+  ASSERT_EQ(nullptr, handle);
+
+  PushReadBuffer buffer(50);
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsAudioTrackReadBufferPushFrame(nullptr, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferPushFrame(buffer, nullptr));
+  const std::vector<int16_t> samples = MakeRampFrame(0, 480, 1);
+  mrsAudioFrame frame{};
+  frame.data_ = samples.data();
+  frame.bits_per_sample_ = 24;
+  frame.sampling_rate_hz_ = 48000;
+  frame.channel_count_ = 1;
+  frame.sample_count_ = 480;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferPushFrame(buffer, &frame));
+  frame.bits_per_sample_ = 16;
+  frame.channel_count_ = 3;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferPushFrame(buffer, &frame));
+
+  // Invalid frames are rejected without being buffered
+  const ReadResult result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(0, result.num_samples_read);
+  ASSERT_EQ(0u, GetStats(buffer).overrun_count);
+}
+
+TEST_F(AudioTrackTests, ReadBufferRingWraparound) {
+  // 50 ms keeps 6 frames, so the ring wraps around every few iterations
+  PushReadBuffer buffer(50);
+  int next_pushed = 0;
+  int next_read = 0;
+  for (int i = 0; i < 40; ++i) {
+    const int count = 1 + i % 5;
+    for (int j = 0; j < count; ++j) {
+      PushRampFrame(buffer, next_pushed++);
+    }
+    const ReadResult result = ReadS16(buffer, 48000, 1, 480 * count);
+    ASSERT_EQ(480 * count, result.num_samples_read);
+    ASSERT_FALSE(result.has_overrun);
+    for (int j = 0; j < count; ++j) {
+      const std::vector<int16_t> expected = MakeRampFrame(next_read++, 480, 1);
+      ASSERT_TRUE(std::equal(expected.begin(), expected.end(),
+                             result.samples.begin() + 480 * j));
+    }
+  }
+  ASSERT_EQ(0u, GetStats(buffer).overrun_count);
+}
+
+TEST_F(AudioTrackTests, ReadBufferRingFull) {
+  PushReadBuffer buffer(50);
+  for (int k = 0; k < 8; ++k) {
+    PushRampFrame(buffer, k);
+  }
+
+  // The ring holds 6 frames, and the 2 frames pushed while full were dropped
+  // instead of the oldest ones
+  ASSERT_EQ(2u, GetStats(buffer).overrun_count);
+  ReadResult result = ReadS16(buffer, 48000, 1, 480 * 6);
+  ASSERT_EQ(480 * 6, result.num_samples_read);
+  ASSERT_TRUE(result.has_overrun);
+  for (int k = 0; k < 6; ++k) {
+    const std::vector<int16_t> expected = MakeRampFrame(k, 480, 1);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(),
+                           result.samples.begin() + 480 * k));
+  }
+  result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(0, result.num_samples_read);
+  ASSERT_FALSE(result.has_overrun);
+
+  // Frames are buffered again once the reader caught up, and the overrun is
+  // only reported once
+  PushRampFrame(buffer, 8);
+  result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(480, result.num_samples_read);
+  ASSERT_FALSE(result.has_overrun);
+  ASSERT_EQ(MakeRampFrame(8, 480, 1), result.samples);
+  ASSERT_EQ(2u, GetStats(buffer).overrun_count);
+}
+
+TEST_F(AudioTrackTests, ReadBufferOversizedFrame) {
+  PushReadBuffer buffer(50);
+
+  // 30 ms of 48 kHz stereo exceeds the size of a ring slot, and is dropped
+  ASSERT_EQ(Result::kSuccess,
+            PushFrame(buffer, MakeRampFrame(0, 1440, 2), 48000, 2));
+  ASSERT_EQ(1u, GetStats(buffer).overrun_count);
+  ReadResult result = ReadS16(buffer, 48000, 2, 960);
+  ASSERT_EQ(0, result.num_samples_read);
+  ASSERT_TRUE(result.has_overrun);
+
+  // 10 ms of 96 kHz stereo is the largest frame a slot holds
+  const std::vector<int16_t> largest = MakeRampFrame(1, 960, 2);
+  ASSERT_EQ(Result::kSuccess, PushFrame(buffer, largest, 96000, 2));
+  ASSERT_EQ(1u, GetStats(buffer).overrun_count);
+  result = ReadS16(buffer, 96000, 2, 1920);
+  ASSERT_EQ(1920, result.num_samples_read);
+  ASSERT_EQ(largest, result.samples);
+}
+
+TEST_F(AudioTrackTests, ReadBufferStats) {
+  PushReadBuffer buffer(50);
+  mrsAudioTrackReadBufferStats stats = GetStats(buffer);
+  ASSERT_EQ(0, stats.latency_ms);
+  ASSERT_EQ(0, stats.min_fill_ms);
+  ASSERT_EQ(0, stats.max_fill_ms);
+  ASSERT_EQ(0u, stats.underrun_count);
+  ASSERT_EQ(0u, stats.overrun_count);
+
+  // The fill level is measured at the start of each read, and includes the
+  // samples of a partially read frame
+  for (int k = 0; k < 3; ++k) {
+    PushRampFrame(buffer, k);
+  }
+  ASSERT_EQ(480, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(240, ReadS16(buffer, 48000, 1, 240).num_samples_read);
+  ASSERT_EQ(240, ReadS16(buffer, 48000, 1, 240).num_samples_read);
+  stats = GetStats(buffer);
+  ASSERT_EQ(15, stats.latency_ms);
+  ASSERT_EQ(15, stats.min_fill_ms);
+  ASSERT_EQ(30, stats.max_fill_ms);
+  ASSERT_EQ(0u, stats.underrun_count);
+
+  // Without any read since the previous call, the range is the last latency
+  stats = GetStats(buffer);
+  ASSERT_EQ(15, stats.min_fill_ms);
+  ASSERT_EQ(15, stats.max_fill_ms);
+
+  // Running empty counts one underrun, however many reads find no data
+  ASSERT_EQ(480, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  stats = GetStats(buffer);
+  ASSERT_EQ(0, stats.latency_ms);
+  ASSERT_EQ(0, stats.min_fill_ms);
+  ASSERT_EQ(10, stats.max_fill_ms);
+  ASSERT_EQ(1u, stats.underrun_count);
+
+  // A complete read ends the underrun, so the next one counts again
+  PushRampFrame(buffer, 3);
+  ASSERT_EQ(480, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(2u, GetStats(buffer).underrun_count);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsAudioTrackReadBufferGetStats(nullptr, &stats));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferGetStats(buffer, nullptr));
+}
+
+TEST_F(AudioTrackTests, ReadBufferLatencyWindow) {
+  // 200 ms of capacity
+  PushReadBuffer buffer(200);
+  mrsAudioTrackReadBufferLatencyWindow window{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsAudioTrackReadBufferSetLatencyWindow(nullptr, &window));
+  window.min_latency_ms = -10;
+  window.max_latency_ms = 100;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  window.min_latency_ms = 100;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  window.min_latency_ms = 40;
+  window.max_latency_ms = 210;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  window.max_latency_ms = 200;
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, nullptr));
+}
+
+TEST_F(AudioTrackTests, ReadBufferAdaptiveRebuffering) {
+  PushReadBuffer buffer(200);
+  mrsAudioTrackReadBufferLatencyWindow window{};
+  window.min_latency_ms = 40;
+  window.max_latency_ms = 120;
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+
+  // Reading starts only once the minimum latency is buffered, padding until
+  // then without consuming any frame
+  PushRampFrame(buffer, 0);
+  PushRampFrame(buffer, 1);
+  ReadResult result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(0, result.num_samples_read);
+  ASSERT_EQ(std::vector<int16_t>(480, 0), result.samples);
+  PushRampFrame(buffer, 2);
+  PushRampFrame(buffer, 3);
+  result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(480, result.num_samples_read);
+  ASSERT_EQ(MakeRampFrame(0, 480, 1), result.samples);
+
+  // Once started, reading continues below the minimum until an underrun
+  for (int k = 1; k < 4; ++k) {
+    result = ReadS16(buffer, 48000, 1, 480);
+    ASSERT_EQ(480, result.num_samples_read);
+    ASSERT_EQ(MakeRampFrame(k, 480, 1), result.samples);
+  }
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(1u, GetStats(buffer).underrun_count);
+
+  // After the underrun the buffer fills up to the minimum latency again
+  // before resuming, where it left off
+  for (int k = 4; k < 7; ++k) {
+    PushRampFrame(buffer, k);
+  }
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(30, GetStats(buffer).latency_ms);
+  PushRampFrame(buffer, 7);
+  result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(480, result.num_samples_read);
+  ASSERT_EQ(MakeRampFrame(4, 480, 1), result.samples);
+  ASSERT_EQ(1u, GetStats(buffer).underrun_count);
+
+  // Disabling the adaptive mode reads any available frame immediately
+  for (int k = 5; k < 8; ++k) {
+    ASSERT_EQ(480, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  }
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, nullptr));
+  PushRampFrame(buffer, 8);
+  result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(480, result.num_samples_read);
+  ASSERT_EQ(MakeRampFrame(8, 480, 1), result.samples);
+
+  // Enabling it again waits for the minimum latency first
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  PushRampFrame(buffer, 9);
+  ASSERT_EQ(0, ReadS16(buffer, 48000, 1, 480).num_samples_read);
+}
+
+TEST_F(AudioTrackTests, ReadBufferDriftCorrection) {
+  // The fast resampler turns each 10 ms frame into exactly 478, 480 or 482
+  // samples when speeding up, keeping or slowing down the pace of 48 kHz
+  // audio by 200 Hz, so the frames consumed by a read are known exactly.
+  PushReadBuffer buffer(500, mrsAudioResamplingQuality::kFast);
+  mrsAudioTrackReadBufferLatencyWindow window{};
+  window.min_latency_ms = 40;
+  window.max_latency_ms = 120;
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferSetLatencyWindow(buffer, &window));
+  for (int k = 0; k < 20; ++k) {
+    PushRampFrame(buffer, k);
+  }
+
+  // Above the window, playback speeds up until back to its middle, 80 ms
+  ASSERT_EQ(478 * 8, ReadS16(buffer, 48000, 1, 478 * 8).num_samples_read);
+  ASSERT_EQ(478 * 4, ReadS16(buffer, 48000, 1, 478 * 4).num_samples_read);
+  mrsAudioTrackReadBufferStats stats = GetStats(buffer);
+  ASSERT_EQ(120, stats.latency_ms);
+  ASSERT_EQ(120, stats.min_fill_ms);
+  ASSERT_EQ(200, stats.max_fill_ms);
+
+  // Within the window frames play unchanged, down to the minimum
+  for (int k = 12; k < 17; ++k) {
+    const ReadResult result = ReadS16(buffer, 48000, 1, 480);
+    ASSERT_EQ(MakeRampFrame(k, 480, 1), result.samples);
+  }
+
+  // Below the window, playback slows down until back to the middle
+  ASSERT_EQ(482 * 2, ReadS16(buffer, 48000, 1, 482 * 2).num_samples_read);
+  for (int k = 20; k < 26; ++k) {
+    PushRampFrame(buffer, k);
+  }
+  ASSERT_EQ(482, ReadS16(buffer, 48000, 1, 482).num_samples_read);
+  PushRampFrame(buffer, 26);
+  PushRampFrame(buffer, 27);
+  const ReadResult result = ReadS16(buffer, 48000, 1, 480);
+  ASSERT_EQ(MakeRampFrame(20, 480, 1), result.samples);
+  stats = GetStats(buffer);
+  ASSERT_EQ(80, stats.latency_ms);
+  ASSERT_EQ(30, stats.min_fill_ms);
+  ASSERT_EQ(80, stats.max_fill_ms);
+  ASSERT_EQ(0u, stats.underrun_count);
+}
+
+namespace {
+
+/// Create frame |k| of a 1 kHz tone at 48 kHz, whose samples all differ from
+/// a linear interpolation of their neighbors.
+std::vector<int16_t> MakeToneFrame(int k) {
+  std::vector<int16_t> samples(480);
+  for (int i = 0; i < 480; ++i) {
+    const double t = (double)(k * 480 + i) / 48000.0;
+    samples[i] = (int16_t)std::lround(
+        10000.0 * std::sin(2.0 * 3.14159265358979 * 1000.0 * t));
+  }
+  return samples;
+}
+
+}  // namespace
+
+TEST_F(AudioTrackTests, ReadBufferResamplingFast) {
+  PushReadBuffer buffer(500, mrsAudioResamplingQuality::kFast);
+  // The resampler interpolates linearly the stream preceded by a copy of its
+  // first sample, which it starts from.
+  std::vector<int16_t> input;
+  for (int k = 0; k < 10; ++k) {
+    const std::vector<int16_t> frame = MakeToneFrame(k);
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+    input.insert(input.end(), frame.begin(), frame.end());
+  }
+  input.insert(input.begin(), input.front());
+
+  // Each 48 kHz frame of 480 samples makes exactly 441 samples at 44.1 kHz
+  std::vector<int16_t> output;
+  for (int k = 0; k < 10; ++k) {
+    const ReadResult result = ReadS16(buffer, 44100, 1, 441);
+    ASSERT_EQ(441, result.num_samples_read);
+    output.insert(output.end(), result.samples.begin(), result.samples.end());
+  }
+  for (int n = 0; n < 4410; ++n) {
+    const int64_t position = (int64_t)n * 48000;
+    const size_t index = (size_t)(position / 44100);
+    const int64_t frac = position % 44100;
+    const int a = input[index];
+    const int b = input[index + 1];
+    ASSERT_EQ((int16_t)(a + (b - a) * frac / 44100), output[n])
+        << "Sample " << n;
+  }
+}
+
+TEST_F(AudioTrackTests, ReadBufferResamplingPassthrough) {
+  // Frames keep their rate, whatever the rate read
+  PushReadBuffer buffer(500, mrsAudioResamplingQuality::kPassthrough);
+  std::vector<int16_t> input;
+  for (int k = 0; k < 3; ++k) {
+    const std::vector<int16_t> frame = MakeToneFrame(k);
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+    input.insert(input.end(), frame.begin(), frame.end());
+  }
+  const ReadResult result = ReadS16(buffer, 44100, 1, 480 * 3);
+  ASSERT_EQ(480 * 3, result.num_samples_read);
+  ASSERT_EQ(input, result.samples);
+}
+
+TEST_F(AudioTrackTests, ReadBufferResamplingHigh) {
+  // The filtered resampler converts 48 kHz frames of a constant signal to
+  // 16 kHz frames of the same constant, once past the delay of its filter
+  PushReadBuffer buffer(500, mrsAudioResamplingQuality::kHigh);
+  const std::vector<int16_t> frame(480, 10000);
+  for (int k = 0; k < 10; ++k) {
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+  }
+  const ReadResult result = ReadS16(buffer, 16000, 1, 160 * 10);
+  ASSERT_EQ(160 * 10, result.num_samples_read);
+  for (int n = 160; n < 160 * 10; ++n) {
+    ASSERT_NEAR(10000, result.samples[n], 200) << "Sample " << n;
+  }
+
+  // A 1 kHz tone keeps its amplitude, well below the cutoff of the filter
+  PushReadBuffer tone_buffer(500, mrsAudioResamplingQuality::kHigh);
+  for (int k = 0; k < 10; ++k) {
+    ASSERT_EQ(Result::kSuccess,
+              PushFrame(tone_buffer, MakeToneFrame(k), 48000, 1));
+  }
+  const ReadResult tone = ReadS16(tone_buffer, 16000, 1, 160 * 10);
+  ASSERT_EQ(160 * 10, tone.num_samples_read);
+  const auto range = std::minmax_element(tone.samples.begin() + 160,
+                                         tone.samples.end());
+  ASSERT_NEAR(-10000, *range.first, 300);
+  ASSERT_NEAR(10000, *range.second, 300);
+}
+
+namespace {
+
+/// Read 48 kHz samples of type |T| with the given layout, filling the output
+/// with |kSentinel| beforehand to detect which samples are written.
+template <typename T>
+std::vector<T> ReadFormat(mrsAudioTrackReadBufferHandle buffer,
+                          int channels,
+                          mrsAudioTrackReadBufferPadBehavior pad_behavior,
+                          bool interleaved,
+                          int num_samples,
+                          int* num_samples_read) {
+  mrsAudioTrackReadBufferOutputFormat format{};
+  format.sample_type = (std::is_same<T, float>::value
+                            ? mrsAudioTrackReadBufferSampleType::kFloat32
+                            : mrsAudioTrackReadBufferSampleType::kInt16);
+  format.interleaved = (interleaved ? mrsBool::kTrue : mrsBool::kFalse);
+  std::vector<T> samples((size_t)num_samples, (T)77);
+  mrsBool has_overrun = mrsBool::kFalse;
+  EXPECT_EQ(Result::kSuccess,
+            mrsAudioTrackReadBufferReadWithFormat(
+                buffer, 48000, channels, pad_behavior, &format,
+                samples.data(), num_samples, num_samples_read, &has_overrun));
+  return samples;
+}
+
+/// Check that |samples| are a sine padding, whose amplitude is 15% of the
+/// full scale of the sample type.
+template <typename T>
+void ExpectSinePadding(const T* samples, size_t count) {
+  const float max_value =
+      (std::is_same<T, float>::value ? 0.15f : 0.15f * 32767.0f + 0.5f);
+  bool any_non_zero = false;
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_LE(std::abs((float)samples[i]), max_value);
+    any_non_zero |= (samples[i] != 0);
+  }
+  ASSERT_TRUE(any_non_zero);
+}
+
+}  // namespace
+
+TEST_F(AudioTrackTests, ReadBufferFormatS16Interleaved) {
+  using Pad = mrsAudioTrackReadBufferPadBehavior;
+  PushReadBuffer buffer(50);
+  const std::vector<int16_t> frame = MakeRampFrame(0, 480, 2);
+  for (Pad pad : {Pad::kDoNotPad, Pad::kPadWithZero, Pad::kPadWithSine}) {
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 2));
+    int num_read = 0;
+    const std::vector<int16_t> samples =
+        ReadFormat<int16_t>(buffer, 2, pad, true, 1200, &num_read);
+    ASSERT_EQ(960, num_read);
+    ASSERT_TRUE(std::equal(frame.begin(), frame.end(), samples.begin()));
+    switch (pad) {
+      case Pad::kDoNotPad:
+        ASSERT_EQ(std::vector<int16_t>(240, 77),
+                  std::vector<int16_t>(samples.begin() + 960, samples.end()));
+        break;
+      case Pad::kPadWithZero:
+        ASSERT_EQ(std::vector<int16_t>(240, 0),
+                  std::vector<int16_t>(samples.begin() + 960, samples.end()));
+        break;
+      case Pad::kPadWithSine:
+        ExpectSinePadding(samples.data() + 960, 240);
+        break;
+    }
+  }
+}
+
+TEST_F(AudioTrackTests, ReadBufferFormatF32Planar) {
+  using Pad = mrsAudioTrackReadBufferPadBehavior;
+  PushReadBuffer buffer(50);
+  const std::vector<int16_t> frame = MakeRampFrame(0, 480, 2);
+
+  // Planar output needs whole frames
+  int num_read = 0;
+  mrsAudioTrackReadBufferOutputFormat format{};
+  format.interleaved = mrsBool::kFalse;
+  std::vector<float> samples(1199);
+  mrsBool has_overrun = mrsBool::kFalse;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackReadBufferReadWithFormat(
+                buffer, 48000, 2, Pad::kPadWithZero, &format, samples.data(),
+                1199, &num_read, &has_overrun));
+
+  // Each plane holds 600 samples, the 480 read followed by the padding
+  for (Pad pad : {Pad::kDoNotPad, Pad::kPadWithZero, Pad::kPadWithSine}) {
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 2));
+    samples = ReadFormat<float>(buffer, 2, pad, false, 1200, &num_read);
+    ASSERT_EQ(960, num_read);
+    for (int c = 0; c < 2; ++c) {
+      const float* plane = samples.data() + 600 * c;
+      for (int i = 0; i < 480; ++i) {
+        ASSERT_EQ((float)frame[2 * i + c] / 32768.0f, plane[i]);
+      }
+      switch (pad) {
+        case Pad::kDoNotPad:
+          ASSERT_EQ(std::vector<float>(120, 77.0f),
+                    std::vector<float>(plane + 480, plane + 600));
+          break;
+        case Pad::kPadWithZero:
+          ASSERT_EQ(std::vector<float>(120, 0.0f),
+                    std::vector<float>(plane + 480, plane + 600));
+          break;
+        case Pad::kPadWithSine:
+          ExpectSinePadding(plane + 480, 120);
+          break;
+      }
+    }
+  }
+}
+
+TEST_F(AudioTrackTests, ReadBufferFormatMonoToStereoPlanar) {
+  using Pad = mrsAudioTrackReadBufferPadBehavior;
+  PushReadBuffer buffer(50);
+  const std::vector<int16_t> frame = MakeRampFrame(0, 480, 1);
+
+  // Both planes hold a copy of the mono channel
+  for (Pad pad : {Pad::kDoNotPad, Pad::kPadWithZero, Pad::kPadWithSine}) {
+    ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+    int num_read = 0;
+    const std::vector<int16_t> samples =
+        ReadFormat<int16_t>(buffer, 2, pad, false, 1200, &num_read);
+    ASSERT_EQ(960, num_read);
+    for (int c = 0; c < 2; ++c) {
+      const int16_t* plane = samples.data() + 600 * c;
+      ASSERT_TRUE(std::equal(frame.begin(), frame.end(), plane));
+      switch (pad) {
+        case Pad::kDoNotPad:
+          ASSERT_EQ(std::vector<int16_t>(120, 77),
+                    std::vector<int16_t>(plane + 480, plane + 600));
+          break;
+        case Pad::kPadWithZero:
+          ASSERT_EQ(std::vector<int16_t>(120, 0),
+                    std::vector<int16_t>(plane + 480, plane + 600));
+          break;
+        case Pad::kPadWithSine:
+          ExpectSinePadding(plane + 480, 120);
+          break;
+      }
+    }
+  }
+
+  // Same in floating point, planar and interleaved
+  ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+  int num_read = 0;
+  std::vector<float> samples =
+      ReadFormat<float>(buffer, 2, Pad::kPadWithZero, false, 960, &num_read);
+  ASSERT_EQ(960, num_read);
+  for (int i = 0; i < 480; ++i) {
+    ASSERT_EQ((float)frame[i] / 32768.0f, samples[i]);
+    ASSERT_EQ(samples[i], samples[480 + i]);
+  }
+  ASSERT_EQ(Result::kSuccess, PushFrame(buffer, frame, 48000, 1));
+  samples =
+      ReadFormat<float>(buffer, 2, Pad::kPadWithZero, true, 960, &num_read);
+  ASSERT_EQ(960, num_read);
+  for (int i = 0; i < 480; ++i) {
+    ASSERT_EQ((float)frame[i] / 32768.0f, samples[2 * i]);
+    ASSERT_EQ(samples[2 * i], samples[2 * i + 1]);
+  }
+}
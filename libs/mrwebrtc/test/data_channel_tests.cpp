@@ -3,6 +3,9 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <thread>
+
 #include "data_channel_interop.h"
 #include "interop_api.h"
 
@@ -380,6 +383,1096 @@ TEST_F(DataChannelTests, Send_InvalidHandle) {
   const uint64_t size = sizeof(msg);
   ASSERT_EQ(Result::kInvalidNativeHandle,
             mrsDataChannelSendMessage(nullptr, msg, size));
+
+  // The buffer is released even on error
+  mrsDataChannelMessageBufferHandle buffer{};
+  void* data{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelMessageBufferCreate(size, &buffer, &data));
+  ASSERT_NE(nullptr, buffer);
+  ASSERT_NE(nullptr, data);
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSendMessageBuffer(nullptr, buffer, size));
+}
+
+TEST_P(DataChannelTests, SendMessageBuffer) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  const char msg_data[] = "test message";
+  const uint64_t msg_size = sizeof(msg_data);
+
+  Event ev_msg, ev_state1, ev_state2;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_EQ(msg_size, size);
+        ASSERT_NE(nullptr, data);
+        ASSERT_EQ(0, memcmp(data, msg_data, msg_size));
+        ev_msg.Set();
+      });
+  std::function<void(mrsDataChannelState, int32_t)> state1_cb(
+      [&](mrsDataChannelState state, int32_t /*id*/) {
+        if (state == mrsDataChannelState::kOpen) {
+          ev_state1.Set();
+        }
+      });
+  std::function<void(mrsDataChannelState, int32_t)> state2_cb(
+      [&](mrsDataChannelState state, int32_t /*id*/) {
+        if (state == mrsDataChannelState::kOpen) {
+          ev_state2.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks1{};
+  callbacks1.state_callback = &StaticStateCallback;
+  callbacks1.state_user_data = &state1_cb;
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+  callbacks2.state_callback = &StaticStateCallback;
+  callbacks2.state_user_data = &state2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelRegisterCallbacks(handle1, &callbacks1);
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_state1.WaitFor(60s));
+  ASSERT_TRUE(ev_state2.WaitFor(60s));
+
+  // Build the message in place, in a buffer larger than needed
+  mrsDataChannelMessageBufferHandle buffer{};
+  void* data{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelMessageBufferCreate(256, &buffer, &data));
+  memcpy(data, msg_data, msg_size);
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessageBuffer(handle1, buffer, msg_size));
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  // Sizes past the capacity are rejected
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelMessageBufferCreate(4, &buffer, &data));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendMessageBuffer(handle1, buffer, 5));
+
+  // Unsent buffers can be destroyed
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelMessageBufferCreate(4, &buffer, &data));
+  mrsDataChannelMessageBufferDestroy(buffer);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, SendMessages) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  const char* const msg_data[] = {"first", "second message", "third"};
+  constexpr int kMessageCount = 3;
+
+  Event ev_msg, ev_state1, ev_state2;
+  int received_count = 0;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        // Reliable ordered channel; messages arrive in order
+        ASSERT_GT(kMessageCount, received_count);
+        const char* const expected = msg_data[received_count];
+        ASSERT_EQ(strlen(expected), size);
+        ASSERT_EQ(0, memcmp(data, expected, size));
+        if (++received_count == kMessageCount) {
+          ev_msg.Set();
+        }
+      });
+  std::function<void(mrsDataChannelState, int32_t)> state1_cb(
+      [&](mrsDataChannelState state, int32_t /*id*/) {
+        if (state == mrsDataChannelState::kOpen) {
+          ev_state1.Set();
+        }
+      });
+  std::function<void(mrsDataChannelState, int32_t)> state2_cb(
+      [&](mrsDataChannelState state, int32_t /*id*/) {
+        if (state == mrsDataChannelState::kOpen) {
+          ev_state2.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks1{};
+  callbacks1.state_callback = &StaticStateCallback;
+  callbacks1.state_user_data = &state1_cb;
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+  callbacks2.state_callback = &StaticStateCallback;
+  callbacks2.state_user_data = &state2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelRegisterCallbacks(handle1, &callbacks1);
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_state1.WaitFor(60s));
+  ASSERT_TRUE(ev_state2.WaitFor(60s));
+
+  mrsDataChannelMessage messages[kMessageCount];
+  for (int i = 0; i < kMessageCount; ++i) {
+    messages[i].data = msg_data[i];
+    messages[i].size = strlen(msg_data[i]);
+  }
+  int32_t num_accepted = -1;
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSendMessages(nullptr, messages, kMessageCount,
+                                       nullptr, &num_accepted));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendMessages(handle1, nullptr, kMessageCount,
+                                       nullptr, &num_accepted));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendMessages(handle1, messages, kMessageCount,
+                                       nullptr, nullptr));
+
+  mrsBool accepted[kMessageCount]{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessages(handle1, messages, kMessageCount,
+                                       accepted, &num_accepted));
+  ASSERT_EQ(kMessageCount, num_accepted);
+  for (mrsBool message_accepted : accepted) {
+    ASSERT_EQ(mrsBool::kTrue, message_accepted);
+  }
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, SendQueue) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  const char* const msg_data[] = {"first", "second message", "third"};
+  constexpr int kMessageCount = 3;
+
+  Event ev_msg;
+  int received_count = 0;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_GT(kMessageCount, received_count);
+        const char* const expected = msg_data[received_count];
+        ASSERT_EQ(strlen(expected), size);
+        ASSERT_EQ(0, memcmp(data, expected, size));
+        if (++received_count == kMessageCount) {
+          ev_msg.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+
+  // The send queue is disabled by default
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelQueueMessage(handle1, msg_data[0], 1));
+
+  // Invalid watermarks
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.low_watermark = queue_config.high_watermark;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetSendQueue(handle1, &queue_config));
+  queue_config.low_watermark = 1024;
+  queue_config.high_watermark = 0x2000000;  // 32 MB
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetSendQueue(handle1, &queue_config));
+
+  // Messages queued before the channel opens are sent once it does
+  queue_config = mrsDataChannelSendQueueConfig{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetSendQueue(handle1, &queue_config));
+  for (int i = 0; i < kMessageCount; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelQueueMessage(handle1, msg_data[i],
+                                         strlen(msg_data[i])));
+  }
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetSendQueue(handle1, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, Priority) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr int kBulkMessageCount = 32;
+  constexpr size_t kBulkMessageSize = 64 * 1024;
+  Event ev_bulk;
+  std::atomic<int> bulk_count{0};
+  std::function<void(const void*, const uint64_t)> bulk2_cb(
+      [&](const void* /*data*/, const uint64_t size) {
+        ASSERT_EQ(kBulkMessageSize, size);
+        if (++bulk_count == kBulkMessageCount) {
+          ev_bulk.Set();
+        }
+      });
+  Event ev_input;
+  std::function<void(const void*, const uint64_t)> input2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_EQ(5u, size);
+        ASSERT_EQ(0, memcmp(data, "input", 5));
+        ev_input.Set();
+      });
+
+  mrsDataChannelConfig bulk_config{};
+  bulk_config.id = 1;
+  bulk_config.label = "bulk";
+  bulk_config.flags = mrsDataChannelConfigFlags::kOrdered |
+                      mrsDataChannelConfigFlags::kReliable;
+  bulk_config.priority = mrsDataChannelPriority::kVeryLow;
+  mrsDataChannelConfig input_config{};
+  input_config.id = 2;
+  input_config.label = "input";
+  input_config.flags = mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle bulk1 = nullptr;
+
+  // Invalid priority
+  input_config.priority = (mrsDataChannelPriority)4;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &input_config,
+                                            &bulk1));
+  input_config.priority = mrsDataChannelPriority::kHigh;
+
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pair.pc1(), &bulk_config, &bulk1));
+  mrsDataChannelHandle input1 = nullptr;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pair.pc1(), &input_config, &input1));
+  mrsDataChannelHandle bulk2 = nullptr;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pair.pc2(), &bulk_config, &bulk2));
+  mrsDataChannelHandle input2 = nullptr;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pair.pc2(), &input_config, &input2));
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &bulk2_cb;
+  mrsDataChannelRegisterCallbacks(bulk2, &callbacks2);
+  callbacks2.message_user_data = &input2_cb;
+  mrsDataChannelRegisterCallbacks(input2, &callbacks2);
+
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.high_watermark = kBulkMessageCount * kBulkMessageSize;
+  queue_config.low_watermark = kBulkMessageSize;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetSendQueue(bulk1, &queue_config));
+  queue_config = mrsDataChannelSendQueueConfig{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetSendQueue(input1, &queue_config));
+  pair.ConnectAndWait();
+
+  // The input message is not held back by the bulk transfer, which completes
+  // once the input channel drained
+  std::vector<uint8_t> bulk_message(kBulkMessageSize, 0x5A);
+  for (int i = 0; i < kBulkMessageCount; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelQueueMessage(bulk1, bulk_message.data(),
+                                         bulk_message.size()));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelQueueMessage(input1, "input", 5));
+  ASSERT_TRUE(ev_input.WaitFor(60s));
+  ASSERT_TRUE(ev_bulk.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), bulk1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), input1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), bulk2));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), input2));
+}
+
+TEST_P(DataChannelTests, Limits) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid limits
+  mrsDataChannelLimits limits{};
+  limits.max_buffering_size = 0x2000000;  // 32 MB
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetDataChannelLimits(pair.pc1(), &limits));
+  limits = mrsDataChannelLimits{};
+  limits.max_message_size = limits.max_buffering_size + 1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetDataChannelLimits(pair.pc1(), &limits));
+  limits.max_message_size = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetDataChannelLimits(pair.pc1(), &limits));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetDataChannelLimits(pair.pc1(), nullptr));
+
+  // The limits of the peer connection apply to the channels it creates
+  limits.max_buffering_size = 1024 * 1024;
+  limits.max_message_size = 64 * 1024;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetDataChannelLimits(pair.pc1(), &limits));
+
+  Event ev_msg;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* /*data*/, const uint64_t size) {
+        ASSERT_EQ(64u * 1024u, size);
+        ev_msg.Set();
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+
+  mrsDataChannelLimits limits1{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetLimits(handle1, &limits1));
+  ASSERT_EQ(limits.max_buffering_size, limits1.max_buffering_size);
+  ASSERT_EQ(limits.max_message_size, limits1.max_message_size);
+  mrsDataChannelLimits limits2{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetLimits(handle2, &limits2));
+  ASSERT_EQ(16u * 1024u * 1024u, limits2.max_buffering_size);
+  ASSERT_EQ(16u * 1024u * 1024u, limits2.max_message_size);
+
+  pair.ConnectAndWait();
+
+  // Messages larger than the limit are rejected
+  std::vector<uint8_t> data(64 * 1024 + 1, 0x42);
+  ASSERT_NE(Result::kSuccess,
+            mrsDataChannelSendMessage(handle1, data.data(), data.size()));
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.high_watermark = 2 * 1024 * 1024;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetSendQueue(handle1, &queue_config));
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessage(handle1, data.data(), data.size() - 1));
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  // The limits can be raised per channel, up to the transport limit
+  limits.max_message_size = limits.max_buffering_size;
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetLimits(handle1, &limits));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetLimits(handle1, nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSetLimits(nullptr, &limits));
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, NetworkProbe) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  Event ev_state1, ev_probe;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* /*data*/, const uint64_t /*size*/) {
+        FAIL() << "Padding delivered as message.";
+      });
+  std::function<void(mrsDataChannelState, int32_t)> state1_cb(
+      [&](mrsDataChannelState state, int32_t /*id*/) {
+        if (state == mrsDataChannelState::kOpen) {
+          ev_state1.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks1{};
+  callbacks1.state_callback = &StaticStateCallback;
+  callbacks1.state_user_data = &state1_cb;
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelRegisterCallbacks(handle1, &callbacks1);
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+
+  mrsNetworkProbeResult probe_result{};
+  InteropCallback<const mrsNetworkProbeResult*> probe_cb =
+      [&](const mrsNetworkProbeResult* result) {
+        probe_result = *result;
+        ev_probe.Set();
+      };
+  mrsNetworkProbeConfig probe_config{};
+  probe_config.duration_ms = 500;
+  probe_config.data_channel = handle1;
+
+  // Invalid arguments
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionProbeNetwork(nullptr, &probe_config,
+                                          CB(probe_cb)));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config, nullptr,
+                                          nullptr));
+  probe_config.duration_ms = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config,
+                                          CB(probe_cb)));
+  probe_config.duration_ms = 500;
+
+  // Not connected yet
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config,
+                                          CB(probe_cb)));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_state1.WaitFor(60s));
+
+  // The data channel must belong to the peer connection
+  probe_config.data_channel = handle2;
+  ASSERT_EQ(Result::kNotFound,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config,
+                                          CB(probe_cb)));
+  probe_config.data_channel = handle1;
+
+  // Only one probe at a time
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config,
+                                          CB(probe_cb)));
+  probe_cb.is_registered_ = true;
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsPeerConnectionProbeNetwork(pair.pc1(), &probe_config,
+                                          CB(probe_cb)));
+  ASSERT_TRUE(ev_probe.WaitFor(10s));
+  probe_cb.is_registered_ = false;
+  ASSERT_EQ(Result::kSuccess, probe_result.result);
+  ASSERT_LT(0.0, probe_result.measured_bitrate);
+  ASSERT_LT(0, probe_result.suggested_start_bitrate_bps);
+  ASSERT_LE(0.0, probe_result.min_round_trip_time);
+  ASSERT_LE(probe_result.min_round_trip_time, probe_result.round_trip_time);
+  ASSERT_LE(0.0, probe_result.loss_fraction);
+  ASSERT_GE(1.0, probe_result.loss_fraction);
+
+  // The padding is not counted as messages
+  mrsDataChannelCounters counters{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetCounters(handle1, &counters));
+  ASSERT_EQ(0u, counters.messages_sent);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, ReceiveRing) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  const char* const msg_data[] = {"first", "second message", "third"};
+  constexpr int kMessageCount = 3;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+
+  // The receive ring is disabled by default
+  char buffer[64];
+  uint64_t size = 0;
+  mrsBool received = mrsBool::kTrue;
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelTryReceiveMessage(handle2, buffer, sizeof(buffer),
+                                            &size, &received));
+  ASSERT_EQ(mrsBool::kFalse, received);
+
+  // Invalid capacity
+  mrsDataChannelReceiveRingConfig ring_config{};
+  ring_config.max_messages = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetReceiveRing(handle2, &ring_config));
+
+  ring_config = mrsDataChannelReceiveRingConfig{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetReceiveRing(handle2, &ring_config));
+
+  // The empty ring succeeds without pulling any message
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelTryReceiveMessage(handle2, buffer, sizeof(buffer),
+                                            &size, &received));
+  ASSERT_EQ(mrsBool::kFalse, received);
+
+  // Pull the messages from the data available callback, which fires again
+  // each time the ring was emptied.
+  Event ev_msg;
+  int received_count = 0;
+  InteropCallback<> data_available_cb([&]() {
+    // A buffer too small leaves the message in the ring
+    uint64_t msg_size = 0;
+    mrsBool msg_received = mrsBool::kTrue;
+    ASSERT_EQ(Result::kBufferTooSmall,
+              mrsDataChannelTryReceiveMessage(handle2, buffer, 1, &msg_size,
+                                              &msg_received));
+    ASSERT_EQ(mrsBool::kFalse, msg_received);
+    ASSERT_LT(1u, msg_size);
+    while (true) {
+      ASSERT_EQ(Result::kSuccess, mrsDataChannelTryReceiveMessage(
+                                      handle2, buffer, sizeof(buffer),
+                                      &msg_size, &msg_received));
+      if (msg_received == mrsBool::kFalse) {
+        break;
+      }
+      ASSERT_GT(kMessageCount, received_count);
+      const char* const expected = msg_data[received_count];
+      ASSERT_EQ(strlen(expected), msg_size);
+      ASSERT_EQ(0, memcmp(buffer, expected, msg_size));
+      if (++received_count == kMessageCount) {
+        ev_msg.Set();
+      }
+    }
+  });
+  mrsDataChannelRegisterDataAvailableCallback(handle2, CB(data_available_cb));
+  data_available_cb.is_registered_ = true;
+
+  pair.ConnectAndWait();
+  for (int i = 0; i < kMessageCount; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(handle1, msg_data[i],
+                                        strlen(msg_data[i])));
+  }
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  uint64_t dropped_count = 1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelGetReceiveDroppedCount(handle2, &dropped_count));
+  ASSERT_EQ(0u, dropped_count);
+
+  // Nothing left to pull in batch
+  mrsDataChannelMessage messages[kMessageCount];
+  int32_t count = -1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelReceiveMessages(handle2, buffer, sizeof(buffer),
+                                          messages, kMessageCount, &count));
+  ASSERT_EQ(0, count);
+
+  mrsDataChannelRegisterDataAvailableCallback(handle2, nullptr, nullptr);
+  data_available_cb.is_registered_ = false;
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetReceiveRing(handle2, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, Stream) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Large enough to span many fragments and fill the send queue many times
+  constexpr uint64_t kStreamSize = 1024 * 1024 + 123;
+  std::vector<uint8_t> src_data(kStreamSize);
+  for (uint64_t i = 0; i < kStreamSize; ++i) {
+    src_data[i] = (uint8_t)(i * 7 + (i >> 10));
+  }
+  std::vector<uint8_t> dst_data;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "stream";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+
+  // Streams are written through the send queue
+  uint32_t stream_id = 0;
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelOpenStream(handle1, kStreamSize, &stream_id));
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.high_watermark = 256 * 1024;
+  queue_config.low_watermark = 64 * 1024;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetSendQueue(handle1, &queue_config));
+  Event ev_writable;
+  InteropCallback<> writable_cb([&]() { ev_writable.Set(); });
+  mrsDataChannelRegisterWritableCallback(handle1, CB(writable_cb));
+  writable_cb.is_registered_ = true;
+
+  // Reassemble into a buffer allocated when the stream opens
+  Event ev_completed;
+  uint32_t opened_id = 0;
+  uint64_t last_progress = 0;
+  mrsResult completed_result = Result::kUnknownError;
+  mrsDataChannelStreamReceiverCallbacks receiver{};
+  receiver.opened_callback = [](void* user_data, uint32_t id,
+                                uint64_t total_size) -> void* {
+    auto dst = static_cast<std::vector<uint8_t>*>(user_data);
+    dst->resize((size_t)total_size);
+    return dst->data();
+  };
+  receiver.opened_user_data = &dst_data;
+  InteropCallback<uint32_t, uint64_t, uint64_t> progress_cb(
+      [&](uint32_t id, uint64_t received, uint64_t total) {
+        ASSERT_EQ(kStreamSize, total);
+        ASSERT_LT(last_progress, received);
+        last_progress = received;
+        opened_id = id;
+      });
+  InteropCallback<uint32_t, mrsResult> completed_cb(
+      [&](uint32_t id, mrsResult result) {
+        ASSERT_EQ(opened_id, id);
+        completed_result = result;
+        ev_completed.Set();
+      });
+  receiver.progress_callback = &decltype(progress_cb)::StaticExec;
+  receiver.progress_user_data = &progress_cb;
+  receiver.completed_callback = &decltype(completed_cb)::StaticExec;
+  receiver.completed_user_data = &completed_cb;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetStreamReceiver(handle2, &receiver));
+
+  pair.ConnectAndWait();
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelOpenStream(handle1, kStreamSize, &stream_id));
+  uint64_t offset = 0;
+  while (offset < kStreamSize) {
+    uint64_t written = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelWriteStream(handle1, stream_id,
+                                        src_data.data() + offset,
+                                        kStreamSize - offset, &written));
+    offset += written;
+    if (offset < kStreamSize) {
+      ASSERT_TRUE(ev_writable.WaitFor(60s));
+      ev_writable.Reset();
+    }
+  }
+  ASSERT_EQ(kStreamSize, offset);
+
+  // The stream is closed once fully written
+  uint64_t written = 0;
+  ASSERT_EQ(Result::kNotFound,
+            mrsDataChannelWriteStream(handle1, stream_id, src_data.data(), 1,
+                                      &written));
+
+  ASSERT_TRUE(ev_completed.WaitFor(60s));
+  ASSERT_EQ(Result::kSuccess, completed_result);
+  ASSERT_EQ(stream_id, opened_id);
+  ASSERT_EQ(kStreamSize, last_progress);
+  ASSERT_TRUE(src_data == dst_data);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetStreamReceiver(handle2, nullptr));
+  mrsDataChannelRegisterWritableCallback(handle1, nullptr, nullptr);
+  writable_cb.is_registered_ = false;
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetSendQueue(handle1, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, Compression) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // A message below the threshold, a compressible one, and one which does not
+  // compress.
+  std::vector<std::vector<uint8_t>> messages(3);
+  const char small_msg[] = "small";
+  messages[0].assign(small_msg, small_msg + sizeof(small_msg));
+  const char json[] = "{\"pos\":[1.0,2.5,3.25],\"rot\":[0,0,0,1]},";
+  for (int i = 0; i < 500; ++i) {
+    messages[1].insert(messages[1].end(), json, json + sizeof(json) - 1);
+  }
+  uint32_t state = 12345;
+  messages[2].resize(4096);
+  for (uint8_t& value : messages[2]) {
+    state = state * 1664525u + 1013904223u;
+    value = (uint8_t)(state >> 24);
+  }
+  const int message_count = (int)messages.size();
+
+  Event ev_msg;
+  int received_count = 0;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_GT(message_count, received_count);
+        const std::vector<uint8_t>& expected = messages[received_count];
+        ASSERT_EQ(expected.size(), size);
+        ASSERT_EQ(0, memcmp(data, expected.data(), (size_t)size));
+        if (++received_count == message_count) {
+          ev_msg.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  // Out-of-band channels are compressed when both peers set the flag
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "compressed";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable |
+                 mrsDataChannelConfigFlags::kCompressed;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetCompressionThreshold(handle1, 64));
+
+  pair.ConnectAndWait();
+  for (const std::vector<uint8_t>& message : messages) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(handle1, message.data(),
+                                        message.size()));
+  }
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, PartialReliability) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  Event ev_msg;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_EQ(4u, size);
+        ASSERT_EQ(0, memcmp(data, "pose", 4));
+        ev_msg.Set();
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "pose";
+  mrsDataChannelHandle handle1 = nullptr;
+
+  // Reliable channels cannot limit retransmissions
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  config.max_packet_lifetime_ms = 50;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+
+  // Only one of the limits can be set
+  config.flags = mrsDataChannelConfigFlags::kOrdered;
+  config.max_retransmits = 2;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+
+  // Limits are encoded on 16 bits
+  config.max_retransmits = -1;
+  config.max_packet_lifetime_ms = 0x10000;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+
+  // Drop messages not delivered within 50 ms
+  config.max_packet_lifetime_ms = 50;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2 = nullptr;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+
+  pair.ConnectAndWait();
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSendMessage(handle1, "pose", 4));
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, Counters) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr int kMessageCount = 20;
+  constexpr uint64_t kMessageSize = 100;
+  const std::vector<uint8_t> msg_data(kMessageSize, 0x42);
+
+  Event ev_msg;
+  std::atomic<int> received_count{0};
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* /*data*/, const uint64_t size) {
+        // Latency probes are not delivered
+        ASSERT_EQ(kMessageSize, size);
+        if (++received_count == kMessageCount) {
+          ev_msg.Set();
+        }
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "counters";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetLatencyProbeInterval(handle1, 10));
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetLatencyProbeInterval(handle2, 10));
+
+  mrsDataChannelCounters counters1{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetCounters(handle1, &counters1));
+  ASSERT_EQ(0u, counters1.messages_sent);
+  ASSERT_EQ(-1, counters1.latency_us);
+
+  pair.ConnectAndWait();
+  for (int i = 0; i < kMessageCount; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(handle1, msg_data.data(),
+                                        kMessageSize));
+    // Space the messages out for some of them to carry a probe
+    std::this_thread::sleep_for(20ms);
+  }
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetCounters(handle1, &counters1));
+  ASSERT_EQ((uint64_t)kMessageCount, counters1.messages_sent);
+  ASSERT_EQ(kMessageCount * kMessageSize, counters1.bytes_sent);
+  ASSERT_EQ(0u, counters1.messages_rejected);
+  ASSERT_LE(counters1.buffered_amount, counters1.peak_buffered_amount);
+  mrsDataChannelCounters counters2{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetCounters(handle2, &counters2));
+  ASSERT_EQ((uint64_t)kMessageCount, counters2.messages_received);
+  ASSERT_EQ(kMessageCount * kMessageSize, counters2.bytes_received);
+
+  // The echo of the last probes may still be in flight
+  for (int i = 0; (i < 100) && (counters1.latency_us < 0); ++i) {
+    std::this_thread::sleep_for(10ms);
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelGetCounters(handle1, &counters1));
+  }
+  ASSERT_LE(0, counters1.latency_us);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+}
+
+TEST_P(DataChannelTests, AddMany) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr uint32_t kChannelCount = 3;
+  mrsDataChannelConfig configs[kChannelCount]{};
+  for (uint32_t i = 0; i < kChannelCount; ++i) {
+    configs[i].id = 42 + (int32_t)i;
+    configs[i].flags = mrsDataChannelConfigFlags::kOrdered |
+                       mrsDataChannelConfigFlags::kReliable;
+  }
+  configs[0].label = "first";
+
+  // An invalid configuration fails the whole batch
+  configs[2].max_retransmits = 2;
+  mrsDataChannelHandle handles1[kChannelCount];
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannels(pair.pc1(), configs,
+                                             kChannelCount, handles1));
+  ASSERT_EQ(nullptr, handles1[0]);
+  configs[2].max_retransmits = -1;
+
+  // Asynchronous creation on the first peer
+  Event ev_added;
+  std::vector<mrsDataChannelHandle> added_handles;
+  InteropCallback<mrsResult, const mrsDataChannelHandle*, uint32_t> added_cb(
+      [&](mrsResult result, const mrsDataChannelHandle* handles,
+          uint32_t count) {
+        ASSERT_EQ(Result::kSuccess, result);
+        added_handles.assign(handles, handles + count);
+        ev_added.Set();
+      });
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannelsAsync(pair.pc1(), configs,
+                                                  kChannelCount, CB(added_cb)));
+  ASSERT_TRUE(ev_added.WaitFor(5s));
+  ASSERT_EQ(kChannelCount, added_handles.size());
+  std::copy(added_handles.begin(), added_handles.end(), handles1);
+
+  // Synchronous creation on the second peer
+  Event ev_msg;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_EQ(4u, size);
+        ASSERT_EQ(0, memcmp(data, "last", 4));
+        ev_msg.Set();
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+  mrsDataChannelHandle handles2[kChannelCount];
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannels(pair.pc2(), configs,
+                                             kChannelCount, handles2));
+  for (uint32_t i = 0; i < kChannelCount; ++i) {
+    ASSERT_NE(nullptr, handles1[i]);
+    ASSERT_NE(nullptr, handles2[i]);
+  }
+  mrsDataChannelRegisterCallbacks(handles2[2], &callbacks2);
+
+  pair.ConnectAndWait();
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessage(handles1[2], "last", 4));
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+
+  for (uint32_t i = 0; i < kChannelCount; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionRemoveDataChannel(pair.pc1(), handles1[i]));
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionRemoveDataChannel(pair.pc2(), handles2[i]));
+  }
+}
+
+TEST_P(DataChannelTests, Prenegotiated) {
+  mrsDataChannelConfig configs[2]{};
+  configs[0].id = 3;
+  configs[0].label = "reliable";
+  configs[0].flags = mrsDataChannelConfigFlags::kOrdered |
+                     mrsDataChannelConfigFlags::kReliable;
+  configs[1].id = 4;
+  configs[1].label = "pose";
+  configs[1].max_packet_lifetime_ms = 50;
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  pc_config.data_channels = configs;
+  pc_config.data_channel_count = 2;
+
+  // In-band channels cannot be pre-negotiated
+  configs[1].id = -1;
+  mrsPeerConnectionHandle handle = nullptr;
+  ASSERT_EQ(Result::kInvalidDataChannelId,
+            mrsPeerConnectionCreate(&pc_config, &handle));
+  ASSERT_EQ(nullptr, handle);
+  configs[1].id = 4;
+
+  LocalPeerPairRaii pair(pc_config);
+  mrsDataChannelHandle handle1 = nullptr;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetDataChannelById(pair.pc1(), 4, &handle1));
+  ASSERT_NE(nullptr, handle1);
+  mrsDataChannelHandle handle2 = nullptr;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetDataChannelById(pair.pc2(), 4, &handle2));
+  ASSERT_NE(nullptr, handle2);
+  mrsDataChannelHandle other = nullptr;
+  ASSERT_EQ(Result::kNotFound,
+            mrsPeerConnectionGetDataChannelById(pair.pc1(), 5, &other));
+  ASSERT_EQ(nullptr, other);
+
+  Event ev_msg;
+  std::function<void(const void*, const uint64_t)> message2_cb(
+      [&](const void* data, const uint64_t size) {
+        ASSERT_EQ(4u, size);
+        ASSERT_EQ(0, memcmp(data, "pose", 4));
+        ev_msg.Set();
+      });
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message2_cb;
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+
+  pair.ConnectAndWait();
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSendMessage(handle1, "pose", 4));
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
 }
 
 // NOTE - This test is flaky, relies on the send loop being faster than what the
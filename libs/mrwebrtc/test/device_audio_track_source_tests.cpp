@@ -17,6 +17,32 @@ class DeviceAudioTrackSourceTests
 
 }  // namespace
 
+TEST_F(DeviceAudioTrackSourceTests, InvalidConfig) {
+  mrsDeviceAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsDeviceAudioTrackSourceCreate(nullptr, &source_handle));
+  ASSERT_EQ(nullptr, source_handle);
+  mrsLocalAudioDeviceInitConfig config{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsDeviceAudioTrackSourceCreate(&config, nullptr));
+
+  // Audio processing options other than true, false, or unset, are rejected
+  // before opening any device
+  mrsOptBool mrsLocalAudioDeviceInitConfig::*const options[] = {
+      &mrsLocalAudioDeviceInitConfig::auto_gain_control_,
+      &mrsLocalAudioDeviceInitConfig::echo_cancellation_,
+      &mrsLocalAudioDeviceInitConfig::noise_suppression_,
+      &mrsLocalAudioDeviceInitConfig::highpass_filter_};
+  for (auto option : options) {
+    config = mrsLocalAudioDeviceInitConfig{};
+    config.*option = (mrsOptBool)42;
+    source_handle = nullptr;
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsDeviceAudioTrackSourceCreate(&config, &source_handle));
+    ASSERT_EQ(nullptr, source_handle);
+  }
+}
+
 #if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
 
 INSTANTIATE_TEST_CASE_P(,
@@ -7,6 +7,7 @@
 #include "interop_api.h"
 #include "video_frame.h"
 
+#include "peer_connection_test_helpers.h"
 #include "test_utils.h"
 
 namespace {
@@ -42,4 +43,73 @@ TEST_P(DeviceVideoTrackSourceTests, DeviceIdInvalid) {
   ASSERT_EQ(nullptr, source_handle);
 }
 
+TEST_P(DeviceVideoTrackSourceTests, CreateAsync) {
+  mrsLocalVideoDeviceInitConfig config{};
+  Event created_ev;
+  mrsResult created_result = Result::kUnknownError;
+  mrsDeviceVideoTrackSourceHandle source_handle{};
+  InteropCallback<mrsResult, mrsDeviceVideoTrackSourceHandle> created_cb =
+      [&](mrsResult result, mrsDeviceVideoTrackSourceHandle handle) {
+        created_result = result;
+        source_handle = handle;
+        created_ev.Set();
+      };
+  uint32_t operation_id = 0;
+  ASSERT_EQ(Result::kSuccess, mrsDeviceVideoTrackSourceCreateAsync(
+                                  &config, CB(created_cb), &operation_id));
+  ASSERT_NE(0u, operation_id);
+  ASSERT_TRUE(created_ev.WaitFor(10s));
+  ASSERT_EQ(Result::kSuccess, created_result);
+  ASSERT_NE(nullptr, source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+
+  // Cancel the second of two creations, which cannot have started yet.
+  created_ev.Reset();
+  uint32_t first_id = 0;
+  InteropCallback<mrsResult, mrsDeviceVideoTrackSourceHandle> first_cb =
+      [](mrsResult /*result*/, mrsDeviceVideoTrackSourceHandle handle) {
+        if (handle) {
+          mrsRefCountedObjectRemoveRef(handle);
+        }
+      };
+  ASSERT_EQ(Result::kSuccess, mrsDeviceVideoTrackSourceCreateAsync(
+                                  &config, CB(first_cb), &first_id));
+  ASSERT_EQ(Result::kSuccess, mrsDeviceVideoTrackSourceCreateAsync(
+                                  &config, CB(created_cb), &operation_id));
+  ASSERT_EQ(Result::kSuccess,
+            mrsDeviceVideoTrackSourceCancelCreateAsync(operation_id));
+  ASSERT_TRUE(created_ev.WaitFor(10s));
+  ASSERT_EQ(Result::kCancelled, created_result);
+  ASSERT_EQ(nullptr, source_handle);
+  ASSERT_EQ(Result::kNotFound,
+            mrsDeviceVideoTrackSourceCancelCreateAsync(operation_id));
+}
+
+TEST_P(DeviceVideoTrackSourceTests, EnumDevicesCached) {
+  struct Enumeration {
+    std::vector<std::string> ids;
+    Event completed_ev;
+  };
+  auto enum_callback = [](const char* id, const char* /*name*/,
+                          void* user_data) {
+    static_cast<Enumeration*>(user_data)->ids.push_back(id);
+  };
+  auto completed_callback = [](void* user_data) {
+    static_cast<Enumeration*>(user_data)->completed_ev.Set();
+  };
+  Enumeration first;
+  ASSERT_EQ(Result::kSuccess,
+            mrsEnumVideoCaptureDevicesAsync(enum_callback, &first,
+                                            completed_callback, &first));
+  ASSERT_TRUE(first.completed_ev.WaitFor(10s));
+
+  // Once cached, the devices are enumerated before the call returns.
+  Enumeration second;
+  ASSERT_EQ(Result::kSuccess,
+            mrsEnumVideoCaptureDevicesAsync(enum_callback, &second,
+                                            completed_callback, &second));
+  ASSERT_TRUE(second.completed_ev.IsSignaled());
+  ASSERT_EQ(first.ids, second.ids);
+}
+
 #endif  // MRSW_EXCLUDE_DEVICE_TESTS
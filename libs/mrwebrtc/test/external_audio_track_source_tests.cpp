@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "external_audio_track_source_interop.h"
+#include "interop_api.h"
+
+#include "test_utils.h"
+
+namespace {
+
+class ExternalAudioTrackSourceTests : public TestUtils::TestBase {};
+
+}  // namespace
+
+TEST_F(ExternalAudioTrackSourceTests, Create) {
+  mrsExternalAudioTrackSourceSettings settings{};
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&settings, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalAudioTrackSourceTests, InvalidSettings) {
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  {
+    mrsExternalAudioTrackSourceSettings settings{};
+    settings.sampling_rate_hz = 44101;  // not a multiple of 100 Hz
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsExternalAudioTrackSourceCreate(&settings, &source_handle));
+    ASSERT_EQ(nullptr, source_handle);
+  }
+  {
+    mrsExternalAudioTrackSourceSettings settings{};
+    settings.channel_count = 3;
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsExternalAudioTrackSourceCreate(&settings, &source_handle));
+    ASSERT_EQ(nullptr, source_handle);
+  }
+}
+
+TEST_F(ExternalAudioTrackSourceTests, PushAudio) {
+  // 20 ms of stereo float audio at 48 kHz.
+  mrsExternalAudioTrackSourceSettings settings{};
+  settings.channel_count = 2;
+  settings.sample_type = mrsExternalAudioSampleType::kFloat32;
+  settings.buffer_ms = 20;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&settings, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Pushing more than the buffer holds only copies what fits.
+  std::vector<float> samples(2 * 1920, 0.5f);
+  uint32_t frames_pushed = 0;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalAudioTrackSourcePushAudio(source_handle, samples.data(),
+                                                 1920, &frames_pushed));
+  ASSERT_GE(frames_pushed, 960u);
+  ASSERT_LE(frames_pushed, 1920u);
+
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
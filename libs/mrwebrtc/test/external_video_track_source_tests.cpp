@@ -3,12 +3,22 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "data_channel.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
 #include "local_video_track_interop.h"
+#include "media/external_video_track_source.h"
 #include "remote_video_track_interop.h"
 #include "transceiver_interop.h"
+#include "video_frame_queue_interop.h"
+#include "video_texture_uploader_interop.h"
+#include "video_track_source_interop.h"
 
 #include "test_utils.h"
 
@@ -20,8 +30,72 @@ class ExternalVideoTrackSourceTests
     : public TestUtils::TestBase,
       public testing::WithParamInterface<mrsSdpSemantic> {};
 
+using PendingRequestRing =
+    Microsoft::MixedReality::WebRTC::detail::PendingRequestRing;
+
 }  // namespace
 
+TEST(PendingRequestRing, Overflow) {
+  PendingRequestRing ring;
+  constexpr uint32_t kCapacity = PendingRequestRing::kCapacity;
+  std::vector<uint32_t> ids;
+  for (uint32_t i = 0; i < kCapacity + 6; ++i) {
+    ids.push_back(ring.Push(1000 + i));
+  }
+  // IDs are sequential, and the oldest requests past the capacity are dropped
+  for (uint32_t i = 0; i < kCapacity + 6; ++i) {
+    ASSERT_EQ(ids[0] + i, ids[i]);
+  }
+  for (uint32_t i = 0; i < 6; ++i) {
+    ASSERT_EQ(-1, ring.Consume(ids[i]));
+  }
+  // The requests still pending kept their own timestamp, even though their
+  // slots were reused
+  ASSERT_EQ(1006, ring.Consume(ids[6]));
+  ASSERT_EQ((int64_t)(1000 + kCapacity + 5), ring.Consume(ids[kCapacity + 5]));
+  ASSERT_EQ(-1, ring.Consume(ids[kCapacity + 5]));
+}
+
+TEST(PendingRequestRing, StaleAfterClear) {
+  PendingRequestRing ring;
+  const uint32_t id0 = ring.Push(10);
+  const uint32_t id1 = ring.Push(11);
+  ring.Clear();
+  ASSERT_EQ(-1, ring.Consume(id0));
+  ASSERT_EQ(-1, ring.Consume(id1));
+
+  // New requests after a restart don't reuse the IDs of the cleared ones
+  const uint32_t id2 = ring.Push(12);
+  ASSERT_NE(id0, id2);
+  ASSERT_NE(id1, id2);
+  ASSERT_EQ(-1, ring.Consume(id1));
+  ASSERT_EQ(12, ring.Consume(id2));
+
+  // IDs never issued are rejected too
+  ASSERT_EQ(-1, ring.Consume(id2 + 1));
+  ASSERT_EQ(-1, ring.Consume(id2 + 1000));
+}
+
+TEST(PendingRequestRing, OutOfOrderCompletion) {
+  PendingRequestRing ring;
+  const uint32_t id0 = ring.Push(10);
+  const uint32_t id1 = ring.Push(11);
+  const uint32_t id2 = ring.Push(12);
+  const uint32_t id3 = ring.Push(13);
+
+  // Completing a request discards all older ones
+  ASSERT_EQ(12, ring.Consume(id2));
+  ASSERT_EQ(-1, ring.Consume(id0));
+  ASSERT_EQ(-1, ring.Consume(id1));
+  ASSERT_EQ(-1, ring.Consume(id2));
+  ASSERT_EQ(13, ring.Consume(id3));
+
+  // The ring is empty again, and keeps working
+  const uint32_t id4 = ring.Push(14);
+  ASSERT_EQ(id3 + 1, id4);
+  ASSERT_EQ(14, ring.Consume(id4));
+}
+
 #if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
 
 namespace {
@@ -51,12 +125,8 @@ constexpr uint32_t kGreen = 0xFF00BA7Fu;
 constexpr uint32_t kBlue = 0xFFEFA400u;
 constexpr uint32_t kYellow = 0xFF00B9FFu;
 
-/// Generate a 16px by 16px test frame.
-mrsResult MRS_CALL
-GenerateQuadTestFrame(void* /*user_data*/,
-                      mrsExternalVideoTrackSourceHandle source_handle,
-                      uint32_t request_id,
-                      int64_t timestamp_ms) {
+/// Fill a 16px by 16px test frame.
+mrsArgb32VideoFrame FillQuadTestFrame() {
   memset(FrameBuffer, 0, 256 * 4);
   FillSquareArgb32(FrameBuffer, 0, 0, 8, 8, 64, kRed);
   FillSquareArgb32(FrameBuffer, 8, 0, 8, 8, 64, kGreen);
@@ -67,6 +137,16 @@ GenerateQuadTestFrame(void* /*user_data*/,
   frame_view.height_ = 16;
   frame_view.argb32_data_ = FrameBuffer;
   frame_view.stride_ = 16 * 4;
+  return frame_view;
+}
+
+/// Generate a 16px by 16px test frame.
+mrsResult MRS_CALL
+GenerateQuadTestFrame(void* /*user_data*/,
+                      mrsExternalVideoTrackSourceHandle source_handle,
+                      uint32_t request_id,
+                      int64_t timestamp_ms) {
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
   return mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
       source_handle, request_id, timestamp_ms, &frame_view);
 }
@@ -120,6 +200,9 @@ void ValidateQuadTestFrame(const void* data,
 using VideoTrackAddedCallback =
     InteropCallback<const mrsRemoteVideoTrackAddedInfo*>;
 
+// mrsI420AVideoFrameCallback
+using I420AVideoFrameCallback = InteropCallback<const mrsI420AVideoFrame&>;
+
 // mrsArgb32VideoFrameCallback
 using Argb32VideoFrameCallback = InteropCallback<const mrsArgb32VideoFrame&>;
 
@@ -220,4 +303,1374 @@ TEST_P(ExternalVideoTrackSourceTests, Simple) {
   mrsRefCountedObjectRemoveRef(source_handle1);
 }
 
+TEST_F(ExternalVideoTrackSourceTests, OnDemandScheduling) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromArgb32Callback(
+                &GenerateQuadTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Invalid settings are rejected
+  mrsExternalVideoTrackSourceSettings settings{};
+  settings.framerate = 0.0f;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceConfigure(source_handle, nullptr));
+
+  settings.scheduling = mrsExternalVideoFrameScheduling::kOnDemand;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Settings cannot change once capture started
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+
+  uint32_t frame_count = 0;
+  Event ev;
+  Argb32VideoFrameCallback argb_cb = [&frame_count,
+                                      &ev](const mrsArgb32VideoFrame& frame) {
+    ValidateQuadTestFrame(frame.argb32_data_, frame.stride_, frame.width_,
+                          frame.height_);
+    ++frame_count;
+    ev.Set();
+  };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // No frame is requested until the application signals one
+  ASSERT_FALSE(ev.WaitFor(1s));
+  ASSERT_EQ(0u, frame_count);
+
+  // Each signal produces exactly one frame
+  for (uint32_t i = 1; i <= 3; ++i) {
+    ev.Reset();
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceNotifyFrameAvailable(source_handle));
+    ASSERT_TRUE(ev.WaitFor(5s));
+    ASSERT_EQ(i, frame_count);
+  }
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, SharedScheduler) {
+  // Several sources multiplexed on the shared scheduler thread, and one with
+  // its own dedicated thread, all produce frames concurrently.
+  constexpr int kSourceCount = 4;
+  mrsExternalVideoTrackSourceHandle source_handles[kSourceCount]{};
+  std::atomic<uint32_t> frame_counts[kSourceCount]{};
+  Event events[kSourceCount];
+  std::vector<Argb32VideoFrameCallback> callbacks;
+  callbacks.reserve(kSourceCount);
+  for (int i = 0; i < kSourceCount; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceCreateFromArgb32Callback(
+                  &GenerateQuadTestFrame, nullptr, &source_handles[i]));
+    mrsExternalVideoTrackSourceSettings settings{};
+    settings.framerate = 60.0f;
+    settings.dedicated_thread = (i == kSourceCount - 1);
+    ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceConfigure(
+                                       source_handles[i], &settings));
+    callbacks.emplace_back([&frame_counts, &events,
+                            i](const mrsArgb32VideoFrame& /*frame*/) {
+      if (++frame_counts[i] == 5) {
+        events[i].Set();
+      }
+    });
+    mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handles[i],
+                                                   CB(callbacks[i]));
+    mrsExternalVideoTrackSourceFinishCreation(source_handles[i]);
+  }
+  for (int i = 0; i < kSourceCount; ++i) {
+    ASSERT_TRUE(events[i].WaitFor(5s));
+  }
+
+  // Stopping one source does not affect the others sharing its thread
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handles[0], nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handles[0]);
+  events[1].Reset();
+  frame_counts[1] = 0;
+  ASSERT_TRUE(events[1].WaitFor(5s));
+
+  for (int i = 0; i < kSourceCount; ++i) {
+    mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handles[i], nullptr,
+                                                   nullptr);
+    mrsExternalVideoTrackSourceShutdown(source_handles[i]);
+    mrsRefCountedObjectRemoveRef(source_handles[i]);
+  }
+}
+
+namespace {
+
+uint8_t NoCopyPlanes[4][256];
+uint8_t NoCopyAlpha = 0x20;
+
+/// Release callback for frames completed without copy.
+void MRS_CALL OnNoCopyFrameReleased(void* user_data) {
+  auto ev = static_cast<Event*>(user_data);
+  ev->Set();
+}
+
+/// Complete a request with a 16px by 16px I420A frame, without copy.
+mrsResult MRS_CALL
+GenerateNoCopyTestFrame(void* user_data,
+                        mrsExternalVideoTrackSourceHandle source_handle,
+                        uint32_t request_id,
+                        int64_t timestamp_ms) {
+  memset(NoCopyPlanes[0], 0x40, 256);
+  memset(NoCopyPlanes[1], 0x80, 64);
+  memset(NoCopyPlanes[2], 0xC0, 64);
+  memset(NoCopyPlanes[3], NoCopyAlpha, 256);
+  mrsI420AVideoFrame frame_view{};
+  frame_view.width_ = 16;
+  frame_view.height_ = 16;
+  frame_view.ydata_ = NoCopyPlanes[0];
+  frame_view.udata_ = NoCopyPlanes[1];
+  frame_view.vdata_ = NoCopyPlanes[2];
+  frame_view.adata_ = NoCopyPlanes[3];
+  frame_view.ystride_ = 16;
+  frame_view.ustride_ = 8;
+  frame_view.vstride_ = 8;
+  frame_view.astride_ = 16;
+  return mrsExternalVideoTrackSourceCompleteI420AFrameRequestNoCopy(
+      source_handle, request_id, timestamp_ms, &frame_view,
+      &OnNoCopyFrameReleased, user_data);
+}
+
+}  // namespace
+
+TEST_F(ExternalVideoTrackSourceTests, CompleteRequestNoCopy) {
+  Event released;
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &GenerateNoCopyTestFrame, &released, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Stop producing frames after the first one is released
+  mrsExternalVideoTrackSourceSettings settings{};
+  settings.scheduling = mrsExternalVideoFrameScheduling::kOnDemand;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  bool has_alpha = false;
+  const void* ydata = nullptr;
+  Event delivered;
+  I420AVideoFrameCallback i420a_cb = [&](const mrsI420AVideoFrame& frame) {
+    // The frame references the application planes, alpha included
+    ydata = frame.ydata_;
+    has_alpha = (frame.adata_ == NoCopyPlanes[3]);
+    delivered.Set();
+  };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420a_cb));
+
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceNotifyFrameAvailable(source_handle));
+  ASSERT_TRUE(delivered.WaitFor(5s));
+  ASSERT_EQ(NoCopyPlanes[0], ydata);
+  ASSERT_TRUE(has_alpha);
+
+  // No sink holds the frame, so it is released once delivered
+  ASSERT_TRUE(released.WaitFor(5s));
+
+  // A fully opaque alpha plane is dropped, and the next translucent frame has
+  // alpha again
+  for (uint8_t alpha : {0xFF, 0x20}) {
+    NoCopyAlpha = alpha;
+    delivered.Reset();
+    released.Reset();
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceNotifyFrameAvailable(source_handle));
+    ASSERT_TRUE(delivered.WaitFor(5s));
+    ASSERT_EQ(NoCopyPlanes[0], ydata);
+    ASSERT_EQ(alpha != 0xFF, has_alpha);
+    ASSERT_TRUE(released.WaitFor(5s));
+  }
+
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+namespace {
+
+/// Record the frame requests of a source without completing them.
+struct RequestRecorder {
+  std::mutex mutex_;
+  std::vector<uint32_t> request_ids_;
+  std::vector<int64_t> timestamps_;
+  Event ev_;
+  size_t expected_count_ = 0;
+};
+
+mrsResult MRS_CALL
+RecordRequest(void* user_data,
+              mrsExternalVideoTrackSourceHandle /*source_handle*/,
+              uint32_t request_id,
+              int64_t timestamp_ms) {
+  auto recorder = static_cast<RequestRecorder*>(user_data);
+  std::lock_guard<std::mutex> lock(recorder->mutex_);
+  recorder->request_ids_.push_back(request_id);
+  recorder->timestamps_.push_back(timestamp_ms);
+  if (recorder->request_ids_.size() == recorder->expected_count_) {
+    recorder->ev_.Set();
+  }
+  return mrsResult::kSuccess;
+}
+
+}  // namespace
+
+TEST_F(ExternalVideoTrackSourceTests, PendingRequests) {
+  RequestRecorder recorder;
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromArgb32Callback(
+                &RecordRequest, &recorder, &source_handle));
+  mrsExternalVideoTrackSourceSettings settings{};
+  settings.scheduling = mrsExternalVideoFrameScheduling::kOnDemand;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  uint32_t frame_count = 0;
+  Argb32VideoFrameCallback argb_cb =
+      [&frame_count](const mrsArgb32VideoFrame& /*frame*/) { ++frame_count; };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // Issue more requests than the source keeps pending
+  constexpr size_t kCapacity = PendingRequestRing::kCapacity;
+  constexpr size_t kRequestCount = kCapacity + 6;
+  recorder.expected_count_ = kRequestCount;
+  for (size_t i = 0; i < kRequestCount; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceNotifyFrameAvailable(source_handle));
+  }
+  ASSERT_TRUE(recorder.ev_.WaitFor(5s));
+  std::vector<uint32_t> ids;
+  std::vector<int64_t> timestamps;
+  {
+    std::lock_guard<std::mutex> lock(recorder.mutex_);
+    ids = recorder.request_ids_;
+    timestamps = recorder.timestamps_;
+  }
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  auto complete = [&](size_t index) {
+    return mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
+        source_handle, ids[index], timestamps[index], &frame_view);
+  };
+
+  // The oldest requests overflowed and cannot be completed
+  for (size_t i = 0; i < kRequestCount - kCapacity; ++i) {
+    ASSERT_EQ(mrsResult::kInvalidParameter, complete(i));
+  }
+  ASSERT_EQ(0u, frame_count);
+
+  // An invalid capture time leaves the request pending
+  ASSERT_EQ(
+      mrsResult::kInvalidParameter,
+      mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithCaptureTime(
+          source_handle, ids[kRequestCount - 2],
+          std::numeric_limits<int64_t>::min() / 2, &frame_view));
+  ASSERT_EQ(0u, frame_count);
+
+  // Completing out of order discards the older requests
+  ASSERT_EQ(mrsResult::kSuccess, complete(kRequestCount - 2));
+  ASSERT_EQ(1u, frame_count);
+  ASSERT_EQ(mrsResult::kInvalidParameter, complete(kRequestCount - 3));
+  ASSERT_EQ(
+      mrsResult::kSuccess,
+      mrsExternalVideoTrackSourceCompleteArgb32FrameRequestWithCaptureTime(
+          source_handle, ids[kRequestCount - 1], 1, &frame_view));
+  ASSERT_EQ(2u, frame_count);
+  ASSERT_EQ(mrsResult::kInvalidParameter, complete(kRequestCount - 1));
+
+  // Requests issued before the capture stopped are stale
+  {
+    std::lock_guard<std::mutex> lock(recorder.mutex_);
+    recorder.expected_count_ = kRequestCount + 1;
+  }
+  recorder.ev_.Reset();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceNotifyFrameAvailable(source_handle));
+  ASSERT_TRUE(recorder.ev_.WaitFor(5s));
+  uint32_t stale_id;
+  int64_t stale_timestamp;
+  {
+    std::lock_guard<std::mutex> lock(recorder.mutex_);
+    stale_id = recorder.request_ids_.back();
+    stale_timestamp = recorder.timestamps_.back();
+  }
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
+                source_handle, stale_id, stale_timestamp, &frame_view));
+  ASSERT_EQ(2u, frame_count);
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, PushFrames) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Frames cannot be pushed before capture started
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle, nullptr,
+                                                       0));
+
+  // Push sources have no request schedule to configure
+  mrsExternalVideoTrackSourceSettings settings{};
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  uint32_t frame_count = 0;
+  Argb32VideoFrameCallback argb_cb =
+      [&frame_count](const mrsArgb32VideoFrame& frame) {
+        ValidateQuadTestFrame(frame.argb32_data_, frame.stride_, frame.width_,
+                              frame.height_);
+        ++frame_count;
+      };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // Each pushed frame is delivered before the push call returns
+  for (uint32_t i = 1; i <= 3; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                         &frame_view, 0));
+    ASSERT_EQ(i, frame_count);
+  }
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+
+  // Frames cannot be pushed after shutdown
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+// Color conversions split into row bands produce the same pixels as a single
+// pass, including at band boundaries, which fall on chroma rows, and with an
+// odd number of rows.
+TEST_F(ExternalVideoTrackSourceTests, ParallelConversionMatchesSinglePass) {
+  constexpr int kWidth = 70;
+  constexpr int kHeight = 259;
+  std::vector<uint32_t> argb(kWidth * kHeight);
+  for (uint32_t& pixel : argb) {
+    pixel = 0xFF000000u | (((uint32_t)rand() << 12) ^ (uint32_t)rand());
+  }
+  mrsArgb32VideoFrame frame_view{};
+  frame_view.width_ = kWidth;
+  frame_view.height_ = kHeight;
+  frame_view.argb32_data_ = argb.data();
+  frame_view.stride_ = kWidth * 4;
+
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Keep a tightly packed copy of the I420 frame converted by the source, and
+  // of the ARGB32 frame converted back for the callback.
+  std::vector<uint8_t> i420;
+  std::vector<uint8_t> argb_out;
+  I420AVideoFrameCallback i420_cb = [&i420](const mrsI420AVideoFrame& frame) {
+    const int chroma_width = ((int)frame.width_ + 1) / 2;
+    const int chroma_height = ((int)frame.height_ + 1) / 2;
+    i420.clear();
+    auto append = [&i420](const void* data, int stride, int width,
+                          int height) {
+      for (int j = 0; j < height; ++j) {
+        const uint8_t* row = (const uint8_t*)data + (size_t)j * stride;
+        i420.insert(i420.end(), row, row + width);
+      }
+    };
+    append(frame.ydata_, frame.ystride_, frame.width_, frame.height_);
+    append(frame.udata_, frame.ustride_, chroma_width, chroma_height);
+    append(frame.vdata_, frame.vstride_, chroma_width, chroma_height);
+  };
+  Argb32VideoFrameCallback argb_cb =
+      [&argb_out](const mrsArgb32VideoFrame& frame) {
+        argb_out.clear();
+        for (uint32_t j = 0; j < frame.height_; ++j) {
+          const uint8_t* row =
+              (const uint8_t*)frame.argb32_data_ + (size_t)j * frame.stride_;
+          argb_out.insert(argb_out.end(), row, row + frame.width_ * 4);
+        }
+      };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420_cb));
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // Single pass
+  mrsSetParallelConversionThreshold(0);
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  const std::vector<uint8_t> i420_single = i420;
+  const std::vector<uint8_t> argb_single = argb_out;
+  ASSERT_EQ((size_t)kWidth * kHeight + 2 * 35 * 130, i420_single.size());
+  ASSERT_EQ((size_t)kWidth * kHeight * 4, argb_single.size());
+
+  // Row bands, for any frame size
+  mrsSetParallelConversionThreshold(1);
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  ASSERT_TRUE(i420_single == i420);
+  ASSERT_TRUE(argb_single == argb_out);
+
+  mrsSetParallelConversionThreshold(2560 * 1440);
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+// The pooled ARGB32 scratch buffer of a frame is not reused for a frame of
+// another shape, even if large enough, since its rows would not fit.
+TEST_F(ExternalVideoTrackSourceTests, ArgbFramesChangingShape) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  uint32_t frame_count = 0;
+  uint32_t expected_width = 0;
+  uint32_t expected_height = 0;
+  Argb32VideoFrameCallback argb_cb = [&](const mrsArgb32VideoFrame& frame) {
+    ++frame_count;
+    ASSERT_EQ(expected_width, frame.width_);
+    ASSERT_EQ(expected_height, frame.height_);
+    ASSERT_EQ((int)frame.width_ * 4, frame.stride_);
+    double err = 0.0;
+    for (uint32_t j = 0; j < frame.height_; ++j) {
+      const uint8_t* const data = (const uint8_t*)frame.argb32_data_;
+      const uint32_t* row = (const uint32_t*)(data + (size_t)j * frame.stride_);
+      for (uint32_t i = 0; i < frame.width_; ++i) {
+        err += std::fabs(ArgbColorError(kGreen, row[i]));
+      }
+    }
+    // +/-1 per component
+    ASSERT_LE(err, 4.0 * frame.width_ * frame.height_);
+  };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // Landscape and portrait frames of the same size, then a narrower frame
+  // smaller than the buffer of the previous one.
+  const std::pair<uint32_t, uint32_t> kShapes[] = {
+      {64, 48}, {48, 64}, {64, 48}, {48, 64}, {32, 64}, {64, 48}};
+  std::vector<uint32_t> argb(64 * 64, kGreen);
+  for (auto&& shape : kShapes) {
+    expected_width = shape.first;
+    expected_height = shape.second;
+    mrsArgb32VideoFrame frame_view{};
+    frame_view.width_ = shape.first;
+    frame_view.height_ = shape.second;
+    frame_view.argb32_data_ = argb.data();
+    frame_view.stride_ = (int)shape.first * 4;
+    const uint32_t count = frame_count;
+    ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                       source_handle, &frame_view, 0));
+    ASSERT_EQ(count + 1, frame_count);
+  }
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+// A frame pushed while no sink wants it is dropped along with its metadata,
+// which never sticks to a later frame.
+TEST_F(ExternalVideoTrackSourceTests, MetadataOfSkippedFrame) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  const uint32_t kMetadata = 0x5EEDu;
+  mrsExternalVideoFrameInfo info{};
+  info.metadata = &kMetadata;
+  info.metadata_size = sizeof(kMetadata);
+
+  // No sink
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithInfo(
+                source_handle, &frame_view, &info));
+
+  uint32_t frame_count = 0;
+  std::vector<uint8_t> metadata;
+  Argb32VideoFrameCallback argb_cb = [&](const mrsArgb32VideoFrame& frame) {
+    ++frame_count;
+    const uint8_t* const data = (const uint8_t*)frame.metadata_;
+    metadata.assign(data, data + frame.metadata_size_);
+  };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+
+  // The next frame has no metadata
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  ASSERT_EQ(1u, frame_count);
+  ASSERT_TRUE(metadata.empty());
+
+  // The metadata of a frame pushed with a sink is delivered with it only
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithInfo(
+                source_handle, &frame_view, &info));
+  ASSERT_EQ(2u, frame_count);
+  ASSERT_EQ(sizeof(kMetadata), metadata.size());
+  ASSERT_EQ(0, memcmp(&kMetadata, metadata.data(), sizeof(kMetadata)));
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  ASSERT_EQ(3u, frame_count);
+  ASSERT_TRUE(metadata.empty());
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, CaptureTime) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  int64_t timestamp_us = 0;
+  Argb32VideoFrameCallback argb_cb =
+      [&timestamp_us](const mrsArgb32VideoFrame& frame) {
+        timestamp_us = frame.timestamp_us_;
+      };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+
+  // Frames without capture time are stamped when pushed
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  const int64_t first_us = timestamp_us;
+  ASSERT_LT(0, first_us);
+
+  // Capture times are mapped from the application clock
+  constexpr int64_t kAppTimeUs = 5000000;
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsExternalVideoTrackSourceSyncCaptureClock(nullptr, kAppTimeUs));
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+                nullptr, &frame_view, kAppTimeUs));
+  std::this_thread::sleep_for(100ms);
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceSyncCaptureClock(
+                                     source_handle, kAppTimeUs));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+                source_handle, &frame_view,
+                std::numeric_limits<int64_t>::min() / 2));
+  ASSERT_EQ(first_us, timestamp_us);
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+                source_handle, &frame_view, kAppTimeUs - 50000));
+  const int64_t captured_us = timestamp_us;
+  ASSERT_LT(first_us, captured_us);
+
+  // The capture time only applies to its own frame
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushArgb32Frame(
+                                     source_handle, &frame_view, 0));
+  ASSERT_LE(captured_us + 45000, timestamp_us);
+  const int64_t pushed_us = timestamp_us;
+
+  // Capture times in the future are clamped to the current time
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32FrameWithCaptureTime(
+                source_handle, &frame_view, kAppTimeUs + 10000000));
+  ASSERT_LT(pushed_us, timestamp_us);
+  ASSERT_GT(pushed_us + 1000000, timestamp_us);
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, AsyncSinkUpdates) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsVideoTrackSourceSetAsyncSinkUpdates(nullptr, mrsBool::kTrue,
+                                                   nullptr, nullptr));
+  Event sink_updated;
+  InteropCallback<> sink_updated_cb = [&sink_updated]() { sink_updated.Set(); };
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceSetAsyncSinkUpdates(
+                source_handle, mrsBool::kTrue, CB(sink_updated_cb)));
+
+  // Frames are delivered once the sink is added
+  uint32_t frame_count = 0;
+  Argb32VideoFrameCallback argb_cb =
+      [&frame_count](const mrsArgb32VideoFrame& /*frame*/) { ++frame_count; };
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+  ASSERT_TRUE(sink_updated.WaitFor(5s));
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_EQ(1u, frame_count);
+
+  // An unregistered callback is not invoked anymore, even before the sink is
+  // removed.
+  sink_updated.Reset();
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_TRUE(sink_updated.WaitFor(5s));
+  ASSERT_EQ(1u, frame_count);
+
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceSetAsyncSinkUpdates(
+                source_handle, mrsBool::kFalse, nullptr, nullptr));
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, FrameQueue) {
+  mrsVideoFrameQueueHandle queue_handle{};
+  ASSERT_EQ(mrsResult::kOutOfRange, mrsVideoFrameQueueCreate(0, &queue_handle));
+  ASSERT_EQ(mrsResult::kSuccess, mrsVideoFrameQueueCreate(2, &queue_handle));
+  ASSERT_NE(nullptr, queue_handle);
+
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  uint64_t subscriber_id = 0;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceAddFrameQueueSubscriber(
+                source_handle, queue_handle, &subscriber_id));
+  ASSERT_NE(0u, subscriber_id);
+
+  // The queue keeps the latest frames
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                         &frame_view, 0));
+  }
+  mrsVideoFrameQueueStats stats{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoFrameQueueGetStats(queue_handle, &stats));
+  ASSERT_EQ(3u, stats.enqueued_count);
+  ASSERT_EQ(1u, stats.dropped_count);
+  ASSERT_EQ(2u, stats.queued_count);
+
+  // Dequeued frames expose their planes
+  mrsVideoFrameLease lease{};
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsVideoFrameQueueTryDequeue(queue_handle, &lease));
+    ASSERT_NE(nullptr, lease.buffer_handle_);
+    ASSERT_EQ(frame_view.width_, lease.width_);
+    ASSERT_EQ(frame_view.height_, lease.height_);
+    ASSERT_NE(nullptr, lease.ydata_);
+    mrsVideoFrameBufferRemoveRef(lease.buffer_handle_);
+  }
+  ASSERT_EQ(mrsResult::kNotFound,
+            mrsVideoFrameQueueTryDequeue(queue_handle, &lease));
+  ASSERT_EQ(nullptr, lease.buffer_handle_);
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoFrameQueueGetStats(queue_handle, &stats));
+  ASSERT_EQ(2u, stats.dequeued_count);
+  ASSERT_EQ(0u, stats.queued_count);
+  ASSERT_EQ(2u, stats.queue_latency.sample_count);
+
+  // Frames still queued are released with the queue
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_EQ(mrsResult::kSuccess, mrsVideoTrackSourceRemoveFrameSubscriber(
+                                     source_handle, subscriber_id));
+  mrsVideoFrameQueueDestroy(queue_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, TextureUploader) {
+  mrsVideoFrameQueueHandle queue_handle{};
+  ASSERT_EQ(mrsResult::kSuccess, mrsVideoFrameQueueCreate(2, &queue_handle));
+  mrsVideoTextureUploaderHandle uploader_handle{};
+  ASSERT_EQ(mrsResult::kUnsupported,
+            mrsVideoTextureUploaderCreate(queue_handle,
+                                          mrsVideoTextureApi::kOpenGLES3,
+                                          &uploader_handle));
+  ASSERT_EQ(nullptr, uploader_handle);
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTextureUploaderCreate(
+                queue_handle, mrsVideoTextureApi::kD3D11, &uploader_handle));
+  ASSERT_NE(nullptr, uploader_handle);
+
+  // Textures must be complete
+  mrsVideoTextures textures{};
+  textures.width = 4;
+  textures.height = 4;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsVideoTextureUploaderSetTextures(uploader_handle, &textures));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTextureUploaderSetTextures(uploader_handle, nullptr));
+
+  // An RGBA texture replaces the plane textures. No render event is issued
+  // with this fake texture, which is cleared before.
+  int fake_texture = 0;
+  textures.y_texture = &fake_texture;
+  textures.u_texture = &fake_texture;
+  textures.v_texture = &fake_texture;
+  textures.rgba_texture = &fake_texture;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsVideoTextureUploaderSetTextures(uploader_handle, &textures));
+  textures.y_texture = nullptr;
+  textures.u_texture = nullptr;
+  textures.v_texture = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTextureUploaderSetTextures(uploader_handle, &textures));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTextureUploaderSetTextures(uploader_handle, nullptr));
+
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  uint64_t subscriber_id = 0;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceAddFrameQueueSubscriber(
+                source_handle, queue_handle, &subscriber_id));
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+
+  // Without textures, render events leave the frames in the queue
+  mrsVideoTextureRenderEventCallback callback = nullptr;
+  int32_t event_id = 0;
+  ASSERT_EQ(mrsResult::kSuccess, mrsVideoTextureUploaderGetRenderEvent(
+                                     uploader_handle, &callback, &event_id));
+  ASSERT_NE(nullptr, callback);
+  ASSERT_NE(0, event_id);
+  (*callback)(event_id);
+  mrsVideoTextureUploaderStats stats{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTextureUploaderGetStats(uploader_handle, &stats));
+  ASSERT_EQ(0u, stats.uploaded_count);
+  ASSERT_EQ(0u, stats.skipped_count);
+  ASSERT_EQ(0u, stats.cpu_converted_count);
+  mrsVideoFrameQueueStats queue_stats{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoFrameQueueGetStats(queue_handle, &queue_stats));
+  ASSERT_EQ(1u, queue_stats.queued_count);
+
+  // Render events of destroyed uploaders are ignored
+  mrsVideoTextureUploaderDestroy(uploader_handle);
+  (*callback)(event_id);
+
+  ASSERT_EQ(mrsResult::kSuccess, mrsVideoTrackSourceRemoveFrameSubscriber(
+                                     source_handle, subscriber_id));
+  mrsVideoFrameQueueDestroy(queue_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, BufferPoolStats) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  mrsExternalVideoBufferPoolStats stats{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceGetBufferPoolStats(source_handle,
+                                                          nullptr));
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceGetBufferPoolStats(
+                                     source_handle, &stats));
+  ASSERT_EQ(0u, stats.hit_count);
+  ASSERT_EQ(0u, stats.miss_count);
+
+  // Frames nobody consumes are dropped before conversion
+  mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceGetBufferPoolStats(
+                                     source_handle, &stats));
+  ASSERT_EQ(0u, stats.miss_count);
+
+  // The frame callback does not keep the frames, so after the first allocation
+  // the same buffer is reused for all frames of the same resolution.
+  Argb32VideoFrameCallback argb_cb = [](const mrsArgb32VideoFrame&) {};
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                         &frame_view, 0));
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceGetBufferPoolStats(
+                                     source_handle, &stats));
+  ASSERT_EQ(1u, stats.miss_count);
+  ASSERT_EQ(4u, stats.hit_count);
+
+  // A resolution change requires a new buffer
+  frame_view.width_ = 8;
+  frame_view.height_ = 8;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceGetBufferPoolStats(
+                                     source_handle, &stats));
+  ASSERT_EQ(2u, stats.miss_count);
+  ASSERT_EQ(4u, stats.hit_count);
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, PushNv12Frames) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  uint32_t frame_count = 0;
+  I420AVideoFrameCallback i420a_cb =
+      [&frame_count](const mrsI420AVideoFrame& frame) {
+        ASSERT_EQ(16u, frame.width_);
+        ASSERT_EQ(16u, frame.height_);
+        ASSERT_EQ(0x40, ((const uint8_t*)frame.ydata_)[0]);
+        ASSERT_EQ(0x80, ((const uint8_t*)frame.udata_)[0]);
+        ASSERT_EQ(0xC0, ((const uint8_t*)frame.vdata_)[0]);
+        ++frame_count;
+      };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420a_cb));
+
+  uint8_t ydata[256];
+  uint8_t uvdata[128];
+  memset(ydata, 0x40, sizeof(ydata));
+  for (int i = 0; i < 128; i += 2) {
+    uvdata[i] = 0x80;
+    uvdata[i + 1] = 0xC0;
+  }
+  mrsNv12VideoFrame frame_view{};
+  frame_view.width_ = 16;
+  frame_view.height_ = 16;
+  frame_view.ydata_ = ydata;
+  frame_view.uvdata_ = uvdata;
+  frame_view.ystride_ = 16;
+  frame_view.uvstride_ = 16;
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourcePushNv12Frame(
+                                     source_handle, &frame_view, 0));
+  ASSERT_EQ(1u, frame_count);
+
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+namespace {
+
+struct NativeFrameTestState {
+  int convert_count = 0;
+  int release_count = 0;
+};
+
+mrsResult MRS_CALL ConvertNativeTestFrame(void* user_data,
+                                          void* /*native_handle*/,
+                                          uint8_t* ydata,
+                                          int32_t ystride,
+                                          uint8_t* udata,
+                                          int32_t ustride,
+                                          uint8_t* vdata,
+                                          int32_t vstride) {
+  auto state = static_cast<NativeFrameTestState*>(user_data);
+  ++state->convert_count;
+  for (int i = 0; i < 16; ++i) {
+    memset(ydata + i * ystride, 0x40, 16);
+  }
+  for (int i = 0; i < 8; ++i) {
+    memset(udata + i * ustride, 0x80, 8);
+    memset(vdata + i * vstride, 0x80, 8);
+  }
+  return mrsResult::kSuccess;
+}
+
+void MRS_CALL ReleaseNativeTestFrame(void* user_data) {
+  auto state = static_cast<NativeFrameTestState*>(user_data);
+  ++state->release_count;
+}
+
+}  // namespace
+
+TEST_F(ExternalVideoTrackSourceTests, PushNativeFrames) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  NativeFrameTestState state;
+  int texture = 0;
+  mrsNativeVideoFrame frame{};
+  frame.width = 16;
+  frame.height = 16;
+  frame.native_handle = &texture;
+  frame.to_i420_callback = &ConvertNativeTestFrame;
+  frame.release_callback = &ReleaseNativeTestFrame;
+  frame.user_data = &state;
+
+  // Without any consumer reading the frame, it is never converted
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushNativeFrame(source_handle, &frame,
+                                                       0));
+  ASSERT_EQ(0, state.convert_count);
+  ASSERT_EQ(1, state.release_count);
+
+  // A frame callback needs the I420 content, converted once per frame
+  uint32_t frame_count = 0;
+  I420AVideoFrameCallback i420a_cb =
+      [&frame_count](const mrsI420AVideoFrame& i420a_frame) {
+        ASSERT_EQ(0x40, ((const uint8_t*)i420a_frame.ydata_)[0]);
+        ++frame_count;
+      };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420a_cb));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushNativeFrame(source_handle, &frame,
+                                                       0));
+  ASSERT_EQ(1u, frame_count);
+  ASSERT_EQ(1, state.convert_count);
+  ASSERT_EQ(2, state.release_count);
+
+  // Invalid frames are rejected without invoking any callback
+  frame.width = 0;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourcePushNativeFrame(source_handle, &frame,
+                                                       0));
+  ASSERT_EQ(2, state.release_count);
+
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, AndroidTextureRejectsOtherBuffers) {
+  mrsAndroidTextureFrame texture{};
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsVideoFrameBufferGetAndroidTexture(nullptr, &texture));
+
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Query the texture of each leased frame, on any platform
+  std::vector<std::pair<mrsVideoFrameBufferType, mrsResult>> results;
+  InteropCallback<const mrsVideoFrameLease&> lease_cb =
+      [&results](const mrsVideoFrameLease& lease) {
+        ASSERT_EQ(mrsResult::kInvalidParameter,
+                  mrsVideoFrameBufferGetAndroidTexture(lease.buffer_handle_,
+                                                       nullptr));
+        mrsAndroidTextureFrame texture{};
+        results.emplace_back(lease.type_,
+                             mrsVideoFrameBufferGetAndroidTexture(
+                                 lease.buffer_handle_, &texture));
+        mrsVideoFrameBufferRemoveRef(lease.buffer_handle_);
+      };
+  mrsVideoTrackSourceRegisterFrameLeaseCallback(source_handle, CB(lease_cb));
+
+  // A CPU buffer holds no texture
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+
+  // Neither does a native buffer of the application, which is not a Java
+  // buffer and must not be converted to one
+  NativeFrameTestState state;
+  int native_texture = 0;
+  mrsNativeVideoFrame frame{};
+  frame.width = 16;
+  frame.height = 16;
+  frame.native_handle = &native_texture;
+  frame.to_i420_callback = &ConvertNativeTestFrame;
+  frame.release_callback = &ReleaseNativeTestFrame;
+  frame.user_data = &state;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourcePushNativeFrame(source_handle, &frame,
+                                                       0));
+
+  ASSERT_EQ(2u, results.size());
+  ASSERT_EQ(mrsVideoFrameBufferType::kI420, results[0].first);
+  ASSERT_EQ(mrsResult::kUnsupported, results[0].second);
+  ASSERT_EQ(mrsVideoFrameBufferType::kNative, results[1].first);
+  ASSERT_EQ(mrsResult::kUnsupported, results[1].second);
+  ASSERT_EQ(0, state.convert_count);
+  ASSERT_EQ(1, state.release_count);
+
+  mrsVideoTrackSourceRegisterFrameLeaseCallback(source_handle, nullptr,
+                                                nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, SinkWants) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Frame callbacks do not constrain the frames
+  Argb32VideoFrameCallback argb_cb = [](const mrsArgb32VideoFrame&) {};
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, CB(argb_cb));
+  mrsExternalVideoSinkWants wants{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceGetSinkWants(source_handle, nullptr));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceGetSinkWants(source_handle, &wants));
+  ASSERT_EQ(0u, wants.max_pixel_count);
+  ASSERT_EQ(0u, wants.target_pixel_count);
+  ASSERT_EQ(0.0f, wants.max_framerate);
+
+  mrsVideoTrackSourceRegisterArgb32FrameCallback(source_handle, nullptr,
+                                                 nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+/// Generate a 16px by 16px test frame, and count the requests.
+mrsResult MRS_CALL
+CountQuadTestFrame(void* user_data,
+                   mrsExternalVideoTrackSourceHandle source_handle,
+                   uint32_t request_id,
+                   int64_t timestamp_ms) {
+  ++*(std::atomic<uint32_t>*)user_data;
+  return GenerateQuadTestFrame(nullptr, source_handle, request_id,
+                               timestamp_ms);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, PauseWithoutConsumers) {
+  std::atomic<uint32_t> request_count{0};
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromArgb32Callback(
+                &CountQuadTestFrame, &request_count, &source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // A local track without frame callback nor transceiver consumes no frame
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "paused_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                                 &track_handle));
+  }
+  Event ev;
+  ASSERT_FALSE(ev.WaitFor(500ms));
+  ASSERT_EQ(0u, request_count.load());
+
+  // Frames are requested again once the track has a frame callback
+  Argb32VideoFrameCallback argb_cb = [&ev](const mrsArgb32VideoFrame& frame) {
+    ValidateQuadTestFrame(frame.argb32_data_, frame.stride_, frame.width_,
+                          frame.height_);
+    ev.Set();
+  };
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, CB(argb_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+
+  // Requests pause again once the callback is removed
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, nullptr,
+                                                nullptr);
+  ev.Reset();
+  ev.WaitFor(200ms);
+  const uint32_t paused_count = request_count.load();
+  ASSERT_LT(0u, paused_count);
+  ev.WaitFor(500ms);
+  ASSERT_EQ(paused_count, request_count.load());
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, ContentHint) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+
+  // Hints can be set before and after capture started
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceSetContentHint(
+                source_handle, mrsVideoContentHint::kText, mrsOptBool::kFalse));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceSetContentHint(
+                                     source_handle, mrsVideoContentHint::kMotion,
+                                     mrsOptBool::kUnset));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceSetContentHint(
+                source_handle, (mrsVideoContentHint)42, mrsOptBool::kUnset));
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsExternalVideoTrackSourceSetContentHint(
+                nullptr, mrsVideoContentHint::kNone, mrsOptBool::kUnset));
+
+  // Tracks override the hint of their source
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "hinted_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                                 &track_handle));
+  }
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackSetContentHint(track_handle,
+                                             mrsVideoContentHint::kDetail));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLocalVideoTrackSetContentHint(track_handle,
+                                             (mrsVideoContentHint)42));
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, FrameHeightRoundMode) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateForPush(&source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  mrsLocalVideoTrackInitSettings settings{};
+  settings.track_name = "rounded_track";
+  settings.frame_height_round_mode = (FrameHeightRoundMode)42;
+  mrsLocalVideoTrackHandle track_handle{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                               &track_handle));
+
+  // 16x24 frames are cropped to 16x16, or padded to 16x32
+  std::vector<uint32_t> pixels(16 * 24);
+  FillSquareArgb32(pixels.data(), 0, 0, 16, 24, 64, kRed);
+  mrsArgb32VideoFrame frame_view{};
+  frame_view.width_ = 16;
+  frame_view.height_ = 24;
+  frame_view.argb32_data_ = pixels.data();
+  frame_view.stride_ = 16 * 4;
+  const std::pair<FrameHeightRoundMode, uint32_t> modes[] = {
+      {FrameHeightRoundMode::kNone, 24},
+      {FrameHeightRoundMode::kCrop, 16},
+      {FrameHeightRoundMode::kPad, 32}};
+  for (const auto& mode : modes) {
+    settings.frame_height_round_mode = mode.first;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                                 &track_handle));
+    Event ev;
+    I420AVideoFrameCallback i420a_cb = [&](const mrsI420AVideoFrame& frame) {
+      ASSERT_EQ(16u, frame.width_);
+      ASSERT_EQ(mode.second, frame.height_);
+      // The edge rows are replicated into the padding
+      const uint8_t* const y = (const uint8_t*)frame.ydata_;
+      ASSERT_EQ(y[(frame.height_ / 2) * frame.ystride_], y[0]);
+      ASSERT_EQ(y[(frame.height_ / 2) * frame.ystride_],
+                y[(frame.height_ - 1) * frame.ystride_]);
+      ev.Set();
+    };
+    mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(i420a_cb));
+    i420a_cb.is_registered_ = true;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                         &frame_view, 0));
+    ASSERT_TRUE(ev.WaitFor(5s));
+    mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr,
+                                                 nullptr);
+    i420a_cb.is_registered_ = false;
+    mrsRefCountedObjectRemoveRef(track_handle);
+  }
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, PushFramesRequiresPushSource) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromArgb32Callback(
+                &GenerateQuadTestFrame, nullptr, &source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  const mrsArgb32VideoFrame frame_view = FillQuadTestFrame();
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsExternalVideoTrackSourcePushArgb32Frame(source_handle,
+                                                       &frame_view, 0));
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_F(ExternalVideoTrackSourceTests, SyntheticSource) {
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  mrsSyntheticVideoSourceConfig config{};
+  config.width = 0;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceCreateSynthetic(&config,
+                                                       &source_handle));
+  config.width = 64;
+  config.height = 48;
+  config.complexity = (mrsSyntheticVideoComplexity)42;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsExternalVideoTrackSourceCreateSynthetic(&config,
+                                                       &source_handle));
+
+  for (auto complexity : {mrsSyntheticVideoComplexity::kStatic,
+                          mrsSyntheticVideoComplexity::kModerateMotion,
+                          mrsSyntheticVideoComplexity::kNoise}) {
+    config.complexity = complexity;
+    ASSERT_EQ(mrsResult::kSuccess, mrsExternalVideoTrackSourceCreateSynthetic(
+                                       &config, &source_handle));
+    mrsExternalVideoTrackSourceSettings settings{};
+    settings.framerate = 60.0f;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceConfigure(source_handle, &settings));
+    mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+    // Frames of moving sources differ from one another
+    Event frames_ev;
+    std::atomic_uint32_t frame_count{0};
+    std::atomic_uint32_t changed_count{0};
+    uint8_t last_pixel = 0;
+    I420AVideoFrameCallback i420a_cb = [&](const mrsI420AVideoFrame& frame) {
+      ASSERT_EQ(64u, frame.width_);
+      ASSERT_EQ(48u, frame.height_);
+      const uint8_t pixel = ((const uint8_t*)frame.ydata_)[0];
+      if (complexity == mrsSyntheticVideoComplexity::kStatic) {
+        ASSERT_EQ(235, pixel);  // White bar
+      }
+      if ((frame_count > 0) && (pixel != last_pixel)) {
+        ++changed_count;
+      }
+      last_pixel = pixel;
+      if (++frame_count == 10) {
+        frames_ev.Set();
+      }
+    };
+    mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420a_cb));
+    ASSERT_TRUE(frames_ev.WaitFor(5s));
+    mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+    if (complexity == mrsSyntheticVideoComplexity::kStatic) {
+      ASSERT_EQ(0u, changed_count.load());
+    } else {
+      ASSERT_LT(0u, changed_count.load());
+    }
+    mrsExternalVideoTrackSourceShutdown(source_handle);
+    mrsRefCountedObjectRemoveRef(source_handle);
+  }
+}
+
+TEST_F(ExternalVideoTrackSourceTests, SharedMemoryFrames) {
+  // Act as the producer process, with a ring of 2 slots of 16x16 frames
+  constexpr uint32_t kSlotCount = 2;
+  constexpr uint32_t kSlotSize = 512;
+  constexpr uint32_t kHeaderSize = 64;
+  const HANDLE mapping = ::CreateFileMappingW(
+      INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+      kHeaderSize + kSlotCount * kSlotSize, L"mrsTestSharedFrameRing");
+  ASSERT_NE(nullptr, mapping);
+  auto view = static_cast<uint8_t*>(
+      ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+  ASSERT_NE(nullptr, view);
+  auto ring = reinterpret_cast<mrsSharedFrameRingHeader*>(view);
+  ring->magic = kMrsSharedFrameRingMagic;
+  ring->version = kMrsSharedFrameRingVersion;
+  ring->header_size = kHeaderSize;
+  ring->slot_count = kSlotCount;
+  ring->slot_size = kSlotSize;
+  const HANDLE doorbell =
+      ::CreateEventW(nullptr, FALSE, FALSE, L"mrsTestSharedFrameDoorbell");
+  ASSERT_NE(nullptr, doorbell);
+
+  mrsExternalVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(mrsResult::kNotFound,
+            mrsExternalVideoTrackSourceCreateFromSharedMemory(
+                "mrsTestMissingRing", "mrsTestSharedFrameDoorbell",
+                &source_handle));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromSharedMemory(
+                "mrsTestSharedFrameRing", "mrsTestSharedFrameDoorbell",
+                &source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  Event frame_ev;
+  uint32_t frame_count = 0;
+  I420AVideoFrameCallback i420a_cb = [&](const mrsI420AVideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    ASSERT_EQ(0x40, ((const uint8_t*)frame.ydata_)[0]);
+    ASSERT_EQ(0x80, ((const uint8_t*)frame.udata_)[0]);
+    ++frame_count;
+    frame_ev.Set();
+  };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420a_cb));
+
+  // Write a frame to the first slot, without copy on the consumer side
+  uint8_t* const slot_data = view + kHeaderSize;
+  auto slot = reinterpret_cast<mrsSharedFrameSlotHeader*>(slot_data);
+  slot->width = 16;
+  slot->height = 16;
+  slot->yoffset = 64;
+  slot->uoffset = slot->yoffset + 256;
+  slot->voffset = slot->uoffset + 64;
+  slot->ystride = 16;
+  slot->ustride = 8;
+  slot->vstride = 8;
+  slot->sequence = 1;
+  memset(slot_data + slot->yoffset, 0x40, 256);
+  memset(slot_data + slot->uoffset, 0x80, 128);
+  ::InterlockedExchange(reinterpret_cast<volatile LONG*>(&slot->state),
+                        (LONG)mrsSharedFrameSlotState::kReady);
+  ::SetEvent(doorbell);
+  ASSERT_TRUE(frame_ev.WaitFor(5s));
+  ASSERT_EQ(1u, frame_count);
+
+  // The slot is handed back to the producer once the frame is released
+  for (int i = 0; i < 100; ++i) {
+    if (slot->state == (uint32_t)mrsSharedFrameSlotState::kFree) {
+      break;
+    }
+    ::Sleep(10);
+  }
+  ASSERT_EQ((uint32_t)mrsSharedFrameSlotState::kFree, slot->state);
+
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ::CloseHandle(doorbell);
+  ::UnmapViewOfFile(view);
+  ::CloseHandle(mapping);
+}
+
 #endif  // MRSW_EXCLUDE_DEVICE_TESTS
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <vector>
+
+#include "media/base/videocommon.h"
+
+#include "media/device_video_track_source.h"
+
+#define GTEST_LANG_CXX11 1
+#include "gtest/gtest.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+cricket::VideoFormat MakeFormat(int width,
+                                int height,
+                                int fps,
+                                uint32_t fourcc) {
+  return cricket::VideoFormat(width, height,
+                              cricket::VideoFormat::FpsToInterval(fps), fourcc);
+}
+
+mrsLocalVideoDeviceInitConfig MakeConfig(uint32_t width,
+                                         uint32_t height,
+                                         double framerate) {
+  mrsLocalVideoDeviceInitConfig config{};
+  config.width = width;
+  config.height = height;
+  config.framerate = framerate;
+  config.prefer_native_format = mrsBool::kTrue;
+  return config;
+}
+
+/// Select a format among |formats| for |config|, expecting one to be found.
+cricket::VideoFormat Select(const std::vector<cricket::VideoFormat>& formats,
+                            const mrsLocalVideoDeviceInitConfig& config) {
+  cricket::VideoFormat format;
+  EXPECT_TRUE(DeviceVideoTrackSource::SelectNativeCaptureFormat(
+      formats, config, format));
+  return format;
+}
+
+}  // namespace
+
+TEST(DeviceVideoTrackSourceTests, SelectNativeCaptureFormatNone) {
+  cricket::VideoFormat format = MakeFormat(320, 240, 15, cricket::FOURCC_I420);
+  const cricket::VideoFormat before = format;
+  ASSERT_FALSE(DeviceVideoTrackSource::SelectNativeCaptureFormat(
+      {}, MakeConfig(640, 480, 30.0), format));
+  ASSERT_EQ(before, format);
+}
+
+TEST(DeviceVideoTrackSourceTests, SelectNativeCaptureFormatCheapest) {
+  // Among formats of the requested resolution and framerate, the one with the
+  // cheapest conversion to I420 is selected, whatever their order
+  const mrsLocalVideoDeviceInitConfig config = MakeConfig(1280, 720, 30.0);
+  const cricket::VideoFormat mjpg =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_MJPG);
+  const cricket::VideoFormat argb =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_ARGB);
+  const cricket::VideoFormat yuy2 =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_YUY2);
+  const cricket::VideoFormat nv12 =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_NV12);
+  const cricket::VideoFormat i420 =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_I420);
+  ASSERT_EQ(argb, Select({mjpg, argb}, config));
+  ASSERT_EQ(yuy2, Select({mjpg, argb, yuy2}, config));
+  ASSERT_EQ(nv12, Select({mjpg, yuy2, nv12, argb}, config));
+  ASSERT_EQ(nv12, Select({nv12, mjpg}, config));
+  ASSERT_EQ(i420, Select({mjpg, nv12, i420, yuy2}, config));
+}
+
+TEST(DeviceVideoTrackSourceTests, SelectNativeCaptureFormatResolutionFirst) {
+  // The resolution and framerate requested come before the conversion cost
+  const cricket::VideoFormat mjpg_720p =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_MJPG);
+  const cricket::VideoFormat nv12_480p =
+      MakeFormat(640, 480, 30, cricket::FOURCC_NV12);
+  const cricket::VideoFormat nv12_720p_15 =
+      MakeFormat(1280, 720, 15, cricket::FOURCC_NV12);
+  const std::vector<cricket::VideoFormat> formats{nv12_480p, mjpg_720p,
+                                                  nv12_720p_15};
+  ASSERT_EQ(mjpg_720p, Select(formats, MakeConfig(1280, 720, 30.0)));
+  ASSERT_EQ(nv12_720p_15, Select(formats, MakeConfig(1280, 720, 15.0)));
+  ASSERT_EQ(nv12_480p, Select(formats, MakeConfig(640, 480, 30.0)));
+
+  // Without an exact match, the closest resolution is selected
+  ASSERT_EQ(nv12_480p, Select(formats, MakeConfig(800, 600, 30.0)));
+  ASSERT_EQ(mjpg_720p, Select(formats, MakeConfig(1920, 1080, 30.0)));
+}
+
+TEST(DeviceVideoTrackSourceTests, SelectNativeCaptureFormatDefaults) {
+  // An unspecified resolution and framerate default to 640x480 at 30 fps,
+  // like the capturer without constraints
+  const cricket::VideoFormat nv12_720p =
+      MakeFormat(1280, 720, 30, cricket::FOURCC_NV12);
+  const cricket::VideoFormat mjpg_480p_15 =
+      MakeFormat(640, 480, 15, cricket::FOURCC_MJPG);
+  const cricket::VideoFormat mjpg_480p_30 =
+      MakeFormat(640, 480, 30, cricket::FOURCC_MJPG);
+  ASSERT_EQ(mjpg_480p_30, Select({nv12_720p, mjpg_480p_15, mjpg_480p_30},
+                                 MakeConfig(0, 0, 0.0)));
+
+  // Only the unspecified values default
+  ASSERT_EQ(nv12_720p, Select({nv12_720p, mjpg_480p_15, mjpg_480p_30},
+                              MakeConfig(1280, 0, 0.0)));
+  ASSERT_EQ(mjpg_480p_15, Select({nv12_720p, mjpg_480p_15, mjpg_480p_30},
+                                 MakeConfig(0, 0, 15.0)));
+}
+
+TEST(DeviceVideoTrackSourceTests, SelectNativeCaptureFormatHighestFramerate) {
+  // Between framerates as close to the requested one, with the same
+  // conversion cost, the highest is selected
+  const cricket::VideoFormat nv12_25 =
+      MakeFormat(640, 480, 25, cricket::FOURCC_NV12);
+  const cricket::VideoFormat nv12_35 =
+      MakeFormat(640, 480, 35, cricket::FOURCC_NV12);
+  ASSERT_EQ(nv12_35, Select({nv12_25, nv12_35}, MakeConfig(640, 480, 30.0)));
+  ASSERT_EQ(nv12_35, Select({nv12_35, nv12_25}, MakeConfig(640, 480, 30.0)));
+}
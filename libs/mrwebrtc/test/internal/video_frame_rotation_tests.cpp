@@ -0,0 +1,282 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "rtc_base/timeutils.h"
+
+#include "video_frame_observer.h"
+
+#define GTEST_LANG_CXX11 1
+#include "gtest/gtest.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+constexpr int kWidth = 8;
+constexpr int kHeight = 4;
+
+/// Frame observer fed directly with frames, as a video source would.
+class TestFrameObserver : public VideoFrameObserver {
+ public:
+  using VideoFrameObserver::OnFrame;
+};
+
+/// Tightly packed copy of a plane of a delivered frame.
+struct Plane {
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> data_;
+
+  void Copy(const void* data, int stride, int width, int height) {
+    width_ = width;
+    height_ = height;
+    data_.clear();
+    for (int j = 0; j < height; ++j) {
+      const uint8_t* row = (const uint8_t*)data + (size_t)j * stride;
+      data_.insert(data_.end(), row, row + width);
+    }
+  }
+  uint8_t At(int x, int y) const { return data_[(size_t)y * width_ + x]; }
+};
+
+/// Last frame delivered to each callback.
+struct DeliveredFrames {
+  int i420a_count_ = 0;
+  VideoRotation i420a_rotation_ = VideoRotation::k0;
+  Plane y_, u_, v_;
+
+  int argb_count_ = 0;
+  VideoRotation argb_rotation_ = VideoRotation::k0;
+  int argb_width_ = 0;
+  int argb_height_ = 0;
+  std::vector<uint32_t> argb_;
+
+  int nv12_count_ = 0;
+  VideoRotation nv12_rotation_ = VideoRotation::k0;
+  Plane nv12_y_, nv12_uv_;
+
+  uint32_t ArgbAt(int x, int y) const {
+    return argb_[(size_t)y * argb_width_ + x];
+  }
+};
+
+void MRS_CALL OnI420AFrame(void* user_data, const I420AVideoFrame& frame) {
+  auto* const frames = static_cast<DeliveredFrames*>(user_data);
+  ++frames->i420a_count_;
+  frames->i420a_rotation_ = frame.rotation_;
+  const int chroma_width = ((int)frame.width_ + 1) / 2;
+  const int chroma_height = ((int)frame.height_ + 1) / 2;
+  frames->y_.Copy(frame.ydata_, frame.ystride_, frame.width_, frame.height_);
+  frames->u_.Copy(frame.udata_, frame.ustride_, chroma_width, chroma_height);
+  frames->v_.Copy(frame.vdata_, frame.vstride_, chroma_width, chroma_height);
+}
+
+void MRS_CALL OnArgb32Frame(void* user_data, const Argb32VideoFrame& frame) {
+  auto* const frames = static_cast<DeliveredFrames*>(user_data);
+  ++frames->argb_count_;
+  frames->argb_rotation_ = frame.rotation_;
+  frames->argb_width_ = frame.width_;
+  frames->argb_height_ = frame.height_;
+  frames->argb_.clear();
+  for (uint32_t j = 0; j < frame.height_; ++j) {
+    const uint32_t* row = (const uint32_t*)((const uint8_t*)frame.argb32_data_ +
+                                            (size_t)j * frame.stride_);
+    frames->argb_.insert(frames->argb_.end(), row, row + frame.width_);
+  }
+}
+
+void MRS_CALL OnNv12Frame(void* user_data, const Nv12VideoFrame& frame) {
+  auto* const frames = static_cast<DeliveredFrames*>(user_data);
+  ++frames->nv12_count_;
+  frames->nv12_rotation_ = frame.rotation_;
+  frames->nv12_y_.Copy(frame.ydata_, frame.ystride_, frame.width_,
+                       frame.height_);
+  frames->nv12_uv_.Copy(frame.uvdata_, frame.uvstride_,
+                        ((frame.width_ + 1) / 2) * 2, (frame.height_ + 1) / 2);
+}
+
+/// Create a |kWidth| x |kHeight| frame with a distinct value for each sample
+/// of each plane, to locate each sample after rotation.
+rtc::scoped_refptr<webrtc::I420Buffer> CreateTestBuffer() {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(kWidth, kHeight);
+  for (int j = 0; j < kHeight; ++j) {
+    for (int i = 0; i < kWidth; ++i) {
+      buffer->MutableDataY()[j * buffer->StrideY() + i] =
+          (uint8_t)(16 + 3 * (j * kWidth + i));
+    }
+  }
+  for (int j = 0; j < kHeight / 2; ++j) {
+    for (int i = 0; i < kWidth / 2; ++i) {
+      const int index = j * (kWidth / 2) + i;
+      buffer->MutableDataU()[j * buffer->StrideU() + i] =
+          (uint8_t)(100 + 4 * index);
+      buffer->MutableDataV()[j * buffer->StrideV() + i] =
+          (uint8_t)(160 - 4 * index);
+    }
+  }
+  return buffer;
+}
+
+void DeliverTestFrame(TestFrameObserver& observer,
+                      const rtc::scoped_refptr<webrtc::I420Buffer>& buffer,
+                      webrtc::VideoRotation rotation) {
+  static int64_t timestamp_us = rtc::TimeMicros();
+  timestamp_us += 33333;
+  observer.OnFrame(webrtc::VideoFrame::Builder()
+                       .set_video_frame_buffer(buffer)
+                       .set_timestamp_us(timestamp_us)
+                       .set_rotation(rotation)
+                       .build());
+}
+
+/// Map the coordinates of a sample of the upright frame rotated clockwise by
+/// |rotation| to the coordinates of that sample in the frame as produced, of
+/// size |width| x |height|.
+void MapToSource(VideoRotation rotation,
+                 int width,
+                 int height,
+                 int x,
+                 int y,
+                 int& src_x,
+                 int& src_y) {
+  if (rotation == VideoRotation::k90) {
+    src_x = y;
+    src_y = height - 1 - x;
+  } else {
+    src_x = width - 1 - y;
+    src_y = x;
+  }
+}
+
+void ExpectRotatedPlane(const Plane& source,
+                        const Plane& rotated,
+                        VideoRotation rotation) {
+  ASSERT_EQ(source.height_, rotated.width_);
+  ASSERT_EQ(source.width_, rotated.height_);
+  for (int y = 0; y < rotated.height_; ++y) {
+    for (int x = 0; x < rotated.width_; ++x) {
+      int src_x, src_y;
+      MapToSource(rotation, source.width_, source.height_, x, y, src_x, src_y);
+      ASSERT_EQ(source.At(src_x, src_y), rotated.At(x, y))
+          << "Sample (" << x << ", " << y << ")";
+    }
+  }
+}
+
+/// Check that two ARGB32 colors differ by at most 1 per component.
+void ExpectSameColor(uint32_t expected, uint32_t actual) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    const int a = (int)((expected >> shift) & 0xFFu);
+    const int b = (int)((actual >> shift) & 0xFFu);
+    ASSERT_LE(std::abs(a - b), 1) << std::hex << expected << " " << actual;
+  }
+}
+
+class VideoFrameRotationTests
+    : public testing::TestWithParam<webrtc::VideoRotation> {
+ protected:
+  void SetUp() override {
+    observer_.SetCallback(I420AFrameReadyCallback{&OnI420AFrame, &frames_});
+    observer_.SetCallback(Argb32FrameReadyCallback{&OnArgb32Frame, &frames_});
+    observer_.SetCallback(Nv12FrameReadyCallback{&OnNv12Frame, &frames_});
+  }
+  void TearDown() override {
+    observer_.SetCallback(I420AFrameReadyCallback{});
+    observer_.SetCallback(Argb32FrameReadyCallback{});
+    observer_.SetCallback(Nv12FrameReadyCallback{});
+  }
+
+  TestFrameObserver observer_;
+  DeliveredFrames frames_;
+};
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(,
+                        VideoFrameRotationTests,
+                        testing::Values(webrtc::kVideoRotation_90,
+                                        webrtc::kVideoRotation_270));
+
+TEST_P(VideoFrameRotationTests, RotationPassedThrough) {
+  const VideoRotation rotation = static_cast<VideoRotation>(GetParam());
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer = CreateTestBuffer();
+  DeliverTestFrame(observer_, buffer, GetParam());
+
+  // The frames are delivered as produced, along with their rotation
+  ASSERT_EQ(1, frames_.i420a_count_);
+  ASSERT_EQ(rotation, frames_.i420a_rotation_);
+  ASSERT_EQ(kWidth, frames_.y_.width_);
+  ASSERT_EQ(kHeight, frames_.y_.height_);
+  for (int j = 0; j < kHeight; ++j) {
+    for (int i = 0; i < kWidth; ++i) {
+      ASSERT_EQ(buffer->DataY()[j * buffer->StrideY() + i],
+                frames_.y_.At(i, j));
+    }
+  }
+  ASSERT_EQ(1, frames_.argb_count_);
+  ASSERT_EQ(rotation, frames_.argb_rotation_);
+  ASSERT_EQ(kWidth, frames_.argb_width_);
+  ASSERT_EQ(kHeight, frames_.argb_height_);
+  ASSERT_EQ(1, frames_.nv12_count_);
+  ASSERT_EQ(rotation, frames_.nv12_rotation_);
+  ASSERT_EQ(kWidth, frames_.nv12_y_.width_);
+  ASSERT_EQ(kHeight, frames_.nv12_y_.height_);
+}
+
+TEST_P(VideoFrameRotationTests, ApplyRotation) {
+  const VideoRotation rotation = static_cast<VideoRotation>(GetParam());
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer = CreateTestBuffer();
+
+  // Reference frames delivered as produced
+  DeliverTestFrame(observer_, buffer, webrtc::kVideoRotation_0);
+  const DeliveredFrames reference = frames_;
+  ASSERT_EQ(kWidth, reference.argb_width_);
+  ASSERT_EQ(kHeight, reference.argb_height_);
+
+  VideoFrameDeliveryOptions options{};
+  options.apply_rotation_ = true;
+  observer_.SetDeliveryOptions(options);
+  DeliverTestFrame(observer_, buffer, GetParam());
+
+  // All formats are upright, with swapped dimensions, and each sample moved
+  // to its rotated location
+  ASSERT_EQ(2, frames_.i420a_count_);
+  ASSERT_EQ(VideoRotation::k0, frames_.i420a_rotation_);
+  ExpectRotatedPlane(reference.y_, frames_.y_, rotation);
+  ExpectRotatedPlane(reference.u_, frames_.u_, rotation);
+  ExpectRotatedPlane(reference.v_, frames_.v_, rotation);
+
+  ASSERT_EQ(2, frames_.argb_count_);
+  ASSERT_EQ(VideoRotation::k0, frames_.argb_rotation_);
+  ASSERT_EQ(kHeight, frames_.argb_width_);
+  ASSERT_EQ(kWidth, frames_.argb_height_);
+  for (int y = 0; y < kWidth; ++y) {
+    for (int x = 0; x < kHeight; ++x) {
+      int src_x, src_y;
+      MapToSource(rotation, kWidth, kHeight, x, y, src_x, src_y);
+      ExpectSameColor(reference.ArgbAt(src_x, src_y), frames_.ArgbAt(x, y));
+    }
+  }
+
+  ASSERT_EQ(2, frames_.nv12_count_);
+  ASSERT_EQ(VideoRotation::k0, frames_.nv12_rotation_);
+  ExpectRotatedPlane(reference.nv12_y_, frames_.nv12_y_, rotation);
+  ASSERT_EQ(kHeight, frames_.nv12_uv_.width_);
+  ASSERT_EQ(kWidth / 2, frames_.nv12_uv_.height_);
+  for (int y = 0; y < kWidth / 2; ++y) {
+    for (int x = 0; x < kHeight / 2; ++x) {
+      int src_x, src_y;
+      MapToSource(rotation, kWidth / 2, kHeight / 2, x, y, src_x, src_y);
+      ASSERT_EQ(reference.u_.At(src_x, src_y), frames_.nv12_uv_.At(2 * x, y));
+      ASSERT_EQ(reference.v_.At(src_x, src_y),
+                frames_.nv12_uv_.At(2 * x + 1, y));
+    }
+  }
+}
@@ -3,10 +3,61 @@
 
 #include "pch.h"
 
+#include <thread>
+#include <vector>
+
+#include "external_audio_track_source_interop.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
+#include "log_sink_interop.h"
+#include "object_interop.h"
+#include "peer_connection_interop.h"
+#include "transceiver_interop.h"
+
+#include "peer_connection_test_helpers.h"
 #include "video_test_utils.h"
 
+namespace {
+
+/// Create an offer with an audio media line and return its DTLS fingerprint.
+std::string GetOfferFingerprint(mrsPeerConnectionHandle handle) {
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  if (mrsPeerConnectionAddTransceiver(handle, &transceiver_config,
+                                      &transceiver_handle) !=
+      mrsResult::kSuccess) {
+    return {};
+  }
+  std::string offer;
+  Event offer_ev;
+  SdpCallback sdp_cb(handle, [&offer, &offer_ev](mrsSdpMessageType,
+                                                 const char* sdp_data) {
+    offer = sdp_data;
+    offer_ev.Set();
+  });
+  if ((mrsPeerConnectionCreateOffer(handle) != mrsResult::kSuccess) ||
+      !offer_ev.WaitFor(10s)) {
+    return {};
+  }
+  const size_t begin = offer.find("a=fingerprint:");
+  if (begin == std::string::npos) {
+    return {};
+  }
+  return offer.substr(begin, offer.find('\r', begin) - begin);
+}
+
+}  // namespace
+
+void MRS_CALL CountLogMessage(void* user_data,
+                              mrsLogLevel /*level*/,
+                              const char* module,
+                              const char* message) {
+  ASSERT_NE(nullptr, module);
+  ASSERT_NE(nullptr, message);
+  ++*static_cast<std::atomic<int>*>(user_data);
+}
+
 TEST(LibraryTests, SetShutdownOptions) {
   ASSERT_EQ(0u, mrsReportLiveObjects());
   auto const initial_options = mrsGetShutdownOptions();
@@ -30,6 +81,151 @@ TEST(LibraryTests, ReportLiveObjects) {
   ASSERT_EQ(0u, mrsReportLiveObjects());
 }
 
+TEST(LibraryTests, GetMemoryReport) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsGetMemoryReport(nullptr));
+  mrsResetMemoryReportPeaks();
+  mrsMemoryReport report{};
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(0u, report.external_video_track_sources.current);
+  ASSERT_EQ(0u, report.external_video_track_sources.peak);
+
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(1u, report.external_video_track_sources.current);
+  ASSERT_EQ(1u, report.external_video_track_sources.peak);
+  ASSERT_EQ(0u, report.peer_connections.current);
+
+  // The peak remains after the object is destroyed, until reset.
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(0u, report.external_video_track_sources.current);
+  ASSERT_EQ(1u, report.external_video_track_sources.peak);
+  mrsResetMemoryReportPeaks();
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(0u, report.external_video_track_sources.peak);
+  ASSERT_LE(report.frame_buffers.current_bytes, report.frame_buffers.peak_bytes);
+}
+
+TEST(LibraryTests, ManyLiveObjects) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsResetMemoryReportPeaks();
+
+  // Create objects of two types concurrently from several threads, each
+  // tagging its objects with their index to look them up later.
+  constexpr int kThreadCount = 4;
+  constexpr int kObjectsPerThread = 256;
+  constexpr int kObjectCount = kThreadCount * kObjectsPerThread;
+  std::vector<mrsExternalVideoTrackSourceHandle> video_sources(kObjectCount);
+  std::vector<mrsExternalAudioTrackSourceHandle> audio_sources(kObjectCount);
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; ++t) {
+      threads.emplace_back([&, t]() {
+        for (int i = t * kObjectsPerThread; i < (t + 1) * kObjectsPerThread;
+             ++i) {
+          ASSERT_EQ(mrsResult::kSuccess,
+                    mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                        &VideoTestUtils::MakeTestFrame, nullptr,
+                        &video_sources[i]));
+          mrsExternalVideoTrackSourceFinishCreation(video_sources[i]);
+          mrsObjectSetUserData(video_sources[i], &video_sources[i]);
+          mrsExternalAudioTrackSourceSettings settings{};
+          ASSERT_EQ(mrsResult::kSuccess, mrsExternalAudioTrackSourceCreate(
+                                             &settings, &audio_sources[i]));
+          mrsObjectSetUserData(audio_sources[i], &audio_sources[i]);
+        }
+      });
+    }
+    for (auto&& thread : threads) {
+      thread.join();
+    }
+  }
+  const uint32_t count = kObjectCount;
+  mrsMemoryReport report{};
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(count, report.external_video_track_sources.current);
+  ASSERT_EQ(count, report.external_video_track_sources.peak);
+  ASSERT_EQ(count, report.external_audio_track_sources.current);
+  ASSERT_EQ(count, report.external_audio_track_sources.peak);
+  ASSERT_EQ(0u, report.peer_connections.current);
+  ASSERT_EQ(2 * count, mrsReportLiveObjects());
+  for (int i = 0; i < kObjectCount; ++i) {
+    ASSERT_EQ(&video_sources[i], mrsObjectGetUserData(video_sources[i]));
+    ASSERT_EQ(&audio_sources[i], mrsObjectGetUserData(audio_sources[i]));
+  }
+
+  // Remove every other video source, in reverse creation order, while the
+  // other threads keep the remaining objects of both types alive and look
+  // them up.
+  {
+    std::thread remover([&]() {
+      for (int i = kObjectCount - 1; i >= 0; i -= 2) {
+        mrsRefCountedObjectRemoveRef(video_sources[i]);
+        video_sources[i] = nullptr;
+      }
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < kThreadCount; ++t) {
+      readers.emplace_back([&, t]() {
+        for (int i = t * kObjectsPerThread; i < (t + 1) * kObjectsPerThread;
+             ++i) {
+          ASSERT_EQ(&audio_sources[i], mrsObjectGetUserData(audio_sources[i]));
+          mrsMemoryReport partial{};
+          ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&partial));
+          ASSERT_EQ(count,
+                    partial.external_audio_track_sources.current);
+          ASSERT_LE(count / 2,
+                    partial.external_video_track_sources.current);
+        }
+      });
+    }
+    remover.join();
+    for (auto&& thread : readers) {
+      thread.join();
+    }
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(count / 2,
+            report.external_video_track_sources.current);
+  ASSERT_EQ(count, report.external_video_track_sources.peak);
+  ASSERT_EQ(count, report.external_audio_track_sources.current);
+  ASSERT_EQ(3 * count / 2, mrsReportLiveObjects());
+  for (int i = 0; i < kObjectCount; i += 2) {
+    ASSERT_EQ(&video_sources[i], mrsObjectGetUserData(video_sources[i]));
+  }
+
+  // Remove all the remaining objects concurrently, each thread interleaving
+  // both types.
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; ++t) {
+      threads.emplace_back([&, t]() {
+        for (int i = t * kObjectsPerThread; i < (t + 1) * kObjectsPerThread;
+             ++i) {
+          if (video_sources[i]) {
+            mrsRefCountedObjectRemoveRef(video_sources[i]);
+          }
+          mrsRefCountedObjectRemoveRef(audio_sources[i]);
+        }
+      });
+    }
+    for (auto&& thread : threads) {
+      thread.join();
+    }
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsGetMemoryReport(&report));
+  ASSERT_EQ(0u, report.external_video_track_sources.current);
+  ASSERT_EQ(0u, report.external_audio_track_sources.current);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsResetMemoryReportPeaks();
+}
+
 TEST(LibraryTests, ForceShutdown) {
   // Disable kDebugBreakOnForceShutdown; debug break makes the test fail
   mrsSetShutdownOptions(mrsShutdownOptions::kNone);
@@ -44,3 +240,310 @@ TEST(LibraryTests, ForceShutdown) {
   mrsForceShutdown();
   ASSERT_EQ(0u, mrsReportLiveObjects());
 }
+
+namespace {
+
+void* MRS_CALL CountFactoryCreation(void* user_data) {
+  ++*static_cast<int*>(user_data);
+  return nullptr;  // built-in codecs only
+}
+
+}  // namespace
+
+TEST(LibraryTests, SetVideoCodecFactories) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  int count = 0;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsSetVideoCodecFactories(&CountFactoryCreation,
+                                      &CountFactoryCreation, &count));
+
+  // The factories are created when the library initializes, and cannot change
+  // while it is initialized.
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  ASSERT_EQ(2, count);
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsSetVideoCodecFactories(nullptr, nullptr, nullptr));
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsSetVideoCodecFactories(nullptr, nullptr, nullptr));
+}
+
+TEST(LibraryTests, SetThreadGroups) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Invalid arguments
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsSetThreadGroups(nullptr, 1));
+  mrsThreadGroupConfig groups[2]{};
+  groups[0].worker_thread.priority = (mrsThreadPriority)42;
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsSetThreadGroups(groups, 2));
+
+  groups[0].worker_thread.priority = mrsThreadPriority::kHigh;
+  groups[0].worker_thread.affinity_mask = 0x1;
+  groups[1].network_thread.priority = mrsThreadPriority::kLow;
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetThreadGroups(groups, 2));
+
+  // Peer connections can be assigned to any existing group, and the groups
+  // cannot change while the library is initialized.
+  mrsPeerConnectionConfiguration pc_config{};
+  mrsPeerConnectionHandle handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle1));
+  ASSERT_NE(nullptr, handle1);
+  pc_config.thread_group = 1;
+  mrsPeerConnectionHandle handle2 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle2));
+  ASSERT_NE(nullptr, handle2);
+  pc_config.thread_group = 2;
+  mrsPeerConnectionHandle handle3 = nullptr;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsPeerConnectionCreate(&pc_config, &handle3));
+  ASSERT_EQ(nullptr, handle3);
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsSetThreadGroups(nullptr, 0));
+  mrsRefCountedObjectRemoveRef(handle1);
+  mrsRefCountedObjectRemoveRef(handle2);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetThreadGroups(nullptr, 0));
+}
+
+TEST(LibraryTests, SetCertificatePoolConfig) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Invalid arguments
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsSetCertificatePoolConfig(nullptr));
+  mrsCertificatePoolConfig pool_config{};
+  pool_config.pool_size = 1000;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsSetCertificatePoolConfig(&pool_config));
+  pool_config.pool_size = 4;
+  pool_config.key_type = (mrsCertificateKeyType)42;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsSetCertificatePoolConfig(&pool_config));
+
+  pool_config.key_type = mrsCertificateKeyType::kEcdsa;
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetCertificatePoolConfig(&pool_config));
+
+  // Connections to the same identity share their certificate, while others
+  // each take their own from the pool.
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.certificate_identity = "remote_peer";
+  mrsPeerConnectionHandle handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle1));
+  mrsPeerConnectionHandle handle2 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle2));
+  pc_config.certificate_identity = nullptr;
+  mrsPeerConnectionHandle handle3 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle3));
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsSetCertificatePoolConfig(&pool_config));
+
+  const std::string fingerprint1 = GetOfferFingerprint(handle1);
+  const std::string fingerprint2 = GetOfferFingerprint(handle2);
+  const std::string fingerprint3 = GetOfferFingerprint(handle3);
+  ASSERT_FALSE(fingerprint1.empty());
+  ASSERT_EQ(fingerprint1, fingerprint2);
+  ASSERT_FALSE(fingerprint3.empty());
+  ASSERT_NE(fingerprint1, fingerprint3);
+
+  mrsRefCountedObjectRemoveRef(handle1);
+  mrsRefCountedObjectRemoveRef(handle2);
+  mrsRefCountedObjectRemoveRef(handle3);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  pool_config.pool_size = 0;
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetCertificatePoolConfig(&pool_config));
+}
+
+TEST(LibraryTests, SetVideoDecoderThreadingConfig) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Invalid arguments
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsSetVideoDecoderThreadingConfig(nullptr));
+  mrsVideoDecoderThreadingConfig threading_config{};
+  threading_config.max_threads_per_decoder = 1000;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsSetVideoDecoderThreadingConfig(&threading_config));
+
+  threading_config.max_threads_per_decoder = 2;
+  threading_config.thread_budget = 4;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsSetVideoDecoderThreadingConfig(&threading_config));
+
+  // The configuration cannot change while the library is initialized
+  mrsPeerConnectionConfiguration pc_config{};
+  mrsPeerConnectionHandle handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle));
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsSetVideoDecoderThreadingConfig(&threading_config));
+  mrsRefCountedObjectRemoveRef(handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  threading_config = mrsVideoDecoderThreadingConfig{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsSetVideoDecoderThreadingConfig(&threading_config));
+}
+
+TEST(LibraryTests, SetVp9ScalabilityMode) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Invalid modes
+  for (const char* mode : {"L4T1", "L1T0", "S2T1", "L2T2h", "l1t3"}) {
+    ASSERT_EQ(mrsResult::kInvalidParameter, mrsSetVp9ScalabilityMode(mode));
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetVp9ScalabilityMode("L3T3"));
+
+  // Video encodings can only have the scalability mode of the library
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+  mrsPeerConnectionHandle handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle));
+  mrsRtpEncodingParameters svc{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kVideo;
+  transceiver_config.send_encodings = &svc;
+  transceiver_config.send_encodings_count = 1;
+  mrsTransceiverHandle transceiver_handle = nullptr;
+  for (const char* mode : {"L1T1", "L3T1", "L2T3"}) {
+    svc.scalability_mode = mode;
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(handle, &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_EQ(nullptr, transceiver_handle);
+  }
+  svc.scalability_mode = "L3T3";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionAddTransceiver(handle, &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+  svc.scalability_mode = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &svc, 1));
+
+  // The mode cannot change while the library is initialized
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsSetVp9ScalabilityMode("L1T1"));
+  mrsRefCountedObjectRemoveRef(handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Restore the default single layer
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetVp9ScalabilityMode(nullptr));
+}
+
+TEST(LibraryTests, SetAudioDeviceModuleConfig) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Invalid arguments
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsSetAudioDeviceModuleConfig(nullptr));
+  mrsAudioDeviceModuleConfig adm_config{};
+  for (int32_t layer : {-1, 9, 42}) {
+    adm_config.audio_layer = (mrsAudioDeviceLayer)layer;
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsSetAudioDeviceModuleConfig(&adm_config));
+  }
+
+  // The dummy layer needs no audio device, and the library initializes with
+  // it like with the default layer
+  adm_config.audio_layer = mrsAudioDeviceLayer::kDummy;
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetAudioDeviceModuleConfig(&adm_config));
+  mrsPeerConnectionConfiguration pc_config{};
+  mrsPeerConnectionHandle handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess, mrsPeerConnectionCreate(&pc_config, &handle));
+  ASSERT_NE(nullptr, handle);
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionAddTransceiver(handle, &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  // The configuration cannot change while the library is initialized
+  adm_config.audio_layer = mrsAudioDeviceLayer::kPlatformDefault;
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsSetAudioDeviceModuleConfig(&adm_config));
+  mrsRefCountedObjectRemoveRef(handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Restore the default layer
+  ASSERT_EQ(mrsResult::kSuccess, mrsSetAudioDeviceModuleConfig(&adm_config));
+}
+
+TEST(LibraryTests, InitializeAsync) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  Event ev_initialized;
+  mrsResult init_result = mrsResult::kUnknownError;
+  InteropCallback<mrsResult> initialized_cb = [&](mrsResult result) {
+    init_result = result;
+    ev_initialized.Set();
+  };
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLibraryInitializeAsync(CB(initialized_cb)));
+  ASSERT_TRUE(ev_initialized.WaitFor(10s));
+  ASSERT_EQ(mrsResult::kSuccess, init_result);
+
+  // The first object takes over the library initialized in the background,
+  // which shuts down once the object is destroyed.
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  ASSERT_EQ(1u, mrsReportLiveObjects());
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
+TEST(LibraryTests, LogSink) {
+  mrsLogSinkConfig config{};
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsLogSinkInstall(nullptr));
+  // Neither file nor callback
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsLogSinkInstall(&config));
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsLogSinkSetLevel(nullptr, mrsLogLevel::kVerbose));
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsLogSinkFlush());
+
+  std::atomic<int> message_count{0};
+  config.level = mrsLogLevel::kNone;
+  config.callback = &CountLogMessage;
+  config.user_data = &message_count;
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkInstall(&config));
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsLogSinkInstall(&config));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLogSinkSetLevel(nullptr, (mrsLogLevel)42));
+
+  // Nothing is logged while all modules are disabled
+  {
+    PCRaii pc;
+    ASSERT_NE(nullptr, pc.handle());
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkFlush());
+  ASSERT_EQ(0, message_count.load());
+
+  // Levels changed at runtime take effect immediately
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLogSinkSetLevel("peer_connection", mrsLogLevel::kError));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLogSinkSetLevel(nullptr, mrsLogLevel::kVerbose));
+  {
+    PCRaii pc;
+    ASSERT_NE(nullptr, pc.handle());
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkFlush());
+  ASSERT_LT(0, message_count.load());
+  mrsLogSinkStats stats{};
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkGetStats(&stats));
+  ASSERT_EQ((uint64_t)message_count.load(), stats.written_count);
+
+  mrsLogSinkUninstall();
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsLogSinkGetStats(&stats));
+  mrsLogSinkUninstall();
+}
@@ -169,3 +169,80 @@ TEST(MemoryUtils, MemCpyStride_StrideToPack) {
     }
   }
 }
+
+// Test mrsCopyArgb32Frame() with streaming stores to an unaligned destination,
+// flipping the frame vertically.
+TEST(MemoryUtils, CopyArgb32Frame_FlipStreaming) {
+  constexpr int kWidth = 37;
+  constexpr int kSrcStride = kWidth * 4 + 12;
+  constexpr int kDstStride = kWidth * 4 + 4;
+  constexpr int kHeight = 11;
+  std::vector<uint8_t> s(kSrcStride * kHeight);
+  std::vector<uint8_t> d(kDstStride * kHeight + 1);
+  for (uint8_t& c : s) {
+    c = (rand() & 0xFF);
+  }
+  mrsArgb32VideoFrame frame{};
+  frame.width_ = kWidth;
+  frame.height_ = kHeight;
+  frame.argb32_data_ = s.data();
+  frame.stride_ = kSrcStride;
+  uint8_t* const dst = d.data() + 1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsCopyArgb32Frame(&frame, dst, kWidth * 4 - 1,
+                               mrsFrameCopyFlags::kNone));
+  ASSERT_EQ(Result::kSuccess,
+            mrsCopyArgb32Frame(&frame, dst, kDstStride,
+                               mrsFrameCopyFlags::kFlipVertically |
+                                   mrsFrameCopyFlags::kStreamingStores));
+  for (int j = 0; j < kHeight; ++j) {
+    ASSERT_EQ(0, memcmp(s.data() + j * kSrcStride,
+                        dst + (kHeight - 1 - j) * kDstStride, kWidth * 4));
+  }
+}
+
+// Test mrsCopyI420AFrame() with odd dimensions, filling the destination alpha
+// plane missing from the source frame.
+TEST(MemoryUtils, CopyI420AFrame_OpaqueAlpha) {
+  constexpr int kWidth = 29;
+  constexpr int kHeight = 13;
+  constexpr int kChromaWidth = (kWidth + 1) / 2;
+  constexpr int kChromaHeight = (kHeight + 1) / 2;
+  constexpr int kStride = 32;
+  std::vector<uint8_t> sy(kStride * kHeight), su(kStride * kChromaHeight),
+      sv(kStride * kChromaHeight);
+  for (auto* plane : {&sy, &su, &sv}) {
+    for (uint8_t& c : *plane) {
+      c = (rand() & 0xFF);
+    }
+  }
+  std::vector<uint8_t> dy(kWidth * kHeight), du(kChromaWidth * kChromaHeight),
+      dv(kChromaWidth * kChromaHeight), da(kWidth * kHeight);
+  mrsI420AVideoFrame frame{};
+  frame.width_ = kWidth;
+  frame.height_ = kHeight;
+  frame.ydata_ = sy.data();
+  frame.udata_ = su.data();
+  frame.vdata_ = sv.data();
+  frame.ystride_ = kStride;
+  frame.ustride_ = kStride;
+  frame.vstride_ = kStride;
+  mrsI420AFrameLayout layout{dy.data(),    du.data(),    dv.data(),
+                             da.data(),    kWidth,       kChromaWidth,
+                             kChromaWidth, kWidth};
+  ASSERT_EQ(Result::kSuccess,
+            mrsCopyI420AFrame(&frame, &layout, mrsFrameCopyFlags::kNone));
+  for (int j = 0; j < kHeight; ++j) {
+    ASSERT_EQ(0, memcmp(sy.data() + j * kStride, dy.data() + j * kWidth,
+                        kWidth));
+  }
+  for (int j = 0; j < kChromaHeight; ++j) {
+    ASSERT_EQ(0, memcmp(su.data() + j * kStride,
+                        du.data() + j * kChromaWidth, kChromaWidth));
+    ASSERT_EQ(0, memcmp(sv.data() + j * kStride,
+                        dv.data() + j * kChromaWidth, kChromaWidth));
+  }
+  for (uint8_t c : da) {
+    ASSERT_EQ(0xFF, c);
+  }
+}
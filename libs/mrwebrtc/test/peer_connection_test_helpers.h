@@ -259,6 +259,15 @@ class LocalPeerPairRaii {
     ASSERT_EQ(true, ev2.WaitFor(60s));
   }
 
+  /// Renegotiate the connected pair with an offer from the first peer which
+  /// restarts ICE.
+  void RestartIce() {
+    ASSERT_FALSE(is_exchange_pending_);
+    is_exchange_pending_ = true;
+    exchange_completed_.Reset();
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionRestartIce(pc1()));
+  }
+
   /// Wait until the SDP exchange is completed, that is the SDP answer was
   /// applied on the offering peer.
   bool WaitExchangeCompletedFor(std::chrono::seconds timeout) {
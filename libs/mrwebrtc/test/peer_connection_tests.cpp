@@ -3,7 +3,14 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+#include "event_queue_interop.h"
 #include "interop_api.h"
+#include "peer_connection_interop.h"
+#include "transceiver_interop.h"
 
 #include "test_utils.h"
 
@@ -89,3 +96,562 @@ TEST_P(PeerConnectionTests, LocalIce) {
                                                              nullptr, nullptr);
   }
 }
+
+TEST_P(PeerConnectionTests, Dscp) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  pc_config.enable_dscp = mrsBool::kTrue;
+  LocalPeerPairRaii pair(pc_config);
+  ASSERT_NE(nullptr, pair.pc1());
+  ASSERT_NE(nullptr, pair.pc2());
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+}
+
+TEST_P(PeerConnectionTests, GcmCryptoSuites) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  pc_config.enable_gcm_crypto_suites = mrsBool::kTrue;
+  LocalPeerPairRaii pair(pc_config);
+
+  // SRTP is only negotiated with a media section
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "audio_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  InteropCallback<const mrsTransportCryptoStats*> crypto_cb;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionGetTransportCryptoStats(pair.pc1(), nullptr,
+                                                     nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionGetTransportCryptoStats(nullptr, CB(crypto_cb)));
+
+  // The transport may take a moment to complete the DTLS handshake
+  std::string srtp_cipher;
+  std::string dtls_cipher;
+  for (int i = 0; (i < 50) && srtp_cipher.empty(); ++i) {
+    Event ev;
+    crypto_cb = [&](const mrsTransportCryptoStats* stats) {
+      srtp_cipher = stats->srtp_cipher;
+      dtls_cipher = stats->dtls_cipher;
+      ev.Set();
+    };
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionGetTransportCryptoStats(
+                                    pair.pc1(), CB(crypto_cb)));
+    ASSERT_TRUE(ev.WaitFor(5s));
+    if (srtp_cipher.empty()) {
+      std::this_thread::sleep_for(100ms);
+    }
+  }
+  ASSERT_EQ(0u, srtp_cipher.find("AEAD_AES_"));
+  ASSERT_FALSE(dtls_cipher.empty());
+}
+
+TEST_P(PeerConnectionTests, Listeners) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid arguments
+  uint64_t id = 42;
+  InteropCallback<> connected_cb;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddConnectedListener(pair.pc1(), CB(connected_cb),
+                                                  nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionAddConnectedListener(nullptr, CB(connected_cb),
+                                                  &id));
+  ASSERT_EQ(0u, id);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddConnectedListener(pair.pc1(), nullptr, nullptr,
+                                                  &id));
+  ASSERT_EQ(Result::kNotFound, mrsPeerConnectionRemoveListener(pair.pc1(), 0));
+
+  // Listeners are invoked along with the registered callback
+  Event ev_connected;
+  connected_cb = [&ev_connected]() { ev_connected.Set(); };
+  uint64_t connected_id = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddConnectedListener(pair.pc1(), CB(connected_cb),
+                                                  &connected_id));
+  connected_cb.is_registered_ = true;
+  ASSERT_NE(0u, connected_id);
+
+  // A listener can remove itself while being invoked
+  Event ev_ice_state;
+  std::atomic<int> ice_state_count{0};
+  uint64_t ice_state_id = 0;
+  InteropCallback<mrsIceConnectionState> ice_state_cb;
+  ice_state_cb = [&](mrsIceConnectionState /*new_state*/) {
+    ++ice_state_count;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionRemoveListener(pair.pc1(), ice_state_id));
+    ice_state_cb.is_registered_ = false;
+    ev_ice_state.Set();
+  };
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceStateChangedListener(
+                pair.pc1(), CB(ice_state_cb), &ice_state_id));
+  ice_state_cb.is_registered_ = true;
+  ASSERT_NE(connected_id, ice_state_id);
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_connected.WaitFor(5s));
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(ev_ice_state.WaitFor(5s));
+  ASSERT_EQ(1, ice_state_count.load());
+  ASSERT_FALSE(ice_state_cb.is_registered_);
+
+  // Removing a listener does not affect the registered callback
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveListener(pair.pc1(), connected_id));
+  connected_cb.is_registered_ = false;
+  ASSERT_EQ(Result::kNotFound,
+            mrsPeerConnectionRemoveListener(pair.pc1(), connected_id));
+  ASSERT_EQ(Result::kNotFound,
+            mrsPeerConnectionRemoveListener(pair.pc1(), ice_state_id));
+}
+
+TEST_P(PeerConnectionTests, IceCandidateBatches) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid arguments
+  mrsIceCandidate invalid{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionSetIceCandidateBatchWindow(nullptr, 20));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddIceCandidates(pair.pc1(), nullptr, 1));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddIceCandidates(pair.pc1(), &invalid, -1));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddIceCandidates(pair.pc1(), &invalid, 1));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceCandidates(pair.pc1(), nullptr, 0));
+
+  // Count the candidates delivered individually by the pair helper, which
+  // also adds them to the remote peer.
+  std::atomic<int> single_count{0};
+  InteropCallback<const mrsIceCandidate*> single_cb(
+      [&single_count](const mrsIceCandidate* /*candidate*/) {
+        ++single_count;
+      });
+  uint64_t single_id = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceCandidateReadytoSendListener(
+                pair.pc1(), CB(single_cb), &single_id));
+  single_cb.is_registered_ = true;
+
+  // Batches of the first peer are re-added in bulk to the second one, where
+  // each candidate is already known and is accepted again.
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetIceCandidateBatchWindow(pair.pc1(), 20));
+  std::atomic<int> batch_count{0};
+  std::atomic<int> batched_count{0};
+  InteropCallback<const mrsIceCandidate*, int> batch_cb(
+      [&](const mrsIceCandidate* candidates, int count) {
+        ASSERT_LT(0, count);
+        ++batch_count;
+        batched_count += count;
+        ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddIceCandidates(
+                                        pair.pc2(), candidates, count));
+      });
+  mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(pair.pc1(),
+                                                            CB(batch_cb));
+  batch_cb.is_registered_ = true;
+
+  // All batches are delivered before gathering completes.
+  Event ev_gathered;
+  int single_on_complete = -1;
+  int batched_on_complete = -1;
+  InteropCallback<mrsIceGatheringState> gathering_cb(
+      [&](mrsIceGatheringState new_state) {
+        if (new_state == mrsIceGatheringState::kComplete) {
+          single_on_complete = single_count.load();
+          batched_on_complete = batched_count.load();
+          ev_gathered.Set();
+        }
+      });
+  mrsPeerConnectionRegisterIceGatheringStateChangedCallback(pair.pc1(),
+                                                            CB(gathering_cb));
+  gathering_cb.is_registered_ = true;
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(ev_gathered.WaitFor(10s));
+  ASSERT_LT(0, single_on_complete);
+  ASSERT_EQ(single_on_complete, batched_on_complete);
+  ASSERT_LE(1, batch_count.load());
+  ASSERT_GE(batched_on_complete, batch_count.load());
+
+  mrsPeerConnectionRegisterIceGatheringStateChangedCallback(pair.pc1(),
+                                                            nullptr, nullptr);
+  gathering_cb.is_registered_ = false;
+  mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(pair.pc1(),
+                                                            nullptr, nullptr);
+  batch_cb.is_registered_ = false;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveListener(pair.pc1(), single_id));
+  single_cb.is_registered_ = false;
+}
+
+TEST_P(PeerConnectionTests, RestrictedGathering) {
+  // Invalid port ranges
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.sdp_semantic = GetParam();
+    pc_config.min_port = 50100;
+    pc_config.max_port = 50000;
+    mrsPeerConnectionHandle handle = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+    pc_config.min_port = 0;
+    pc_config.max_port = 70000;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  pc_config.min_port = 50000;
+  pc_config.max_port = 50100;
+  pc_config.disable_tcp_candidates = mrsBool::kTrue;
+  pc_config.disable_ipv6 = mrsBool::kTrue;
+  pc_config.network_interface_denylist = "vEthernet;VirtualBox";
+  LocalPeerPairRaii pair(pc_config);
+
+  // Check the candidates delivered to the pair helper.
+  std::atomic<int> candidate_count{0};
+  std::atomic<int> invalid_count{0};
+  InteropCallback<const mrsIceCandidate*> candidate_cb(
+      [&](const mrsIceCandidate* candidate) {
+        ++candidate_count;
+        // candidate:<foundation> <component> <protocol> <priority> <address>
+        // <port> typ <type> ...
+        std::istringstream fields(candidate->content);
+        std::string foundation, component, protocol, priority, address;
+        int port = 0;
+        fields >> foundation >> component >> protocol >> priority >> address >>
+            port;
+        if ((protocol != "udp") || (port < 50000) || (port > 50100) ||
+            (address.find(':') != std::string::npos)) {
+          ++invalid_count;
+        }
+      });
+  uint64_t candidate_id = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceCandidateReadytoSendListener(
+                pair.pc1(), CB(candidate_cb), &candidate_id));
+  candidate_cb.is_registered_ = true;
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_LT(0, candidate_count.load());
+  ASSERT_EQ(0, invalid_count.load());
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveListener(pair.pc1(), candidate_id));
+  candidate_cb.is_registered_ = false;
+}
+
+TEST_P(PeerConnectionTests, PrewarmIce) {
+  // Invalid configuration
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.sdp_semantic = GetParam();
+    pc_config.ice_candidate_pool_size = -1;
+    mrsPeerConnectionHandle handle = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    mrsPeerConnectionConfiguration pc_config{};  // local connection only
+    pc_config.sdp_semantic = GetParam();
+    pc_config.ice_candidate_pool_size = i;
+    pc_config.continual_gathering_policy =
+        mrsContinualGatheringPolicy::kGatherContinually;
+    LocalPeerPairRaii pair(pc_config);
+
+    // Invalid arguments
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsPeerConnectionPrewarmIce(nullptr, 2));
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionPrewarmIce(pair.pc1(), 0));
+
+    // Pre-gathered candidates are used by the first offer
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionPrewarmIce(pair.pc1(), 2));
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionPrewarmIce(pair.pc2(), 2));
+    pair.ConnectAndWait();
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  }
+}
+
+TEST_P(PeerConnectionTests, IceRestart) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid arguments
+  mrsIceRestartPolicy policy{};
+  ASSERT_EQ(Result::kInvalidNativeHandle, mrsPeerConnectionRestartIce(nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionSetIceRestartPolicy(nullptr, &policy));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetIceRestartPolicy(pair.pc1(), nullptr));
+  policy.max_attempts = -1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSetIceRestartPolicy(pair.pc1(), &policy));
+
+  policy.enabled = mrsBool::kTrue;
+  policy.disconnected_delay_ms = 2000;
+  policy.max_attempts = 2;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetIceRestartPolicy(pair.pc1(), &policy));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // Restarting ICE gathers new candidates with new credentials, and
+  // renegotiates the session without closing the connection.
+  Event ev_candidate;
+  InteropCallback<const mrsIceCandidate*> candidate_cb(
+      [&ev_candidate](const mrsIceCandidate* /*candidate*/) {
+        ev_candidate.Set();
+      });
+  uint64_t candidate_id = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceCandidateReadytoSendListener(
+                pair.pc1(), CB(candidate_cb), &candidate_id));
+  candidate_cb.is_registered_ = true;
+  pair.RestartIce();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(ev_candidate.WaitFor(5s));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveListener(pair.pc1(), candidate_id));
+  candidate_cb.is_registered_ = false;
+}
+
+TEST_P(PeerConnectionTests, BatchUpdate) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid arguments
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionBeginBatchUpdate(nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionEndBatchUpdate(nullptr));
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsPeerConnectionEndBatchUpdate(pair.pc1()));
+
+  std::atomic<int> renegotiation_needed_count{0};
+  InteropCallback<> renegotiation_needed_cb = [&]() {
+    ++renegotiation_needed_count;
+  };
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(
+      pair.pc1(), CB(renegotiation_needed_cb));
+
+  // Adding transceivers in nested batches raises a single event at the end of
+  // the outermost batch.
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionBeginBatchUpdate(pair.pc1()));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionBeginBatchUpdate(pair.pc1()));
+  for (int i = 0; i < 3; ++i) {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind =
+        (i == 0 ? mrsMediaKind::kAudio : mrsMediaKind::kVideo);
+    mrsTransceiverHandle transceiver_handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_NE(nullptr, transceiver_handle);
+  }
+  ASSERT_EQ(0, renegotiation_needed_count.load());
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionEndBatchUpdate(pair.pc1()));
+  ASSERT_EQ(0, renegotiation_needed_count.load());
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionEndBatchUpdate(pair.pc1()));
+  ASSERT_EQ(1, renegotiation_needed_count.load());
+
+  // A batch without changes does not raise the event.
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionBeginBatchUpdate(pair.pc1()));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionEndBatchUpdate(pair.pc1()));
+  ASSERT_EQ(1, renegotiation_needed_count.load());
+
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(pair.pc1(), nullptr,
+                                                       nullptr);
+}
+
+TEST_P(PeerConnectionTests, RegisterWhileCallbackBlocked) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+  auto add_transceiver = [&pair]() {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    mrsTransceiverHandle transceiver_handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+  };
+
+  // The first callback blocks until released by the test
+  Event ev_blocked;
+  Event ev_release;
+  std::atomic<int> first_count{0};
+  InteropCallback<> first_cb = [&]() {
+    ++first_count;
+    ev_blocked.Set();
+    ASSERT_TRUE(ev_release.WaitFor(10s));
+  };
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(pair.pc1(),
+                                                       CB(first_cb));
+  first_cb.is_registered_ = true;
+  std::thread trigger(add_transceiver);
+  const bool blocked = ev_blocked.WaitFor(5s);
+
+  // Register callbacks from yet another thread while the first one is blocked
+  Event ev_listener_added;
+  Event ev_registered;
+  Event ev_second;
+  std::atomic<int> listener_count{0};
+  InteropCallback<> listener_cb = [&]() { ++listener_count; };
+  InteropCallback<> second_cb = [&]() { ev_second.Set(); };
+  uint64_t listener_id = 0;
+  std::thread registering([&]() {
+    // Adding a listener never waits for the callback in progress
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddRenegotiationNeededListener(
+                  pair.pc1(), CB(listener_cb), &listener_id));
+    ev_listener_added.Set();
+
+    // Replacing the registered callback waits for it to return, after which
+    // it is never invoked again
+    mrsPeerConnectionRegisterRenegotiationNeededCallback(pair.pc1(),
+                                                         CB(second_cb));
+    ev_registered.Set();
+  });
+  const bool listener_added = ev_listener_added.WaitFor(5s);
+  std::this_thread::sleep_for(200ms);
+  const bool registered_while_blocked = ev_registered.IsSignaled();
+
+  // Release the callback before checking, to never leave threads behind
+  ev_release.Set();
+  const bool registered = ev_registered.WaitFor(5s);
+  registering.join();
+  trigger.join();
+  listener_cb.is_registered_ = true;
+  second_cb.is_registered_ = true;
+  first_cb.is_registered_ = false;
+  ASSERT_TRUE(blocked);
+  ASSERT_TRUE(listener_added);
+  ASSERT_FALSE(registered_while_blocked);
+  ASSERT_TRUE(registered);
+
+  // The next event invokes the new callback and the listener only
+  add_transceiver();
+  ASSERT_TRUE(ev_second.WaitFor(5s));
+  ASSERT_EQ(1, first_count.load());
+  ASSERT_EQ(1, listener_count.load());
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveListener(pair.pc1(), listener_id));
+  listener_cb.is_registered_ = false;
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(pair.pc1(), nullptr,
+                                                       nullptr);
+  second_cb.is_registered_ = false;
+}
+
+TEST_P(PeerConnectionTests, CloseMany) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // Invalid arguments
+  mrsPeerConnectionHandle handles[3] = {pair.pc1(), pair.pc2(), nullptr};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionCloseMany(nullptr, 1, 1000));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionCloseMany(handles, 3, 1000));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCloseMany(nullptr, 0, 1000));
+
+  // Connected peers close together, and closing again is a no-op.
+  mrsPeerConnectionConfiguration local_config{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionCreate(&local_config, &handles[2]));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCloseMany(handles, 3, 5000));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCloseMany(handles, 3, -1));
+  mrsRefCountedObjectRemoveRef(handles[2]);
+}
+
+TEST_P(PeerConnectionTests, EventPolling) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  PCRaii pc(pc_config);
+
+  // Invalid arguments
+  uint32_t count = 0;
+  ASSERT_EQ(Result::kInvalidParameter, mrsPollEvents(nullptr, 1, &count));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionSetEventPolling(nullptr, mrsBool::kTrue));
+
+  // Discard the events of other tests, if any
+  mrsEvent events[16];
+  do {
+    ASSERT_EQ(Result::kSuccess, mrsPollEvents(events, 16, &count));
+  } while (count > 0);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetEventPolling(pc.handle(), mrsBool::kTrue));
+  mrsDataChannelConfig data_config{};
+  data_config.id = 0;
+  data_config.label = "polled";
+  mrsDataChannelHandle data_channel = nullptr;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &data_config,
+                                            &data_channel));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCreateOffer(pc.handle()));
+
+  // Events are recorded in order, without invoking any callback
+  bool data_channel_added = false;
+  bool offer_ready = false;
+  for (int i = 0; (i < 500) && !offer_ready; ++i) {
+    ASSERT_EQ(Result::kSuccess, mrsPollEvents(events, 16, &count));
+    for (uint32_t j = 0; j < count; ++j) {
+      const mrsEvent& event = events[j];
+      ASSERT_EQ(pc.handle(), event.source);
+      if (event.type == mrsEventType::kDataChannelAdded) {
+        ASSERT_FALSE(offer_ready);
+        ASSERT_EQ(data_channel, event.object);
+        ASSERT_STREQ("polled", event.text);
+        data_channel_added = true;
+      } else if (event.type == mrsEventType::kLocalSdpReadytoSend) {
+        ASSERT_EQ((int32_t)mrsSdpMessageType::kOffer, event.value);
+        ASSERT_LT(0u, event.size);
+        ASSERT_EQ(event.size, strlen((const char*)event.data));
+        offer_ready = true;
+      }
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_TRUE(data_channel_added);
+  ASSERT_TRUE(offer_ready);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetEventPolling(pc.handle(), mrsBool::kFalse));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pc.handle(), data_channel));
+}
@@ -206,3 +206,101 @@ TEST(SdpUtils, IsValidToken) {
     ASSERT_EQ(mrsBool::kTrue, mrsSdpIsValidToken(str));
   }
 }
+
+namespace {
+
+std::string EncodeCompact(const char* message, const char* base) {
+  uint64_t len = 0;
+  EXPECT_EQ(Result::kBufferTooSmall,
+            mrsSdpEncodeCompact(message, base, nullptr, &len));
+  RaiiBuffer buffer((size_t)len);
+  EXPECT_EQ(Result::kSuccess,
+            mrsSdpEncodeCompact(message, base, buffer._data, &len));
+  return std::string(buffer._data);
+}
+
+mrsResult DecodeCompact(const std::string& compact,
+                        const char* base,
+                        std::string& message) {
+  uint64_t len = 0;
+  const mrsResult result =
+      mrsSdpDecodeCompact(compact.c_str(), base, nullptr, &len);
+  if (result != Result::kBufferTooSmall) {
+    return result;
+  }
+  RaiiBuffer buffer((size_t)len);
+  EXPECT_EQ(Result::kSuccess, mrsSdpDecodeCompact(compact.c_str(), base,
+                                                  buffer._data, &len));
+  message.assign(buffer._data);
+  return Result::kSuccess;
+}
+
+}  // namespace
+
+TEST(SdpUtils, CompactRoundTrip) {
+  const std::string compact = EncodeCompact(kSdpFullString, nullptr);
+  std::string message;
+  ASSERT_EQ(Result::kSuccess, DecodeCompact(compact, nullptr, message));
+  ASSERT_EQ(kSdpFullString, message);
+}
+
+TEST(SdpUtils, CompactRepeatedSections) {
+  // Repeat the video section, as with several video transceivers.
+  const char* const video = strstr(kSdpFullString, "m=video");
+  ASSERT_NE(nullptr, video);
+  std::string repeated(kSdpFullString);
+  repeated += video;
+  repeated += video;
+  const std::string compact = EncodeCompact(repeated.c_str(), nullptr);
+  std::string message;
+  ASSERT_EQ(Result::kSuccess, DecodeCompact(compact, nullptr, message));
+  ASSERT_EQ(repeated, message);
+  ASSERT_LT(compact.size(), repeated.size());
+}
+
+TEST(SdpUtils, CompactDelta) {
+  // Renegotiation bumping the session version, changing the direction of the
+  // video section, and adding a section.
+  std::string renegotiated(kSdpFullString);
+  const size_t version_pos = renegotiated.find("18446462598732840960");
+  ASSERT_NE(std::string::npos, version_pos);
+  renegotiated.replace(version_pos, 20, "18446462598732840961");
+  const size_t direction_pos =
+      renegotiated.find("a=sendrecv", renegotiated.find("m=video"));
+  ASSERT_NE(std::string::npos, direction_pos);
+  renegotiated.replace(direction_pos, 10, "a=sendonly");
+  renegotiated +=
+      "m=application 9 DTLS/SCTP 5000\r\n"
+      "c=IN IP4 0.0.0.0\r\n"
+      "a=mid:data\r\n";
+
+  const std::string compact =
+      EncodeCompact(renegotiated.c_str(), kSdpFullString);
+  ASSERT_LT(compact.size(), renegotiated.size() / 4);
+  std::string message;
+  ASSERT_EQ(Result::kSuccess, DecodeCompact(compact, kSdpFullString, message));
+  ASSERT_EQ(renegotiated, message);
+
+  // Identical messages.
+  const std::string same = EncodeCompact(kSdpFullString, kSdpFullString);
+  ASSERT_EQ(Result::kSuccess, DecodeCompact(same, kSdpFullString, message));
+  ASSERT_EQ(kSdpFullString, message);
+}
+
+TEST(SdpUtils, CompactInvalid) {
+  std::string message;
+  ASSERT_EQ(Result::kInvalidParameter,
+            DecodeCompact("v=0\r\n", nullptr, message));
+  ASSERT_EQ(Result::kInvalidParameter,
+            DecodeCompact("#mrsc1\n#b0\n", nullptr, message));
+
+  // Delta decoded against another base.
+  const std::string compact =
+      EncodeCompact(kSdpForcedAudioOpus, kSdpFullString);
+  ASSERT_EQ(Result::kInvalidParameter,
+            DecodeCompact(compact, kSdpForcedAudioOpus, message));
+  ASSERT_EQ(Result::kInvalidParameter,
+            DecodeCompact(compact, nullptr, message));
+  ASSERT_EQ(Result::kSuccess, DecodeCompact(compact, kSdpFullString, message));
+  ASSERT_EQ(kSdpForcedAudioOpus, message);
+}
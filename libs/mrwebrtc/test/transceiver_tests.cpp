@@ -61,6 +61,10 @@ struct MediaTrait;
 /// Specialization for audio tests.
 template <>
 struct MediaTrait<AudioTest> {
+  /// Non-default codec to prefer, and default codec pruned by the preference.
+  static constexpr const char* kPreferredCodec = "G722";
+  static constexpr const char* kPrunedCodec = "opus";
+
   static void CheckTransceiverTracksAreNull(mrsTransceiverHandle handle) {
     mrsLocalAudioTrackHandle local_handle{};
     ASSERT_EQ(Result::kSuccess,
@@ -83,6 +87,10 @@ struct MediaTrait<AudioTest> {
 /// Specialization for video tests.
 template <>
 struct MediaTrait<VideoTest> {
+  /// Non-default codec to prefer, and default codec pruned by the preference.
+  static constexpr const char* kPreferredCodec = "VP9";
+  static constexpr const char* kPrunedCodec = "VP8";
+
   static void CheckTransceiverTracksAreNull(mrsTransceiverHandle handle) {
     mrsLocalVideoTrackHandle local_handle{};
     ASSERT_EQ(Result::kSuccess,
@@ -458,6 +466,83 @@ TYPED_TEST_P(TransceiverTests, SetDirection_InvalidHandle) {
       mrsTransceiverSetDirection(nullptr, mrsTransceiverDirection::kRecvOnly));
 }
 
+TYPED_TEST_P(TransceiverTests, SetSubscribed) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+
+  Event renegotiation_needed1_ev;
+  InteropCallback renegotiation_needed1_cb = [&renegotiation_needed1_ev]() {
+    renegotiation_needed1_ev.Set();
+  };
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(
+      pair.pc1(), CB(renegotiation_needed1_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "transceiver_1";
+    transceiver_config.media_kind = TypeParam::kMediaKind;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+    ASSERT_NE(nullptr, transceiver_handle1);
+  }
+
+  Event state_updated1_ev_remote;
+  Event state_updated1_ev_setdir;
+  mrsTransceiverDirection dir_desired1 = mrsTransceiverDirection::kInactive;
+  InteropCallback<mrsTransceiverStateUpdatedReason, mrsTransceiverOptDirection,
+                  mrsTransceiverDirection>
+      state_updated1_cb = [&](mrsTransceiverStateUpdatedReason reason,
+                              mrsTransceiverOptDirection /*negotiated*/,
+                              mrsTransceiverDirection desired) {
+        dir_desired1 = desired;
+        if (reason == mrsTransceiverStateUpdatedReason::kRemoteDesc) {
+          state_updated1_ev_remote.Set();
+        } else if (reason == mrsTransceiverStateUpdatedReason::kSetDirection) {
+          state_updated1_ev_setdir.Set();
+        }
+      };
+  mrsTransceiverRegisterStateUpdatedCallback(transceiver_handle1,
+                                             CB(state_updated1_cb));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(state_updated1_ev_remote.WaitFor(10s));
+  state_updated1_ev_remote.Reset();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_EQ(mrsTransceiverDirection::kSendRecv, dir_desired1);
+
+  // Unsubscribing a receiving transceiver needs a renegotiation, but leaves
+  // its desired direction unchanged.
+  renegotiation_needed1_ev.Reset();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetSubscribed(transceiver_handle1, mrsBool::kFalse));
+  ASSERT_TRUE(renegotiation_needed1_ev.IsSignaled());
+  ASSERT_FALSE(state_updated1_ev_setdir.IsSignaled());
+
+  // Unsubscribing again is a no-op.
+  renegotiation_needed1_ev.Reset();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetSubscribed(transceiver_handle1, mrsBool::kFalse));
+  ASSERT_FALSE(renegotiation_needed1_ev.IsSignaled());
+
+  // The desired direction is still reported after renegotiating.
+  pair.ConnectAndWait();
+  ASSERT_TRUE(state_updated1_ev_remote.WaitFor(10s));
+  state_updated1_ev_remote.Reset();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_EQ(mrsTransceiverDirection::kSendRecv, dir_desired1);
+
+  renegotiation_needed1_ev.Reset();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetSubscribed(transceiver_handle1, mrsBool::kTrue));
+  ASSERT_TRUE(renegotiation_needed1_ev.IsSignaled());
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetSubscribed(nullptr, mrsBool::kTrue));
+}
+
 TYPED_TEST_P(TransceiverTests, SetLocalTrackSendRecv) {
   const mrsSdpSemantic sdp_semantic = TypeParam::kSdpSemantic;
   Test_SetLocalTrack(sdp_semantic, mrsTransceiverDirection::kSendRecv,
@@ -532,15 +617,432 @@ TYPED_TEST_P(TransceiverTests, StreamIDs) {
   pair.WaitExchangeCompletedFor(60s);
 }
 
+TYPED_TEST_P(TransceiverTests, ManyTransceivers) {
+  if (TypeParam::kSdpSemantic != mrsSdpSemantic::kUnifiedPlan) {
+    // Plan B only creates remote transceivers for tracks actually received.
+    return;
+  }
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+
+  // Collect the transceivers created on the remote peer (#2)
+  constexpr int kNumTransceivers = 64;
+  std::mutex mutex;
+  std::vector<mrsTransceiverHandle> remote_handles;
+  std::vector<int> remote_mline_indices;
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added2_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        ASSERT_EQ(TypeParam::kMediaKind, info->media_kind);
+        std::lock_guard<std::mutex> lock(mutex);
+        remote_handles.push_back(info->transceiver_handle);
+        remote_mline_indices.push_back(info->mline_index);
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(),
+                                                    CB(transceiver_added2_cb));
+
+  // Add many transceivers to the local peer (#1)
+  for (int i = 0; i < kNumTransceivers; ++i) {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind = TypeParam::kMediaKind;
+    mrsTransceiverHandle transceiver_handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_NE(nullptr, transceiver_handle);
+  }
+
+  // Connect #1 and #2; each RTP transceiver gets exactly one wrapper, in media
+  // line order.
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(kNumTransceivers, (int)remote_handles.size());
+    for (int i = 0; i < kNumTransceivers; ++i) {
+      ASSERT_EQ(i, remote_mline_indices[i]);
+      for (int j = 0; j < i; ++j) {
+        ASSERT_NE(remote_handles[i], remote_handles[j]);
+      }
+    }
+  }
+
+  // Renegotiate; the existing wrappers are found again.
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(kNumTransceivers, (int)remote_handles.size());
+  }
+
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(), nullptr,
+                                                    nullptr);
+}
+
+TYPED_TEST_P(TransceiverTests, SendEncodings) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  mrsRtpEncodingParameters layers[3]{};
+  layers[0].rid = "low";
+  layers[0].scale_resolution_down_by = 4.0;
+  layers[0].max_bitrate_bps = 150000;
+  layers[1].rid = "mid";
+  layers[1].scale_resolution_down_by = 2.0;
+  layers[1].max_bitrate_bps = 500000;
+  layers[1].max_framerate = 15;
+  layers[2].rid = "high";
+  layers[2].max_bitrate_bps = 2500000;
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  mrsTransceiverHandle transceiver_handle{};
+
+  // Invalid arrays
+  transceiver_config.send_encodings = layers;
+  transceiver_config.send_encodings_count = -1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  transceiver_config.send_encodings = nullptr;
+  transceiver_config.send_encodings_count = 1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+
+  // Invalid encodings
+  {
+    mrsRtpEncodingParameters invalid[2]{};
+    transceiver_config.send_encodings = invalid;
+    transceiver_config.send_encodings_count = 1;
+    invalid[0].scale_resolution_down_by = 0.5;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    invalid[0].scale_resolution_down_by = 1.0;
+    invalid[0].max_bitrate_bps = -1;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    invalid[0].max_bitrate_bps = 0;
+    invalid[0].rid = "not a token";
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+
+    // Simulcast layers without distinct RIDs
+    invalid[0].rid = "layer";
+    invalid[1].rid = "layer";
+    transceiver_config.send_encodings_count = 2;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    invalid[1].rid = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+
+    // Invalid scalability modes
+    invalid[0].rid = nullptr;
+    transceiver_config.send_encodings_count = 1;
+    for (const char* mode : {"L4T1", "L1T0", "S2T1", "L2T2h", "l1t3"}) {
+      invalid[0].scalability_mode = mode;
+      ASSERT_EQ(Result::kInvalidParameter,
+                mrsPeerConnectionAddTransceiver(
+                    pc.handle(), &transceiver_config, &transceiver_handle));
+    }
+    invalid[0].scalability_mode = "L3T3";
+    if (TypeParam::kMediaKind == mrsMediaKind::kAudio) {
+      ASSERT_EQ(Result::kInvalidParameter,
+                mrsPeerConnectionAddTransceiver(
+                    pc.handle(), &transceiver_config, &transceiver_handle));
+    } else {
+      // SVC replaces simulcast
+      invalid[0].rid = "low";
+      invalid[1].rid = "high";
+      transceiver_config.send_encodings_count = 2;
+      ASSERT_EQ(Result::kUnsupported,
+                mrsPeerConnectionAddTransceiver(
+                    pc.handle(), &transceiver_config, &transceiver_handle));
+    }
+  }
+  ASSERT_EQ(nullptr, transceiver_handle);
+
+  // A single encoding limits the sender
+  transceiver_config.send_encodings = &layers[2];
+  transceiver_config.send_encodings_count = 1;
+  if (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB) {
+    ASSERT_EQ(Result::kUnsupported,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    return;
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  // Simulcast layers, for video only. Whether those are accepted depends on
+  // the simulcast support of the underlying implementation.
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    transceiver_config.send_encodings = layers;
+    transceiver_config.send_encodings_count = 3;
+    transceiver_handle = nullptr;
+    const mrsResult result = mrsPeerConnectionAddTransceiver(
+        pc.handle(), &transceiver_config, &transceiver_handle);
+    ASSERT_TRUE((result == Result::kSuccess) ||
+                (result == Result::kUnsupported));
+    ASSERT_EQ(result == Result::kSuccess, transceiver_handle != nullptr);
+
+    // A single SVC encoding needs the layers of all VP9 encoders, which are
+    // the default single layer here
+    mrsRtpEncodingParameters svc{};
+    svc.scalability_mode = "L3T3";
+    transceiver_config.send_encodings = &svc;
+    transceiver_config.send_encodings_count = 1;
+    transceiver_handle = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_EQ(nullptr, transceiver_handle);
+    svc.scalability_mode = "L1T1";
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_NE(nullptr, transceiver_handle);
+    svc.scalability_mode = "L1T3";
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsTransceiverSetEncodingParameters(transceiver_handle, &svc, 1));
+  }
+}
+
+TYPED_TEST_P(TransceiverTests, SetEncodingParameters) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  // Invalid arguments
+  mrsRtpEncodingParameters encoding{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetEncodingParameters(nullptr, &encoding, 1));
+  ASSERT_EQ(Result::kInvalidParameter, mrsTransceiverSetEncodingParameters(
+                                           transceiver_handle, nullptr, 1));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetDegradationPreference(
+                nullptr, mrsDegradationPreference::kBalanced));
+
+  if (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB) {
+    // No RTP sender until the first offer or answer.
+    ASSERT_EQ(Result::kInvalidOperation, mrsTransceiverSetEncodingParameters(
+                                             transceiver_handle, &encoding, 1));
+    return;
+  }
+
+  // The transceiver has a single encoding
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &encoding,
+                                                0));
+  encoding.bitrate_priority = 0.0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &encoding,
+                                                1));
+  encoding.bitrate_priority = 2.0;
+  encoding.rid = "other";
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &encoding,
+                                                1));
+  encoding.rid = nullptr;
+
+  // Throttle, pause, and resume the sender without renegotiating
+  encoding.max_bitrate_bps = 300000;
+  encoding.max_framerate = 15;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetEncodingParameters(
+                                  transceiver_handle, &encoding, 1));
+  encoding.active = mrsBool::kFalse;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetEncodingParameters(
+                                  transceiver_handle, &encoding, 1));
+  encoding = mrsRtpEncodingParameters{};
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetEncodingParameters(
+                                  transceiver_handle, &encoding, 1));
+
+  // Temporal layers only apply to video
+  encoding.scalability_mode = "L1T3";
+  ASSERT_EQ(TypeParam::kMediaKind == mrsMediaKind::kVideo
+                ? Result::kSuccess
+                : Result::kInvalidParameter,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &encoding,
+                                                1));
+  encoding.scalability_mode = "L0T0";
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetEncodingParameters(transceiver_handle, &encoding,
+                                                1));
+  encoding.scalability_mode = "L1T1";
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetEncodingParameters(
+                                    transceiver_handle, &encoding, 1));
+  }
+  encoding.scalability_mode = nullptr;
+
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetDegradationPreference(
+                  transceiver_handle,
+                  mrsDegradationPreference::kMaintainResolution));
+  } else {
+    ASSERT_EQ(Result::kInvalidMediaKind,
+              mrsTransceiverSetDegradationPreference(
+                  transceiver_handle,
+                  mrsDegradationPreference::kMaintainResolution));
+  }
+}
+
+TYPED_TEST_P(TransceiverTests, CodecPreferences) {
+  using Media = MediaTrait<typename TypeParam::MediaType>;
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  // Invalid arguments
+  mrsCodecPreference codec{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetCodecPreferences(nullptr, &codec, 1));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetCodecPreferences(transceiver_handle, nullptr, 1));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetCodecPreferences(transceiver_handle, &codec, 1));
+
+  codec.name = Media::kPreferredCodec;
+  if (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB) {
+    ASSERT_EQ(Result::kUnsupported,
+              mrsTransceiverSetCodecPreferences(transceiver_handle, &codec, 1));
+    return;
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetCodecPreferences(transceiver_handle, &codec, 1));
+
+  // The offer only advertises the preferred codec.
+  std::string offer;
+  Event offer_ev;
+  SdpCallback sdp_cb(pc.handle(),
+                     [&offer, &offer_ev](mrsSdpMessageType type,
+                                         const char* sdp_data) {
+                       ASSERT_EQ(mrsSdpMessageType::kOffer, type);
+                       offer = sdp_data;
+                       offer_ev.Set();
+                     });
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCreateOffer(pc.handle()));
+  ASSERT_TRUE(offer_ev.WaitFor(10s));
+  ASSERT_NE(std::string::npos,
+            offer.find(std::string(" ") + Media::kPreferredCodec + "/"));
+  ASSERT_EQ(std::string::npos,
+            offer.find(std::string(" ") + Media::kPrunedCodec + "/"));
+
+  // Preferences can be removed.
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetCodecPreferences(transceiver_handle, nullptr, 0));
+}
+
+TYPED_TEST_P(TransceiverTests, AudioCodecOptions) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  // Invalid arguments
+  mrsAudioCodecOptions options{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetAudioCodecOptions(nullptr, &options));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetAudioCodecOptions(transceiver_handle, nullptr));
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    ASSERT_EQ(Result::kInvalidMediaKind,
+              mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+    return;
+  }
+  if (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB) {
+    ASSERT_EQ(Result::kUnsupported,
+              mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+    return;
+  }
+  options.ptime_ms = 5;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+  options.ptime_ms = 0;
+  options.max_bitrate_bps = -1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+
+  // The offer advertises the options as Opus format parameters.
+  options.dtx = mrsOptBool::kTrue;
+  options.fec = mrsOptBool::kTrue;
+  options.ptime_ms = 40;
+  options.max_bitrate_bps = 24000;
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+  std::string offer;
+  Event offer_ev;
+  SdpCallback sdp_cb(pc.handle(),
+                     [&offer, &offer_ev](mrsSdpMessageType type,
+                                         const char* sdp_data) {
+                       ASSERT_EQ(mrsSdpMessageType::kOffer, type);
+                       offer = sdp_data;
+                       offer_ev.Set();
+                     });
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionCreateOffer(pc.handle()));
+  ASSERT_TRUE(offer_ev.WaitFor(10s));
+  ASSERT_NE(std::string::npos, offer.find("usedtx=1"));
+  ASSERT_NE(std::string::npos, offer.find("useinbandfec=1"));
+
+  // The maximum bitrate can be changed at any time.
+  options.max_bitrate_bps = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioCodecOptions(transceiver_handle, &options));
+}
+
 // Note: All tests must be listed in this macro
 REGISTER_TYPED_TEST_CASE_P(TransceiverTests,
                            InvalidName,
                            SetDirection,
                            SetDirection_InvalidHandle,
+                           SetSubscribed,
                            SetLocalTrack_InvalidHandle,
                            SetLocalTrackSendRecv,
                            SetLocalTrackRecvOnly,
-                           StreamIDs);
+                           StreamIDs,
+                           ManyTransceivers,
+                           SendEncodings,
+                           SetEncodingParameters,
+                           CodecPreferences,
+                           AudioCodecOptions);
 
 using TestTypes = ::testing::Types<TestParams<AudioTest, SdpPlanB>,
                                    TestParams<AudioTest, SdpUnifiedPlan>,
@@ -52,19 +52,20 @@ TEST(VideoFrameObserver, GetArgbScratchBuffer) {
 TEST(VideoFrameObserver, ReuseArgbScratchBuffer) {
   MockVideoFrameObserver observer;
   ArgbBuffer* const buffer0 = observer.mock_GetArgbScratchBuffer(16, 16);
-  ArgbBuffer* const buffer1 = observer.mock_GetArgbScratchBuffer(15, 16);
+  ArgbBuffer* const buffer1 = observer.mock_GetArgbScratchBuffer(16, 16);
   ASSERT_EQ(buffer0, buffer1);
-  ArgbBuffer* const buffer2 = observer.mock_GetArgbScratchBuffer(16, 15);
-  ASSERT_EQ(buffer0, buffer2);
-  ArgbBuffer* const buffer3 = observer.mock_GetArgbScratchBuffer(16, 16);
-  ASSERT_EQ(buffer0, buffer3);
-  ArgbBuffer* const buffer4 = observer.mock_GetArgbScratchBuffer(17, 16);
-  ASSERT_NE(buffer0, buffer4);
-  ArgbBuffer* const buffer5 = observer.mock_GetArgbScratchBuffer(16, 17);
-  ASSERT_NE(buffer0, buffer5);
-  ASSERT_EQ(buffer4, buffer5);
-  ArgbBuffer* const buffer6 = observer.mock_GetArgbScratchBuffer(16, 18);
-  ASSERT_NE(buffer4, buffer6);
+  // Buffers of another shape are reallocated, even if large enough
+  ArgbBuffer* const buffer2 = observer.mock_GetArgbScratchBuffer(15, 16);
+  ASSERT_EQ(15, buffer2->width());
+  ASSERT_EQ(15 * 4, buffer2->Stride());
+  ArgbBuffer* const buffer3 = observer.mock_GetArgbScratchBuffer(16, 15);
+  ASSERT_EQ(16, buffer3->width());
+  ASSERT_EQ(15, buffer3->height());
+  ASSERT_EQ(16 * 4, buffer3->Stride());
+  ArgbBuffer* const buffer4 = observer.mock_GetArgbScratchBuffer(15, 16);
+  ASSERT_EQ(15, buffer4->width());
+  ASSERT_EQ(16, buffer4->height());
+  ASSERT_EQ(15 * 4, buffer4->Stride());
 }
 
 #endif  // #if 0
@@ -3,12 +3,18 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <thread>
+
 #include "device_video_track_source_interop.h"
+#include "external_encoded_video_track_source_interop.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
 #include "local_video_track_interop.h"
+#include "relay_video_track_source_interop.h"
 #include "remote_video_track_interop.h"
 #include "transceiver_interop.h"
+#include "video_track_source_interop.h"
 
 #include "simple_interop.h"
 #include "test_utils.h"
@@ -26,6 +32,76 @@ using VideoTrackAddedCallback =
 // PeerConnectionI420VideoFrameCallback
 using I420VideoFrameCallback = InteropCallback<const I420AVideoFrame&>;
 
+// mrsArgb32VideoFrameCallback
+using Argb32VideoFrameCallback = InteropCallback<const mrsArgb32VideoFrame&>;
+
+// mrsNv12VideoFrameCallback
+using Nv12VideoFrameCallback = InteropCallback<const mrsNv12VideoFrame&>;
+
+// mrsVideoFrameLeaseCallback
+using VideoFrameLeaseCallback = InteropCallback<const mrsVideoFrameLease&>;
+
+// mrsArgb32VideoFrameLeaseCallback
+using Argb32VideoFrameLeaseCallback =
+    InteropCallback<const mrsArgb32VideoFrame&, mrsVideoFrameBufferHandle>;
+
+// mrsEncodedVideoFrameCallback
+using EncodedVideoFrameCallback = InteropCallback<const mrsEncodedVideoFrame*>;
+
+// mrsStatsSnapshotCallback
+using StatsSnapshotCallback = InteropCallback<const mrsStatsEntry*, uint32_t>;
+using BandwidthEstimateCallback = InteropCallback<const mrsBandwidthEstimate*>;
+using QualityLimitationCallback =
+    InteropCallback<const mrsQualityLimitationEvent*>;
+
+// Complete a frame request with a uniform gray 320x240 frame, large enough to
+// hold a latency marker, with optional information passed along with it.
+mrsResult CompleteGrayFrame(mrsExternalVideoTrackSourceHandle handle,
+                            uint32_t request_id,
+                            int64_t timestamp_ms,
+                            const mrsExternalVideoFrameInfo* info) {
+  constexpr int kWidth = 320;
+  constexpr int kHeight = 240;
+  std::vector<uint8_t> buffer_y(kWidth * kHeight, 0x7F);
+  std::vector<uint8_t> buffer_uv(kWidth * kHeight / 4, 0x7F);
+  mrsI420AVideoFrame frame{};
+  frame.width_ = kWidth;
+  frame.height_ = kHeight;
+  frame.ydata_ = buffer_y.data();
+  frame.udata_ = buffer_uv.data();
+  frame.vdata_ = buffer_uv.data();
+  frame.ystride_ = kWidth;
+  frame.ustride_ = kWidth / 2;
+  frame.vstride_ = kWidth / 2;
+  if (info) {
+    return mrsExternalVideoTrackSourceCompleteI420AFrameRequestWithInfo(
+        handle, request_id, info, &frame);
+  }
+  return mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
+      handle, request_id, timestamp_ms, &frame);
+}
+
+// Complete a frame request with a uniform gray frame.
+mrsResult MRS_CALL MakeGrayFrame(void* /*user_data*/,
+                                 mrsExternalVideoTrackSourceHandle handle,
+                                 uint32_t request_id,
+                                 int64_t timestamp_ms) {
+  return CompleteGrayFrame(handle, request_id, timestamp_ms, nullptr);
+}
+
+// Complete a frame request with a uniform gray frame, with the request ID
+// passed as metadata.
+mrsResult MRS_CALL
+MakeGrayFrameWithMetadata(void* /*user_data*/,
+                          mrsExternalVideoTrackSourceHandle handle,
+                          uint32_t request_id,
+                          int64_t timestamp_ms) {
+  mrsExternalVideoFrameInfo info{};
+  info.metadata = &request_id;
+  info.metadata_size = sizeof(request_id);
+  return CompleteGrayFrame(handle, request_id, timestamp_ms, &info);
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_CASE_P(,
@@ -558,3 +634,1873 @@ TEST_P(VideoTrackTests, ExternalI420) {
   mrsExternalVideoTrackSourceShutdown(source_handle1);
   mrsRefCountedObjectRemoveRef(source_handle1);
 }
+
+TEST_P(VideoTrackTests, FrameLease) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Keep the leases past the end of the callback
+  std::mutex leases_mutex;
+  std::vector<mrsVideoFrameLease> leases;
+  Event ev;
+  VideoFrameLeaseCallback lease_cb =
+      [&leases_mutex, &leases, &ev](const mrsVideoFrameLease& lease) {
+        ASSERT_NE(nullptr, lease.buffer_handle_);
+        std::lock_guard<std::mutex> lock(leases_mutex);
+        leases.push_back(lease);
+        if (leases.size() == 5) {
+          ev.Set();
+        }
+      };
+  mrsVideoTrackSourceRegisterFrameLeaseCallback(source_handle, CB(lease_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterFrameLeaseCallback(source_handle, nullptr,
+                                                nullptr);
+
+  // Check the frame data is still valid, then release the leases
+  {
+    std::lock_guard<std::mutex> lock(leases_mutex);
+    for (auto&& lease : leases) {
+      ASSERT_EQ(mrsVideoFrameBufferType::kI420, lease.type_);
+      I420AVideoFrame frame{};
+      frame.width_ = lease.width_;
+      frame.height_ = lease.height_;
+      frame.ydata_ = lease.ydata_;
+      frame.udata_ = lease.udata_;
+      frame.vdata_ = lease.vdata_;
+      frame.ystride_ = lease.ystride_;
+      frame.ustride_ = lease.ustride_;
+      frame.vstride_ = lease.vstride_;
+      VideoTestUtils::CheckIsTestFrame(frame);
+      mrsVideoFrameBufferRemoveRef(lease.buffer_handle_);
+    }
+    leases.clear();
+  }
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, Argb32BufferPool) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsVideoTrackSourceSetArgb32BufferPoolSize(source_handle, 0));
+  ASSERT_EQ(Result::kSuccess,
+            mrsVideoTrackSourceSetArgb32BufferPoolSize(source_handle, 3));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Check out all frames, until the pool is exhausted
+  std::mutex handles_mutex;
+  std::vector<mrsVideoFrameBufferHandle> handles;
+  Event ev;
+  Argb32VideoFrameLeaseCallback argb_cb =
+      [&handles_mutex, &handles, &ev](const mrsArgb32VideoFrame& frame,
+                                      mrsVideoFrameBufferHandle handle) {
+        ASSERT_NE(nullptr, frame.argb32_data_);
+        ASSERT_NE(nullptr, handle);
+        mrsVideoFrameBufferAddRef(handle);
+        std::lock_guard<std::mutex> lock(handles_mutex);
+        // Checked out buffers are never reused
+        ASSERT_EQ(handles.end(),
+                  std::find(handles.begin(), handles.end(), handle));
+        handles.push_back(handle);
+        if (handles.size() == 3) {
+          ev.Set();
+        }
+      };
+  mrsVideoTrackSourceRegisterArgb32FrameLeaseCallback(source_handle,
+                                                      CB(argb_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+
+  // Frames are dropped while all buffers are checked out
+  Event wait_ev;
+  wait_ev.WaitFor(1s);
+  {
+    std::lock_guard<std::mutex> lock(handles_mutex);
+    ASSERT_EQ(3u, handles.size());
+
+    // Return all buffers to the pool
+    for (auto&& handle : handles) {
+      mrsVideoFrameBufferRemoveRef(handle);
+    }
+    handles.clear();
+    ev.Reset();
+  }
+
+  // Delivery resumes once buffers are returned
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterArgb32FrameLeaseCallback(source_handle, nullptr,
+                                                      nullptr);
+  {
+    std::lock_guard<std::mutex> lock(handles_mutex);
+    for (auto&& handle : handles) {
+      mrsVideoFrameBufferRemoveRef(handle);
+    }
+    handles.clear();
+  }
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, Nv12Callback) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Check frames are converted to NV12. The test frame is uniformly filled
+  // with 0x7F, so both planes are too after conversion.
+  uint32_t frame_count = 0;
+  Event ev;
+  Nv12VideoFrameCallback nv12_cb = [&frame_count,
+                                    &ev](const mrsNv12VideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    ASSERT_NE(nullptr, frame.ydata_);
+    ASSERT_NE(nullptr, frame.uvdata_);
+    ASSERT_LE(16, frame.ystride_);
+    ASSERT_LE(16, frame.uvstride_);
+    for (uint32_t j = 0; j < frame.height_; ++j) {
+      const uint8_t* y = (const uint8_t*)frame.ydata_ + j * frame.ystride_;
+      for (uint32_t i = 0; i < frame.width_; ++i) {
+        ASSERT_EQ(0x7F, y[i]);
+      }
+    }
+    for (uint32_t j = 0; j < frame.height_ / 2; ++j) {
+      const uint8_t* uv = (const uint8_t*)frame.uvdata_ + j * frame.uvstride_;
+      for (uint32_t i = 0; i < frame.width_; ++i) {
+        ASSERT_EQ(0x7F, uv[i]);
+      }
+    }
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsVideoTrackSourceRegisterNv12FrameCallback(source_handle, CB(nv12_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterNv12FrameCallback(source_handle, nullptr,
+                                               nullptr);
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, DeliveryOptionsDownscale) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Invalid options are rejected
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsVideoTrackSourceSetFrameDeliveryOptions(nullptr, nullptr));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, nullptr));
+  mrsVideoFrameDeliveryOptions options{};
+  options.max_framerate_ = -1.0f;
+  ASSERT_EQ(
+      mrsResult::kInvalidParameter,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+
+  // Limit the width only; the 16x16 test frame is downscaled to 8x8 to
+  // preserve its aspect ratio, and stays uniformly filled with 0x7F.
+  options.max_width_ = 8;
+  options.max_framerate_ = 0.0f;
+  ASSERT_EQ(
+      mrsResult::kSuccess,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+  uint32_t frame_count = 0;
+  Event ev;
+  I420VideoFrameCallback i420cb = [&frame_count,
+                                   &ev](const I420AVideoFrame& frame) {
+    ASSERT_EQ(8u, frame.width_);
+    ASSERT_EQ(8u, frame.height_);
+    ASSERT_EQ(VideoRotation::k0, frame.rotation_);
+    ASSERT_NE(nullptr, frame.ydata_);
+    for (uint32_t j = 0; j < frame.height_; ++j) {
+      const uint8_t* y = (const uint8_t*)frame.ydata_ + j * frame.ystride_;
+      for (uint32_t i = 0; i < frame.width_; ++i) {
+        ASSERT_EQ(0x7F, y[i]);
+      }
+    }
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, DeliveryOptionsPackedPlanes) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // The stride alignment must be a power of two up to 256
+  mrsVideoFrameDeliveryOptions options{};
+  options.pack_planes_ = true;
+  options.packed_stride_alignment_ = 3;
+  ASSERT_EQ(
+      mrsResult::kInvalidParameter,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+  options.packed_stride_alignment_ = 512;
+  ASSERT_EQ(
+      mrsResult::kInvalidParameter,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+
+  // The planes of the 16x16 test frame follow each other in a single aligned
+  // buffer, with 32-byte strides.
+  options.packed_stride_alignment_ = 32;
+  ASSERT_EQ(
+      mrsResult::kSuccess,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+  uint32_t frame_count = 0;
+  Event ev;
+  I420VideoFrameCallback i420cb = [&frame_count,
+                                   &ev](const I420AVideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    const uint8_t* const packed = (const uint8_t*)frame.packed_data_;
+    ASSERT_NE(nullptr, packed);
+    ASSERT_EQ(0u, (uintptr_t)packed % 64);
+    ASSERT_EQ(32u * 16 + 2 * 32 * 8, frame.packed_size_);
+    ASSERT_EQ(32, frame.ystride_);
+    ASSERT_EQ(32, frame.ustride_);
+    ASSERT_EQ(32, frame.vstride_);
+    ASSERT_EQ(packed, frame.ydata_);
+    ASSERT_EQ(packed + 32 * 16, frame.udata_);
+    ASSERT_EQ(packed + 32 * 16 + 32 * 8, frame.vdata_);
+    ASSERT_EQ(nullptr, frame.adata_);
+    for (uint32_t j = 0; j < frame.height_; ++j) {
+      const uint8_t* y = packed + j * frame.ystride_;
+      for (uint32_t i = 0; i < frame.width_; ++i) {
+        ASSERT_EQ(0x7F, y[i]);
+      }
+    }
+    for (uint32_t j = 0; j < frame.height_ / 2; ++j) {
+      const uint8_t* u = (const uint8_t*)frame.udata_ + j * frame.ustride_;
+      const uint8_t* v = (const uint8_t*)frame.vdata_ + j * frame.vstride_;
+      for (uint32_t i = 0; i < frame.width_ / 2; ++i) {
+        ASSERT_EQ(0x7F, u[i]);
+        ASSERT_EQ(0x7F, v[i]);
+      }
+    }
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+
+  // Tightly packed planes
+  options.packed_stride_alignment_ = 0;
+  ASSERT_EQ(
+      mrsResult::kSuccess,
+      mrsVideoTrackSourceSetFrameDeliveryOptions(source_handle, &options));
+  frame_count = 0;
+  ev.Reset();
+  I420VideoFrameCallback tight_cb = [&frame_count,
+                                     &ev](const I420AVideoFrame& frame) {
+    ASSERT_NE(nullptr, frame.packed_data_);
+    ASSERT_EQ(16u * 16 + 2 * 8 * 8, frame.packed_size_);
+    ASSERT_EQ(16, frame.ystride_);
+    ASSERT_EQ(8, frame.ustride_);
+    ASSERT_EQ(8, frame.vstride_);
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(tight_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, NoCallbackAfterUnregister) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Once unregistering returns, the callback is never invoked again, even if
+  // a frame was being delivered concurrently.
+  std::atomic_bool unregistered{false};
+  std::atomic_bool called_after{false};
+  Event ev;
+  I420VideoFrameCallback i420cb = [&unregistered, &called_after,
+                                   &ev](const I420AVideoFrame&) {
+    if (unregistered.load()) {
+      called_after.store(true);
+    }
+    ev.Set();
+  };
+  for (int i = 0; i < 5; ++i) {
+    ev.Reset();
+    mrsVideoTrackSourceRegisterFrameCallback(source_handle, CB(i420cb));
+    ASSERT_TRUE(ev.WaitFor(5s));
+    mrsVideoTrackSourceRegisterFrameCallback(source_handle, nullptr, nullptr);
+    unregistered.store(true);
+    ev.Reset();
+    ASSERT_FALSE(ev.WaitFor(1s));
+    ASSERT_FALSE(called_after.load());
+    unregistered.store(false);
+  }
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, FrameSubscribersShareConversion) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Two ARGB32 subscribers are invoked in turn with the same converted
+  // buffer for each frame.
+  const void* first_data = nullptr;
+  uint32_t shared_count = 0;
+  Event ev;
+  Argb32VideoFrameCallback argb_cb1 =
+      [&first_data](const mrsArgb32VideoFrame& frame) {
+        first_data = frame.argb32_data_;
+      };
+  Argb32VideoFrameCallback argb_cb2 = [&first_data, &shared_count,
+                                       &ev](const mrsArgb32VideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    ASSERT_EQ(first_data, frame.argb32_data_);
+    if (++shared_count == 5) {
+      ev.Set();
+    }
+  };
+  uint64_t id1 = 0;
+  uint64_t id2 = 0;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceAddArgb32FrameSubscriber(source_handle,
+                                                        CB(argb_cb1), &id1));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceAddArgb32FrameSubscriber(source_handle,
+                                                        CB(argb_cb2), &id2));
+  ASSERT_NE(0u, id1);
+  ASSERT_NE(0u, id2);
+  ASSERT_NE(id1, id2);
+  ASSERT_TRUE(ev.WaitFor(5s));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceRemoveFrameSubscriber(source_handle, id2));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsVideoTrackSourceRemoveFrameSubscriber(source_handle, id1));
+  ASSERT_EQ(mrsResult::kNotFound,
+            mrsVideoTrackSourceRemoveFrameSubscriber(source_handle, id1));
+
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, LatencyStats) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Create a local track from it
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "latency_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                                 &track_handle));
+    ASSERT_NE(nullptr, track_handle);
+  }
+
+  mrsVideoFrameLatencyStats stats{};
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsLocalVideoTrackGetLatencyStats(nullptr, &stats));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLocalVideoTrackGetLatencyStats(track_handle, nullptr));
+
+  // Delivered frames carry their capture timestamp, and are accounted for in
+  // the latency stats.
+  uint32_t frame_count = 0;
+  Event ev;
+  I420VideoFrameCallback i420cb = [&frame_count,
+                                   &ev](const I420AVideoFrame& frame) {
+    ASSERT_LT(0, frame.timestamp_us_);
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(i420cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackGetLatencyStats(track_handle, &stats));
+  ASSERT_LE(5u, stats.sample_count);
+  ASSERT_LE(stats.p50_ms, stats.p95_ms);
+  ASSERT_LE(stats.p95_ms, stats.p99_ms);
+  ASSERT_LE(stats.p99_ms, stats.max_ms);
+
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackResetLatencyStats(track_handle));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackGetLatencyStats(track_handle, &stats));
+  ASSERT_EQ(0u, stats.sample_count);
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, AsyncDelivery) {
+  // Create an external source producing I420 test frames
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+
+  // Create a local track from it
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "async_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                                 &track_handle));
+    ASSERT_NE(nullptr, track_handle);
+  }
+
+  mrsVideoFrameDeliveryStats stats{};
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsLocalVideoTrackGetFrameDeliveryStats(nullptr, &stats));
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLocalVideoTrackGetFrameDeliveryStats(track_handle, nullptr));
+
+  // Synchronous delivery runs on the thread producing the frames
+  std::thread::id source_thread;
+  Event ev;
+  I420VideoFrameCallback sync_cb = [&source_thread,
+                                    &ev](const I420AVideoFrame&) {
+    source_thread = std::this_thread::get_id();
+    ev.Set();
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(sync_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+
+  // Asynchronous delivery runs on another thread, and a slow callback makes
+  // newer frames replace the pending ones.
+  ASSERT_EQ(mrsResult::kSuccess, mrsLocalVideoTrackSetAsyncFrameDelivery(
+                                     track_handle, mrsBool::kTrue));
+  std::atomic_bool unregistered{false};
+  std::atomic_bool called_after{false};
+  std::atomic_bool same_thread{false};
+  uint32_t frame_count = 0;
+  ev.Reset();
+  I420VideoFrameCallback async_cb = [&](const I420AVideoFrame&) {
+    if (unregistered.load()) {
+      called_after.store(true);
+    }
+    if (std::this_thread::get_id() == source_thread) {
+      same_thread.store(true);
+    }
+    std::this_thread::sleep_for(100ms);
+    if (++frame_count == 5) {
+      ev.Set();
+    }
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(async_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+
+  // Once unregistering returns, the delivery thread does not invoke the
+  // callback anymore, even if it was delivering a frame concurrently.
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+  unregistered.store(true);
+  std::this_thread::sleep_for(500ms);
+  ASSERT_FALSE(called_after.load());
+  ASSERT_FALSE(same_thread.load());
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackGetFrameDeliveryStats(track_handle, &stats));
+  ASSERT_LT(0u, stats.async_replaced_count);
+
+  // Frames are delivered synchronously again once disabled
+  ASSERT_EQ(mrsResult::kSuccess, mrsLocalVideoTrackSetAsyncFrameDelivery(
+                                     track_handle, mrsBool::kFalse));
+  ev.Reset();
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(sync_cb));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, EncodedFrames) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "encoded_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackRegisterEncodedFrameCallback(nullptr, nullptr,
+                                                            nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackSetDecodingEnabled(nullptr, mrsBool::kFalse));
+
+  // Record the encoded frames without decoding them
+  std::atomic_uint32_t decoded_count{0};
+  I420VideoFrameCallback i420cb = [&decoded_count](const I420AVideoFrame&) {
+    ++decoded_count;
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetDecodingEnabled(
+                                  track_handle2, mrsBool::kFalse));
+  std::atomic_uint32_t encoded_count{0};
+  Event encoded_ev;
+  EncodedVideoFrameCallback encoded_cb =
+      [&encoded_count, &encoded_ev](const mrsEncodedVideoFrame* frame) {
+        ASSERT_NE(nullptr, frame->codec_name);
+        ASSERT_NE(nullptr, frame->data);
+        ASSERT_LT(0u, frame->size);
+        if (frame->is_keyframe == mrsBool::kTrue) {
+          ASSERT_LT(0u, frame->width);
+          ASSERT_LT(0u, frame->height);
+        }
+        if (++encoded_count == 30) {
+          encoded_ev.Set();
+        }
+      };
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, CB(encoded_cb)));
+  ASSERT_TRUE(encoded_ev.WaitFor(5s));
+
+  // Frames decoded before decoding was disabled may still be in flight, but
+  // none is decoded afterward.
+  Event wait_ev;
+  wait_ev.WaitFor(200ms);
+  const uint32_t decoded_before = decoded_count.load();
+  wait_ev.WaitFor(500ms);
+  ASSERT_EQ(decoded_before, decoded_count.load());
+
+  // Decoding resumes once enabled again
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetDecodingEnabled(
+                                  track_handle2, mrsBool::kTrue));
+  wait_ev.WaitFor(3s);
+  ASSERT_LT(decoded_before, decoded_count.load());
+
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, nullptr, nullptr));
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, LowPriorityDecoding) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "low_priority_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackSetLowPriorityDecoding(nullptr,
+                                                      mrsBool::kTrue));
+
+  std::atomic_uint32_t decoded_count{0};
+  I420VideoFrameCallback i420cb = [&decoded_count](const I420AVideoFrame&) {
+    ++decoded_count;
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+
+  // Frames keep being decoded while the decoder is reinitialized on the key
+  // frame requested by each change of priority.
+  Event wait_ev;
+  for (mrsBool low_priority : {mrsBool::kTrue, mrsBool::kFalse}) {
+    ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetLowPriorityDecoding(
+                                    track_handle2, low_priority));
+    wait_ev.WaitFor(500ms);
+    const uint32_t decoded_before = decoded_count.load();
+    wait_ev.WaitFor(2s);
+    ASSERT_LT(decoded_before, decoded_count.load());
+  }
+
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, RecordAndReplay) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "recorded_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  char temp_dir[MAX_PATH];
+  ASSERT_LT(0u, ::GetTempPathA(MAX_PATH, temp_dir));
+  const std::string path = std::string(temp_dir) + "mrs_test_recording.bin";
+
+  // Record about one second of frames, starting from a key frame
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackStartRecording(nullptr, path.c_str()));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteVideoTrackStartRecording(track_handle2, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackStartRecording(track_handle2, path.c_str()));
+  Event wait_ev;
+  wait_ev.WaitFor(1s);
+  uint32_t recorded_count = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackStopRecording(track_handle2, &recorded_count));
+  ASSERT_LT(0u, recorded_count);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+
+  // Replay the recording as fast as possible, decoding all frames
+  uint32_t replayed_count = 0;
+  I420VideoFrameCallback i420cb = [&replayed_count](const I420AVideoFrame&) {
+    ++replayed_count;
+  };
+  mrsEncodedVideoReplayConfig replay_config{};
+  replay_config.path = path.c_str();
+  replay_config.i420a_callback = &i420cb.StaticExec;
+  replay_config.i420a_user_data = &i420cb;
+  mrsEncodedVideoReplayStats stats{};
+  ASSERT_EQ(Result::kSuccess, mrsReplayEncodedVideo(&replay_config, &stats));
+  ASSERT_EQ(recorded_count, stats.frames_read);
+  ASSERT_EQ(0u, stats.decode_errors);
+  ASSERT_EQ(recorded_count, stats.frames_decoded);
+  ASSERT_EQ(recorded_count, replayed_count);
+  ASSERT_LE(stats.decode_time_us, stats.duration_us);
+
+  // Replaying at the recorded pacing takes about as long as the recording
+  replay_config.recorded_pacing = mrsBool::kTrue;
+  ASSERT_EQ(Result::kSuccess, mrsReplayEncodedVideo(&replay_config, &stats));
+  ASSERT_EQ(recorded_count, stats.frames_decoded);
+  ASSERT_LT(500000, stats.duration_us);
+
+  replay_config.path = "mrs_test_missing_recording.bin";
+  ASSERT_EQ(Result::kNotFound, mrsReplayEncodedVideo(&replay_config, &stats));
+  ::DeleteFileA(path.c_str());
+}
+
+TEST_P(VideoTrackTests, StatsSubscription) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "stats_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  mrsStatsSubscriptionConfig config{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionSubscribeStats(nullptr, &config, nullptr,
+                                            nullptr));
+  config.interval_ms = 0;
+  StatsSnapshotCallback snapshot_cb =
+      [](const mrsStatsEntry* /*entries*/, uint32_t /*entry_count*/) {};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSubscribeStats(pair.pc1(), &config,
+                                            CB(snapshot_cb)));
+
+  // Only the entries which changed are delivered, so each snapshot of the
+  // video sender has sent more data than the previous one.
+  std::atomic_bool subscribed{true};
+  uint64_t last_bytes_sent = 0;
+  uint32_t snapshot_count = 0;
+  Event snapshots_ev;
+  snapshot_cb = [&](const mrsStatsEntry* entries, uint32_t entry_count) {
+    ASSERT_TRUE(subscribed.load());
+    ASSERT_LT(0u, entry_count);
+    for (uint32_t i = 0; i < entry_count; ++i) {
+      if (entries[i].kind == mrsStatsEntryKind::kVideoSender) {
+        const mrsVideoSenderStats& stats = entries[i].video_sender;
+        ASSERT_NE(nullptr, stats.track_identifier);
+        ASSERT_LE(last_bytes_sent, stats.bytes_sent);
+        last_bytes_sent = stats.bytes_sent;
+        if (++snapshot_count == 3) {
+          snapshots_ev.Set();
+        }
+      } else if (entries[i].kind == mrsStatsEntryKind::kTransport) {
+        const mrsTransportStats& stats = entries[i].transport;
+        ASSERT_LE(0.0, stats.current_round_trip_time);
+        ASSERT_LE(0.0, stats.available_outgoing_bitrate);
+      }
+    }
+  };
+  config.interval_ms = 200;
+  config.flags = mrsStatsSubscriptionFlags::kChangedOnly;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSubscribeStats(
+                                  pair.pc1(), &config, CB(snapshot_cb)));
+  ASSERT_TRUE(snapshots_ev.WaitFor(5s));
+
+  // No snapshot is delivered once unsubscribed
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSubscribeStats(
+                                  pair.pc1(), nullptr, nullptr, nullptr));
+  subscribed.store(false);
+  Event wait_ev;
+  wait_ev.WaitFor(500ms);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, BandwidthEstimate) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "bwe_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  mrsBandwidthEstimateConfig config{};
+  BandwidthEstimateCallback estimate_cb =
+      [](const mrsBandwidthEstimate* /*estimate*/) {};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionSubscribeBandwidthEstimate(nullptr, &config,
+                                                        CB(estimate_cb)));
+  config.change_threshold_percent = -1.0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionSubscribeBandwidthEstimate(pair.pc1(), &config,
+                                                        CB(estimate_cb)));
+
+  // With a zero threshold all estimates are delivered.
+  std::atomic_bool subscribed{true};
+  uint32_t estimate_count = 0;
+  Event estimates_ev;
+  estimate_cb = [&](const mrsBandwidthEstimate* estimate) {
+    ASSERT_TRUE(subscribed.load());
+    ASSERT_NE(nullptr, estimate);
+    ASSERT_LT(0.0, estimate->target_bitrate);
+    ASSERT_LE(0.0, estimate->send_bitrate);
+    ASSERT_LE(0.0, estimate->round_trip_time);
+    ASSERT_LE(0.0, estimate->loss_fraction);
+    ASSERT_GE(1.0, estimate->loss_fraction);
+    if (++estimate_count == 3) {
+      estimates_ev.Set();
+    }
+  };
+  config.interval_ms = 200;
+  config.change_threshold_percent = 0.0;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSubscribeBandwidthEstimate(
+                                  pair.pc1(), &config, CB(estimate_cb)));
+  ASSERT_TRUE(estimates_ev.WaitFor(5s));
+
+  // No estimate is delivered once unsubscribed
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSubscribeBandwidthEstimate(
+                                  pair.pc1(), nullptr, nullptr, nullptr));
+  subscribed.store(false);
+  Event wait_ev;
+  wait_ev.WaitFor(500ms);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, QualityLimitation) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_added2_ev](const mrsRemoteVideoTrackAddedInfo* /*info*/) {
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "quality_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  mrsQualityLimitationConfig config{};
+  QualityLimitationCallback limitation_cb =
+      [](const mrsQualityLimitationEvent* /*event*/) {};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSubscribeQualityLimitation(nullptr, &config,
+                                                     CB(limitation_cb)));
+  config.interval_ms = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSubscribeQualityLimitation(
+                transceiver_handle1, &config, CB(limitation_cb)));
+
+  // The first event is delivered once the stream is sent
+  std::atomic_bool subscribed{true};
+  Event limitation_ev;
+  limitation_cb = [&](const mrsQualityLimitationEvent* event) {
+    ASSERT_TRUE(subscribed.load());
+    ASSERT_NE(nullptr, event);
+    ASSERT_LT(0u, event->frame_width);
+    ASSERT_LT(0u, event->frame_height);
+    ASSERT_LE(0, event->previous_duration_ms);
+    limitation_ev.Set();
+  };
+  config.interval_ms = 200;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSubscribeQualityLimitation(
+                                  transceiver_handle1, &config,
+                                  CB(limitation_cb)));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_TRUE(limitation_ev.WaitFor(5s));
+
+  // No event is delivered once unsubscribed
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSubscribeQualityLimitation(
+                                  transceiver_handle1, nullptr, nullptr,
+                                  nullptr));
+  subscribed.store(false);
+  Event wait_ev;
+  wait_ev.WaitFor(500ms);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, KeyFrameRequests) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "keyframe_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalVideoTrackRequestKeyFrame(nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackRequestKeyFrame(nullptr));
+
+  // Count the key frames received
+  std::atomic_uint32_t keyframe_count{0};
+  EncodedVideoFrameCallback encoded_cb =
+      [&keyframe_count](const mrsEncodedVideoFrame* frame) {
+        if (frame->is_keyframe == mrsBool::kTrue) {
+          ++keyframe_count;
+        }
+      };
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, CB(encoded_cb)));
+
+  // Let the key frames sent on connection arrive, then check that each
+  // request produces a key frame long before the next periodic one.
+  Event wait_ev;
+  wait_ev.WaitFor(1s);
+  uint32_t keyframe_before = keyframe_count.load();
+  ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackRequestKeyFrame(track_handle1));
+  wait_ev.WaitFor(1s);
+  ASSERT_LT(keyframe_before, keyframe_count.load());
+
+  keyframe_before = keyframe_count.load();
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackRequestKeyFrame(track_handle2));
+  wait_ev.WaitFor(1s);
+  ASSERT_LT(keyframe_before, keyframe_count.load());
+
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, nullptr, nullptr));
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, EncoderOptions) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "encoder_options_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Invalid arguments
+  mrsVideoEncoderOptions options{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalVideoTrackSetEncoderOptions(nullptr, &options));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetEncoderOptions(track_handle1, nullptr));
+  options.preset = (mrsVideoEncoderPreset)42;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetEncoderOptions(track_handle1, &options));
+
+  // Count the frames and key frames received
+  std::atomic_uint32_t frame_count{0};
+  std::atomic_uint32_t keyframe_count{0};
+  EncodedVideoFrameCallback encoded_cb =
+      [&frame_count, &keyframe_count](const mrsEncodedVideoFrame* frame) {
+        ++frame_count;
+        if (frame->is_keyframe == mrsBool::kTrue) {
+          ++keyframe_count;
+        }
+      };
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, CB(encoded_cb)));
+
+  // Let the key frames sent on connection arrive, then check that changing
+  // the options reinitializes the encoder, which keeps sending frames.
+  Event wait_ev;
+  wait_ev.WaitFor(1s);
+  const mrsVideoEncoderPreset presets[] = {
+      mrsVideoEncoderPreset::kQuality, mrsVideoEncoderPreset::kRealtimeFast};
+  for (mrsVideoEncoderPreset preset : presets) {
+    options.preset = preset;
+    options.max_threads = 1;
+    const uint32_t frame_before = frame_count.load();
+    const uint32_t keyframe_before = keyframe_count.load();
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackSetEncoderOptions(track_handle1, &options));
+    wait_ev.WaitFor(1s);
+    ASSERT_LT(keyframe_before, keyframe_count.load());
+    ASSERT_LT(frame_before + 1, frame_count.load());
+  }
+  options = mrsVideoEncoderOptions{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetEncoderOptions(track_handle1, &options));
+
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  track_handle2, nullptr, nullptr));
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, LowLatencyPlayout) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+
+  // Invalid jitter buffer size
+  {
+    pc_config.audio_jitter_buffer_max_packets = -1;
+    mrsPeerConnectionHandle handle = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  pc_config.audio_jitter_buffer_max_packets = 10;
+  pc_config.audio_jitter_buffer_fast_accelerate = mrsBool::kTrue;
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2)
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send a local video track from the local peer (#1)
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle1));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "low_latency_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+
+  // Invalid playout delays
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalVideoTrackSetPlayoutDelay(nullptr, 0, 0));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetPlayoutDelay(track_handle1, -1, 100));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetPlayoutDelay(track_handle1, 200, 100));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetPlayoutDelay(track_handle1, 0, 50000));
+
+  // Render the frames as soon as they are decoded
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetPlayoutDelay(track_handle1, 0, 0));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  std::atomic_uint32_t frame_count{0};
+  I420VideoFrameCallback i420cb = [&frame_count](const I420AVideoFrame&) {
+    ++frame_count;
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+  Event wait_ev;
+  wait_ev.WaitFor(3s);
+  ASSERT_LT(30u, frame_count.load()) << "Expected at least 10 FPS";
+
+  // Stop stamping the frames
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetPlayoutDelay(track_handle1, -1, -1));
+
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, RelaySource) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii upstream(pc_config);
+  LocalPeerPairRaii downstream(pc_config);
+
+  // Grab the remote tracks of both receiving peers
+  mrsRemoteVideoTrackHandle upstream_track{};
+  Event upstream_track_ev;
+  VideoTrackAddedCallback upstream_track_cb =
+      [&upstream_track,
+       &upstream_track_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        upstream_track = info->track_handle;
+        upstream_track_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(upstream.pc2(),
+                                                   CB(upstream_track_cb));
+  mrsRemoteVideoTrackHandle downstream_track{};
+  Event downstream_track_ev;
+  VideoTrackAddedCallback downstream_track_cb =
+      [&downstream_track,
+       &downstream_track_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        downstream_track = info->track_handle;
+        downstream_track_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(downstream.pc2(),
+                                                   CB(downstream_track_cb));
+
+  // Send test frames upstream
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "video_transceiver";
+  transceiver_config.media_kind = mrsMediaKind::kVideo;
+  mrsTransceiverHandle upstream_transceiver{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(
+                upstream.pc1(), &transceiver_config, &upstream_transceiver));
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  mrsLocalVideoTrackHandle local_track{};
+  mrsLocalVideoTrackInitSettings settings{};
+  settings.track_name = "presenter_track";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                               &local_track));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  upstream_transceiver, local_track));
+  upstream.ConnectAndWait();
+  ASSERT_TRUE(upstream_track_ev.WaitFor(5s));
+
+  // Relay the received track downstream, without decoding it
+  mrsRelayVideoTrackSourceHandle relay_source{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRelayVideoTrackSourceCreate(nullptr, &relay_source));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRelayVideoTrackSourceCreate(upstream_track, &relay_source));
+  ASSERT_NE(nullptr, relay_source);
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetDecodingEnabled(
+                                  upstream_track, mrsBool::kFalse));
+  mrsLocalVideoTrackHandle relay_track{};
+  settings.track_name = "relay_track";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackCreateFromSource(&settings, relay_source,
+                                               &relay_track));
+  mrsTransceiverHandle downstream_transceiver{};
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddTransceiver(
+                                  downstream.pc1(), &transceiver_config,
+                                  &downstream_transceiver));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  downstream_transceiver, relay_track));
+  downstream.ConnectAndWait();
+  ASSERT_TRUE(downstream_track_ev.WaitFor(5s));
+
+  // The downstream peer decodes the frames encoded upstream
+  std::atomic_uint32_t frame_count{0};
+  Event frames_ev;
+  I420VideoFrameCallback i420cb = [&frame_count,
+                                   &frames_ev](const I420AVideoFrame& frame) {
+    VideoTestUtils::CheckIsTestFrame(frame);
+    if (++frame_count == 30) {
+      frames_ev.Set();
+    }
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(downstream_track, CB(i420cb));
+  ASSERT_TRUE(frames_ev.WaitFor(10s));
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(downstream_track, nullptr,
+                                                nullptr);
+
+  mrsRefCountedObjectRemoveRef(relay_track);
+  mrsRefCountedObjectRemoveRef(relay_source);
+  mrsRefCountedObjectRemoveRef(local_track);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, ExternalEncodedSource) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii upstream(pc_config);
+  LocalPeerPairRaii downstream(pc_config);
+
+  // Grab the remote tracks of both receiving peers
+  mrsRemoteVideoTrackHandle upstream_track{};
+  Event upstream_track_ev;
+  VideoTrackAddedCallback upstream_track_cb =
+      [&upstream_track,
+       &upstream_track_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        upstream_track = info->track_handle;
+        upstream_track_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(upstream.pc2(),
+                                                   CB(upstream_track_cb));
+  mrsRemoteVideoTrackHandle downstream_track{};
+  Event downstream_track_ev;
+  VideoTrackAddedCallback downstream_track_cb =
+      [&downstream_track,
+       &downstream_track_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        downstream_track = info->track_handle;
+        downstream_track_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(downstream.pc2(),
+                                                   CB(downstream_track_cb));
+
+  // Send test frames upstream
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "video_transceiver";
+  transceiver_config.media_kind = mrsMediaKind::kVideo;
+  mrsTransceiverHandle upstream_transceiver{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(
+                upstream.pc1(), &transceiver_config, &upstream_transceiver));
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  mrsLocalVideoTrackHandle local_track{};
+  mrsLocalVideoTrackInitSettings settings{};
+  settings.track_name = "presenter_track";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackCreateFromSource(&settings, source_handle,
+                                               &local_track));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  upstream_transceiver, local_track));
+  upstream.ConnectAndWait();
+  ASSERT_TRUE(upstream_track_ev.WaitFor(5s));
+
+  // Feed the frames received upstream, without decoding them, to an external
+  // encoded source sending them downstream
+  mrsExternalEncodedVideoTrackSourceHandle encoded_source{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalEncodedVideoTrackSourceCreate(nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalEncodedVideoTrackSourceCreate(&encoded_source));
+  ASSERT_NE(nullptr, encoded_source);
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetDecodingEnabled(
+                                  upstream_track, mrsBool::kFalse));
+  InteropCallback<> keyframe_cb = [&upstream_track]() {
+    mrsRemoteVideoTrackRequestKeyFrame(upstream_track);
+  };
+  mrsExternalEncodedVideoTrackSourceRegisterKeyFrameCallback(encoded_source,
+                                                             CB(keyframe_cb));
+  Event bitrate_ev;
+  InteropCallback<uint32_t, uint32_t> bitrate_cb =
+      [&bitrate_ev](uint32_t bitrate_bps, uint32_t /*framerate*/) {
+        if (bitrate_bps > 0) {
+          bitrate_ev.Set();
+        }
+      };
+  mrsExternalEncodedVideoTrackSourceRegisterBitrateCallback(encoded_source,
+                                                            CB(bitrate_cb));
+  EncodedVideoFrameCallback encoded_cb =
+      [&encoded_source](const mrsEncodedVideoFrame* frame) {
+        ASSERT_EQ(Result::kSuccess,
+                  mrsExternalEncodedVideoTrackSourcePushFrame(encoded_source,
+                                                              frame, 0));
+      };
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  upstream_track, CB(encoded_cb)));
+  mrsLocalVideoTrackHandle encoded_track{};
+  settings.track_name = "encoded_track";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLocalVideoTrackCreateFromSource(&settings, encoded_source,
+                                               &encoded_track));
+  mrsTransceiverHandle downstream_transceiver{};
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddTransceiver(
+                                  downstream.pc1(), &transceiver_config,
+                                  &downstream_transceiver));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  downstream_transceiver, encoded_track));
+  downstream.ConnectAndWait();
+  ASSERT_TRUE(downstream_track_ev.WaitFor(5s));
+
+  // The downstream peer decodes the frames encoded upstream
+  std::atomic_uint32_t frame_count{0};
+  Event frames_ev;
+  I420VideoFrameCallback i420cb = [&frame_count,
+                                   &frames_ev](const I420AVideoFrame& frame) {
+    VideoTestUtils::CheckIsTestFrame(frame);
+    if (++frame_count == 30) {
+      frames_ev.Set();
+    }
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(downstream_track, CB(i420cb));
+  ASSERT_TRUE(frames_ev.WaitFor(10s));
+  ASSERT_TRUE(bitrate_ev.WaitFor(1s));
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(downstream_track, nullptr,
+                                                nullptr);
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackRegisterEncodedFrameCallback(
+                                  upstream_track, nullptr, nullptr));
+
+  mrsRefCountedObjectRemoveRef(encoded_track);
+  mrsRefCountedObjectRemoveRef(encoded_source);
+  mrsRefCountedObjectRemoveRef(local_track);
+  mrsExternalVideoTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, LatencyMarkers) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send gray frames stamped with latency markers from #1
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &MakeGrayFrame, nullptr, &source_handle1));
+  ASSERT_NE(nullptr, source_handle1);
+  ASSERT_EQ(Result::kSuccess, mrsExternalVideoTrackSourceSetLatencyMarkers(
+                                  source_handle1, mrsBool::kTrue));
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "marked_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Decode the markers on #2, without any frame callback
+  ASSERT_EQ(Result::kSuccess, mrsRemoteVideoTrackSetLatencyMarkerDecoding(
+                                  track_handle2, mrsBool::kTrue));
+  Event ev;
+  ev.WaitFor(3s);
+  mrsVideoLatencyMarkerStats stats{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteVideoTrackGetLatencyMarkerStats(track_handle2, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackGetLatencyMarkerStats(track_handle2, &stats));
+  ASSERT_LT(10u, stats.decoded_count);
+  ASSERT_EQ(stats.decoded_count, stats.latency.sample_count);
+  ASSERT_LT(stats.latency.p50_ms, 1000.0);
+
+  // Resetting the latency stats also resets the marker stats
+  mrsRemoteVideoTrackSetLatencyMarkerDecoding(track_handle2, mrsBool::kFalse);
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackResetLatencyStats(track_handle2));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackGetLatencyMarkerStats(track_handle2, &stats));
+  ASSERT_EQ(0u, stats.decoded_count);
+  ASSERT_EQ(0u, stats.missing_count);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, FrameTimingStats) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send frames from #1
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &MakeGrayFrame, nullptr, &source_handle1));
+  ASSERT_NE(nullptr, source_handle1);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "timed_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Frames are timed on #2 without any frame callback
+  Event ev;
+  ev.WaitFor(3s);
+  mrsVideoFrameTimingStats stats{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteVideoTrackGetFrameTimingStats(track_handle2, nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackGetFrameTimingStats(nullptr, &stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackGetFrameTimingStats(track_handle2, &stats));
+  ASSERT_LT(10u, stats.frame_count);
+  ASSERT_EQ(stats.frame_count - 1, stats.inter_arrival.sample_count);
+  ASSERT_LT(0.0, stats.framerate_1s);
+  ASSERT_LT(0.0, stats.framerate_10s);
+  ASSERT_LE(stats.inter_arrival.p50_ms, stats.inter_arrival.p95_ms);
+  ASSERT_LE(stats.inter_arrival.p95_ms, stats.inter_arrival.p99_ms);
+  ASSERT_LE(stats.inter_arrival.p99_ms, stats.inter_arrival.max_ms);
+  ASSERT_EQ(0u, stats.pause_count);
+  ASSERT_LE(0.0, stats.ms_since_last_frame);
+
+  const uint64_t frame_count = stats.frame_count;
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackResetFrameTimingStats(track_handle2));
+  mrsRemoteVideoTrackGetFrameTimingStats(track_handle2, &stats);
+  ASSERT_GT(frame_count, stats.frame_count);
+  ASSERT_EQ(0u, stats.freeze_count);
+  ASSERT_EQ(0.0, stats.total_freeze_duration_ms);
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}
+
+TEST_P(VideoTrackTests, FrameMetadata) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Send frames with their request ID attached as metadata from #1
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &MakeGrayFrameWithMetadata, nullptr, &source_handle1));
+  ASSERT_NE(nullptr, source_handle1);
+  {
+    std::vector<uint8_t> too_large(1025);
+    mrsExternalVideoFrameInfo info{};
+    info.metadata = too_large.data();
+    info.metadata_size = (uint32_t)too_large.size();
+    ASSERT_EQ(Result::kInvalidParameter,
+              CompleteGrayFrame(source_handle1, 0, 0, &info));
+    info.metadata = nullptr;
+    info.metadata_size = 4;
+    ASSERT_EQ(Result::kInvalidParameter,
+              CompleteGrayFrame(source_handle1, 0, 0, &info));
+  }
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "metadata_video_track";
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source_handle1,
+                                                 &track_handle1));
+  }
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  // Local frames carry their metadata too
+  std::atomic<uint32_t> local_frame_count{0};
+  std::atomic<uint32_t> local_metadata_count{0};
+  I420VideoFrameCallback local_i420cb = [&](const I420AVideoFrame& frame) {
+    ++local_frame_count;
+    if ((frame.metadata_ != nullptr) &&
+        (frame.metadata_size_ == sizeof(uint32_t))) {
+      ++local_metadata_count;
+    }
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle1,
+                                               CB(local_i420cb));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Each remote frame carries the metadata of its request, in request order
+  std::mutex mutex;
+  uint32_t remote_frame_count = 0;
+  uint32_t remote_metadata_count = 0;
+  uint32_t last_request_id = 0;
+  bool in_order = true;
+  I420VideoFrameCallback remote_i420cb = [&](const I420AVideoFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++remote_frame_count;
+    if ((frame.metadata_ != nullptr) &&
+        (frame.metadata_size_ == sizeof(uint32_t))) {
+      ++remote_metadata_count;
+      uint32_t request_id;
+      memcpy(&request_id, frame.metadata_, sizeof(request_id));
+      in_order &= (request_id > last_request_id);
+      last_request_id = request_id;
+    }
+  };
+  uint32_t argb_metadata_count = 0;
+  Argb32VideoFrameCallback remote_argbcb =
+      [&](const mrsArgb32VideoFrame& frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if ((frame.metadata_ != nullptr) &&
+            (frame.metadata_size_ == sizeof(uint32_t))) {
+          ++argb_metadata_count;
+        }
+      };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2,
+                                                CB(remote_i420cb));
+  mrsRemoteVideoTrackRegisterArgb32FrameCallback(track_handle2,
+                                                 CB(remote_argbcb));
+  Event ev;
+  ev.WaitFor(3s);
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  mrsRemoteVideoTrackRegisterArgb32FrameCallback(track_handle2, nullptr,
+                                                 nullptr);
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle1, nullptr,
+                                               nullptr);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_LT(10u, remote_frame_count);
+    ASSERT_EQ(remote_frame_count, remote_metadata_count);
+    ASSERT_LT(10u, argb_metadata_count);
+    ASSERT_TRUE(in_order);
+  }
+  ASSERT_LT(10u, local_frame_count.load());
+  ASSERT_EQ(local_frame_count.load(), local_metadata_count.load());
+
+  mrsRefCountedObjectRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsRefCountedObjectRemoveRef(source_handle1);
+}